@@ -31,6 +31,7 @@
 #include "upb/mem/arena.h"
 #include "upb/reflection/def.hpp"
 #include "upb/wire/decode.h"
+#include "utf8_validity.h"
 
 upb_StringView descriptor =
     benchmarks_descriptor_proto_upbdefinit.descriptor;
@@ -351,6 +352,27 @@ static void BM_SerializeDescriptor_Proto2(benchmark::State& state) {
 }
 BENCHMARK(BM_SerializeDescriptor_Proto2);
 
+template <bool kAsciiOnly>
+static void BM_VerifyUtf8(benchmark::State& state) {
+  // ASCII-only covers the overwhelming common case; the multibyte variant
+  // sprinkles two-byte codepoints through the buffer to exercise the SIMD
+  // range checker rather than the ASCII skip loop.
+  std::string data(16 * 1024, 'a');
+  if (!kAsciiOnly) {
+    for (size_t i = 0; i + 1 < data.size(); i += 64) {
+      data[i] = '\xC3';
+      data[i + 1] = '\xA9';  // U+00E9
+    }
+  }
+  for (auto _ : state) {
+    bool ok = utf8_range::IsStructurallyValid(data);
+    ABSL_CHECK(ok);
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK_TEMPLATE(BM_VerifyUtf8, true);
+BENCHMARK_TEMPLATE(BM_VerifyUtf8, false);
+
 static upb_benchmark_FileDescriptorProto* UpbParseDescriptor(upb_Arena* arena) {
   upb_benchmark_FileDescriptorProto* set =
       upb_benchmark_FileDescriptorProto_parse(descriptor.data, descriptor.size,
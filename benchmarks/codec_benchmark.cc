@@ -0,0 +1,375 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google LLC.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+// Microbenchmarks for the C++ codec: per-field-type decode, packed decode,
+// map parse, ByteSizeLong, serialization, JSON and TextFormat round-trips,
+// and arena vs. heap parsing.  The schemas come from gen_synthetic_protos.py
+// so that the perf surface stays pinned across releases.
+
+#include <benchmark/benchmark.h>
+
+#include <stdint.h>
+
+#include <string>
+
+#include "absl/log/absl_check.h"
+#include "absl/strings/str_cat.h"
+#include "google/protobuf/arena.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/json/json.h"
+#include "google/protobuf/message.h"
+#include "google/protobuf/text_format.h"
+#include "benchmarks/100_fields.pb.h"
+#include "benchmarks/codec.pb.h"
+
+namespace protobuf = ::google::protobuf;
+
+using upb_benchmark::CodecMessage;
+using upb_benchmark::CodecSub;
+
+// How many times the encoded field is repeated in single-field payloads.
+constexpr int kFieldRepeats = 1024;
+// Element count for repeated and map payloads.
+constexpr int kRepeatedLen = 1024;
+constexpr int kStringLen = 32;
+
+// Serializes a message holding a single field, then repeats the encoded
+// field kFieldRepeats times.  Repeated occurrences of a singular field are
+// legal on the wire (the last one wins), so parsing the result exercises one
+// parser dispatch for that field type per repeat.
+template <typename Setter>
+std::string SingleFieldPayload(Setter&& set) {
+  CodecMessage m;
+  set(m);
+  const std::string one = m.SerializeAsString();
+  std::string payload;
+  payload.reserve(one.size() * kFieldRepeats);
+  for (int i = 0; i < kFieldRepeats; ++i) payload += one;
+  return payload;
+}
+
+template <typename Setter>
+void DecodeFieldBenchmark(benchmark::State& state, Setter&& set) {
+  const std::string payload = SingleFieldPayload(set);
+  CodecMessage m;
+  for (auto _ : state) {
+    bool ok = m.ParseFromString(payload);
+    ABSL_CHECK(ok);
+  }
+  state.SetBytesProcessed(state.iterations() * payload.size());
+}
+
+#define CODEC_DECODE_FIELD_BENCHMARK(name, stmt)          \
+  static void BM_Decode_##name(benchmark::State& state) { \
+    DecodeFieldBenchmark(state, [](CodecMessage& m) { stmt; }); \
+  }                                                       \
+  BENCHMARK(BM_Decode_##name)
+
+CODEC_DECODE_FIELD_BENCHMARK(Int32, m.set_opt_int32(0x7ffffff));
+CODEC_DECODE_FIELD_BENCHMARK(Int64, m.set_opt_int64(int64_t{0x7ffffffffff}));
+CODEC_DECODE_FIELD_BENCHMARK(Uint32, m.set_opt_uint32(0xfffffffu));
+CODEC_DECODE_FIELD_BENCHMARK(Uint64, m.set_opt_uint64(uint64_t{0xfffffffffff}));
+CODEC_DECODE_FIELD_BENCHMARK(Sint32, m.set_opt_sint32(-0x7ffffff));
+CODEC_DECODE_FIELD_BENCHMARK(Sint64, m.set_opt_sint64(-int64_t{0x7ffffffffff}));
+CODEC_DECODE_FIELD_BENCHMARK(Fixed32, m.set_opt_fixed32(0xdeadbeef));
+CODEC_DECODE_FIELD_BENCHMARK(Fixed64, m.set_opt_fixed64(0xdeadbeefcafe));
+CODEC_DECODE_FIELD_BENCHMARK(Sfixed32, m.set_opt_sfixed32(-12345678));
+CODEC_DECODE_FIELD_BENCHMARK(Sfixed64, m.set_opt_sfixed64(-1234567890123));
+CODEC_DECODE_FIELD_BENCHMARK(Float, m.set_opt_float(3.14159f));
+CODEC_DECODE_FIELD_BENCHMARK(Double, m.set_opt_double(2.71828));
+CODEC_DECODE_FIELD_BENCHMARK(Bool, m.set_opt_bool(true));
+CODEC_DECODE_FIELD_BENCHMARK(String, m.set_opt_string(std::string(kStringLen, 'x')));
+CODEC_DECODE_FIELD_BENCHMARK(Bytes, m.set_opt_bytes(std::string(kStringLen, 'y')));
+
+// Decodes a payload with kRepeatedLen elements of one repeated or map field.
+#define CODEC_DECODE_REPEATED_BENCHMARK(name, stmt)         \
+  static void BM_Decode_##name(benchmark::State& state) {   \
+    CodecMessage filled;                                    \
+    for (int i = 0; i < kRepeatedLen; ++i) {                \
+      stmt;                                                 \
+    }                                                       \
+    const std::string payload = filled.SerializeAsString(); \
+    CodecMessage m;                                         \
+    for (auto _ : state) {                                  \
+      bool ok = m.ParseFromString(payload);                 \
+      ABSL_CHECK(ok);                                       \
+    }                                                       \
+    state.SetBytesProcessed(state.iterations() * payload.size()); \
+  }                                                         \
+  BENCHMARK(BM_Decode_##name)
+
+CODEC_DECODE_REPEATED_BENCHMARK(PackedInt32, filled.add_packed_int32(i * 3));
+CODEC_DECODE_REPEATED_BENCHMARK(PackedDouble, filled.add_packed_double(i * 0.5));
+CODEC_DECODE_REPEATED_BENCHMARK(PackedFixed32, filled.add_packed_fixed32(i));
+// The next two decode the same values as fixed-stride vs. varint blocks;
+// their ratio is the cost of varint decode for 64-bit numeric vectors.
+CODEC_DECODE_REPEATED_BENCHMARK(PackedSfixed64,
+                                filled.add_packed_sfixed64(int64_t{1} << 60 | i));
+CODEC_DECODE_REPEATED_BENCHMARK(PackedInt64Varint,
+                                filled.add_packed_int64(int64_t{1} << 60 | i));
+CODEC_DECODE_REPEATED_BENCHMARK(UnpackedInt32, filled.add_unpacked_int32(i * 3));
+CODEC_DECODE_REPEATED_BENCHMARK(RepeatedString,
+                                filled.add_rep_string(std::string(kStringLen, 'x')));
+CODEC_DECODE_REPEATED_BENCHMARK(RepeatedMessage, {
+  CodecSub* sub = filled.add_rep_msg();
+  sub->set_id(i);
+  sub->set_payload("payload");
+});
+CODEC_DECODE_REPEATED_BENCHMARK(MapInt32, (*filled.mutable_map_int32())[i] = i);
+CODEC_DECODE_REPEATED_BENCHMARK(
+    MapString,
+    (*filled.mutable_map_string())[absl::StrCat("key", i)] = "value");
+
+// A message with every field of the codec schema populated, for whole-message
+// encode/decode and round-trip benchmarks.
+static CodecMessage MakePopulatedMessage() {
+  CodecMessage m;
+  m.set_opt_int32(0x7ffffff);
+  m.set_opt_int64(int64_t{0x7ffffffffff});
+  m.set_opt_uint32(0xfffffffu);
+  m.set_opt_uint64(uint64_t{0xfffffffffff});
+  m.set_opt_sint32(-0x7ffffff);
+  m.set_opt_sint64(-int64_t{0x7ffffffffff});
+  m.set_opt_fixed32(0xdeadbeef);
+  m.set_opt_fixed64(0xdeadbeefcafe);
+  m.set_opt_sfixed32(-12345678);
+  m.set_opt_sfixed64(-1234567890123);
+  m.set_opt_float(3.14159f);
+  m.set_opt_double(2.71828);
+  m.set_opt_bool(true);
+  m.set_opt_string(std::string(kStringLen, 'x'));
+  m.set_opt_bytes(std::string(kStringLen, 'y'));
+  m.mutable_opt_msg()->set_id(1);
+  m.mutable_opt_msg()->set_payload("payload");
+  for (int i = 0; i < 64; ++i) {
+    m.add_packed_int32(i * 3);
+    m.add_packed_double(i * 0.5);
+    m.add_packed_fixed32(i);
+    m.add_unpacked_int32(i * 3);
+    m.add_rep_string(absl::StrCat("string", i));
+    CodecSub* sub = m.add_rep_msg();
+    sub->set_id(i);
+    sub->set_payload("payload");
+    (*m.mutable_map_int32())[i] = i;
+    (*m.mutable_map_string())[absl::StrCat("key", i)] = "value";
+  }
+  return m;
+}
+
+enum ArenaMode {
+  NoArena,
+  UseArena,
+};
+
+template <ArenaMode AMode>
+static void BM_Decode_AllFields(benchmark::State& state) {
+  const std::string payload = MakePopulatedMessage().SerializeAsString();
+  for (auto _ : state) {
+    if (AMode == UseArena) {
+      protobuf::Arena arena;
+      auto* m = protobuf::Arena::Create<CodecMessage>(&arena);
+      bool ok = m->ParseFromString(payload);
+      ABSL_CHECK(ok);
+    } else {
+      CodecMessage m;
+      bool ok = m.ParseFromString(payload);
+      ABSL_CHECK(ok);
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * payload.size());
+}
+BENCHMARK_TEMPLATE(BM_Decode_AllFields, NoArena);
+BENCHMARK_TEMPLATE(BM_Decode_AllFields, UseArena);
+
+// Per-request reset strategies: recursive Clear() walks every set field,
+// while resetting the owning arena and re-creating the message invalidates
+// everything wholesale. Parsing the same payload in both keeps the work per
+// iteration identical apart from the reset itself.
+static void BM_ClearAndReparse_AllFields(benchmark::State& state) {
+  const std::string payload = MakePopulatedMessage().SerializeAsString();
+  CodecMessage m;
+  for (auto _ : state) {
+    m.Clear();
+    bool ok = m.ParseFromString(payload);
+    ABSL_CHECK(ok);
+  }
+  state.SetBytesProcessed(state.iterations() * payload.size());
+}
+BENCHMARK(BM_ClearAndReparse_AllFields);
+
+static void BM_ArenaResetAndReparse_AllFields(benchmark::State& state) {
+  const std::string payload = MakePopulatedMessage().SerializeAsString();
+  protobuf::Arena arena;
+  for (auto _ : state) {
+    arena.Reset();
+    auto* m = protobuf::Arena::Create<CodecMessage>(&arena);
+    bool ok = m->ParseFromString(payload);
+    ABSL_CHECK(ok);
+  }
+  state.SetBytesProcessed(state.iterations() * payload.size());
+}
+BENCHMARK(BM_ArenaResetAndReparse_AllFields);
+
+static void BM_ByteSize_AllFields(benchmark::State& state) {
+  const CodecMessage m = MakePopulatedMessage();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(m.ByteSizeLong());
+  }
+  state.SetBytesProcessed(state.iterations() * m.ByteSizeLong());
+}
+BENCHMARK(BM_ByteSize_AllFields);
+
+static void BM_Serialize_AllFields(benchmark::State& state) {
+  const CodecMessage m = MakePopulatedMessage();
+  std::string out;
+  for (auto _ : state) {
+    out.clear();
+    bool ok = m.SerializeToString(&out);
+    ABSL_CHECK(ok);
+  }
+  state.SetBytesProcessed(state.iterations() * out.size());
+}
+BENCHMARK(BM_Serialize_AllFields);
+
+static void BM_JsonSerialize_Codec(benchmark::State& state) {
+  const CodecMessage m = MakePopulatedMessage();
+  std::string json;
+  for (auto _ : state) {
+    json.clear();
+    ABSL_CHECK_OK(protobuf::json::MessageToJsonString(m, &json));
+  }
+  state.SetBytesProcessed(state.iterations() * json.size());
+}
+BENCHMARK(BM_JsonSerialize_Codec);
+
+static void BM_JsonParse_Codec(benchmark::State& state) {
+  std::string json;
+  ABSL_CHECK_OK(
+      protobuf::json::MessageToJsonString(MakePopulatedMessage(), &json));
+  for (auto _ : state) {
+    CodecMessage m;
+    ABSL_CHECK_OK(protobuf::json::JsonStringToMessage(json, &m));
+  }
+  state.SetBytesProcessed(state.iterations() * json.size());
+}
+BENCHMARK(BM_JsonParse_Codec);
+
+static void BM_TextFormatSerialize_Codec(benchmark::State& state) {
+  const CodecMessage m = MakePopulatedMessage();
+  std::string text;
+  for (auto _ : state) {
+    text.clear();
+    bool ok = protobuf::TextFormat::PrintToString(m, &text);
+    ABSL_CHECK(ok);
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_TextFormatSerialize_Codec);
+
+static void BM_TextFormatParse_Codec(benchmark::State& state) {
+  std::string text;
+  ABSL_CHECK(
+      protobuf::TextFormat::PrintToString(MakePopulatedMessage(), &text));
+  for (auto _ : state) {
+    CodecMessage m;
+    bool ok = protobuf::TextFormat::ParseFromString(text, &m);
+    ABSL_CHECK(ok);
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_TextFormatParse_Codec);
+
+// The 100_fields schema draws its field types from real-world frequencies,
+// so parsing it approximates the parser's aggregate dispatch mix.  Fill it
+// via reflection so this file does not hard-code the generated field names.
+static void FillAllFieldsViaReflection(protobuf::Message* message) {
+  const protobuf::Descriptor* descriptor = message->GetDescriptor();
+  const protobuf::Reflection* reflection = message->GetReflection();
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    const protobuf::FieldDescriptor* field = descriptor->field(i);
+    const int count = field->is_repeated() ? 4 : 1;
+    for (int j = 0; j < count; ++j) {
+      switch (field->cpp_type()) {
+        case protobuf::FieldDescriptor::CPPTYPE_INT32:
+          field->is_repeated() ? reflection->AddInt32(message, field, j)
+                               : reflection->SetInt32(message, field, 1);
+          break;
+        case protobuf::FieldDescriptor::CPPTYPE_INT64:
+          field->is_repeated() ? reflection->AddInt64(message, field, j)
+                               : reflection->SetInt64(message, field, 1);
+          break;
+        case protobuf::FieldDescriptor::CPPTYPE_UINT32:
+          field->is_repeated() ? reflection->AddUInt32(message, field, j)
+                               : reflection->SetUInt32(message, field, 1);
+          break;
+        case protobuf::FieldDescriptor::CPPTYPE_UINT64:
+          field->is_repeated() ? reflection->AddUInt64(message, field, j)
+                               : reflection->SetUInt64(message, field, 1);
+          break;
+        case protobuf::FieldDescriptor::CPPTYPE_DOUBLE:
+          field->is_repeated() ? reflection->AddDouble(message, field, j)
+                               : reflection->SetDouble(message, field, 1);
+          break;
+        case protobuf::FieldDescriptor::CPPTYPE_FLOAT:
+          field->is_repeated() ? reflection->AddFloat(message, field, j)
+                               : reflection->SetFloat(message, field, 1);
+          break;
+        case protobuf::FieldDescriptor::CPPTYPE_BOOL:
+          field->is_repeated() ? reflection->AddBool(message, field, true)
+                               : reflection->SetBool(message, field, true);
+          break;
+        case protobuf::FieldDescriptor::CPPTYPE_ENUM:
+          field->is_repeated()
+              ? reflection->AddEnum(message, field,
+                                    field->enum_type()->value(0))
+              : reflection->SetEnum(message, field,
+                                    field->enum_type()->value(0));
+          break;
+        case protobuf::FieldDescriptor::CPPTYPE_STRING:
+          field->is_repeated()
+              ? reflection->AddString(message, field, "hello world")
+              : reflection->SetString(message, field, "hello world");
+          break;
+        case protobuf::FieldDescriptor::CPPTYPE_MESSAGE:
+          // Presence only; the schema's message fields are recursive, so we
+          // leave the submessage empty.
+          if (field->is_repeated()) {
+            reflection->AddMessage(message, field);
+          } else {
+            reflection->MutableMessage(message, field);
+          }
+          break;
+      }
+    }
+  }
+}
+
+static void BM_Decode_Synthetic100Fields(benchmark::State& state) {
+  upb_benchmark::Message filled;
+  FillAllFieldsViaReflection(&filled);
+  const std::string payload = filled.SerializeAsString();
+  upb_benchmark::Message m;
+  for (auto _ : state) {
+    bool ok = m.ParseFromString(payload);
+    ABSL_CHECK(ok);
+  }
+  state.SetBytesProcessed(state.iterations() * payload.size());
+}
+BENCHMARK(BM_Decode_Synthetic100Fields);
+
+static void BM_Serialize_Synthetic100Fields(benchmark::State& state) {
+  upb_benchmark::Message m;
+  FillAllFieldsViaReflection(&m);
+  std::string out;
+  for (auto _ : state) {
+    out.clear();
+    bool ok = m.SerializeToString(&out);
+    ABSL_CHECK(ok);
+  }
+  state.SetBytesProcessed(state.iterations() * out.size());
+}
+BENCHMARK(BM_Serialize_Synthetic100Fields);
@@ -0,0 +1,219 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google LLC.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+// Replays recorded wire-format corpora (see corpus_replay.proto) through the
+// parse, serialize and JSON paths and reports throughput and an arena
+// allocation footprint per sample.  Sample files are given on the command
+// line after the benchmark flags:
+//
+//   bazel run -c opt //benchmarks:corpus_replay_benchmark -- \
+//       --benchmark_repetitions=20 /path/to/sample1.bin /path/to/sample2.bin
+//
+// With --benchmark_repetitions each benchmark also reports a p99 row, so two
+// releases can be compared by diffing the output of the same invocation.
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/log/absl_check.h"
+#include "absl/strings/str_cat.h"
+#include "google/protobuf/arena.h"
+#include "benchmarks/corpus_replay.pb.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/descriptor.pb.h"
+#include "google/protobuf/dynamic_message.h"
+#include "google/protobuf/json/json.h"
+#include "google/protobuf/message.h"
+
+namespace protobuf = ::google::protobuf;
+
+namespace {
+
+// A loaded sample owns the descriptor pool and message factory backing its
+// prototype, so it must outlive the benchmark run.
+struct LoadedSample {
+  std::string name;
+  std::unique_ptr<protobuf::DescriptorPool> pool;
+  std::unique_ptr<protobuf::DynamicMessageFactory> factory;
+  const protobuf::Message* prototype = nullptr;
+  std::vector<std::string> payloads;
+  int64_t total_payload_bytes = 0;
+};
+
+std::unique_ptr<LoadedSample> LoadSample(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  ABSL_CHECK(in.good()) << "cannot open " << path;
+  std::string data((std::istreambuf_iterator<char>(in)),
+                   std::istreambuf_iterator<char>());
+
+  upb_benchmark::CorpusSample sample;
+  ABSL_CHECK(sample.ParseFromString(data)) << path << ": not a CorpusSample";
+
+  protobuf::FileDescriptorSet file_set;
+  ABSL_CHECK(file_set.ParseFromString(sample.file_descriptor_set()))
+      << path << ": file_descriptor_set is not a FileDescriptorSet";
+
+  auto loaded = std::make_unique<LoadedSample>();
+  loaded->name = sample.name().empty() ? path : sample.name();
+  loaded->pool = std::make_unique<protobuf::DescriptorPool>();
+  for (const auto& file : file_set.file()) {
+    ABSL_CHECK(loaded->pool->BuildFile(file) != nullptr)
+        << path << ": cannot build " << file.name();
+  }
+  const protobuf::Descriptor* descriptor =
+      loaded->pool->FindMessageTypeByName(sample.message_name());
+  ABSL_CHECK(descriptor != nullptr)
+      << path << ": no message type named " << sample.message_name();
+  loaded->factory = std::make_unique<protobuf::DynamicMessageFactory>();
+  loaded->prototype = loaded->factory->GetPrototype(descriptor);
+
+  ABSL_CHECK(sample.payload_size() > 0) << path << ": no payloads";
+  for (const auto& payload : sample.payload()) {
+    loaded->payloads.push_back(payload);
+    loaded->total_payload_bytes += payload.size();
+  }
+  return loaded;
+}
+
+// Parses every recorded payload into a fresh arena-allocated message.  The
+// arena_bytes counter reports the arena space one replay needs, as a proxy
+// for allocation volume.
+void BM_Parse(benchmark::State& state, const LoadedSample* sample) {
+  protobuf::Arena arena;
+  int64_t arena_bytes = 0;
+  for (auto _ : state) {
+    arena.Reset();
+    for (const std::string& payload : sample->payloads) {
+      protobuf::Message* message = sample->prototype->New(&arena);
+      bool ok = message->ParseFromString(payload);
+      ABSL_CHECK(ok);
+    }
+    arena_bytes = static_cast<int64_t>(arena.SpaceAllocated());
+  }
+  state.SetBytesProcessed(state.iterations() * sample->total_payload_bytes);
+  state.counters["arena_bytes"] = static_cast<double>(arena_bytes);
+}
+
+void BM_Serialize(benchmark::State& state, const LoadedSample* sample) {
+  protobuf::Arena arena;
+  std::vector<const protobuf::Message*> messages;
+  for (const std::string& payload : sample->payloads) {
+    protobuf::Message* message = sample->prototype->New(&arena);
+    ABSL_CHECK(message->ParseFromString(payload));
+    messages.push_back(message);
+  }
+  std::string wire;
+  int64_t bytes = 0;
+  for (auto _ : state) {
+    bytes = 0;
+    for (const protobuf::Message* message : messages) {
+      wire.clear();
+      bool ok = message->SerializeToString(&wire);
+      ABSL_CHECK(ok);
+      bytes += wire.size();
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * bytes);
+}
+
+void BM_JsonSerialize(benchmark::State& state, const LoadedSample* sample) {
+  protobuf::Arena arena;
+  std::vector<const protobuf::Message*> messages;
+  for (const std::string& payload : sample->payloads) {
+    protobuf::Message* message = sample->prototype->New(&arena);
+    ABSL_CHECK(message->ParseFromString(payload));
+    messages.push_back(message);
+  }
+  std::string json;
+  int64_t bytes = 0;
+  for (auto _ : state) {
+    bytes = 0;
+    for (const protobuf::Message* message : messages) {
+      json.clear();
+      auto status = protobuf::json::MessageToJsonString(*message, &json);
+      ABSL_CHECK(status.ok());
+      bytes += json.size();
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * bytes);
+}
+
+void BM_JsonParse(benchmark::State& state, const LoadedSample* sample) {
+  protobuf::Arena arena;
+  std::vector<std::string> jsons;
+  int64_t bytes = 0;
+  for (const std::string& payload : sample->payloads) {
+    protobuf::Message* message = sample->prototype->New(&arena);
+    ABSL_CHECK(message->ParseFromString(payload));
+    std::string json;
+    ABSL_CHECK(protobuf::json::MessageToJsonString(*message, &json).ok());
+    bytes += json.size();
+    jsons.push_back(std::move(json));
+  }
+  for (auto _ : state) {
+    arena.Reset();
+    for (const std::string& json : jsons) {
+      protobuf::Message* message = sample->prototype->New(&arena);
+      auto status = protobuf::json::JsonStringToMessage(json, message);
+      ABSL_CHECK(status.ok());
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * bytes);
+}
+
+// Reported per benchmark when run with --benchmark_repetitions.
+double Percentile99(const std::vector<double>& samples) {
+  std::vector<double> sorted = samples;
+  std::sort(sorted.begin(), sorted.end());
+  size_t index =
+      static_cast<size_t>(std::ceil(sorted.size() * 0.99)) - 1;
+  return sorted[std::min(index, sorted.size() - 1)];
+}
+
+void RegisterSample(const LoadedSample* sample) {
+  struct {
+    const char* suffix;
+    void (*fn)(benchmark::State&, const LoadedSample*);
+  } benchmarks[] = {
+      {"Parse", BM_Parse},
+      {"Serialize", BM_Serialize},
+      {"JsonSerialize", BM_JsonSerialize},
+      {"JsonParse", BM_JsonParse},
+  };
+  for (const auto& bm : benchmarks) {
+    auto* fn = bm.fn;
+    benchmark::RegisterBenchmark(
+        absl::StrCat("BM_", sample->name, "/", bm.suffix).c_str(),
+        [fn, sample](benchmark::State& state) { fn(state, sample); })
+        ->ComputeStatistics("p99", Percentile99);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s [benchmark flags] SAMPLE_FILE...\n", argv[0]);
+    return 1;
+  }
+  std::vector<std::unique_ptr<LoadedSample>> samples;
+  for (int i = 1; i < argc; ++i) {
+    samples.push_back(LoadSample(argv[i]));
+    RegisterSample(samples.back().get());
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
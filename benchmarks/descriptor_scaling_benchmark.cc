@@ -0,0 +1,190 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google LLC.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+// Benchmarks DescriptorPool build scaling.  Synthetic FileDescriptorProto
+// dependency graphs (wide fan-in, deep chains, overlapping diamonds) are
+// generated in memory and built file-by-file, so the numbers isolate
+// BuildFile and the pool's Tables from parsing and I/O.  Each benchmark also
+// reports the pool's heap growth, which tracks Tables allocation (interned
+// strings plus descriptor payloads) as the file count rises:
+//   bazel run -c opt //benchmarks:descriptor_scaling_benchmark
+
+#include <benchmark/benchmark.h>
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+#include <malloc.h>
+#endif
+
+#include "absl/log/absl_check.h"
+#include "absl/strings/str_cat.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/descriptor.pb.h"
+
+namespace protobuf = ::google::protobuf;
+
+constexpr int kMessagesPerFile = 4;
+constexpr int kScalarFieldsPerMessage = 8;
+
+std::string FileName(int index) {
+  return absl::StrCat("bench/scale/file_", index, ".proto");
+}
+
+std::string MessageName(int file, int index) {
+  return absl::StrCat("M", file, "_", index);
+}
+
+// One synthetic file: kMessagesPerFile messages of scalar fields, plus one
+// message-typed field per dependency so that cross-file symbol resolution
+// scales with the import count.
+protobuf::FileDescriptorProto MakeFile(int index, const std::vector<int>& deps) {
+  protobuf::FileDescriptorProto file;
+  file.set_name(FileName(index));
+  file.set_package("bench.scale");
+  file.set_syntax("proto3");
+  for (int dep : deps) file.add_dependency(FileName(dep));
+  for (int m = 0; m < kMessagesPerFile; ++m) {
+    protobuf::DescriptorProto* message = file.add_message_type();
+    message->set_name(MessageName(index, m));
+    int number = 1;
+    for (int f = 0; f < kScalarFieldsPerMessage; ++f) {
+      protobuf::FieldDescriptorProto* field = message->add_field();
+      field->set_name(absl::StrCat("f", f));
+      field->set_number(number++);
+      field->set_label(protobuf::FieldDescriptorProto::LABEL_OPTIONAL);
+      field->set_type(f % 2 == 0 ? protobuf::FieldDescriptorProto::TYPE_INT64
+                                 : protobuf::FieldDescriptorProto::TYPE_STRING);
+    }
+    for (size_t d = 0; d < deps.size(); ++d) {
+      protobuf::FieldDescriptorProto* field = message->add_field();
+      field->set_name(absl::StrCat("dep", d));
+      field->set_number(number++);
+      field->set_label(protobuf::FieldDescriptorProto::LABEL_OPTIONAL);
+      field->set_type(protobuf::FieldDescriptorProto::TYPE_MESSAGE);
+      field->set_type_name(
+          absl::StrCat(".bench.scale.", MessageName(deps[d], 0)));
+    }
+  }
+  return file;
+}
+
+enum class Shape {
+  kWide,     // n - 1 independent leaves plus one aggregator importing all.
+  kDeep,     // A linear import chain of length n.
+  kDiamond,  // File i imports i - 1 and i - 2: overlapping paths to every
+             // transitive dependency.
+};
+
+// Files come back in topological order, so building them front to back
+// never hits a missing dependency.
+std::vector<protobuf::FileDescriptorProto> MakeGraph(Shape shape, int n) {
+  std::vector<protobuf::FileDescriptorProto> files;
+  files.reserve(n);
+  for (int i = 0; i < n; ++i) {
+    std::vector<int> deps;
+    switch (shape) {
+      case Shape::kWide:
+        if (i == n - 1) {
+          for (int d = 0; d < n - 1; ++d) deps.push_back(d);
+        }
+        break;
+      case Shape::kDeep:
+        if (i > 0) deps.push_back(i - 1);
+        break;
+      case Shape::kDiamond:
+        if (i > 0) deps.push_back(i - 1);
+        if (i > 1) deps.push_back(i - 2);
+        break;
+    }
+    files.push_back(MakeFile(i, deps));
+  }
+  return files;
+}
+
+int64_t HeapUsedBytes() {
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+  return static_cast<int64_t>(mallinfo2().uordblks);
+#else
+  return 0;
+#endif
+}
+
+class CountingErrorCollector : public protobuf::DescriptorPool::ErrorCollector {
+ public:
+  void RecordError(absl::string_view filename, absl::string_view element_name,
+                   const protobuf::Message* descriptor, ErrorLocation location,
+                   absl::string_view message) override {
+    ++errors_;
+  }
+
+  int errors() const { return errors_; }
+
+ private:
+  int errors_ = 0;
+};
+
+void BuildGraphBenchmark(benchmark::State& state, Shape shape,
+                         bool collect_errors) {
+  const int n = static_cast<int>(state.range(0));
+  const std::vector<protobuf::FileDescriptorProto> files = MakeGraph(shape, n);
+
+  // One untimed build measures the pool's heap growth; everything the pool
+  // retains lives in its Tables, so the delta is the Tables footprint.
+  int64_t heap_delta;
+  {
+    const int64_t before = HeapUsedBytes();
+    protobuf::DescriptorPool pool;
+    for (const protobuf::FileDescriptorProto& file : files) {
+      ABSL_CHECK(pool.BuildFile(file) != nullptr);
+    }
+    heap_delta = HeapUsedBytes() - before;
+  }
+
+  CountingErrorCollector collector;
+  for (auto _ : state) {
+    protobuf::DescriptorPool pool;
+    for (const protobuf::FileDescriptorProto& file : files) {
+      const protobuf::FileDescriptor* built =
+          collect_errors ? pool.BuildFileCollectingErrors(file, &collector)
+                         : pool.BuildFile(file);
+      ABSL_CHECK(built != nullptr);
+    }
+  }
+  ABSL_CHECK_EQ(collector.errors(), 0);
+
+  state.SetItemsProcessed(state.iterations() * n);
+  state.counters["heap_bytes"] = static_cast<double>(heap_delta);
+  state.counters["heap_bytes_per_file"] = static_cast<double>(heap_delta) / n;
+}
+
+void BM_BuildFile_Wide(benchmark::State& state) {
+  BuildGraphBenchmark(state, Shape::kWide, false);
+}
+BENCHMARK(BM_BuildFile_Wide)->RangeMultiplier(4)->Range(16, 16 << 10);
+
+void BM_BuildFile_Deep(benchmark::State& state) {
+  BuildGraphBenchmark(state, Shape::kDeep, false);
+}
+BENCHMARK(BM_BuildFile_Deep)->RangeMultiplier(4)->Range(16, 16 << 10);
+
+void BM_BuildFile_Diamond(benchmark::State& state) {
+  BuildGraphBenchmark(state, Shape::kDiamond, false);
+}
+BENCHMARK(BM_BuildFile_Diamond)->RangeMultiplier(4)->Range(16, 16 << 10);
+
+// The error-collecting entry point takes a different code path through
+// DescriptorBuilder; one shape is enough to keep its overhead pinned.
+void BM_BuildFileCollectingErrors_Deep(benchmark::State& state) {
+  BuildGraphBenchmark(state, Shape::kDeep, true);
+}
+BENCHMARK(BM_BuildFileCollectingErrors_Deep)
+    ->RangeMultiplier(4)
+    ->Range(16, 16 << 10);
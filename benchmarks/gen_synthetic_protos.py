@@ -121,3 +121,44 @@ with open(base + "/200_fields.proto", "w") as f:
     f.write('  {label} {field_type} field{i} = {i};\n'.format(i=i, label=label,field_type=field_type))
     i += 1
   f.write('}\n')
+
+# A hand-shaped schema exercising each codec path once: every scalar type,
+# packed and unpacked repeated fields, strings, maps and submessages.  It is
+# fully deterministic; it lives here rather than being checked in so that all
+# benchmark schemas are pinned in one place.
+with open(base + "/codec.proto", "w") as f:
+  f.write('syntax = "proto3";\n')
+  f.write('package upb_benchmark;\n')
+  f.write('message CodecSub {\n')
+  f.write('  int32 id = 1;\n')
+  f.write('  string payload = 2;\n')
+  f.write('}\n')
+  f.write('message CodecMessage {\n')
+  scalar_fields = [
+      'int32', 'int64', 'uint32', 'uint64', 'sint32', 'sint64', 'fixed32',
+      'fixed64', 'sfixed32', 'sfixed64', 'float', 'double', 'bool',
+  ]
+  i = 1
+  for field_type in scalar_fields:
+    f.write('  {t} opt_{t} = {i};\n'.format(t=field_type, i=i))
+    i += 1
+  other_fields = [
+      'string opt_string',
+      'bytes opt_bytes',
+      'CodecSub opt_msg',
+      'repeated int32 packed_int32',
+      'repeated double packed_double',
+      'repeated fixed32 packed_fixed32',
+      'repeated sfixed64 packed_sfixed64',
+      'repeated int64 packed_int64',
+      'repeated int32 unpacked_int32',
+      'repeated string rep_string',
+      'repeated CodecSub rep_msg',
+      'map<int32, int32> map_int32',
+      'map<string, string> map_string',
+  ]
+  for decl in other_fields:
+    opts = ' [packed = false]' if 'unpacked' in decl else ''
+    f.write('  {decl} = {i}{opts};\n'.format(decl=decl, i=i, opts=opts))
+    i += 1
+  f.write('}\n')
@@ -0,0 +1,125 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google LLC.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+// Microbenchmarks for the optional runtime hardening layers, paired so the
+// cost of each layer is the delta between the hardened entry point and its
+// unhardened twin on the same data:
+//
+//  - RepeatedField::at() vs. Get()            (bounds checks)
+//  - RepeatedPtrField::at() vs. Get()         (bounds checks)
+//  - Map::at() vs. find()                     (missing-key check)
+//  - arena allocation                         (sanitizer poisoning; a no-op
+//                                              in non-sanitizer builds)
+//
+// Run once with the default configuration and once with
+// --define=protobuf_max_performance=1; the per-layer cost report in
+// docs/design/max-performance-build.md comes from comparing the two runs:
+//   bazel run -c opt //benchmarks:hardening_benchmark
+//   bazel run -c opt --define=protobuf_max_performance=1 \
+//       //benchmarks:hardening_benchmark
+
+#include <benchmark/benchmark.h>
+
+#include <stdint.h>
+
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "google/protobuf/arena.h"
+#include "google/protobuf/map.h"
+#include "google/protobuf/repeated_field.h"
+#include "google/protobuf/repeated_ptr_field.h"
+
+namespace protobuf = ::google::protobuf;
+
+constexpr int kElements = 1024;
+
+static void BM_RepeatedFieldGet(benchmark::State& state) {
+  protobuf::RepeatedField<int32_t> field;
+  for (int i = 0; i < kElements; ++i) field.Add(i);
+  for (auto _ : state) {
+    int64_t sum = 0;
+    for (int i = 0; i < kElements; ++i) sum += field.Get(i);
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * kElements);
+}
+BENCHMARK(BM_RepeatedFieldGet);
+
+static void BM_RepeatedFieldAt(benchmark::State& state) {
+  protobuf::RepeatedField<int32_t> field;
+  for (int i = 0; i < kElements; ++i) field.Add(i);
+  for (auto _ : state) {
+    int64_t sum = 0;
+    for (int i = 0; i < kElements; ++i) sum += field.at(i);
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * kElements);
+}
+BENCHMARK(BM_RepeatedFieldAt);
+
+static void BM_RepeatedPtrFieldGet(benchmark::State& state) {
+  protobuf::RepeatedPtrField<std::string> field;
+  for (int i = 0; i < kElements; ++i) *field.Add() = absl::StrCat("elem", i);
+  for (auto _ : state) {
+    size_t total = 0;
+    for (int i = 0; i < kElements; ++i) total += field.Get(i).size();
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * kElements);
+}
+BENCHMARK(BM_RepeatedPtrFieldGet);
+
+static void BM_RepeatedPtrFieldAt(benchmark::State& state) {
+  protobuf::RepeatedPtrField<std::string> field;
+  for (int i = 0; i < kElements; ++i) *field.Add() = absl::StrCat("elem", i);
+  for (auto _ : state) {
+    size_t total = 0;
+    for (int i = 0; i < kElements; ++i) total += field.at(i).size();
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * kElements);
+}
+BENCHMARK(BM_RepeatedPtrFieldAt);
+
+static void BM_MapFind(benchmark::State& state) {
+  protobuf::Map<int32_t, int32_t> map;
+  for (int i = 0; i < kElements; ++i) map[i] = i;
+  for (auto _ : state) {
+    int64_t sum = 0;
+    for (int i = 0; i < kElements; ++i) sum += map.find(i)->second;
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * kElements);
+}
+BENCHMARK(BM_MapFind);
+
+static void BM_MapAt(benchmark::State& state) {
+  protobuf::Map<int32_t, int32_t> map;
+  for (int i = 0; i < kElements; ++i) map[i] = i;
+  for (auto _ : state) {
+    int64_t sum = 0;
+    for (int i = 0; i < kElements; ++i) sum += map.at(i);
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * kElements);
+}
+BENCHMARK(BM_MapAt);
+
+// Arena poisoning hooks compile to nothing outside sanitizer builds; this
+// pins the allocation path so a sanitizer run shows the poisoning cost
+// against the same baseline.
+static void BM_ArenaAllocate(benchmark::State& state) {
+  for (auto _ : state) {
+    protobuf::Arena arena;
+    for (int i = 0; i < kElements; ++i) {
+      benchmark::DoNotOptimize(protobuf::Arena::CreateArray<char>(&arena, 64));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kElements);
+}
+BENCHMARK(BM_ArenaAllocate);
@@ -0,0 +1,251 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google LLC.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+// Scenario benchmarks modeling a full request lifecycle: parse the request,
+// read its fields, build a response referencing request data, serialize the
+// response, reset for the next request.  Microbenchmarks of the individual
+// steps miss the interaction effects this suite is after: arena reuse vs.
+// the block cache, Clear() vs. Reset(), and cache pollution between phases.
+//
+// The lifecycle runs under three reuse strategies -- a fresh arena per
+// request, one arena with Reset(), and a pooled heap message pair with
+// Clear() -- across three message shapes.  The phases are also registered as
+// separate benchmarks so that hardware counters attribute cost per phase;
+// with libpfm available, run
+//
+//   bazel run -c opt //benchmarks:pipeline_benchmark -- \
+//       --benchmark_perf_counters=CYCLES,INSTRUCTIONS,LLC-MISSES
+//
+// to get cycles, instructions and LLC misses next to each row.  Arena
+// allocation volume is reported per lifecycle via the arena_bytes counter.
+
+#include <benchmark/benchmark.h>
+
+#include <stdint.h>
+
+#include <string>
+
+#include "absl/log/absl_check.h"
+#include "absl/strings/str_cat.h"
+#include "google/protobuf/arena.h"
+#include "benchmarks/pipeline.pb.h"
+
+namespace protobuf = ::google::protobuf;
+
+using upb_benchmark::PipelineRecord;
+using upb_benchmark::PipelineRequest;
+using upb_benchmark::PipelineResponse;
+
+namespace {
+
+// Message shapes for the request:
+//  - kFlat: a handful of scalars, a short packed array and a small payload;
+//    the per-request fixed costs dominate.
+//  - kDeep: 64 nested records with labels and sample arrays; submessage
+//    allocation and traversal dominate.
+//  - kStringHeavy: a 16 KiB payload plus 32 long labels; string copying
+//    dominates and the payload is echoed into the response.
+enum Shape { kFlat, kDeep, kStringHeavy };
+
+void FillRequest(Shape shape, PipelineRequest& request) {
+  request.set_request_id(1234567);
+  request.set_client_id("pipeline-benchmark-client");
+  request.set_priority(3);
+  switch (shape) {
+    case kFlat:
+      for (int i = 0; i < 16; ++i) request.add_tags(i * 7);
+      request.set_opaque_payload(std::string(512, 'x'));
+      break;
+    case kDeep:
+      for (int i = 0; i < 64; ++i) {
+        PipelineRecord* record = request.add_records();
+        record->set_id(i);
+        record->set_label(absl::StrCat("record-", i));
+        for (int j = 0; j < 8; ++j) record->add_samples(i * 0.5 + j);
+      }
+      break;
+    case kStringHeavy:
+      request.set_opaque_payload(std::string(16 << 10, 'x'));
+      for (int i = 0; i < 32; ++i) {
+        PipelineRecord* record = request.add_records();
+        record->set_id(i);
+        record->set_label(std::string(256, static_cast<char>('a' + i % 26)));
+      }
+      break;
+  }
+}
+
+std::string RequestWire(Shape shape) {
+  PipelineRequest request;
+  FillRequest(shape, request);
+  return request.SerializeAsString();
+}
+
+// The read/build phase: walk the parsed request and build a response that
+// references its data (ids and means computed from the records, the payload
+// echoed back).
+void BuildResponse(const PipelineRequest& request, PipelineResponse& response) {
+  response.set_request_id(request.request_id());
+  response.set_status(request.priority() > 0 ? 1 : 0);
+  response.set_client_id(request.client_id());
+  for (const PipelineRecord& record : request.records()) {
+    response.add_record_ids(record.id());
+    double sum = 0;
+    for (double sample : record.samples()) sum += sample;
+    response.add_record_means(
+        record.samples().empty() ? 0.0 : sum / record.samples_size());
+  }
+  response.set_opaque_payload(request.opaque_payload());
+}
+
+// One full lifecycle against the given (already reset) message pair.
+void RunLifecycle(const std::string& wire, PipelineRequest* request,
+                  PipelineResponse* response, std::string* out) {
+  bool ok = request->ParseFromString(wire);
+  ABSL_CHECK(ok);
+  BuildResponse(*request, *response);
+  out->clear();
+  ok = response->AppendToString(out);
+  ABSL_CHECK(ok);
+}
+
+// ---------------------------------------------------------------------------
+// Full lifecycle per reuse strategy.
+
+// A new arena per request: no block reuse, every lifecycle pays the initial
+// block allocations.
+template <Shape shape>
+void BM_Lifecycle_FreshArena(benchmark::State& state) {
+  const std::string wire = RequestWire(shape);
+  std::string out;
+  int64_t arena_bytes = 0;
+  for (auto _ : state) {
+    protobuf::Arena arena;
+    auto* request = protobuf::Arena::Create<PipelineRequest>(&arena);
+    auto* response = protobuf::Arena::Create<PipelineResponse>(&arena);
+    RunLifecycle(wire, request, response, &out);
+    arena_bytes = static_cast<int64_t>(arena.SpaceAllocated());
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(wire.size()));
+  state.counters["arena_bytes"] = static_cast<double>(arena_bytes);
+}
+BENCHMARK_TEMPLATE(BM_Lifecycle_FreshArena, kFlat);
+BENCHMARK_TEMPLATE(BM_Lifecycle_FreshArena, kDeep);
+BENCHMARK_TEMPLATE(BM_Lifecycle_FreshArena, kStringHeavy);
+
+// One arena reset between requests: blocks are cached, so steady-state
+// lifecycles allocate from warm memory.
+template <Shape shape>
+void BM_Lifecycle_ResetArena(benchmark::State& state) {
+  const std::string wire = RequestWire(shape);
+  protobuf::Arena arena;
+  std::string out;
+  for (auto _ : state) {
+    arena.Reset();
+    auto* request = protobuf::Arena::Create<PipelineRequest>(&arena);
+    auto* response = protobuf::Arena::Create<PipelineResponse>(&arena);
+    RunLifecycle(wire, request, response, &out);
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(wire.size()));
+  state.counters["arena_bytes"] = static_cast<double>(arena.SpaceAllocated());
+}
+BENCHMARK_TEMPLATE(BM_Lifecycle_ResetArena, kFlat);
+BENCHMARK_TEMPLATE(BM_Lifecycle_ResetArena, kDeep);
+BENCHMARK_TEMPLATE(BM_Lifecycle_ResetArena, kStringHeavy);
+
+// Pooled heap messages cleared between requests: Clear() keeps the arrays
+// and string capacity of the previous request, trading retained memory for
+// fewer allocations.  pool_bytes reports that retained footprint.
+template <Shape shape>
+void BM_Lifecycle_MessagePool(benchmark::State& state) {
+  const std::string wire = RequestWire(shape);
+  PipelineRequest request;
+  PipelineResponse response;
+  std::string out;
+  for (auto _ : state) {
+    request.Clear();
+    response.Clear();
+    RunLifecycle(wire, &request, &response, &out);
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(wire.size()));
+  state.counters["pool_bytes"] = static_cast<double>(
+      request.SpaceUsedLong() + response.SpaceUsedLong());
+}
+BENCHMARK_TEMPLATE(BM_Lifecycle_MessagePool, kFlat);
+BENCHMARK_TEMPLATE(BM_Lifecycle_MessagePool, kDeep);
+BENCHMARK_TEMPLATE(BM_Lifecycle_MessagePool, kStringHeavy);
+
+// ---------------------------------------------------------------------------
+// Individual phases, for attributing the lifecycle cost.  The phases run
+// under the Reset() strategy (the usual server deployment); diffing a phase
+// row against the matching full lifecycle row isolates the remaining phases'
+// share, including the cache pollution they cause each other.
+
+template <Shape shape>
+void BM_Phase_Parse(benchmark::State& state) {
+  const std::string wire = RequestWire(shape);
+  protobuf::Arena arena;
+  for (auto _ : state) {
+    arena.Reset();
+    auto* request = protobuf::Arena::Create<PipelineRequest>(&arena);
+    bool ok = request->ParseFromString(wire);
+    ABSL_CHECK(ok);
+    benchmark::DoNotOptimize(request);
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(wire.size()));
+  state.counters["arena_bytes"] = static_cast<double>(arena.SpaceAllocated());
+}
+BENCHMARK_TEMPLATE(BM_Phase_Parse, kFlat);
+BENCHMARK_TEMPLATE(BM_Phase_Parse, kDeep);
+BENCHMARK_TEMPLATE(BM_Phase_Parse, kStringHeavy);
+
+template <Shape shape>
+void BM_Phase_BuildResponse(benchmark::State& state) {
+  PipelineRequest request;
+  FillRequest(shape, request);
+  protobuf::Arena arena;
+  for (auto _ : state) {
+    arena.Reset();
+    auto* response = protobuf::Arena::Create<PipelineResponse>(&arena);
+    BuildResponse(request, *response);
+    benchmark::DoNotOptimize(response);
+  }
+  state.counters["arena_bytes"] = static_cast<double>(arena.SpaceAllocated());
+}
+BENCHMARK_TEMPLATE(BM_Phase_BuildResponse, kFlat);
+BENCHMARK_TEMPLATE(BM_Phase_BuildResponse, kDeep);
+BENCHMARK_TEMPLATE(BM_Phase_BuildResponse, kStringHeavy);
+
+template <Shape shape>
+void BM_Phase_Serialize(benchmark::State& state) {
+  PipelineRequest request;
+  FillRequest(shape, request);
+  PipelineResponse response;
+  BuildResponse(request, response);
+  std::string out;
+  int64_t bytes = 0;
+  for (auto _ : state) {
+    out.clear();
+    bool ok = response.AppendToString(&out);
+    ABSL_CHECK(ok);
+    bytes = static_cast<int64_t>(out.size());
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetBytesProcessed(state.iterations() * bytes);
+}
+BENCHMARK_TEMPLATE(BM_Phase_Serialize, kFlat);
+BENCHMARK_TEMPLATE(BM_Phase_Serialize, kDeep);
+BENCHMARK_TEMPLATE(BM_Phase_Serialize, kStringHeavy);
+
+}  // namespace
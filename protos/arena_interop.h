@@ -0,0 +1,63 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google LLC.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef UPB_PROTOS_ARENA_INTEROP_H_
+#define UPB_PROTOS_ARENA_INTEROP_H_
+
+#include <cstddef>
+#include <cstring>
+
+#include "google/protobuf/arena.h"
+#include "upb/mem/alloc.h"
+#include "upb/mem/arena.hpp"
+
+namespace protos {
+namespace internal {
+
+// upb_alloc that carves upb arena blocks out of a google::protobuf::Arena.
+// The shim itself is allocated on that arena, so it stays valid exactly as
+// long as the memory it handed out.  Frees are no-ops: the C++ arena
+// reclaims every block when it is destroyed, mirroring upb's own arena
+// semantics.
+struct CppArenaAlloc {
+  upb_alloc base;
+  ::google::protobuf::Arena* arena;
+
+  static void* Func(upb_alloc* alloc, void* ptr, size_t oldsize,
+                    size_t size) {
+    auto* self = reinterpret_cast<CppArenaAlloc*>(alloc);
+    if (size == 0) return nullptr;
+    void* mem =
+        ::google::protobuf::Arena::CreateArray<char>(self->arena, size);
+    if (ptr != nullptr && oldsize != 0) {
+      memcpy(mem, ptr, oldsize < size ? oldsize : size);
+    }
+    return mem;
+  }
+};
+
+}  // namespace internal
+
+// Returns a upb::Arena that draws all of its blocks from `arena`, so upb
+// messages created or parsed on it share one allocation source and one
+// lifetime with the C++ messages around them.  This lets a mixed code path
+// hand wire bytes to the upb parser without introducing a second lifetime to
+// manage: everything is reclaimed when the C++ arena is destroyed.
+//
+// `arena` must outlive the returned upb::Arena (and any arena fused with it)
+// and must not be Reset() while either is alive.
+inline upb::Arena CreateSharedArena(::google::protobuf::Arena* arena) {
+  auto* alloc = ::google::protobuf::Arena::Create<internal::CppArenaAlloc>(
+      arena);
+  alloc->base.func = &internal::CppArenaAlloc::Func;
+  alloc->arena = arena;
+  return upb::Arena(&alloc->base);
+}
+
+}  // namespace protos
+
+#endif  // UPB_PROTOS_ARENA_INTEROP_H_
@@ -0,0 +1,41 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google LLC.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "protos/arena_interop.h"
+
+#include <cstring>
+
+#include <gtest/gtest.h>
+#include "google/protobuf/arena.h"
+#include "protos/protos.h"
+#include "protos_generator/tests/test_model.upb.proto.h"
+#include "upb/mem/arena.h"
+
+namespace protos::testing {
+namespace {
+using ::protos_generator::test::protos::TestModel;
+
+TEST(CppGeneratedCode, SharedArenaDrawsFromCppArena) {
+  ::google::protobuf::Arena cpp_arena;
+  const uint64_t initial = cpp_arena.SpaceUsed();
+  upb::Arena arena = ::protos::CreateSharedArena(&cpp_arena);
+  void* mem = upb_Arena_Malloc(arena.ptr(), 4096);
+  ASSERT_NE(mem, nullptr);
+  memset(mem, 0xa5, 4096);
+  EXPECT_GE(cpp_arena.SpaceUsed(), initial + 4096);
+}
+
+TEST(CppGeneratedCode, SharedArenaMessageLifetime) {
+  ::google::protobuf::Arena cpp_arena;
+  upb::Arena arena = ::protos::CreateSharedArena(&cpp_arena);
+  auto model = ::protos::CreateMessage<TestModel>(arena);
+  model.set_str1("str");
+  EXPECT_EQ(model.str1(), "str");
+}
+
+}  // namespace
+}  // namespace protos::testing
@@ -25,17 +25,22 @@ set(libprotobuf_srcs
   ${protobuf_SOURCE_DIR}/src/google/protobuf/any_lite.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/arena.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/arena_align.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/arena_size_hint.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/arena_telemetry.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/arenastring.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/arenaz_sampler.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/codecz_sampler.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/compiler/importer.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/compiler/parser.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/cpp_features.pb.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/cpu_features.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/descriptor.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/descriptor.pb.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/descriptor_database.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/dynamic_message.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/extension_set.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/extension_set_heavy.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/fast_debug_string.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/feature_resolver.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/generated_enum_util.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/generated_message_bases.cc
@@ -76,17 +81,34 @@ set(libprotobuf_srcs
   ${protobuf_SOURCE_DIR}/src/google/protobuf/repeated_field.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/repeated_ptr_field.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/service.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/string_intern_pool.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/stubs/common.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/text_format.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/unknown_field_set.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/any_field_extractor.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/column_transcoder.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/compression_dictionary.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/util/delimited_message_util.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/util/field_comparator.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/util/field_mask_util.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/flat_message.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/frozen_message.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/incremental_parser.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/journal_stream.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/merge_reparse.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/message_delta.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/util/message_differencer.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/mini_descriptor.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/parallel_delimited_reader.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/parallel_serialization.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/repeated_bool_util.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/shared_message.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/util/time_util.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/util/type_resolver_util.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/wire_stats.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/wire_format.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/wire_format_lite.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/wire_format_validate.cc
 )
 
 # @//pkg:protobuf
@@ -106,12 +128,18 @@ set(libprotobuf_hdrs
   ${protobuf_SOURCE_DIR}/src/google/protobuf/arena_align.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/arena_allocation_policy.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/arena_cleanup.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/arena_memory_resource.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/arena_size_hint.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/arena_string_piece.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/arena_telemetry.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/arenastring.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/arenaz_sampler.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/codecz_sampler.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/compiler/importer.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/compiler/parser.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/cpp_edition_defaults.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/cpp_features.pb.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/cpu_features.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/descriptor.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/descriptor.pb.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/descriptor_database.h
@@ -123,11 +151,13 @@ set(libprotobuf_hdrs
   ${protobuf_SOURCE_DIR}/src/google/protobuf/explicitly_constructed.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/extension_set.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/extension_set_inl.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/fast_debug_string.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/feature_resolver.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/field_access_listener.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/generated_enum_reflection.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/generated_enum_util.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/generated_message_bases.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/generated_message_fixed_shape.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/generated_message_reflection.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/generated_message_tctable_decl.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/generated_message_tctable_gen.h
@@ -166,6 +196,7 @@ set(libprotobuf_hdrs
   ${protobuf_SOURCE_DIR}/src/google/protobuf/map_type_handler.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/message.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/message_lite.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/message_pool.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/metadata.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/metadata_lite.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/parse_context.h
@@ -185,6 +216,7 @@ set(libprotobuf_hdrs
   ${protobuf_SOURCE_DIR}/src/google/protobuf/serial_arena.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/service.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/string_block.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/string_intern_pool.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/stubs/callback.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/stubs/common.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/stubs/platform_macros.h
@@ -193,17 +225,34 @@ set(libprotobuf_hdrs
   ${protobuf_SOURCE_DIR}/src/google/protobuf/text_format.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/thread_safe_arena.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/unknown_field_set.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/any_field_extractor.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/cached_any_unpacker.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/column_transcoder.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/compression_dictionary.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/util/delimited_message_util.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/util/field_comparator.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/util/field_mask_util.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/flat_message.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/frozen_message.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/incremental_parser.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/journal_stream.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/util/json_util.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/merge_reparse.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/message_delta.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/util/message_differencer.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/mini_descriptor.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/parallel_delimited_reader.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/parallel_serialization.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/repeated_bool_util.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/shared_message.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/util/time_util.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/util/type_resolver.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/util/type_resolver_util.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/wire_stats.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/varint_shuffle.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/wire_format.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/wire_format_lite.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/wire_format_validate.h
 )
 
 # @//pkg:protobuf_lite
@@ -211,8 +260,11 @@ set(libprotobuf_lite_srcs
   ${protobuf_SOURCE_DIR}/src/google/protobuf/any_lite.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/arena.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/arena_align.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/arena_telemetry.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/arenastring.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/arenaz_sampler.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/codecz_sampler.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/cpu_features.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/extension_set.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/generated_enum_util.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/generated_message_tctable_lite.cc
@@ -231,8 +283,10 @@ set(libprotobuf_lite_srcs
   ${protobuf_SOURCE_DIR}/src/google/protobuf/raw_ptr.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/repeated_field.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/repeated_ptr_field.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/string_intern_pool.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/stubs/common.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/wire_format_lite.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/wire_format_validate.cc
 )
 
 # @//pkg:protobuf_lite
@@ -242,14 +296,20 @@ set(libprotobuf_lite_hdrs
   ${protobuf_SOURCE_DIR}/src/google/protobuf/arena_align.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/arena_allocation_policy.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/arena_cleanup.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/arena_memory_resource.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/arena_string_piece.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/arena_telemetry.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/arenastring.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/arenaz_sampler.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/codecz_sampler.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/cpu_features.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/descriptor_lite.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/endian.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/explicitly_constructed.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/extension_set.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/extension_set_inl.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/generated_enum_util.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/generated_message_fixed_shape.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/generated_message_tctable_decl.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/generated_message_tctable_impl.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/generated_message_util.h
@@ -266,6 +326,7 @@ set(libprotobuf_lite_hdrs
   ${protobuf_SOURCE_DIR}/src/google/protobuf/map_field_lite.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/map_type_handler.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/message_lite.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/message_pool.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/metadata_lite.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/parse_context.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/port.h
@@ -277,6 +338,7 @@ set(libprotobuf_lite_hdrs
   ${protobuf_SOURCE_DIR}/src/google/protobuf/runtime_version.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/serial_arena.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/string_block.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/string_intern_pool.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/stubs/callback.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/stubs/common.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/stubs/platform_macros.h
@@ -285,6 +347,7 @@ set(libprotobuf_lite_hdrs
   ${protobuf_SOURCE_DIR}/src/google/protobuf/thread_safe_arena.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/varint_shuffle.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/wire_format_lite.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/wire_format_validate.h
 )
 
 # @//pkg:protoc
@@ -306,6 +369,7 @@ set(libprotoc_srcs
   ${protobuf_SOURCE_DIR}/src/google/protobuf/compiler/cpp/helpers.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/compiler/cpp/ifndef_guard.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/compiler/cpp/message.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/compiler/cpp/micro_generator.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/compiler/cpp/namespace_printer.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/compiler/cpp/padding_optimizer.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/compiler/cpp/parse_function_generator.cc
@@ -425,6 +489,7 @@ set(libprotoc_hdrs
   ${protobuf_SOURCE_DIR}/src/google/protobuf/compiler/cpp/ifndef_guard.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/compiler/cpp/message.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/compiler/cpp/message_layout_helper.h
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/compiler/cpp/micro_generator.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/compiler/cpp/names.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/compiler/cpp/namespace_printer.h
   ${protobuf_SOURCE_DIR}/src/google/protobuf/compiler/cpp/options.h
@@ -984,9 +1049,15 @@ set(upb_test_files
 set(protobuf_test_files
   ${protobuf_SOURCE_DIR}/src/google/protobuf/any_test.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/arena_align_test.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/arena_memory_resource_test.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/arena_size_hint_test.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/arena_string_piece_test.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/arena_unittest.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/arenastring_unittest.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/arenaz_sampler_test.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/codecz_sampler_test.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/cpu_features_test.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/deferred_utf8_validation_test.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/descriptor_database_unittest.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/descriptor_unittest.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/descriptor_visitor_test.cc
@@ -994,15 +1065,19 @@ set(protobuf_test_files
   ${protobuf_SOURCE_DIR}/src/google/protobuf/dynamic_message_unittest.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/edition_message_unittest.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/extension_set_unittest.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/fast_debug_string_test.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/feature_resolver_test.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/generated_enum_util_test.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/generated_message_fixed_shape_unittest.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/generated_message_reflection_unittest.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/generated_message_tctable_lite_test.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/has_bits_test.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/implicit_weak_message_unittest.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/inlined_string_field_unittest.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/internal_message_util_unittest.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/map_field_test.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/map_test.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/message_pool_test.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/message_unittest.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/no_field_presence_test.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/port_test.cc
@@ -1019,6 +1094,7 @@ set(protobuf_test_files
   ${protobuf_SOURCE_DIR}/src/google/protobuf/repeated_field_unittest.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/retention_test.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/string_block_test.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/string_intern_pool_test.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/string_view_test.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/text_format_unittest.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/unknown_field_set_unittest.cc
@@ -1027,6 +1103,7 @@ set(protobuf_test_files
   ${protobuf_SOURCE_DIR}/src/google/protobuf/varint_shuffle_test.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/well_known_types_unittest.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/wire_format_unittest.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/wire_format_validate_test.cc
 )
 
 # @//src/google/protobuf:test_proto_all_srcs
@@ -1104,6 +1181,7 @@ set(compiler_test_files
   ${protobuf_SOURCE_DIR}/src/google/protobuf/compiler/cpp/ifndef_guard_unittest.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/compiler/cpp/message_size_unittest.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/compiler/cpp/metadata_test.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/compiler/cpp/micro_generator_unittest.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/compiler/cpp/move_unittest.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/compiler/cpp/namespace_printer_unittest.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/compiler/cpp/plugin_unittest.cc
@@ -1150,12 +1228,28 @@ set(io_test_files
 
 # @//src/google/protobuf/util:test_srcs
 set(util_test_files
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/any_field_extractor_test.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/cached_any_unpacker_test.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/column_transcoder_test.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/compression_dictionary_test.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/util/delimited_message_util_test.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/util/field_comparator_test.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/util/field_mask_util_test.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/flat_message_test.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/frozen_message_test.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/incremental_parser_test.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/journal_stream_test.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/merge_reparse_test.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/message_delta_test.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/util/message_differencer_unittest.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/mini_descriptor_test.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/parallel_delimited_reader_test.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/parallel_serialization_test.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/repeated_bool_util_test.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/shared_message_test.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/util/time_util_test.cc
   ${protobuf_SOURCE_DIR}/src/google/protobuf/util/type_resolver_util_test.cc
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/util/wire_stats_test.cc
 )
 
 # @//src/google/protobuf/util:test_proto_srcs
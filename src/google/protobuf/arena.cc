@@ -13,6 +13,7 @@
 #include <cstdint>
 #include <limits>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "absl/base/attributes.h"
@@ -20,10 +21,12 @@
 #include "absl/container/internal/layout.h"
 #include "absl/log/absl_check.h"
 #include "absl/log/absl_log.h"
+#include "absl/numeric/bits.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "google/protobuf/arena_allocation_policy.h"
 #include "google/protobuf/arena_cleanup.h"
+#include "google/protobuf/arena_telemetry.h"
 #include "google/protobuf/arenaz_sampler.h"
 #include "google/protobuf/port.h"
 #include "google/protobuf/serial_arena.h"
@@ -60,8 +63,112 @@ ArenaBlock* SentryArenaBlock() {
 }
 #endif
 
+// Process-wide, per-thread cache of standard-sized arena blocks. When enabled
+// via EnableArenaBlockCache(), blocks released by Reset() or arena destruction
+// are kept on a per-thread freelist and handed back to later block
+// allocations instead of round-tripping through the system allocator. Only
+// blocks managed by the default allocator participate; policies with custom
+// block_alloc/block_dealloc hooks bypass the cache entirely.
+std::atomic<size_t> block_cache_max_bytes{0};
+
+#ifndef PROTOBUF_NO_THREADLOCAL
+
+// Freelist node constructed in the first bytes of a cached block. Blocks are
+// at least AllocationPolicy::start_block_size (256) bytes, so there is always
+// room for the node.
+struct CachedBlock {
+  CachedBlock* next;
+  size_t size;
+};
+
+// Buckets hold blocks of size [2^i, 2^(i+1)) for i in
+// [kBlockCacheMinShift, kBlockCacheMaxShift]; sizes outside this range are
+// released to the allocator as usual.
+constexpr size_t kBlockCacheMinShift = 8;   // 256 bytes
+constexpr size_t kBlockCacheMaxShift = 17;  // 128 KiB
+constexpr size_t kBlockCacheNumBuckets =
+    kBlockCacheMaxShift - kBlockCacheMinShift + 1;
+
+struct ThreadBlockCache {
+  CachedBlock* buckets[kBlockCacheNumBuckets] = {};
+  size_t total_bytes = 0;
+
+  ~ThreadBlockCache() {
+    for (CachedBlock*& head : buckets) {
+      while (head != nullptr) {
+        CachedBlock* next = head->next;
+        internal::SizedDelete(head, head->size);
+        head = next;
+      }
+    }
+  }
+};
+
+ThreadBlockCache& thread_block_cache() {
+  static thread_local ThreadBlockCache cache;
+  return cache;
+}
+
+// Pops a cached block of at least `*size` bytes, updating `*size` to the
+// actual block size, or returns nullptr if the cache is disabled or empty.
+void* TryAllocateCachedBlock(size_t* size) {
+  if (block_cache_max_bytes.load(std::memory_order_relaxed) == 0) {
+    return nullptr;
+  }
+  const size_t shift = absl::bit_width(*size - 1);  // ceil(log2(*size))
+  if (shift < kBlockCacheMinShift || shift > kBlockCacheMaxShift) {
+    return nullptr;
+  }
+  ThreadBlockCache& cache = thread_block_cache();
+  CachedBlock*& head = cache.buckets[shift - kBlockCacheMinShift];
+  if (head == nullptr) return nullptr;
+  CachedBlock* block = head;
+  head = block->next;
+  cache.total_bytes -= block->size;
+  *size = block->size;
+  return block;
+}
+
+// Pushes `mem` onto the per-thread freelist. Returns false, leaving `mem`
+// untouched, if the cache is disabled, full, or the size is out of range.
+bool TryCacheBlock(SizedPtr mem) {
+  const size_t max_bytes = block_cache_max_bytes.load(std::memory_order_relaxed);
+  if (max_bytes == 0) return false;
+  if (mem.n < (size_t{1} << kBlockCacheMinShift) ||
+      mem.n > (size_t{1} << kBlockCacheMaxShift)) {
+    return false;
+  }
+  ThreadBlockCache& cache = thread_block_cache();
+  if (cache.total_bytes + mem.n > max_bytes) return false;
+  size_t shift = absl::bit_width(mem.n) - 1;  // floor(log2(mem.n))
+  if (shift > kBlockCacheMaxShift) shift = kBlockCacheMaxShift;
+  CachedBlock* block = static_cast<CachedBlock*>(mem.p);
+  CachedBlock*& head = cache.buckets[shift - kBlockCacheMinShift];
+  block->next = head;
+  block->size = mem.n;
+  head = block;
+  cache.total_bytes += mem.n;
+  return true;
+}
+
+#else  // PROTOBUF_NO_THREADLOCAL
+
+void* TryAllocateCachedBlock(size_t*) { return nullptr; }
+bool TryCacheBlock(SizedPtr) { return false; }
+
+#endif  // PROTOBUF_NO_THREADLOCAL
+
 }  // namespace
 
+void EnableArenaBlockCache(size_t max_bytes_per_thread) {
+  block_cache_max_bytes.store(max_bytes_per_thread,
+                              std::memory_order_relaxed);
+}
+
+void DisableArenaBlockCache() {
+  block_cache_max_bytes.store(0, std::memory_order_relaxed);
+}
+
 static SizedPtr AllocateMemory(const AllocationPolicy* policy_ptr,
                                size_t last_size, size_t min_bytes) {
   AllocationPolicy policy;  // default policy
@@ -79,22 +186,46 @@ static SizedPtr AllocateMemory(const AllocationPolicy* policy_ptr,
                                SerialArena::kBlockHeaderSize);
   size = std::max(size, SerialArena::kBlockHeaderSize + min_bytes);
 
-  if (policy.block_alloc == nullptr) {
-    return AllocateAtLeast(size);
+  if (policy.block_alloc != nullptr) {
+    return {policy.block_alloc(size), size};
+  }
+  if (policy.context_block_alloc != nullptr) {
+    return {policy.context_block_alloc(policy.hook_context, size), size};
+  }
+  if (void* cached = TryAllocateCachedBlock(&size)) {
+    return {cached, size};
   }
-  return {policy.block_alloc(size), size};
+  return AllocateAtLeast(size);
 }
 
 class GetDeallocator {
  public:
   GetDeallocator(const AllocationPolicy* policy, size_t* space_allocated)
       : dealloc_(policy ? policy->block_dealloc : nullptr),
+        context_dealloc_(policy ? policy->context_block_dealloc : nullptr),
+        context_(policy ? policy->hook_context : nullptr),
+        // Only blocks from the default allocator may be recycled; a policy
+        // with a custom block_alloc owns its blocks even if block_dealloc is
+        // unset.
+        cacheable_(policy == nullptr ||
+                   (policy->block_alloc == nullptr &&
+                    policy->block_dealloc == nullptr &&
+                    policy->context_block_alloc == nullptr &&
+                    policy->context_block_dealloc == nullptr)),
         space_allocated_(space_allocated) {}
 
+  // Blocks freed on behalf of a SerialArena owned by another thread are not
+  // recycled into the freeing thread's block cache: by first touch they
+  // likely live on the owner's NUMA node, and recycling them locally would
+  // turn one cross-node teardown into cross-node traffic on every reuse.
+  void set_foreign_owner(bool foreign) { foreign_owner_ = foreign; }
+
   void operator()(SizedPtr mem) const {
     if (dealloc_) {
       dealloc_(mem.p, mem.n);
-    } else {
+    } else if (context_dealloc_) {
+      context_dealloc_(context_, mem.p, mem.n);
+    } else if (!cacheable_ || foreign_owner_ || !TryCacheBlock(mem)) {
       internal::SizedDelete(mem.p, mem.n);
     }
     *space_allocated_ += mem.n;
@@ -102,6 +233,10 @@ class GetDeallocator {
 
  private:
   void (*dealloc_)(void*, size_t);
+  void (*context_dealloc_)(void*, void*, size_t);
+  void* context_;
+  bool cacheable_;
+  bool foreign_owner_ = false;
   size_t* space_allocated_;
 };
 
@@ -139,8 +274,8 @@ std::vector<void*> SerialArena::PeekCleanupListForTesting() {
   if (b->IsSentry()) return res;
 
   const auto peek_list = [&](char* pos, char* end) {
-    for (; pos != end; pos += cleanup::Size()) {
-      cleanup::PeekNode(pos, res);
+    while (pos != end) {
+      pos += cleanup::PeekNode(pos, res);
     }
   };
 
@@ -204,15 +339,22 @@ void* SerialArena::AllocateFromStringBlockFallback() {
     AddSpaceUsed(sb->effective_size());
   }
 
+  size_t first_size = AllocationPolicy::kDefaultStartStringBlockSize;
+  size_t max_size = AllocationPolicy::kDefaultMaxStringBlockSize;
+  if (const AllocationPolicy* policy = parent_.AllocPolicy()) {
+    first_size = policy->start_string_block_size;
+    max_size = policy->max_string_block_size;
+  }
+
   void* ptr;
   StringBlock* new_sb;
-  size_t size = StringBlock::NextSize(sb);
+  size_t size = StringBlock::NextSize(sb, first_size);
   if (MaybeAllocateAligned(size, &ptr)) {
     // Correct space_used_ to avoid double counting
     AddSpaceUsed(-size);
-    new_sb = StringBlock::Emplace(ptr, size, sb);
+    new_sb = StringBlock::Emplace(ptr, size, sb, first_size, max_size);
   } else {
-    new_sb = StringBlock::New(sb);
+    new_sb = StringBlock::New(sb, first_size, max_size);
     AddSpaceAllocated(new_sb->allocated_size());
   }
   string_block_.store(new_sb, std::memory_order_release);
@@ -259,6 +401,7 @@ void SerialArena::AllocateNewBlock(size_t n) {
   // exclusive access to a cacheline. Hence we write it in terms of a
   // regular add.
   AddSpaceAllocated(mem.n);
+  RecordArenaBlockGrowth(mem.n);
   ThreadSafeArenaStats::RecordAllocateStats(parent_.arena_stats_.MutableStats(),
                                             /*used=*/used,
                                             /*allocated=*/mem.n, wasted);
@@ -296,6 +439,20 @@ uint64_t SerialArena::SpaceUsed() const {
   return space_used + space_used_.load(std::memory_order_relaxed);
 }
 
+uint64_t SerialArena::StringBlockSpaceUsed() const {
+  // Subject to the same races as SpaceUsed(): a concurrent allocation can
+  // leave `string_block_unused_` stale relative to the head block.
+  uint64_t space_used = 0;
+  StringBlock* sb = string_block_.load(std::memory_order_acquire);
+  if (sb == nullptr) return space_used;
+  size_t unused = string_block_unused_.load(std::memory_order_relaxed);
+  space_used += sb->effective_size() - unused;
+  for (sb = sb->next(); sb != nullptr; sb = sb->next()) {
+    space_used += sb->effective_size();
+  }
+  return space_used;
+}
+
 size_t SerialArena::FreeStringBlocks(StringBlock* string_block,
                                      size_t unused_bytes) {
   ABSL_DCHECK(string_block != nullptr);
@@ -327,20 +484,22 @@ void SerialArena::CleanupList() {
     char* limit = b->Limit();
     char* it = reinterpret_cast<char*>(b->cleanup_nodes);
     ABSL_DCHECK(!b->IsSentry() || it == limit);
-    // A prefetch distance of 8 here was chosen arbitrarily.
+    // A prefetch distance of 8 here was chosen arbitrarily. Nodes are one or
+    // two slots wide, so the distance is approximate; "prefetching" the
+    // count/stride slot of a run reads a non-pointer value, which is
+    // harmless.
     char* prefetch = it;
     int prefetch_dist = 8;
     for (; prefetch < limit && --prefetch_dist; prefetch += cleanup::Size()) {
       cleanup::PrefetchNode(prefetch);
     }
-    for (; prefetch < limit;
-         it += cleanup::Size(), prefetch += cleanup::Size()) {
-      cleanup::DestroyNode(it);
-      cleanup::PrefetchNode(prefetch);
-    }
     absl::PrefetchToLocalCacheNta(b->next);
-    for (; it < limit; it += cleanup::Size()) {
-      cleanup::DestroyNode(it);
+    while (it < limit) {
+      if (prefetch < limit) {
+        cleanup::PrefetchNode(prefetch);
+        prefetch += cleanup::Size();
+      }
+      it += cleanup::DestroyNode(it);
     }
     b = b->next;
   } while (b);
@@ -708,20 +867,32 @@ ThreadSafeArena::~ThreadSafeArena() {
 SizedPtr ThreadSafeArena::Free(size_t* space_allocated) {
   auto deallocator = GetDeallocator(alloc_policy_.get(), space_allocated);
 
+  // Track how many bytes belong to SerialArenas owned by other threads, to
+  // surface teardowns that ship memory across threads (and, by first touch,
+  // across NUMA nodes) in the arenaz sample.
+  void* const self_id = &thread_cache();
+  uint64_t cross_thread_bytes = 0;
+
   WalkSerialArenaChunk([&](SerialArenaChunk* chunk) {
     absl::Span<std::atomic<SerialArena*>> span = chunk->arenas();
+    absl::Span<const std::atomic<void*>> ids = chunk->ids();
     // Walks arenas backward to handle the first serial arena the last. Freeing
     // in reverse-order to the order in which objects were created may not be
     // necessary to Free and we should revisit this. (b/247560530)
-    for (auto it = span.rbegin(); it != span.rend(); ++it) {
-      SerialArena* serial = it->load(std::memory_order_relaxed);
+    for (size_t i = span.size(); i > 0; --i) {
+      SerialArena* serial = span[i - 1].load(std::memory_order_relaxed);
       ABSL_DCHECK_NE(serial, nullptr);
+      const bool foreign =
+          ids[i - 1].load(std::memory_order_relaxed) != self_id;
+      deallocator.set_foreign_owner(foreign);
+      const size_t freed_before = *space_allocated;
       // Free string blocks
       *space_allocated += serial->FreeStringBlocks();
       // Always frees the first block of "serial" as it cannot be user-provided.
       SizedPtr mem = serial->Free(deallocator);
       ABSL_DCHECK_NE(mem.p, nullptr);
       deallocator(mem);
+      if (foreign) cross_thread_bytes += *space_allocated - freed_before;
     }
 
     // Delete the chunk as we're done with it.
@@ -729,9 +900,22 @@ SizedPtr ThreadSafeArena::Free(size_t* space_allocated) {
                           SerialArenaChunk::AllocSize(chunk->capacity()));
   });
 
+  const bool first_foreign = first_owner_ != self_id;
+  deallocator.set_foreign_owner(first_foreign);
+  const size_t freed_before = *space_allocated;
   // The first block of the first arena is special and let the caller handle it.
   *space_allocated += first_arena_.FreeStringBlocks();
-  return first_arena_.Free(deallocator);
+  // The returned block is not counted: the caller may reuse it (Reset) or
+  // hand it back to the user rather than free it.
+  SizedPtr mem = first_arena_.Free(deallocator);
+  if (first_foreign) {
+    cross_thread_bytes += *space_allocated - freed_before;
+  }
+  if (cross_thread_bytes > 0) {
+    ThreadSafeArenaStats::RecordCrossThreadFree(arena_stats_.MutableStats(),
+                                                cross_thread_bytes);
+  }
+  return mem;
 }
 
 uint64_t ThreadSafeArena::Reset() {
@@ -863,6 +1047,14 @@ uint64_t ThreadSafeArena::SpaceUsed() const {
   return space_used - (alloc_policy_.get() ? sizeof(AllocationPolicy) : 0);
 }
 
+uint64_t ThreadSafeArena::StringBlockSpaceUsed() const {
+  uint64_t space_used = 0;
+  VisitSerialArena([&space_used](const SerialArena* serial) {
+    space_used += serial->StringBlockSpaceUsed();
+  });
+  return space_used;
+}
+
 template <AllocationClient alloc_client>
 PROTOBUF_NOINLINE void* ThreadSafeArena::AllocateAlignedFallback(size_t n) {
   return GetSerialArenaFallback(n)->AllocateAligned<alloc_client>(n);
@@ -897,6 +1089,8 @@ PROTOBUF_NOINLINE
 SerialArena* ThreadSafeArena::GetSerialArenaFallback(size_t n) {
   void* const id = &thread_cache();
   if (id == first_owner_) {
+    ThreadSafeArenaStats::RecordFallbackStats(arena_stats_.MutableStats(),
+                                              /*new_serial_arena=*/false);
     CacheSerialArena(&first_arena_);
     return &first_arena_;
   }
@@ -914,6 +1108,9 @@ SerialArena* ThreadSafeArena::GetSerialArenaFallback(size_t n) {
     }
   });
 
+  ThreadSafeArenaStats::RecordFallbackStats(
+      arena_stats_.MutableStats(), /*new_serial_arena=*/serial == nullptr);
+
   if (!serial) {
     // This thread doesn't have any SerialArena, which also means it doesn't
     // have any blocks yet.  So we'll allocate its first block now. It must be
@@ -930,6 +1127,61 @@ SerialArena* ThreadSafeArena::GetSerialArenaFallback(size_t n) {
 
 }  // namespace internal
 
+namespace {
+
+// Hand-off queue behind Arena::ReleaseForBackgroundDestruction(). The
+// reclaimer thread is started lazily on the first hand-off, is never joined,
+// and drains the queue in batches so a burst of releases takes the lock once
+// per batch rather than once per arena. The queue itself is leaked: the
+// detached thread may still be touching it during process exit.
+struct ArenaReclaimQueue {
+  absl::Mutex mu;
+  std::vector<Arena*> pending;
+};
+
+ArenaReclaimQueue& arena_reclaim_queue() {
+  static auto* queue = new ArenaReclaimQueue();
+  return *queue;
+}
+
+void ArenaReclaimLoop() {
+  ArenaReclaimQueue& queue = arena_reclaim_queue();
+  std::vector<Arena*> batch;
+  for (;;) {
+    {
+      absl::MutexLock lock(&queue.mu);
+      queue.mu.Await(absl::Condition(
+          +[](std::vector<Arena*>* pending) { return !pending->empty(); },
+          &queue.pending));
+      batch.swap(queue.pending);
+    }
+    // Destructors run with the lock dropped; an arena teardown may itself be
+    // slow and must not block further hand-offs.
+    for (Arena* arena : batch) {
+      delete arena;
+    }
+    batch.clear();
+  }
+}
+
+void StartArenaReclaimThreadOnce() {
+  static bool started = [] {
+    std::thread(ArenaReclaimLoop).detach();
+    return true;
+  }();
+  (void)started;
+}
+
+}  // namespace
+
+void Arena::ReleaseForBackgroundDestruction(Arena* arena) {
+  if (arena == nullptr) return;
+  StartArenaReclaimThreadOnce();
+  ArenaReclaimQueue& queue = arena_reclaim_queue();
+  absl::MutexLock lock(&queue.mu);
+  queue.pending.push_back(arena);
+}
+
 void* Arena::Allocate(size_t n) { return impl_.AllocateAligned(n); }
 
 void* Arena::AllocateForArray(size_t n) {
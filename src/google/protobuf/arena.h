@@ -99,6 +99,17 @@ struct ArenaOptions {
   // here.
   size_t max_block_size = internal::AllocationPolicy::kDefaultMaxBlockSize;
 
+  // This defines the size of the first block dedicated to std::string
+  // instances allocated on the arena, and the maximum such blocks grow to.
+  // String blocks hold the (fixed size) string objects themselves; string
+  // character payloads are allocated by std::string on the heap as usual.
+  // Applications allocating many arena strings can raise these to reduce the
+  // number of string block allocations; the effective range is 256B to 32KB.
+  size_t start_string_block_size =
+      internal::AllocationPolicy::kDefaultStartStringBlockSize;
+  size_t max_string_block_size =
+      internal::AllocationPolicy::kDefaultMaxStringBlockSize;
+
   // An initial block of memory for the arena to use, or nullptr for none. If
   // provided, the block must live at least as long as the arena itself. The
   // creator of the Arena retains ownership of the block after the Arena is
@@ -119,13 +130,32 @@ struct ArenaOptions {
   // calls free.
   void (*block_dealloc)(void*, size_t) = nullptr;
 
+  // Context-carrying variants of block_alloc/block_dealloc. The hooks receive
+  // `hook_context` as their first argument, so a single hook implementation
+  // can serve arenas belonging to different owners -- for example, charging
+  // each block to a per-tenant accounting structure with relaxed atomic
+  // counters and inspecting a budget, without wrapping every allocation.
+  // Like block_alloc, context_block_alloc must behave like malloc and must
+  // not return nullptr; enforce budgets by failing the operation that would
+  // create the arena, not the block callback. These hooks are ignored if
+  // block_alloc or block_dealloc is also set, and `hook_context` must outlive
+  // every arena constructed with these options.
+  void* hook_context = nullptr;
+  void* (*context_block_alloc)(void*, size_t) = nullptr;
+  void (*context_block_dealloc)(void*, void*, size_t) = nullptr;
+
  private:
   internal::AllocationPolicy AllocationPolicy() const {
     internal::AllocationPolicy res;
     res.start_block_size = start_block_size;
     res.max_block_size = max_block_size;
+    res.start_string_block_size = start_string_block_size;
+    res.max_string_block_size = max_string_block_size;
     res.block_alloc = block_alloc;
     res.block_dealloc = block_dealloc;
+    res.hook_context = hook_context;
+    res.context_block_alloc = context_block_alloc;
+    res.context_block_dealloc = context_block_dealloc;
     return res;
   }
 
@@ -290,14 +320,77 @@ class PROTOBUF_EXPORT PROTOBUF_ALIGNAS(8) Arena final {
   // can lead to underestimates of the space used, and race conditions can lead
   // to overestimates (up to the current block size).
   uint64_t SpaceUsed() const { return impl_.SpaceUsed(); }
+  // Returns the portion of SpaceUsed() occupied by string blocks (the blocks
+  // holding std::string instances allocated on the arena), for tuning the
+  // string block sizes in ArenaOptions.  Subject to the same best-effort
+  // caveats as SpaceUsed().
+  uint64_t SpaceUsedByStringBlocks() const {
+    return impl_.StringBlockSpaceUsed();
+  }
 
   // Frees all storage allocated by this arena after calling destructors
   // registered with OwnDestructor() and freeing objects registered with Own().
   // Any objects allocated on this arena are unusable after this call. It also
   // returns the total space used by the arena which is the sums of the sizes
   // of the allocated blocks. This method is not thread-safe.
+  //
+  // For messages that are rebuilt once per request, Reset() followed by
+  // re-creating the message on the arena invalidates all previous state in
+  // time proportional to the number of arena blocks, whereas Message::Clear()
+  // walks every set field recursively. For wide, deeply nested messages the
+  // reset-and-recreate pattern is typically much cheaper per request.
   uint64_t Reset() { return impl_.Reset(); }
 
+  // Fuses the lifetime of another arena into this one: `donor` must be
+  // heap-allocated, ownership transfers to this arena, and the donor (along
+  // with every object allocated on it) is destroyed when this arena is reset
+  // or destroyed. Pointers into the donor therefore remain valid for this
+  // arena's lifetime, so messages built on the donor can be stitched into
+  // messages on this arena with the unsafe_arena_set_allocated_* /
+  // UnsafeArenaAddAllocated accessors -- an O(1) pointer splice instead of
+  // the deep copy that the checked setters perform for differing arenas.
+  // After adoption the donor may still be allocated from, but it must not be
+  // reset, destroyed, or adopted again by the caller.
+  void Adopt(Arena* donor) {
+    ABSL_DCHECK_NE(donor, this);
+    Own(donor);
+  }
+
+  // Hands a heap-allocated arena to a process-wide background reclamation
+  // thread and returns immediately. Ownership transfers: the reclaimer runs
+  // the arena's destructor -- cleanup lists and block frees included -- off
+  // the calling thread, so teardown on the request path is O(1) instead of
+  // proportional to what the arena holds. The reclaimer thread is started
+  // lazily on the first call and lives for the remainder of the process.
+  //
+  // The arena must no longer be in use by any thread, and objects allocated
+  // on it are destroyed at an unspecified later point, so their destructors
+  // must not depend on state that ends with the request. Blocks freed on the
+  // reclaimer follow the cross-thread rules of the per-thread block cache
+  // (see EnableArenaBlockCache()): they return to the underlying allocator
+  // rather than being cached on a thread that will never allocate from them.
+  static void ReleaseForBackgroundDestruction(Arena* arena);
+
+  // Swaps the contents of `a` and `b` by pointer exchange even when they
+  // live on different arenas, where Swap() would fall back to a deep copy.
+  // This is an O(1) operation regardless of message size.
+  //
+  // Requirements: both messages must live on (non-null) arenas, and the
+  // caller guarantees that both arenas outlive all accesses to both
+  // messages -- typically because the arenas share a lifetime, e.g. after
+  // Adopt().  After the swap, sub-objects reachable from `a` are owned by
+  // `b`'s arena and vice versa; destroying one arena before the other
+  // leaves the surviving message dangling.
+  template <typename T>
+  static void UnsafeCrossArenaSwap(T* a, T* b) {
+    static_assert(is_arena_constructable<T>::value,
+                  "UnsafeCrossArenaSwap requires an arena-constructable type");
+    ABSL_DCHECK(a->GetArena() != nullptr);
+    ABSL_DCHECK(b->GetArena() != nullptr);
+    if (a == b) return;
+    InternalHelper<T>::InternalSwap(a, b);
+  }
+
   // Adds |object| to a list of heap-allocated objects to be freed with |delete|
   // when the arena is destroyed or reset.
   template <typename T>
@@ -23,17 +23,31 @@ namespace internal {
 struct AllocationPolicy {
   static constexpr size_t kDefaultStartBlockSize = 256;
   static constexpr size_t kDefaultMaxBlockSize = 32 << 10;
+  static constexpr size_t kDefaultStartStringBlockSize = 256;
+  static constexpr size_t kDefaultMaxStringBlockSize = 8 << 10;
 
   size_t start_block_size = kDefaultStartBlockSize;
   size_t max_block_size = kDefaultMaxBlockSize;
+  size_t start_string_block_size = kDefaultStartStringBlockSize;
+  size_t max_string_block_size = kDefaultMaxStringBlockSize;
 
   void* (*block_alloc)(size_t) = nullptr;
   void (*block_dealloc)(void*, size_t) = nullptr;
 
+  // Context-carrying variants of the block hooks; `hook_context` is passed
+  // through verbatim so one hook implementation can serve many arenas with
+  // per-arena attribution.  Ignored when block_alloc/block_dealloc are set.
+  void* hook_context = nullptr;
+  void* (*context_block_alloc)(void*, size_t) = nullptr;
+  void (*context_block_dealloc)(void*, void*, size_t) = nullptr;
+
   bool IsDefault() const {
     return start_block_size == kDefaultStartBlockSize &&
-           max_block_size == kDefaultMaxBlockSize && block_alloc == nullptr &&
-           block_dealloc == nullptr;
+           max_block_size == kDefaultMaxBlockSize &&
+           start_string_block_size == kDefaultStartStringBlockSize &&
+           max_string_block_size == kDefaultMaxStringBlockSize &&
+           block_alloc == nullptr && block_dealloc == nullptr &&
+           context_block_alloc == nullptr && context_block_dealloc == nullptr;
   }
 };
 
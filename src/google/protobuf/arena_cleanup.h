@@ -9,6 +9,7 @@
 #define GOOGLE_PROTOBUF_ARENA_CLEANUP_H__
 
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <vector>
 
@@ -37,6 +38,21 @@ struct CleanupNode {
   void (*destructor)(void*);
 };
 
+// Adjacent same-type objects are coalesced into a "run" covering `count`
+// objects laid out `stride` bytes apart. A run occupies two node slots: the
+// head slot (at the lower address, i.e. walked first) is a CleanupNode whose
+// `elem` has kRunTag set and points at the first object of the run, followed
+// by a RunExtent slot holding the count and stride. The tag bit is available
+// because `elem` is at least 4 byte aligned.
+constexpr uintptr_t kRunTag = 1;
+
+struct RunExtent {
+  uintptr_t count;
+  uintptr_t stride;
+};
+static_assert(sizeof(RunExtent) == sizeof(CleanupNode),
+              "RunExtent must occupy exactly one node slot");
+
 inline ABSL_ATTRIBUTE_ALWAYS_INLINE CleanupNode* ToCleanup(void* pos) {
   return reinterpret_cast<CleanupNode*>(pos);
 }
@@ -48,6 +64,35 @@ inline ABSL_ATTRIBUTE_ALWAYS_INLINE void CreateNode(void* pos, void* elem,
   memcpy(pos, &n, sizeof(n));
 }
 
+// Returns true if the node at `pos` is the head of a run.
+inline ABSL_ATTRIBUTE_ALWAYS_INLINE bool IsRunNode(void* pos) {
+  return (reinterpret_cast<uintptr_t>(ToCleanup(pos)->elem) & kRunTag) != 0;
+}
+
+// Converts the plain node at `pos + Size()` into a run of two objects by
+// writing a tagged head node at `pos` and turning the old slot into the
+// RunExtent. The caller has already reserved the slot at `pos`.
+inline ABSL_ATTRIBUTE_ALWAYS_INLINE void ConvertToRun(void* pos,
+                                                      size_t stride) {
+  char* old_pos = static_cast<char*>(pos) + sizeof(CleanupNode);
+  CleanupNode old_node;
+  memcpy(&old_node, old_pos, sizeof(old_node));
+  CleanupNode head = {
+      reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(old_node.elem) |
+                              kRunTag),
+      old_node.destructor};
+  memcpy(pos, &head, sizeof(head));
+  RunExtent extent = {2, stride};
+  memcpy(old_pos, &extent, sizeof(extent));
+}
+
+// Extends the run headed at `pos` by one object.
+inline ABSL_ATTRIBUTE_ALWAYS_INLINE void ExtendRun(void* pos) {
+  RunExtent* extent =
+      reinterpret_cast<RunExtent*>(static_cast<char*>(pos) + sizeof(CleanupNode));
+  ++extent->count;
+}
+
 // Optimization: performs a prefetch on the elem for the cleanup node at `pos`.
 inline ABSL_ATTRIBUTE_ALWAYS_INLINE void PrefetchNode(void* pos) {
   // We explicitly use NTA prefetch here to avoid polluting remote caches: we
@@ -56,15 +101,44 @@ inline ABSL_ATTRIBUTE_ALWAYS_INLINE void PrefetchNode(void* pos) {
   absl::PrefetchToLocalCacheNta(ToCleanup(pos)->elem);
 }
 
-// Destroys the object referenced by the cleanup node.
-inline ABSL_ATTRIBUTE_ALWAYS_INLINE void DestroyNode(void* pos) {
+// Destroys the object(s) referenced by the node at `pos` and returns the
+// node's size in bytes. Runs are destroyed newest object first, matching the
+// destruction order of individually registered nodes.
+inline ABSL_ATTRIBUTE_ALWAYS_INLINE size_t DestroyNode(void* pos) {
   CleanupNode* cleanup = ToCleanup(pos);
-  cleanup->destructor(cleanup->elem);
+  uintptr_t elem = reinterpret_cast<uintptr_t>(cleanup->elem);
+  if (PROTOBUF_PREDICT_TRUE((elem & kRunTag) == 0)) {
+    cleanup->destructor(cleanup->elem);
+    return sizeof(CleanupNode);
+  }
+  RunExtent extent;
+  memcpy(&extent, static_cast<char*>(pos) + sizeof(CleanupNode),
+         sizeof(extent));
+  char* first = reinterpret_cast<char*>(elem & ~kRunTag);
+  char* it = first + extent.stride * (extent.count - 1);
+  for (;; it -= extent.stride) {
+    cleanup->destructor(it);
+    if (it == first) break;
+  }
+  return sizeof(CleanupNode) + sizeof(RunExtent);
 }
 
-// Append in `out` the pointer to the to-be-cleaned object in `pos`.
-inline void PeekNode(void* pos, std::vector<void*>& out) {
-  out.push_back(ToCleanup(pos)->elem);
+// Append in `out` the pointer(s) to the to-be-cleaned object(s) in `pos`, and
+// returns the node's size in bytes.
+inline size_t PeekNode(void* pos, std::vector<void*>& out) {
+  uintptr_t elem = reinterpret_cast<uintptr_t>(ToCleanup(pos)->elem);
+  if ((elem & kRunTag) == 0) {
+    out.push_back(ToCleanup(pos)->elem);
+    return sizeof(CleanupNode);
+  }
+  RunExtent extent;
+  memcpy(&extent, static_cast<char*>(pos) + sizeof(CleanupNode),
+         sizeof(extent));
+  char* first = reinterpret_cast<char*>(elem & ~kRunTag);
+  for (uintptr_t i = extent.count; i > 0; --i) {
+    out.push_back(first + extent.stride * (i - 1));
+  }
+  return sizeof(CleanupNode) + sizeof(RunExtent);
 }
 
 // Returns the required size for a cleanup node.
@@ -0,0 +1,99 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+// This file defines an adapter that lets std::pmr containers draw their
+// memory from a protobuf Arena, so one bump allocator can serve both a
+// message tree and adjacent pmr data structures built per request.
+//
+// std::pmr is a C++17 library feature; this header only provides the
+// adapter when <memory_resource> is available. Test
+// GOOGLE_PROTOBUF_HAS_ARENA_MEMORY_RESOURCE before use.
+
+#ifndef GOOGLE_PROTOBUF_ARENA_MEMORY_RESOURCE_H__
+#define GOOGLE_PROTOBUF_ARENA_MEMORY_RESOURCE_H__
+
+#if defined(__has_include)
+#if __has_include(<memory_resource>) && \
+    ((defined(_MSVC_LANG) && _MSVC_LANG >= 201703L) || \
+     __cplusplus >= 201703L)
+#define GOOGLE_PROTOBUF_HAS_ARENA_MEMORY_RESOURCE 1
+#endif
+#endif
+
+#ifdef GOOGLE_PROTOBUF_HAS_ARENA_MEMORY_RESOURCE
+
+#include <cstddef>
+#include <memory_resource>
+
+#include "absl/log/absl_check.h"
+#include "google/protobuf/arena.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+
+// An std::pmr::memory_resource backed by Arena::AllocateAligned().
+//
+// Like std::pmr::monotonic_buffer_resource, deallocation is a no-op:
+// individual blocks are reclaimed only when the arena is reset or
+// destroyed. This is the right trade for request-scoped containers whose
+// lifetime matches the arena's, and it is what makes the bump allocation
+// cheap. Do not hand this resource to containers that churn through much
+// more memory than they hold at once.
+//
+// The resource must not outlive its arena, and the elements of any
+// container using it must not either. Allocation through the resource is
+// thread-safe exactly as Arena allocation is.
+//
+// Example:
+//   Arena arena;
+//   ArenaMemoryResource resource(&arena);
+//   std::pmr::vector<std::pmr::string> names(&resource);
+class ArenaMemoryResource final : public std::pmr::memory_resource {
+ public:
+  explicit ArenaMemoryResource(Arena* arena) : arena_(arena) {
+    ABSL_DCHECK(arena != nullptr);
+  }
+  ArenaMemoryResource(const ArenaMemoryResource&) = delete;
+  ArenaMemoryResource& operator=(const ArenaMemoryResource&) = delete;
+
+  Arena* arena() const { return arena_; }
+
+ private:
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    return arena_->AllocateAligned(bytes, alignment);
+  }
+
+  // Memory is reclaimed when the arena is reset or destroyed.
+  void do_deallocate(void* /*p*/, size_t /*bytes*/,
+                     size_t /*alignment*/) override {}
+
+  bool do_is_equal(
+      const std::pmr::memory_resource& other) const noexcept override {
+#if PROTOBUF_RTTI
+    // Deallocation is a no-op, so any resource over the same arena can
+    // release memory allocated here.
+    const auto* rhs = dynamic_cast<const ArenaMemoryResource*>(&other);
+    return rhs != nullptr && rhs->arena_ == arena_;
+#else
+    return this == &other;
+#endif
+  }
+
+  Arena* const arena_;
+};
+
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_HAS_ARENA_MEMORY_RESOURCE
+
+#endif  // GOOGLE_PROTOBUF_ARENA_MEMORY_RESOURCE_H__
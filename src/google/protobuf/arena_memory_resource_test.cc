@@ -0,0 +1,82 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/arena_memory_resource.h"
+
+#ifdef GOOGLE_PROTOBUF_HAS_ARENA_MEMORY_RESOURCE
+
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+
+#include <gtest/gtest.h>
+#include "google/protobuf/arena.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace {
+
+TEST(ArenaMemoryResourceTest, PmrContainersDrawFromArena) {
+  Arena arena;
+  ArenaMemoryResource resource(&arena);
+  const uint64_t baseline = arena.SpaceUsed();
+
+  std::pmr::vector<std::pmr::string> names(&resource);
+  for (int i = 0; i < 100; ++i) {
+    names.emplace_back("a string long enough to defeat any SSO buffer");
+  }
+
+  ASSERT_EQ(names.size(), 100u);
+  EXPECT_EQ(names.front(), "a string long enough to defeat any SSO buffer");
+  EXPECT_GT(arena.SpaceUsed(), baseline);
+}
+
+TEST(ArenaMemoryResourceTest, RespectsAlignment) {
+  Arena arena;
+  ArenaMemoryResource resource(&arena);
+
+  for (size_t align : {size_t{8}, size_t{16}, size_t{64}, size_t{128}}) {
+    void* p = resource.allocate(1, align);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % align, 0u)
+        << "alignment " << align;
+  }
+}
+
+TEST(ArenaMemoryResourceTest, DeallocateIsANoOp) {
+  Arena arena;
+  ArenaMemoryResource resource(&arena);
+
+  void* p = resource.allocate(64, 8);
+  const uint64_t used = arena.SpaceUsed();
+  resource.deallocate(p, 64, 8);
+  EXPECT_EQ(arena.SpaceUsed(), used);
+}
+
+#if PROTOBUF_RTTI
+TEST(ArenaMemoryResourceTest, ResourcesOverSameArenaCompareEqual) {
+  Arena arena1;
+  Arena arena2;
+  ArenaMemoryResource a(&arena1);
+  ArenaMemoryResource b(&arena1);
+  ArenaMemoryResource c(&arena2);
+
+  EXPECT_TRUE(a.is_equal(b));
+  EXPECT_FALSE(a.is_equal(c));
+  EXPECT_FALSE(a.is_equal(*std::pmr::new_delete_resource()));
+}
+#endif  // PROTOBUF_RTTI
+
+}  // namespace
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_HAS_ARENA_MEMORY_RESOURCE
@@ -0,0 +1,87 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2024 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/arena_size_hint.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace {
+
+// How slowly the estimate decays toward smaller observations.  Growth is
+// immediate, so after a burst of large parses roughly 1/kDecayShift of the
+// gap to the smaller steady state closes per observation.
+constexpr int kDecayShift = 4;
+
+struct TypeEstimate {
+  std::atomic<uint64_t> estimate{0};
+};
+
+class SizeHintRegistry {
+ public:
+  TypeEstimate& ForType(const Descriptor* type) {
+    absl::MutexLock lock(&mutex_);
+    auto& entry = estimates_[type];
+    if (entry == nullptr) entry = std::make_unique<TypeEstimate>();
+    return *entry;
+  }
+
+  TypeEstimate* FindType(const Descriptor* type) {
+    absl::MutexLock lock(&mutex_);
+    auto it = estimates_.find(type);
+    return it == estimates_.end() ? nullptr : it->second.get();
+  }
+
+  static SizeHintRegistry& Get() {
+    static auto* registry = new SizeHintRegistry();
+    return *registry;
+  }
+
+ private:
+  absl::Mutex mutex_;
+  absl::flat_hash_map<const Descriptor*, std::unique_ptr<TypeEstimate>>
+      estimates_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace
+
+size_t ArenaSizeHint::For(const Descriptor* type) {
+  TypeEstimate* entry = SizeHintRegistry::Get().FindType(type);
+  if (entry == nullptr) return 0;
+  return static_cast<size_t>(entry->estimate.load(std::memory_order_relaxed));
+}
+
+void ArenaSizeHint::Record(const Descriptor* type, uint64_t space_allocated) {
+  TypeEstimate& entry = SizeHintRegistry::Get().ForType(type);
+  uint64_t current = entry.estimate.load(std::memory_order_relaxed);
+  uint64_t next;
+  do {
+    if (space_allocated >= current) {
+      // Grow immediately: a first block sized below a recent parse would
+      // force block-chain growth on the next one.
+      next = space_allocated;
+    } else {
+      next = current - ((current - space_allocated) >> kDecayShift);
+    }
+  } while (!entry.estimate.compare_exchange_weak(current, next,
+                                                 std::memory_order_relaxed));
+}
+
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
@@ -0,0 +1,61 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2024 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef GOOGLE_PROTOBUF_ARENA_SIZE_HINT_H__
+#define GOOGLE_PROTOBUF_ARENA_SIZE_HINT_H__
+
+#include <cstddef>
+#include <cstdint>
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+
+class Descriptor;
+
+// Adaptive first-block sizing for arenas that hold one message type.
+//
+// A fixed ArenaOptions::start_block_size is always wrong for workloads that
+// mix small and large payloads of the same type: either the first block is
+// oversized for the common case, or large parses grow a chain of blocks.
+// This keeps a moving per-type estimate of arena consumption, fed by
+// callers after each parse, so the next arena's first block can be sized to
+// fit the whole parse most of the time:
+//
+//   ArenaOptions options;
+//   options.start_block_size = ArenaSizeHint::For(MyMessage::descriptor());
+//   Arena arena(options);
+//   ... parse into the arena ...
+//   ArenaSizeHint::Record(MyMessage::descriptor(), arena.SpaceAllocated());
+//
+// The estimate adapts upward immediately and decays downward slowly, so it
+// tracks near the high end of recent observations rather than the mean.
+// All methods are thread-safe.
+class PROTOBUF_EXPORT ArenaSizeHint {
+ public:
+  ArenaSizeHint() = delete;
+
+  // Returns the current estimate, in bytes, of the arena space a message of
+  // `type` needs, or 0 if nothing has been recorded for it yet.  The value
+  // is suitable for ArenaOptions::start_block_size, which clamps it to the
+  // arena's supported block size range.
+  static size_t For(const Descriptor* type);
+
+  // Records that an arena holding a message of `type` ended up allocating
+  // `space_allocated` bytes (typically arena.SpaceAllocated() after the
+  // parse finished).
+  static void Record(const Descriptor* type, uint64_t space_allocated);
+};
+
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_ARENA_SIZE_HINT_H__
@@ -0,0 +1,66 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2024 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/arena_size_hint.h"
+
+#include <cstdint>
+
+#include <gtest/gtest.h>
+#include "google/protobuf/arena.h"
+#include "google/protobuf/test_util.h"
+#include "google/protobuf/unittest.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace {
+
+TEST(ArenaSizeHintTest, GrowsImmediatelyAndDecaysSlowly) {
+  const Descriptor* type = unittest::TestAllTypes::descriptor();
+  EXPECT_EQ(0, ArenaSizeHint::For(type));
+
+  ArenaSizeHint::Record(type, 1024);
+  EXPECT_EQ(1024, ArenaSizeHint::For(type));
+
+  // Larger observations take effect immediately...
+  ArenaSizeHint::Record(type, 4096);
+  EXPECT_EQ(4096, ArenaSizeHint::For(type));
+
+  // ...while smaller ones only pull the estimate down gradually, so the
+  // hint stays near the high end of recent parses.
+  ArenaSizeHint::Record(type, 1024);
+  const size_t decayed = ArenaSizeHint::For(type);
+  EXPECT_LT(decayed, 4096);
+  EXPECT_GT(decayed, 1024);
+}
+
+TEST(ArenaSizeHintTest, HintSizesFirstBlockToFitParse) {
+  const Descriptor* type = unittest::TestPackedTypes::descriptor();
+  ASSERT_EQ(0, ArenaSizeHint::For(type));
+
+  {
+    Arena arena;
+    auto* message = Arena::Create<unittest::TestPackedTypes>(&arena);
+    TestUtil::SetPackedFields(message);
+    ArenaSizeHint::Record(type, arena.SpaceAllocated());
+  }
+
+  const size_t hint = ArenaSizeHint::For(type);
+  ASSERT_GT(hint, 0);
+
+  // An arena whose first block is sized from the hint holds the same
+  // workload without growing past that block.
+  ArenaOptions options;
+  options.start_block_size = hint;
+  Arena arena(options);
+  auto* message = Arena::Create<unittest::TestPackedTypes>(&arena);
+  TestUtil::SetPackedFields(message);
+  EXPECT_LE(arena.SpaceUsed(), hint);
+}
+
+}  // namespace
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,108 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+//
+// This file defines the internal ArenaStringPiece class
+
+#ifndef GOOGLE_PROTOBUF_ARENA_STRING_PIECE_H__
+#define GOOGLE_PROTOBUF_ARENA_STRING_PIECE_H__
+
+#include <cstddef>
+#include <cstring>
+
+#include "absl/strings/string_view.h"
+#include "google/protobuf/arena.h"
+#include "google/protobuf/port.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+
+// Storage for a `ctype = STRING_PIECE` field: an immutable string slice of
+// two words (pointer and size), with the characters owned by the message's
+// arena.  Unlike std::string storage there is no capacity word, no SSO
+// buffer and no heap header per value, so a field costs 16 bytes plus its
+// exact payload; the parser copies the payload into place once via
+// `Mutable()` and the value is then only ever read.
+//
+// Ownership follows the message: on an arena, payloads are arena memory and
+// no cleanup runs; without an arena, payloads are heap allocations and the
+// containing message's destructor must call `Destroy()`.  An overwritten
+// heap payload is freed by the overwriting call, so passing a consistent
+// arena pointer (the message's) to every mutating call is required.
+class ArenaStringPiece {
+ public:
+  constexpr ArenaStringPiece() : data_(nullptr), size_(0) {}
+
+  // Slices share immutable payload storage when copied.
+  ArenaStringPiece(const ArenaStringPiece&) = default;
+  ArenaStringPiece& operator=(const ArenaStringPiece&) = default;
+
+  absl::string_view Get() const { return absl::string_view(data_, size_); }
+
+  // Copies `value` into storage drawn from `arena`, or from the heap when
+  // `arena` is null.  `value` may alias the current payload.
+  void Set(absl::string_view value, Arena* arena) {
+    char* buffer = arena != nullptr
+                       ? Arena::CreateArray<char>(arena, value.size())
+                       : new char[value.size()];
+    if (!value.empty()) memcpy(buffer, value.data(), value.size());
+    MaybeDeleteHeapPayload(arena);
+    data_ = buffer;
+    size_ = value.size();
+  }
+
+  // Points the slice at a fresh uninitialized buffer of `size` bytes and
+  // returns it; the caller fills all `size` bytes.  This is the parse path:
+  // the wire payload is copied straight into final storage.
+  char* Mutable(size_t size, Arena* arena) {
+    char* buffer = arena != nullptr ? Arena::CreateArray<char>(arena, size)
+                                    : new char[size];
+    MaybeDeleteHeapPayload(arena);
+    data_ = buffer;
+    size_ = size;
+    return buffer;
+  }
+
+  void Clear(Arena* arena) {
+    MaybeDeleteHeapPayload(arena);
+    data_ = nullptr;
+    size_ = 0;
+  }
+
+  // Frees the heap payload; called from the destructor of a message that is
+  // not on an arena.  Must not be called for arena-backed slices (their
+  // containing message's destructor does not run).
+  void Destroy() {
+    delete[] data_;
+    data_ = nullptr;
+    size_ = 0;
+  }
+
+  size_t SpaceUsedExcludingSelfLong() const { return size_; }
+
+ private:
+  void MaybeDeleteHeapPayload(Arena* arena) {
+    if (arena == nullptr) delete[] data_;
+  }
+
+  const char* data_;
+  size_t size_;
+};
+
+static_assert(sizeof(ArenaStringPiece) == 2 * sizeof(void*),
+              "ArenaStringPiece must be a bare pointer/size pair");
+
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_ARENA_STRING_PIECE_H__
@@ -0,0 +1,94 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/arena_string_piece.h"
+
+#include <cstring>
+#include <string>
+
+#include <gtest/gtest.h>
+#include "absl/strings/string_view.h"
+#include "google/protobuf/arena.h"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+namespace {
+
+TEST(ArenaStringPieceTest, DefaultIsEmpty) {
+  ArenaStringPiece piece;
+  EXPECT_EQ("", piece.Get());
+  EXPECT_EQ(0, piece.SpaceUsedExcludingSelfLong());
+}
+
+TEST(ArenaStringPieceTest, SetCopiesOntoArena) {
+  Arena arena;
+  ArenaStringPiece piece;
+  std::string source = "hello world";
+  piece.Set(source, &arena);
+
+  // The slice owns an arena copy, not the caller's buffer.
+  source[0] = 'X';
+  EXPECT_EQ("hello world", piece.Get());
+  EXPECT_GE(arena.SpaceUsed(), piece.Get().size());
+}
+
+TEST(ArenaStringPieceTest, SetOnHeapAndDestroy) {
+  ArenaStringPiece piece;
+  piece.Set("payload", nullptr);
+  EXPECT_EQ("payload", piece.Get());
+
+  // Overwriting frees the previous heap payload.
+  piece.Set("replacement", nullptr);
+  EXPECT_EQ("replacement", piece.Get());
+
+  piece.Destroy();
+  EXPECT_EQ("", piece.Get());
+}
+
+TEST(ArenaStringPieceTest, SetMayAliasCurrentPayload) {
+  ArenaStringPiece piece;
+  piece.Set("self alias test", nullptr);
+  piece.Set(piece.Get().substr(5, 5), nullptr);
+  EXPECT_EQ("alias", piece.Get());
+  piece.Destroy();
+}
+
+TEST(ArenaStringPieceTest, MutableFillsInPlace) {
+  Arena arena;
+  ArenaStringPiece piece;
+  constexpr absl::string_view kPayload = "wire payload";
+  char* buffer = piece.Mutable(kPayload.size(), &arena);
+  memcpy(buffer, kPayload.data(), kPayload.size());
+  EXPECT_EQ(kPayload, piece.Get());
+}
+
+TEST(ArenaStringPieceTest, ClearResets) {
+  Arena arena;
+  ArenaStringPiece piece;
+  piece.Set("value", &arena);
+  piece.Clear(&arena);
+  EXPECT_EQ("", piece.Get());
+
+  ArenaStringPiece heap_piece;
+  heap_piece.Set("value", nullptr);
+  heap_piece.Clear(nullptr);
+  EXPECT_EQ("", heap_piece.Get());
+}
+
+TEST(ArenaStringPieceTest, CopiesShareStorage) {
+  Arena arena;
+  ArenaStringPiece piece;
+  piece.Set("shared", &arena);
+  ArenaStringPiece copy = piece;
+  EXPECT_EQ(piece.Get().data(), copy.Get().data());
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
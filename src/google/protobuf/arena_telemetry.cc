@@ -0,0 +1,32 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/arena_telemetry.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+
+#if defined(PROTOBUF_NO_THREADLOCAL) || \
+    (defined(PROTOBUF_USE_DLLS) && defined(_WIN32))
+ArenaTelemetry*& arena_telemetry_slot() {
+  static PROTOBUF_THREAD_LOCAL ArenaTelemetry* slot = nullptr;
+  return slot;
+}
+#else
+PROTOBUF_CONSTINIT PROTOBUF_THREAD_LOCAL ArenaTelemetry*
+    arena_telemetry_slot_ = nullptr;
+#endif
+
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
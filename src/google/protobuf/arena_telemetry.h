@@ -0,0 +1,121 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+// Scoped, thread-local arena allocation telemetry.
+//
+// Performance CI wants to assert "parsing message X allocates exactly K
+// times", but allocation counts are invisible from the outside: SpaceUsed()
+// only reports bytes, and heap profilers attribute arena blocks, not the
+// discrete allocations inside them.  ScopedArenaTelemetry attributes every
+// arena allocation made on the current thread to a caller-owned counter set
+// for the lifetime of the scope:
+//
+//   ArenaTelemetry telemetry;
+//   {
+//     ScopedArenaTelemetry scope(&telemetry);
+//     message->ParseFromString(data);
+//   }
+//   EXPECT_EQ(telemetry.allocations, kExpectedAllocations);
+//
+// When no scope is active the per-allocation cost is one thread-local load
+// and a predicted branch.  Scopes nest; an inner scope shadows the outer
+// one, and counts recorded while the inner scope is active are not
+// propagated outward.
+
+#ifndef GOOGLE_PROTOBUF_ARENA_TELEMETRY_H__
+#define GOOGLE_PROTOBUF_ARENA_TELEMETRY_H__
+
+#include <cstddef>
+#include <cstdint>
+
+#include "google/protobuf/port.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+
+// Counters accumulated while a ScopedArenaTelemetry referencing them is
+// active.  Plain data; reset it by assigning {}.
+struct ArenaTelemetry {
+  // Discrete allocations served by an arena, including those satisfied from
+  // an already-available block.
+  int64_t allocations = 0;
+  // Bytes requested by those allocations, after alignment rounding.
+  int64_t allocated_bytes = 0;
+  // Times an arena had to fetch a new block from the underlying allocator.
+  int64_t block_growths = 0;
+  // Bytes fetched by those block allocations.
+  int64_t block_growth_bytes = 0;
+  // String or bytes payloads copied onto an arena.
+  int64_t string_copies = 0;
+  // Bytes of those payloads.
+  int64_t string_copy_bytes = 0;
+};
+
+namespace internal {
+
+#if defined(PROTOBUF_NO_THREADLOCAL) || \
+    (defined(PROTOBUF_USE_DLLS) && defined(_WIN32))
+// Thread local variables cannot be exposed through MSVC DLL interface (and
+// iOS lacks __thread), so the slot is wrapped in an exported function.
+PROTOBUF_EXPORT ArenaTelemetry*& arena_telemetry_slot();
+#else
+PROTOBUF_EXPORT extern PROTOBUF_THREAD_LOCAL ArenaTelemetry*
+    arena_telemetry_slot_;
+inline ArenaTelemetry*& arena_telemetry_slot() {
+  return arena_telemetry_slot_;
+}
+#endif
+
+inline void RecordArenaAllocation(size_t n) {
+  ArenaTelemetry* telemetry = arena_telemetry_slot();
+  if (PROTOBUF_PREDICT_TRUE(telemetry == nullptr)) return;
+  ++telemetry->allocations;
+  telemetry->allocated_bytes += static_cast<int64_t>(n);
+}
+
+inline void RecordArenaBlockGrowth(size_t n) {
+  ArenaTelemetry* telemetry = arena_telemetry_slot();
+  if (PROTOBUF_PREDICT_TRUE(telemetry == nullptr)) return;
+  ++telemetry->block_growths;
+  telemetry->block_growth_bytes += static_cast<int64_t>(n);
+}
+
+inline void RecordArenaStringCopy(size_t n) {
+  ArenaTelemetry* telemetry = arena_telemetry_slot();
+  if (PROTOBUF_PREDICT_TRUE(telemetry == nullptr)) return;
+  ++telemetry->string_copies;
+  telemetry->string_copy_bytes += static_cast<int64_t>(n);
+}
+
+}  // namespace internal
+
+// Routes arena telemetry on the current thread into `telemetry` for the
+// lifetime of the scope.  Pass nullptr to suspend an enclosing scope.  Must
+// be destroyed on the thread it was created on, in LIFO order.
+class ScopedArenaTelemetry {
+ public:
+  explicit ScopedArenaTelemetry(ArenaTelemetry* telemetry)
+      : previous_(internal::arena_telemetry_slot()) {
+    internal::arena_telemetry_slot() = telemetry;
+  }
+  ScopedArenaTelemetry(const ScopedArenaTelemetry&) = delete;
+  ScopedArenaTelemetry& operator=(const ScopedArenaTelemetry&) = delete;
+  ~ScopedArenaTelemetry() { internal::arena_telemetry_slot() = previous_; }
+
+ private:
+  ArenaTelemetry* const previous_;
+};
+
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_ARENA_TELEMETRY_H__
@@ -31,6 +31,7 @@
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/barrier.h"
 #include "absl/utility/utility.h"
+#include "google/protobuf/arena_telemetry.h"
 #include "google/protobuf/arena_test_util.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/extension_set.h"
@@ -41,6 +42,7 @@
 #include "google/protobuf/port.h"
 #include "google/protobuf/repeated_field.h"
 #include "google/protobuf/test_util.h"
+#include "google/protobuf/thread_safe_arena.h"
 #include "google/protobuf/unittest.pb.h"
 #include "google/protobuf/unittest_arena.pb.h"
 #include "google/protobuf/unknown_field_set.h"
@@ -269,6 +271,59 @@ TEST(ArenaTest, BasicCreate) {
   EXPECT_EQ(2, notifier.GetCount());
 }
 
+// Records the order in which instances are destroyed, so tests can verify
+// that cleanup-run coalescing neither drops destructor calls nor changes the
+// newest-to-oldest destruction order.
+class DtorOrderRecorder {
+ public:
+  void SetTag(std::vector<int>* order, int tag) {
+    order_ = order;
+    tag_ = tag;
+  }
+  ~DtorOrderRecorder() {
+    if (order_ != nullptr) order_->push_back(tag_);
+  }
+
+ private:
+  std::vector<int>* order_ = nullptr;
+  int tag_ = 0;
+};
+
+TEST(ArenaTest, CleanupRunsCoalesceSameTypeObjects) {
+  // Enough objects to span several blocks, so runs are broken and restarted
+  // at block boundaries and the no-new-node extension path is exercised.
+  constexpr int kCount = 1000;
+  std::vector<int> order;
+  {
+    Arena arena;
+    for (int i = 0; i < kCount; ++i) {
+      Arena::Create<DtorOrderRecorder>(&arena)->SetTag(&order, i);
+    }
+  }
+  ASSERT_EQ(order.size(), kCount);
+  for (int i = 0; i < kCount; ++i) {
+    EXPECT_EQ(order[i], kCount - 1 - i);
+  }
+}
+
+TEST(ArenaTest, CleanupRunsWithInterleavedTypes) {
+  // Interleaving other registrations and allocations breaks runs; every
+  // destructor must still be called exactly once.
+  constexpr int kCount = 100;
+  std::vector<int> order;
+  Notifier notifier;
+  {
+    Arena arena;
+    for (int i = 0; i < kCount; ++i) {
+      Arena::Create<DtorOrderRecorder>(&arena)->SetTag(&order, i);
+      Arena::Create<SimpleDataType>(&arena)->SetNotifier(&notifier);
+      Arena::Create<int32_t>(&arena);  // Trivial, registers no cleanup.
+    }
+  }
+  EXPECT_EQ(order.size(), kCount);
+  EXPECT_EQ(notifier.GetCount(), kCount);
+}
+
 TEST(ArenaTest, CreateAndConstCopy) {
   Arena arena;
   const std::string s("foo");
@@ -820,6 +875,27 @@ TEST(ArenaTest, UnsafeArenaSwap) {
   TestUtil::ExpectAllFieldsSet(*message2);
 }
 
+TEST(ArenaTest, UnsafeCrossArenaSwap) {
+  Arena arena1;
+  Arena arena2;
+  TestAllTypes* message1 = Arena::Create<TestAllTypes>(&arena1);
+  TestAllTypes* message2 = Arena::Create<TestAllTypes>(&arena2);
+  TestUtil::SetAllFields(message1);
+
+  // The swap must transfer pointers rather than copying: the nested message
+  // allocated on arena1 stays at the same address, now reachable from
+  // message2.
+  const TestAllTypes::NestedMessage* nested =
+      &message1->optional_nested_message();
+  Arena::UnsafeCrossArenaSwap(message1, message2);
+
+  TestUtil::ExpectAllFieldsSet(*message2);
+  EXPECT_EQ(nested, &message2->optional_nested_message());
+  std::string output;
+  message1->SerializeToString(&output);
+  EXPECT_EQ(0, output.size());
+}
+
 TEST(ArenaTest, SwapBetweenArenasUsingReflection) {
   Arena arena1;
   TestAllTypes* arena1_message = Arena::Create<TestAllTypes>(&arena1);
@@ -1654,6 +1730,72 @@ TEST(ArenaTest, SpaceAllocated_and_Used) {
   EXPECT_EQ(1024, arena_2.Reset());
 }
 
+TEST(ArenaTest, SpaceUsedByStringBlocks) {
+  Arena arena;
+  EXPECT_EQ(0, arena.SpaceUsedByStringBlocks());
+
+  constexpr int kStrings = 100;
+  for (int i = 0; i < kStrings; ++i) {
+    Arena::Create<std::string>(&arena);
+  }
+  // String blocks account exactly one std::string per allocation.
+  EXPECT_EQ(kStrings * sizeof(std::string), arena.SpaceUsedByStringBlocks());
+  EXPECT_LE(arena.SpaceUsedByStringBlocks(), arena.SpaceUsed());
+}
+
+TEST(ArenaTest, StringBlockSizeOptions) {
+  ArenaOptions options;
+  options.start_string_block_size = size_t{4} << 10;
+  options.max_string_block_size = size_t{32} << 10;
+  Arena arena(options);
+
+  // The first string allocation must create a block of the configured start
+  // size rather than the 256 byte default.
+  Arena::Create<std::string>(&arena);
+  EXPECT_GE(arena.SpaceAllocated(), options.start_string_block_size);
+  EXPECT_EQ(sizeof(std::string), arena.SpaceUsedByStringBlocks());
+}
+
+namespace {
+
+// Simulates a per-tenant accounting group: one context struct shared by all
+// of a tenant's arenas, charged at block granularity.
+struct BlockAccounting {
+  std::atomic<size_t> allocated{0};
+  std::atomic<size_t> freed{0};
+};
+
+void* AccountedBlockAlloc(void* context, size_t size) {
+  static_cast<BlockAccounting*>(context)->allocated.fetch_add(
+      size, std::memory_order_relaxed);
+  return ::operator new(size);
+}
+
+void AccountedBlockDealloc(void* context, void* ptr, size_t size) {
+  static_cast<BlockAccounting*>(context)->freed.fetch_add(
+      size, std::memory_order_relaxed);
+  ::operator delete(ptr);
+}
+
+}  // namespace
+
+TEST(ArenaTest, ContextBlockHooks) {
+  BlockAccounting accounting;
+  ArenaOptions options;
+  options.hook_context = &accounting;
+  options.context_block_alloc = AccountedBlockAlloc;
+  options.context_block_dealloc = AccountedBlockDealloc;
+  {
+    Arena arena(options);
+    Arena::CreateArray<char>(&arena, 320);
+    EXPECT_GE(accounting.allocated.load(), size_t{320});
+    EXPECT_EQ(accounting.freed.load(), size_t{0});
+  }
+  // Destruction returns every block through the context hook.
+  EXPECT_GT(accounting.allocated.load(), size_t{0});
+  EXPECT_EQ(accounting.allocated.load(), accounting.freed.load());
+}
+
 namespace {
 
 void VerifyArenaOverhead(Arena& arena, size_t overhead) {
@@ -1750,6 +1892,59 @@ TEST(ArenaTest, AddCleanup) {
   }
 }
 
+TEST(ArenaTest, AdoptKeepsDonorObjectsAlive) {
+  Arena response_arena;
+  Arena* donor = new Arena;
+  auto* nested = Arena::Create<TestAllTypes::NestedMessage>(donor);
+  nested->set_bb(42);
+
+  auto* response = Arena::Create<TestAllTypes>(&response_arena);
+  response_arena.Adopt(donor);
+  // After adoption the donor outlives until response_arena dies, so splicing
+  // with the unsafe accessors is safe and copy-free.
+  response->unsafe_arena_set_allocated_optional_nested_message(nested);
+  EXPECT_EQ(response->optional_nested_message().bb(), 42);
+  EXPECT_EQ(response->mutable_optional_nested_message(), nested);
+}
+
+TEST(ArenaTest, BlockCacheRecyclesBlocksAcrossReset) {
+  internal::EnableArenaBlockCache(/*max_bytes_per_thread=*/1 << 20);
+  Arena arena;
+  Arena::CreateArray<char>(&arena, 1000);
+  const uint64_t allocated = arena.SpaceAllocated();
+  EXPECT_GT(allocated, 0);
+  arena.Reset();
+  // The recycled block is at least as large as the one just released, so the
+  // same allocation must not grow the footprint.
+  Arena::CreateArray<char>(&arena, 1000);
+  EXPECT_LE(arena.SpaceAllocated(), allocated);
+  internal::DisableArenaBlockCache();
+}
+
+TEST(ArenaTest, ReleaseForBackgroundDestructionRunsDestructors) {
+  std::atomic<bool> destroyed{false};
+  struct SetOnDestroy {
+    explicit SetOnDestroy(std::atomic<bool>* flag) : flag(flag) {}
+    ~SetOnDestroy() { flag->store(true); }
+    std::atomic<bool>* flag;
+  };
+
+  Arena* arena = new Arena;
+  Arena::Create<SetOnDestroy>(arena, &destroyed);
+  Arena::Create<TestAllTypes>(arena)->set_optional_string("on the arena");
+  Arena::ReleaseForBackgroundDestruction(arena);
+
+  // The reclaimer thread destroys the arena at some later point; wait for the
+  // cleanup destructor to observe it.
+  while (!destroyed.load()) {
+    std::this_thread::yield();
+  }
+}
+
+TEST(ArenaTest, ReleaseForBackgroundDestructionIgnoresNull) {
+  Arena::ReleaseForBackgroundDestruction(nullptr);
+}
+
 struct DestroyOrderRecorder {
   std::vector<int>* destroy_order;
   int i;
@@ -1805,6 +2000,79 @@ TEST(ArenaTest, SpaceReuseForArraysSizeChecks) {
   }
 }
 
+TEST(ArenaTest, ScopedArenaTelemetryCountsAllocations) {
+  Arena arena;
+  ArenaTelemetry telemetry;
+  {
+    ScopedArenaTelemetry scope(&telemetry);
+    Arena::CreateArray<char>(&arena, 64);
+  }
+  EXPECT_EQ(1, telemetry.allocations);
+  EXPECT_EQ(64, telemetry.allocated_bytes);
+  // The very first allocation forces the arena to fetch its first block.
+  EXPECT_EQ(1, telemetry.block_growths);
+  EXPECT_GT(telemetry.block_growth_bytes, 0);
+
+  // Counting stops with the scope.
+  Arena::CreateArray<char>(&arena, 64);
+  EXPECT_EQ(1, telemetry.allocations);
+}
+
+TEST(ArenaTest, ScopedArenaTelemetryCountsStringCopies) {
+  Arena arena;
+  auto* message = Arena::Create<TestAllTypes>(&arena);
+  ArenaTelemetry telemetry;
+  {
+    ScopedArenaTelemetry scope(&telemetry);
+    message->set_optional_string("a string long enough to be copied");
+  }
+  EXPECT_EQ(1, telemetry.string_copies);
+  EXPECT_EQ(static_cast<int64_t>(
+                absl::string_view("a string long enough to be copied").size()),
+            telemetry.string_copy_bytes);
+}
+
+TEST(ArenaTest, ScopedArenaTelemetryAttributesParses) {
+  TestAllTypes original;
+  original.set_optional_int32(42);
+  original.set_optional_string("payload payload payload payload");
+  original.mutable_optional_nested_message()->set_bb(7);
+  std::string wire;
+  ASSERT_TRUE(original.SerializeToString(&wire));
+
+  Arena arena;
+  auto* parsed = Arena::Create<TestAllTypes>(&arena);
+  ArenaTelemetry telemetry;
+  {
+    ScopedArenaTelemetry scope(&telemetry);
+    ASSERT_TRUE(parsed->ParseFromString(wire));
+  }
+  // The parse had to place the nested message and copy the string onto the
+  // arena.  Exact counts are what perf CI asserts on; here we only pin that
+  // the work is attributed at all.
+  EXPECT_GT(telemetry.allocations, 0);
+  EXPECT_GT(telemetry.allocated_bytes, 0);
+  EXPECT_EQ(1, telemetry.string_copies);
+}
+
+TEST(ArenaTest, ScopedArenaTelemetryNests) {
+  Arena arena;
+  ArenaTelemetry outer_telemetry;
+  ArenaTelemetry inner_telemetry;
+  {
+    ScopedArenaTelemetry outer(&outer_telemetry);
+    Arena::CreateArray<char>(&arena, 8);
+    {
+      // The inner scope shadows the outer one; its counts do not propagate.
+      ScopedArenaTelemetry inner(&inner_telemetry);
+      Arena::CreateArray<char>(&arena, 8);
+    }
+    Arena::CreateArray<char>(&arena, 8);
+  }
+  EXPECT_EQ(2, outer_telemetry.allocations);
+  EXPECT_EQ(1, inner_telemetry.allocations);
+}
+
 TEST(ArenaTest, SpaceReusePoisonsAndUnpoisonsMemory) {
 #ifdef PROTOBUF_ASAN
   char buf[1024]{};
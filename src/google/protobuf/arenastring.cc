@@ -12,6 +12,7 @@
 #include "absl/log/absl_check.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
+#include "google/protobuf/arena_telemetry.h"
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/message_lite.h"
 #include "google/protobuf/parse_context.h"
@@ -83,6 +84,7 @@ inline TaggedStringPtr CreateString(absl::string_view value) {
 
 // Creates an arena allocated std::string value.
 TaggedStringPtr CreateArenaString(Arena& arena, absl::string_view s) {
+  RecordArenaStringCopy(s.length());
   TaggedStringPtr res;
   res.SetMutableArena(Arena::Create<std::string>(&arena, s.data(), s.length()));
   return res;
@@ -271,6 +273,7 @@ const char* EpsCopyInputStream::ReadArenaString(const char* ptr,
 
   int size = ReadSize(&ptr);
   if (!ptr) return nullptr;
+  RecordArenaStringCopy(static_cast<size_t>(size));
 
   auto* str = s->NewString(arena);
   ptr = ReadString(ptr, size, str);
@@ -63,6 +63,9 @@ void ThreadSafeArenaStats::PrepareForSampling(int64_t stride) {
   for (auto& blockstats : block_histogram) blockstats.PrepareForSampling();
   max_block_size.store(0, std::memory_order_relaxed);
   thread_ids.store(0, std::memory_order_relaxed);
+  num_fallbacks.store(0, std::memory_order_relaxed);
+  num_serial_arenas_created.store(0, std::memory_order_relaxed);
+  bytes_freed_cross_thread.store(0, std::memory_order_relaxed);
   weight = stride;
   // The inliner makes hardcoded skip_count difficult (especially when combined
   // with LTO).  We use the ability to exclude stacks by regex when encoding
@@ -112,6 +115,17 @@ void RecordAllocateSlow(ThreadSafeArenaStats* info, size_t used,
   info->thread_ids.fetch_or(tid, std::memory_order_relaxed);
 }
 
+void RecordFallbackSlow(ThreadSafeArenaStats* info, bool new_serial_arena) {
+  info->num_fallbacks.fetch_add(1, std::memory_order_relaxed);
+  if (new_serial_arena) {
+    info->num_serial_arenas_created.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void RecordCrossThreadFreeSlow(ThreadSafeArenaStats* info, size_t bytes) {
+  info->bytes_freed_cross_thread.fetch_add(bytes, std::memory_order_relaxed);
+}
+
 ThreadSafeArenaStats* SampleSlow(SamplingState& sampling_state) {
   bool first = sampling_state.next_sample < 0;
   const int64_t next_stride = g_exponential_biased_generator.GetStride(
@@ -26,6 +26,8 @@ namespace internal {
 struct ThreadSafeArenaStats;
 void RecordAllocateSlow(ThreadSafeArenaStats* info, size_t used,
                         size_t allocated, size_t wasted);
+void RecordFallbackSlow(ThreadSafeArenaStats* info, bool new_serial_arena);
+void RecordCrossThreadFreeSlow(ThreadSafeArenaStats* info, size_t bytes);
 // Stores information about a sampled thread safe arena.  All mutations to this
 // *must* be made through `Record*` functions below.  All reads from this *must*
 // only occur in the callback to `ThreadSafeArenazSampler::Iterate`.
@@ -73,6 +75,22 @@ struct ThreadSafeArenaStats
   // bit mixing for thread-ids; `% 64` would only grab the low bits and might
   // create sampling artifacts.
   std::atomic<uint64_t> thread_ids;
+  // Number of allocations that missed the per-thread SerialArena cache and
+  // went through `ThreadSafeArena::GetSerialArenaFallback`.  A high count
+  // relative to the histogram's total num_allocations means many threads
+  // interleave allocations on this arena, making it a candidate for
+  // splitting.
+  std::atomic<uint64_t> num_fallbacks;
+  // Of those fallbacks, the number that found no SerialArena for the calling
+  // thread and had to create one; this counts the threads that allocated from
+  // the arena beyond the one that created it.
+  std::atomic<uint64_t> num_serial_arenas_created;
+  // Bytes released at teardown or Reset() on behalf of a SerialArena owned by
+  // a different thread than the one doing the freeing. Memory is placed on
+  // the allocating thread's NUMA node by first touch, so on multi-socket
+  // machines this approximates cross-node traffic caused by tearing arenas
+  // down away from the threads that filled them.
+  std::atomic<uint64_t> bytes_freed_cross_thread;
 
   // All of the fields below are set by `PrepareForSampling`, they must not
   // be mutated in `Record*` functions.  They are logically `const` in that
@@ -88,6 +106,17 @@ struct ThreadSafeArenaStats
     RecordAllocateSlow(info, used, allocated, wasted);
   }
 
+  static void RecordFallbackStats(ThreadSafeArenaStats* info,
+                                  bool new_serial_arena) {
+    if (PROTOBUF_PREDICT_TRUE(info == nullptr)) return;
+    RecordFallbackSlow(info, new_serial_arena);
+  }
+
+  static void RecordCrossThreadFree(ThreadSafeArenaStats* info, size_t bytes) {
+    if (PROTOBUF_PREDICT_TRUE(info == nullptr)) return;
+    RecordCrossThreadFreeSlow(info, bytes);
+  }
+
   // Returns the bin for the provided size.
   static size_t FindBin(size_t bytes);
 
@@ -167,6 +196,9 @@ using SamplingState = int64_t;
 struct ThreadSafeArenaStats {
   static void RecordAllocateStats(ThreadSafeArenaStats*, size_t /*requested*/,
                                   size_t /*allocated*/, size_t /*wasted*/) {}
+  static void RecordFallbackStats(ThreadSafeArenaStats*,
+                                  bool /*new_serial_arena*/) {}
+  static void RecordCrossThreadFree(ThreadSafeArenaStats*, size_t /*bytes*/) {}
 };
 
 ThreadSafeArenaStats* SampleSlow(SamplingState& next_sample);
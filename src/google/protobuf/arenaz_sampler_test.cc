@@ -78,6 +78,9 @@ TEST(ThreadSafeArenaStatsTest, PrepareForSampling) {
     EXPECT_EQ(block_stats.bytes_wasted.load(std::memory_order_relaxed), 0);
   }
   EXPECT_EQ(info.max_block_size.load(std::memory_order_relaxed), 0);
+  EXPECT_EQ(info.num_fallbacks.load(std::memory_order_relaxed), 0);
+  EXPECT_EQ(info.num_serial_arenas_created.load(std::memory_order_relaxed), 0);
+  EXPECT_EQ(info.bytes_freed_cross_thread.load(std::memory_order_relaxed), 0);
   EXPECT_EQ(info.weight, kTestStride);
 
   for (auto& block_stats : info.block_histogram) {
@@ -87,6 +90,9 @@ TEST(ThreadSafeArenaStatsTest, PrepareForSampling) {
     block_stats.bytes_wasted.store(1, std::memory_order_relaxed);
   }
   info.max_block_size.store(1, std::memory_order_relaxed);
+  info.num_fallbacks.store(1, std::memory_order_relaxed);
+  info.num_serial_arenas_created.store(1, std::memory_order_relaxed);
+  info.bytes_freed_cross_thread.store(1, std::memory_order_relaxed);
 
   info.PrepareForSampling(2 * kTestStride);
   for (auto& block_stats : info.block_histogram) {
@@ -96,6 +102,9 @@ TEST(ThreadSafeArenaStatsTest, PrepareForSampling) {
     EXPECT_EQ(block_stats.bytes_wasted.load(std::memory_order_relaxed), 0);
   }
   EXPECT_EQ(info.max_block_size.load(std::memory_order_relaxed), 0);
+  EXPECT_EQ(info.num_fallbacks.load(std::memory_order_relaxed), 0);
+  EXPECT_EQ(info.num_serial_arenas_created.load(std::memory_order_relaxed), 0);
+  EXPECT_EQ(info.bytes_freed_cross_thread.load(std::memory_order_relaxed), 0);
   EXPECT_EQ(info.weight, 2 * kTestStride);
 }
 
@@ -167,6 +176,32 @@ TEST(ThreadSafeArenaStatsTest, RecordAllocateSlow) {
   EXPECT_EQ(info.max_block_size.load(std::memory_order_relaxed), 256);
 }
 
+TEST(ThreadSafeArenaStatsTest, RecordFallbackSlow) {
+  ThreadSafeArenaStats info;
+  constexpr int64_t kTestStride = 458;
+  absl::MutexLock l(&info.init_mu);
+  info.PrepareForSampling(kTestStride);
+  RecordFallbackSlow(&info, /*new_serial_arena=*/true);
+  EXPECT_EQ(info.num_fallbacks.load(std::memory_order_relaxed), 1);
+  EXPECT_EQ(info.num_serial_arenas_created.load(std::memory_order_relaxed), 1);
+  RecordFallbackSlow(&info, /*new_serial_arena=*/false);
+  EXPECT_EQ(info.num_fallbacks.load(std::memory_order_relaxed), 2);
+  EXPECT_EQ(info.num_serial_arenas_created.load(std::memory_order_relaxed), 1);
+}
+
+TEST(ThreadSafeArenaStatsTest, RecordCrossThreadFreeSlow) {
+  ThreadSafeArenaStats info;
+  constexpr int64_t kTestStride = 362;
+  absl::MutexLock l(&info.init_mu);
+  info.PrepareForSampling(kTestStride);
+  RecordCrossThreadFreeSlow(&info, 4096);
+  EXPECT_EQ(info.bytes_freed_cross_thread.load(std::memory_order_relaxed),
+            4096);
+  RecordCrossThreadFreeSlow(&info, 1024);
+  EXPECT_EQ(info.bytes_freed_cross_thread.load(std::memory_order_relaxed),
+            5120);
+}
+
 TEST(ThreadSafeArenaStatsTest, RecordAllocateSlowMaxBlockSizeTest) {
   ThreadSafeArenaStats info;
   constexpr int64_t kTestStride = 458;
@@ -478,6 +513,52 @@ TEST(ThreadSafeArenazSamplerTest, MultiThread) {
   SetThreadSafeArenazSampleParameter(oldparam);
 }
 
+class CrossThreadFreeThread : public Thread {
+ protected:
+  void Run() override {
+    // Allocate enough to grow blocks owned by this thread's SerialArena.
+    for (int i = 0; i < 100; ++i) {
+      google::protobuf::ArenaSafeUniquePtr<
+          protobuf_test_messages::proto2::TestAllTypesProto2>
+          message = google::protobuf::MakeArenaSafeUnique<
+              protobuf_test_messages::proto2::TestAllTypesProto2>(arena_);
+      ABSL_CHECK(message != nullptr);
+    }
+  }
+
+ public:
+  CrossThreadFreeThread(const thread::Options& options,
+                        google::protobuf::Arena* arena)
+      : Thread(options, "CrossThreadFreeThread"), arena_(arena) {}
+
+ private:
+  google::protobuf::Arena* arena_;
+};
+
+TEST(ThreadSafeArenazSamplerTest, CrossThreadFree) {
+  SetThreadSafeArenazEnabled(true);
+  int32_t oldparam = ThreadSafeArenazSampleParameter();
+  SetThreadSafeArenazSampleParameter(1);
+  SetThreadSafeArenazGlobalNextSample(0);
+  auto& sampler = GlobalThreadSafeArenazSampler();
+  google::protobuf::Arena arena;
+  thread::Options options;
+  options.set_joinable(true);
+  CrossThreadFreeThread t(options, &arena);
+  t.Start();
+  t.Join();
+  // Resetting here frees the other thread's SerialArena blocks from this
+  // thread, which must show up as cross-thread freed bytes.
+  arena.Reset();
+  uint64_t cross_thread_bytes = 0;
+  sampler.Iterate([&](const ThreadSafeArenaStats& h) {
+    cross_thread_bytes +=
+        h.bytes_freed_cross_thread.load(std::memory_order_relaxed);
+  });
+  EXPECT_GT(cross_thread_bytes, 0);
+  SetThreadSafeArenazSampleParameter(oldparam);
+}
+
 class SampleFirstArenaThread : public Thread {
  protected:
   void Run() override {
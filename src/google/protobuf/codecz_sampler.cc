@@ -0,0 +1,167 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/codecz_sampler.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
+#include "absl/synchronization/mutex.h"
+#include "google/protobuf/message_lite.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+
+std::atomic<bool> codecz_enabled{false};
+
+namespace {
+
+std::atomic<int32_t> codecz_sample_parameter{1024};
+
+#if !defined(PROTOBUF_NO_THREADLOCAL)
+PROTOBUF_THREAD_LOCAL int64_t codecz_next_sample = 0;
+#else
+std::atomic<int64_t> codecz_next_sample{0};
+#endif
+
+// Accumulation slot for one message type.  Entries are created under the
+// registry mutex and never removed, so sampled parses can bump the counters
+// with relaxed atomics and no lock.
+struct CodecStatsEntry {
+  std::string type_name;
+  std::atomic<int64_t> parse_count{0};
+  std::atomic<int64_t> parse_bytes{0};
+  std::atomic<int64_t> parse_nanos{0};
+};
+
+class CodecStatsRegistry {
+ public:
+  CodecStatsEntry* GetOrCreate(const MessageLite& msg,
+                               const TcParseTableBase* table) {
+    {
+      absl::ReaderMutexLock lock(&mu_);
+      auto it = entries_.find(table);
+      if (it != entries_.end()) return it->second.get();
+    }
+    std::string type_name(msg.GetTypeName());
+    absl::MutexLock lock(&mu_);
+    auto& entry = entries_[table];
+    if (entry == nullptr) {
+      entry = std::make_unique<CodecStatsEntry>();
+      entry->type_name = std::move(type_name);
+    }
+    return entry.get();
+  }
+
+  void Iterate(absl::FunctionRef<void(const MessageCodecStats&)> f) {
+    // Snapshot under the lock; invoke the callback outside it so scrapers
+    // cannot block sampled parses registering new types.
+    std::vector<MessageCodecStats> snapshot;
+    {
+      absl::ReaderMutexLock lock(&mu_);
+      snapshot.reserve(entries_.size());
+      for (const auto& kv : entries_) {
+        const CodecStatsEntry& entry = *kv.second;
+        snapshot.push_back(MessageCodecStats{
+            entry.type_name,
+            entry.parse_count.load(std::memory_order_relaxed),
+            entry.parse_bytes.load(std::memory_order_relaxed),
+            entry.parse_nanos.load(std::memory_order_relaxed)});
+      }
+    }
+    for (const MessageCodecStats& stats : snapshot) {
+      f(stats);
+    }
+  }
+
+  void Reset() {
+    absl::MutexLock lock(&mu_);
+    entries_.clear();
+  }
+
+ private:
+  absl::Mutex mu_;
+  absl::flat_hash_map<const TcParseTableBase*,
+                      std::unique_ptr<CodecStatsEntry>>
+      entries_ ABSL_GUARDED_BY(mu_);
+};
+
+CodecStatsRegistry& GlobalRegistry() {
+  static auto* registry = new CodecStatsRegistry();
+  return *registry;
+}
+
+}  // namespace
+
+void SetCodeczEnabled(bool enabled) {
+  codecz_enabled.store(enabled, std::memory_order_release);
+}
+
+bool IsCodeczEnabled() {
+  return codecz_enabled.load(std::memory_order_acquire);
+}
+
+void SetCodeczSampleParameter(int32_t rate) {
+  codecz_sample_parameter.store(rate > 0 ? rate : 1,
+                                std::memory_order_relaxed);
+}
+
+int32_t CodeczSampleParameter() {
+  return codecz_sample_parameter.load(std::memory_order_relaxed);
+}
+
+bool CodeczShouldSampleSlow() {
+#if !defined(PROTOBUF_NO_THREADLOCAL)
+  if (--codecz_next_sample > 0) return false;
+  codecz_next_sample = codecz_sample_parameter.load(std::memory_order_relaxed);
+  return true;
+#else
+  if (codecz_next_sample.fetch_sub(1, std::memory_order_relaxed) > 1) {
+    return false;
+  }
+  codecz_next_sample.store(
+      codecz_sample_parameter.load(std::memory_order_relaxed),
+      std::memory_order_relaxed);
+  return true;
+#endif
+}
+
+void CodeczRecordParse(const MessageLite& msg, const TcParseTableBase* table,
+                       int64_t bytes, int64_t nanos) {
+  CodecStatsEntry* entry = GlobalRegistry().GetOrCreate(msg, table);
+  entry->parse_count.fetch_add(1, std::memory_order_relaxed);
+  entry->parse_bytes.fetch_add(bytes, std::memory_order_relaxed);
+  entry->parse_nanos.fetch_add(nanos, std::memory_order_relaxed);
+}
+
+int64_t CodeczNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void CodeczIterate(absl::FunctionRef<void(const MessageCodecStats&)> f) {
+  GlobalRegistry().Iterate(f);
+}
+
+void CodeczReset() { GlobalRegistry().Reset(); }
+
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
@@ -0,0 +1,93 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef GOOGLE_PROTOBUF_SRC_GOOGLE_PROTOBUF_CODECZ_SAMPLER_H__
+#define GOOGLE_PROTOBUF_SRC_GOOGLE_PROTOBUF_CODECZ_SAMPLER_H__
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "absl/functional/function_ref.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+
+class MessageLite;
+
+namespace internal {
+
+struct TcParseTableBase;
+
+// Per-message-type codec work, aggregated by the global codecz sampler.
+// Companion to the arenaz sampler: where arenaz answers "where does arena
+// memory go", codecz answers "which message types burn parse CPU".
+//
+// Sampling is off by default.  When enabled via SetCodeczEnabled(), roughly
+// one in CodeczSampleParameter() top-level parses pays for a clock read and
+// a hash lookup; all other parses only decrement a thread-local counter.
+// Multiply the recorded values by the sample parameter to estimate totals.
+struct MessageCodecStats {
+  // Fully-qualified message type name.
+  std::string type_name;
+  // Number of sampled top-level parses (ParseFrom*/MergeFrom* entry points;
+  // nested submessages are attributed to their top-level parse).
+  int64_t parse_count;
+  // Wire bytes consumed by sampled parses.
+  int64_t parse_bytes;
+  // Wall time spent in sampled parses.
+  int64_t parse_nanos;
+};
+
+// Enables or disables codec sampling.  Disabling does not discard stats
+// already collected.
+void PROTOBUF_EXPORT SetCodeczEnabled(bool enabled);
+bool PROTOBUF_EXPORT IsCodeczEnabled();
+
+// Sets the sampling rate: one in `rate` parses is recorded.  Default 1024.
+void PROTOBUF_EXPORT SetCodeczSampleParameter(int32_t rate);
+int32_t PROTOBUF_EXPORT CodeczSampleParameter();
+
+// Invokes `f` once per message type with the stats accumulated so far.
+void PROTOBUF_EXPORT CodeczIterate(
+    absl::FunctionRef<void(const MessageCodecStats&)> f);
+
+// Discards all accumulated stats.
+void PROTOBUF_EXPORT CodeczReset();
+
+// Hot-path hook: returns true if this parse should be sampled.  Cheap when
+// sampling is disabled or the countdown has not expired.
+bool PROTOBUF_EXPORT CodeczShouldSampleSlow();
+extern std::atomic<bool> codecz_enabled;
+
+inline bool CodeczShouldSample() {
+  if (PROTOBUF_PREDICT_TRUE(
+          !codecz_enabled.load(std::memory_order_relaxed))) {
+    return false;
+  }
+  return CodeczShouldSampleSlow();
+}
+
+// Records one sampled parse of `msg`.  `table` keys the per-type slot (it is
+// unique and permanent per message type); the type name is resolved on first
+// use.  Called only on the sampled path.
+void PROTOBUF_EXPORT CodeczRecordParse(const MessageLite& msg,
+                                       const TcParseTableBase* table,
+                                       int64_t bytes, int64_t nanos);
+
+// Monotonic clock read for the sampled path.
+int64_t PROTOBUF_EXPORT CodeczNanos();
+
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+#endif  // GOOGLE_PROTOBUF_SRC_GOOGLE_PROTOBUF_CODECZ_SAMPLER_H__
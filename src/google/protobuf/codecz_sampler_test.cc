@@ -0,0 +1,95 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/codecz_sampler.h"
+
+#include <cstdint>
+#include <string>
+
+#include <gtest/gtest.h>
+#include "google/protobuf/test_util.h"
+#include "google/protobuf/unittest.pb.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+namespace {
+
+class CodeczSamplerTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    CodeczReset();
+    SetCodeczSampleParameter(1);  // Sample every parse.
+    SetCodeczEnabled(true);
+  }
+  void TearDown() override {
+    SetCodeczEnabled(false);
+    SetCodeczSampleParameter(1024);
+    CodeczReset();
+  }
+};
+
+TEST_F(CodeczSamplerTest, RecordsPerTypeParseStats) {
+  protobuf_unittest::TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  std::string wire = message.SerializeAsString();
+
+  protobuf_unittest::TestAllTypes parsed;
+  constexpr int kParses = 8;
+  for (int i = 0; i < kParses; ++i) {
+    ASSERT_TRUE(parsed.ParseFromString(wire));
+  }
+
+  bool found = false;
+  CodeczIterate([&](const MessageCodecStats& stats) {
+    if (stats.type_name != "protobuf_unittest.TestAllTypes") return;
+    found = true;
+    EXPECT_EQ(stats.parse_count, kParses);
+    EXPECT_EQ(stats.parse_bytes,
+              kParses * static_cast<int64_t>(wire.size()));
+    EXPECT_GE(stats.parse_nanos, 0);
+  });
+  EXPECT_TRUE(found);
+}
+
+TEST_F(CodeczSamplerTest, DisabledSamplerRecordsNothing) {
+  SetCodeczEnabled(false);
+  CodeczReset();
+
+  protobuf_unittest::TestAllTypes message;
+  message.set_optional_int32(1);
+  std::string wire = message.SerializeAsString();
+  protobuf_unittest::TestAllTypes parsed;
+  ASSERT_TRUE(parsed.ParseFromString(wire));
+
+  int types_seen = 0;
+  CodeczIterate([&](const MessageCodecStats&) { ++types_seen; });
+  EXPECT_EQ(types_seen, 0);
+}
+
+TEST_F(CodeczSamplerTest, ResetDiscardsStats) {
+  protobuf_unittest::TestAllTypes message;
+  message.set_optional_int32(1);
+  std::string wire = message.SerializeAsString();
+  protobuf_unittest::TestAllTypes parsed;
+  ASSERT_TRUE(parsed.ParseFromString(wire));
+
+  CodeczReset();
+  int types_seen = 0;
+  CodeczIterate([&](const MessageCodecStats&) { ++types_seen; });
+  EXPECT_EQ(types_seen, 0);
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
@@ -88,6 +88,9 @@
 #include "google/protobuf/io/printer.h"
 #include "google/protobuf/io/zero_copy_stream_impl.h"
 #include "google/protobuf/text_format.h"
+#include "google/protobuf/util/compression_dictionary.h"
+#include "google/protobuf/util/delimited_message_util.h"
+#include "google/protobuf/util/wire_stats.h"
 
 
 #ifdef _WIN32
@@ -1187,6 +1190,10 @@ int CommandLineInterface::Run(int argc, const char* const argv[]) {
       break;
   }
 
+  if (!batch_manifest_name_.empty()) {
+    return RunBatch(executable_name_, batch_manifest_name_);
+  }
+
   std::vector<const FileDescriptor*> parsed_files;
   std::unique_ptr<DiskSourceTree> disk_source_tree;
   std::unique_ptr<ErrorPrinter> error_collector;
@@ -1411,6 +1418,18 @@ int CommandLineInterface::Run(int argc, const char* const argv[]) {
     }
   }
 
+  if (mode_ == MODE_ANALYZE) {
+    if (!AnalyzeMessage(descriptor_pool.get())) {
+      return 1;
+    }
+  }
+
+  if (mode_ == MODE_TRAIN_DICTIONARY) {
+    if (!TrainCompressionDictionary(descriptor_pool.get())) {
+      return 1;
+    }
+  }
+
   if (error_collector->FoundErrors() ||
       (fatal_warnings_ && error_collector->FoundWarnings())) {
     return 1;
@@ -1438,6 +1457,48 @@ int CommandLineInterface::Run(int argc, const char* const argv[]) {
   return 0;
 }
 
+int CommandLineInterface::RunBatch(std::string executable_name,
+                                   std::string manifest_name) {
+  std::ifstream manifest(manifest_name.c_str());
+  if (!manifest.is_open()) {
+    std::cerr << manifest_name << ": " << strerror(errno) << std::endl;
+    return 1;
+  }
+
+  std::string line;
+  int line_number = 0;
+  while (std::getline(manifest, line)) {
+    ++line_number;
+    // Arguments are whitespace-separated; we don't support any kind of shell
+    // quoting or expansion, same as argument files.
+    std::vector<std::string> arguments =
+        absl::StrSplit(line, absl::ByAnyChar(" \t"), absl::SkipEmpty());
+    if (arguments.empty() || arguments[0][0] == '#') continue;
+
+    std::vector<const char*> argv;
+    argv.reserve(arguments.size() + 1);
+    argv.push_back(executable_name.c_str());
+    for (const std::string& argument : arguments) {
+      if (absl::StartsWith(argument, "--batch_manifest")) {
+        std::cerr << manifest_name << ":" << line_number
+                  << ": --batch_manifest may not be used inside a batch "
+                     "manifest."
+                  << std::endl;
+        return 1;
+      }
+      argv.push_back(argument.c_str());
+    }
+
+    int result = Run(static_cast<int>(argv.size()), argv.data());
+    if (result != 0) {
+      std::cerr << manifest_name << ":" << line_number
+                << ": batch entry failed." << std::endl;
+      return result;
+    }
+  }
+  return 0;
+}
+
 bool CommandLineInterface::InitializeDiskSourceTree(
     DiskSourceTree* source_tree, DescriptorDatabase* fallback_database) {
   AddDefaultProtoPaths(&proto_path_);
@@ -1663,6 +1724,9 @@ void CommandLineInterface::Clear() {
   descriptor_set_in_names_.clear();
   descriptor_set_out_name_.clear();
   dependency_out_name_.clear();
+  plugin_descriptor_set_handoff_name_.clear();
+  plugin_descriptor_set_handoff_written_ = false;
+  batch_manifest_name_.clear();
 
   experimental_editions_ = false;
   edition_defaults_out_name_.clear();
@@ -1878,6 +1942,19 @@ CommandLineInterface::ParseArgumentStatus CommandLineInterface::ParseArguments(
     proto_path_.push_back(std::pair<std::string, std::string>("", "."));
   }
 
+  // In batch mode the inputs and outputs come from the manifest entries, each
+  // of which is checked when it is run.
+  if (!batch_manifest_name_.empty()) {
+    if (!input_files_.empty() || !output_directives_.empty() ||
+        mode_ != MODE_COMPILE) {
+      std::cerr << "--batch_manifest may not be combined with input files, "
+                   "output directives, --encode or --decode."
+                << std::endl;
+      return PARSE_ARGUMENT_FAIL;
+    }
+    return PARSE_ARGUMENT_DONE_AND_CONTINUE;
+  }
+
   // Check error cases that span multiple flag values.
   bool missing_proto_definitions = false;
   switch (mode_) {
@@ -1900,6 +1977,8 @@ CommandLineInterface::ParseArgumentStatus CommandLineInterface::ParseArguments(
       // --decode (not raw) is handled the same way as the rest of the modes.
       ABSL_FALLTHROUGH_INTENDED;
     case MODE_ENCODE:
+    case MODE_ANALYZE:
+    case MODE_TRAIN_DICTIONARY:
     case MODE_PRINT:
       missing_proto_definitions =
           input_files_.empty() && descriptor_set_in_names_.empty();
@@ -2180,6 +2259,28 @@ CommandLineInterface::InterpretArgument(const std::string& name,
     }
     dependency_out_name_ = value;
 
+  } else if (name == "--plugin_descriptor_set_handoff") {
+    if (!plugin_descriptor_set_handoff_name_.empty()) {
+      std::cerr << name << " may only be passed once." << std::endl;
+      return PARSE_ARGUMENT_FAIL;
+    }
+    if (value.empty()) {
+      std::cerr << name << " requires a non-empty value." << std::endl;
+      return PARSE_ARGUMENT_FAIL;
+    }
+    plugin_descriptor_set_handoff_name_ = value;
+
+  } else if (name == "--batch_manifest") {
+    if (!batch_manifest_name_.empty()) {
+      std::cerr << name << " may only be passed once." << std::endl;
+      return PARSE_ARGUMENT_FAIL;
+    }
+    if (value.empty()) {
+      std::cerr << name << " requires a non-empty value." << std::endl;
+      return PARSE_ARGUMENT_FAIL;
+    }
+    batch_manifest_name_ = value;
+
   } else if (name == "--include_imports") {
     if (imports_in_descriptor_set_) {
       std::cerr << name << " may only be passed once." << std::endl;
@@ -2251,6 +2352,48 @@ CommandLineInterface::InterpretArgument(const std::string& name,
 
     codec_type_ = value;
 
+  } else if (name == "--analyze") {
+    if (mode_ != MODE_COMPILE) {
+      std::cerr << "Only one of --analyze, --encode and --decode can be "
+                   "specified."
+                << std::endl;
+      return PARSE_ARGUMENT_FAIL;
+    }
+    if (!output_directives_.empty() || !descriptor_set_out_name_.empty()) {
+      std::cerr << "Cannot use " << name
+                << " and generate code or descriptors at the same time."
+                << std::endl;
+      return PARSE_ARGUMENT_FAIL;
+    }
+    if (value.empty()) {
+      std::cerr << "Type name for " << name << " cannot be blank." << std::endl;
+      return PARSE_ARGUMENT_FAIL;
+    }
+
+    mode_ = MODE_ANALYZE;
+    codec_type_ = value;
+
+  } else if (name == "--train_dictionary") {
+    if (mode_ != MODE_COMPILE) {
+      std::cerr << "Only one of --train_dictionary, --analyze, --encode and "
+                   "--decode can be specified."
+                << std::endl;
+      return PARSE_ARGUMENT_FAIL;
+    }
+    if (!output_directives_.empty() || !descriptor_set_out_name_.empty()) {
+      std::cerr << "Cannot use " << name
+                << " and generate code or descriptors at the same time."
+                << std::endl;
+      return PARSE_ARGUMENT_FAIL;
+    }
+    if (value.empty()) {
+      std::cerr << "Type name for " << name << " cannot be blank." << std::endl;
+      return PARSE_ARGUMENT_FAIL;
+    }
+
+    mode_ = MODE_TRAIN_DICTIONARY;
+    codec_type_ = value;
+
   } else if (name == "--deterministic_output") {
     deterministic_output_ = true;
 
@@ -2462,6 +2605,21 @@ Parse PROTO_FILES and generate output based on the options given:
                               pairs in text format to standard output.  No
                               PROTO_FILES should be given when using this
                               flag.
+  --analyze=MESSAGE_TYPE      Read a binary message of the given type from
+                              standard input and write a table attributing
+                              its bytes to the fields that produced them to
+                              standard output.  The message type must be
+                              defined in PROTO_FILES or their imports.
+  --train_dictionary=MESSAGE_TYPE
+                              Read a corpus of binary messages of the given
+                              type, each prefixed with its size as a varint,
+                              from standard input and write a raw compression
+                              dictionary trained on their field values to
+                              standard output, most valuable bytes last, for
+                              use with zlib's deflateSetDictionary() or as a
+                              zstd raw-content dictionary.  The message type
+                              must be defined in PROTO_FILES or their
+                              imports.
   --descriptor_set_in=FILES   Specifies a delimited list of FILES
                               each containing a FileDescriptorSet (a
                               protocol buffer defined in descriptor.proto).
@@ -2490,6 +2648,15 @@ Parse PROTO_FILES and generate output based on the options given:
   --dependency_out=FILE       Write a dependency output file in the format
                               expected by make. This writes the transitive
                               set of input file paths to FILE
+  --batch_manifest=FILE       Run every command line listed in FILE (one
+                              complete set of protoc arguments per line,
+                              whitespace-separated; blank lines and lines
+                              starting with '#' are ignored) in this
+                              process, amortizing startup cost across many
+                              compilations.  Entries are compiled
+                              independently and the first failure stops the
+                              batch.  May not be combined with input files
+                              or output directives.
   --error_format=FORMAT       Set the format in which to print errors.
                               FORMAT may be 'gcc' (the default) or 'msvs'
                               (Microsoft Visual Studio format).
@@ -2512,7 +2679,15 @@ Parse PROTO_FILES and generate output based on the options given:
                               Additionally, EXECUTABLE may be of the form
                               NAME=PATH, in which case the given plugin name
                               is mapped to the given executable even if
-                              the executable's own name differs.)";
+                              the executable's own name differs.
+  --plugin_descriptor_set_handoff=FILE
+                              Write the descriptor set for plugin requests
+                              to FILE once and have each plugin load it from
+                              there instead of embedding it in every request.
+                              Plugins must support the descriptor_set_handoff
+                              parameter (C++ PluginMain does).  Point FILE at
+                              memory-backed storage (e.g. /dev/shm) to hand
+                              the descriptors off without touching disk.)";
   }
 
   for (const auto& kv : generators_by_flag_name_) {
@@ -2801,6 +2976,25 @@ bool CommandLineInterface::GeneratePluginOutput(
   version->set_patch(PROTOBUF_VERSION % 1000);
   version->set_suffix(PROTOBUF_VERSION_SUFFIX);
 
+  // Hand the descriptor set off through a file written once for all plugin
+  // invocations instead of re-embedding it in every request.  Bootstrap
+  // requests keep the inline form since their proto_file differs.
+  if (!plugin_descriptor_set_handoff_name_.empty() && !bootstrap) {
+    if (!plugin_descriptor_set_handoff_written_) {
+      if (!WritePluginDescriptorSetHandoff(request, error)) {
+        return false;
+      }
+      plugin_descriptor_set_handoff_written_ = true;
+    }
+    request.clear_proto_file();
+    std::string handoff_option = absl::StrCat(
+        "descriptor_set_handoff=", plugin_descriptor_set_handoff_name_);
+    request.set_parameter(
+        request.parameter().empty()
+            ? handoff_option
+            : absl::StrCat(request.parameter(), ",", handoff_option));
+  }
+
   // Invoke the plugin.
   Subprocess subprocess;
 
@@ -2937,6 +3131,88 @@ bool CommandLineInterface::EncodeOrDecode(const DescriptorPool* pool) {
   return true;
 }
 
+bool CommandLineInterface::AnalyzeMessage(const DescriptorPool* pool) {
+  // Look up the type.
+  const Descriptor* type = pool->FindMessageTypeByName(codec_type_);
+  if (type == nullptr) {
+    std::cerr << "Type not defined: " << codec_type_ << std::endl;
+    return false;
+  }
+
+  SetFdToBinaryMode(STDIN_FILENO);
+  SetFdToTextMode(STDOUT_FILENO);
+
+  io::FileInputStream in(STDIN_FILENO);
+  std::string data;
+  const void* buffer;
+  int size;
+  while (in.Next(&buffer, &size)) {
+    data.append(static_cast<const char*>(buffer), size);
+  }
+
+  util::WireStats stats;
+  const bool ok = util::AnalyzeWireStats(type, data, &stats);
+  if (!ok) {
+    std::cerr << "warning:  Input is malformed; statistics cover the bytes "
+                 "before the malformed point."
+              << std::endl;
+  }
+  std::cout << util::WireStatsToString(stats);
+  const std::string string_lengths = util::WireStringLengthsToString(stats);
+  if (!string_lengths.empty()) {
+    std::cout << "\n" << string_lengths;
+  }
+  return ok;
+}
+
+bool CommandLineInterface::TrainCompressionDictionary(
+    const DescriptorPool* pool) {
+  // Matches zlib's 32 KB deflate window, the smaller of the two dictionary
+  // formats the output targets.
+  static const size_t kMaxDictionaryBytes = 32 * 1024;
+
+  // Look up the type.
+  const Descriptor* type = pool->FindMessageTypeByName(codec_type_);
+  if (type == nullptr) {
+    std::cerr << "Type not defined: " << codec_type_ << std::endl;
+    return false;
+  }
+
+  DynamicMessageFactory dynamic_factory(pool);
+  std::unique_ptr<Message> message(dynamic_factory.GetPrototype(type)->New());
+
+  SetFdToBinaryMode(STDIN_FILENO);
+  SetFdToBinaryMode(STDOUT_FILENO);
+
+  io::FileInputStream in(STDIN_FILENO);
+  io::CodedInputStream coded_in(&in);
+  coded_in.SetTotalBytesLimit(INT_MAX);
+
+  util::CompressionDictionaryTrainer trainer;
+  bool clean_eof = false;
+  while (util::ParseDelimitedFromCodedStream(message.get(), &coded_in,
+                                             &clean_eof)) {
+    trainer.AddMessage(*message);
+    message->Clear();
+  }
+  if (!clean_eof) {
+    std::cerr << "input: malformed corpus record after "
+              << trainer.message_count() << " message(s)." << std::endl;
+    return false;
+  }
+  if (trainer.message_count() == 0) {
+    std::cerr << "input: empty corpus." << std::endl;
+    return false;
+  }
+
+  const std::string dictionary = trainer.TrainDictionary(kMaxDictionaryBytes);
+
+  io::FileOutputStream out(STDOUT_FILENO);
+  io::CodedOutputStream coded_out(&out);
+  coded_out.WriteString(dictionary);
+  return true;
+}
+
 bool CommandLineInterface::WriteDescriptorSet(
     const std::vector<const FileDescriptor*>& parsed_files) {
   FileDescriptorSet file_set;
@@ -3004,6 +3280,39 @@ bool CommandLineInterface::WriteDescriptorSet(
   return true;
 }
 
+bool CommandLineInterface::WritePluginDescriptorSetHandoff(
+    const CodeGeneratorRequest& request, std::string* error) {
+  FileDescriptorSet file_set;
+  file_set.mutable_file()->CopyFrom(request.proto_file());
+
+  int fd;
+  do {
+    fd = open(plugin_descriptor_set_handoff_name_.c_str(),
+              O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0666);
+  } while (fd < 0 && errno == EINTR);
+
+  if (fd < 0) {
+    *error = absl::StrCat(plugin_descriptor_set_handoff_name_, ": ",
+                          strerror(errno));
+    return false;
+  }
+
+  io::FileOutputStream out(fd);
+  if (!file_set.SerializeToZeroCopyStream(&out)) {
+    *error = absl::StrCat(plugin_descriptor_set_handoff_name_, ": ",
+                          strerror(out.GetErrno()));
+    out.Close();
+    return false;
+  }
+  if (!out.Close()) {
+    *error = absl::StrCat(plugin_descriptor_set_handoff_name_, ": ",
+                          strerror(out.GetErrno()));
+    return false;
+  }
+
+  return true;
+}
+
 bool CommandLineInterface::WriteEditionDefaults(const DescriptorPool& pool) {
   const Descriptor* feature_set =
       pool.FindMessageTypeByName("google.protobuf.FeatureSet");
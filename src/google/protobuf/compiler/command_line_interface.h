@@ -47,9 +47,10 @@ class SimpleDescriptorDatabase;  // descriptor_database.h
 
 namespace compiler {
 
-class CodeGenerator;     // code_generator.h
-class GeneratorContext;  // code_generator.h
-class DiskSourceTree;    // importer.h
+class CodeGenerator;         // code_generator.h
+class CodeGeneratorRequest;  // plugin.pb.h
+class GeneratorContext;      // code_generator.h
+class DiskSourceTree;        // importer.h
 
 struct TransitiveDependencyOptions {
   bool include_json_name = false;
@@ -205,6 +206,14 @@ class PROTOC_EXPORT CommandLineInterface {
   // Clear state from previous Run().
   void Clear();
 
+  // Runs every command line listed in the --batch_manifest file through
+  // Run(), amortizing process startup across many compilations.  Each entry
+  // is compiled independently; the first failing entry stops the batch and
+  // its exit code is returned.  The parameters are taken by value because
+  // the recursive Run() calls clear the members they would otherwise
+  // reference.
+  int RunBatch(std::string executable_name, std::string manifest_name);
+
   // Remaps the proto file so that it is relative to one of the directories
   // in proto_path_.  Returns false if an error occurred.
   bool MakeProtoProtoPathRelative(DiskSourceTree* source_tree,
@@ -290,10 +299,21 @@ class PROTOC_EXPORT CommandLineInterface {
   // Implements --encode and --decode.
   bool EncodeOrDecode(const DescriptorPool* pool);
 
+  // Implements --analyze.
+  bool AnalyzeMessage(const DescriptorPool* pool);
+
+  // Implements --train_dictionary.
+  bool TrainCompressionDictionary(const DescriptorPool* pool);
+
   // Implements the --descriptor_set_out option.
   bool WriteDescriptorSet(
       const std::vector<const FileDescriptor*>& parsed_files);
 
+  // Implements the --plugin_descriptor_set_handoff option: writes the
+  // request's proto_file to the handoff file for plugins to load.
+  bool WritePluginDescriptorSetHandoff(const CodeGeneratorRequest& request,
+                                       std::string* error);
+
   // Implements the --edition_defaults_out option.
   bool WriteEditionDefaults(const DescriptorPool& pool);
 
@@ -377,6 +397,11 @@ class PROTOC_EXPORT CommandLineInterface {
     MODE_COMPILE,  // Normal mode:  parse .proto files and compile them.
     MODE_ENCODE,   // --encode:  read text from stdin, write binary to stdout.
     MODE_DECODE,   // --decode:  read binary from stdin, write text to stdout.
+    MODE_ANALYZE,  // --analyze: read binary from stdin, write per-field byte
+                   //            statistics to stdout.
+    MODE_TRAIN_DICTIONARY,  // --train_dictionary: read length-delimited
+                            //  messages from stdin, write a raw compression
+                            //  dictionary to stdout.
     MODE_PRINT,    // Print mode: print info of the given .proto files and exit.
   };
 
@@ -442,6 +467,18 @@ class PROTOC_EXPORT CommandLineInterface {
   // dependency file will be written. Otherwise, empty.
   std::string dependency_out_name_;
 
+  // If --plugin_descriptor_set_handoff was given, this is the file to which
+  // the descriptor set for plugin requests is written once, with each plugin
+  // request then referencing it instead of embedding proto_file. Otherwise,
+  // empty.
+  std::string plugin_descriptor_set_handoff_name_;
+  bool plugin_descriptor_set_handoff_written_ = false;
+
+  // If --batch_manifest was given, this is the path to a file listing one
+  // complete protoc command line per line, all of which are run in this
+  // process. Otherwise, empty.
+  std::string batch_manifest_name_;
+
   bool experimental_editions_ = false;
 
   // True if --include_imports was given, meaning that we should
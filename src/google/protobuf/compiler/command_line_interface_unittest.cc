@@ -39,6 +39,7 @@
 #include "google/protobuf/descriptor.pb.h"
 #include "google/protobuf/testing/googletest.h"
 #include <gtest/gtest.h>
+#include "absl/strings/match.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
@@ -46,6 +47,7 @@
 #include "google/protobuf/compiler/command_line_interface.h"
 #include "google/protobuf/compiler/cpp/names.h"
 #include "google/protobuf/compiler/mock_code_generator.h"
+#include "google/protobuf/compiler/plugin.h"
 #include "google/protobuf/compiler/plugin.pb.h"
 #include "google/protobuf/test_textproto.h"
 #include "google/protobuf/test_util2.h"
@@ -390,6 +392,66 @@ TEST_F(CommandLineInterfaceTest, BasicOutput_DescriptorSetIn) {
   ExpectGenerated("test_generator", "", "foo.proto", "Foo");
 }
 
+TEST_F(CommandLineInterfaceTest, BatchManifest) {
+  // Test that --batch_manifest compiles each listed command line.
+
+  CreateTempFile("foo.proto",
+                 "syntax = \"proto2\";\n"
+                 "message Foo {}\n");
+  CreateTempFile("bar.proto",
+                 "syntax = \"proto2\";\n"
+                 "message Bar {}\n");
+  CreateTempFile(
+      "manifest.txt",
+      absl::StrCat("# comment lines and blank lines are ignored\n", "\n",
+                   "--test_out=", temp_directory(),
+                   " --proto_path=", temp_directory(), " foo.proto\n",
+                   "--test_out=", temp_directory(),
+                   " --proto_path=", temp_directory(), " bar.proto\n"));
+
+  Run("protocol_compiler --batch_manifest=$tmpdir/manifest.txt");
+
+  ExpectNoErrors();
+  ExpectGenerated("test_generator", "", "foo.proto", "Foo");
+  ExpectGenerated("test_generator", "", "bar.proto", "Bar");
+}
+
+TEST_F(CommandLineInterfaceTest, BatchManifestEntryFailure) {
+  // The first failing entry stops the batch.
+
+  CreateTempFile(
+      "manifest.txt",
+      absl::StrCat("--test_out=", temp_directory(),
+                   " --proto_path=", temp_directory(), " missing.proto\n"));
+
+  Run("protocol_compiler --batch_manifest=$tmpdir/manifest.txt");
+
+  ExpectErrorSubstring("manifest.txt:1: batch entry failed.");
+}
+
+TEST_F(CommandLineInterfaceTest, BatchManifestCombinedWithInputs) {
+  CreateTempFile("foo.proto",
+                 "syntax = \"proto2\";\n"
+                 "message Foo {}\n");
+  CreateTempFile("manifest.txt", "");
+
+  Run("protocol_compiler --batch_manifest=$tmpdir/manifest.txt "
+      "--proto_path=$tmpdir foo.proto");
+
+  ExpectErrorSubstring("--batch_manifest may not be combined");
+}
+
+TEST_F(CommandLineInterfaceTest, BatchManifestMayNotBeNested) {
+  CreateTempFile("inner.txt", "");
+  CreateTempFile("manifest.txt", absl::StrCat("--batch_manifest=",
+                                              temp_directory(), "/inner.txt\n"));
+
+  Run("protocol_compiler --batch_manifest=$tmpdir/manifest.txt");
+
+  ExpectErrorSubstring(
+      "--batch_manifest may not be used inside a batch manifest.");
+}
+
 TEST_F(CommandLineInterfaceTest, BasicPlugin) {
   // Test that basic plugins work.
 
@@ -492,6 +554,47 @@ TEST_F(CommandLineInterfaceTest, Plugin_OptionRetention) {
   }
 }
 
+TEST_F(CommandLineInterfaceTest, Plugin_DescriptorSetHandoff) {
+  CreateTempFile("foo.proto",
+                 R"pb(syntax = "proto2"
+                      ;
+                      package foo;
+                      message Foo { optional int32 a = 1; })pb");
+
+#ifdef GOOGLE_PROTOBUF_FAKE_PLUGIN_PATH
+  std::string plugin_path = GOOGLE_PROTOBUF_FAKE_PLUGIN_PATH;
+#else
+  std::string plugin_path = absl::StrCat(
+      TestUtil::TestSourceDir(), "/google/protobuf/compiler/fake_plugin");
+#endif
+
+  // With the handoff flag, the request sent to the plugin references the
+  // descriptor set file instead of embedding proto_file.
+  Run(absl::StrCat(
+      "protocol_compiler --fake_plugin_out=$tmpdir --proto_path=$tmpdir "
+      "--plugin_descriptor_set_handoff=$tmpdir/handoff.bin "
+      "foo.proto --plugin=prefix-gen-fake_plugin=",
+      plugin_path));
+  ExpectNoErrors();
+  std::string base64_output = ReadFile("foo.proto.request");
+  std::string binary_request;
+  ASSERT_TRUE(absl::Base64Unescape(base64_output, &binary_request));
+  CodeGeneratorRequest request;
+  ASSERT_TRUE(request.ParseFromString(binary_request));
+
+  EXPECT_EQ(request.proto_file_size(), 0);
+  EXPECT_TRUE(
+      absl::StrContains(request.parameter(), "descriptor_set_handoff="));
+
+  // The plugin front end resolves the reference back to the full request.
+  std::string error;
+  ASSERT_TRUE(ExpandDescriptorSetHandoff(&request, &error)) << error;
+  ASSERT_EQ(request.proto_file_size(), 1);
+  EXPECT_EQ(request.proto_file(0).name(), "foo.proto");
+  EXPECT_FALSE(
+      absl::StrContains(request.parameter(), "descriptor_set_handoff"));
+}
+
 TEST_F(CommandLineInterfaceTest, Plugin_SourceFileDescriptors) {
   CreateTempFile("foo.proto",
                  R"pb(syntax = "proto2"
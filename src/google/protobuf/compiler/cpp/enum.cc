@@ -523,8 +523,9 @@ void EnumGenerator::GenerateMethods(int idx, io::Printer* p) {
             int idx = ::$proto_ns$::internal::LookUpEnumName(
                 $Msg_Enum$_entries, $Msg_Enum$_entries_by_number, $num_unique$,
                 value);
-            return idx == -1 ? ::$proto_ns$::internal::GetEmptyString()
-                             : $Msg_Enum$_strings[idx].get();
+            return idx == -1
+                       ? ::$proto_ns$::internal::GetEmptyStringAlreadyInited()
+                       : $Msg_Enum$_strings[idx].get();
           }
 
           bool $Msg_Enum$_Parse(absl::string_view name, $Msg_Enum$* value) {
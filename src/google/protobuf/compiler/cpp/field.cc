@@ -344,6 +344,16 @@ void HasBitVars(const FieldDescriptor* field, const Options& opts,
   auto set = absl::StrFormat("%s[%d] |= %s;", has_bits, index, mask);
   auto clr = absl::StrFormat("%s[%d] &= ~%s;", has_bits, index, mask);
 
+  // With dirty_bits, setters and clearers additionally mark the field's bit
+  // in _dirty_bits_ (clearing a field is a mutation too).  Map entries have
+  // no _dirty_bits_ member.
+  if (opts.dirty_bits && !IsMapEntryMessage(field->containing_type())) {
+    auto dirty =
+        absl::StrFormat(" _impl_._dirty_bits_[%d] |= %s;", index, mask);
+    absl::StrAppend(&set, dirty);
+    absl::StrAppend(&clr, dirty);
+  }
+
   vars.emplace_back("has_hasbit", has);
   vars.emplace_back(Sub("set_hasbit", set).WithSuffix(";"));
   vars.emplace_back(Sub("clear_hasbit", clr).WithSuffix(";"));
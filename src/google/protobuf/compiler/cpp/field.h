@@ -180,6 +180,24 @@ class FieldGeneratorBase {
   virtual void GenerateSerializeWithCachedSizesToArray(
       io::Printer* p) const = 0;
 
+  // For fields whose serializer writes at most a small compile-time-constant
+  // number of bytes (fixed-width scalars and bool), returns that maximum, tag
+  // included.  The message serializer uses this to coalesce EnsureSpace()
+  // calls across runs of adjacent such fields.  Generators returning a value
+  // here must also override
+  // GenerateSerializeWithCachedSizesToArrayNoEnsureSpace().
+  virtual absl::optional<size_t> FixedSerializedSize() const {
+    return absl::nullopt;
+  }
+
+  // Like GenerateSerializeWithCachedSizesToArray(), but the caller guarantees
+  // that FixedSerializedSize() bytes are already writable at `target`, so the
+  // serializer must not emit its own EnsureSpace() call.
+  virtual void GenerateSerializeWithCachedSizesToArrayNoEnsureSpace(
+      io::Printer* p) const {
+    GenerateSerializeWithCachedSizesToArray(p);
+  }
+
   virtual void GenerateByteSize(io::Printer* p) const = 0;
 
   virtual void GenerateIsInitialized(io::Printer* p) const {}
@@ -460,6 +478,18 @@ class FieldGenerator {
     impl_->GenerateSerializeWithCachedSizesToArray(p);
   }
 
+  // See FieldGeneratorBase for documentation.
+  absl::optional<size_t> FixedSerializedSize() const {
+    return impl_->FixedSerializedSize();
+  }
+
+  // See FieldGeneratorBase for documentation.
+  void GenerateSerializeWithCachedSizesToArrayNoEnsureSpace(
+      io::Printer* p) const {
+    auto vars = PushVarsForCall(p);
+    impl_->GenerateSerializeWithCachedSizesToArrayNoEnsureSpace(p);
+  }
+
   // Generates statements to compute the serialized size of this field, which
   // are placed in the message's ByteSize() method.
   void GenerateByteSize(io::Printer* p) const {
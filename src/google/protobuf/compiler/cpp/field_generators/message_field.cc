@@ -21,6 +21,7 @@
 #include "google/protobuf/compiler/cpp/field.h"
 #include "google/protobuf/compiler/cpp/field_generators/generators.h"
 #include "google/protobuf/compiler/cpp/helpers.h"
+#include "google/protobuf/compiler/cpp/names.h"
 #include "google/protobuf/compiler/cpp/options.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/descriptor.pb.h"
@@ -149,7 +150,7 @@ class SingularMessage : public FieldGeneratorBase {
 
 void SingularMessage::GenerateAccessorDeclarations(io::Printer* p) const {
   auto vars = AnnotatedAccessors(
-      field_, {"", "set_allocated_", "unsafe_arena_set_allocated_",
+      field_, {"", "set_", "set_allocated_", "unsafe_arena_set_allocated_",
                "unsafe_arena_release_"});
   vars.push_back(Sub{
       "release_name",
@@ -160,20 +161,29 @@ void SingularMessage::GenerateAccessorDeclarations(io::Printer* p) const {
   auto v2 = p->WithVars(
       AnnotatedAccessors(field_, {"mutable_"}, AnnotationCollector::kAlias));
 
-  p->Emit(R"cc(
-    $DEPRECATED$ const $Submsg$& $name$() const;
-    $DEPRECATED$ PROTOBUF_NODISCARD $Submsg$* $release_name$();
-    $DEPRECATED$ $Submsg$* $mutable_name$();
-    $DEPRECATED$ void $set_allocated_name$($Submsg$* value);
-    $DEPRECATED$ void $unsafe_arena_set_allocated_name$($Submsg$* value);
-    $DEPRECATED$ $Submsg$* $unsafe_arena_release_name$();
-
-    private:
-    const $Submsg$& _internal_$name$() const;
-    $Submsg$* _internal_mutable_$name$();
-
-    public:
-  )cc");
+  p->Emit(
+      {{"set_by_move_decl",
+        [&] {
+          if (is_weak()) return;
+          p->Emit(R"cc(
+            $DEPRECATED$ void $set_name$($Submsg$&& value);
+          )cc");
+        }}},
+      R"cc(
+        $DEPRECATED$ const $Submsg$& $name$() const;
+        $DEPRECATED$ PROTOBUF_NODISCARD $Submsg$* $release_name$();
+        $DEPRECATED$ $Submsg$* $mutable_name$();
+        $set_by_move_decl$;
+        $DEPRECATED$ void $set_allocated_name$($Submsg$* value);
+        $DEPRECATED$ void $unsafe_arena_set_allocated_name$($Submsg$* value);
+        $DEPRECATED$ $Submsg$* $unsafe_arena_release_name$();
+
+        private:
+        const $Submsg$& _internal_$name$() const;
+        $Submsg$* _internal_mutable_$name$();
+
+        public:
+      )cc");
 }
 
 void SingularMessage::GenerateInlineAccessorDefinitions(io::Printer* p) const {
@@ -193,6 +203,24 @@ void SingularMessage::GenerateInlineAccessorDefinitions(io::Printer* p) const {
                }
              )cc");
            }},
+          {"set_by_move",
+           [&] {
+             if (is_weak()) return;
+             p->Emit(R"cc(
+               inline void $Msg$::set_$name$($Submsg$&& value) {
+                 $WeakDescriptorSelfPin$;
+                 $TsanDetectConcurrentMutation$;
+                 $PrepareSplitMessageForWrite$;
+                 $set_hasbit$;
+                 //~ Message move assignment is arena-aware: it swaps
+                 //~ representations when the arenas match and falls back to a
+                 //~ copy when they do not.
+                 *_internal_mutable_$name_internal$() = std::move(value);
+                 $annotate_set$;
+                 // @@protoc_insertion_point(field_set:$pkg.Msg.field$)
+               }
+             )cc");
+           }},
       },
       R"cc(
         inline const $Submsg$& $Msg$::_internal_$name_internal$() const {
@@ -277,6 +305,7 @@ void SingularMessage::GenerateInlineAccessorDefinitions(io::Printer* p) const {
           // @@protoc_insertion_point(field_mutable:$pkg.Msg.field$)
           return _msg;
         }
+        $set_by_move$;
         //~ We handle the most common case inline, and delegate less common
         //~ cases to the slow fallback function.
         inline void $Msg$::set_allocated_$name$($Submsg$* value) {
@@ -569,18 +598,48 @@ void OneofMessage::GenerateInlineAccessorDefinitions(io::Printer* p) const {
       // @@protoc_insertion_point(field_unsafe_arena_set_allocated:$pkg.Msg.field$)
     }
   )cc");
-  p->Emit(R"cc(
-    inline $Submsg$* $Msg$::_internal_mutable_$name_internal$() {
-      $StrongRef$;
-      if ($not_has_field$) {
-        clear_$oneof_name$();
-        set_has_$name_internal$();
-        $field_$ =
-            $weak_cast$($superclass$::DefaultConstruct<$Submsg$>(GetArena()));
+  if (IsOneofCachedField(field_, options_)) {
+    // Take a matching cached member out of the slot before clear_$oneof_name$()
+    // refills it with the member being evicted; that way two members
+    // toggling reuse each other's storage with no allocation.
+    p->Emit({{"field_case", OneofCaseConstantName(field_)}},
+            R"cc(
+              inline $Submsg$* $Msg$::_internal_mutable_$name_internal$() {
+                $StrongRef$;
+                if ($not_has_field$) {
+                  $Submsg$* cached = nullptr;
+                  if (_impl_._$oneof_name$_cache_case_ ==
+                      static_cast<::uint32_t>($field_case$)) {
+                    cached = static_cast<$Submsg$*>(_impl_._$oneof_name$_cache_);
+                    _impl_._$oneof_name$_cache_ = nullptr;
+                    _impl_._$oneof_name$_cache_case_ = 0;
+                  }
+                  clear_$oneof_name$();
+                  set_has_$name_internal$();
+                  if (cached != nullptr) {
+                    cached->Clear();
+                    $field_$ = cached;
+                  } else {
+                    $field_$ = $superclass$::DefaultConstruct<$Submsg$>(GetArena());
+                  }
+                }
+                return $cast_field_$;
+              }
+            )cc");
+  } else {
+    p->Emit(R"cc(
+      inline $Submsg$* $Msg$::_internal_mutable_$name_internal$() {
+        $StrongRef$;
+        if ($not_has_field$) {
+          clear_$oneof_name$();
+          set_has_$name_internal$();
+          $field_$ =
+              $weak_cast$($superclass$::DefaultConstruct<$Submsg$>(GetArena()));
+        }
+        return $cast_field_$;
       }
-      return $cast_field_$;
-    }
-  )cc");
+    )cc");
+  }
   p->Emit(R"cc(
     inline $Submsg$* $Msg$::mutable_$name$() ABSL_ATTRIBUTE_LIFETIME_BOUND {
       $WeakDescriptorSelfPin$;
@@ -590,30 +649,59 @@ void OneofMessage::GenerateInlineAccessorDefinitions(io::Printer* p) const {
       return _msg;
     }
   )cc");
+  if (!is_weak()) {
+    p->Emit(R"cc(
+      inline void $Msg$::set_$name$($Submsg$&& value) {
+        $WeakDescriptorSelfPin$;
+        *_internal_mutable_$name_internal$() = std::move(value);
+        $annotate_set$;
+        // @@protoc_insertion_point(field_set:$pkg.Msg.field$)
+      }
+    )cc");
+  }
 }
 
 void OneofMessage::GenerateClearingCode(io::Printer* p) const {
-  p->Emit({{"poison_or_clear",
-            [&] {
-              if (HasDescriptorMethods(field_->file(), options_)) {
-                p->Emit(R"cc(
-                  $pbi$::MaybePoisonAfterClear($field_$);
-                )cc");
+  auto poison_or_clear = [&] {
+    if (HasDescriptorMethods(field_->file(), options_)) {
+      p->Emit(R"cc(
+        $pbi$::MaybePoisonAfterClear($field_$);
+      )cc");
+    } else {
+      p->Emit(R"cc(
+        if ($field_$ != nullptr) {
+          $field_$->Clear();
+        }
+      )cc");
+    }
+  };
+  if (IsOneofCachedField(field_, options_)) {
+    // Hardened builds skip the cache so that poisoning (and with it
+    // use-after-clear detection) stays effective.
+    p->Emit({{"poison_or_clear", poison_or_clear},
+             {"field_case", OneofCaseConstantName(field_)}},
+            R"cc(
+              if (GetArena() == nullptr) {
+                delete $field_$;
+              } else if ($pbi$::DebugHardenClearOneofMessageOnArena()) {
+                $poison_or_clear$;
               } else {
-                p->Emit(R"cc(
-                  if ($field_$ != nullptr) {
-                    $field_$->Clear();
-                  }
-                )cc");
+                // Keep the evicted member so that switching the case back
+                // recycles it instead of allocating.
+                _impl_._$oneof_name$_cache_ = $field_$;
+                _impl_._$oneof_name$_cache_case_ = $field_case$;
               }
-            }}},
-          R"cc(
-            if (GetArena() == nullptr) {
-              delete $field_$;
-            } else if ($pbi$::DebugHardenClearOneofMessageOnArena()) {
-              $poison_or_clear$;
-            }
-          )cc");
+            )cc");
+  } else {
+    p->Emit({{"poison_or_clear", poison_or_clear}},
+            R"cc(
+              if (GetArena() == nullptr) {
+                delete $field_$;
+              } else if ($pbi$::DebugHardenClearOneofMessageOnArena()) {
+                $poison_or_clear$;
+              }
+            )cc");
+  }
 }
 
 void OneofMessage::GenerateMessageClearingCode(io::Printer* p) const {
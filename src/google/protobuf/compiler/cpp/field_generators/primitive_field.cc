@@ -158,9 +158,18 @@ class SingularPrimitive final : public FieldGeneratorBase {
     )cc");
   }
 
+  absl::optional<size_t> FixedSerializedSize() const override {
+    if (is_oneof()) return absl::nullopt;
+    auto fixed_size = FixedSize(field_->type());
+    if (!fixed_size.has_value()) return absl::nullopt;
+    return WireFormat::TagSize(field_->number(), field_->type()) + *fixed_size;
+  }
+
   void GenerateAccessorDeclarations(io::Printer* p) const override;
   void GenerateInlineAccessorDefinitions(io::Printer* p) const override;
   void GenerateSerializeWithCachedSizesToArray(io::Printer* p) const override;
+  void GenerateSerializeWithCachedSizesToArrayNoEnsureSpace(
+      io::Printer* p) const override;
   void GenerateByteSize(io::Printer* p) const override;
 
  private:
@@ -259,6 +268,15 @@ void SingularPrimitive::GenerateSerializeWithCachedSizesToArray(
   }
 }
 
+void SingularPrimitive::GenerateSerializeWithCachedSizesToArrayNoEnsureSpace(
+    io::Printer* p) const {
+  ABSL_DCHECK(FixedSerializedSize().has_value());
+  p->Emit(R"cc(
+    target = ::_pbi::WireFormatLite::Write$DeclaredType$ToArray(
+        $number$, this->_internal_$name$(), target);
+  )cc");
+}
+
 void SingularPrimitive::GenerateByteSize(io::Printer* p) const {
   size_t tag_size = WireFormat::TagSize(field_->number(), field_->type());
 
@@ -218,13 +218,10 @@ void SingularStringView::GenerateStaticMembers(io::Printer* p) const {
 void SingularStringView::GenerateAccessorDeclarations(io::Printer* p) const {
   ABSL_CHECK(!field_->options().has_ctype());
 
-  auto vars = AnnotatedAccessors(field_, {"", "set_allocated_"});
-  vars.push_back(Sub{
-      "release_name",
-      SafeFunctionName(field_->containing_type(), field_, "release_"),
-  }
-                     .AnnotatedAs(field_));
-  auto v1 = p->WithVars(vars);
+  // The string_view API deliberately exposes no mutable_/release_/
+  // set_allocated_ accessors: callers never get their hands on the backing
+  // std::string.
+  auto v1 = p->WithVars(AnnotatedAccessors(field_, {""}));
   auto v2 = p->WithVars(
       AnnotatedAccessors(field_, {"set_"}, AnnotationCollector::kSet));
   auto v3 = p->WithVars(
@@ -305,8 +302,6 @@ void SingularStringView::GenerateInlineAccessorDefinitions(
                }
              )cc");
            }},
-          {"release_name",
-           SafeFunctionName(field_->containing_type(), field_, "release_")},
       },
       R"cc(
         inline absl::string_view $Msg$::$name$() const
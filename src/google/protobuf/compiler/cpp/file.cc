@@ -180,6 +180,7 @@ void FileGenerator::GenerateFile(io::Printer* p, GeneratedFileType file_type,
 
     #include <limits>
     #include <string>
+    #include <tuple>
     #include <type_traits>
     #include <utility>
 
@@ -243,6 +244,8 @@ void FileGenerator::GenerateSharedHeaderCode(io::Printer* p) {
           {"fwd_decls", [&] { GenerateForwardDeclarations(p); }},
           {"proto2_ns_enums",
            [&] { GenerateProto2NamespaceEnumSpecializations(p); }},
+          {"fixed_shape_specializations",
+           [&] { GenerateFixedShapeSpecializations(p); }},
           {"main_decls",
            [&] {
              NamespaceOpener ns(Namespace(file_, options_), p);
@@ -292,6 +295,8 @@ void FileGenerator::GenerateSharedHeaderCode(io::Printer* p) {
 
           $proto2_ns_enums$
 
+          $fixed_shape_specializations$
+
           // @@protoc_insertion_point(global_scope)
 
           $port_undef$
@@ -890,10 +895,25 @@ void FileGenerator::GenerateGlobalSource(io::Printer* p) {
     }
   }
 
-  NamespaceOpener ns(Namespace(file_, options_), p);
-  for (size_t i = 0; i < enum_generators_.size(); ++i) {
-    enum_generators_[i]->GenerateMethods(i, p);
+  {
+    NamespaceOpener ns(Namespace(file_, options_), p);
+    for (size_t i = 0; i < enum_generators_.size(); ++i) {
+      enum_generators_[i]->GenerateMethods(i, p);
+    }
+
+    if (HasGenericServices(file_, options_)) {
+      for (size_t i = 0; i < service_generators_.size(); ++i) {
+        p->Emit(R"(
+          $hrule_thick$
+        )");
+        service_generators_[i]->GenerateImplementation(p);
+      }
+    }
   }
+
+  // Flushes the AddDescriptors() registration queued by the reflection code
+  // above; a no-op for lite files.
+  GenerateStaticInitializer(p);
 }
 
 void FileGenerator::GenerateSource(io::Printer* p) {
@@ -1358,7 +1378,11 @@ void FileGenerator::GenerateReflectionInitializationCode(io::Printer* p) {
   // dynamic initialization, because in some situations that would otherwise
   // pull in a lot of unnecessary code that can't be stripped by --gc-sections.
   // Descriptor initialization will still be performed lazily when it's needed.
-  if (!IsLazilyInitializedFile(file_->name())) {
+  // The lazy_descriptor_initialization option opts arbitrary files into the
+  // same treatment; unlike the hardcoded files above, their extension
+  // registration (handled separately) stays eager.
+  if (!IsLazilyInitializedFile(file_->name()) &&
+      !options_.lazy_descriptor_initialization) {
     if (UsingImplicitWeakDescriptor(file_, options_)) {
       for (auto* pinned :
            GetMessagesToPinGloballyForWeakDescriptors(file_, options_)) {
@@ -1603,6 +1627,9 @@ void FileGenerator::GenerateLibraryIncludes(io::Printer* p) {
   if (HasGeneratedMethods(file_, options_)) {
     IncludeFile("third_party/protobuf/generated_message_tctable_decl.h", p);
   }
+  if (options_.fixed_shape_codec) {
+    IncludeFile("third_party/protobuf/generated_message_fixed_shape.h", p);
+  }
   IncludeFile("third_party/protobuf/generated_message_util.h", p);
   IncludeFile("third_party/protobuf/metadata_lite.h", p);
 
@@ -1812,6 +1839,32 @@ void FileGenerator::GenerateProto2NamespaceEnumSpecializations(io::Printer* p) {
   p->PrintRaw("\n");
 }
 
+void FileGenerator::GenerateFixedShapeSpecializations(io::Printer* p) {
+  if (!options_.fixed_shape_codec) {
+    return;
+  }
+
+  bool has_fixed_shape = false;
+  for (auto& gen : message_generators_) {
+    if (IsFixedShapeMessage(gen->descriptor(), options_)) {
+      has_fixed_shape = true;
+      break;
+    }
+  }
+  if (!has_fixed_shape) {
+    return;
+  }
+
+  p->PrintRaw("\n");
+  NamespaceOpener ns(absl::StrCat(ProtobufNamespace(options_), "::internal"),
+                     p);
+  p->PrintRaw("\n");
+  for (auto& gen : message_generators_) {
+    gen->GenerateFixedShapeTraits(p);
+  }
+  p->PrintRaw("\n");
+}
+
 std::vector<const Descriptor*> FileGenerator::MessagesInTopologicalOrder()
     const {
   std::vector<const Descriptor*> descs;
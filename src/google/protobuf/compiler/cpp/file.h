@@ -151,6 +151,11 @@ class PROTOC_EXPORT FileGenerator {
 
   void GenerateProto2NamespaceEnumSpecializations(io::Printer* p);
 
+  // Generates FixedShapeTraits specializations in the
+  // google::protobuf::internal namespace for messages that qualify for the
+  // fixed-shape codec.
+  void GenerateFixedShapeSpecializations(io::Printer* p);
+
   // Sometimes the names we use in a .proto file happen to be defined as
   // macros on some platforms (e.g., macro/minor used in plugin.proto are
   // defined as macros in sys/types.h on FreeBSD and a few other platforms).
@@ -13,6 +13,7 @@
 
 #include <cstdlib>
 #include <cstring>
+#include <fstream>
 #include <memory>
 #include <string>
 #include <utility>
@@ -22,6 +23,7 @@
 #include "absl/log/absl_check.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
+#include "absl/strings/ascii.h"
 #include "absl/strings/match.h"
 #include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
@@ -124,6 +126,8 @@ bool CppGenerator::Generate(const FileDescriptor* file,
   file_options.opensource_runtime = opensource_runtime_;
   file_options.runtime_include_base = runtime_include_base_;
 
+  std::string presence_profile_path;
+
   for (const auto& option : options) {
     const auto& key = option.first;
     const auto& value = option.second;
@@ -153,6 +157,18 @@ bool CppGenerator::Generate(const FileDescriptor* file,
       }
     } else if (key == "descriptor_implicit_weak_messages") {
       file_options.descriptor_implicit_weak_messages = true;
+    } else if (key == "lazy_descriptor_initialization") {
+      file_options.lazy_descriptor_initialization = true;
+    } else if (key == "fixed_shape_codec") {
+      file_options.fixed_shape_codec = true;
+    } else if (key == "dirty_bits") {
+      file_options.dirty_bits = true;
+    } else if (key == "table_driven_clear") {
+      file_options.table_driven_clear = true;
+    } else if (key == "oneof_member_cache") {
+      file_options.oneof_member_cache = true;
+    } else if (key == "separate_cc_files") {
+      file_options.separate_cc_files = true;
     } else if (key == "proto_h") {
       file_options.proto_h = true;
     } else if (key == "proto_static_reflection_h") {
@@ -182,6 +198,21 @@ bool CppGenerator::Generate(const FileDescriptor* file,
       } while (pos < value.size());
     } else if (key == "force_eagerly_verified_lazy") {
       file_options.force_eagerly_verified_lazy = true;
+    } else if (key == "force_split") {
+      file_options.force_split = true;
+    } else if (key == "split_fields") {
+      // '+'-separated field full names to place in the lazily-allocated
+      // Split struct (cold storage), e.g.
+      // split_fields=pkg.Msg.rare_blob+pkg.Msg.debug_info.
+      for (absl::string_view name : absl::StrSplit(value, '+')) {
+        if (!name.empty()) {
+          file_options.split_field_names.emplace(name);
+        }
+      }
+    } else if (key == "presence_profile") {
+      // Path to a field-presence profile; see the loading code below for the
+      // format.
+      presence_profile_path = value;
     } else if (key == "experimental_strip_nonfunctional_codegen") {
       file_options.strip_nonfunctional_codegen = true;
     } else {
@@ -190,6 +221,35 @@ bool CppGenerator::Generate(const FileDescriptor* file,
     }
   }
 
+  // Load the field-presence profile, if one was given.  Each line holds a
+  // field full name and an observed presence probability in [0, 1], separated
+  // by whitespace; '#' starts a comment line.  E.g.:
+  //   # field                      presence
+  //   mypkg.MyMessage.hot_field    0.98
+  //   mypkg.MyMessage.debug_field  0.001
+  if (!presence_profile_path.empty()) {
+    std::ifstream profile(presence_profile_path);
+    if (!profile) {
+      *error = absl::StrCat("Could not open presence profile: ",
+                            presence_profile_path);
+      return false;
+    }
+    std::string line;
+    while (std::getline(profile, line)) {
+      absl::string_view entry = absl::StripAsciiWhitespace(line);
+      if (entry.empty() || entry[0] == '#') continue;
+      std::vector<absl::string_view> parts =
+          absl::StrSplit(entry, absl::ByAnyChar(" \t"), absl::SkipEmpty());
+      float probability;
+      if (parts.size() != 2 || !absl::SimpleAtof(parts[1], &probability) ||
+          probability < 0 || probability > 1) {
+        *error = absl::StrCat("Malformed presence profile line: ", line);
+        return false;
+      }
+      file_options.presence_profile[std::string(parts[0])] = probability;
+    }
+  }
+
   // The safe_boundary_check option controls behavior for Google-internal
   // protobuf APIs.
   if (file_options.safe_boundary_check && file_options.opensource_runtime) {
@@ -280,7 +340,8 @@ bool CppGenerator::Generate(const FileDescriptor* file,
   }
 
   // Generate cc file(s).
-  if (UsingImplicitWeakFields(file, file_options)) {
+  if (UsingImplicitWeakFields(file, file_options) ||
+      file_options.separate_cc_files) {
     {
       // This is the global .cc file, containing
       // enum/services/tables/reflection
@@ -8,9 +8,13 @@
 #include "google/protobuf/compiler/cpp/generator.h"
 
 #include <memory>
+#include <string>
 
+#include "google/protobuf/testing/file.h"
 #include "google/protobuf/descriptor.pb.h"
 #include <gtest/gtest.h>
+#include "absl/log/absl_check.h"
+#include "absl/strings/str_cat.h"
 #include "google/protobuf/compiler/command_line_interface_tester.h"
 #include "google/protobuf/cpp_features.pb.h"
 
@@ -144,6 +148,43 @@ TEST_F(CppGeneratorTest, LegacyClosedEnumImplicit) {
       "Field Foo.bar has a closed enum type with implicit presence.");
 }
 
+TEST_F(CppGeneratorTest, SplitFieldsParameter) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Foo {
+      optional int32 hot = 1;
+      optional string cold_blob = 2;
+      repeated int64 cold_samples = 3;
+    })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir "
+      "--cpp_opt=split_fields=Foo.cold_blob+Foo.cold_samples "
+      "--cpp_out=$tmpdir foo.proto");
+
+  ExpectNoErrors();
+}
+
+TEST_F(CppGeneratorTest, ForceSplitParameter) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Foo {
+      optional int32 bar = 1;
+      oneof kind {
+        string name = 2;
+        int32 id = 3;
+      }
+    })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir --cpp_opt=force_split "
+      "--cpp_out=$tmpdir foo.proto");
+
+  ExpectNoErrors();
+}
+
 TEST_F(CppGeneratorTest, AllowStringTypeForEdition2023) {
   CreateTempFile("foo.proto", R"schema(
     edition = "2023";
@@ -285,6 +326,261 @@ TEST_F(CppGeneratorTest, CtypeOnExtensionTest) {
       "Extension bar specifies ctype=CORD which is "
       "not supported for extensions.");
 }
+
+TEST_F(CppGeneratorTest, LazyDescriptorInitializationDropsStaticInit) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Foo {
+      optional int32 bar = 1;
+    })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir --cpp_out=$tmpdir "
+      "--cpp_opt=lazy_descriptor_initialization foo.proto");
+  ExpectNoErrors();
+
+  std::string pb_cc;
+  ABSL_CHECK_OK(File::GetContents(
+      absl::StrCat(temp_directory(), "/foo.pb.cc"), &pb_cc, true));
+  EXPECT_EQ(pb_cc.find("AddDescriptors(&descriptor_table_"),
+            std::string::npos);
+}
+
+TEST_F(CppGeneratorTest, EagerDescriptorInitializationByDefault) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Foo {
+      optional int32 bar = 1;
+    })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir --cpp_out=$tmpdir foo.proto");
+  ExpectNoErrors();
+
+  std::string pb_cc;
+  ABSL_CHECK_OK(File::GetContents(
+      absl::StrCat(temp_directory(), "/foo.pb.cc"), &pb_cc, true));
+  EXPECT_NE(pb_cc.find("AddDescriptors(&descriptor_table_"),
+            std::string::npos);
+}
+TEST_F(CppGeneratorTest, StaticFieldMetadataEmitsMemberPointers) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Foo {
+      optional int32 bar = 1;
+      repeated string baz = 2;
+      oneof kind {
+        int64 fizz = 3;
+      }
+    })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir --cpp_out=$tmpdir foo.proto");
+  ExpectNoErrors();
+
+  std::string pb_h;
+  ABSL_CHECK_OK(File::GetContents(absl::StrCat(temp_directory(), "/foo.pb.h"),
+                                  &pb_h, true));
+  EXPECT_NE(pb_h.find("static constexpr auto internal_field_metadata()"),
+            std::string::npos);
+  // Plain fields carry a pointer to their Impl_ storage member.
+  EXPECT_NE(pb_h.find("\"bar\", 1"), std::string::npos);
+  EXPECT_NE(pb_h.find("&Impl_::bar_"), std::string::npos);
+  EXPECT_NE(pb_h.find("&Impl_::baz_"), std::string::npos);
+  // Oneof members live in a union, so their entry carries nullptr.
+  EXPECT_NE(pb_h.find("\"fizz\", 3"), std::string::npos);
+  EXPECT_EQ(pb_h.find("&Impl_::fizz_"), std::string::npos);
+}
+
+TEST_F(CppGeneratorTest, StaticFieldMetadataSkipsSplitFieldMembers) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Foo {
+      optional int32 hot = 1;
+      optional string cold = 2;
+    })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir --cpp_out=$tmpdir "
+      "--cpp_opt=split_fields=Foo.cold foo.proto");
+  ExpectNoErrors();
+
+  std::string pb_h;
+  ABSL_CHECK_OK(File::GetContents(absl::StrCat(temp_directory(), "/foo.pb.h"),
+                                  &pb_h, true));
+  EXPECT_NE(pb_h.find("&Impl_::hot_"), std::string::npos);
+  // Split fields live behind Impl_::_split_, out of member-pointer reach.
+  EXPECT_EQ(pb_h.find("&Impl_::cold_"), std::string::npos);
+}
+
+TEST_F(CppGeneratorTest, DirtyBitsOptionEmitsTrackingWords) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Foo {
+      optional int32 bar = 1;
+      optional string baz = 2;
+    })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir --cpp_out=$tmpdir "
+      "--cpp_opt=dirty_bits foo.proto");
+  ExpectNoErrors();
+
+  std::string pb_h;
+  ABSL_CHECK_OK(File::GetContents(absl::StrCat(temp_directory(), "/foo.pb.h"),
+                                  &pb_h, true));
+  EXPECT_NE(pb_h.find("_dirty_bits_;"), std::string::npos);
+  EXPECT_NE(pb_h.find("dirty_mask("), std::string::npos);
+  EXPECT_NE(pb_h.find("clear_dirty_mask()"), std::string::npos);
+  // Setters and clearers mark the field's bit in the dirty words.
+  EXPECT_NE(pb_h.find("_impl_._dirty_bits_[0] |= 0x00000001u;"),
+            std::string::npos);
+}
+
+TEST_F(CppGeneratorTest, NoDirtyBitsByDefault) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Foo {
+      optional int32 bar = 1;
+    })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir --cpp_out=$tmpdir foo.proto");
+  ExpectNoErrors();
+
+  std::string pb_h;
+  ABSL_CHECK_OK(File::GetContents(absl::StrCat(temp_directory(), "/foo.pb.h"),
+                                  &pb_h, true));
+  EXPECT_EQ(pb_h.find("_dirty_bits_"), std::string::npos);
+}
+
+TEST_F(CppGeneratorTest, OneofMemberCacheEmitsCacheSlotAndDenseEnum) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Bar {
+      optional int32 x = 1;
+    }
+    message Foo {
+      oneof kind {
+        Bar a = 5;
+        Bar b = 9;
+        int32 c = 12;
+      }
+    })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir --cpp_out=$tmpdir "
+      "--cpp_opt=oneof_member_cache foo.proto");
+  ExpectNoErrors();
+
+  std::string pb_h;
+  ABSL_CHECK_OK(File::GetContents(absl::StrCat(temp_directory(), "/foo.pb.h"),
+                                  &pb_h, true));
+  // One cache slot per oneof with message members.
+  EXPECT_NE(pb_h.find("_kind_cache_;"), std::string::npos);
+  EXPECT_NE(pb_h.find("_kind_cache_case_;"), std::string::npos);
+  // Switching back to a cached member recycles it instead of allocating.
+  EXPECT_NE(pb_h.find("cached->Clear();"), std::string::npos);
+  // Dense declaration-order constants alongside the field-numbered ones.
+  EXPECT_NE(pb_h.find("enum KindCaseIndex {"), std::string::npos);
+  EXPECT_NE(pb_h.find("kAIndex = 1,"), std::string::npos);
+  EXPECT_NE(pb_h.find("kBIndex = 2,"), std::string::npos);
+  EXPECT_NE(pb_h.find("kCIndex = 3,"), std::string::npos);
+  EXPECT_NE(pb_h.find("KIND_INDEX_NOT_SET = 0,"), std::string::npos);
+  EXPECT_NE(pb_h.find("kind_case_index()"), std::string::npos);
+
+  std::string pb_cc;
+  ABSL_CHECK_OK(File::GetContents(absl::StrCat(temp_directory(), "/foo.pb.cc"),
+                                  &pb_cc, true));
+  // clear_kind() stashes the evicted member on arenas.
+  EXPECT_NE(pb_cc.find("_impl_._kind_cache_ ="), std::string::npos);
+}
+
+TEST_F(CppGeneratorTest, NoOneofMemberCacheByDefault) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Bar {
+      optional int32 x = 1;
+    }
+    message Foo {
+      oneof kind {
+        Bar a = 1;
+        Bar b = 2;
+      }
+    })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir --cpp_out=$tmpdir foo.proto");
+  ExpectNoErrors();
+
+  std::string pb_h;
+  ABSL_CHECK_OK(File::GetContents(absl::StrCat(temp_directory(), "/foo.pb.h"),
+                                  &pb_h, true));
+  EXPECT_EQ(pb_h.find("_kind_cache_"), std::string::npos);
+  EXPECT_EQ(pb_h.find("KindCaseIndex"), std::string::npos);
+}
+
+TEST_F(CppGeneratorTest, SeparateCcFilesSplitsSourceByMessage) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Foo {
+      optional int32 bar = 1;
+    }
+    message Baz {
+      optional string qux = 1;
+    })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir --cpp_out=$tmpdir "
+      "--cpp_opt=separate_cc_files foo.proto");
+  ExpectNoErrors();
+
+  // The global file keeps the reflection table; per-message class methods
+  // move to numbered files under foo.out/.
+  std::string pb_cc;
+  ABSL_CHECK_OK(File::GetContents(
+      absl::StrCat(temp_directory(), "/foo.pb.cc"), &pb_cc, true));
+  EXPECT_NE(pb_cc.find("AddDescriptors(&descriptor_table_"),
+            std::string::npos);
+  EXPECT_EQ(pb_cc.find("Foo::MergeImpl"), std::string::npos);
+
+  std::string cc0, cc1;
+  ABSL_CHECK_OK(File::GetContents(
+      absl::StrCat(temp_directory(), "/foo.out/0.cc"), &cc0, true));
+  ABSL_CHECK_OK(File::GetContents(
+      absl::StrCat(temp_directory(), "/foo.out/1.cc"), &cc1, true));
+  EXPECT_NE(cc0.find("Foo::MergeImpl"), std::string::npos);
+  EXPECT_EQ(cc0.find("Baz::MergeImpl"), std::string::npos);
+  EXPECT_NE(cc1.find("Baz::MergeImpl"), std::string::npos);
+}
+
+TEST_F(CppGeneratorTest, SingleCcFileByDefault) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto2";
+    message Foo {
+      optional int32 bar = 1;
+    })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir --cpp_out=$tmpdir foo.proto");
+  ExpectNoErrors();
+
+  std::string pb_cc;
+  ABSL_CHECK_OK(File::GetContents(
+      absl::StrCat(temp_directory(), "/foo.pb.cc"), &pb_cc, true));
+  EXPECT_NE(pb_cc.find("Foo::MergeImpl"), std::string::npos);
+}
+
 }  // namespace
 }  // namespace cpp
 }  // namespace compiler
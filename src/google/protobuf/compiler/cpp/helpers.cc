@@ -925,17 +925,29 @@ bool IsProfileDriven(const Options& options) {
          options.access_info_map != nullptr;
 }
 
+// Thresholds at which a presence-profile entry is strong enough to steer
+// layout decisions that want a yes/no answer (e.g. clear/merge chunking).
+// Fields in between keep the default treatment.
+constexpr float kRarelyPresentThreshold = 0.02f;
+constexpr float kLikelyPresentThreshold = 0.9f;
+
 bool IsRarelyPresent(const FieldDescriptor* field, const Options& options) {
-  return false;
+  auto it = options.presence_profile.find(field->full_name());
+  if (it == options.presence_profile.end()) return false;
+  return it->second <= kRarelyPresentThreshold;
 }
 
 bool IsLikelyPresent(const FieldDescriptor* field, const Options& options) {
-  return false;
+  auto it = options.presence_profile.find(field->full_name());
+  if (it == options.presence_profile.end()) return false;
+  return it->second >= kLikelyPresentThreshold;
 }
 
 float GetPresenceProbability(const FieldDescriptor* field,
                              const Options& options) {
-  return 1.f;
+  auto it = options.presence_profile.find(field->full_name());
+  if (it == options.presence_profile.end()) return 1.f;
+  return it->second;
 }
 
 bool IsStringInliningEnabled(const Options& options) {
@@ -1028,8 +1040,80 @@ VerifySimpleType ShouldVerifySimple(const Descriptor* descriptor) {
   return VerifySimpleType::kCustom;
 }
 
-bool ShouldSplit(const Descriptor*, const Options&) { return false; }
-bool ShouldSplit(const FieldDescriptor*, const Options&) { return false; }
+bool ShouldSplit(const Descriptor* desc, const Options& options) {
+  if (!options.force_split && options.split_field_names.empty()) return false;
+  for (int i = 0; i < desc->field_count(); ++i) {
+    if (ShouldSplit(desc->field(i), options)) return true;
+  }
+  return false;
+}
+
+bool ShouldSplit(const FieldDescriptor* field, const Options& options) {
+  if (!options.force_split &&
+      !options.split_field_names.contains(field->full_name())) {
+    return false;
+  }
+  // Oneof members share the containing union and cannot be moved out of it;
+  // weak and inlined-string representations are likewise tied to the main
+  // instance.
+  if (field->is_extension()) return false;
+  if (field->real_containing_oneof() != nullptr) return false;
+  if (field->options().weak()) return false;
+  if (IsStringInlined(field, options)) return false;
+  return true;
+}
+
+bool IsFixedShapeMessage(const Descriptor* descriptor, const Options& options) {
+  if (!options.fixed_shape_codec) return false;
+  if (descriptor->field_count() == 0) return false;
+  if (descriptor->extension_range_count() > 0) return false;
+  if (descriptor->real_oneof_decl_count() > 0) return false;
+  if (IsMapEntryMessage(descriptor)) return false;
+  if (ShouldSplit(descriptor, options)) return false;
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    const FieldDescriptor* field = descriptor->field(i);
+    if (field->is_repeated()) return false;
+    if (field->cpp_type() == FieldDescriptor::CPPTYPE_STRING ||
+        field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+      return false;
+    }
+    // Explicit presence means absent fields must not be serialized, which the
+    // fixed wire layout cannot express; required fields are always present.
+    if (field->has_presence() && !field->is_required()) return false;
+    if (field->options().weak()) return false;
+  }
+  return true;
+}
+
+bool HasTableDrivenClear(const Descriptor* descriptor, const Options& options,
+                         MessageSCCAnalyzer* scc_analyzer) {
+  if (!options.table_driven_clear) return false;
+  // The interpreters walk the parse table, which only exists alongside the
+  // generated (speed-optimized) methods.
+  if (!HasGeneratedMethods(descriptor->file(), options)) return false;
+  if (descriptor->field_count() == 0) return false;
+  if (descriptor->extension_range_count() > 0) return false;
+  if (descriptor->real_oneof_decl_count() > 0) return false;
+  if (IsMapEntryMessage(descriptor)) return false;
+  if (ShouldSplit(descriptor, options)) return false;
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    const FieldDescriptor* field = descriptor->field(i);
+    if (field->is_map()) return false;
+    if (field->options().weak()) return false;
+    if (field->cpp_type() == FieldDescriptor::CPPTYPE_STRING) {
+      // The interpreters only understand the default ArenaStringPtr
+      // representation with an empty default.
+      if (!IsString(field)) return false;
+      if (IsStringInlined(field, options)) return false;
+      if (!field->default_value_string().empty()) return false;
+    }
+    if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+      if (IsLazy(field, options, scc_analyzer)) return false;
+      if (IsImplicitWeakField(field, options, scc_analyzer)) return false;
+    }
+  }
+  return true;
+}
 
 bool ShouldForceAllocationOnConstruction(const Descriptor* desc,
                                          const Options& options) {
@@ -1539,7 +1623,7 @@ bool UsingImplicitWeakFields(const FileDescriptor* file,
 bool IsImplicitWeakField(const FieldDescriptor* field, const Options& options,
                          MessageSCCAnalyzer* scc_analyzer) {
   return UsingImplicitWeakFields(field->file(), options) &&
-         field->type() == FieldDescriptor::TYPE_MESSAGE &&
+         field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE &&
          !field->is_required() && !field->is_map() && !field->is_extension() &&
          !IsWellKnownMessage(field->message_type()->file()) &&
          field->message_type()->file()->name() !=
@@ -328,6 +328,26 @@ inline bool IsWeak(const FieldDescriptor* field, const Options& options) {
   return false;
 }
 
+// Whether this field participates in its oneof's member cache (see the
+// oneof_member_cache generator option): a non-weak message-typed oneof
+// member whose evicted object can be recycled when the case toggles back.
+inline bool IsOneofCachedField(const FieldDescriptor* field,
+                               const Options& options) {
+  return options.oneof_member_cache &&
+         field->real_containing_oneof() != nullptr &&
+         field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE &&
+         !IsWeak(field, options);
+}
+
+// Whether this oneof carries a member-reuse cache slot.
+inline bool HasOneofMemberCache(const OneofDescriptor* oneof,
+                                const Options& options) {
+  for (int i = 0; i < oneof->field_count(); ++i) {
+    if (IsOneofCachedField(oneof->field(i), options)) return true;
+  }
+  return false;
+}
+
 inline bool IsCord(const FieldDescriptor* field) {
   return field->cpp_type() == FieldDescriptor::CPPTYPE_STRING &&
          internal::cpp::EffectiveStringCType(field) == FieldOptions::CORD;
@@ -435,6 +455,22 @@ bool ShouldSplit(const Descriptor* desc, const Options& options);
 // Is the given field being split out?
 bool ShouldSplit(const FieldDescriptor* field, const Options& options);
 
+// Does the given message qualify for the fixed-shape codec (see
+// generated_message_fixed_shape.h)?  Requires the fixed_shape_codec generator
+// option and a message whose fields are all singular scalars without explicit
+// presence (implicit presence or LEGACY_REQUIRED), with no oneofs and no
+// extension ranges.
+bool IsFixedShapeMessage(const Descriptor* descriptor, const Options& options);
+
+// Should Clear() and MergeFrom() for this message delegate to the shared
+// TcParseTable interpreters (TcParser::ClearMessageFields /
+// MergeMessageFields)?  Requires the table_driven_clear generator option and
+// a message whose fields the interpreters support: no oneofs, extensions,
+// maps, weak, lazy or split fields, and only default-representation strings
+// with empty defaults.
+bool HasTableDrivenClear(const Descriptor* descriptor, const Options& options,
+                         MessageSCCAnalyzer* scc_analyzer);
+
 // Should we generate code that force creating an allocation in the constructor
 // of the given message?
 bool ShouldForceAllocationOnConstruction(const Descriptor* desc,
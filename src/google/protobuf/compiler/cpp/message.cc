@@ -34,6 +34,7 @@
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 #include "google/protobuf/compiler/cpp/enum.h"
 #include "google/protobuf/compiler/cpp/extension.h"
 #include "google/protobuf/compiler/cpp/field.h"
@@ -45,6 +46,7 @@
 #include "google/protobuf/compiler/cpp/tracker.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/descriptor.pb.h"
+#include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/printer.h"
 #include "google/protobuf/wire_format.h"
 #include "google/protobuf/wire_format_lite.h"
@@ -993,6 +995,13 @@ void MessageGenerator::GenerateFieldAccessorDeclarations(io::Printer* p) {
               void $clear_oneof_name$();
               $OneOfName$Case $oneof_name$_case() const;
             )cc");
+    if (options_.oneof_member_cache) {
+      p->Emit({{"oneof_name", oneof->name()},
+               {"OneOfName", UnderscoresToCamelCase(oneof->name(), true)}},
+              R"cc(
+                $OneOfName$CaseIndex $oneof_name$_case_index() const;
+              )cc");
+    }
   }
 }
 
@@ -1359,6 +1368,13 @@ void MessageGenerator::GenerateImplDefinition(io::Printer* p) {
             )cc");
             need_to_emit_cached_size = false;
           }
+          if (options_.dirty_bits) {
+            // Same word layout as _has_bits_; maintained by setters and
+            // clearers, surfaced through dirty_mask().
+            p->Emit({{"sizeof_has_bits", sizeof_has_bits}}, R"cc(
+              ::$proto_ns$::internal::HasBits<$sizeof_has_bits$> _dirty_bits_;
+            )cc");
+          }
         }},
        {"field_members",
         [&] {
@@ -1414,6 +1430,15 @@ void MessageGenerator::GenerateImplDefinition(io::Printer* p) {
                     $oneof_fields$;
                   } $oneof_name$_;
                 )cc");
+            if (HasOneofMemberCache(oneof, options_)) {
+              // The member most recently evicted from the union on an arena,
+              // kept so that switching the case back recycles it.
+              p->Emit({{"oneof_name", oneof->name()}},
+                      R"cc(
+                        ::$proto_ns$::MessageLite* _$oneof_name$_cache_;
+                        $uint32$ _$oneof_name$_cache_case_;
+                      )cc");
+            }
             for (auto field : FieldRange(oneof)) {
               field_generators_.get(field).GenerateStaticMembers(p);
             }
@@ -1670,6 +1695,36 @@ void MessageGenerator::GenerateClassDefinition(io::Printer* p) {
                     $upper_oneof_name$_NOT_SET = 0,
                   };
                 )cc");
+            if (options_.oneof_member_cache) {
+              // A second, dense enumeration in declaration order.  The
+              // *Case constants carry field numbers, which may be sparse;
+              // these values are contiguous so user dispatch over
+              // <oneof>_case_index() compiles to a jump table.
+              p->Emit(
+                  {{"oneof_camel_name",
+                    UnderscoresToCamelCase(oneof->name(), true)},
+                   {"oneof_index_field",
+                    [&] {
+                      int index = 0;
+                      for (auto field : FieldRange(oneof)) {
+                        p->Emit(
+                            {
+                                {"oneof_constant", OneofCaseConstantName(field)},
+                                {"index", ++index},
+                            },
+                            R"cc(
+                              $oneof_constant$Index = $index$,
+                            )cc");
+                      }
+                    }},
+                   {"upper_oneof_name", absl::AsciiStrToUpper(oneof->name())}},
+                  R"cc(
+                    enum $oneof_camel_name$CaseIndex {
+                      $oneof_index_field$,
+                      $upper_oneof_name$_INDEX_NOT_SET = 0,
+                    };
+                  )cc");
+            }
           }
         }},
        {"index_in_file_messages", index_in_file_messages_},
@@ -1854,6 +1909,158 @@ void MessageGenerator::GenerateClassDefinition(io::Printer* p) {
        {"proto2_message_sets",
         [&] {
         }},
+       {"presence_api",
+        [&] {
+          if (has_bit_indices_.empty()) return;
+          p->Emit(
+              {{"presence_cases",
+                [&] {
+                  for (auto field : FieldRange(descriptor_)) {
+                    int has_bit_index = HasBitIndex(field);
+                    if (has_bit_index == kNoHasbit) continue;
+                    p->Emit({{"number", field->number()},
+                             {"index", has_bit_index}},
+                            R"cc(
+                              case $number$:
+                                return $index$;
+                            )cc");
+                  }
+                }}},
+              R"cc(
+                // Presence-bitmap helpers.  presence_bit_index() maps a field
+                // number to its bit in the internal presence bitmap, or -1 for
+                // fields that do not track presence with a has-bit.  The bit
+                // assignment is fixed for a given generated file but may
+                // change whenever the message or the code generator changes,
+                // so masks over the bitmap must be built through
+                // presence_bit_index() rather than hard-coded.
+                static constexpr int presence_bit_index(int field_number) {
+                  switch (field_number) {
+                    $presence_cases$;
+                    default:
+                      return -1;
+                  }
+                }
+                // Returns word `word_index` of the presence bitmap; the bit
+                // for field N is bit presence_bit_index(N) % 32 of word
+                // presence_bit_index(N) / 32.
+                ::uint32_t presence_mask(int word_index = 0) const {
+                  return _impl_._has_bits_[word_index];
+                }
+                // Branchless presence tests over several fields at once:
+                // whether all (resp. any) of the given fields are present.
+                // Every field number must track presence, i.e. satisfy
+                // presence_bit_index(N) >= 0.  The tests reduce to mask
+                // compares of the presence words.
+                template <int... kFieldNumbers>
+                bool HasAll() const {
+                  static_assert(sizeof...(kFieldNumbers) > 0,
+                                "HasAll() requires at least one field number");
+                  static_assert(
+                      ::$proto_ns$::internal::AllNonNegative(
+                          {presence_bit_index(kFieldNumbers)...}),
+                      "every field passed to HasAll() must have explicit "
+                      "presence");
+                  static constexpr auto mask =
+                      decltype(_impl_._has_bits_)::FromIndexes(
+                          {static_cast<::uint32_t>(
+                              presence_bit_index(kFieldNumbers))...});
+                  return _impl_._has_bits_.TestAll(mask);
+                }
+                template <int... kFieldNumbers>
+                bool HasAny() const {
+                  static_assert(sizeof...(kFieldNumbers) > 0,
+                                "HasAny() requires at least one field number");
+                  static_assert(
+                      ::$proto_ns$::internal::AllNonNegative(
+                          {presence_bit_index(kFieldNumbers)...}),
+                      "every field passed to HasAny() must have explicit "
+                      "presence");
+                  static constexpr auto mask =
+                      decltype(_impl_._has_bits_)::FromIndexes(
+                          {static_cast<::uint32_t>(
+                              presence_bit_index(kFieldNumbers))...});
+                  return _impl_._has_bits_.TestAny(mask);
+                }
+              )cc");
+        }},
+       {"dirty_api",
+        [&] {
+          if (!options_.dirty_bits || has_bit_indices_.empty()) return;
+          p->Emit(R"cc(
+            // Mutation-tracking helpers (dirty_bits generator option).  The
+            // dirty words share the bit assignment of the presence bitmap:
+            // the bit for field N is presence_bit_index(N).  Bits start
+            // clear on construction and are set by setters and clearers;
+            // parsing, Clear() and MergeFrom() do not maintain them.  The
+            // intended protocol is: compute ByteSizeLong(), call
+            // clear_dirty_mask(), and as long as dirty_mask() stays zero for
+            // every word the cached sizes remain valid for
+            // SerializePartialToArrayUsingCachedSizes().
+            ::uint32_t dirty_mask(int word_index = 0) const {
+              return _impl_._dirty_bits_[word_index];
+            }
+            void clear_dirty_mask() { _impl_._dirty_bits_.Clear(); }
+          )cc");
+        }},
+       {"static_field_metadata",
+        [&] {
+          p->Emit(
+              {{"field_metadata_entries",
+                [&] {
+                  bool first = true;
+                  for (auto field : FieldRange(descriptor_)) {
+                    if (!first) p->Emit(",\n");
+                    first = false;
+                    //~ Only fields whose storage is a direct Impl_ member get
+                    //~ a member pointer; oneof members live in a union and
+                    //~ split/weak fields live behind an indirection.
+                    const bool direct_member =
+                        field->real_containing_oneof() == nullptr &&
+                        !ShouldSplit(field, options_) &&
+                        !field->options().weak();
+                    p->Emit(
+                        {{"name", FieldName(field)},
+                         {"number", field->number()},
+                         {"type", static_cast<int>(field->type())},
+                         {"member",
+                          direct_member
+                              ? absl::StrCat("&Impl_::", FieldName(field), "_")
+                              : "nullptr"}},
+                        R"cc(
+                          $pbi$::MakeFieldMetadataEntry("$name$", $number$,
+                                                        $type$, $member$))cc");
+                  }
+                }},
+               {"field_ref",
+                [&] {
+                  if (!HasImplData(descriptor_, options_)) return;
+                  p->Emit(R"cc(
+                    // Resolves a metadata entry's member pointer against this
+                    // message.  The reference designates the field's storage:
+                    // scalar and repeated fields yield their value type, while
+                    // string, message and map fields yield the internal
+                    // representation that backs their accessors.
+                    template <typename T, typename C>
+                    const T& internal_field_ref(T C::* member) const {
+                      return _impl_.*member;
+                    }
+                  )cc");
+                }}},
+              R"cc(
+                // Compile-time field metadata: a constexpr tuple with one
+                // entry per field, in declaration order, for templates that
+                // visit fields at compile time.  Each entry carries the
+                // field's unqualified name, number, declared type
+                // (FieldDescriptor::Type as an int) and, where the storage is
+                // a direct member of the message, a pointer to that member;
+                // see FieldMetadataEntry in generated_message_util.h.
+                static constexpr auto internal_field_metadata() {
+                  return std::make_tuple($field_metadata_entries$);
+                }
+                $field_ref$;
+              )cc");
+        }},
        {"decl_set_has",
         [&] {
           for (auto field : FieldRange(descriptor_)) {
@@ -1896,6 +2103,16 @@ void MessageGenerator::GenerateClassDefinition(io::Printer* p) {
                   R"cc(
                     friend struct $split_default$;
                   )cc");
+        }},
+       {"fixed_shape_friend",
+        [&] {
+          if (!IsFixedShapeMessage(descriptor_, options_)) return;
+
+          //~ The FixedShapeTraits specialization needs access to the private
+          //~ field members in order to compute their offsets.
+          p->Emit(R"cc(
+            friend struct ::$proto_ns$::internal::FixedShapeTraits<$classname$>;
+          )cc");
         }}},
       R"cc(
         class $dllexport_decl $$classname$ final : public $superclass$
@@ -2014,6 +2231,9 @@ void MessageGenerator::GenerateClassDefinition(io::Printer* p) {
           $decl_field_accessors$;
           $decl_extension_ids$;
           $proto2_message_sets$;
+          $presence_api$;
+          $dirty_api$;
+          $static_field_metadata$;
           // @@protoc_insertion_point(class_scope:$full_name$)
           //~ Generate private members.
          private:
@@ -2036,6 +2256,7 @@ void MessageGenerator::GenerateClassDefinition(io::Printer* p) {
           using DestructorSkippable_ = void;
           $decl_impl$;
           $split_friend$;
+          $fixed_shape_friend$;
           //~ The TableStruct struct needs access to the private parts, in
           //~ order to construct the offsets of all members.
           friend struct ::$tablename$;
@@ -2064,9 +2285,116 @@ void MessageGenerator::GenerateInlineMethods(io::Printer* p) {
             return $classname$::$OneofName$($oneof_case$[$oneof_index$]);
           }
         )cc");
+    if (options_.oneof_member_cache) {
+      p->Emit(
+          {
+              {"oneof_name", oneof->name()},
+              {"OneofCaseIndex",
+               absl::StrCat(UnderscoresToCamelCase(oneof->name(), true),
+                            "CaseIndex")},
+              {"upper_oneof_name", absl::AsciiStrToUpper(oneof->name())},
+              {"index_cases",
+               [&] {
+                 for (auto field : FieldRange(oneof)) {
+                   p->Emit(
+                       {{"oneof_constant", OneofCaseConstantName(field)}},
+                       R"cc(
+                         case $oneof_constant$:
+                           return $oneof_constant$Index;
+                       )cc");
+                 }
+               }},
+          },
+          R"cc(
+            inline $classname$::$OneofCaseIndex$ $classname$::$oneof_name$_case_index() const {
+              switch ($oneof_name$_case()) {
+                $index_cases$;
+                default:
+                  return $upper_oneof_name$_INDEX_NOT_SET;
+              }
+            }
+          )cc");
+    }
+  }
+}
+
+namespace {
+
+// Maps a fixed-shape field to the FixedShapeFieldType enumerator naming its
+// wire encoding.  Only called for fields that passed IsFixedShapeMessage.
+absl::string_view FixedShapeTypeName(const FieldDescriptor* field) {
+  switch (field->type()) {
+    case FieldDescriptor::TYPE_INT32:
+    case FieldDescriptor::TYPE_ENUM:
+      return "kVarint32";
+    case FieldDescriptor::TYPE_INT64:
+      return "kVarint64";
+    case FieldDescriptor::TYPE_UINT32:
+      return "kVarintU32";
+    case FieldDescriptor::TYPE_UINT64:
+      return "kVarintU64";
+    case FieldDescriptor::TYPE_SINT32:
+      return "kZigZag32";
+    case FieldDescriptor::TYPE_SINT64:
+      return "kZigZag64";
+    case FieldDescriptor::TYPE_FIXED32:
+    case FieldDescriptor::TYPE_SFIXED32:
+    case FieldDescriptor::TYPE_FLOAT:
+      return "kFixed32";
+    case FieldDescriptor::TYPE_FIXED64:
+    case FieldDescriptor::TYPE_SFIXED64:
+    case FieldDescriptor::TYPE_DOUBLE:
+      return "kFixed64";
+    case FieldDescriptor::TYPE_BOOL:
+      return "kBool";
+    default:
+      ABSL_LOG(FATAL) << "Non-scalar field in fixed-shape message: "
+                      << field->full_name();
+      return "";
   }
 }
 
+}  // namespace
+
+void MessageGenerator::GenerateFixedShapeTraits(io::Printer* p) {
+  if (!IsFixedShapeMessage(descriptor_, options_)) return;
+
+  auto v = p->WithVars(ClassVars(descriptor_, options_));
+  std::vector<const FieldDescriptor*> ordered_fields =
+      SortFieldsByNumber(descriptor_);
+  p->Emit(
+      {{"field_count", descriptor_->field_count()},
+       {"entries",
+        [&] {
+          for (const FieldDescriptor* field : ordered_fields) {
+            p->Emit(
+                {{"tag", ::google::protobuf::internal::WireFormat::MakeTag(
+                      field)},
+                 {"member", FieldMemberName(field, /*split=*/false)},
+                 {"tag_size", ::google::protobuf::internal::WireFormat::TagSize(
+                      field->number(), field->type())},
+                 {"type", FixedShapeTypeName(field)}},
+                R"cc(
+                  {$tag$, PROTOBUF_FIELD_OFFSET($classtype$, $member$),
+                   $tag_size$, FixedShapeFieldType::$type$},
+                )cc");
+          }
+        }}},
+      R"cc(
+        template <>
+        struct FixedShapeTraits<$classtype$> {
+          static constexpr bool value = true;
+          static constexpr int field_count = $field_count$;
+          static const FixedShapeField* fields() {
+            static constexpr FixedShapeField kFields[$field_count$] = {
+                $entries$,
+            };
+            return kFields;
+          }
+        };
+      )cc");
+}
+
 void MessageGenerator::GenerateSchema(io::Printer* p, int offset,
                                       int has_offset) {
   has_offset = !has_bit_indices_.empty() || IsMapEntryMessage(descriptor_)
@@ -2516,6 +2844,14 @@ void MessageGenerator::GenerateImplMemberInit(io::Printer* p,
     for (auto oneof : OneOfRange(descriptor_)) {
       separator();
       p->Emit({{"name", oneof->name()}}, "$name$_{}");
+      if (HasOneofMemberCache(oneof, options_)) {
+        // The cache always starts empty, even when copying: the source's
+        // cached object belongs to its arena.
+        separator();
+        p->Emit({{"name", oneof->name()}}, "_$name$_cache_{nullptr}");
+        separator();
+        p->Emit({{"name", oneof->name()}}, "_$name$_cache_case_{}");
+      }
     }
   };
 
@@ -3146,6 +3482,19 @@ void MessageGenerator::GenerateSourceInProto2Namespace(io::Printer* p) {
 
 void MessageGenerator::GenerateClear(io::Printer* p) {
   if (HasSimpleBaseClass(descriptor_, options_)) return;
+  if (HasTableDrivenClear(descriptor_, options_, scc_analyzer_)) {
+    // The shared interpreter supports every field of this message; emit a
+    // compact body instead of the unrolled chunked clear below.
+    p->Emit(R"cc(
+      PROTOBUF_NOINLINE void $classname$::Clear() {
+        // @@protoc_insertion_point(message_clear_start:$full_name$)
+        $pbi$::TSanWrite(&_impl_);
+        $pbi$::TcParser::ClearMessageFields(this, &_table_.header);
+        _internal_metadata_.Clear<$unknown_fields_type$>();
+      }
+    )cc");
+    return;
+  }
   Formatter format(p);
 
   // The maximum number of bytes we will memset to zero without checking their
@@ -3423,6 +3772,14 @@ void MessageGenerator::GenerateSwap(io::Printer* p) {
       for (int i = 0; i < HasBitsSize(); ++i) {
         format("swap($has_bits$[$1$], other->$has_bits$[$1$]);\n", i);
       }
+      if (options_.dirty_bits) {
+        for (int i = 0; i < HasBitsSize(); ++i) {
+          format(
+              "swap(_impl_._dirty_bits_[$1$], "
+              "other->_impl_._dirty_bits_[$1$]);\n",
+              i);
+        }
+      }
     }
 
     // If possible, we swap several fields at once, including padding.
@@ -3475,6 +3832,12 @@ void MessageGenerator::GenerateSwap(io::Printer* p) {
 
     for (auto oneof : OneOfRange(descriptor_)) {
       format("swap(_impl_.$1$_, other->_impl_.$1$_);\n", oneof->name());
+      if (HasOneofMemberCache(oneof, options_)) {
+        format(
+            "swap(_impl_._$1$_cache_, other->_impl_._$1$_cache_);\n"
+            "swap(_impl_._$1$_cache_case_, other->_impl_._$1$_cache_case_);\n",
+            oneof->name());
+      }
     }
 
     for (int i = 0; i < descriptor_->real_oneof_decl_count(); i++) {
@@ -3659,6 +4022,24 @@ void MessageGenerator::GenerateClassSpecificMergeImpl(io::Printer* p) {
         "  auto& from = static_cast<const $classname$&>(from_msg);\n");
   }
   format.Indent();
+  if (HasTableDrivenClear(descriptor_, options_, scc_analyzer_)) {
+    // Delegate the field-by-field merge to the shared interpreter; only
+    // unknown fields stay in generated code (the table cannot reach the
+    // internal metadata).
+    format(
+        "$annotate_mergefrom$"
+        "// @@protoc_insertion_point(class_specific_merge_from_start:"
+        "$full_name$)\n");
+    format("$DCHK$_NE(&from, _this);\n");
+    format(
+        "$pbi$::TcParser::MergeMessageFields(from, _this, &_table_.header);\n"
+        "_this->_internal_metadata_.MergeFrom<$unknown_fields_type$>(from._"
+        "internal_"
+        "metadata_);\n");
+    format.Outdent();
+    format("}\n");
+    return;
+  }
   if (RequiresArena(GeneratorFunction::kMergeFrom)) {
     p->Emit(R"cc(
       ::$proto_ns$::Arena* arena = _this->GetArena();
@@ -3714,6 +4095,17 @@ void MessageGenerator::GenerateClassSpecificMergeImpl(io::Printer* p) {
                cached_has_word_index);
       }
 
+      // A chunk of contiguous trivially-copyable fields can be merged with a
+      // single span copy when every field in it is present in `from`, which
+      // is the common case for always-populated scalar groups.  The else
+      // branch below falls back to per-field merging for partial presence.
+      const bool emit_bulk_copy =
+          check_has_byte && !ShouldSplit(fields.front(), options_) &&
+          std::all_of(fields.begin(), fields.end(),
+                      [&](const FieldDescriptor* field) {
+                        return IsPOD(field) && !field->options().weak();
+                      });
+
       if (check_has_byte) {
         // Emit an if() that will let us skip the whole chunk if none are set.
         uint32_t chunk_mask = GenChunkMask(fields, has_bit_indices_);
@@ -3726,8 +4118,31 @@ void MessageGenerator::GenerateClassSpecificMergeImpl(io::Printer* p) {
         ABSL_DCHECK_LE(2, popcnt(chunk_mask));
         ABSL_DCHECK_GE(8, popcnt(chunk_mask));
 
-        format("if (cached_has_bits & 0x$1$u) {\n", chunk_mask_str);
-        format.Indent();
+        if (emit_bulk_copy) {
+          format("if ((cached_has_bits & 0x$1$u) == 0x$1$u) {\n",
+                 chunk_mask_str);
+          format.Indent();
+          format(
+              "// All fields in this chunk are present in from: copy the\n"
+              "// contiguous span at once instead of field by field.\n");
+          p->Emit({{"first", FieldName(fields.front())},
+                   {"last", FieldName(fields.back())}},
+                  R"cc(
+                    ::memcpy(reinterpret_cast<char*>(&_this->_impl_) +
+                                 offsetof(Impl_, $first$_),
+                             reinterpret_cast<const char*>(&from._impl_) +
+                                 offsetof(Impl_, $first$_),
+                             offsetof(Impl_, $last$_) -
+                                 offsetof(Impl_, $first$_) +
+                                 sizeof(Impl_::$last$_));
+                  )cc");
+          format.Outdent();
+          format("} else if (cached_has_bits & 0x$1$u) {\n", chunk_mask_str);
+          format.Indent();
+        } else {
+          format("if (cached_has_bits & 0x$1$u) {\n", chunk_mask_str);
+          format.Indent();
+        }
       }
 
       // Go back and emit merging code for each of the fields we processed.
@@ -3977,10 +4392,16 @@ void MessageGenerator::GenerateSerializeOneofFields(
 
 void MessageGenerator::GenerateSerializeOneField(io::Printer* p,
                                                  const FieldDescriptor* field,
-                                                 int cached_has_bits_index) {
+                                                 int cached_has_bits_index,
+                                                 bool space_ensured) {
   auto v = p->WithVars(FieldVars(field, options_));
   auto emit_body = [&] {
-    field_generators_.get(field).GenerateSerializeWithCachedSizesToArray(p);
+    if (space_ensured) {
+      field_generators_.get(field)
+          .GenerateSerializeWithCachedSizesToArrayNoEnsureSpace(p);
+    } else {
+      field_generators_.get(field).GenerateSerializeWithCachedSizesToArray(p);
+    }
   };
 
   if (field->options().weak()) {
@@ -4109,7 +4530,7 @@ void MessageGenerator::GenerateSerializeWithCachedSizesBody(io::Printer* p) {
 
     // If conditions allow, try to accumulate a run of fields from the same
     // oneof, and handle them at the next Flush().
-    void Emit(const FieldDescriptor* field) {
+    void Emit(const FieldDescriptor* field, bool space_ensured = false) {
       if (!field->has_presence() || MustFlush(field)) {
         Flush();
       }
@@ -4133,7 +4554,8 @@ void MessageGenerator::GenerateSerializeWithCachedSizesBody(io::Printer* p) {
           }
         }
 
-        mg_->GenerateSerializeOneField(p_, field, cached_has_bit_index_);
+        mg_->GenerateSerializeOneField(p_, field, cached_has_bit_index_,
+                                       space_ensured);
       }
     }
 
@@ -4232,6 +4654,58 @@ void MessageGenerator::GenerateSerializeWithCachedSizesBody(io::Printer* p) {
   }
   std::sort(sorted_extensions.begin(), sorted_extensions.end(),
             ExtensionRangeSorter());
+
+  // EnsureSpace() guarantees kSlopBytes writable bytes, so a run of adjacent
+  // fixed-size scalar fields whose combined worst-case size fits within that
+  // budget needs only one check up front; each field in the run then writes
+  // straight to the buffer.  Runs break at oneofs, weak fields and extension
+  // ranges, which serialize through their own paths.
+  constexpr size_t kSlopBytes = io::EpsCopyOutputStream::kSlopBytes;
+  std::vector<bool> starts_ensured_run(ordered_fields.size(), false);
+  std::vector<bool> in_ensured_run(ordered_fields.size(), false);
+  auto fixed_serialized_size =
+      [&](const FieldDescriptor* field) -> absl::optional<size_t> {
+    if (field->options().weak() || field->real_containing_oneof()) {
+      return absl::nullopt;
+    }
+    return field_generators_.get(field).FixedSerializedSize();
+  };
+  {
+    size_t ext = 0;
+    size_t i = 0;
+    while (i < ordered_fields.size()) {
+      while (ext < sorted_extensions.size() &&
+             sorted_extensions[ext]->start_number() <
+                 ordered_fields[i]->number()) {
+        ++ext;
+      }
+      absl::optional<size_t> size = fixed_serialized_size(ordered_fields[i]);
+      if (!size.has_value() || *size > kSlopBytes) {
+        ++i;
+        continue;
+      }
+      size_t budget = *size;
+      size_t run_end = i + 1;
+      while (run_end < ordered_fields.size()) {
+        if (ext < sorted_extensions.size() &&
+            sorted_extensions[ext]->start_number() <
+                ordered_fields[run_end]->number()) {
+          break;
+        }
+        absl::optional<size_t> next_size =
+            fixed_serialized_size(ordered_fields[run_end]);
+        if (!next_size.has_value() || budget + *next_size > kSlopBytes) break;
+        budget += *next_size;
+        ++run_end;
+      }
+      if (run_end - i >= 2) {
+        starts_ensured_run[i] = true;
+        for (size_t k = i; k < run_end; ++k) in_ensured_run[k] = true;
+      }
+      i = run_end;
+    }
+  }
+
   p->Emit(
       {
           {"handle_weak_fields",
@@ -4254,6 +4728,7 @@ void MessageGenerator::GenerateSerializeWithCachedSizesBody(io::Printer* p) {
                    (i < descriptor_->field_count() &&
                     ordered_fields[i]->number() <
                         sorted_extensions[j]->start_number())) {
+                 const size_t field_index = i;
                  const FieldDescriptor* field = ordered_fields[i++];
                  re.Flush();
                  if (field->options().weak()) {
@@ -4261,7 +4736,13 @@ void MessageGenerator::GenerateSerializeWithCachedSizesBody(io::Printer* p) {
                    PrintFieldComment(Formatter{p}, field, options_);
                  } else {
                    e.EmitIfNotNull(largest_weak_field.Release());
-                   e.Emit(field);
+                   if (starts_ensured_run[field_index]) {
+                     e.Flush();
+                     p->Emit(R"cc(
+                       target = stream->EnsureSpace(target);
+                     )cc");
+                   }
+                   e.Emit(field, in_ensured_run[field_index]);
                  }
                } else {
                  e.EmitIfNotNull(largest_weak_field.Release());
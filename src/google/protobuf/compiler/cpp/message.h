@@ -62,6 +62,11 @@ class MessageGenerator {
   // file).
   void GenerateInlineMethods(io::Printer* p);
 
+  // Generate the FixedShapeTraits specialization for this message (placed in
+  // the google::protobuf::internal namespace at the end of the header file).
+  // No-op unless the message qualifies for the fixed-shape codec.
+  void GenerateFixedShapeTraits(io::Printer* p);
+
   // Generate all non-inline methods for this class.
   void GenerateClassMethods(io::Printer* p);
 
@@ -137,8 +142,12 @@ class MessageGenerator {
   // cached_has_bit_index maintains that:
   //   cached_has_bits = _has_bits_[cached_has_bit_index]
   // for cached_has_bit_index >= 0
+  // If space_ensured is true, the caller has already emitted an EnsureSpace()
+  // call covering this field's worst-case serialized size, so the field's
+  // serializer may write without its own check.
   void GenerateSerializeOneField(io::Printer* p, const FieldDescriptor* field,
-                                 int cached_has_bits_index);
+                                 int cached_has_bits_index,
+                                 bool space_ensured = false);
   // Generate a switch statement to serialize 2+ fields from the same oneof.
   // Or, if fields.size() == 1, just call GenerateSerializeOneField().
   void GenerateSerializeOneofFields(
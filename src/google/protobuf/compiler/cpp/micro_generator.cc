@@ -0,0 +1,1045 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/compiler/cpp/micro_generator.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_replace.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/substitute.h"
+#include "google/protobuf/compiler/cpp/helpers.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/io/printer.h"
+#include "google/protobuf/io/strtod.h"
+#include "google/protobuf/io/zero_copy_stream.h"
+#include "google/protobuf/wire_format.h"
+#include "google/protobuf/wire_format_lite.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace compiler {
+namespace cpp {
+namespace {
+
+using ::google::protobuf::internal::WireFormat;
+using ::google::protobuf::internal::WireFormatLite;
+
+// Wire helpers emitted verbatim into every generated header.  The block is
+// include-guarded so that any number of micro headers can coexist in one
+// translation unit; all copies are textually identical.
+constexpr absl::string_view kWireHelpers = R"(
+// Self-contained wire helpers shared by all micro runtime headers.  Every
+// generated header carries an identical copy guarded by this macro, so any
+// one of them may be included first.
+#ifndef GOOGLE_PROTOBUF_MICRO_WIRE_HELPERS_INCLUDED
+#define GOOGLE_PROTOBUF_MICRO_WIRE_HELPERS_INCLUDED
+
+namespace google {
+namespace protobuf {
+namespace micro {
+
+// Reads a varint of at most 10 bytes.  Returns a pointer past the varint, or
+// nullptr on truncated or over-long input.
+inline const char* ReadVarint(const char* ptr, const char* end,
+                              uint64_t* out) {
+  uint64_t result = 0;
+  for (int shift = 0; shift < 70 && ptr < end; shift += 7) {
+    const uint64_t byte = static_cast<uint8_t>(*ptr++);
+    result |= (byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      *out = result;
+      return ptr;
+    }
+  }
+  return nullptr;
+}
+
+inline const char* ReadFixed32(const char* ptr, const char* end,
+                               uint32_t* out) {
+  if (end - ptr < 4) return nullptr;
+  *out = static_cast<uint32_t>(static_cast<uint8_t>(ptr[0])) |
+         static_cast<uint32_t>(static_cast<uint8_t>(ptr[1])) << 8 |
+         static_cast<uint32_t>(static_cast<uint8_t>(ptr[2])) << 16 |
+         static_cast<uint32_t>(static_cast<uint8_t>(ptr[3])) << 24;
+  return ptr + 4;
+}
+
+inline const char* ReadFixed64(const char* ptr, const char* end,
+                               uint64_t* out) {
+  uint32_t lo, hi;
+  if ((ptr = ReadFixed32(ptr, end, &lo)) == nullptr) return nullptr;
+  if ((ptr = ReadFixed32(ptr, end, &hi)) == nullptr) return nullptr;
+  *out = static_cast<uint64_t>(lo) | static_cast<uint64_t>(hi) << 32;
+  return ptr;
+}
+
+inline char* WriteVarint(uint64_t value, char* target) {
+  while (value >= 0x80) {
+    *target++ = static_cast<char>(value | 0x80);
+    value >>= 7;
+  }
+  *target++ = static_cast<char>(value);
+  return target;
+}
+
+inline char* WriteFixed32(uint32_t value, char* target) {
+  for (int i = 0; i < 4; ++i) {
+    *target++ = static_cast<char>(value >> (8 * i));
+  }
+  return target;
+}
+
+inline char* WriteFixed64(uint64_t value, char* target) {
+  target = WriteFixed32(static_cast<uint32_t>(value), target);
+  return WriteFixed32(static_cast<uint32_t>(value >> 32), target);
+}
+
+inline size_t VarintSize(uint64_t value) {
+  size_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    ++size;
+  }
+  return size;
+}
+
+inline uint32_t ZigZagEncode32(int32_t value) {
+  return (static_cast<uint32_t>(value) << 1) ^
+         static_cast<uint32_t>(value >> 31);
+}
+
+inline int32_t ZigZagDecode32(uint32_t value) {
+  return static_cast<int32_t>((value >> 1) ^ (~(value & 1) + 1));
+}
+
+inline uint64_t ZigZagEncode64(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^
+         static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t ZigZagDecode64(uint64_t value) {
+  return static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+}
+
+inline float BitsToFloat(uint32_t bits) {
+  float result;
+  std::memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
+inline uint32_t FloatToBits(float value) {
+  uint32_t result;
+  std::memcpy(&result, &value, sizeof(result));
+  return result;
+}
+
+inline double BitsToDouble(uint64_t bits) {
+  double result;
+  std::memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
+inline uint64_t DoubleToBits(double value) {
+  uint64_t result;
+  std::memcpy(&result, &value, sizeof(result));
+  return result;
+}
+
+// Skips an unknown field.  Returns nullptr on malformed input or on group
+// wire types, which the micro runtime does not support.
+inline const char* SkipField(uint32_t tag, const char* ptr, const char* end) {
+  switch (tag & 7) {
+    case 0: {
+      uint64_t unused;
+      return ReadVarint(ptr, end, &unused);
+    }
+    case 1:
+      return end - ptr < 8 ? nullptr : ptr + 8;
+    case 2: {
+      uint64_t length;
+      ptr = ReadVarint(ptr, end, &length);
+      if (ptr == nullptr || length > static_cast<uint64_t>(end - ptr)) {
+        return nullptr;
+      }
+      return ptr + length;
+    }
+    case 5:
+      return end - ptr < 4 ? nullptr : ptr + 4;
+    default:
+      return nullptr;
+  }
+}
+
+}  // namespace micro
+}  // namespace protobuf
+}  // namespace google
+
+#endif  // GOOGLE_PROTOBUF_MICRO_WIRE_HELPERS_INCLUDED
+)";
+
+// Flattened C++ name of a message or enum defined in `file`: the package
+// prefix is dropped and nesting dots become underscores, mirroring the
+// Foo_Bar names the full C++ generator uses before aliasing them into class
+// scope.
+std::string MicroName(absl::string_view full_name, const FileDescriptor* file) {
+  absl::string_view package = file->package();
+  if (!package.empty()) full_name.remove_prefix(package.size() + 1);
+  return absl::StrReplaceAll(full_name, {{".", "_"}});
+}
+
+std::string MessageName(const Descriptor* descriptor) {
+  return MicroName(descriptor->full_name(), descriptor->file());
+}
+
+std::string EnumName(const EnumDescriptor* descriptor) {
+  return MicroName(descriptor->full_name(), descriptor->file());
+}
+
+// Enum value constants are emitted at namespace scope, so values of nested
+// enums are prefixed with the containing message name to keep them unique.
+std::string EnumValueName(const EnumValueDescriptor* value) {
+  const Descriptor* parent = value->type()->containing_type();
+  if (parent != nullptr) {
+    return absl::StrCat(MessageName(parent), "_", value->name());
+  }
+  return std::string(value->name());
+}
+
+// C++ type of a single element of the field.
+std::string ElementType(const FieldDescriptor* field) {
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      return "int32_t";
+    case FieldDescriptor::CPPTYPE_UINT32:
+      return "uint32_t";
+    case FieldDescriptor::CPPTYPE_INT64:
+      return "int64_t";
+    case FieldDescriptor::CPPTYPE_UINT64:
+      return "uint64_t";
+    case FieldDescriptor::CPPTYPE_BOOL:
+      return "bool";
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      return "float";
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      return "double";
+    case FieldDescriptor::CPPTYPE_ENUM:
+      return EnumName(field->enum_type());
+    case FieldDescriptor::CPPTYPE_STRING:
+      return "std::string";
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      return MessageName(field->message_type());
+  }
+  return "";
+}
+
+// C++ literal for the field's default value.
+std::string MicroDefaultValue(const FieldDescriptor* field) {
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      return absl::StrCat(field->default_value_int32());
+    case FieldDescriptor::CPPTYPE_UINT32:
+      return absl::StrCat(field->default_value_uint32(), "u");
+    case FieldDescriptor::CPPTYPE_INT64:
+      return absl::StrCat("int64_t{", field->default_value_int64(), "}");
+    case FieldDescriptor::CPPTYPE_UINT64:
+      return absl::StrCat("uint64_t{", field->default_value_uint64(), "u}");
+    case FieldDescriptor::CPPTYPE_BOOL:
+      return field->default_value_bool() ? "true" : "false";
+    case FieldDescriptor::CPPTYPE_FLOAT: {
+      std::string value = io::SimpleFtoa(field->default_value_float());
+      if (value.find_first_of(".eE") != std::string::npos) {
+        value.push_back('f');
+      }
+      return value;
+    }
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      return io::SimpleDtoa(field->default_value_double());
+    case FieldDescriptor::CPPTYPE_ENUM:
+      return EnumValueName(field->default_value_enum());
+    case FieldDescriptor::CPPTYPE_STRING:
+      return absl::StrCat(
+          "\"", EscapeTrigraphs(absl::CEscape(field->default_value_string())),
+          "\"");
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      break;
+  }
+  return "";
+}
+
+// Tag of a single (non-packed) element; WireFormat::MakeTag() would return
+// the length-delimited tag for packed fields, which is emitted separately.
+uint32_t FieldTag(const FieldDescriptor* field) {
+  return WireFormatLite::MakeTag(field->number(),
+                                 WireFormat::WireTypeForFieldType(field->type()));
+}
+
+uint32_t PackedTag(const FieldDescriptor* field) {
+  return WireFormatLite::MakeTag(field->number(),
+                                 WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+}
+
+size_t TagSize(uint32_t tag) {
+  size_t size = 1;
+  while (tag >= 0x80) {
+    tag >>= 7;
+    ++size;
+  }
+  return size;
+}
+
+bool IsFixed32(const FieldDescriptor* field) {
+  return field->type() == FieldDescriptor::TYPE_FIXED32 ||
+         field->type() == FieldDescriptor::TYPE_SFIXED32 ||
+         field->type() == FieldDescriptor::TYPE_FLOAT;
+}
+
+bool IsFixed64(const FieldDescriptor* field) {
+  return field->type() == FieldDescriptor::TYPE_FIXED64 ||
+         field->type() == FieldDescriptor::TYPE_SFIXED64 ||
+         field->type() == FieldDescriptor::TYPE_DOUBLE;
+}
+
+// Statements that read one scalar element from [ptr, $0) into a local
+// `value` of the field's element type.  `$0` is the limit pointer so the
+// same snippet works inside packed runs.
+std::string ScalarReader(const FieldDescriptor* field) {
+  if (IsFixed32(field)) {
+    std::string expr;
+    switch (field->type()) {
+      case FieldDescriptor::TYPE_FIXED32:
+        expr = "raw";
+        break;
+      case FieldDescriptor::TYPE_SFIXED32:
+        expr = "static_cast<int32_t>(raw)";
+        break;
+      default:
+        expr = "::google::protobuf::micro::BitsToFloat(raw)";
+        break;
+    }
+    return absl::Substitute(
+        "uint32_t raw;\n"
+        "ptr = ::google::protobuf::micro::ReadFixed32(ptr, $$0, &raw);\n"
+        "if (ptr == nullptr) return false;\n"
+        "const $0 value = $1;\n",
+        ElementType(field), expr);
+  }
+  if (IsFixed64(field)) {
+    std::string expr;
+    switch (field->type()) {
+      case FieldDescriptor::TYPE_FIXED64:
+        expr = "raw";
+        break;
+      case FieldDescriptor::TYPE_SFIXED64:
+        expr = "static_cast<int64_t>(raw)";
+        break;
+      default:
+        expr = "::google::protobuf::micro::BitsToDouble(raw)";
+        break;
+    }
+    return absl::Substitute(
+        "uint64_t raw;\n"
+        "ptr = ::google::protobuf::micro::ReadFixed64(ptr, $$0, &raw);\n"
+        "if (ptr == nullptr) return false;\n"
+        "const $0 value = $1;\n",
+        ElementType(field), expr);
+  }
+  std::string expr;
+  switch (field->type()) {
+    case FieldDescriptor::TYPE_INT32:
+      expr = "static_cast<int32_t>(raw)";
+      break;
+    case FieldDescriptor::TYPE_INT64:
+      expr = "static_cast<int64_t>(raw)";
+      break;
+    case FieldDescriptor::TYPE_UINT32:
+      expr = "static_cast<uint32_t>(raw)";
+      break;
+    case FieldDescriptor::TYPE_UINT64:
+      expr = "raw";
+      break;
+    case FieldDescriptor::TYPE_BOOL:
+      expr = "raw != 0";
+      break;
+    case FieldDescriptor::TYPE_SINT32:
+      expr =
+          "::google::protobuf::micro::ZigZagDecode32("
+          "static_cast<uint32_t>(raw))";
+      break;
+    case FieldDescriptor::TYPE_SINT64:
+      expr = "::google::protobuf::micro::ZigZagDecode64(raw)";
+      break;
+    case FieldDescriptor::TYPE_ENUM:
+      expr = absl::StrCat("static_cast<", ElementType(field),
+                          ">(static_cast<int32_t>(raw))");
+      break;
+    default:
+      break;
+  }
+  return absl::Substitute(
+      "uint64_t raw;\n"
+      "ptr = ::google::protobuf::micro::ReadVarint(ptr, $$0, &raw);\n"
+      "if (ptr == nullptr) return false;\n"
+      "const $0 value = $1;\n",
+      ElementType(field), expr);
+}
+
+// Expression for the encoded payload size of scalar `$0`.
+std::string ScalarSize(const FieldDescriptor* field) {
+  if (IsFixed32(field)) return "4";
+  if (IsFixed64(field)) return "8";
+  switch (field->type()) {
+    case FieldDescriptor::TYPE_UINT32:
+    case FieldDescriptor::TYPE_UINT64:
+      return "::google::protobuf::micro::VarintSize("
+             "static_cast<uint64_t>($0))";
+    case FieldDescriptor::TYPE_BOOL:
+      return "1";
+    case FieldDescriptor::TYPE_SINT32:
+      return "::google::protobuf::micro::VarintSize("
+             "::google::protobuf::micro::ZigZagEncode32($0))";
+    case FieldDescriptor::TYPE_SINT64:
+      return "::google::protobuf::micro::VarintSize("
+             "::google::protobuf::micro::ZigZagEncode64($0))";
+    default:
+      // int32, int64 and enum sign-extend to ten bytes on the wire.
+      return "::google::protobuf::micro::VarintSize("
+             "static_cast<uint64_t>(static_cast<int64_t>($0)))";
+  }
+}
+
+// Statement writing scalar `$0` to `target`.
+std::string ScalarWriter(const FieldDescriptor* field) {
+  switch (field->type()) {
+    case FieldDescriptor::TYPE_FIXED32:
+      return "target = ::google::protobuf::micro::WriteFixed32($0, target);\n";
+    case FieldDescriptor::TYPE_SFIXED32:
+      return "target = ::google::protobuf::micro::WriteFixed32("
+             "static_cast<uint32_t>($0), target);\n";
+    case FieldDescriptor::TYPE_FLOAT:
+      return "target = ::google::protobuf::micro::WriteFixed32("
+             "::google::protobuf::micro::FloatToBits($0), target);\n";
+    case FieldDescriptor::TYPE_FIXED64:
+      return "target = ::google::protobuf::micro::WriteFixed64($0, target);\n";
+    case FieldDescriptor::TYPE_SFIXED64:
+      return "target = ::google::protobuf::micro::WriteFixed64("
+             "static_cast<uint64_t>($0), target);\n";
+    case FieldDescriptor::TYPE_DOUBLE:
+      return "target = ::google::protobuf::micro::WriteFixed64("
+             "::google::protobuf::micro::DoubleToBits($0), target);\n";
+    case FieldDescriptor::TYPE_UINT32:
+    case FieldDescriptor::TYPE_UINT64:
+      return "target = ::google::protobuf::micro::WriteVarint("
+             "static_cast<uint64_t>($0), target);\n";
+    case FieldDescriptor::TYPE_BOOL:
+      return "target = ::google::protobuf::micro::WriteVarint("
+             "$0 ? 1 : 0, target);\n";
+    case FieldDescriptor::TYPE_SINT32:
+      return "target = ::google::protobuf::micro::WriteVarint("
+             "::google::protobuf::micro::ZigZagEncode32($0), target);\n";
+    case FieldDescriptor::TYPE_SINT64:
+      return "target = ::google::protobuf::micro::WriteVarint("
+             "::google::protobuf::micro::ZigZagEncode64($0), target);\n";
+    default:
+      // int32, int64 and enum sign-extend to ten bytes on the wire.
+      return "target = ::google::protobuf::micro::WriteVarint("
+             "static_cast<uint64_t>(static_cast<int64_t>($0)), target);\n";
+  }
+}
+
+// Condition under which a singular non-message field is serialized.  Required
+// fields are always serialized; everything else follows implicit presence.
+std::string PresenceCondition(const FieldDescriptor* field,
+                              const std::string& member) {
+  if (field->is_required()) return "true";
+  if (field->cpp_type() == FieldDescriptor::CPPTYPE_STRING &&
+      field->default_value_string().empty()) {
+    return absl::StrCat("!", member, ".empty()");
+  }
+  return absl::StrCat(member, " != ", MicroDefaultValue(field));
+}
+
+void Indent(std::string* text, int spaces) {
+  const std::string indent(spaces, ' ');
+  std::string result;
+  for (absl::string_view line : absl::StrSplit(*text, '\n')) {
+    if (!line.empty()) absl::StrAppend(&result, indent, line);
+    result.push_back('\n');
+  }
+  result.pop_back();
+  *text = result;
+}
+
+// Rejects fields and features the micro runtime cannot express as a plain
+// struct with self-contained codec code.
+bool CheckSupported(const FileDescriptor* file, std::string* error) {
+  if (file->extension_count() > 0) {
+    *error = absl::StrCat(file->name(),
+                          ": extensions are not supported by the micro "
+                          "runtime.");
+    return false;
+  }
+  std::vector<const Descriptor*> stack;
+  for (int i = 0; i < file->message_type_count(); ++i) {
+    stack.push_back(file->message_type(i));
+  }
+  while (!stack.empty()) {
+    const Descriptor* message = stack.back();
+    stack.pop_back();
+    for (int i = 0; i < message->nested_type_count(); ++i) {
+      stack.push_back(message->nested_type(i));
+    }
+    if (message->extension_range_count() > 0 ||
+        message->extension_count() > 0) {
+      *error = absl::StrCat(message->full_name(),
+                            ": extensions are not supported by the micro "
+                            "runtime.");
+      return false;
+    }
+    if (message->real_oneof_decl_count() > 0) {
+      *error = absl::StrCat(message->full_name(),
+                            ": oneof fields are not supported by the micro "
+                            "runtime.");
+      return false;
+    }
+    for (int i = 0; i < message->field_count(); ++i) {
+      const FieldDescriptor* field = message->field(i);
+      if (field->is_map()) {
+        *error = absl::StrCat(field->full_name(),
+                              ": map fields are not supported by the micro "
+                              "runtime.");
+        return false;
+      }
+      if (field->type() == FieldDescriptor::TYPE_GROUP) {
+        *error = absl::StrCat(field->full_name(),
+                              ": group fields are not supported by the micro "
+                              "runtime.");
+        return false;
+      }
+      if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE &&
+          field->message_type()->file() != file) {
+        *error = absl::StrCat(field->full_name(),
+                              ": message types from other files are not "
+                              "supported by the micro runtime.");
+        return false;
+      }
+      if (field->cpp_type() == FieldDescriptor::CPPTYPE_ENUM &&
+          field->enum_type()->file() != file) {
+        *error = absl::StrCat(field->full_name(),
+                              ": enum types from other files are not "
+                              "supported by the micro runtime.");
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Orders all messages of the file (including nested ones) so that every
+// by-value member type is defined before its first use.  Returns false on
+// recursive message types, which cannot be laid out as plain structs.
+bool TopologicalOrder(const FileDescriptor* file,
+                      std::vector<const Descriptor*>* order,
+                      std::string* error) {
+  enum State { kUnvisited, kVisiting, kDone };
+  absl::flat_hash_map<const Descriptor*, State> states;
+  struct Visitor {
+    const FileDescriptor* file;
+    absl::flat_hash_map<const Descriptor*, State>* states;
+    std::vector<const Descriptor*>* order;
+    std::string* error;
+
+    bool Visit(const Descriptor* message) {
+      State& state = (*states)[message];
+      if (state == kDone) return true;
+      if (state == kVisiting) {
+        *error = absl::StrCat(message->full_name(),
+                              ": recursive message types are not supported "
+                              "by the micro runtime.");
+        return false;
+      }
+      state = kVisiting;
+      for (int i = 0; i < message->field_count(); ++i) {
+        const FieldDescriptor* field = message->field(i);
+        if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE &&
+            field->message_type()->file() == file) {
+          if (!Visit(field->message_type())) return false;
+        }
+      }
+      (*states)[message] = kDone;
+      order->push_back(message);
+      return true;
+    }
+  };
+  Visitor visitor{file, &states, order, error};
+  std::vector<const Descriptor*> stack;
+  for (int i = 0; i < file->message_type_count(); ++i) {
+    stack.push_back(file->message_type(i));
+  }
+  while (!stack.empty()) {
+    const Descriptor* message = stack.back();
+    stack.pop_back();
+    for (int i = 0; i < message->nested_type_count(); ++i) {
+      stack.push_back(message->nested_type(i));
+    }
+    if (!visitor.Visit(message)) return false;
+  }
+  return true;
+}
+
+void GenerateEnum(const EnumDescriptor* descriptor, io::Printer* printer) {
+  printer->Print("// $full_name$\nenum $name$ : int32_t {\n", "full_name",
+                 descriptor->full_name(), "name", EnumName(descriptor));
+  for (int i = 0; i < descriptor->value_count(); ++i) {
+    const EnumValueDescriptor* value = descriptor->value(i);
+    printer->Print("  $name$ = $number$,\n", "name", EnumValueName(value),
+                   "number", absl::StrCat(value->number()));
+  }
+  printer->Print("};\n\n");
+}
+
+void GenerateMembers(const Descriptor* message, io::Printer* printer) {
+  for (int i = 0; i < message->field_count(); ++i) {
+    const FieldDescriptor* field = message->field(i);
+    const std::string name = FieldName(field);
+    if (field->is_repeated()) {
+      printer->Print("  std::vector<$type$> $name$;\n", "type",
+                     ElementType(field), "name", name);
+    } else if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+      printer->Print("  $type$ $name$;\n  bool has_$name$ = false;\n", "type",
+                     ElementType(field), "name", name);
+    } else if (field->cpp_type() == FieldDescriptor::CPPTYPE_STRING) {
+      if (field->default_value_string().empty()) {
+        printer->Print("  std::string $name$;\n", "name", name);
+      } else {
+        printer->Print("  std::string $name$ = $default$;\n", "name", name,
+                       "default", MicroDefaultValue(field));
+      }
+    } else {
+      printer->Print("  $type$ $name$ = $default$;\n", "type",
+                     ElementType(field), "name", name, "default",
+                     MicroDefaultValue(field));
+    }
+  }
+}
+
+void GenerateParseCase(const FieldDescriptor* field, io::Printer* printer) {
+  const std::string member = absl::StrCat("this->", FieldName(field));
+  std::string body;
+  if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+    body = absl::Substitute(
+        "case $0u: {\n"
+        "  uint64_t length;\n"
+        "  ptr = ::google::protobuf::micro::ReadVarint(ptr, end, &length);\n"
+        "  if (ptr == nullptr ||\n"
+        "      length > static_cast<uint64_t>(end - ptr)) {\n"
+        "    return false;\n"
+        "  }\n"
+        "$1"
+        "  ptr += length;\n"
+        "  break;\n"
+        "}\n",
+        FieldTag(field),
+        field->is_repeated()
+            ? absl::Substitute(
+                  "  $0.emplace_back();\n"
+                  "  if (!$0.back().ParseFromArray(ptr, "
+                  "static_cast<size_t>(length))) {\n"
+                  "    return false;\n"
+                  "  }\n",
+                  member)
+            : absl::Substitute(
+                  "  if (!$0.ParseFromArray(ptr, "
+                  "static_cast<size_t>(length))) {\n"
+                  "    return false;\n"
+                  "  }\n"
+                  "  this->has_$1 = true;\n",
+                  member, FieldName(field)));
+  } else if (field->cpp_type() == FieldDescriptor::CPPTYPE_STRING) {
+    body = absl::Substitute(
+        "case $0u: {\n"
+        "  uint64_t length;\n"
+        "  ptr = ::google::protobuf::micro::ReadVarint(ptr, end, &length);\n"
+        "  if (ptr == nullptr ||\n"
+        "      length > static_cast<uint64_t>(end - ptr)) {\n"
+        "    return false;\n"
+        "  }\n"
+        "  $1;\n"
+        "  ptr += length;\n"
+        "  break;\n"
+        "}\n",
+        FieldTag(field),
+        field->is_repeated()
+            ? absl::Substitute(
+                  "$0.emplace_back(ptr, static_cast<size_t>(length))", member)
+            : absl::Substitute("$0.assign(ptr, static_cast<size_t>(length))",
+                               member));
+  } else {
+    std::string single_read = absl::Substitute(ScalarReader(field), "end");
+    Indent(&single_read, 2);
+    std::string store = field->is_repeated()
+                            ? absl::StrCat(member, ".push_back(value);")
+                            : absl::StrCat(member, " = value;");
+    body = absl::Substitute(
+        "case $0u: {\n"
+        "$1"
+        "  $2\n"
+        "  break;\n"
+        "}\n",
+        FieldTag(field), single_read, store);
+    if (field->is_repeated()) {
+      // Conformant parsers accept both packed and expanded encodings
+      // regardless of the declared option.
+      std::string packed_read =
+          absl::Substitute(ScalarReader(field), "packed_end");
+      Indent(&packed_read, 4);
+      absl::StrAppend(
+          &body,
+          absl::Substitute(
+              "case $0u: {\n"
+              "  uint64_t length;\n"
+              "  ptr = ::google::protobuf::micro::ReadVarint(ptr, end, "
+              "&length);\n"
+              "  if (ptr == nullptr ||\n"
+              "      length > static_cast<uint64_t>(end - ptr)) {\n"
+              "    return false;\n"
+              "  }\n"
+              "  const char* packed_end = ptr + length;\n"
+              "  while (ptr < packed_end) {\n"
+              "$1"
+              "    $2.push_back(value);\n"
+              "  }\n"
+              "  break;\n"
+              "}\n",
+              PackedTag(field), packed_read, member));
+    }
+  }
+  Indent(&body, 8);
+  printer->PrintRaw(body);
+}
+
+void GenerateByteSize(const FieldDescriptor* field, io::Printer* printer) {
+  const std::string member = absl::StrCat("this->", FieldName(field));
+  const size_t tag_size = TagSize(FieldTag(field));
+  std::string body;
+  if (field->is_repeated()) {
+    if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+      body = absl::Substitute(
+          "for (const auto& element : $0) {\n"
+          "  const size_t element_size = element.ByteSizeLong();\n"
+          "  total += $1 + ::google::protobuf::micro::VarintSize("
+          "element_size) +\n"
+          "           element_size;\n"
+          "}\n",
+          member, tag_size);
+    } else if (field->cpp_type() == FieldDescriptor::CPPTYPE_STRING) {
+      body = absl::Substitute(
+          "for (const auto& element : $0) {\n"
+          "  total += $1 + ::google::protobuf::micro::VarintSize("
+          "element.size()) +\n"
+          "           element.size();\n"
+          "}\n",
+          member, tag_size);
+    } else if (field->is_packed()) {
+      body = absl::Substitute(
+          "if (!$0.empty()) {\n"
+          "  size_t data_size = 0;\n"
+          "  for (const auto& element : $0) {\n"
+          "    data_size += $1;\n"
+          "  }\n"
+          "  total += $2 + ::google::protobuf::micro::VarintSize(data_size) "
+          "+\n"
+          "           data_size;\n"
+          "}\n",
+          member, absl::Substitute(ScalarSize(field), "element"),
+          TagSize(PackedTag(field)));
+    } else {
+      body = absl::Substitute(
+          "for (const auto& element : $0) {\n"
+          "  total += $1 + $2;\n"
+          "}\n",
+          member, tag_size, absl::Substitute(ScalarSize(field), "element"));
+    }
+  } else if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+    body = absl::Substitute(
+        "if (this->has_$0) {\n"
+        "  const size_t sub_size = $1.ByteSizeLong();\n"
+        "  total += $2 + ::google::protobuf::micro::VarintSize(sub_size) +\n"
+        "           sub_size;\n"
+        "}\n",
+        FieldName(field), member, tag_size);
+  } else if (field->cpp_type() == FieldDescriptor::CPPTYPE_STRING) {
+    body = absl::Substitute(
+        "if ($0) {\n"
+        "  total += $1 + ::google::protobuf::micro::VarintSize($2.size()) +\n"
+        "           $2.size();\n"
+        "}\n",
+        PresenceCondition(field, member), tag_size, member);
+  } else {
+    body = absl::Substitute("if ($0) {\n  total += $1 + $2;\n}\n",
+                            PresenceCondition(field, member), tag_size,
+                            absl::Substitute(ScalarSize(field), member));
+  }
+  Indent(&body, 4);
+  printer->PrintRaw(body);
+}
+
+void GenerateSerialize(const FieldDescriptor* field, io::Printer* printer) {
+  const std::string member = absl::StrCat("this->", FieldName(field));
+  const std::string write_tag = absl::Substitute(
+      "target = ::google::protobuf::micro::WriteVarint($0u, target);\n",
+      FieldTag(field));
+  std::string body;
+  if (field->is_repeated()) {
+    if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+      body = absl::Substitute(
+          "for (const auto& element : $0) {\n"
+          "  $1"
+          "  target = ::google::protobuf::micro::WriteVarint("
+          "element.ByteSizeLong(), target);\n"
+          "  target = element.SerializeToArray(target);\n"
+          "}\n",
+          member, write_tag);
+    } else if (field->cpp_type() == FieldDescriptor::CPPTYPE_STRING) {
+      body = absl::Substitute(
+          "for (const auto& element : $0) {\n"
+          "  $1"
+          "  target = ::google::protobuf::micro::WriteVarint("
+          "element.size(), target);\n"
+          "  std::memcpy(target, element.data(), element.size());\n"
+          "  target += element.size();\n"
+          "}\n",
+          member, write_tag);
+    } else if (field->is_packed()) {
+      std::string write_element =
+          absl::Substitute(ScalarWriter(field), "element");
+      Indent(&write_element, 4);
+      body = absl::Substitute(
+          "if (!$0.empty()) {\n"
+          "  target = ::google::protobuf::micro::WriteVarint($1u, target);\n"
+          "  size_t data_size = 0;\n"
+          "  for (const auto& element : $0) {\n"
+          "    data_size += $2;\n"
+          "  }\n"
+          "  target = ::google::protobuf::micro::WriteVarint(data_size, "
+          "target);\n"
+          "  for (const auto& element : $0) {\n"
+          "$3"
+          "  }\n"
+          "}\n",
+          member, PackedTag(field),
+          absl::Substitute(ScalarSize(field), "element"), write_element);
+    } else {
+      std::string write_element =
+          absl::Substitute(ScalarWriter(field), "element");
+      Indent(&write_element, 2);
+      body = absl::Substitute(
+          "for (const auto& element : $0) {\n"
+          "  $1"
+          "$2"
+          "}\n",
+          member, write_tag, write_element);
+    }
+  } else if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+    body = absl::Substitute(
+        "if (this->has_$0) {\n"
+        "  $1"
+        "  target = ::google::protobuf::micro::WriteVarint("
+        "$2.ByteSizeLong(), target);\n"
+        "  target = $2.SerializeToArray(target);\n"
+        "}\n",
+        FieldName(field), write_tag, member);
+  } else if (field->cpp_type() == FieldDescriptor::CPPTYPE_STRING) {
+    body = absl::Substitute(
+        "if ($0) {\n"
+        "  $1"
+        "  target = ::google::protobuf::micro::WriteVarint($2.size(), "
+        "target);\n"
+        "  std::memcpy(target, $2.data(), $2.size());\n"
+        "  target += $2.size();\n"
+        "}\n",
+        PresenceCondition(field, member), write_tag, member);
+  } else {
+    std::string write_value = absl::Substitute(ScalarWriter(field), member);
+    Indent(&write_value, 2);
+    body =
+        absl::Substitute("if ($0) {\n  $1$2}\n",
+                         PresenceCondition(field, member), write_tag,
+                         write_value);
+  }
+  Indent(&body, 4);
+  printer->PrintRaw(body);
+}
+
+void GenerateMessage(const Descriptor* message, io::Printer* printer) {
+  printer->Print("// $full_name$ as a plain struct.\nstruct $name$ {\n",
+                 "full_name", message->full_name(), "name",
+                 MessageName(message));
+  GenerateMembers(message, printer);
+
+  // Serialization walks the fields in field number order so the output is
+  // byte-for-byte identical to the full runtime.
+  std::vector<const FieldDescriptor*> ordered;
+  for (int i = 0; i < message->field_count(); ++i) {
+    ordered.push_back(message->field(i));
+  }
+  std::sort(ordered.begin(), ordered.end(),
+            [](const FieldDescriptor* a, const FieldDescriptor* b) {
+              return a->number() < b->number();
+            });
+
+  printer->Print(
+      "\n"
+      "  // Merges the wire-format message in [data, data + size) into this\n"
+      "  // struct.  Returns false on malformed input; parse into a freshly\n"
+      "  // constructed struct to get plain (non-merging) semantics.\n"
+      "  bool ParseFromArray(const void* data, size_t size) {\n"
+      "    const char* ptr = static_cast<const char*>(data);\n"
+      "    const char* end = ptr + size;\n"
+      "    while (ptr < end) {\n"
+      "      uint64_t tag64;\n"
+      "      ptr = ::google::protobuf::micro::ReadVarint(ptr, end, &tag64);\n"
+      "      if (ptr == nullptr || tag64 == 0 ||\n"
+      "          tag64 > 0xffffffffu) {\n"
+      "        return false;\n"
+      "      }\n"
+      "      switch (static_cast<uint32_t>(tag64)) {\n");
+  for (int i = 0; i < message->field_count(); ++i) {
+    GenerateParseCase(message->field(i), printer);
+  }
+  printer->Print(
+      "        default: {\n"
+      "          ptr = ::google::protobuf::micro::SkipField(\n"
+      "              static_cast<uint32_t>(tag64), ptr, end);\n"
+      "          if (ptr == nullptr) return false;\n"
+      "          break;\n"
+      "        }\n"
+      "      }\n"
+      "    }\n"
+      "    return true;\n"
+      "  }\n"
+      "\n"
+      "  size_t ByteSizeLong() const {\n"
+      "    size_t total = 0;\n");
+  for (const FieldDescriptor* field : ordered) {
+    GenerateByteSize(field, printer);
+  }
+  printer->Print(
+      "    return total;\n"
+      "  }\n"
+      "\n"
+      "  // Writes the message to `target`, which must have room for at\n"
+      "  // least ByteSizeLong() bytes, and returns a pointer just past the\n"
+      "  // written bytes.\n"
+      "  char* SerializeToArray(char* target) const {\n");
+  for (const FieldDescriptor* field : ordered) {
+    GenerateSerialize(field, printer);
+  }
+  printer->Print(
+      "    return target;\n"
+      "  }\n"
+      "\n"
+      "  bool SerializeToString(std::string* out) const {\n"
+      "    out->resize(ByteSizeLong());\n"
+      "    char* end = SerializeToArray(&(*out)[0]);\n"
+      "    return static_cast<size_t>(end - &(*out)[0]) == out->size();\n"
+      "  }\n"
+      "};\n\n");
+}
+
+}  // namespace
+
+bool MicroGenerator::Generate(const FileDescriptor* file,
+                              const std::string& parameter,
+                              GeneratorContext* generator_context,
+                              std::string* error) const {
+  if (!parameter.empty()) {
+    *error = absl::StrCat("Unknown generator option: ", parameter);
+    return false;
+  }
+  if (!CheckSupported(file, error)) return false;
+
+  std::vector<const Descriptor*> messages;
+  if (!TopologicalOrder(file, &messages, error)) return false;
+
+  const std::string basename = StripProto(file->name());
+  std::unique_ptr<io::ZeroCopyOutputStream> output(
+      generator_context->Open(absl::StrCat(basename, ".micro.pb.h")));
+  io::Printer printer(output.get(), '$');
+
+  const std::string guard = absl::StrCat(
+      "GOOGLE_PROTOBUF_MICRO_INCLUDED_", FilenameIdentifier(file->name()));
+  printer.Print(
+      "// Generated by the protocol buffer compiler (micro runtime).\n"
+      "// DO NOT EDIT!\n"
+      "// source: $file$\n"
+      "//\n"
+      "// This header is self-contained: it depends only on the C++\n"
+      "// standard library.  Scalar fields are serialized when they differ\n"
+      "// from their default value; explicit presence is tracked only for\n"
+      "// message-typed fields (via the has_* members).  Strings are not\n"
+      "// UTF-8 validated and submessage sizes are recomputed rather than\n"
+      "// cached, which is the right trade-off for the small messages this\n"
+      "// runtime targets.\n"
+      "\n"
+      "#ifndef $guard$\n"
+      "#define $guard$\n"
+      "\n"
+      "#include <cstdint>\n"
+      "#include <cstring>\n"
+      "#include <string>\n"
+      "#include <vector>\n",
+      "file", file->name(), "guard", guard);
+  printer.PrintRaw(kWireHelpers);
+  printer.Print("\n");
+
+  std::vector<std::string> package_parts;
+  if (!file->package().empty()) {
+    package_parts = absl::StrSplit(file->package(), '.');
+  }
+  for (const std::string& part : package_parts) {
+    printer.Print("namespace $part$ {\n", "part", part);
+  }
+  if (!package_parts.empty()) printer.Print("\n");
+
+  // Enums first: they have no dependencies and may be used by any message.
+  for (int i = 0; i < file->enum_type_count(); ++i) {
+    GenerateEnum(file->enum_type(i), &printer);
+  }
+  for (const Descriptor* message : messages) {
+    for (int i = 0; i < message->enum_type_count(); ++i) {
+      GenerateEnum(message->enum_type(i), &printer);
+    }
+  }
+
+  for (const Descriptor* message : messages) {
+    GenerateMessage(message, &printer);
+  }
+
+  for (auto it = package_parts.rbegin(); it != package_parts.rend(); ++it) {
+    printer.Print("}  // namespace $part$\n", "part", *it);
+  }
+  printer.Print("\n#endif  // $guard$\n", "guard", guard);
+  return !printer.failed();
+}
+
+}  // namespace cpp
+}  // namespace compiler
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
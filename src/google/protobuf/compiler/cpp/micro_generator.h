@@ -0,0 +1,56 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+// Generates a self-contained, header-only C++ codec for a .proto file.
+//
+// The micro runtime targets codec-only use cases where linking libprotobuf
+// (or even the lite runtime) is too expensive: for each message it emits a
+// plain struct with ParseFromArray() / ByteSizeLong() / SerializeToArray()
+// members whose only dependencies are <cstdint>, <cstring>, <string> and
+// <vector>.  The generated wire code is compatible with the full runtime for
+// the supported feature subset; maps, extensions, oneofs, groups and
+// cross-file message fields are rejected with a generator error.
+
+#ifndef GOOGLE_PROTOBUF_COMPILER_CPP_MICRO_GENERATOR_H__
+#define GOOGLE_PROTOBUF_COMPILER_CPP_MICRO_GENERATOR_H__
+
+#include <string>
+
+#include "google/protobuf/compiler/code_generator.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace compiler {
+namespace cpp {
+
+// CodeGenerator implementation for the header-only micro runtime.  Register
+// it with the CommandLineInterface to expose it as --cpp_micro_out.
+class PROTOC_EXPORT MicroGenerator : public CodeGenerator {
+ public:
+  MicroGenerator() = default;
+  ~MicroGenerator() override = default;
+
+  bool Generate(const FileDescriptor* file, const std::string& parameter,
+                GeneratorContext* generator_context,
+                std::string* error) const override;
+
+  uint64_t GetSupportedFeatures() const override {
+    return Feature::FEATURE_PROTO3_OPTIONAL;
+  }
+};
+
+}  // namespace cpp
+}  // namespace compiler
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_COMPILER_CPP_MICRO_GENERATOR_H__
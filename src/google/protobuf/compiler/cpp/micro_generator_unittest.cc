@@ -0,0 +1,155 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/compiler/cpp/micro_generator.h"
+
+#include <memory>
+#include <string>
+
+#include "google/protobuf/testing/file.h"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/log/absl_check.h"
+#include "absl/strings/str_cat.h"
+#include "google/protobuf/compiler/command_line_interface_tester.h"
+
+namespace google {
+namespace protobuf {
+namespace compiler {
+namespace cpp {
+namespace {
+
+using ::testing::HasSubstr;
+using ::testing::Not;
+
+class MicroGeneratorTest : public CommandLineInterfaceTester {
+ protected:
+  MicroGeneratorTest() {
+    RegisterGenerator("--cpp_micro_out", "--cpp_micro_opt",
+                      std::make_unique<MicroGenerator>(),
+                      "Micro test generator");
+  }
+
+  std::string GeneratedFileContent(absl::string_view basename) {
+    std::string content;
+    ABSL_CHECK_OK(File::GetContents(
+        absl::StrCat(temp_directory(), "/", basename, ".micro.pb.h"),
+        &content, true));
+    return content;
+  }
+};
+
+TEST_F(MicroGeneratorTest, EmitsSelfContainedHeader) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto3";
+    package sidecar;
+    message Inner {
+      sint64 delta = 1;
+    }
+    message Packet {
+      int32 id = 1;
+      string payload = 2;
+      repeated float samples = 3;
+      Inner inner = 4;
+    })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir --cpp_micro_out=$tmpdir "
+      "foo.proto");
+
+  ExpectNoErrors();
+  const std::string content = GeneratedFileContent("foo");
+  // Self-contained: only standard library includes.
+  EXPECT_THAT(content, HasSubstr("#include <cstdint>"));
+  EXPECT_THAT(content, Not(HasSubstr("google/protobuf/")));
+  // The by-value member type must be defined before its use.
+  EXPECT_LT(content.find("struct Inner {"), content.find("struct Packet {"));
+  EXPECT_THAT(content, HasSubstr("bool ParseFromArray(const void* data"));
+  EXPECT_THAT(content, HasSubstr("size_t ByteSizeLong() const"));
+  EXPECT_THAT(content, HasSubstr("char* SerializeToArray(char* target) const"));
+  EXPECT_THAT(content, HasSubstr("bool has_inner = false;"));
+  EXPECT_THAT(content, HasSubstr("std::vector<float> samples;"));
+}
+
+TEST_F(MicroGeneratorTest, RejectsMapFields) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto3";
+    message Foo {
+      map<string, int32> bar = 1;
+    })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir --cpp_micro_out=$tmpdir "
+      "foo.proto");
+
+  ExpectErrorSubstring("map fields are not supported by the micro runtime");
+}
+
+TEST_F(MicroGeneratorTest, RejectsRecursiveMessages) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto3";
+    message Node {
+      repeated Node children = 1;
+    })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir --cpp_micro_out=$tmpdir "
+      "foo.proto");
+
+  ExpectErrorSubstring(
+      "recursive message types are not supported by the micro runtime");
+}
+
+TEST_F(MicroGeneratorTest, RejectsOneofFields) {
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto3";
+    message Foo {
+      oneof kind {
+        int32 a = 1;
+        string b = 2;
+      }
+    })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir --cpp_micro_out=$tmpdir "
+      "foo.proto");
+
+  ExpectErrorSubstring("oneof fields are not supported by the micro runtime");
+}
+
+TEST_F(MicroGeneratorTest, RejectsCrossFileMessageFields) {
+  CreateTempFile("base.proto",
+                 R"schema(
+    syntax = "proto3";
+    message Base {
+      int32 a = 1;
+    })schema");
+  CreateTempFile("foo.proto",
+                 R"schema(
+    syntax = "proto3";
+    import "base.proto";
+    message Foo {
+      Base base = 1;
+    })schema");
+
+  RunProtoc(
+      "protocol_compiler --proto_path=$tmpdir --cpp_micro_out=$tmpdir "
+      "foo.proto");
+
+  ExpectErrorSubstring(
+      "message types from other files are not supported by the micro runtime");
+}
+
+}  // namespace
+}  // namespace cpp
+}  // namespace compiler
+}  // namespace protobuf
+}  // namespace google
@@ -12,6 +12,7 @@
 
 #include <string>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 
 namespace google {
@@ -38,6 +39,17 @@ struct FieldListenerOptions {
 struct Options {
   const AccessInfoMap* access_info_map = nullptr;
   const SplitMap* split_map = nullptr;
+  // Full names of fields to move into the lazily-allocated Split struct,
+  // the hot/cold layout splitting normally driven by profile data. Fields
+  // that are not eligible for splitting (e.g. oneof members) are ignored.
+  absl::flat_hash_set<std::string> split_field_names;
+  // Entries of the field-presence profile passed via the presence_profile
+  // generator option, keyed by field full name with values in [0, 1].  The
+  // probabilities bias layout decisions normally driven by profile data:
+  // fast-parse-table slot assignment prefers fields more likely to be
+  // present, and clear/merge chunking treats fields at the extremes as
+  // likely or rarely present.
+  absl::flat_hash_map<std::string, float> presence_profile;
   std::string dllexport_decl;
   std::string runtime_include_base;
   std::string annotation_pragma_name;
@@ -51,6 +63,51 @@ struct Options {
   bool annotate_headers = false;
   bool lite_implicit_weak_fields = false;
   bool descriptor_implicit_weak_messages = false;
+  // Skip the per-file AddDescriptors() static initializer, the way the
+  // runtime already does for descriptor.proto: descriptors register lazily
+  // on first reflection use (or transitively when a dependent file
+  // registers).  Binaries with many protos that never touch reflection pay
+  // no startup cost for it.  Extension registration stays eager, and
+  // generated_pool()->FindFileByName() only sees the file once generated
+  // code for it (or a dependent) has been exercised.
+  bool lazy_descriptor_initialization = false;
+  // Emit FixedShapeTraits specializations for messages whose fields are all
+  // singular scalars without explicit presence, enabling the unrolled codec
+  // in generated_message_fixed_shape.h for those types.  Messages that do
+  // not qualify are unaffected.
+  bool fixed_shape_codec = false;
+  // Emit a second HasBits-like word block (_dirty_bits_) alongside
+  // _has_bits_, with generated setters and clearers marking their field's
+  // bit.  dirty_mask() / clear_dirty_mask() expose it so callers that
+  // serialize a message repeatedly with few mutations in between can tell
+  // whether cached byte sizes are still valid (see
+  // SerializePartialToArrayUsingCachedSizes()).  Only fields with has-bits
+  // are tracked; parsing, Clear() and MergeFrom() do not maintain the bits.
+  bool dirty_bits = false;
+  // Replace the unrolled bodies of Clear() and MergeFrom() with calls into
+  // the shared TcParseTable interpreters (TcParser::ClearMessageFields /
+  // MergeMessageFields) for messages whose fields they support.  Trades a
+  // table walk for considerably less generated code; messages with fields
+  // the interpreters cannot handle keep the unrolled bodies.
+  bool table_driven_clear = false;
+  // Emit one numbered .cc file per message and per extension (the layout
+  // lite_implicit_weak_fields already uses), plus the global .pb.cc with
+  // enums, services and reflection.  With -ffunction-sections
+  // -fdata-sections and --gc-sections the linker can then drop generated
+  // messages the binary never references.  Most effective for lite files;
+  // with descriptor methods the file's reflection table keeps every default
+  // instance reachable, so only the class methods are strippable.
+  bool separate_cc_files = false;
+  // Cache the previously active member of a oneof when the case switches on
+  // an arena, so toggling back to it recycles the old object (a Clear() and
+  // a case-word write) instead of allocating a fresh one.  One cache slot is
+  // added per oneof with message-typed members.  Also emits a dense
+  // <Oneof>CaseIndex enum and <oneof>_case_index() accessor so user code can
+  // switch over declaration-order values regardless of field numbering.
+  // Objects attached with unsafe_arena_set_allocated_* may be recycled as
+  // freshly cleared members after the case switches away, so callers that
+  // keep using such objects independently must not enable this.
+  bool oneof_member_cache = false;
   bool bootstrap = false;
   bool opensource_runtime = false;
   bool annotate_accessor = false;
@@ -213,16 +213,16 @@ static NumToEntryTable MakeNumToEntryTable(
     if (start_new_block == false) {
       // If the next field number is within 15 of the last_skip_entry_start, we
       // continue writing just to that entry.  If it's between 16 and 31 more,
-      // then we just extend the current block by one. If it's more than 31
-      // more, we have to add empty skip entries in order to continue using the
-      // existing block.  Obviously it's just 32 more, it doesn't make sense to
-      // start a whole new block, since new blocks mean having to write out
-      // their starting field number, which is 32 bits, as well as the size of
-      // the additional block, which is 16... while an empty SkipEntry16 only
-      // costs 32 bits.  So if it was 48 more, it's a slight space win; we save
-      // 16 bits, but probably at the cost of slower run time.  We're choosing
-      // 96 for now.
-      if (fnum - last_skip_entry_start > 96) start_new_block = true;
+      // then we just extend the current block by one. If it's further away, we
+      // can either pad the current block with empty skip entries (4 bytes
+      // each) or start a new block, which costs 6 bytes of header and, more
+      // importantly, an extra dependent load and branch in FindFieldEntry
+      // every time a field in a later block misses the fast table.  We bias
+      // towards fewer blocks so that the slow-path lookup for high field
+      // numbers normally indexes into a single block: gaps of up to 256
+      // numbers (15 empty skip entries, 60 bytes) are absorbed into the
+      // current block.
+      if (fnum - last_skip_entry_start > 256) start_new_block = true;
     }
     if (start_new_block) {
       num_to_entry_table.blocks.push_back(SkipEntryBlock{fnum});
@@ -8,6 +8,7 @@
 #include "absl/log/initialize.h"
 #include "google/protobuf/compiler/command_line_interface.h"
 #include "google/protobuf/compiler/cpp/generator.h"
+#include "google/protobuf/compiler/cpp/micro_generator.h"
 #include "google/protobuf/compiler/csharp/csharp_generator.h"
 #include "google/protobuf/compiler/java/generator.h"
 #include "google/protobuf/compiler/java/kotlin_generator.h"
@@ -50,6 +51,12 @@ int ProtobufMain(int argc, char* argv[]) {
   cpp_generator.set_runtime_include_base(GOOGLE_PROTOBUF_RUNTIME_INCLUDE_BASE);
 #endif
 
+  // C++ micro runtime (header-only codec, no library dependency)
+  cpp::MicroGenerator cpp_micro_generator;
+  cli.RegisterGenerator("--cpp_micro_out", "--cpp_micro_opt",
+                        &cpp_micro_generator,
+                        "Generate self-contained header-only C++ codec.");
+
   // Proto2 Java
   java::JavaGenerator java_generator;
   cli.RegisterGenerator("--java_out", "--java_opt", &java_generator,
@@ -9,13 +9,16 @@
 
 #include "google/protobuf/compiler/plugin.h"
 
+#include <fcntl.h>
+
+#include <cerrno>
+#include <cstring>
 #include <iostream>
+#include <string>
 #include <utility>
 #include <vector>
 
-#ifdef _WIN32
-#include <fcntl.h>
-#else
+#ifndef _WIN32
 #include <unistd.h>
 #endif
 
@@ -23,6 +26,10 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
 #include "google/protobuf/compiler/code_generator.h"
 #include "google/protobuf/compiler/plugin.pb.h"
 #include "google/protobuf/descriptor.h"
@@ -38,9 +45,18 @@ namespace compiler {
 #if defined(_WIN32)
 // DO NOT include <io.h>, instead create functions in io_win32.{h,cc} and import
 // them like we do below.
+using google::protobuf::io::win32::open;
 using google::protobuf::io::win32::setmode;
 #endif
 
+#ifndef O_BINARY
+#ifdef _O_BINARY
+#define O_BINARY _O_BINARY
+#else
+#define O_BINARY 0  // If this isn't defined, the platform doesn't need it.
+#endif
+#endif
+
 class GeneratorResponseContext : public GeneratorContext {
  public:
   GeneratorResponseContext(
@@ -154,6 +170,52 @@ bool GenerateCode(const CodeGeneratorRequest& request,
   return true;
 }
 
+bool ExpandDescriptorSetHandoff(CodeGeneratorRequest* request,
+                                std::string* error_msg) {
+  static constexpr absl::string_view kOption = "descriptor_set_handoff=";
+  if (request->proto_file_size() > 0 || request->parameter().empty()) {
+    return true;
+  }
+
+  std::string path;
+  std::vector<absl::string_view> kept_options;
+  bool found = false;
+  for (absl::string_view option : absl::StrSplit(request->parameter(), ',')) {
+    if (!found && absl::ConsumePrefix(&option, kOption)) {
+      path = std::string(option);
+      found = true;
+    } else {
+      kept_options.push_back(option);
+    }
+  }
+  if (!found) return true;
+
+  int fd;
+  do {
+    fd = open(path.c_str(), O_RDONLY | O_BINARY);
+  } while (fd < 0 && errno == EINTR);
+  if (fd < 0) {
+    *error_msg = absl::StrCat("could not open descriptor set handoff file ",
+                              path, ": ", strerror(errno));
+    return false;
+  }
+
+  FileDescriptorSet file_set;
+  io::FileInputStream in(fd);
+  in.SetCloseOnDelete(true);
+  if (!file_set.ParseFromZeroCopyStream(&in)) {
+    *error_msg =
+        absl::StrCat("could not parse descriptor set handoff file ", path);
+    return false;
+  }
+
+  for (FileDescriptorProto& file : *file_set.mutable_file()) {
+    *request->add_proto_file() = std::move(file);
+  }
+  request->set_parameter(absl::StrJoin(kept_options, ","));
+  return true;
+}
+
 int PluginMain(int argc, char* argv[], const CodeGenerator* generator) {
 
   if (argc > 1) {
@@ -177,6 +239,11 @@ int PluginMain(int argc, char* argv[], const CodeGenerator* generator) {
   std::string error_msg;
   CodeGeneratorResponse response;
 
+  if (!ExpandDescriptorSetHandoff(&request, &error_msg)) {
+    std::cerr << argv[0] << ": " << error_msg << std::endl;
+    return 1;
+  }
+
   if (GenerateCode(request, *generator, &response, &error_msg)) {
     if (!response.SerializeToFileDescriptor(STDOUT_FILENO)) {
       std::cerr << argv[0] << ": Error writing to stdout." << std::endl;
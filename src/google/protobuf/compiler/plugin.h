@@ -64,6 +64,16 @@ bool GenerateCode(const CodeGeneratorRequest& request,
                   const CodeGenerator& generator,
                   CodeGeneratorResponse* response, std::string* error_msg);
 
+// If the request carries no proto_file but its parameter contains a
+// "descriptor_set_handoff=FILE" option (as emitted by protoc's
+// --plugin_descriptor_set_handoff flag), loads the FileDescriptorSet from
+// FILE into proto_file and strips the option from the parameter.  Requests
+// with inline proto_file pass through untouched.  PluginMain calls this
+// automatically; it is exposed for plugins with custom front ends.  Returns
+// false and populates error_msg if FILE cannot be read or parsed.
+PROTOC_EXPORT bool ExpandDescriptorSetHandoff(CodeGeneratorRequest* request,
+                                              std::string* error_msg);
+
 }  // namespace compiler
 }  // namespace protobuf
 }  // namespace google
@@ -0,0 +1,117 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/cpu_features.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+namespace {
+
+// Set in the cached value so that a machine reporting no listed features
+// still reads as "already detected".
+constexpr uint32_t kCpuFeaturesResolved = 1u << 31;
+
+#if defined(__x86_64__) || defined(_M_X64)
+
+void CpuId(uint32_t leaf, uint32_t regs[4]) {
+#if defined(_MSC_VER) && !defined(__clang__)
+  int out[4];
+  __cpuidex(out, static_cast<int>(leaf), 0);
+  for (int i = 0; i < 4; i++) regs[i] = static_cast<uint32_t>(out[i]);
+#else
+  __cpuid_count(leaf, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// XCR0, i.e. which register state the OS saves and restores.  AVX use is
+// only safe when the OS manages the YMM halves, not just when the CPU has
+// the instructions.
+uint64_t Xgetbv() {
+#if defined(_MSC_VER) && !defined(__clang__)
+  return _xgetbv(0);
+#else
+  uint32_t eax, edx;
+  // Raw encoding of xgetbv, to avoid requiring -mxsave for the intrinsic.
+  __asm__(".byte 0x0f, 0x01, 0xd0" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+
+uint32_t DetectCpuFeatures() {
+  uint32_t regs[4];
+  CpuId(0, regs);
+  const uint32_t max_leaf = regs[0];
+  if (max_leaf < 1) return 0;
+  CpuId(1, regs);
+  const uint32_t ecx1 = regs[2];
+  uint32_t features = 0;
+  if (ecx1 & (1u << 19)) features |= kCpuFeatureSse41;
+  const bool osxsave = (ecx1 & (1u << 27)) != 0;
+  const bool avx = (ecx1 & (1u << 28)) != 0;
+  if (osxsave && avx && (Xgetbv() & 0x6) == 0x6 && max_leaf >= 7) {
+    CpuId(7, regs);
+    if (regs[1] & (1u << 5)) features |= kCpuFeatureAvx2;
+  }
+  return features;
+}
+
+#elif defined(__aarch64__) || defined(_M_ARM64)
+
+// NEON is architectural on AArch64.
+uint32_t DetectCpuFeatures() { return kCpuFeatureNeon; }
+
+#else
+
+uint32_t DetectCpuFeatures() { return 0; }
+
+#endif
+
+}  // namespace
+
+uint32_t CpuFeatureMaskForDispatchName(const char* name) {
+  if (name == nullptr) return ~uint32_t{0};
+  if (strcmp(name, "generic") == 0) return 0;
+  if (strcmp(name, "sse4") == 0) return kCpuFeatureSse41;
+  if (strcmp(name, "avx2") == 0) return kCpuFeatureSse41 | kCpuFeatureAvx2;
+  if (strcmp(name, "neon") == 0) return kCpuFeatureNeon;
+  return ~uint32_t{0};
+}
+
+uint32_t GetCpuFeatures() {
+  static std::atomic<uint32_t> cache{0};
+  uint32_t value = cache.load(std::memory_order_relaxed);
+  if (PROTOBUF_PREDICT_FALSE(value == 0)) {
+    value = DetectCpuFeatures() &
+            CpuFeatureMaskForDispatchName(getenv("PROTOBUF_CPU_DISPATCH"));
+    value |= kCpuFeaturesResolved;
+    cache.store(value, std::memory_order_relaxed);
+  }
+  return value & ~kCpuFeaturesResolved;
+}
+
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
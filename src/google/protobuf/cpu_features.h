@@ -0,0 +1,80 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef GOOGLE_PROTOBUF_CPU_FEATURES_H__
+#define GOOGLE_PROTOBUF_CPU_FEATURES_H__
+
+#include <atomic>
+#include <cstdint>
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+
+// SIMD extensions that codec kernels select on at run time.  Only features
+// some kernel actually branches on are listed; features that are part of the
+// compilation baseline (SSE2 on x86-64, NEON on AArch64) never need a runtime
+// check and are reported purely so an override can name them.
+enum CpuFeature : uint32_t {
+  kCpuFeatureSse41 = 1u << 0,
+  kCpuFeatureAvx2 = 1u << 1,
+  kCpuFeatureNeon = 1u << 2,
+};
+
+// Returns the bitwise-or of the CpuFeature values supported by the running
+// machine.  Detection runs once and the result is cached.  The
+// PROTOBUF_CPU_DISPATCH environment variable, read on first use, caps the
+// reported set ("generic", "sse4", "avx2" or "neon") so that dispatched
+// kernels can be A/B measured against their fallbacks in the same binary.
+PROTOBUF_EXPORT uint32_t GetCpuFeatures();
+
+inline bool HasCpuFeature(CpuFeature feature) {
+  return (GetCpuFeatures() & feature) != 0;
+}
+
+// Maps a PROTOBUF_CPU_DISPATCH value to the feature mask it permits.
+// Unrecognized names (and nullptr, i.e. the variable being unset) permit
+// everything, so a misspelled override degrades to normal detection rather
+// than silently forcing the scalar kernels.  Exposed for testing.
+PROTOBUF_EXPORT uint32_t CpuFeatureMaskForDispatchName(const char* name);
+
+// A lazily resolved function pointer.  The resolver runs on the first call
+// and the result is cached, so steady-state dispatch is one relaxed load and
+// an indirect call.  Concurrent first calls may each run the resolver, which
+// is harmless because resolvers are deterministic.  The constructor is
+// constexpr so slots in function-local statics are constant-initialized and
+// need no guard variable.
+template <typename FnPtr>
+class CpuDispatchSlot {
+ public:
+  explicit constexpr CpuDispatchSlot(FnPtr (*resolver)())
+      : resolver_(resolver), fn_(nullptr) {}
+
+  FnPtr Get() {
+    FnPtr fn = fn_.load(std::memory_order_relaxed);
+    if (PROTOBUF_PREDICT_FALSE(fn == nullptr)) {
+      fn = resolver_();
+      fn_.store(fn, std::memory_order_relaxed);
+    }
+    return fn;
+  }
+
+ private:
+  FnPtr (*const resolver_)();
+  std::atomic<FnPtr> fn_;
+};
+
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_CPU_FEATURES_H__
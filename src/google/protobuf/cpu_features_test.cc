@@ -0,0 +1,62 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/cpu_features.h"
+
+#include <cstdint>
+
+#include <gtest/gtest.h>
+
+namespace google {
+namespace protobuf {
+namespace internal {
+namespace {
+
+TEST(CpuFeaturesTest, FeatureSetIsStable) {
+  EXPECT_EQ(GetCpuFeatures(), GetCpuFeatures());
+}
+
+TEST(CpuFeaturesTest, HasCpuFeatureMatchesMask) {
+  const uint32_t features = GetCpuFeatures();
+  EXPECT_EQ((features & kCpuFeatureSse41) != 0,
+            HasCpuFeature(kCpuFeatureSse41));
+  EXPECT_EQ((features & kCpuFeatureAvx2) != 0, HasCpuFeature(kCpuFeatureAvx2));
+  EXPECT_EQ((features & kCpuFeatureNeon) != 0, HasCpuFeature(kCpuFeatureNeon));
+}
+
+TEST(CpuFeaturesTest, DispatchNameMasks) {
+  EXPECT_EQ(uint32_t{0}, CpuFeatureMaskForDispatchName("generic"));
+  EXPECT_EQ(uint32_t{kCpuFeatureSse41}, CpuFeatureMaskForDispatchName("sse4"));
+  EXPECT_EQ(uint32_t{kCpuFeatureSse41 | kCpuFeatureAvx2},
+            CpuFeatureMaskForDispatchName("avx2"));
+  EXPECT_EQ(uint32_t{kCpuFeatureNeon}, CpuFeatureMaskForDispatchName("neon"));
+  // An unset or unrecognized override must not cap detection.
+  EXPECT_EQ(~uint32_t{0}, CpuFeatureMaskForDispatchName(nullptr));
+  EXPECT_EQ(~uint32_t{0}, CpuFeatureMaskForDispatchName("not-a-feature"));
+}
+
+int resolver_calls = 0;
+
+int ReturnsSeven() { return 7; }
+
+int (*CountingResolver())() {
+  ++resolver_calls;
+  return ReturnsSeven;
+}
+
+TEST(CpuDispatchSlotTest, ResolvesOnceAndCaches) {
+  resolver_calls = 0;
+  CpuDispatchSlot<int (*)()> slot(CountingResolver);
+  EXPECT_EQ(7, slot.Get()());
+  EXPECT_EQ(7, slot.Get()());
+  EXPECT_EQ(1, resolver_calls);
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
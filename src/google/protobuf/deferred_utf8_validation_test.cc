@@ -0,0 +1,90 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2024 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+// Tests for MessageLite::kDeferUtf8Validation: UTF-8 validation of enforced
+// string fields runs as one batch after the parse loop instead of inline per
+// field.  The outcome must match inline parsing for any payload whose final
+// field values decide validity.
+
+#include <string>
+
+#include <gtest/gtest.h>
+#include "absl/strings/string_view.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/map_unittest.pb.h"
+#include "google/protobuf/message_lite.h"
+#include "google/protobuf/unittest.pb.h"
+#include "google/protobuf/unittest_proto3.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace {
+
+constexpr MessageLite::ParseFlags kDeferredParse =
+    static_cast<MessageLite::ParseFlags>(MessageLite::kParse |
+                                         MessageLite::kDeferUtf8Validation);
+
+TEST(DeferredUtf8ValidationTest, AcceptsValidPayload) {
+  proto3_unittest::TestAllTypes message;
+  message.set_optional_string("valid utf8 \xe2\x98\x83");
+  message.add_repeated_string("more valid utf8");
+  const std::string data = message.SerializeAsString();
+  proto3_unittest::TestAllTypes parsed;
+  EXPECT_TRUE(parsed.ParseFrom<kDeferredParse>(absl::string_view(data)));
+  EXPECT_EQ(parsed.optional_string(), message.optional_string());
+}
+
+TEST(DeferredUtf8ValidationTest, RejectsInvalidSingularString) {
+  // optional_string (field 14) with an invalid UTF-8 payload.
+  const std::string data("\x72\x02\xff\xfe", 4);
+  proto3_unittest::TestAllTypes message;
+  EXPECT_FALSE(message.ParseFrom<kDeferredParse>(absl::string_view(data)));
+}
+
+TEST(DeferredUtf8ValidationTest, RejectsInvalidRepeatedString) {
+  // repeated_string (field 44): one valid element followed by an invalid
+  // one; the batch must catch the second element.
+  const std::string data("\xe2\x02\x02ok\xe2\x02\x02\xff\xfe", 10);
+  proto3_unittest::TestAllTypes message;
+  EXPECT_FALSE(message.ParseFrom<kDeferredParse>(absl::string_view(data)));
+}
+
+TEST(DeferredUtf8ValidationTest, RejectsInvalidUtf8FromStream) {
+  const std::string data("\x72\x02\xff\xfe", 4);
+  io::ArrayInputStream stream(data.data(), static_cast<int>(data.size()));
+  proto3_unittest::TestAllTypes message;
+  io::ZeroCopyInputStream* input = &stream;
+  EXPECT_FALSE(message.ParseFrom<kDeferredParse>(input));
+}
+
+TEST(DeferredUtf8ValidationTest, ValidatesFinalValueOfSingularField) {
+  // Two occurrences of optional_string; last-wins keeps the valid one, and
+  // deferred validation checks the values left in the message.
+  const std::string data("\x72\x02\xff\xfe\x72\x02ok", 8);
+  proto3_unittest::TestAllTypes message;
+  EXPECT_TRUE(message.ParseFrom<kDeferredParse>(absl::string_view(data)));
+  EXPECT_EQ(message.optional_string(), "ok");
+}
+
+TEST(DeferredUtf8ValidationTest, Proto2StaysLogOnly) {
+  // proto2 strings are not enforced, so deferral changes nothing for them.
+  const std::string data("\x72\x02\xff\xfe", 4);
+  unittest::TestAllTypes message;
+  EXPECT_TRUE(message.ParseFrom<kDeferredParse>(absl::string_view(data)));
+}
+
+TEST(DeferredUtf8ValidationTest, MapKeysStayValidatedInline) {
+  // map_string_string (field 14) entry whose key is invalid UTF-8; map
+  // entries keep inline validation and must still be rejected.
+  const std::string data("\x72\x04\x0a\x02\xff\xfe", 6);
+  protobuf_unittest::TestMap message;
+  EXPECT_FALSE(message.ParseFrom<kDeferredParse>(absl::string_view(data)));
+}
+
+}  // namespace
+}  // namespace protobuf
+}  // namespace google
@@ -1218,6 +1218,8 @@ class FileDescriptorTables {
       const void* parent, absl::string_view lowercase_name) const;
   inline const FieldDescriptor* FindFieldByCamelcaseName(
       const void* parent, absl::string_view camelcase_name) const;
+  inline const FieldDescriptor* FindFieldByJsonName(
+      const void* parent, absl::string_view json_name) const;
   inline const EnumValueDescriptor* FindEnumValueByNumber(
       const EnumDescriptor* parent, int number) const;
   // This creates a new EnumValueDescriptor if not found, in a thread-safe way.
@@ -1258,15 +1260,20 @@ class FileDescriptorTables {
   static void FieldsByCamelcaseNamesLazyInitStatic(
       const FileDescriptorTables* tables);
   void FieldsByCamelcaseNamesLazyInitInternal() const;
+  static void FieldsByJsonNamesLazyInitStatic(
+      const FileDescriptorTables* tables);
+  void FieldsByJsonNamesLazyInitInternal() const;
 
   SymbolsByParentSet symbols_by_parent_;
   mutable absl::once_flag fields_by_lowercase_name_once_;
   mutable absl::once_flag fields_by_camelcase_name_once_;
+  mutable absl::once_flag fields_by_json_name_once_;
   // Make these fields atomic to avoid race conditions with
   // GetEstimatedOwnedMemoryBytesSize. Once the pointer is set the map won't
   // change anymore.
   mutable std::atomic<const FieldsByNameMap*> fields_by_lowercase_name_{};
   mutable std::atomic<const FieldsByNameMap*> fields_by_camelcase_name_{};
+  mutable std::atomic<const FieldsByNameMap*> fields_by_json_name_{};
   FieldsByNumberSet fields_by_number_;  // Not including extensions.
   EnumValuesByNumberSet enum_values_by_number_;
   mutable EnumValuesByNumberSet unknown_enum_values_by_number_
@@ -1409,6 +1416,32 @@ class DescriptorPool::Tables {
   bool AddFile(const FileDescriptor* file);
   bool AddExtension(const FieldDescriptor* field);
 
+  // -----------------------------------------------------------------
+  // Replacing files (see DescriptorPool::UpdateFile()).
+
+  // Everything RemoveFileEntries() unhooked for one file, in a form that
+  // RestoreFileEntries() can put back if building the replacement fails.
+  struct RemovedFileEntries {
+    const FileDescriptor* file = nullptr;
+    std::vector<Symbol> symbols;
+    std::vector<std::pair<std::pair<const Descriptor*, int>,
+                          const FieldDescriptor*>>
+        extensions;
+  };
+
+  // True if any built file other than `file` itself lists `file` as a
+  // dependency.
+  bool HasDependentFile(const FileDescriptor* file) const;
+
+  // Unhooks a built file, its non-package symbols and its extensions from
+  // the lookup tables.  Package symbols stay put: they may be shared with
+  // other files, and rebuilding the replacement re-adds them idempotently.
+  // The descriptors themselves stay allocated in the pool.
+  RemovedFileEntries RemoveFileEntries(const FileDescriptor* file);
+
+  // Puts back what RemoveFileEntries() took out.
+  void RestoreFileEntries(const RemovedFileEntries& entries);
+
   // Caches a feature set and returns a stable reference to the cached
   // allocation owned by the pool.
   const FeatureSet* InternFeatureSet(FeatureSet&& features);
@@ -1516,6 +1549,7 @@ FileDescriptorTables::FileDescriptorTables() = default;
 FileDescriptorTables::~FileDescriptorTables() {
   delete fields_by_lowercase_name_.load(std::memory_order_acquire);
   delete fields_by_camelcase_name_.load(std::memory_order_acquire);
+  delete fields_by_json_name_.load(std::memory_order_acquire);
 }
 
 inline const FileDescriptorTables& FileDescriptorTables::GetEmptyInstance() {
@@ -1583,6 +1617,16 @@ inline Symbol FileDescriptorTables::FindNestedSymbol(
 
 Symbol DescriptorPool::Tables::FindByNameHelper(const DescriptorPool* pool,
                                                 absl::string_view name) {
+  if (pool->IsSealed()) {
+    // Sealed pools are immutable: read the tables without locking and never
+    // consult the fallback database.
+    Symbol result = FindSymbol(name);
+    if (result.IsNull() && pool->underlay_ != nullptr) {
+      result =
+          pool->underlay_->tables_->FindByNameHelper(pool->underlay_, name);
+    }
+    return result;
+  }
   if (pool->mutex_ != nullptr) {
     // Fast path: the Symbol is already cached.  This is just a hash lookup.
     absl::ReaderMutexLock lock(pool->mutex_);
@@ -1707,6 +1751,38 @@ inline const FieldDescriptor* FileDescriptorTables::FindFieldByCamelcaseName(
   return it->second;
 }
 
+void FileDescriptorTables::FieldsByJsonNamesLazyInitStatic(
+    const FileDescriptorTables* tables) {
+  tables->FieldsByJsonNamesLazyInitInternal();
+}
+
+void FileDescriptorTables::FieldsByJsonNamesLazyInitInternal() const {
+  auto* map = new FieldsByNameMap;
+  for (Symbol symbol : symbols_by_parent_) {
+    const FieldDescriptor* field = symbol.field_descriptor();
+    if (!field) continue;
+    const void* parent = FindParentForFieldsByMap(field);
+    // If we already have a field with this JSON name, keep the field with
+    // the smallest field number. This way we get a deterministic mapping.
+    const FieldDescriptor*& found =
+        (*map)[{parent, field->json_name().c_str()}];
+    if (found == nullptr || found->number() > field->number()) {
+      found = field;
+    }
+  }
+  fields_by_json_name_.store(map, std::memory_order_release);
+}
+
+inline const FieldDescriptor* FileDescriptorTables::FindFieldByJsonName(
+    const void* parent, absl::string_view json_name) const {
+  absl::call_once(fields_by_json_name_once_,
+                  FileDescriptorTables::FieldsByJsonNamesLazyInitStatic, this);
+  auto* fields = fields_by_json_name_.load(std::memory_order_acquire);
+  auto it = fields->find({parent, json_name});
+  if (it == fields->end()) return nullptr;
+  return it->second;
+}
+
 inline const EnumValueDescriptor* FileDescriptorTables::FindEnumValueByNumber(
     const EnumDescriptor* parent, int number) const {
   // If `number` is within the sequential range, just index into the parent
@@ -1866,6 +1942,52 @@ bool DescriptorPool::Tables::AddExtension(const FieldDescriptor* field) {
   }
 }
 
+bool DescriptorPool::Tables::HasDependentFile(
+    const FileDescriptor* file) const {
+  for (const FileDescriptor* other : files_by_name_) {
+    if (other == file) continue;
+    for (int i = 0; i < other->dependency_count(); i++) {
+      if (other->dependency(i) == file) return true;
+    }
+  }
+  return false;
+}
+
+DescriptorPool::Tables::RemovedFileEntries
+DescriptorPool::Tables::RemoveFileEntries(const FileDescriptor* file) {
+  RemovedFileEntries removed;
+  removed.file = file;
+  for (auto it = symbols_by_name_.begin(); it != symbols_by_name_.end();) {
+    if (!it->IsPackage() && it->GetFile() == file) {
+      removed.symbols.push_back(*it);
+      symbols_by_name_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+  for (auto it = extensions_.begin(); it != extensions_.end();) {
+    if (it->second->file() == file) {
+      removed.extensions.push_back(*it);
+      it = extensions_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  files_by_name_.erase(file);
+  return removed;
+}
+
+void DescriptorPool::Tables::RestoreFileEntries(
+    const RemovedFileEntries& entries) {
+  files_by_name_.insert(entries.file);
+  for (const Symbol& symbol : entries.symbols) {
+    symbols_by_name_.insert(symbol);
+  }
+  for (const auto& extension : entries.extensions) {
+    extensions_.insert(extension);
+  }
+}
+
 const FeatureSet* DescriptorPool::Tables::InternFeatureSet(
     FeatureSet&& features) {
   // Use the serialized feature set as the cache key.  If multiple equivalent
@@ -2133,6 +2255,14 @@ void DescriptorPool::InternalAddGeneratedFile(
 
 const FileDescriptor* DescriptorPool::FindFileByName(
     absl::string_view name) const {
+  if (IsSealed()) {
+    // See FindByNameHelper: sealed pools read immutable tables lock-free.
+    const FileDescriptor* result = tables_->FindFile(name);
+    if (result == nullptr && underlay_ != nullptr) {
+      result = underlay_->FindFileByName(name);
+    }
+    return result;
+  }
   absl::MutexLockMaybe lock(mutex_);
   if (fallback_database_ != nullptr) {
     tables_->known_bad_symbols_.clear();
@@ -2368,6 +2498,17 @@ const FieldDescriptor* Descriptor::FindFieldByCamelcaseName(
   }
 }
 
+const FieldDescriptor* Descriptor::FindFieldByJsonName(
+    absl::string_view json_name) const {
+  const FieldDescriptor* result =
+      file()->tables_->FindFieldByJsonName(this, json_name);
+  if (result == nullptr || result->is_extension()) {
+    return nullptr;
+  } else {
+    return result;
+  }
+}
+
 const FieldDescriptor* Descriptor::FindFieldByName(
     absl::string_view name) const {
   const FieldDescriptor* field =
@@ -2436,6 +2577,114 @@ const FieldDescriptor* Descriptor::map_value() const {
   return field(1);
 }
 
+namespace {
+
+// The fingerprint is FNV-1a rather than absl hashing because it has to be
+// stable across processes: absl hashes are seeded per process, but these
+// values are used as cache keys that may be shared between binaries.
+constexpr uint64_t kFingerprintBasis = uint64_t{0xcbf29ce484222325};
+constexpr uint64_t kFingerprintPrime = uint64_t{0x100000001b3};
+
+uint64_t FingerprintMix(uint64_t h, uint64_t value) {
+  for (int i = 0; i < 8; ++i) {
+    h = (h ^ (value & 0xff)) * kFingerprintPrime;
+    value >>= 8;
+  }
+  return h;
+}
+
+uint64_t FingerprintMix(uint64_t h, absl::string_view value) {
+  for (const char c : value) {
+    h = (h ^ static_cast<uint8_t>(c)) * kFingerprintPrime;
+  }
+  // Mix the length so that adjacent strings can't alias each other.
+  return FingerprintMix(h, value.size());
+}
+
+// Computes the structural fingerprint of `message`.  `visiting` holds the
+// messages on the current walk; a message reached again through one of its
+// own fields contributes only its full name, which breaks the recursion
+// while still distinguishing which type closes the cycle.
+uint64_t FingerprintMessage(const Descriptor& message,
+                            absl::flat_hash_set<const Descriptor*>* visiting) {
+  uint64_t h = FingerprintMix(kFingerprintBasis, message.full_name());
+  if (!visiting->insert(&message).second) {
+    return h;
+  }
+
+  // Walk fields in number order so that declaration order, which does not
+  // affect the wire format, does not affect the fingerprint.
+  std::vector<const FieldDescriptor*> fields;
+  fields.reserve(message.field_count());
+  for (int i = 0; i < message.field_count(); ++i) {
+    fields.push_back(message.field(i));
+  }
+  std::sort(fields.begin(), fields.end(),
+            [](const FieldDescriptor* a, const FieldDescriptor* b) {
+              return a->number() < b->number();
+            });
+
+  for (const FieldDescriptor* field : fields) {
+    h = FingerprintMix(h, static_cast<uint64_t>(field->number()));
+    h = FingerprintMix(h, static_cast<uint64_t>(field->type()));
+    h = FingerprintMix(h, field->is_required()   ? uint64_t{2}
+                          : field->is_repeated() ? uint64_t{1}
+                                                 : uint64_t{0});
+    h = FingerprintMix(h, field->is_packed() ? uint64_t{1} : uint64_t{0});
+    switch (field->type()) {
+      case FieldDescriptor::TYPE_MESSAGE:
+      case FieldDescriptor::TYPE_GROUP:
+        h = FingerprintMix(h,
+                           FingerprintMessage(*field->message_type(), visiting));
+        break;
+      case FieldDescriptor::TYPE_ENUM:
+        h = FingerprintMix(h, field->enum_type()->full_name());
+        break;
+      default:
+        break;
+    }
+  }
+
+  visiting->erase(&message);
+  return h;
+}
+
+// Zero is reserved as the "not computed yet" sentinel in the cached member.
+uint64_t FingerprintAvoidingSentinel(uint64_t h) { return h == 0 ? 1 : h; }
+
+}  // namespace
+
+uint64_t Descriptor::Fingerprint() const {
+  uint64_t cached = fingerprint_.load(std::memory_order_relaxed);
+  if (cached != 0) return cached;
+  absl::flat_hash_set<const Descriptor*> visiting;
+  // Computation is deterministic, so concurrent first calls all store the
+  // same value and relaxed ordering suffices.
+  cached = FingerprintAvoidingSentinel(FingerprintMessage(*this, &visiting));
+  fingerprint_.store(cached, std::memory_order_relaxed);
+  return cached;
+}
+
+uint64_t FileDescriptor::Fingerprint() const {
+  uint64_t cached = fingerprint_.load(std::memory_order_relaxed);
+  if (cached != 0) return cached;
+  uint64_t h = FingerprintMix(kFingerprintBasis, name());
+  h = FingerprintMix(h, package());
+  for (int i = 0; i < message_type_count(); ++i) {
+    h = FingerprintMix(h, message_type(i)->Fingerprint());
+  }
+  for (int i = 0; i < enum_type_count(); ++i) {
+    h = FingerprintMix(h, enum_type(i)->full_name());
+  }
+  for (int i = 0; i < extension_count(); ++i) {
+    h = FingerprintMix(h, static_cast<uint64_t>(extension(i)->number()));
+    h = FingerprintMix(h, extension(i)->full_name());
+  }
+  cached = FingerprintAvoidingSentinel(h);
+  fingerprint_.store(cached, std::memory_order_relaxed);
+  return cached;
+}
+
 const EnumValueDescriptor* EnumDescriptor::FindValueByName(
     absl::string_view name) const {
   return file()->tables_->FindNestedSymbol(this, name).enum_value_descriptor();
@@ -3765,20 +4014,11 @@ bool EnumDescriptor::is_closed() const {
   return features().enum_type() == FeatureSet::CLOSED;
 }
 
-bool FieldDescriptor::is_packed() const {
-  if (!is_packable()) return false;
-  return features().repeated_field_encoding() == FeatureSet::PACKED;
-}
-
 static bool IsStrictUtf8(const FieldDescriptor* field) {
   return internal::InternalFeatureHelper::GetFeatures(*field)
              .utf8_validation() == FeatureSet::VERIFY;
 }
 
-bool FieldDescriptor::requires_utf8_validation() const {
-  return type() == TYPE_STRING && IsStrictUtf8(this);
-}
-
 bool FieldDescriptor::has_presence() const {
   if (is_repeated()) return false;
   return cpp_type() == CPPTYPE_MESSAGE || is_extension() ||
@@ -4545,9 +4785,60 @@ const FileDescriptor* DescriptorPool::BuildFileCollectingErrors(
       ->BuildFile(proto);
 }
 
+const FileDescriptor* DescriptorPool::UpdateFile(
+    const FileDescriptorProto& proto) {
+  return UpdateFileCollectingErrors(proto, nullptr);
+}
+
+const FileDescriptor* DescriptorPool::UpdateFileCollectingErrors(
+    const FileDescriptorProto& proto, ErrorCollector* error_collector) {
+  ABSL_CHECK(fallback_database_ == nullptr)
+      << "Cannot call UpdateFile on a DescriptorPool that uses a "
+         "DescriptorDatabase.  You must instead find a way to update your "
+         "file in the underlying database.";
+  ABSL_CHECK(mutex_ == nullptr);  // Implied by the above ABSL_CHECK.
+  ABSL_CHECK(!IsSealed())
+      << "Cannot call UpdateFile on a sealed DescriptorPool.";
+  const FileDescriptor* existing = tables_->FindFile(proto.name());
+  if (existing == nullptr) {
+    return BuildFileCollectingErrors(proto, error_collector);
+  }
+  if (tables_->HasDependentFile(existing)) {
+    // Files importing this one hold pointers into the old version; their
+    // descriptors cannot be patched to agree with the replacement.
+    const std::string message =
+        "Cannot update a file which other built files import.";
+    if (error_collector == nullptr) {
+      ABSL_LOG(ERROR) << "Invalid proto descriptor for file \"" << proto.name()
+                      << "\": " << message;
+    } else {
+      error_collector->RecordError(proto.name(), proto.name(), nullptr,
+                                   ErrorCollector::OTHER, message);
+    }
+    return nullptr;
+  }
+  tables_->known_bad_symbols_.clear();
+  tables_->known_bad_files_.clear();
+  build_started_ = true;
+  Tables::RemovedFileEntries removed = tables_->RemoveFileEntries(existing);
+  const FileDescriptor* result =
+      DescriptorBuilder::New(this, tables_.get(), error_collector)
+          ->BuildFile(proto);
+  if (result == nullptr) {
+    // The replacement did not build; hook the old version back up so the
+    // pool is exactly as it was.
+    tables_->RestoreFileEntries(removed);
+  }
+  return result;
+}
+
 const FileDescriptor* DescriptorPool::BuildFileFromDatabase(
     const FileDescriptorProto& proto) const {
   mutex_->AssertHeld();
+  if (IsSealed()) {
+    // Sealed pools must not lazily build new files; treat as not found.
+    return nullptr;
+  }
   build_started_ = true;
   if (tables_->known_bad_files_.contains(proto.name())) {
     return nullptr;
@@ -5388,6 +5679,15 @@ void DescriptorBuilder::PostProcessFieldFeatures(FieldDescriptor& field) {
       field.features().message_encoding() == FeatureSet::DELIMITED) {
     field.type_ = FieldDescriptor::TYPE_GROUP;
   }
+  // Precompute the hot option and feature bits now that options are
+  // interpreted and features resolved, so that is_packed(),
+  // requires_utf8_validation() and cpp_string_type() never have to touch the
+  // option protos at run time.
+  field.is_repeated_encoding_packed_ =
+      field.features().repeated_field_encoding() == FeatureSet::PACKED;
+  field.verify_utf8_ =
+      field.features().utf8_validation() == FeatureSet::VERIFY;
+  field.cpp_string_type_ = static_cast<uint8_t>(field.options().ctype());
 }
 
 // A common pattern:  We want to convert a repeated field in the descriptor
@@ -5698,6 +5998,7 @@ FileDescriptor* DescriptorBuilder::BuildFileImpl(
 
   result->is_placeholder_ = false;
   result->finished_building_ = false;
+  result->fingerprint_.store(0, std::memory_order_relaxed);
   SourceCodeInfo* info = nullptr;
   if (proto.has_source_code_info()) {
     info = alloc.AllocateArray<SourceCodeInfo>(1);
@@ -6030,6 +6331,7 @@ void DescriptorBuilder::BuildMessage(const DescriptorProto& proto,
   result->is_placeholder_ = false;
   result->is_unqualified_placeholder_ = false;
   result->well_known_type_ = Descriptor::WELLKNOWNTYPE_UNSPECIFIED;
+  result->fingerprint_.store(0, std::memory_order_relaxed);
   result->options_ = nullptr;  // Set to default_instance later if necessary.
 
   auto it = pool_->tables_->well_known_types_.find(result->full_name());
@@ -6322,6 +6624,13 @@ void DescriptorBuilder::BuildFieldOrExtension(const FieldDescriptorProto& proto,
 
   result->has_json_name_ = proto.has_json_name();
 
+  // Overwritten by PostProcessFieldFeatures() once options are interpreted
+  // and features resolved; initialized here so the bits are never read
+  // uninitialized on error paths.
+  result->is_repeated_encoding_packed_ = false;
+  result->verify_utf8_ = false;
+  result->cpp_string_type_ = 0;
+
   // Some compilers do not allow static_cast directly between two enum types,
   // so we must cast to int first.
   result->type_ = static_cast<FieldDescriptor::Type>(
@@ -9338,6 +9647,60 @@ Symbol DescriptorPool::CrossLinkOnDemandHelper(absl::string_view name,
   return result;
 }
 
+namespace {
+
+// Touches every accessor that can hide a deferred cross-link, forcing its
+// once-init.  See DescriptorPool::WarmDependencies().
+void WarmField(const FieldDescriptor* field) {
+  field->message_type();
+  field->enum_type();
+  field->default_value_enum();
+}
+
+void WarmMessage(const Descriptor* message) {
+  for (int i = 0; i < message->field_count(); ++i) {
+    WarmField(message->field(i));
+  }
+  for (int i = 0; i < message->extension_count(); ++i) {
+    WarmField(message->extension(i));
+  }
+  for (int i = 0; i < message->nested_type_count(); ++i) {
+    WarmMessage(message->nested_type(i));
+  }
+}
+
+void WarmFile(const FileDescriptor* file,
+              absl::flat_hash_set<const FileDescriptor*>* visited) {
+  if (!visited->insert(file).second) return;
+  for (int i = 0; i < file->message_type_count(); ++i) {
+    WarmMessage(file->message_type(i));
+  }
+  for (int i = 0; i < file->extension_count(); ++i) {
+    WarmField(file->extension(i));
+  }
+  for (int i = 0; i < file->service_count(); ++i) {
+    const ServiceDescriptor* service = file->service(i);
+    for (int j = 0; j < service->method_count(); ++j) {
+      service->method(j)->input_type();
+      service->method(j)->output_type();
+    }
+  }
+  // dependency(i) itself resolves the import; recursing builds out a deep
+  // import chain in one pass.
+  for (int i = 0; i < file->dependency_count(); ++i) {
+    const FileDescriptor* dependency = file->dependency(i);
+    if (dependency != nullptr) WarmFile(dependency, visited);
+  }
+}
+
+}  // namespace
+
+void DescriptorPool::WarmDependencies(const FileDescriptor* file) const {
+  if (!lazily_build_dependencies_ || file == nullptr) return;
+  absl::flat_hash_set<const FileDescriptor*> visited;
+  WarmFile(file, &visited);
+}
+
 // Handle the lazy import building for a message field whose type wasn't built
 // at cross link time. If that was the case, we saved the name of the type to
 // be looked up when the accessor for the type was called. Set type_,
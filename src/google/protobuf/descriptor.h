@@ -392,6 +392,17 @@ class PROTOBUF_EXPORT Descriptor : private internal::SymbolBase {
 
   WellKnownType well_known_type() const;
 
+  // Returns a 64-bit structural fingerprint of this message type, suitable
+  // for keying caches of schema-derived artifacts.  The fingerprint covers
+  // the properties that determine wire compatibility: field numbers, types,
+  // cardinality and packedness, recursing into message-typed fields.  It is
+  // stable across processes and pools: descriptors built from equivalent
+  // .proto definitions fingerprint equally, regardless of how they were
+  // loaded.  It is never zero and is not a cryptographic hash; do not rely
+  // on it for integrity checks.  The result is computed on first use and
+  // cached in the descriptor, so subsequent calls are a single atomic load.
+  uint64_t Fingerprint() const;
+
   // Field stuff -----------------------------------------------------
 
   // The number of fields in this message type.
@@ -419,6 +430,13 @@ class PROTOBUF_EXPORT Descriptor : private internal::SymbolBase {
   const FieldDescriptor* FindFieldByCamelcaseName(
       absl::string_view camelcase_name) const;
 
+  // Looks up a field by JSON name (as returned by json_name()): the
+  // camel-case name unless json_name was explicitly set in the .proto file.
+  // This lookup may be ambiguous if multiple fields have the same JSON name,
+  // in which case the field returned is chosen arbitrarily from the matches.
+  const FieldDescriptor* FindFieldByJsonName(
+      absl::string_view json_name) const;
+
   // The number of oneofs in this message type.
   int oneof_decl_count() const;
   // The number of oneofs in this message type, excluding synthetic oneofs.
@@ -713,6 +731,9 @@ class PROTOBUF_EXPORT Descriptor : private internal::SymbolBase {
   int reserved_range_count_;
   int reserved_name_count_;
 
+  // Cached result of Fingerprint().  Zero means "not computed yet".
+  mutable std::atomic<uint64_t> fingerprint_;
+
   // IMPORTANT:  If you add a new field, make sure to search for all instances
   // of Allocate<Descriptor>() and AllocateArray<Descriptor>() in descriptor.cc
   // and update them to initialize the field.
@@ -729,7 +750,7 @@ class PROTOBUF_EXPORT Descriptor : private internal::SymbolBase {
   friend class FileDescriptor;
 };
 
-PROTOBUF_INTERNAL_CHECK_CLASS_SIZE(Descriptor, 152);
+PROTOBUF_INTERNAL_CHECK_CLASS_SIZE(Descriptor, 160);
 
 // Describes a single field of a message.  To get the descriptor for a given
 // field, first get the Descriptor for the message in which it is defined,
@@ -870,6 +891,17 @@ class PROTOBUF_EXPORT FieldDescriptor : private internal::SymbolBase,
   // are packed by default unless `packed = false` is specified.
   bool is_packed() const;
 
+  // The in-memory string representation selected by options().ctype(),
+  // precomputed when the descriptor is built so that hot paths can branch on
+  // it without dereferencing the options proto.  Enumerator values mirror
+  // FieldOptions::CType.  Only meaningful when cpp_type() == CPPTYPE_STRING.
+  enum class CppStringType {
+    kString = 0,       // FieldOptions::STRING
+    kCord = 1,         // FieldOptions::CORD
+    kStringPiece = 2,  // FieldOptions::STRING_PIECE
+  };
+  CppStringType cpp_string_type() const;
+
   // Returns true if this field tracks presence, ie. does the field
   // distinguish between "unset" and "present with default value."
   // This includes required, optional, and oneof fields. It excludes maps,
@@ -1099,6 +1131,12 @@ class PROTOBUF_EXPORT FieldDescriptor : private internal::SymbolBase,
   uint8_t lowercase_name_index_ : 2;
   uint8_t camelcase_name_index_ : 2;
   uint8_t json_name_index_ : 3;
+  // Hot option and feature bits, precomputed by DescriptorBuilder so that the
+  // corresponding accessors do not have to chase the options or feature
+  // protos at run time.
+  bool is_repeated_encoding_packed_ : 1;
+  bool verify_utf8_ : 1;
+  uint8_t cpp_string_type_ : 2;
   // Sadly, `number_` located here to reduce padding. Unrelated to all_names_
   // and its indices above.
   int number_;
@@ -1916,6 +1954,11 @@ class PROTOBUF_EXPORT FileDescriptor : private internal::SymbolBase {
   // with AllowUnknownDependencies() set.
   bool is_placeholder() const;
 
+  // Returns a 64-bit structural fingerprint covering this file's name,
+  // package and the fingerprints of its top-level types and extensions.
+  // See Descriptor::Fingerprint() for the guarantees made.
+  uint64_t Fingerprint() const;
+
   // Updates |*out_location| to the source location of the complete extent of
   // this file declaration (namely, the empty path).
   bool GetSourceLocation(SourceLocation* out_location) const;
@@ -1986,6 +2029,9 @@ class PROTOBUF_EXPORT FileDescriptor : private internal::SymbolBase {
   const FileDescriptorTables* tables_;
   const SourceCodeInfo* source_code_info_;
 
+  // Cached result of Fingerprint().  Zero means "not computed yet".
+  mutable std::atomic<uint64_t> fingerprint_;
+
   // IMPORTANT:  If you add a new field, make sure to search for all instances
   // of Allocate<FileDescriptor>() and AllocateArray<FileDescriptor>() in
   // descriptor.cc and update them to initialize the field.
@@ -2003,7 +2049,7 @@ class PROTOBUF_EXPORT FileDescriptor : private internal::SymbolBase {
   friend class ServiceDescriptor;
 };
 
-PROTOBUF_INTERNAL_CHECK_CLASS_SIZE(FileDescriptor, 168);
+PROTOBUF_INTERNAL_CHECK_CLASS_SIZE(FileDescriptor, 176);
 
 // ===================================================================
 
@@ -2190,12 +2236,42 @@ class PROTOBUF_EXPORT DescriptorPool {
   // the pool.  Returns the resulting FileDescriptor, or nullptr if there were
   // problems with the input (e.g. the message was invalid, or dependencies
   // were missing).  Details about the errors are written to ABSL_LOG(ERROR).
+  //
+  // Building is inherently single-threaded per pool: descriptors are
+  // cross-linked through the pool's shared symbol and file tables as they
+  // are built, so independent files cannot be built into private tables on
+  // worker threads and merged afterwards.  To parallelize startup, shard
+  // files with disjoint dependency subtrees across separate DescriptorPool
+  // instances built on their own threads, or rely on lazy on-demand
+  // building from a DescriptorDatabase (as the generated pool does) and
+  // Seal() the pool once loading is complete to make lookups lock-free.
   const FileDescriptor* BuildFile(const FileDescriptorProto& proto);
 
   // Same as BuildFile() except errors are sent to the given ErrorCollector.
   const FileDescriptor* BuildFileCollectingErrors(
       const FileDescriptorProto& proto, ErrorCollector* error_collector);
 
+  // Replaces a previously built file with a new version of it, without
+  // rebuilding the rest of the pool.  The new file is built normally; on
+  // success, name lookups atomically resolve to the new descriptors while
+  // every other file's descriptors -- and any caches keyed on them, such as
+  // DynamicMessageFactory prototypes and their parse tables -- are left
+  // untouched.  If the file is not in the pool yet, this is plain
+  // BuildFile().  Returns nullptr and leaves the old version in place if
+  // the new file fails to build, or if another built file imports this one
+  // (its descriptors hold pointers into the old version and cannot be
+  // patched).
+  //
+  // The caller is responsible for only installing compatible updates (e.g.
+  // a new field added): descriptors of the old version stay alive for the
+  // pool's lifetime and previously obtained pointers keep working, but they
+  // describe the old schema and are no longer found by name lookups.
+  const FileDescriptor* UpdateFile(const FileDescriptorProto& proto);
+
+  // Same as UpdateFile() except errors are sent to the given ErrorCollector.
+  const FileDescriptor* UpdateFileCollectingErrors(
+      const FileDescriptorProto& proto, ErrorCollector* error_collector);
+
   // By default, it is an error if a FileDescriptorProto contains references
   // to types or other files that are not found in the DescriptorPool (or its
   // backing DescriptorDatabase, if any).  If you call
@@ -2234,6 +2310,21 @@ class PROTOBUF_EXPORT DescriptorPool {
     enforce_extension_declarations_ = enforce;
   }
 
+  // Seals the pool against further lazy loading and enables lock-free name
+  // lookups. After Seal(), symbol and file tables are treated as immutable:
+  // the hot lookup paths (FindMessageTypeByName() and friends,
+  // FindFileByName()) read them without taking the pool's mutex, and the
+  // pool never falls back to its DescriptorDatabase to build new files.
+  // Call this once every descriptor the process needs has been loaded (e.g.
+  // by eagerly resolving all types at startup); symbols that were never
+  // loaded will no longer be found. Sealing a pool without a fallback
+  // database only turns off the (already lock-free) fallback probing.
+  // Sealing cannot be undone.
+  void Seal() { sealed_.store(true, std::memory_order_release); }
+
+  // Returns true if Seal() has been called on this pool.
+  bool IsSealed() const { return sealed_.load(std::memory_order_acquire); }
+
 #ifndef SWIG
   // Dispatch recursive builds to a callback that may stick them onto a separate
   // thread.  This is primarily to avoid stack overflows on untrusted inputs.
@@ -2325,6 +2416,18 @@ class PROTOBUF_EXPORT DescriptorPool {
     InternalDontEnforceDependencies();
   }
 
+  // Companion to InternalSetLazilyBuildDependencies(): eagerly resolves
+  // every lazily deferred reference reachable from `file` -- imported
+  // files, field message/enum types and enum defaults, and service method
+  // types -- transitively through its imports.  In lazy mode each deferred
+  // resolution takes the pool mutex when first touched, so a serving
+  // thread that trips over an unbuilt dependency stalls every other thread
+  // using the pool; calling this off the serving path after loading a file
+  // moves those builds out of traffic.  Resolutions are once-only, so the
+  // call is idempotent and safe to run concurrently with serving.  A no-op
+  // for pools not in lazy mode.
+  void WarmDependencies(const FileDescriptor* file) const;
+
   // For internal use only.
   void internal_set_underlay(const DescriptorPool* underlay) {
     underlay_ = underlay;
@@ -2432,6 +2535,7 @@ class PROTOBUF_EXPORT DescriptorPool {
   bool disallow_enforce_utf8_;
   bool deprecated_legacy_json_field_conflicts_;
   mutable bool build_started_ = false;
+  std::atomic<bool> sealed_{false};
 
   // Set of files to track for unused imports. The bool value when true means
   // unused imports are treated as errors (and as warnings when false).
@@ -2682,6 +2786,18 @@ inline bool FieldDescriptor::is_packable() const {
   return is_repeated() && IsTypePackable(type());
 }
 
+inline bool FieldDescriptor::is_packed() const {
+  return is_packable() && is_repeated_encoding_packed_;
+}
+
+inline bool FieldDescriptor::requires_utf8_validation() const {
+  return type() == TYPE_STRING && verify_utf8_;
+}
+
+inline FieldDescriptor::CppStringType FieldDescriptor::cpp_string_type() const {
+  return static_cast<CppStringType>(cpp_string_type_);
+}
+
 inline bool FieldDescriptor::is_map() const {
   return type() == TYPE_MESSAGE && is_map_message_type();
 }
@@ -12,6 +12,8 @@
 #include "google/protobuf/descriptor_database.h"
 
 #include <algorithm>
+#include <cstdint>
+#include <limits>
 #include <string>
 #include <utility>
 #include <vector>
@@ -541,8 +543,315 @@ class EncodedDescriptorDatabase::DescriptorIndex {
   std::vector<ExtensionEntry> by_extension_flat_;
 };
 
+namespace {
+
+// Lightweight, allocation-light stand-ins for the slices of
+// FileDescriptorProto that DescriptorIndex::AddFile() reads.  Indexing a file
+// only needs a handful of names, but EncodedDescriptorDatabase::Add() used to
+// parse the entire FileDescriptorProto to get at them, which dominated
+// startup in binaries registering thousands of generated files.  These views
+// are filled by a direct scan of the wire bytes instead; the string_views
+// alias the encoded buffer, which must outlive the database anyway.
+struct EncodedExtensionView {
+  absl::string_view name_;
+  absl::string_view extendee_;
+  int number_ = 0;
+
+  absl::string_view name() const { return name_; }
+  absl::string_view extendee() const { return extendee_; }
+  int number() const { return number_; }
+};
+
+struct EncodedMessageView {
+  absl::string_view name_;
+  std::vector<EncodedMessageView> nested_type_;
+  std::vector<EncodedExtensionView> extension_;
+
+  absl::string_view name() const { return name_; }
+  const std::vector<EncodedMessageView>& nested_type() const {
+    return nested_type_;
+  }
+  const std::vector<EncodedExtensionView>& extension() const {
+    return extension_;
+  }
+};
+
+struct EncodedNamedView {
+  absl::string_view name_;
+
+  absl::string_view name() const { return name_; }
+};
+
+struct EncodedFileView {
+  absl::string_view name_;
+  absl::string_view package_;
+  std::vector<EncodedMessageView> message_type_;
+  std::vector<EncodedNamedView> enum_type_;
+  std::vector<EncodedNamedView> service_;
+  std::vector<EncodedExtensionView> extension_;
+
+  absl::string_view name() const { return name_; }
+  absl::string_view package() const { return package_; }
+  const std::vector<EncodedMessageView>& message_type() const {
+    return message_type_;
+  }
+  const std::vector<EncodedNamedView>& enum_type() const { return enum_type_; }
+  const std::vector<EncodedNamedView>& service() const { return service_; }
+  const std::vector<EncodedExtensionView>& extension() const {
+    return extension_;
+  }
+};
+
+// Mirrors CodedInputStream's default recursion limit; deeper nesting falls
+// back to the full parse, which enforces its own limit.
+constexpr int kScanRecursionLimit = 100;
+
+bool ScanVarint(const char** pp, const char* end, uint64_t* out) {
+  const char* ptr = *pp;
+  uint64_t result = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (ptr == end) return false;
+    uint64_t byte = static_cast<uint8_t>(*ptr++);
+    result |= (byte & 0x7f) << shift;
+    if (byte < 0x80) {
+      *pp = ptr;
+      *out = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ScanLengthDelimited(const char** pp, const char* end,
+                         absl::string_view* out) {
+  uint64_t length;
+  if (!ScanVarint(pp, end, &length) ||
+      length > static_cast<uint64_t>(end - *pp)) {
+    return false;
+  }
+  *out = absl::string_view(*pp, static_cast<size_t>(length));
+  *pp += length;
+  return true;
+}
+
+// Skips a field with the given tag, including nested groups.
+bool SkipScannedField(const char** pp, const char* end, uint32_t tag,
+                      int depth) {
+  if (depth > kScanRecursionLimit) return false;
+  uint64_t unused;
+  absl::string_view unused_view;
+  switch (tag & 7) {
+    case internal::WireFormatLite::WIRETYPE_VARINT:
+      return ScanVarint(pp, end, &unused);
+    case internal::WireFormatLite::WIRETYPE_FIXED64:
+      if (end - *pp < 8) return false;
+      *pp += 8;
+      return true;
+    case internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED:
+      return ScanLengthDelimited(pp, end, &unused_view);
+    case internal::WireFormatLite::WIRETYPE_START_GROUP:
+      while (true) {
+        uint64_t inner_tag;
+        if (!ScanVarint(pp, end, &inner_tag) || inner_tag == 0 ||
+            inner_tag > std::numeric_limits<uint32_t>::max()) {
+          return false;
+        }
+        if ((inner_tag & 7) ==
+            internal::WireFormatLite::WIRETYPE_END_GROUP) {
+          return inner_tag >> 3 == tag >> 3;
+        }
+        if (!SkipScannedField(pp, end, static_cast<uint32_t>(inner_tag),
+                              depth + 1)) {
+          return false;
+        }
+      }
+    case internal::WireFormatLite::WIRETYPE_FIXED32:
+      if (end - *pp < 4) return false;
+      *pp += 4;
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool ScanExtension(absl::string_view data, EncodedExtensionView* out) {
+  const char* ptr = data.data();
+  const char* end = ptr + data.size();
+  while (ptr != end) {
+    uint64_t tag;
+    if (!ScanVarint(&ptr, end, &tag) || tag < 8 ||
+        tag > std::numeric_limits<uint32_t>::max()) {
+      return false;
+    }
+    switch (tag) {
+      case internal::WireFormatLite::MakeTag(
+          FieldDescriptorProto::kNameFieldNumber,
+          internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED):
+        if (!ScanLengthDelimited(&ptr, end, &out->name_)) return false;
+        break;
+      case internal::WireFormatLite::MakeTag(
+          FieldDescriptorProto::kExtendeeFieldNumber,
+          internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED):
+        if (!ScanLengthDelimited(&ptr, end, &out->extendee_)) return false;
+        break;
+      case internal::WireFormatLite::MakeTag(
+          FieldDescriptorProto::kNumberFieldNumber,
+          internal::WireFormatLite::WIRETYPE_VARINT): {
+        uint64_t number;
+        if (!ScanVarint(&ptr, end, &number)) return false;
+        out->number_ = static_cast<int>(number);
+        break;
+      }
+      default:
+        if (!SkipScannedField(&ptr, end, static_cast<uint32_t>(tag), 0)) {
+          return false;
+        }
+    }
+  }
+  return true;
+}
+
+bool ScanName(absl::string_view data, absl::string_view* name) {
+  const char* ptr = data.data();
+  const char* end = ptr + data.size();
+  while (ptr != end) {
+    uint64_t tag;
+    if (!ScanVarint(&ptr, end, &tag) || tag < 8 ||
+        tag > std::numeric_limits<uint32_t>::max()) {
+      return false;
+    }
+    if (tag == internal::WireFormatLite::MakeTag(
+                   1, internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED)) {
+      if (!ScanLengthDelimited(&ptr, end, name)) return false;
+    } else if (!SkipScannedField(&ptr, end, static_cast<uint32_t>(tag), 0)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ScanMessage(absl::string_view data, EncodedMessageView* out, int depth) {
+  if (depth > kScanRecursionLimit) return false;
+  const char* ptr = data.data();
+  const char* end = ptr + data.size();
+  while (ptr != end) {
+    uint64_t tag;
+    if (!ScanVarint(&ptr, end, &tag) || tag < 8 ||
+        tag > std::numeric_limits<uint32_t>::max()) {
+      return false;
+    }
+    absl::string_view payload;
+    switch (tag) {
+      case internal::WireFormatLite::MakeTag(
+          DescriptorProto::kNameFieldNumber,
+          internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED):
+        if (!ScanLengthDelimited(&ptr, end, &out->name_)) return false;
+        break;
+      case internal::WireFormatLite::MakeTag(
+          DescriptorProto::kNestedTypeFieldNumber,
+          internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED):
+        out->nested_type_.emplace_back();
+        if (!ScanLengthDelimited(&ptr, end, &payload) ||
+            !ScanMessage(payload, &out->nested_type_.back(), depth + 1)) {
+          return false;
+        }
+        break;
+      case internal::WireFormatLite::MakeTag(
+          DescriptorProto::kExtensionFieldNumber,
+          internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED):
+        out->extension_.emplace_back();
+        if (!ScanLengthDelimited(&ptr, end, &payload) ||
+            !ScanExtension(payload, &out->extension_.back())) {
+          return false;
+        }
+        break;
+      default:
+        if (!SkipScannedField(&ptr, end, static_cast<uint32_t>(tag), 0)) {
+          return false;
+        }
+    }
+  }
+  return true;
+}
+
+bool ScanFile(const void* data, int size, EncodedFileView* out) {
+  const char* ptr = static_cast<const char*>(data);
+  const char* end = ptr + size;
+  while (ptr != end) {
+    uint64_t tag;
+    if (!ScanVarint(&ptr, end, &tag) || tag < 8 ||
+        tag > std::numeric_limits<uint32_t>::max()) {
+      return false;
+    }
+    absl::string_view payload;
+    switch (tag) {
+      case internal::WireFormatLite::MakeTag(
+          FileDescriptorProto::kNameFieldNumber,
+          internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED):
+        if (!ScanLengthDelimited(&ptr, end, &out->name_)) return false;
+        break;
+      case internal::WireFormatLite::MakeTag(
+          FileDescriptorProto::kPackageFieldNumber,
+          internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED):
+        if (!ScanLengthDelimited(&ptr, end, &out->package_)) return false;
+        break;
+      case internal::WireFormatLite::MakeTag(
+          FileDescriptorProto::kMessageTypeFieldNumber,
+          internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED):
+        out->message_type_.emplace_back();
+        if (!ScanLengthDelimited(&ptr, end, &payload) ||
+            !ScanMessage(payload, &out->message_type_.back(), 0)) {
+          return false;
+        }
+        break;
+      case internal::WireFormatLite::MakeTag(
+          FileDescriptorProto::kEnumTypeFieldNumber,
+          internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED):
+        out->enum_type_.emplace_back();
+        if (!ScanLengthDelimited(&ptr, end, &payload) ||
+            !ScanName(payload, &out->enum_type_.back().name_)) {
+          return false;
+        }
+        break;
+      case internal::WireFormatLite::MakeTag(
+          FileDescriptorProto::kServiceFieldNumber,
+          internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED):
+        out->service_.emplace_back();
+        if (!ScanLengthDelimited(&ptr, end, &payload) ||
+            !ScanName(payload, &out->service_.back().name_)) {
+          return false;
+        }
+        break;
+      case internal::WireFormatLite::MakeTag(
+          FileDescriptorProto::kExtensionFieldNumber,
+          internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED):
+        out->extension_.emplace_back();
+        if (!ScanLengthDelimited(&ptr, end, &payload) ||
+            !ScanExtension(payload, &out->extension_.back())) {
+          return false;
+        }
+        break;
+      default:
+        if (!SkipScannedField(&ptr, end, static_cast<uint32_t>(tag), 0)) {
+          return false;
+        }
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
 bool EncodedDescriptorDatabase::Add(const void* encoded_file_descriptor,
                                     int size) {
+  // Fast path: index the few fields AddFile() needs straight off the wire
+  // without materializing a FileDescriptorProto.
+  EncodedFileView view;
+  if (ScanFile(encoded_file_descriptor, size, &view)) {
+    return index_->AddFile(view, std::make_pair(encoded_file_descriptor, size));
+  }
+  // The scanner rejects anything it does not fully recognize; let the real
+  // parser have the final word on validity.
   FileDescriptorProto file;
   if (file.ParseFromArray(encoded_file_descriptor, size)) {
     return index_->AddFile(file, std::make_pair(encoded_file_descriptor, size));
@@ -561,6 +870,36 @@ bool EncodedDescriptorDatabase::AddCopy(const void* encoded_file_descriptor,
   return Add(copy, size);
 }
 
+bool EncodedDescriptorDatabase::AddFileDescriptorSet(const void* data,
+                                                     int size) {
+  // Split the set into per-file spans aliasing |data| and index each one.
+  const char* ptr = static_cast<const char*>(data);
+  const char* end = ptr + size;
+  while (ptr != end) {
+    uint64_t tag;
+    if (!ScanVarint(&ptr, end, &tag) || tag < 8 ||
+        tag > std::numeric_limits<uint32_t>::max()) {
+      ABSL_LOG(ERROR) << "Invalid FileDescriptorSet data passed to "
+                         "EncodedDescriptorDatabase::AddFileDescriptorSet().";
+      return false;
+    }
+    if (tag == internal::WireFormatLite::MakeTag(
+                   FileDescriptorSet::kFileFieldNumber,
+                   internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED)) {
+      absl::string_view file;
+      if (!ScanLengthDelimited(&ptr, end, &file) ||
+          !Add(file.data(), static_cast<int>(file.size()))) {
+        return false;
+      }
+    } else if (!SkipScannedField(&ptr, end, static_cast<uint32_t>(tag), 0)) {
+      ABSL_LOG(ERROR) << "Invalid FileDescriptorSet data passed to "
+                         "EncodedDescriptorDatabase::AddFileDescriptorSet().";
+      return false;
+    }
+  }
+  return true;
+}
+
 bool EncodedDescriptorDatabase::FindFileByName(const std::string& filename,
                                                FileDescriptorProto* output) {
   return MaybeParse(index_->FindFile(filename), output);
@@ -881,6 +1220,445 @@ EncodedDescriptorDatabase::~EncodedDescriptorDatabase() {
 
 // ===================================================================
 
+namespace {
+
+// On-disk layout of the IndexedDescriptorDatabase index (all integers are
+// 32-bit little-endian, all offsets relative to the start of the index):
+//
+//   header:          magic, version, descriptor set size,
+//                    file count, symbol count, extension count
+//   file table:      {name offset, name size, data offset, data size} per
+//                    file, sorted by name; the data offsets point into the
+//                    descriptor set and delimit the encoded
+//                    FileDescriptorProto
+//   symbol table:    {name offset, name size, file table index} per
+//                    top-level symbol, sorted by name and maintaining the
+//                    invariant that no symbol is a sub-symbol of another
+//                    (see SimpleDescriptorDatabase::DescriptorIndex)
+//   extension table: {extendee offset, extendee size, field number,
+//                    file table index}, sorted by (extendee, number)
+//   string pool:     the bytes referenced by the name/extendee offsets above
+constexpr uint32_t kDescriptorIndexMagic = 0x49444250;  // "PBDI"
+constexpr uint32_t kDescriptorIndexVersion = 1;
+constexpr size_t kDescriptorIndexHeaderSize = 6 * sizeof(uint32_t);
+constexpr size_t kFileEntrySize = 4 * sizeof(uint32_t);
+constexpr size_t kSymbolEntrySize = 3 * sizeof(uint32_t);
+constexpr size_t kExtensionEntrySize = 4 * sizeof(uint32_t);
+
+uint32_t ReadIndexUint32(const char* index, size_t offset) {
+  const unsigned char* p =
+      reinterpret_cast<const unsigned char*>(index + offset);
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+         (static_cast<uint32_t>(p[2]) << 16) |
+         (static_cast<uint32_t>(p[3]) << 24);
+}
+
+void AppendIndexUint32(uint32_t value, std::string* output) {
+  for (int i = 0; i < 4; ++i) {
+    output->push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+// Returns the string at [offset, offset + size) of the index, or an empty
+// view if the range does not lie within the index (corrupt entry).
+absl::string_view IndexStringAt(const char* index, size_t index_size,
+                                size_t offset, size_t size) {
+  if (offset > index_size || size > index_size - offset) {
+    return absl::string_view();
+  }
+  return absl::string_view(index + offset, size);
+}
+
+struct IndexedFileEntry {
+  std::string name;
+  uint32_t data_offset;
+  uint32_t data_size;
+};
+
+struct IndexedSymbolEntry {
+  std::string name;
+  uint32_t file_index;
+};
+
+struct IndexedExtensionEntry {
+  std::string extendee;
+  uint32_t number;
+  uint32_t file_index;
+};
+
+void CollectIndexedExtension(const FieldDescriptorProto& field,
+                             uint32_t file_index,
+                             std::vector<IndexedExtensionEntry>* output) {
+  if (!field.extendee().empty() && field.extendee()[0] == '.') {
+    // As in SimpleDescriptorDatabase, extensions with a relative extendee
+    // cannot be indexed, but the descriptor is still valid.
+    output->push_back({field.extendee().substr(1),
+                       static_cast<uint32_t>(field.number()), file_index});
+  }
+}
+
+void CollectNestedIndexedExtensions(
+    const DescriptorProto& message_type, uint32_t file_index,
+    std::vector<IndexedExtensionEntry>* output) {
+  for (const DescriptorProto& nested : message_type.nested_type()) {
+    CollectNestedIndexedExtensions(nested, file_index, output);
+  }
+  for (const FieldDescriptorProto& extension : message_type.extension()) {
+    CollectIndexedExtension(extension, file_index, output);
+  }
+}
+
+}  // namespace
+
+bool IndexedDescriptorDatabase::BuildIndex(const void* descriptor_set_data,
+                                           int descriptor_set_size,
+                                           std::string* output) {
+  const char* base = static_cast<const char*>(descriptor_set_data);
+  const char* ptr = base;
+  const char* end = base + descriptor_set_size;
+
+  std::vector<IndexedFileEntry> files;
+  std::vector<IndexedSymbolEntry> symbols;
+  std::vector<IndexedExtensionEntry> extensions;
+
+  while (ptr != end) {
+    uint64_t tag;
+    if (!ScanVarint(&ptr, end, &tag) || tag < 8 ||
+        tag > std::numeric_limits<uint32_t>::max()) {
+      ABSL_LOG(ERROR) << "Invalid FileDescriptorSet data passed to "
+                         "IndexedDescriptorDatabase::BuildIndex().";
+      return false;
+    }
+    if (tag == internal::WireFormatLite::MakeTag(
+                   FileDescriptorSet::kFileFieldNumber,
+                   internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED)) {
+      absl::string_view data;
+      FileDescriptorProto file;
+      if (!ScanLengthDelimited(&ptr, end, &data) ||
+          !internal::ParseNoReflection(data, file)) {
+        ABSL_LOG(ERROR) << "Invalid FileDescriptorSet data passed to "
+                           "IndexedDescriptorDatabase::BuildIndex().";
+        return false;
+      }
+      uint32_t file_index = static_cast<uint32_t>(files.size());
+      files.push_back({file.name(),
+                       static_cast<uint32_t>(data.data() - base),
+                       static_cast<uint32_t>(data.size())});
+
+      std::string path = file.has_package() ? file.package() : std::string();
+      if (!path.empty()) path += '.';
+      for (const DescriptorProto& message_type : file.message_type()) {
+        symbols.push_back({path + message_type.name(), file_index});
+        CollectNestedIndexedExtensions(message_type, file_index, &extensions);
+      }
+      for (const EnumDescriptorProto& enum_type : file.enum_type()) {
+        symbols.push_back({path + enum_type.name(), file_index});
+      }
+      for (const FieldDescriptorProto& extension : file.extension()) {
+        symbols.push_back({path + extension.name(), file_index});
+        CollectIndexedExtension(extension, file_index, &extensions);
+      }
+      for (const ServiceDescriptorProto& service : file.service()) {
+        symbols.push_back({path + service.name(), file_index});
+      }
+    } else if (!SkipScannedField(&ptr, end, static_cast<uint32_t>(tag), 0)) {
+      ABSL_LOG(ERROR) << "Invalid FileDescriptorSet data passed to "
+                         "IndexedDescriptorDatabase::BuildIndex().";
+      return false;
+    }
+  }
+
+  std::sort(files.begin(), files.end(),
+            [](const IndexedFileEntry& a, const IndexedFileEntry& b) {
+              return a.name < b.name;
+            });
+  for (size_t i = 1; i < files.size(); ++i) {
+    if (files[i - 1].name == files[i].name) {
+      ABSL_LOG(ERROR) << "File already exists in database: " << files[i].name;
+      return false;
+    }
+  }
+
+  size_t string_pool_size = 0;
+  for (const IndexedSymbolEntry& symbol : symbols) {
+    if (!ValidateSymbolName(symbol.name)) {
+      ABSL_LOG(ERROR) << "Invalid symbol name: " << symbol.name;
+      return false;
+    }
+    string_pool_size += symbol.name.size();
+  }
+  std::sort(symbols.begin(), symbols.end(),
+            [](const IndexedSymbolEntry& a, const IndexedSymbolEntry& b) {
+              return a.name < b.name;
+            });
+  for (size_t i = 1; i < symbols.size(); ++i) {
+    // Symbols sort after their sub-symbols, so checking neighbors enforces
+    // the whole invariant.
+    if (IsSubSymbol(symbols[i - 1].name, symbols[i].name)) {
+      ABSL_LOG(ERROR) << "Symbol name \"" << symbols[i].name
+                      << "\" conflicts with the existing symbol \""
+                      << symbols[i - 1].name << "\".";
+      return false;
+    }
+  }
+
+  std::sort(extensions.begin(), extensions.end(),
+            [](const IndexedExtensionEntry& a, const IndexedExtensionEntry& b) {
+              return std::make_tuple(absl::string_view(a.extendee), a.number) <
+                     std::make_tuple(absl::string_view(b.extendee), b.number);
+            });
+  for (size_t i = 1; i < extensions.size(); ++i) {
+    if (extensions[i - 1].extendee == extensions[i].extendee &&
+        extensions[i - 1].number == extensions[i].number) {
+      ABSL_LOG(ERROR)
+          << "Extension conflicts with extension already in database: extend "
+          << extensions[i].extendee << " { ... = " << extensions[i].number
+          << " }";
+      return false;
+    }
+  }
+
+  for (const IndexedFileEntry& file : files) {
+    string_pool_size += file.name.size();
+  }
+  for (const IndexedExtensionEntry& extension : extensions) {
+    string_pool_size += extension.extendee.size();
+  }
+  size_t string_pool_offset = kDescriptorIndexHeaderSize +
+                              files.size() * kFileEntrySize +
+                              symbols.size() * kSymbolEntrySize +
+                              extensions.size() * kExtensionEntrySize;
+  if (string_pool_offset + string_pool_size >
+      std::numeric_limits<uint32_t>::max()) {
+    ABSL_LOG(ERROR) << "Descriptor index too large.";
+    return false;
+  }
+
+  std::string string_pool;
+  string_pool.reserve(string_pool_size);
+  auto intern = [&string_pool, string_pool_offset](const std::string& str) {
+    uint32_t offset =
+        static_cast<uint32_t>(string_pool_offset + string_pool.size());
+    string_pool.append(str);
+    return offset;
+  };
+
+  AppendIndexUint32(kDescriptorIndexMagic, output);
+  AppendIndexUint32(kDescriptorIndexVersion, output);
+  AppendIndexUint32(static_cast<uint32_t>(descriptor_set_size), output);
+  AppendIndexUint32(static_cast<uint32_t>(files.size()), output);
+  AppendIndexUint32(static_cast<uint32_t>(symbols.size()), output);
+  AppendIndexUint32(static_cast<uint32_t>(extensions.size()), output);
+  for (const IndexedFileEntry& file : files) {
+    AppendIndexUint32(intern(file.name), output);
+    AppendIndexUint32(static_cast<uint32_t>(file.name.size()), output);
+    AppendIndexUint32(file.data_offset, output);
+    AppendIndexUint32(file.data_size, output);
+  }
+  for (const IndexedSymbolEntry& symbol : symbols) {
+    AppendIndexUint32(intern(symbol.name), output);
+    AppendIndexUint32(static_cast<uint32_t>(symbol.name.size()), output);
+    AppendIndexUint32(symbol.file_index, output);
+  }
+  for (const IndexedExtensionEntry& extension : extensions) {
+    AppendIndexUint32(intern(extension.extendee), output);
+    AppendIndexUint32(static_cast<uint32_t>(extension.extendee.size()),
+                      output);
+    AppendIndexUint32(extension.number, output);
+    AppendIndexUint32(extension.file_index, output);
+  }
+  output->append(string_pool);
+  return true;
+}
+
+IndexedDescriptorDatabase::IndexedDescriptorDatabase(
+    const void* descriptor_set_data, int descriptor_set_size,
+    const void* index_data, int index_size)
+    : descriptor_set_(static_cast<const char*>(descriptor_set_data)),
+      descriptor_set_size_(static_cast<size_t>(descriptor_set_size)),
+      index_(static_cast<const char*>(index_data)),
+      index_size_(static_cast<size_t>(index_size)),
+      valid_(false),
+      file_table_(0),
+      file_count_(0),
+      symbol_table_(0),
+      symbol_count_(0),
+      extension_table_(0),
+      extension_count_(0) {
+  valid_ = Validate();
+  if (!valid_) {
+    ABSL_LOG(ERROR) << "Invalid or mismatched index passed to "
+                       "IndexedDescriptorDatabase.";
+  }
+}
+
+IndexedDescriptorDatabase::~IndexedDescriptorDatabase() {}
+
+bool IndexedDescriptorDatabase::Validate() {
+  if (index_size_ < kDescriptorIndexHeaderSize) return false;
+  if (ReadIndexUint32(index_, 0) != kDescriptorIndexMagic) return false;
+  if (ReadIndexUint32(index_, 4) != kDescriptorIndexVersion) return false;
+  if (ReadIndexUint32(index_, 8) != descriptor_set_size_) return false;
+  file_count_ = ReadIndexUint32(index_, 12);
+  symbol_count_ = ReadIndexUint32(index_, 16);
+  extension_count_ = ReadIndexUint32(index_, 20);
+  file_table_ = kDescriptorIndexHeaderSize;
+  symbol_table_ = file_table_ + file_count_ * kFileEntrySize;
+  extension_table_ = symbol_table_ + symbol_count_ * kSymbolEntrySize;
+  return extension_table_ + extension_count_ * kExtensionEntrySize <=
+         index_size_;
+}
+
+bool IndexedDescriptorDatabase::ParseFileAt(size_t file_entry_offset,
+                                            FileDescriptorProto* output) {
+  size_t data_offset = ReadIndexUint32(index_, file_entry_offset + 8);
+  size_t data_size = ReadIndexUint32(index_, file_entry_offset + 12);
+  if (data_offset > descriptor_set_size_ ||
+      data_size > descriptor_set_size_ - data_offset) {
+    return false;
+  }
+  absl::string_view source(descriptor_set_ + data_offset, data_size);
+  return internal::ParseNoReflection(source, *output);
+}
+
+bool IndexedDescriptorDatabase::FindFileByName(const std::string& filename,
+                                               FileDescriptorProto* output) {
+  if (!valid_) return false;
+  size_t lo = 0;
+  size_t hi = file_count_;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    size_t entry = file_table_ + mid * kFileEntrySize;
+    absl::string_view name =
+        IndexStringAt(index_, index_size_, ReadIndexUint32(index_, entry),
+                      ReadIndexUint32(index_, entry + 4));
+    if (name < filename) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo == file_count_) return false;
+  size_t entry = file_table_ + lo * kFileEntrySize;
+  absl::string_view name =
+      IndexStringAt(index_, index_size_, ReadIndexUint32(index_, entry),
+                    ReadIndexUint32(index_, entry + 4));
+  if (name != filename) return false;
+  return ParseFileAt(entry, output);
+}
+
+bool IndexedDescriptorDatabase::FindFileContainingSymbol(
+    const std::string& symbol_name, FileDescriptorProto* output) {
+  if (!valid_) return false;
+  // Find the last symbol that sorts less than or equal to the search key,
+  // then check whether it is a parent symbol; see the lookup-algorithm
+  // comment on SimpleDescriptorDatabase::DescriptorIndex.
+  size_t lo = 0;
+  size_t hi = symbol_count_;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    size_t entry = symbol_table_ + mid * kSymbolEntrySize;
+    absl::string_view name =
+        IndexStringAt(index_, index_size_, ReadIndexUint32(index_, entry),
+                      ReadIndexUint32(index_, entry + 4));
+    if (symbol_name < name) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+  if (lo == 0) return false;
+  size_t entry = symbol_table_ + (lo - 1) * kSymbolEntrySize;
+  absl::string_view name =
+      IndexStringAt(index_, index_size_, ReadIndexUint32(index_, entry),
+                    ReadIndexUint32(index_, entry + 4));
+  if (!IsSubSymbol(name, symbol_name)) return false;
+  size_t file_index = ReadIndexUint32(index_, entry + 8);
+  if (file_index >= file_count_) return false;
+  return ParseFileAt(file_table_ + file_index * kFileEntrySize, output);
+}
+
+bool IndexedDescriptorDatabase::FindFileContainingExtension(
+    const std::string& containing_type, int field_number,
+    FileDescriptorProto* output) {
+  if (!valid_) return false;
+  size_t lo = 0;
+  size_t hi = extension_count_;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    size_t entry = extension_table_ + mid * kExtensionEntrySize;
+    absl::string_view extendee =
+        IndexStringAt(index_, index_size_, ReadIndexUint32(index_, entry),
+                      ReadIndexUint32(index_, entry + 4));
+    uint32_t number = ReadIndexUint32(index_, entry + 8);
+    if (std::make_tuple(extendee, number) <
+        std::make_tuple(absl::string_view(containing_type),
+                        static_cast<uint32_t>(field_number))) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo == extension_count_) return false;
+  size_t entry = extension_table_ + lo * kExtensionEntrySize;
+  absl::string_view extendee =
+      IndexStringAt(index_, index_size_, ReadIndexUint32(index_, entry),
+                    ReadIndexUint32(index_, entry + 4));
+  if (extendee != containing_type ||
+      ReadIndexUint32(index_, entry + 8) !=
+          static_cast<uint32_t>(field_number)) {
+    return false;
+  }
+  size_t file_index = ReadIndexUint32(index_, entry + 12);
+  if (file_index >= file_count_) return false;
+  return ParseFileAt(file_table_ + file_index * kFileEntrySize, output);
+}
+
+bool IndexedDescriptorDatabase::FindAllExtensionNumbers(
+    const std::string& extendee_type, std::vector<int>* output) {
+  if (!valid_) return false;
+  size_t lo = 0;
+  size_t hi = extension_count_;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    size_t entry = extension_table_ + mid * kExtensionEntrySize;
+    absl::string_view extendee =
+        IndexStringAt(index_, index_size_, ReadIndexUint32(index_, entry),
+                      ReadIndexUint32(index_, entry + 4));
+    if (extendee < extendee_type) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  bool success = false;
+  for (; lo < extension_count_; ++lo) {
+    size_t entry = extension_table_ + lo * kExtensionEntrySize;
+    absl::string_view extendee =
+        IndexStringAt(index_, index_size_, ReadIndexUint32(index_, entry),
+                      ReadIndexUint32(index_, entry + 4));
+    if (extendee != extendee_type) break;
+    output->push_back(static_cast<int>(ReadIndexUint32(index_, entry + 8)));
+    success = true;
+  }
+  return success;
+}
+
+bool IndexedDescriptorDatabase::FindAllFileNames(
+    std::vector<std::string>* output) {
+  if (!valid_) return false;
+  for (size_t i = 0; i < file_count_; ++i) {
+    size_t entry = file_table_ + i * kFileEntrySize;
+    absl::string_view name =
+        IndexStringAt(index_, index_size_, ReadIndexUint32(index_, entry),
+                      ReadIndexUint32(index_, entry + 4));
+    output->push_back(std::string(name));
+  }
+  return true;
+}
+
+// ===================================================================
+
 DescriptorPoolDatabase::DescriptorPoolDatabase(const DescriptorPool& pool)
     : pool_(pool) {}
 DescriptorPoolDatabase::~DescriptorPoolDatabase() {}
@@ -957,6 +1735,9 @@ bool MergedDescriptorDatabase::FindFileByName(const std::string& filename,
 
 bool MergedDescriptorDatabase::FindFileContainingSymbol(
     const std::string& symbol_name, FileDescriptorProto* output) {
+  if (cache_missing_symbols_ && missing_symbols_.contains(symbol_name)) {
+    return false;
+  }
   for (size_t i = 0; i < sources_.size(); i++) {
     if (sources_[i]->FindFileContainingSymbol(symbol_name, output)) {
       // The symbol was found in source i.  However, if one of the previous
@@ -966,13 +1747,18 @@ bool MergedDescriptorDatabase::FindFileContainingSymbol(
       FileDescriptorProto temp;
       for (size_t j = 0; j < i; j++) {
         if (sources_[j]->FindFileByName(output->name(), &temp)) {
-          // Found conflicting file in a previous source.
+          // Found conflicting file in a previous source.  This is not a
+          // cacheable miss: the symbol does exist in a source, it is merely
+          // masked here.
           return false;
         }
       }
       return true;
     }
   }
+  if (cache_missing_symbols_) {
+    missing_symbols_.insert(symbol_name);
+  }
   return false;
 }
 
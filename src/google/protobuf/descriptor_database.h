@@ -19,6 +19,7 @@
 #include <vector>
 
 #include "absl/container/btree_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/port.h"
 
@@ -36,6 +37,7 @@ namespace protobuf {
 class DescriptorDatabase;
 class SimpleDescriptorDatabase;
 class EncodedDescriptorDatabase;
+class IndexedDescriptorDatabase;
 class DescriptorPoolDatabase;
 class MergedDescriptorDatabase;
 
@@ -282,6 +284,17 @@ class PROTOBUF_EXPORT EncodedDescriptorDatabase : public DescriptorDatabase {
   // need to keep it around.
   bool AddCopy(const void* encoded_file_descriptor, int size);
 
+  // Adds every file in an encoded FileDescriptorSet without copying: each
+  // indexed file aliases a sub-range of |data|, which must remain valid for
+  // the life of the database.  This is intended for descriptor-set files
+  // mapped read-only into memory (see io::MmapInputStream): many processes
+  // registering the same mapping share one physical copy of the descriptor
+  // bytes, and a lazily-building DescriptorPool on top only touches the
+  // pages it actually resolves symbols from.  Returns false and logs an
+  // error if the bytes are not a valid FileDescriptorSet or any contained
+  // file fails to be added.
+  bool AddFileDescriptorSet(const void* data, int size);
+
   // Like FindFileContainingSymbol but returns only the name of the file.
   bool FindNameOfFileContainingSymbol(const std::string& symbol_name,
                                       std::string* output);
@@ -311,6 +324,80 @@ class PROTOBUF_EXPORT EncodedDescriptorDatabase : public DescriptorDatabase {
                   FileDescriptorProto* output);
 };
 
+// A DescriptorDatabase backed by an encoded FileDescriptorSet and an index
+// built ahead of time with BuildIndex().  Unlike EncodedDescriptorDatabase,
+// which inserts every symbol into in-memory tables at startup, this database
+// performs no indexing at runtime: lookups binary-search the sorted tables
+// in the index bytes directly.  Both buffers are used in place, so they can
+// be memory-mapped read-only files; processes opening the same files share
+// one physical copy of the pages, and only the pages actually touched by
+// lookups are faulted in.  This matters for very large descriptor sets
+// (hundreds of megabytes) served from a schema registry.
+//
+// The index format is versioned, position-independent and endian-neutral;
+// an index built on one machine can be shipped alongside its descriptor set
+// and used anywhere.
+//
+// The same caveats regarding FindFileContainingExtension() apply as with
+// SimpleDescriptorDatabase.
+class PROTOBUF_EXPORT IndexedDescriptorDatabase : public DescriptorDatabase {
+ public:
+  // Builds index bytes for the given encoded FileDescriptorSet and appends
+  // them to *output.  Intended to run offline (e.g. when the descriptor set
+  // is published); the result is typically written next to the descriptor
+  // set and memory-mapped at runtime.  Returns false and logs an error if
+  // the bytes are not a valid FileDescriptorSet or contain conflicting
+  // files, symbols or extensions.
+  static bool BuildIndex(const void* descriptor_set_data,
+                         int descriptor_set_size, std::string* output);
+
+  // Neither buffer is copied nor owned; the caller must keep both valid
+  // (e.g. mapped) for the life of the database.
+  IndexedDescriptorDatabase(const void* descriptor_set_data,
+                            int descriptor_set_size, const void* index_data,
+                            int index_size);
+  IndexedDescriptorDatabase(const IndexedDescriptorDatabase&) = delete;
+  IndexedDescriptorDatabase& operator=(const IndexedDescriptorDatabase&) =
+      delete;
+  ~IndexedDescriptorDatabase() override;
+
+  // True if the index bytes are structurally valid and were built for a
+  // descriptor set of this size.  All lookups on an invalid database fail.
+  bool valid() const { return valid_; }
+
+  // implements DescriptorDatabase -----------------------------------
+  bool FindFileByName(const std::string& filename,
+                      FileDescriptorProto* output) override;
+  bool FindFileContainingSymbol(const std::string& symbol_name,
+                                FileDescriptorProto* output) override;
+  bool FindFileContainingExtension(const std::string& containing_type,
+                                   int field_number,
+                                   FileDescriptorProto* output) override;
+  bool FindAllExtensionNumbers(const std::string& extendee_type,
+                               std::vector<int>* output) override;
+  bool FindAllFileNames(std::vector<std::string>* output) override;
+
+ private:
+  bool Validate();
+  // Parses the file whose entry sits at |file_entry_offset| in the index.
+  bool ParseFileAt(size_t file_entry_offset, FileDescriptorProto* output);
+
+  const char* descriptor_set_;
+  size_t descriptor_set_size_;
+  const char* index_;
+  size_t index_size_;
+  bool valid_;
+
+  // Byte offsets of the three sorted tables within index_, precomputed from
+  // the header by Validate().
+  size_t file_table_;
+  size_t file_count_;
+  size_t symbol_table_;
+  size_t symbol_count_;
+  size_t extension_table_;
+  size_t extension_count_;
+};
+
 // A DescriptorDatabase that fetches files from a given pool.
 class PROTOBUF_EXPORT DescriptorPoolDatabase : public DescriptorDatabase {
  public:
@@ -368,8 +455,21 @@ class PROTOBUF_EXPORT MergedDescriptorDatabase : public DescriptorDatabase {
   // DescriptorDatabase returns true.
   bool FindAllFileNames(std::vector<std::string>* output) override;
 
+  // Enables remembering of failed FindFileContainingSymbol() lookups.  Once
+  // enabled, a symbol that missed every source costs a single hash probe on
+  // later lookups instead of a full query of each source.  This matters when
+  // many databases are layered and misses are common, e.g. plugin systems
+  // that resolve every symbol through the whole stack.  Cached misses are
+  // never invalidated, so only enable this if symbols are never added to the
+  // underlying databases after a failed lookup.
+  void EnableMissingSymbolCaching() { cache_missing_symbols_ = true; }
+
  private:
   std::vector<DescriptorDatabase*> sources_;
+  // Symbols known to be absent from every source; see
+  // EnableMissingSymbolCaching().  Unused until enabled.
+  absl::flat_hash_set<std::string> missing_symbols_;
+  bool cache_missing_symbols_ = false;
 };
 
 }  // namespace protobuf
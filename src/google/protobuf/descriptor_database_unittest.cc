@@ -104,6 +104,79 @@ class EncodedDescriptorDatabaseTestCase : public DescriptorDatabaseTestCase {
   EncodedDescriptorDatabase database_;
 };
 
+// Specialization for IndexedDescriptorDatabase.  The index is built offline
+// from a complete FileDescriptorSet, so this test case rebuilds the set, the
+// index and the database on every addition.
+class IndexedDescriptorDatabaseTestCase : public DescriptorDatabaseTestCase {
+ public:
+  static DescriptorDatabaseTestCase* New() {
+    return new IndexedDescriptorDatabaseTestCase;
+  }
+
+  virtual ~IndexedDescriptorDatabaseTestCase() {}
+
+  virtual DescriptorDatabase* GetDatabase() { return &forwarder_; }
+  virtual bool AddToDatabase(const FileDescriptorProto& file) {
+    FileDescriptorSet candidate_set = set_;
+    candidate_set.add_file()->CopyFrom(file);
+    std::string data;
+    candidate_set.SerializeToString(&data);
+    std::string index;
+    if (!IndexedDescriptorDatabase::BuildIndex(data.data(), data.size(),
+                                               &index)) {
+      return false;
+    }
+    set_ = candidate_set;
+    data_.swap(data);
+    index_.swap(index);
+    database_.reset(new IndexedDescriptorDatabase(
+        data_.data(), data_.size(), index_.data(), index_.size()));
+    return true;
+  }
+
+ private:
+  // The test fixture grabs the DescriptorDatabase pointer before any file is
+  // added, so hand it a stable object that forwards to the latest build.
+  class Forwarder : public DescriptorDatabase {
+   public:
+    explicit Forwarder(std::unique_ptr<IndexedDescriptorDatabase>* db)
+        : db_(db) {}
+    bool FindFileByName(const std::string& filename,
+                        FileDescriptorProto* output) override {
+      return *db_ != nullptr && (*db_)->FindFileByName(filename, output);
+    }
+    bool FindFileContainingSymbol(const std::string& symbol_name,
+                                  FileDescriptorProto* output) override {
+      return *db_ != nullptr &&
+             (*db_)->FindFileContainingSymbol(symbol_name, output);
+    }
+    bool FindFileContainingExtension(const std::string& containing_type,
+                                     int field_number,
+                                     FileDescriptorProto* output) override {
+      return *db_ != nullptr &&
+             (*db_)->FindFileContainingExtension(containing_type, field_number,
+                                                 output);
+    }
+    bool FindAllExtensionNumbers(const std::string& extendee_type,
+                                 std::vector<int>* output) override {
+      return *db_ != nullptr &&
+             (*db_)->FindAllExtensionNumbers(extendee_type, output);
+    }
+    bool FindAllFileNames(std::vector<std::string>* output) override {
+      return *db_ != nullptr && (*db_)->FindAllFileNames(output);
+    }
+
+   private:
+    std::unique_ptr<IndexedDescriptorDatabase>* db_;
+  };
+
+  FileDescriptorSet set_;
+  std::string data_;
+  std::string index_;
+  std::unique_ptr<IndexedDescriptorDatabase> database_;
+  Forwarder forwarder_{&database_};
+};
+
 // Specialization for DescriptorPoolDatabase.
 class DescriptorPoolDatabaseTestCase : public DescriptorDatabaseTestCase {
  public:
@@ -453,6 +526,9 @@ INSTANTIATE_TEST_CASE_P(
 INSTANTIATE_TEST_CASE_P(
     MemoryConserving, DescriptorDatabaseTest,
     testing::Values(&EncodedDescriptorDatabaseTestCase::New));
+INSTANTIATE_TEST_CASE_P(
+    Indexed, DescriptorDatabaseTest,
+    testing::Values(&IndexedDescriptorDatabaseTestCase::New));
 INSTANTIATE_TEST_CASE_P(Pool, DescriptorDatabaseTest,
                         testing::Values(&DescriptorPoolDatabaseTestCase::New));
 
@@ -492,6 +568,113 @@ TEST(EncodedDescriptorDatabaseExtraTest, FindNameOfFileContainingSymbol) {
   EXPECT_FALSE(db.FindNameOfFileContainingSymbol("baz.Baz", &filename));
 }
 
+TEST(EncodedDescriptorDatabaseExtraTest, AddWithUnknownFields) {
+  // The wire scan used to index encoded files must skip fields it does not
+  // recognize (e.g. options or data written by a newer descriptor.proto).
+  FileDescriptorProto file;
+  file.set_name("foo.proto");
+  file.set_package("foo");
+  file.add_message_type()->set_name("Foo");
+  file.mutable_options()->set_java_package("com.foo");
+  std::string data = file.SerializeAsString();
+  // Append an unknown length-delimited field (number 1000) as well.
+  FileDescriptorProto unknown_holder;
+  unknown_holder.mutable_unknown_fields()->AddLengthDelimited(1000, "blah");
+  data += unknown_holder.SerializeAsString();
+
+  EncodedDescriptorDatabase db;
+  ASSERT_TRUE(db.Add(data.data(), data.size()));
+
+  std::string filename;
+  EXPECT_TRUE(db.FindNameOfFileContainingSymbol("foo.Foo", &filename));
+  EXPECT_EQ("foo.proto", filename);
+}
+
+TEST(EncodedDescriptorDatabaseExtraTest, AddFileDescriptorSet) {
+  // An encoded FileDescriptorSet (e.g. an mmap'd descriptor-set file) can be
+  // indexed in place, with each file aliasing the original buffer.
+  FileDescriptorSet set;
+  FileDescriptorProto* file1 = set.add_file();
+  file1->set_name("foo.proto");
+  file1->set_package("foo");
+  file1->add_message_type()->set_name("Foo");
+  FileDescriptorProto* file2 = set.add_file();
+  file2->set_name("bar.proto");
+  file2->set_package("bar");
+  file2->add_message_type()->set_name("Bar");
+  std::string data = set.SerializeAsString();
+
+  EncodedDescriptorDatabase db;
+  ASSERT_TRUE(db.AddFileDescriptorSet(data.data(), data.size()));
+
+  FileDescriptorProto file;
+  EXPECT_TRUE(db.FindFileByName("foo.proto", &file));
+  EXPECT_EQ("foo.proto", file.name());
+  EXPECT_TRUE(db.FindFileContainingSymbol("bar.Bar", &file));
+  EXPECT_EQ("bar.proto", file.name());
+
+  // A lazily-building pool on top resolves symbols straight from the set.
+  DescriptorPool pool(&db);
+  const Descriptor* descriptor = pool.FindMessageTypeByName("foo.Foo");
+  ASSERT_TRUE(descriptor != nullptr);
+  EXPECT_EQ("foo.proto", descriptor->file()->name());
+}
+
+TEST(IndexedDescriptorDatabaseExtraTest, WorksWithLazilyBuildingPool) {
+  FileDescriptorSet set;
+  FileDescriptorProto* file1 = set.add_file();
+  file1->set_name("foo.proto");
+  file1->set_package("foo");
+  file1->add_message_type()->set_name("Foo");
+  FileDescriptorProto* file2 = set.add_file();
+  file2->set_name("bar.proto");
+  file2->set_package("bar");
+  file2->add_message_type()->set_name("Bar");
+  std::string data = set.SerializeAsString();
+
+  std::string index;
+  ASSERT_TRUE(
+      IndexedDescriptorDatabase::BuildIndex(data.data(), data.size(), &index));
+
+  // Both buffers are used in place, as they would be when mmap'd.
+  IndexedDescriptorDatabase db(data.data(), data.size(), index.data(),
+                               index.size());
+  ASSERT_TRUE(db.valid());
+
+  DescriptorPool pool(&db);
+  const Descriptor* descriptor = pool.FindMessageTypeByName("foo.Foo");
+  ASSERT_TRUE(descriptor != nullptr);
+  EXPECT_EQ("foo.proto", descriptor->file()->name());
+  EXPECT_TRUE(pool.FindMessageTypeByName("bar.Bar") != nullptr);
+}
+
+TEST(IndexedDescriptorDatabaseExtraTest, RejectsMismatchedIndex) {
+  FileDescriptorSet set;
+  FileDescriptorProto* file = set.add_file();
+  file->set_name("foo.proto");
+  file->add_message_type()->set_name("Foo");
+  std::string data = set.SerializeAsString();
+
+  std::string index;
+  ASSERT_TRUE(
+      IndexedDescriptorDatabase::BuildIndex(data.data(), data.size(), &index));
+
+  // An index built for a different descriptor set is rejected, as are
+  // obviously corrupt index bytes; all lookups on an invalid database fail.
+  std::string other_data = data + data;
+  IndexedDescriptorDatabase mismatched(other_data.data(), other_data.size(),
+                                       index.data(), index.size());
+  EXPECT_FALSE(mismatched.valid());
+
+  std::string garbage = "not an index";
+  IndexedDescriptorDatabase corrupt(data.data(), data.size(), garbage.data(),
+                                    garbage.size());
+  EXPECT_FALSE(corrupt.valid());
+  FileDescriptorProto out;
+  EXPECT_FALSE(corrupt.FindFileByName("foo.proto", &out));
+  EXPECT_FALSE(corrupt.FindFileContainingSymbol("Foo", &out));
+}
+
 TEST(SimpleDescriptorDatabaseExtraTest, FindAllFileNames) {
   FileDescriptorProto f;
   f.set_name("foo.proto");
@@ -706,6 +889,58 @@ TEST_F(MergedDescriptorDatabaseTest, FindFileContainingSymbol) {
   }
 }
 
+// Counts the FindFileContainingSymbol() calls forwarded to a wrapped
+// database, to observe how often a MergedDescriptorDatabase queries its
+// sources.
+class CountingDescriptorDatabase : public DescriptorDatabase {
+ public:
+  explicit CountingDescriptorDatabase(DescriptorDatabase* wrapped)
+      : wrapped_(wrapped) {}
+
+  bool FindFileByName(const std::string& filename,
+                      FileDescriptorProto* output) override {
+    return wrapped_->FindFileByName(filename, output);
+  }
+  bool FindFileContainingSymbol(const std::string& symbol_name,
+                                FileDescriptorProto* output) override {
+    ++symbol_lookups_;
+    return wrapped_->FindFileContainingSymbol(symbol_name, output);
+  }
+  bool FindFileContainingExtension(const std::string& containing_type,
+                                   int field_number,
+                                   FileDescriptorProto* output) override {
+    return wrapped_->FindFileContainingExtension(containing_type, field_number,
+                                                 output);
+  }
+
+  int symbol_lookups() const { return symbol_lookups_; }
+
+ private:
+  DescriptorDatabase* wrapped_;
+  int symbol_lookups_ = 0;
+};
+
+TEST_F(MergedDescriptorDatabaseTest, MissingSymbolCaching) {
+  CountingDescriptorDatabase counting1(&database1_);
+  CountingDescriptorDatabase counting2(&database2_);
+  MergedDescriptorDatabase merged(&counting1, &counting2);
+  merged.EnableMissingSymbolCaching();
+
+  FileDescriptorProto file;
+  EXPECT_FALSE(merged.FindFileContainingSymbol("NoSuchType", &file));
+  EXPECT_EQ(counting1.symbol_lookups(), 1);
+  EXPECT_EQ(counting2.symbol_lookups(), 1);
+
+  // The repeated miss is served from the cache without touching the sources.
+  EXPECT_FALSE(merged.FindFileContainingSymbol("NoSuchType", &file));
+  EXPECT_EQ(counting1.symbol_lookups(), 1);
+  EXPECT_EQ(counting2.symbol_lookups(), 1);
+
+  // Successful lookups are unaffected.
+  EXPECT_TRUE(merged.FindFileContainingSymbol("Bar", &file));
+  EXPECT_EQ("bar.proto", file.name());
+}
+
 TEST_F(MergedDescriptorDatabaseTest, FindFileContainingExtension) {
   {
     // Can find file that is only in database1_.
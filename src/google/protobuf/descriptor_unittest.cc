@@ -1034,6 +1034,21 @@ TEST_F(DescriptorTest, FieldJsonName) {
   EXPECT_EQ("fieldname7", generated->field(6)->json_name());
 }
 
+TEST_F(DescriptorTest, FindFieldByJsonName) {
+  // Default (camel-case) JSON names.
+  EXPECT_EQ(message4_->field(0), message4_->FindFieldByJsonName("fieldName1"));
+  EXPECT_EQ(message4_->field(1), message4_->FindFieldByJsonName("fieldName2"));
+  EXPECT_EQ(message4_->field(6), message4_->FindFieldByJsonName("fieldname7"));
+
+  // Explicitly set JSON name.
+  EXPECT_EQ(message4_->field(5), message4_->FindFieldByJsonName("@type"));
+
+  // The original field name and non-matching names do not match.
+  EXPECT_TRUE(message4_->FindFieldByJsonName("field_name1") == nullptr);
+  EXPECT_TRUE(message4_->FindFieldByJsonName("fieldName6") == nullptr);
+  EXPECT_TRUE(message4_->FindFieldByJsonName("nosuchfield") == nullptr);
+}
+
 TEST_F(DescriptorTest, FieldFile) {
   EXPECT_EQ(foo_file_, foo_->file());
   EXPECT_EQ(foo_file_, bar_->file());
@@ -3015,6 +3030,122 @@ TEST_F(MiscTest, FieldOptions) {
   EXPECT_NE(&FieldOptions::default_instance(), options);
   EXPECT_TRUE(bar->options().has_ctype());
   EXPECT_EQ(FieldOptions::CORD, bar->options().ctype());
+
+  // The precomputed string type mirrors the ctype option.
+  EXPECT_EQ(FieldDescriptor::CppStringType::kString, foo->cpp_string_type());
+  EXPECT_EQ(FieldDescriptor::CppStringType::kCord, bar->cpp_string_type());
+}
+
+// ===================================================================
+
+TEST(FingerprintTest, StableAcrossPools) {
+  FileDescriptorProto file_proto = ParseTextOrDie(R"pb(
+    name: "fingerprint.proto"
+    message_type {
+      name: "Foo"
+      field { name: "a" number: 1 label: LABEL_OPTIONAL type: TYPE_INT32 }
+      field { name: "b" number: 2 label: LABEL_REPEATED type: TYPE_STRING }
+    }
+  )pb");
+
+  DescriptorPool pool1;
+  DescriptorPool pool2;
+  const FileDescriptor* file1 = ABSL_DIE_IF_NULL(pool1.BuildFile(file_proto));
+  const FileDescriptor* file2 = ABSL_DIE_IF_NULL(pool2.BuildFile(file_proto));
+
+  EXPECT_NE(0u, file1->Fingerprint());
+  EXPECT_NE(0u, file1->message_type(0)->Fingerprint());
+  EXPECT_EQ(file1->Fingerprint(), file2->Fingerprint());
+  EXPECT_EQ(file1->message_type(0)->Fingerprint(),
+            file2->message_type(0)->Fingerprint());
+  // Repeated calls return the cached value.
+  EXPECT_EQ(file1->Fingerprint(), file1->Fingerprint());
+}
+
+TEST(FingerprintTest, IgnoresWireIrrelevantChanges) {
+  FileDescriptorProto file_proto = ParseTextOrDie(R"pb(
+    name: "fingerprint.proto"
+    message_type {
+      name: "Foo"
+      field { name: "a" number: 1 label: LABEL_OPTIONAL type: TYPE_INT32 }
+      field { name: "b" number: 2 label: LABEL_OPTIONAL type: TYPE_STRING }
+    }
+  )pb");
+  DescriptorPool pool1;
+  const FileDescriptor* file1 = ABSL_DIE_IF_NULL(pool1.BuildFile(file_proto));
+
+  // Renaming a field and reordering declarations does not change the wire
+  // format, so the fingerprint is unchanged.
+  FileDescriptorProto modified = file_proto;
+  modified.mutable_message_type(0)->mutable_field(0)->set_name("renamed");
+  modified.mutable_message_type(0)->mutable_field(0)->Swap(
+      modified.mutable_message_type(0)->mutable_field(1));
+  DescriptorPool pool2;
+  const FileDescriptor* file2 = ABSL_DIE_IF_NULL(pool2.BuildFile(modified));
+
+  EXPECT_EQ(file1->message_type(0)->Fingerprint(),
+            file2->message_type(0)->Fingerprint());
+}
+
+TEST(FingerprintTest, SensitiveToWireRelevantChanges) {
+  FileDescriptorProto file_proto = ParseTextOrDie(R"pb(
+    name: "fingerprint.proto"
+    message_type {
+      name: "Foo"
+      field { name: "a" number: 1 label: LABEL_OPTIONAL type: TYPE_INT32 }
+    }
+  )pb");
+  DescriptorPool pool;
+  const FileDescriptor* file = ABSL_DIE_IF_NULL(pool.BuildFile(file_proto));
+  const uint64_t base = file->message_type(0)->Fingerprint();
+
+  auto fingerprint_of = [&](const FileDescriptorProto& proto) {
+    DescriptorPool modified_pool;
+    return ABSL_DIE_IF_NULL(modified_pool.BuildFile(proto))
+        ->message_type(0)
+        ->Fingerprint();
+  };
+
+  FileDescriptorProto renumbered = file_proto;
+  renumbered.mutable_message_type(0)->mutable_field(0)->set_number(2);
+  EXPECT_NE(base, fingerprint_of(renumbered));
+
+  FileDescriptorProto retyped = file_proto;
+  retyped.mutable_message_type(0)->mutable_field(0)->set_type(
+      FieldDescriptorProto::TYPE_SINT32);
+  EXPECT_NE(base, fingerprint_of(retyped));
+
+  FileDescriptorProto repeated = file_proto;
+  repeated.mutable_message_type(0)->mutable_field(0)->set_label(
+      FieldDescriptorProto::LABEL_REPEATED);
+  EXPECT_NE(base, fingerprint_of(repeated));
+}
+
+TEST(FingerprintTest, RecursiveMessageTypes) {
+  FileDescriptorProto file_proto = ParseTextOrDie(R"pb(
+    name: "fingerprint.proto"
+    message_type {
+      name: "Node"
+      field {
+        name: "child"
+        number: 1
+        label: LABEL_OPTIONAL
+        type: TYPE_MESSAGE
+        type_name: ".Node"
+      }
+      field { name: "value" number: 2 label: LABEL_OPTIONAL type: TYPE_INT32 }
+    }
+  )pb");
+
+  DescriptorPool pool1;
+  DescriptorPool pool2;
+  const FileDescriptor* file1 = ABSL_DIE_IF_NULL(pool1.BuildFile(file_proto));
+  const FileDescriptor* file2 = ABSL_DIE_IF_NULL(pool2.BuildFile(file_proto));
+
+  // Self-recursive types terminate and still fingerprint deterministically.
+  EXPECT_NE(0u, file1->message_type(0)->Fingerprint());
+  EXPECT_EQ(file1->message_type(0)->Fingerprint(),
+            file2->message_type(0)->Fingerprint());
 }
 
 // ===================================================================
@@ -4043,6 +4174,141 @@ TEST(CustomOptions, DebugString) {
 
 // ===================================================================
 
+class UpdateFileTest : public testing::Test {
+ protected:
+  FileDescriptorProto ParseProto(absl::string_view text) {
+    FileDescriptorProto proto;
+    EXPECT_TRUE(TextFormat::ParseFromString(text, &proto));
+    return proto;
+  }
+
+  DescriptorPool pool_;
+};
+
+TEST_F(UpdateFileTest, ReplacesFileAndPreservesOthers) {
+  const FileDescriptor* bar = pool_.BuildFile(ParseProto(
+      "name: 'bar.proto' "
+      "message_type { name: 'Bar' }"));
+  ASSERT_TRUE(bar != nullptr);
+  const FileDescriptor* foo_v1 = pool_.BuildFile(ParseProto(
+      "name: 'foo.proto' "
+      "message_type { name: 'Foo' "
+      "  field { name:'a' number:1 label:LABEL_OPTIONAL type:TYPE_INT32 } }"));
+  ASSERT_TRUE(foo_v1 != nullptr);
+  const Descriptor* old_foo = pool_.FindMessageTypeByName("Foo");
+  ASSERT_TRUE(old_foo != nullptr);
+
+  const FileDescriptor* foo_v2 = pool_.UpdateFile(ParseProto(
+      "name: 'foo.proto' "
+      "message_type { name: 'Foo' "
+      "  field { name:'a' number:1 label:LABEL_OPTIONAL type:TYPE_INT32 } "
+      "  field { name:'b' number:2 label:LABEL_OPTIONAL type:TYPE_STRING } }"));
+  ASSERT_TRUE(foo_v2 != nullptr);
+  EXPECT_NE(foo_v1, foo_v2);
+
+  // Lookups now resolve to the new version.
+  EXPECT_EQ(foo_v2, pool_.FindFileByName("foo.proto"));
+  const Descriptor* new_foo = pool_.FindMessageTypeByName("Foo");
+  ASSERT_TRUE(new_foo != nullptr);
+  EXPECT_EQ(foo_v2, new_foo->file());
+  EXPECT_EQ(2, new_foo->field_count());
+  EXPECT_TRUE(new_foo->FindFieldByName("b") != nullptr);
+
+  // Unrelated files keep their original descriptors.
+  EXPECT_EQ(bar, pool_.FindFileByName("bar.proto"));
+  EXPECT_EQ(bar->message_type(0), pool_.FindMessageTypeByName("Bar"));
+
+  // The old descriptors remain usable for anyone still holding them.
+  EXPECT_EQ(1, old_foo->field_count());
+  EXPECT_EQ("a", old_foo->field(0)->name());
+}
+
+TEST_F(UpdateFileTest, BuildsFileNotYetPresent) {
+  const FileDescriptor* file = pool_.UpdateFile(ParseProto(
+      "name: 'foo.proto' "
+      "message_type { name: 'Foo' }"));
+  ASSERT_TRUE(file != nullptr);
+  EXPECT_EQ(file, pool_.FindFileByName("foo.proto"));
+  EXPECT_EQ(file->message_type(0), pool_.FindMessageTypeByName("Foo"));
+}
+
+TEST_F(UpdateFileTest, ReplacesExtensions) {
+  ASSERT_TRUE(pool_.BuildFile(ParseProto(
+                  "name: 'ext.proto' "
+                  "message_type { name: 'Extendee' "
+                  "  extension_range { start: 1 end: 100 } } "
+                  "extension { name: 'ext_a' number: 5 label:LABEL_OPTIONAL "
+                  "  type:TYPE_INT32 extendee: 'Extendee' }")) != nullptr);
+
+  ASSERT_TRUE(pool_.UpdateFile(ParseProto(
+                  "name: 'ext.proto' "
+                  "message_type { name: 'Extendee' "
+                  "  extension_range { start: 1 end: 100 } } "
+                  "extension { name: 'ext_b' number: 6 label:LABEL_OPTIONAL "
+                  "  type:TYPE_INT32 extendee: 'Extendee' }")) != nullptr);
+
+  const Descriptor* extendee = pool_.FindMessageTypeByName("Extendee");
+  ASSERT_TRUE(extendee != nullptr);
+  EXPECT_TRUE(pool_.FindExtensionByNumber(extendee, 6) != nullptr);
+  EXPECT_TRUE(pool_.FindExtensionByNumber(extendee, 5) == nullptr);
+}
+
+TEST_F(UpdateFileTest, RejectsUpdateOfImportedFile) {
+  const FileDescriptor* base_v1 = pool_.BuildFile(ParseProto(
+      "name: 'base.proto' "
+      "message_type { name: 'Base' }"));
+  ASSERT_TRUE(base_v1 != nullptr);
+  ASSERT_TRUE(pool_.BuildFile(ParseProto(
+                  "name: 'dep.proto' "
+                  "dependency: 'base.proto' "
+                  "message_type { name: 'Dep' "
+                  "  field { name:'base' number:1 label:LABEL_OPTIONAL "
+                  "    type:TYPE_MESSAGE type_name:'Base' } }")) != nullptr);
+
+  MockErrorCollector error_collector;
+  EXPECT_TRUE(pool_.UpdateFileCollectingErrors(
+                  ParseProto("name: 'base.proto' "
+                             "message_type { name: 'Base' "
+                             "  field { name:'a' number:1 label:LABEL_OPTIONAL "
+                             "    type:TYPE_INT32 } }"),
+                  &error_collector) == nullptr);
+  EXPECT_EQ(
+      "base.proto: base.proto: OTHER: Cannot update a file which other built "
+      "files import.\n",
+      error_collector.text_);
+
+  // The pool still serves the original version.
+  EXPECT_EQ(base_v1, pool_.FindFileByName("base.proto"));
+  EXPECT_EQ(base_v1->message_type(0), pool_.FindMessageTypeByName("Base"));
+}
+
+TEST_F(UpdateFileTest, RestoresOldVersionWhenReplacementFailsToBuild) {
+  const FileDescriptor* foo_v1 = pool_.BuildFile(ParseProto(
+      "name: 'foo.proto' "
+      "message_type { name: 'Foo' "
+      "  field { name:'a' number:1 label:LABEL_OPTIONAL type:TYPE_INT32 } }"));
+  ASSERT_TRUE(foo_v1 != nullptr);
+
+  MockErrorCollector error_collector;
+  EXPECT_TRUE(pool_.UpdateFileCollectingErrors(
+                  ParseProto(
+                      "name: 'foo.proto' "
+                      "message_type { name: 'Foo' "
+                      "  field { name:'a' number:1 label:LABEL_OPTIONAL "
+                      "    type:TYPE_MESSAGE type_name:'NoSuchType' } }"),
+                  &error_collector) == nullptr);
+  EXPECT_FALSE(error_collector.text_.empty());
+
+  // The failed build rolled back to the original version.
+  EXPECT_EQ(foo_v1, pool_.FindFileByName("foo.proto"));
+  const Descriptor* foo = pool_.FindMessageTypeByName("Foo");
+  ASSERT_TRUE(foo != nullptr);
+  EXPECT_EQ(foo_v1->message_type(0), foo);
+  EXPECT_EQ(1, foo->field_count());
+}
+
+// ===================================================================
+
 
 class ValidationErrorTest : public testing::Test {
  protected:
@@ -11551,6 +11817,25 @@ TEST_F(DatabaseBackedPoolTest, FindFileByName) {
   EXPECT_TRUE(pool.FindFileByName("no_such_file.proto") == nullptr);
 }
 
+TEST_F(DatabaseBackedPoolTest, SealedPoolLookupsWithoutFallback) {
+  DescriptorPool pool(&database_);
+
+  // Load what we need, then seal the pool.
+  const Descriptor* foo = pool.FindMessageTypeByName("Foo");
+  ASSERT_TRUE(foo != nullptr);
+  pool.Seal();
+  EXPECT_TRUE(pool.IsSealed());
+
+  // Already-built symbols and files resolve lock-free.
+  EXPECT_EQ(foo, pool.FindMessageTypeByName("Foo"));
+  EXPECT_EQ(foo->file(), pool.FindFileByName("foo.proto"));
+
+  // Symbols that would require lazily building a new file from the fallback
+  // database are no longer found.
+  EXPECT_TRUE(pool.FindMessageTypeByName("Bar") == nullptr);
+  EXPECT_TRUE(pool.FindFileByName("bar.proto") == nullptr);
+}
+
 TEST_F(DatabaseBackedPoolTest, FindDependencyBeforeDependent) {
   DescriptorPool pool(&database_);
 
@@ -12918,6 +13203,51 @@ TEST_F(LazilyBuildDependenciesTest, Dependency) {
   EXPECT_FALSE(pool_.InternalIsFileLoaded("baz.proto"));
 }
 
+TEST_F(LazilyBuildDependenciesTest, WarmDependencies) {
+  ParseProtoAndAddToDb(
+      "name: 'foo.proto' "
+      "package: 'protobuf_unittest' "
+      "dependency: 'bar.proto' "
+      "dependency: 'enum1.proto' "
+      "message_type { "
+      "  name:'Foo' "
+      "  field { name:'bar' number:1 label:LABEL_OPTIONAL "
+      "type_name:'.protobuf_unittest.Bar' } "
+      "  field { name:'enum1' number:2 label:LABEL_OPTIONAL "
+      "type_name:'.protobuf_unittest.Enum1' } "
+      "}");
+  ParseProtoAndAddToDb(
+      "name: 'bar.proto' "
+      "package: 'protobuf_unittest' "
+      "dependency: 'baz.proto' "
+      "message_type { "
+      "  name:'Bar' "
+      "  field { name:'baz' number:1 label:LABEL_OPTIONAL "
+      "type_name:'.protobuf_unittest.Baz' } "
+      "}");
+  AddSimpleMessageProtoFileToDb("baz", "Baz");
+  AddSimpleEnumProtoFileToDb("enum1", "Enum1", "ENUM1");
+
+  const FileDescriptor* file = pool_.FindFileByName("foo.proto");
+  ASSERT_TRUE(file != nullptr);
+  EXPECT_FALSE(pool_.InternalIsFileLoaded("bar.proto"));
+  EXPECT_FALSE(pool_.InternalIsFileLoaded("baz.proto"));
+  EXPECT_FALSE(pool_.InternalIsFileLoaded("enum1.proto"));
+
+  // Warming builds the whole transitive import chain, including files only
+  // reachable through an import's own lazy fields.
+  pool_.WarmDependencies(file);
+  EXPECT_TRUE(pool_.InternalIsFileLoaded("bar.proto"));
+  EXPECT_TRUE(pool_.InternalIsFileLoaded("baz.proto"));
+  EXPECT_TRUE(pool_.InternalIsFileLoaded("enum1.proto"));
+
+  // Everything resolves afterwards, and warming again is a harmless no-op.
+  const Descriptor* foo = file->FindMessageTypeByName("Foo");
+  EXPECT_TRUE(foo->FindFieldByName("bar")->message_type() != nullptr);
+  EXPECT_TRUE(foo->FindFieldByName("enum1")->enum_type() != nullptr);
+  pool_.WarmDependencies(file);
+}
+
 // ===================================================================
 
 
@@ -115,9 +115,9 @@ int FieldSpaceUsed(const FieldDescriptor* field) {
         }
 
       case FD::CPPTYPE_STRING:
-        switch (field->options().ctype()) {
+        switch (field->cpp_string_type()) {
           default:  // TODO:  Support other string reps.
-          case FieldOptions::STRING:
+          case FieldDescriptor::CppStringType::kString:
             return sizeof(RepeatedPtrField<std::string>);
         }
         break;
@@ -145,9 +145,9 @@ int FieldSpaceUsed(const FieldDescriptor* field) {
         return sizeof(Message*);
 
       case FD::CPPTYPE_STRING:
-        switch (field->options().ctype()) {
+        switch (field->cpp_string_type()) {
           default:  // TODO:  Support other string reps.
-          case FieldOptions::STRING:
+          case FieldDescriptor::CppStringType::kString:
             return sizeof(ArenaStringPtr);
         }
         break;
@@ -398,9 +398,9 @@ void DynamicMessage::SharedCtor(bool lock_factory) {
         break;
 
       case FieldDescriptor::CPPTYPE_STRING:
-        switch (field->options().ctype()) {
+        switch (field->cpp_string_type()) {
           default:  // TODO:  Support other string reps.
-          case FieldOptions::STRING:
+          case FieldDescriptor::CppStringType::kString:
             if (!field->is_repeated()) {
               ArenaStringPtr* asp = new (field_ptr) ArenaStringPtr();
               asp->InitDefault();
@@ -490,9 +490,9 @@ DynamicMessage::~DynamicMessage() {
       if (*(reinterpret_cast<const int32_t*>(field_ptr)) == field->number()) {
         field_ptr = MutableOneofFieldRaw(field);
         if (field->cpp_type() == FieldDescriptor::CPPTYPE_STRING) {
-          switch (field->options().ctype()) {
+          switch (field->cpp_string_type()) {
             default:
-            case FieldOptions::STRING: {
+            case FieldDescriptor::CppStringType::kString: {
               reinterpret_cast<ArenaStringPtr*>(field_ptr)->Destroy();
               break;
             }
@@ -524,9 +524,9 @@ DynamicMessage::~DynamicMessage() {
 #undef HANDLE_TYPE
 
         case FieldDescriptor::CPPTYPE_STRING:
-          switch (field->options().ctype()) {
+          switch (field->cpp_string_type()) {
             default:  // TODO:  Support other string reps.
-            case FieldOptions::STRING:
+            case FieldDescriptor::CppStringType::kString:
               reinterpret_cast<RepeatedPtrField<std::string>*>(field_ptr)
                   ->~RepeatedPtrField<std::string>();
               break;
@@ -544,9 +544,9 @@ DynamicMessage::~DynamicMessage() {
       }
 
     } else if (field->cpp_type() == FieldDescriptor::CPPTYPE_STRING) {
-      switch (field->options().ctype()) {
+      switch (field->cpp_string_type()) {
         default:  // TODO:  Support other string reps.
-        case FieldOptions::STRING: {
+        case FieldDescriptor::CppStringType::kString: {
           reinterpret_cast<ArenaStringPtr*>(field_ptr)->Destroy();
           break;
         }
@@ -617,6 +617,25 @@ DynamicMessageFactory::~DynamicMessageFactory() {
 }
 
 const Message* DynamicMessageFactory::GetPrototype(const Descriptor* type) {
+  if (delegate_to_generated_factory_ &&
+      type->file()->pool() == DescriptorPool::generated_pool()) {
+    const Message* result = MessageFactory::TryGetGeneratedPrototype(type);
+    if (result != nullptr) return result;
+    // Otherwise, we will create it dynamically so keep going.
+  }
+
+  // Once the prototype has been built, lookups only need the shared reader
+  // lock, so concurrent GetPrototype() callers no longer serialize after
+  // warmup.  Entries are published under the exclusive lock below and never
+  // removed, so a hit here is always fully constructed.
+  {
+    absl::ReaderMutexLock lock(&prototypes_mutex_);
+    auto iter = prototypes_.find(type);
+    if (iter != prototypes_.end()) {
+      return iter->second->prototype;
+    }
+  }
+
   absl::MutexLock lock(&prototypes_mutex_);
   return GetPrototypeNoLock(type);
 }
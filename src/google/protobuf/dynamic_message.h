@@ -108,7 +108,9 @@ class PROTOBUF_EXPORT DynamicMessageFactory : public MessageFactory {
   // The given descriptor must outlive the returned message, and hence must
   // outlive the DynamicMessageFactory.
   //
-  // The method is thread-safe.
+  // The method is thread-safe.  The first call for a given type builds the
+  // prototype under an exclusive lock; subsequent calls take only a shared
+  // reader lock, so steady-state lookups from many threads do not contend.
   const Message* GetPrototype(const Descriptor* type) override;
 
  private:
@@ -20,6 +20,7 @@
 #include "google/protobuf/dynamic_message.h"
 
 #include <memory>
+#include <thread>
 #include <vector>
 
 #include "google/protobuf/descriptor.pb.h"
@@ -125,6 +126,35 @@ TEST_F(DynamicMessageTest, OnePrototype) {
   EXPECT_EQ(prototype_, factory_.GetPrototype(descriptor_));
 }
 
+TEST_F(DynamicMessageTest, ConcurrentGetPrototype) {
+  // Many threads fetching a mix of warmed-up and fresh prototypes must all
+  // observe the same objects.  This exercises the shared-reader fast path in
+  // GetPrototype() against concurrent first-time construction.
+  const Descriptor* fresh_descriptor =
+      pool_.FindMessageTypeByName("protobuf_unittest.TestAllTypes.NestedMessage");
+  ASSERT_TRUE(fresh_descriptor != nullptr);
+
+  constexpr int kThreads = 8;
+  std::vector<const Message*> warm_results(kThreads);
+  std::vector<const Message*> fresh_results(kThreads);
+  {
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreads; ++i) {
+      threads.emplace_back([&, i] {
+        for (int j = 0; j < 1000; ++j) {
+          warm_results[i] = factory_.GetPrototype(descriptor_);
+        }
+        fresh_results[i] = factory_.GetPrototype(fresh_descriptor);
+      });
+    }
+    for (std::thread& thread : threads) thread.join();
+  }
+  for (int i = 0; i < kThreads; ++i) {
+    EXPECT_EQ(prototype_, warm_results[i]);
+    EXPECT_EQ(fresh_results[0], fresh_results[i]);
+  }
+}
+
 TEST_F(DynamicMessageTest, Defaults) {
   // Check that all default values are set correctly in the initial message.
   TestUtil::ReflectionTester reflection_tester(descriptor_);
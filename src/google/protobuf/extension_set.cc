@@ -67,34 +67,97 @@ struct ExtensionHasher {
 using ExtensionRegistry =
     absl::flat_hash_set<ExtensionInfo, ExtensionHasher, ExtensionEq>;
 
-static const ExtensionRegistry* global_registry = nullptr;
+// Published with release semantics once the first registration ran, so a
+// lookup that observes the pointer also observes the registrations made
+// before it was stored.  Lookups themselves take no lock.
+static std::atomic<const ExtensionRegistry*> global_registry{nullptr};
 
 // This function is only called at startup, so there is no need for thread-
-// safety.
+// safety beyond the publication of the registry pointer.
 void Register(const ExtensionInfo& info) {
   static auto local_static_registry = OnShutdownDelete(new ExtensionRegistry);
-  global_registry = local_static_registry;
   if (!local_static_registry->insert(info).second) {
     ABSL_LOG(FATAL) << "Multiple extension registrations for type \""
                     << info.message->GetTypeName() << "\", field number "
                     << info.number << ".";
   }
+  global_registry.store(local_static_registry, std::memory_order_release);
 }
 
+#ifndef PROTOBUF_NO_THREADLOCAL
+
+// Most workloads resolve the same handful of extensions over and over
+// (MessageSet-style payloads carry the same few per message), so a small
+// per-thread MRU cache in front of the registry turns the common lookup into
+// a few pointer compares with no shared state.  Entries hold the info by
+// value: pointers into the registry would dangle if a late registration
+// (e.g. from a dynamically loaded library) rehashed it.
+struct ExtensionFindCache {
+  struct Entry {
+    const MessageLite* extendee = nullptr;
+    int number = 0;
+    ExtensionInfo info;
+  };
+  static constexpr int kSize = 4;
+  Entry entries[kSize];
+};
+
+ExtensionFindCache& extension_find_cache() {
+  static thread_local ExtensionFindCache cache;
+  return cache;
+}
+
+const ExtensionInfo* FindCachedExtension(const MessageLite* extendee,
+                                         int number) {
+  ExtensionFindCache& cache = extension_find_cache();
+  for (auto& entry : cache.entries) {
+    if (entry.extendee == extendee && entry.number == number) {
+      return &entry.info;
+    }
+  }
+  return nullptr;
+}
+
+void CacheFoundExtension(const MessageLite* extendee, int number,
+                         const ExtensionInfo& info) {
+  ExtensionFindCache& cache = extension_find_cache();
+  for (int i = ExtensionFindCache::kSize - 1; i > 0; --i) {
+    cache.entries[i] = cache.entries[i - 1];
+  }
+  cache.entries[0] = {extendee, number, info};
+}
+
+#else  // PROTOBUF_NO_THREADLOCAL
+
+const ExtensionInfo* FindCachedExtension(const MessageLite*, int) {
+  return nullptr;
+}
+void CacheFoundExtension(const MessageLite*, int, const ExtensionInfo&) {}
+
+#endif  // PROTOBUF_NO_THREADLOCAL
+
 const ExtensionInfo* FindRegisteredExtension(const MessageLite* extendee,
                                              int number) {
-  if (!global_registry) return nullptr;
+  const ExtensionRegistry* registry =
+      global_registry.load(std::memory_order_acquire);
+  if (!registry) return nullptr;
+
+  if (const ExtensionInfo* cached = FindCachedExtension(extendee, number)) {
+    return cached;
+  }
 
   ExtensionInfo info;
   info.message = extendee;
   info.number = number;
 
-  auto it = global_registry->find(info);
-  if (it == global_registry->end()) {
+  auto it = registry->find(info);
+  if (it == registry->end()) {
+    // Negative results are not cached: the extension may simply not be
+    // registered yet.
     return nullptr;
-  } else {
-    return &*it;
   }
+  CacheFoundExtension(extendee, number, *it);
+  return &*it;
 }
 
 }  // namespace
@@ -1550,9 +1613,29 @@ const ExtensionSet::Extension* ExtensionSet::FindOrNull(int key) const {
   if (flat_size_ == 0) {
     return nullptr;
   } else if (PROTOBUF_PREDICT_TRUE(!is_large())) {
-    auto it = std::lower_bound(flat_begin(), flat_end() - 1, key,
-                               KeyValue::FirstComparator());
-    return it->first == key ? &it->second : nullptr;
+    const KeyValue* flat = flat_begin();
+    // Probe the slot of the last successful lookup first. Generated
+    // accessors pass a constant number per call site, so back-to-back
+    // lookups usually target the same slot; the probe costs one compare
+    // and is validated against the key, so a stale hint is just a miss.
+    const uint16_t hint = last_found_index_.load(std::memory_order_relaxed);
+    if (hint < flat_size_ && flat[hint].first == key) {
+      return &flat[hint].second;
+    }
+    // Branch-free lower bound: the halving step compiles to a conditional
+    // move, so the unpredictable key comparisons of a wide extension set
+    // never cost a branch mispredict.
+    const KeyValue* base = flat;
+    size_t len = flat_size_;
+    while (len > 1) {
+      const size_t half = len / 2;
+      base += (base[half - 1].first < key) ? half : 0;
+      len -= half;
+    }
+    if (base->first != key) return nullptr;
+    last_found_index_.store(static_cast<uint16_t>(base - flat),
+                            std::memory_order_relaxed);
+    return &base->second;
   } else {
     return FindOrNullInLargeMap(key);
   }
@@ -953,6 +953,12 @@ class PROTOBUF_EXPORT ExtensionSet {
   // [map_.flat, map_.flat + flat_size_) is the currently-in-use prefix.
   uint16_t flat_capacity_;
   uint16_t flat_size_;  // negative int16_t(flat_size_) indicates is_large()
+  // Slot of the last successful flat-map lookup. Generated accessors read a
+  // constant extension number per call site, so FindOrNull() probes this
+  // slot before binary searching. Purely a hint: it is re-validated against
+  // the key on every use, and relaxed atomics keep concurrent const lookups
+  // race-free. Occupies otherwise-wasted padding in front of map_.
+  mutable std::atomic<uint16_t> last_found_index_;
   union AllocatedData {
     KeyValue* flat;
 
@@ -965,7 +971,11 @@ class PROTOBUF_EXPORT ExtensionSet {
 };
 
 constexpr ExtensionSet::ExtensionSet(Arena* arena)
-    : arena_(arena), flat_capacity_(0), flat_size_(0), map_{nullptr} {}
+    : arena_(arena),
+      flat_capacity_(0),
+      flat_size_(0),
+      last_found_index_(0),
+      map_{nullptr} {}
 
 // These are just for convenience...
 inline void ExtensionSet::SetString(int number, FieldType type,
@@ -126,6 +126,35 @@ TEST(ExtensionSetTest, ClearOneField) {
   TestUtil::ExpectAllExtensionsSet(message);
 }
 
+TEST(ExtensionSetTest, RepeatedLookupsAfterMutation) {
+  // Repeated reads of one extension warm the last-found-slot hint in
+  // ExtensionSet; erasing an earlier-numbered extension then shifts the
+  // flat array so the hint goes stale.  Lookups must still resolve
+  // correctly afterwards.
+  unittest::TestAllExtensions message;
+
+  TestUtil::SetAllExtensions(&message);
+  int64_t original_value =
+      message.GetExtension(unittest::optional_int64_extension);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(original_value,
+              message.GetExtension(unittest::optional_int64_extension));
+  }
+
+  message.ClearExtension(unittest::optional_int32_extension);
+  EXPECT_FALSE(message.HasExtension(unittest::optional_int32_extension));
+  EXPECT_EQ(original_value,
+            message.GetExtension(unittest::optional_int64_extension));
+  EXPECT_TRUE(message.HasExtension(unittest::optional_uint32_extension));
+
+  // Alternating lookups between two numbers must each see their own value.
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(original_value,
+              message.GetExtension(unittest::optional_int64_extension));
+    EXPECT_TRUE(message.HasExtension(unittest::optional_uint64_extension));
+  }
+}
+
 TEST(ExtensionSetTest, SetAllocatedExtension) {
   unittest::TestAllExtensions message;
   EXPECT_FALSE(
@@ -840,10 +869,16 @@ TEST(ExtensionSetTest, SpaceUsedExcludingSelf) {
     const size_t old_capacity =                                                \
         message->GetRepeatedExtension(unittest::repeated_##type##_extension)   \
             .Capacity();                                                       \
-    EXPECT_GE(                                                                 \
-        old_capacity,                                                          \
-        (RepeatedFieldLowerClampLimit<cpptype, std::max(sizeof(cpptype),       \
-                                                        sizeof(void*))>()));   \
+    /* Small element types are stored inline in the RepeatedField and only  */ \
+    /* retain the inline capacity; everything else clamps to the minimum    */ \
+    /* allocation size.                                                     */ \
+    const size_t min_retained_capacity = std::max<size_t>(                     \
+        1, std::min<size_t>(                                                   \
+               (RepeatedFieldLowerClampLimit<                                  \
+                   cpptype, std::max(sizeof(cpptype), sizeof(void*))>()) -     \
+                   1,                                                          \
+               sizeof(void*) / sizeof(cpptype)));                              \
+    EXPECT_GE(old_capacity, min_retained_capacity);                            \
     for (int i = 0; i < 16; ++i) {                                             \
       message->AddExtension(unittest::repeated_##type##_extension, value);     \
     }                                                                          \
@@ -1414,6 +1449,44 @@ TEST(ExtensionSetTest, BoolExtension) {
   EXPECT_TRUE(msg.GetExtension(protobuf_unittest::optional_bool_extension));
 }
 
+TEST(ExtensionSetTest, RepeatedGeneratedFinderLookupsStayConsistent) {
+  // Repeated lookups of the same extensions are served by the per-thread
+  // find cache after the first hit; the cached info must match the registry.
+  const MessageLite* extendee =
+      &unittest::TestAllExtensions::default_instance();
+  GeneratedExtensionFinder finder(extendee);
+
+  const int numbers[] = {
+      unittest::optional_int32_extension.number(),
+      unittest::optional_string_extension.number(),
+      unittest::optional_nested_message_extension.number(),
+  };
+  ExtensionInfo first[3];
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(finder.Find(numbers[i], &first[i]));
+  }
+  // A burst of other lookups cycles the cache; the original entries must
+  // still resolve identically whether they come from the cache or not.
+  for (int round = 0; round < 3; ++round) {
+    ExtensionInfo info;
+    EXPECT_TRUE(
+        finder.Find(unittest::optional_bool_extension.number(), &info));
+    EXPECT_TRUE(
+        finder.Find(unittest::optional_double_extension.number(), &info));
+    for (int i = 0; i < 3; ++i) {
+      ASSERT_TRUE(finder.Find(numbers[i], &info));
+      EXPECT_EQ(info.message, first[i].message);
+      EXPECT_EQ(info.number, first[i].number);
+      EXPECT_EQ(info.type, first[i].type);
+      EXPECT_EQ(info.is_repeated, first[i].is_repeated);
+    }
+  }
+  // Unregistered numbers keep failing; misses are not cached.
+  ExtensionInfo info;
+  EXPECT_FALSE(finder.Find(99999999, &info));
+  EXPECT_FALSE(finder.Find(99999999, &info));
+}
+
 TEST(ExtensionSetTest, ConstInit) {
   PROTOBUF_CONSTINIT static ExtensionSet set{};
   EXPECT_EQ(set.NumExtensions(), 0);
@@ -0,0 +1,341 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/fast_debug_string.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "absl/base/casts.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/io/strtod.h"
+#include "google/protobuf/message.h"
+#include "google/protobuf/text_format.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+
+namespace internal {
+
+// Friend shim giving this translation unit access to the precomputed visit
+// plan without widening the public Reflection API.
+class FastDebugEmitter {
+ public:
+  using Entry = Reflection::FieldVisitEntry;
+
+  static const Entry* Plan(const Reflection* reflection, int* size) {
+    return reflection->GetVisitPlan(size);
+  }
+};
+
+}  // namespace internal
+
+namespace util {
+namespace {
+
+// FNV-1a, chosen over absl::Hash because redaction tags must be stable across
+// processes and binary versions to be useful for log correlation.
+constexpr uint64_t kFnvOffsetBasis = 0xcbf29ce484222325u;
+constexpr uint64_t kFnvPrime = 0x100000001b3u;
+
+uint64_t FnvHash(absl::string_view data) {
+  uint64_t hash = kFnvOffsetBasis;
+  for (char c : data) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= kFnvPrime;
+  }
+  return hash;
+}
+
+// Hashes the little-endian byte representation of `word` so scalar tags do
+// not depend on host endianness.
+uint64_t FnvHashWord(uint64_t word) {
+  char bytes[8];
+  for (int i = 0; i < 8; ++i) {
+    bytes[i] = static_cast<char>(word >> (8 * i));
+  }
+  return FnvHash(absl::string_view(bytes, 8));
+}
+
+class Emitter {
+ public:
+  Emitter(std::string* output, const FastDebugStringOptions& options)
+      : output_(output),
+        options_(options),
+        start_size_(output->size()),
+        limit_(output->size() + options.byte_budget) {}
+
+  void Emit(const Message& message, int depth);
+
+  bool truncated() const { return truncated_; }
+
+ private:
+  using Entry = internal::FastDebugEmitter::Entry;
+
+  // Returns false (and latches the truncation flag) once the budget is spent.
+  bool HasBudget() {
+    if (output_->size() >= limit_) {
+      truncated_ = true;
+      return false;
+    }
+    return true;
+  }
+
+  // Appends a separating space unless we are at the start of the output.
+  void Sep() {
+    if (output_->size() > start_size_ && output_->back() != ' ') {
+      output_->push_back(' ');
+    }
+  }
+
+  // `index` is -1 for singular fields.
+  void EmitField(const Message& message, const Reflection* reflection,
+                 const FieldDescriptor* field, int index, int depth);
+  void EmitValue(const Message& message, const Reflection* reflection,
+                 const FieldDescriptor* field, int index, int depth);
+  void EmitRedacted(const Message& message, const Reflection* reflection,
+                    const FieldDescriptor* field, int index);
+
+  std::string* output_;
+  const FastDebugStringOptions& options_;
+  const size_t start_size_;
+  const size_t limit_;
+  bool truncated_ = false;
+};
+
+void Emitter::Emit(const Message& message, int depth) {
+  const Reflection* reflection = message.GetReflection();
+  int plan_size = 0;
+  const Entry* plan =
+      internal::FastDebugEmitter::Plan(reflection, &plan_size);
+  for (int i = 0; i < plan_size; ++i) {
+    if (!HasBudget()) return;
+    const Entry& entry = plan[i];
+    const FieldDescriptor* field = entry.field;
+    if (entry.kind == Entry::kRepeated) {
+      const int count = reflection->FieldSize(message, field);
+      for (int j = 0; j < count; ++j) {
+        if (!HasBudget()) return;
+        EmitField(message, reflection, field, j, depth);
+      }
+    } else {
+      if (!reflection->HasField(message, field)) continue;
+      EmitField(message, reflection, field, -1, depth);
+    }
+  }
+}
+
+void Emitter::EmitField(const Message& message, const Reflection* reflection,
+                        const FieldDescriptor* field, int index, int depth) {
+  Sep();
+  output_->append(field->name());
+  if (internal::ShouldRedactField(field)) {
+    output_->append(": ");
+    EmitRedacted(message, reflection, field, index);
+    return;
+  }
+  if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+    if (depth >= options_.max_depth) {
+      output_->append(" {...}");
+      return;
+    }
+    output_->append(" { ");
+    Emit(index < 0 ? reflection->GetMessage(message, field)
+                   : reflection->GetRepeatedMessage(message, field, index),
+         depth + 1);
+    Sep();
+    output_->push_back('}');
+    return;
+  }
+  output_->append(": ");
+  EmitValue(message, reflection, field, index, depth);
+}
+
+void Emitter::EmitValue(const Message& message, const Reflection* reflection,
+                        const FieldDescriptor* field, int index, int depth) {
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      absl::StrAppend(output_,
+                      index < 0
+                          ? reflection->GetInt32(message, field)
+                          : reflection->GetRepeatedInt32(message, field, index));
+      break;
+    case FieldDescriptor::CPPTYPE_INT64:
+      absl::StrAppend(output_,
+                      index < 0
+                          ? reflection->GetInt64(message, field)
+                          : reflection->GetRepeatedInt64(message, field, index));
+      break;
+    case FieldDescriptor::CPPTYPE_UINT32:
+      absl::StrAppend(
+          output_,
+          index < 0 ? reflection->GetUInt32(message, field)
+                    : reflection->GetRepeatedUInt32(message, field, index));
+      break;
+    case FieldDescriptor::CPPTYPE_UINT64:
+      absl::StrAppend(
+          output_,
+          index < 0 ? reflection->GetUInt64(message, field)
+                    : reflection->GetRepeatedUInt64(message, field, index));
+      break;
+    case FieldDescriptor::CPPTYPE_DOUBLE: {
+      char buffer[io::kDoubleToBufferSize];
+      output_->append(io::DoubleToBuffer(
+          index < 0 ? reflection->GetDouble(message, field)
+                    : reflection->GetRepeatedDouble(message, field, index),
+          buffer));
+      break;
+    }
+    case FieldDescriptor::CPPTYPE_FLOAT: {
+      char buffer[io::kFloatToBufferSize];
+      output_->append(io::FloatToBuffer(
+          index < 0 ? reflection->GetFloat(message, field)
+                    : reflection->GetRepeatedFloat(message, field, index),
+          buffer));
+      break;
+    }
+    case FieldDescriptor::CPPTYPE_BOOL:
+      output_->append(
+          (index < 0 ? reflection->GetBool(message, field)
+                     : reflection->GetRepeatedBool(message, field, index))
+              ? "true"
+              : "false");
+      break;
+    case FieldDescriptor::CPPTYPE_ENUM: {
+      const int number =
+          index < 0 ? reflection->GetEnumValue(message, field)
+                    : reflection->GetRepeatedEnumValue(message, field, index);
+      const EnumValueDescriptor* value =
+          field->enum_type()->FindValueByNumber(number);
+      if (value != nullptr) {
+        output_->append(value->name());
+      } else {
+        absl::StrAppend(output_, number);
+      }
+      break;
+    }
+    case FieldDescriptor::CPPTYPE_STRING: {
+      std::string scratch;
+      const std::string& value =
+          index < 0 ? reflection->GetStringReference(message, field, &scratch)
+                    : reflection->GetRepeatedStringReference(message, field,
+                                                             index, &scratch);
+      absl::string_view view = value;
+      const bool clipped = view.size() > options_.max_string_bytes;
+      if (clipped) view = view.substr(0, options_.max_string_bytes);
+      output_->push_back('"');
+      output_->append(absl::CEscape(view));
+      if (clipped) output_->append("...");
+      output_->push_back('"');
+      break;
+    }
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      // Handled in EmitField.
+      break;
+  }
+}
+
+void Emitter::EmitRedacted(const Message& message,
+                           const Reflection* reflection,
+                           const FieldDescriptor* field, int index) {
+  uint64_t tag;
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      tag = FnvHashWord(static_cast<uint64_t>(static_cast<int64_t>(
+          index < 0 ? reflection->GetInt32(message, field)
+                    : reflection->GetRepeatedInt32(message, field, index))));
+      break;
+    case FieldDescriptor::CPPTYPE_INT64:
+      tag = FnvHashWord(static_cast<uint64_t>(
+          index < 0 ? reflection->GetInt64(message, field)
+                    : reflection->GetRepeatedInt64(message, field, index)));
+      break;
+    case FieldDescriptor::CPPTYPE_UINT32:
+      tag = FnvHashWord(
+          index < 0 ? reflection->GetUInt32(message, field)
+                    : reflection->GetRepeatedUInt32(message, field, index));
+      break;
+    case FieldDescriptor::CPPTYPE_UINT64:
+      tag = FnvHashWord(
+          index < 0 ? reflection->GetUInt64(message, field)
+                    : reflection->GetRepeatedUInt64(message, field, index));
+      break;
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      tag = FnvHashWord(absl::bit_cast<uint64_t>(
+          index < 0 ? reflection->GetDouble(message, field)
+                    : reflection->GetRepeatedDouble(message, field, index)));
+      break;
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      tag = FnvHashWord(absl::bit_cast<uint32_t>(
+          index < 0 ? reflection->GetFloat(message, field)
+                    : reflection->GetRepeatedFloat(message, field, index)));
+      break;
+    case FieldDescriptor::CPPTYPE_BOOL:
+      tag = FnvHashWord(
+          (index < 0 ? reflection->GetBool(message, field)
+                     : reflection->GetRepeatedBool(message, field, index))
+              ? 1
+              : 0);
+      break;
+    case FieldDescriptor::CPPTYPE_ENUM:
+      tag = FnvHashWord(static_cast<uint64_t>(static_cast<int64_t>(
+          index < 0
+              ? reflection->GetEnumValue(message, field)
+              : reflection->GetRepeatedEnumValue(message, field, index))));
+      break;
+    case FieldDescriptor::CPPTYPE_STRING: {
+      std::string scratch;
+      const std::string& value =
+          index < 0 ? reflection->GetStringReference(message, field, &scratch)
+                    : reflection->GetRepeatedStringReference(message, field,
+                                                             index, &scratch);
+      tag = FnvHash(value);
+      break;
+    }
+    case FieldDescriptor::CPPTYPE_MESSAGE: {
+      const Message& sub =
+          index < 0 ? reflection->GetMessage(message, field)
+                    : reflection->GetRepeatedMessage(message, field, index);
+      tag = FnvHash(sub.SerializePartialAsString());
+      break;
+    }
+    default:
+      tag = 0;
+      break;
+  }
+  absl::StrAppend(output_, "[REDACTED:", absl::Hex(tag, absl::kZeroPad16),
+                  "]");
+}
+
+}  // namespace
+
+void FastDebugStringTo(const Message& message, std::string* output,
+                       const FastDebugStringOptions& options) {
+  Emitter emitter(output, options);
+  emitter.Emit(message, 0);
+  if (emitter.truncated()) output->append("...");
+}
+
+std::string FastDebugString(const Message& message,
+                            const FastDebugStringOptions& options) {
+  std::string output;
+  FastDebugStringTo(message, &output, options);
+  return output;
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
@@ -0,0 +1,69 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+//
+// A lightweight, budget-capped debug formatter intended for hot error paths
+// where Message::DebugString() is too expensive to leave enabled. It walks the
+// precomputed per-field visit plan instead of ListFields(), writes a single
+// line of text-format-like output, and stops as soon as the byte budget is
+// exhausted.
+//
+// Fields marked `[debug_redact = true]` are never printed verbatim. Instead
+// the value is replaced with `[REDACTED:<tag>]`, where <tag> is a stable
+// 64-bit hash of the value. The tag is identical across processes and binary
+// versions, so redacted logs from different machines can still be correlated
+// ("these two errors saw the same user id") without revealing the value.
+//
+// The output is for human eyes and log scrapers only: it is not guaranteed to
+// be parseable text format, and extensions and unknown fields are omitted.
+
+#ifndef GOOGLE_PROTOBUF_FAST_DEBUG_STRING_H__
+#define GOOGLE_PROTOBUF_FAST_DEBUG_STRING_H__
+
+#include <cstddef>
+#include <string>
+
+#include "google/protobuf/message.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+struct FastDebugStringOptions {
+  // Stop emitting once the output reaches this many bytes; a truncated result
+  // ends with "...". The cap is approximate (the last value written may
+  // overshoot slightly).
+  size_t byte_budget = 1024;
+
+  // Sub-messages nested deeper than this print as "{...}".
+  int max_depth = 8;
+
+  // Individual string/bytes values longer than this are truncated before
+  // escaping.
+  size_t max_string_bytes = 64;
+};
+
+// Appends a single-line debug rendering of `message` to `*output`, honoring
+// the caps in `options`. Typical messages format in a few microseconds.
+PROTOBUF_EXPORT void FastDebugStringTo(const Message& message,
+                                       std::string* output,
+                                       const FastDebugStringOptions& options);
+
+// Convenience form returning the rendering as a new string.
+PROTOBUF_EXPORT std::string FastDebugString(
+    const Message& message,
+    const FastDebugStringOptions& options = FastDebugStringOptions());
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_FAST_DEBUG_STRING_H__
@@ -0,0 +1,129 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/fast_debug_string.h"
+
+#include <string>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "google/protobuf/unittest.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+using ::testing::HasSubstr;
+using ::testing::Not;
+
+TEST(FastDebugStringTest, FormatsScalarsOnOneLine) {
+  protobuf_unittest::TestAllTypes message;
+  message.set_optional_int32(101);
+  message.set_optional_string("hello");
+  message.set_optional_bool(true);
+  message.add_repeated_int32(1);
+  message.add_repeated_int32(2);
+
+  const std::string output = FastDebugString(message);
+  EXPECT_EQ(output,
+            "optional_int32: 101 optional_bool: true "
+            "optional_string: \"hello\" repeated_int32: 1 repeated_int32: 2");
+  EXPECT_THAT(output, Not(HasSubstr("\n")));
+}
+
+TEST(FastDebugStringTest, FormatsNestedMessages) {
+  protobuf_unittest::TestAllTypes message;
+  message.mutable_optional_nested_message()->set_bb(42);
+
+  EXPECT_EQ(FastDebugString(message), "optional_nested_message { bb: 42 }");
+}
+
+TEST(FastDebugStringTest, TruncatesAtByteBudget) {
+  protobuf_unittest::TestAllTypes message;
+  for (int i = 0; i < 1000; ++i) {
+    message.add_repeated_int32(i);
+  }
+
+  FastDebugStringOptions options;
+  options.byte_budget = 100;
+  const std::string output = FastDebugString(message, options);
+  // The budget is approximate: the last value written may overshoot, plus the
+  // "..." marker.
+  EXPECT_LE(output.size(), 100 + sizeof("repeated_int32: 1000") + 3);
+  EXPECT_THAT(output, ::testing::EndsWith("..."));
+}
+
+TEST(FastDebugStringTest, AppendsAfterExistingOutput) {
+  protobuf_unittest::TestAllTypes message;
+  message.set_optional_int32(7);
+
+  std::string output = "prefix: ";
+  FastDebugStringTo(message, &output, FastDebugStringOptions());
+  EXPECT_EQ(output, "prefix: optional_int32: 7");
+}
+
+TEST(FastDebugStringTest, CapsNestingDepth) {
+  protobuf_unittest::TestAllTypes message;
+  message.mutable_optional_nested_message()->set_bb(42);
+
+  FastDebugStringOptions options;
+  options.max_depth = 0;
+  EXPECT_EQ(FastDebugString(message, options),
+            "optional_nested_message {...}");
+}
+
+TEST(FastDebugStringTest, TruncatesLongStrings) {
+  protobuf_unittest::TestAllTypes message;
+  message.set_optional_string(std::string(100, 'x'));
+
+  FastDebugStringOptions options;
+  options.max_string_bytes = 8;
+  EXPECT_EQ(FastDebugString(message, options),
+            "optional_string: \"xxxxxxxx...\"");
+}
+
+TEST(FastDebugStringTest, RedactsMarkedFields) {
+  protobuf_unittest::RedactedFields message;
+  message.set_optional_redacted_string("secret");
+  message.set_optional_unredacted_string("public");
+
+  const std::string output = FastDebugString(message);
+  EXPECT_THAT(output, Not(HasSubstr("secret")));
+  EXPECT_THAT(output, HasSubstr("optional_redacted_string: [REDACTED:"));
+  EXPECT_THAT(output, HasSubstr("optional_unredacted_string: \"public\""));
+}
+
+TEST(FastDebugStringTest, RedactionTagsAreStablePerValue) {
+  protobuf_unittest::RedactedFields a, b, c;
+  a.set_optional_redacted_string("secret");
+  b.set_optional_redacted_string("secret");
+  c.set_optional_redacted_string("other");
+
+  // Equal values hash to equal tags so redacted logs can still be correlated;
+  // distinct values get distinct tags.
+  EXPECT_EQ(FastDebugString(a), FastDebugString(b));
+  EXPECT_NE(FastDebugString(a), FastDebugString(c));
+}
+
+TEST(FastDebugStringTest, RedactsMessageAndRepeatedFields) {
+  protobuf_unittest::RedactedFields message;
+  message.add_repeated_redacted_string("secret1");
+  message.add_repeated_redacted_string("secret2");
+  message.mutable_optional_redacted_message()->set_optional_unredacted_nested_string(
+      "nested-secret");
+
+  const std::string output = FastDebugString(message);
+  EXPECT_THAT(output, Not(HasSubstr("secret")));
+  EXPECT_THAT(output, HasSubstr("repeated_redacted_string: [REDACTED:"));
+  EXPECT_THAT(output, HasSubstr("optional_redacted_message: [REDACTED:"));
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
@@ -56,6 +56,20 @@ bool LookUpEnumValue(const EnumEntry* enums, size_t size,
 
 int LookUpEnumName(const EnumEntry* enums, const int* sorted_indices,
                    size_t size, int value) {
+  if (size == 0) return -1;
+  // Dense fast path: when the values form a contiguous range (the common
+  // case), the sorted position of `value` is its offset from the smallest
+  // value and no search is needed.  Enums with aliased values never take
+  // this path -- duplicates make the range smaller than the entry count --
+  // so the binary search below keeps returning the first alias.
+  const int min_value = enums[sorted_indices[0]].value;
+  const int max_value = enums[sorted_indices[size - 1]].value;
+  if (static_cast<int64_t>(max_value) - min_value + 1 ==
+      static_cast<int64_t>(size)) {
+    if (value < min_value || value > max_value) return -1;
+    return value - min_value;
+  }
+
   auto comparator = [enums, value](int a, int b) {
     return GetValue(enums, a, value) < GetValue(enums, b, value);
   };
@@ -70,6 +84,11 @@ int LookUpEnumName(const EnumEntry* enums, const int* sorted_indices,
 bool InitializeEnumStrings(
     const EnumEntry* enums, const int* sorted_indices, size_t size,
     internal::ExplicitlyConstructed<std::string>* enum_strings) {
+  // The generated _Name() helpers fall back to the fixed-address empty
+  // string for unknown values via GetEmptyStringAlreadyInited(), so make
+  // sure it is constructed here, under the helper's one-time guard, rather
+  // than gating every lookup on it.
+  InitProtobufDefaults();
   for (size_t i = 0; i < size; ++i) {
     enum_strings[i].Construct(enums[sorted_indices[i]].name);
     internal::OnShutdownDestroyString(enum_strings[i].get_mutable());
@@ -204,6 +204,46 @@ TEST(ValidateEnumTest, BitmapRangeTest) {
               ElementsAre(4, 21, 32 + 6));
 }
 
+TEST(LookUpEnumNameTest, DenseRangeIsDirectIndexed) {
+  // Entries are sorted by name, sorted_indices by value, matching the
+  // layout the code generator emits.
+  const EnumEntry enums[] = {{"ALPHA", 1}, {"BETA", 2}, {"GAMMA", 3}};
+  const int sorted_indices[] = {0, 1, 2};
+  EXPECT_EQ(0, LookUpEnumName(enums, sorted_indices, 3, 1));
+  EXPECT_EQ(1, LookUpEnumName(enums, sorted_indices, 3, 2));
+  EXPECT_EQ(2, LookUpEnumName(enums, sorted_indices, 3, 3));
+  EXPECT_EQ(-1, LookUpEnumName(enums, sorted_indices, 3, 0));
+  EXPECT_EQ(-1, LookUpEnumName(enums, sorted_indices, 3, 4));
+}
+
+TEST(LookUpEnumNameTest, DenseRangeWithNegativeValues) {
+  const EnumEntry enums[] = {{"MINUS", -1}, {"PLUS", 1}, {"ZERO", 0}};
+  const int sorted_indices[] = {0, 2, 1};
+  EXPECT_EQ(0, LookUpEnumName(enums, sorted_indices, 3, -1));
+  EXPECT_EQ(1, LookUpEnumName(enums, sorted_indices, 3, 0));
+  EXPECT_EQ(2, LookUpEnumName(enums, sorted_indices, 3, 1));
+  EXPECT_EQ(-1, LookUpEnumName(enums, sorted_indices, 3, -2));
+}
+
+TEST(LookUpEnumNameTest, SparseValuesFallBackToBinarySearch) {
+  const EnumEntry enums[] = {{"FIRST", 0}, {"SECOND", 5}, {"THIRD", 100}};
+  const int sorted_indices[] = {0, 1, 2};
+  EXPECT_EQ(0, LookUpEnumName(enums, sorted_indices, 3, 0));
+  EXPECT_EQ(1, LookUpEnumName(enums, sorted_indices, 3, 5));
+  EXPECT_EQ(2, LookUpEnumName(enums, sorted_indices, 3, 100));
+  EXPECT_EQ(-1, LookUpEnumName(enums, sorted_indices, 3, 3));
+}
+
+TEST(LookUpEnumNameTest, AliasedValuesReturnFirstAlias) {
+  // Aliases make the value range smaller than the entry count, so the
+  // dense path must not trigger and the first alias in sorted order wins.
+  const EnumEntry enums[] = {{"FIRST", 0}, {"FIRST_ALIAS", 0}, {"NEXT", 1}};
+  const int sorted_indices[] = {0, 1, 2};
+  EXPECT_EQ(0, LookUpEnumName(enums, sorted_indices, 3, 0));
+  EXPECT_EQ(2, LookUpEnumName(enums, sorted_indices, 3, 1));
+  EXPECT_EQ(-1, LookUpEnumName(enums, sorted_indices, 3, 2));
+}
+
 TEST(ValidateEnumTest, GenerateEnumDataSequential) {
   EXPECT_THAT(GenerateEnumData({0, 1, 2, 3}), ElementsAre(
                                                   // sequence start=0, length=4
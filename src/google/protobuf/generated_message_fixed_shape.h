@@ -0,0 +1,300 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+// Compile-time shape-specialized codec for "fixed-shape" messages: messages
+// whose fields are all singular scalars with no explicit presence (implicit
+// presence or LEGACY_REQUIRED under editions), no oneofs, no extensions and
+// no strings.  For such messages the wire layout is fully determined by the
+// type, so parse and serialize reduce to a fixed sequence of loads and
+// stores that the compiler can unroll.
+//
+// The code generator emits a FixedShapeTraits<T> specialization for each
+// qualifying message when the `fixed_shape_codec` generator option is set;
+// the templates below are selected by that specialization.  Serialization
+// writes every field, including zero-valued ones, which keeps the codec
+// branch-free; the output is valid wire format that any conforming parser
+// accepts, it is just not the minimal encoding the generated serializer
+// produces.  FixedShapeParseFromArray() conversely requires its input to
+// contain exactly the message's fields in field-number order and reports
+// failure otherwise, so callers can fall back to the general parser (see
+// FixedShapeParse()).  Enum fields are stored without range checking, as
+// for open enums.
+
+#ifndef GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIXED_SHAPE_H__
+#define GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIXED_SHAPE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/wire_format_lite.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+
+// Wire encodings a fixed-shape field can use.  Strings, messages, groups and
+// repeated fields are deliberately absent: messages containing them are not
+// eligible for this codec.
+enum class FixedShapeFieldType : uint8_t {
+  kVarint32,   // int32, enum; sign-extended to 64 bits on the wire
+  kVarint64,   // int64
+  kVarintU32,  // uint32
+  kVarintU64,  // uint64
+  kZigZag32,   // sint32
+  kZigZag64,   // sint64
+  kFixed32,    // fixed32, sfixed32, float
+  kFixed64,    // fixed64, sfixed64, double
+  kBool,       // bool
+};
+
+// Layout of one field of a fixed-shape message.  The code generator emits one
+// of these per field, in field-number order.
+struct FixedShapeField {
+  uint32_t tag;     // (field_number << 3) | wire_type
+  uint32_t offset;  // byte offset of the field storage within the message
+  uint8_t tag_size;  // encoded size of `tag`, in bytes
+  FixedShapeFieldType type;
+};
+
+// Primary template: not a fixed-shape message.  protoc specializes this for
+// qualifying messages when the `fixed_shape_codec` generator option is set;
+// specializations provide
+//   static constexpr bool value = true;
+//   static constexpr int field_count;
+//   static const FixedShapeField* fields();  // `field_count` entries
+template <typename T>
+struct FixedShapeTraits {
+  static constexpr bool value = false;
+};
+
+// Reads a field's storage as a 64-bit value ready for wire encoding.
+inline uint64_t FixedShapeLoadValue(const char* base,
+                                    const FixedShapeField& field) {
+  const char* src = base + field.offset;
+  switch (field.type) {
+    case FixedShapeFieldType::kVarint32: {
+      int32_t value;
+      std::memcpy(&value, src, sizeof(value));
+      return static_cast<uint64_t>(static_cast<int64_t>(value));
+    }
+    case FixedShapeFieldType::kVarintU32:
+    case FixedShapeFieldType::kFixed32: {
+      uint32_t value;
+      std::memcpy(&value, src, sizeof(value));
+      return value;
+    }
+    case FixedShapeFieldType::kZigZag32: {
+      int32_t value;
+      std::memcpy(&value, src, sizeof(value));
+      return WireFormatLite::ZigZagEncode32(value);
+    }
+    case FixedShapeFieldType::kZigZag64: {
+      int64_t value;
+      std::memcpy(&value, src, sizeof(value));
+      return WireFormatLite::ZigZagEncode64(value);
+    }
+    case FixedShapeFieldType::kBool: {
+      bool value;
+      std::memcpy(&value, src, sizeof(value));
+      return value ? 1 : 0;
+    }
+    default: {  // kVarint64, kVarintU64, kFixed64
+      uint64_t value;
+      std::memcpy(&value, src, sizeof(value));
+      return value;
+    }
+  }
+}
+
+// Stores a decoded 64-bit wire value into a field's storage.
+inline void FixedShapeStoreValue(char* base, const FixedShapeField& field,
+                                 uint64_t value) {
+  char* dst = base + field.offset;
+  switch (field.type) {
+    case FixedShapeFieldType::kVarint32:
+    case FixedShapeFieldType::kVarintU32:
+    case FixedShapeFieldType::kFixed32: {
+      const uint32_t narrow = static_cast<uint32_t>(value);
+      std::memcpy(dst, &narrow, sizeof(narrow));
+      break;
+    }
+    case FixedShapeFieldType::kZigZag32: {
+      const int32_t decoded =
+          WireFormatLite::ZigZagDecode32(static_cast<uint32_t>(value));
+      std::memcpy(dst, &decoded, sizeof(decoded));
+      break;
+    }
+    case FixedShapeFieldType::kZigZag64: {
+      const int64_t decoded = WireFormatLite::ZigZagDecode64(value);
+      std::memcpy(dst, &decoded, sizeof(decoded));
+      break;
+    }
+    case FixedShapeFieldType::kBool: {
+      const bool narrow = value != 0;
+      std::memcpy(dst, &narrow, sizeof(narrow));
+      break;
+    }
+    default: {  // kVarint64, kVarintU64, kFixed64
+      std::memcpy(dst, &value, sizeof(value));
+      break;
+    }
+  }
+}
+
+// Reads one varint; returns nullptr on truncated or overlong input.
+inline const uint8_t* FixedShapeReadVarint(const uint8_t* ptr,
+                                           const uint8_t* end,
+                                           uint64_t* value) {
+  uint64_t result = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (ptr == end) return nullptr;
+    const uint64_t byte = *ptr++;
+    result |= (byte & 0x7f) << shift;
+    if (byte < 0x80) {
+      *value = result;
+      return ptr;
+    }
+  }
+  return nullptr;
+}
+
+// Computes the serialized size of `msg`.  Every field is counted, including
+// zero-valued ones; see FixedShapeSerializeToArray().
+template <typename T>
+size_t FixedShapeByteSizeLong(const T& msg) {
+  static_assert(FixedShapeTraits<T>::value,
+                "FixedShapeByteSizeLong requires a fixed-shape message");
+  const char* base = reinterpret_cast<const char*>(&msg);
+  const FixedShapeField* fields = FixedShapeTraits<T>::fields();
+  size_t total = 0;
+  for (int i = 0; i < FixedShapeTraits<T>::field_count; ++i) {
+    const FixedShapeField& field = fields[i];
+    total += field.tag_size;
+    switch (field.type) {
+      case FixedShapeFieldType::kFixed32:
+        total += sizeof(uint32_t);
+        break;
+      case FixedShapeFieldType::kFixed64:
+        total += sizeof(uint64_t);
+        break;
+      case FixedShapeFieldType::kBool:
+        total += 1;
+        break;
+      default:
+        total += io::CodedOutputStream::VarintSize64(
+            FixedShapeLoadValue(base, field));
+        break;
+    }
+  }
+  return total;
+}
+
+// Serializes every field of `msg` to `target`, which must have at least
+// FixedShapeByteSizeLong(msg) bytes available, and returns a pointer past the
+// last byte written.
+template <typename T>
+uint8_t* FixedShapeSerializeToArray(const T& msg, uint8_t* target) {
+  static_assert(FixedShapeTraits<T>::value,
+                "FixedShapeSerializeToArray requires a fixed-shape message");
+  const char* base = reinterpret_cast<const char*>(&msg);
+  const FixedShapeField* fields = FixedShapeTraits<T>::fields();
+  for (int i = 0; i < FixedShapeTraits<T>::field_count; ++i) {
+    const FixedShapeField& field = fields[i];
+    target = io::CodedOutputStream::WriteVarint32ToArray(field.tag, target);
+    const uint64_t value = FixedShapeLoadValue(base, field);
+    switch (field.type) {
+      case FixedShapeFieldType::kFixed32:
+        target = io::CodedOutputStream::WriteLittleEndian32ToArray(
+            static_cast<uint32_t>(value), target);
+        break;
+      case FixedShapeFieldType::kFixed64:
+        target = io::CodedOutputStream::WriteLittleEndian64ToArray(value,
+                                                                   target);
+        break;
+      case FixedShapeFieldType::kBool:
+        *target++ = static_cast<uint8_t>(value);
+        break;
+      default:
+        target = io::CodedOutputStream::WriteVarint64ToArray(value, target);
+        break;
+    }
+  }
+  return target;
+}
+
+// Serializes `msg` into `output`, replacing its contents.
+template <typename T>
+void FixedShapeSerializeToString(const T& msg, std::string* output) {
+  output->resize(FixedShapeByteSizeLong(msg));
+  FixedShapeSerializeToArray(msg, reinterpret_cast<uint8_t*>(&(*output)[0]));
+}
+
+// Parses a buffer holding exactly the message's fields in field-number
+// order, the shape FixedShapeSerializeToArray() produces.  Returns false if
+// the input deviates (missing, reordered or unknown fields, or a malformed
+// value); `msg` may have been partially overwritten by then, so the caller
+// should fall back to the general parser on the same input.
+template <typename T>
+bool FixedShapeParseFromArray(const void* data, size_t size, T* msg) {
+  static_assert(FixedShapeTraits<T>::value,
+                "FixedShapeParseFromArray requires a fixed-shape message");
+  const uint8_t* ptr = static_cast<const uint8_t*>(data);
+  const uint8_t* end = ptr + size;
+  char* base = reinterpret_cast<char*>(msg);
+  const FixedShapeField* fields = FixedShapeTraits<T>::fields();
+  for (int i = 0; i < FixedShapeTraits<T>::field_count; ++i) {
+    const FixedShapeField& field = fields[i];
+    uint64_t tag;
+    ptr = FixedShapeReadVarint(ptr, end, &tag);
+    if (ptr == nullptr || tag != field.tag) return false;
+    uint64_t value;
+    switch (field.type) {
+      case FixedShapeFieldType::kFixed32: {
+        if (end - ptr < static_cast<ptrdiff_t>(sizeof(uint32_t))) return false;
+        uint32_t narrow;
+        ptr = io::CodedInputStream::ReadLittleEndian32FromArray(ptr, &narrow);
+        value = narrow;
+        break;
+      }
+      case FixedShapeFieldType::kFixed64: {
+        if (end - ptr < static_cast<ptrdiff_t>(sizeof(uint64_t))) return false;
+        ptr = io::CodedInputStream::ReadLittleEndian64FromArray(ptr, &value);
+        break;
+      }
+      default:
+        ptr = FixedShapeReadVarint(ptr, end, &value);
+        if (ptr == nullptr) return false;
+        break;
+    }
+    FixedShapeStoreValue(base, field, value);
+  }
+  return ptr == end;
+}
+
+// Drop-in replacement for ParseFromString(): takes the fixed-shape fast path
+// when the input matches and falls back to the general parser when it does
+// not (e.g. the canonical serializer omitted a zero-valued field).
+template <typename T>
+bool FixedShapeParse(absl::string_view data, T* msg) {
+  if (FixedShapeParseFromArray(data.data(), data.size(), msg)) return true;
+  return msg->ParseFromArray(data.data(), static_cast<int>(data.size()));
+}
+
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIXED_SHAPE_H__
@@ -0,0 +1,151 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/generated_message_fixed_shape.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <gtest/gtest.h>
+#include "absl/strings/string_view.h"
+#include "google/protobuf/wire_format_lite.h"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+
+// Exercising a generated FixedShapeTraits specialization would require
+// running protoc, so mirror by hand what the generator emits for
+//   message TestShape {
+//     int32 varint32 = 1;
+//     uint64 varint_u64 = 2;
+//     sint32 zigzag32 = 3;
+//     float float32 = 4;
+//     double double64 = 5;
+//     bool flag = 6;
+//   }
+struct FixedShapeTestMessage {
+  int32_t varint32;
+  uint64_t varint_u64;
+  int32_t zigzag32;
+  float float32;
+  double double64;
+  bool flag;
+};
+
+template <>
+struct FixedShapeTraits<FixedShapeTestMessage> {
+  static constexpr bool value = true;
+  static constexpr int field_count = 6;
+  static const FixedShapeField* fields() {
+    static constexpr FixedShapeField kFields[6] = {
+        {(1 << 3) | 0, offsetof(FixedShapeTestMessage, varint32), 1,
+         FixedShapeFieldType::kVarint32},
+        {(2 << 3) | 0, offsetof(FixedShapeTestMessage, varint_u64), 1,
+         FixedShapeFieldType::kVarintU64},
+        {(3 << 3) | 0, offsetof(FixedShapeTestMessage, zigzag32), 1,
+         FixedShapeFieldType::kZigZag32},
+        {(4 << 3) | 5, offsetof(FixedShapeTestMessage, float32), 1,
+         FixedShapeFieldType::kFixed32},
+        {(5 << 3) | 1, offsetof(FixedShapeTestMessage, double64), 1,
+         FixedShapeFieldType::kFixed64},
+        {(6 << 3) | 0, offsetof(FixedShapeTestMessage, flag), 1,
+         FixedShapeFieldType::kBool},
+    };
+    return kFields;
+  }
+};
+
+namespace {
+
+TEST(FixedShapeCodecTest, RoundTripsAllFieldTypes) {
+  FixedShapeTestMessage msg = {};
+  msg.varint32 = -101;  // Negative int32s take the full 10-byte varint.
+  msg.varint_u64 = uint64_t{1} << 60;
+  msg.zigzag32 = -12345;
+  msg.float32 = 1.5f;
+  msg.double64 = -2.25;
+  msg.flag = true;
+
+  std::string wire;
+  FixedShapeSerializeToString(msg, &wire);
+  EXPECT_EQ(wire.size(), FixedShapeByteSizeLong(msg));
+
+  FixedShapeTestMessage parsed = {};
+  ASSERT_TRUE(FixedShapeParseFromArray(wire.data(), wire.size(), &parsed));
+  EXPECT_EQ(parsed.varint32, msg.varint32);
+  EXPECT_EQ(parsed.varint_u64, msg.varint_u64);
+  EXPECT_EQ(parsed.zigzag32, msg.zigzag32);
+  EXPECT_EQ(parsed.float32, msg.float32);
+  EXPECT_EQ(parsed.double64, msg.double64);
+  EXPECT_EQ(parsed.flag, msg.flag);
+}
+
+TEST(FixedShapeCodecTest, MatchesWireFormatLiteEncoding) {
+  FixedShapeTestMessage msg = {};
+  msg.varint32 = 150;
+  msg.varint_u64 = 2;
+  msg.zigzag32 = -3;
+  msg.float32 = 1.5f;
+  msg.double64 = -2.25;
+  msg.flag = true;
+
+  uint8_t expected[64];
+  uint8_t* ptr = expected;
+  ptr = WireFormatLite::WriteInt32ToArray(1, msg.varint32, ptr);
+  ptr = WireFormatLite::WriteUInt64ToArray(2, msg.varint_u64, ptr);
+  ptr = WireFormatLite::WriteSInt32ToArray(3, msg.zigzag32, ptr);
+  ptr = WireFormatLite::WriteFloatToArray(4, msg.float32, ptr);
+  ptr = WireFormatLite::WriteDoubleToArray(5, msg.double64, ptr);
+  ptr = WireFormatLite::WriteBoolToArray(6, msg.flag, ptr);
+
+  std::string wire;
+  FixedShapeSerializeToString(msg, &wire);
+  EXPECT_EQ(wire, std::string(reinterpret_cast<char*>(expected),
+                              static_cast<size_t>(ptr - expected)));
+}
+
+TEST(FixedShapeCodecTest, WritesZeroValuedFields) {
+  // Unlike the canonical serializer, every field is encoded, so an all-zero
+  // message still round trips through the fixed-shape parser.
+  FixedShapeTestMessage msg = {};
+
+  std::string wire;
+  FixedShapeSerializeToString(msg, &wire);
+  // Six tags plus four one-byte varints, a fixed32 and a fixed64.
+  EXPECT_EQ(wire.size(), 6 + 4 + 4 + 8);
+
+  FixedShapeTestMessage parsed;
+  ASSERT_TRUE(FixedShapeParseFromArray(wire.data(), wire.size(), &parsed));
+  EXPECT_EQ(parsed.varint32, 0);
+  EXPECT_EQ(parsed.varint_u64, 0);
+  EXPECT_FALSE(parsed.flag);
+}
+
+TEST(FixedShapeCodecTest, RejectsInputsNotInFixedShape) {
+  FixedShapeTestMessage msg = {};
+  msg.varint32 = 1;
+  std::string wire;
+  FixedShapeSerializeToString(msg, &wire);
+
+  FixedShapeTestMessage parsed;
+  // Truncated input.
+  EXPECT_FALSE(FixedShapeParseFromArray(wire.data(), wire.size() - 1, &parsed));
+  // Trailing garbage.
+  std::string padded = wire + std::string(1, '\0');
+  EXPECT_FALSE(FixedShapeParseFromArray(padded.data(), padded.size(), &parsed));
+  // An unknown leading field, as the canonical parser would accept.
+  std::string unknown = std::string("\x38\x01", 2) + wire;
+  EXPECT_FALSE(
+      FixedShapeParseFromArray(unknown.data(), unknown.size(), &parsed));
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
@@ -28,6 +28,7 @@
 #include "absl/container/flat_hash_set.h"
 #include "absl/log/absl_check.h"
 #include "absl/log/absl_log.h"
+#include "absl/numeric/bits.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
@@ -318,14 +319,57 @@ Reflection::Reflection(const Descriptor* descriptor,
       descriptor_pool_(
           (pool == nullptr) ? DescriptorPool::internal_generated_pool() : pool),
       message_factory_(factory),
-      last_non_weak_field_index_(-1) {
+      last_non_weak_field_index_(-1),
+      has_dense_has_bits_(false) {
   last_non_weak_field_index_ = descriptor_->field_count() - 1;
+  if (schema_.HasHasbits() && descriptor_->field_count() > 0) {
+    bool dense = true;
+    for (int i = 0; dense && i < descriptor_->field_count(); ++i) {
+      const FieldDescriptor* field = descriptor_->field(i);
+      dense = !field->is_repeated() && !schema_.InRealOneof(field) &&
+              schema_.has_bit_indices_[i] == static_cast<uint32_t>(i);
+    }
+    has_dense_has_bits_ = dense;
+  }
 }
 
 Reflection::~Reflection() {
   // No need to use sized delete. This code path is uncommon and it would not be
   // worth saving or recalculating the size.
   ::operator delete(const_cast<internal::TcParseTableBase*>(tcparse_table_));
+  delete[] visit_plan_;
+}
+
+const Reflection::FieldVisitEntry* Reflection::GetVisitPlan(int* size) const {
+  absl::call_once(visit_plan_once_, [&] {
+    const int field_count = descriptor_->field_count();
+    FieldVisitEntry* plan = new FieldVisitEntry[field_count];
+    for (int i = 0; i < field_count; ++i) {
+      const FieldDescriptor* field = descriptor_->field(i);
+      FieldVisitEntry& entry = plan[i];
+      entry.field = field;
+      entry.number = static_cast<uint32_t>(field->number());
+      entry.has_bit_index = schema_.has_bit_indices_ != nullptr
+                                ? schema_.has_bit_indices_[i]
+                                : FieldVisitEntry::kNoHasbit;
+      entry.oneof_index = 0;
+      entry.type = static_cast<uint8_t>(field->type());
+      entry.cpp_type = static_cast<uint8_t>(field->cpp_type());
+      if (field->is_repeated()) {
+        entry.kind = FieldVisitEntry::kRepeated;
+      } else if (schema_.InRealOneof(field)) {
+        entry.kind = FieldVisitEntry::kOneof;
+        entry.oneof_index =
+            static_cast<uint16_t>(field->containing_oneof()->index());
+      } else {
+        entry.kind = FieldVisitEntry::kSingular;
+      }
+    }
+    visit_plan_size_ = field_count;
+    visit_plan_ = plan;
+  });
+  *size = visit_plan_size_;
+  return visit_plan_;
 }
 
 const UnknownFieldSet& Reflection::GetUnknownFields(
@@ -402,9 +446,9 @@ size_t Reflection::SpaceUsedLong(const Message& message) const {
 #undef HANDLE_TYPE
 
         case FieldDescriptor::CPPTYPE_STRING:
-          switch (field->options().ctype()) {
+          switch (field->cpp_string_type()) {
             default:  // TODO:  Support other string reps.
-            case FieldOptions::STRING:
+            case FieldDescriptor::CppStringType::kString:
               total_size +=
                   GetRaw<RepeatedPtrField<std::string> >(message, field)
                       .SpaceUsedExcludingSelfLong();
@@ -624,9 +668,9 @@ template <bool unsafe_shallow_swap>
 void SwapFieldHelper::SwapRepeatedStringField(const Reflection* r, Message* lhs,
                                               Message* rhs,
                                               const FieldDescriptor* field) {
-  switch (field->options().ctype()) {
+  switch (field->cpp_string_type()) {
     default:
-    case FieldOptions::STRING: {
+    case FieldDescriptor::CppStringType::kString: {
       auto* lhs_string = r->MutableRaw<RepeatedPtrFieldBase>(lhs, field);
       auto* rhs_string = r->MutableRaw<RepeatedPtrFieldBase>(rhs, field);
       if (unsafe_shallow_swap) {
@@ -1169,7 +1213,8 @@ void Reflection::SwapFieldsImpl(
         // may depend on the information in has bits.
         if (!field->is_repeated()) {
           SwapBit(message1, message2, field);
-          if (field->options().ctype() == FieldOptions::STRING &&
+          if (field->cpp_string_type() ==
+                  FieldDescriptor::CppStringType::kString &&
               IsInlined(field)) {
             ABSL_DCHECK(!unsafe_shallow_swap ||
                         message1->GetArena() == message2->GetArena());
@@ -1286,7 +1331,7 @@ void Reflection::InternalSwap(Message* lhs, Message* rhs) const {
       const FieldDescriptor* field = descriptor_->field(i);
       if (field->is_extension() || field->is_repeated() ||
           schema_.InRealOneof(field) ||
-          field->options().ctype() != FieldOptions::STRING ||
+          field->cpp_string_type() != FieldDescriptor::CppStringType::kString ||
           !IsInlined(field)) {
         continue;
       }
@@ -1453,9 +1498,9 @@ void Reflection::ClearField(Message* message,
 #undef HANDLE_TYPE
 
       case FieldDescriptor::CPPTYPE_STRING: {
-        switch (field->options().ctype()) {
+        switch (field->cpp_string_type()) {
           default:  // TODO:  Support other string reps.
-          case FieldOptions::STRING:
+          case FieldDescriptor::CppStringType::kString:
             MutableRaw<RepeatedPtrField<std::string> >(message, field)->Clear();
             break;
         }
@@ -1503,9 +1548,9 @@ void Reflection::RemoveLast(Message* message,
 #undef HANDLE_TYPE
 
       case FieldDescriptor::CPPTYPE_STRING:
-        switch (field->options().ctype()) {
+        switch (field->cpp_string_type()) {
           default:  // TODO:  Support other string reps.
-          case FieldOptions::STRING:
+          case FieldDescriptor::CppStringType::kString:
             MutableRaw<RepeatedPtrField<std::string> >(message, field)
                 ->RemoveLast();
             break;
@@ -1665,30 +1710,49 @@ void Reflection::ListFields(const Message& message,
     CheckInOrder(field, &last);
     output->push_back(field);
   };
-  for (int i = 0; i <= last_non_weak_field_index; i++) {
-    const FieldDescriptor* field = descriptor_->field(i);
-    if (field->is_repeated()) {
-      if (FieldSize(message, field) > 0) {
-        append_to_output(field);
+  if (has_dense_has_bits_ && has_bits != nullptr) {
+    // Every field's presence is exactly its own has-bit, so instead of
+    // testing each field we jump from set bit to set bit; empty words skip
+    // 32 fields in one comparison.  Fields come out in declaration order,
+    // which append_to_output already handles like the general loop below.
+    for (int word = 0; word * 32 <= last_non_weak_field_index; ++word) {
+      uint32_t bits = has_bits[word];
+      while (bits != 0) {
+        const int index = word * 32 + absl::countr_zero(bits);
+        bits &= bits - 1;
+        ABSL_DCHECK_LE(index, last_non_weak_field_index);
+        append_to_output(descriptor_->field(index));
       }
-    } else {
-      const OneofDescriptor* containing_oneof = field->containing_oneof();
-      if (schema_.InRealOneof(field)) {
-        const uint32_t* const oneof_case_array =
-            GetConstPointerAtOffset<uint32_t>(&message,
-                                              schema_.oneof_case_offset_);
-        // Equivalent to: HasOneofField(message, field)
-        if (static_cast<int64_t>(oneof_case_array[containing_oneof->index()]) ==
-            field->number()) {
+    }
+  } else {
+    for (int i = 0; i <= last_non_weak_field_index; i++) {
+      const FieldDescriptor* field = descriptor_->field(i);
+      if (field->is_repeated()) {
+        if (FieldSize(message, field) > 0) {
           append_to_output(field);
         }
-      } else if (has_bits && has_bits_indices[i] != static_cast<uint32_t>(-1)) {
-        // Equivalent to: HasBit(message, field)
-        if (IsIndexInHasBitSet(has_bits, has_bits_indices[i])) {
+      } else {
+        const OneofDescriptor* containing_oneof = field->containing_oneof();
+        if (schema_.InRealOneof(field)) {
+          const uint32_t* const oneof_case_array =
+              GetConstPointerAtOffset<uint32_t>(&message,
+                                                schema_.oneof_case_offset_);
+          // Equivalent to: HasOneofField(message, field)
+          if (static_cast<int64_t>(
+                  oneof_case_array[containing_oneof->index()]) ==
+              field->number()) {
+            append_to_output(field);
+          }
+        } else if (has_bits &&
+                   has_bits_indices[i] != static_cast<uint32_t>(-1)) {
+          // Equivalent to: HasBit(message, field)
+          if (IsIndexInHasBitSet(has_bits, has_bits_indices[i])) {
+            append_to_output(field);
+          }
+        } else if (HasBit(message, field)) {
+          // Fall back on proto3-style HasBit.
           append_to_output(field);
         }
-      } else if (HasBit(message, field)) {  // Fall back on proto3-style HasBit.
-        append_to_output(field);
       }
     }
   }
@@ -2025,9 +2089,9 @@ std::string Reflection::GetRepeatedString(const Message& message,
   if (field->is_extension()) {
     return GetExtensionSet(message).GetRepeatedString(field->number(), index);
   } else {
-    switch (field->options().ctype()) {
+    switch (field->cpp_string_type()) {
       default:  // TODO:  Support other string reps.
-      case FieldOptions::STRING:
+      case FieldDescriptor::CppStringType::kString:
         return GetRepeatedPtrField<std::string>(message, field, index);
     }
   }
@@ -2041,9 +2105,9 @@ const std::string& Reflection::GetRepeatedStringReference(
   if (field->is_extension()) {
     return GetExtensionSet(message).GetRepeatedString(field->number(), index);
   } else {
-    switch (field->options().ctype()) {
+    switch (field->cpp_string_type()) {
       default:  // TODO:  Support other string reps.
-      case FieldOptions::STRING:
+      case FieldDescriptor::CppStringType::kString:
         return GetRepeatedPtrField<std::string>(message, field, index);
     }
   }
@@ -2076,9 +2140,9 @@ void Reflection::SetRepeatedString(Message* message,
     MutableExtensionSet(message)->SetRepeatedString(field->number(), index,
                                                     std::move(value));
   } else {
-    switch (field->options().ctype()) {
+    switch (field->cpp_string_type()) {
       default:  // TODO:  Support other string reps.
-      case FieldOptions::STRING:
+      case FieldDescriptor::CppStringType::kString:
         MutableRepeatedField<std::string>(message, field, index)
             ->assign(std::move(value));
         break;
@@ -2094,9 +2158,9 @@ void Reflection::AddString(Message* message, const FieldDescriptor* field,
     MutableExtensionSet(message)->AddString(field->number(), field->type(),
                                             std::move(value), field);
   } else {
-    switch (field->options().ctype()) {
+    switch (field->cpp_string_type()) {
       default:  // TODO:  Support other string reps.
-      case FieldOptions::STRING:
+      case FieldDescriptor::CppStringType::kString:
         AddField<std::string>(message, field)->assign(std::move(value));
         break;
     }
@@ -2265,11 +2329,16 @@ const Message* Reflection::GetDefaultMessageInstance(
   // to get the default of submessages.
   if (message_factory_ == MessageFactory::generated_factory()) {
     auto& ptr = field->default_generated_instance_;
-    auto* res = ptr.load(std::memory_order_acquire);
+    // Relaxed is enough here: the cached pointer is the only shared state,
+    // and it always refers to a constant-initialized generated default
+    // instance whose bytes need no release/acquire publication.  On the hot
+    // path this keeps the unset-field getter down to a plain load of the
+    // cached address.
+    auto* res = ptr.load(std::memory_order_relaxed);
     if (res == nullptr) {
       // First time asking for this field's default. Load it and cache it.
       res = message_factory_->GetPrototype(field->message_type());
-      ptr.store(res, std::memory_order_release);
+      ptr.store(res, std::memory_order_relaxed);
     }
     return res;
   }
@@ -3095,6 +3164,43 @@ HANDLE_TYPE(double, FieldDescriptor::CPPTYPE_DOUBLE, -1);
 HANDLE_TYPE(bool, FieldDescriptor::CPPTYPE_BOOL, -1);
 
 
+#undef HANDLE_TYPE
+
+template <typename T>
+void Reflection::SetRepeatedSpan(Message* message,
+                                 const FieldDescriptor* field,
+                                 absl::Span<const T> values) const {
+  // MutableRepeatedFieldInternal() performs the usage checks and resolves
+  // the field (including extensions) once; the copy itself is a single
+  // bulk write into the RepeatedField.
+  MutableRepeatedFieldInternal<T>(message, field)
+      ->Assign(values.begin(), values.end());
+}
+
+template <typename T>
+void Reflection::AddRepeatedSpan(Message* message,
+                                 const FieldDescriptor* field,
+                                 absl::Span<const T> values) const {
+  MutableRepeatedFieldInternal<T>(message, field)
+      ->Add(values.begin(), values.end());
+}
+
+#define HANDLE_TYPE(TYPE)                                             \
+  template void Reflection::SetRepeatedSpan<TYPE>(                    \
+      Message * message, const FieldDescriptor* field,                \
+      absl::Span<const TYPE> values) const;                           \
+  template void Reflection::AddRepeatedSpan<TYPE>(                    \
+      Message * message, const FieldDescriptor* field,                \
+      absl::Span<const TYPE> values) const;
+
+HANDLE_TYPE(int32_t)
+HANDLE_TYPE(int64_t)
+HANDLE_TYPE(uint32_t)
+HANDLE_TYPE(uint64_t)
+HANDLE_TYPE(float)
+HANDLE_TYPE(double)
+HANDLE_TYPE(bool)
+
 #undef HANDLE_TYPE
 
 const void* Reflection::GetRawRepeatedString(const Message& message,
@@ -3403,8 +3509,12 @@ const internal::TcParseTableBase* Reflection::CreateTcParseTable() const {
         is_inlined,
         // Only LITE can be implicitly weak.
         /* is_implicitly_weak */ false,
-        // We could change this to use direct table.
-        // Might be easier to do when all messages support TDP.
+        // Generated code links child tables directly: aux entries hold
+        // constexpr TcParser::GetTable<T>() pointers resolved at link time.
+        // Here tables are built lazily per message, so resolving a child's
+        // table eagerly would re-enter table creation for cyclic message
+        // types.  Until tables can be registered before they are filled in,
+        // submessages are reached through the default instance instead.
         /* use_direct_tcparser_table */ false,
         schema_.IsSplit(field),
         is_inlined ? static_cast<int>(schema_.InlinedStringIndex(field))
@@ -33,6 +33,7 @@
 #include "absl/strings/string_view.h"
 #include "google/protobuf/arena.h"
 #include "google/protobuf/descriptor.h"
+#include "google/protobuf/dynamic_message.h"
 #include "google/protobuf/map_test_util.h"
 #include "google/protobuf/map_unittest.pb.h"
 #include "google/protobuf/message.h"
@@ -447,6 +448,30 @@ TEST_P(GeneratedMessageReflectionSwapTest, SwapFieldsAll) {
   TestUtil::ExpectClear(*rhs);
 }
 
+TEST(GeneratedMessageReflectionTest, ListFieldsDenseHasBits) {
+  // DynamicMessage assigns has-bits in declaration order, so a message with
+  // only singular fields exercises the word-at-a-time ListFields fast path.
+  DynamicMessageFactory factory;
+  std::unique_ptr<Message> message(
+      factory.GetPrototype(unittest::TestRequired::descriptor())->New());
+  const Reflection* reflection = message->GetReflection();
+  const Descriptor* descriptor = message->GetDescriptor();
+  reflection->SetInt32(message.get(), descriptor->FindFieldByName("c"), 3);
+  reflection->SetInt32(message.get(), descriptor->FindFieldByName("a"), 1);
+  reflection->SetInt32(message.get(), descriptor->FindFieldByName("dummy10"),
+                       10);
+  reflection->SetInt32(message.get(), descriptor->FindFieldByName("dummy32"),
+                       32);
+
+  std::vector<const FieldDescriptor*> fields;
+  reflection->ListFields(*message, &fields);
+  ASSERT_EQ(fields.size(), 4);
+  EXPECT_EQ(fields[0]->name(), "a");
+  EXPECT_EQ(fields[1]->name(), "dummy10");
+  EXPECT_EQ(fields[2]->name(), "dummy32");
+  EXPECT_EQ(fields[3]->name(), "c");
+}
+
 TEST(GeneratedMessageReflectionTest, SwapFieldsAllOnDifferentArena) {
   Arena arena1, arena2;
   auto* message1 = Arena::Create<unittest::TestAllTypes>(&arena1);
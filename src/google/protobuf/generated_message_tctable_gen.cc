@@ -44,6 +44,25 @@ bool TreatEnumAsInt(const FieldDescriptor* field) {
           field->containing_type()->map_value() == field);
 }
 
+// Whether two map fields produce byte-identical aux entries. The MapAuxInfo
+// is a constexpr function of the key/value types and the UTF-8 handling of
+// the field, and the optional second entry depends only on the mapped message
+// or closed enum type, so same-shape map fields can share one run of aux
+// entries instead of carrying a copy each.
+bool SameMapAuxShape(const FieldDescriptor* a, const FieldDescriptor* b,
+                     bool is_lite) {
+  const FieldDescriptor* a_value = a->message_type()->map_value();
+  const FieldDescriptor* b_value = b->message_type()->map_value();
+  return a->message_type()->map_key()->type() ==
+             b->message_type()->map_key()->type() &&
+         a_value->type() == b_value->type() &&
+         a_value->message_type() == b_value->message_type() &&
+         a_value->enum_type() == b_value->enum_type() &&
+         cpp::HasPreservingUnknownEnumSemantics(a_value) ==
+             cpp::HasPreservingUnknownEnumSemantics(b_value) &&
+         cpp::GetUtf8CheckMode(a, is_lite) == cpp::GetUtf8CheckMode(b, is_lite);
+}
+
 bool GetEnumValidationRange(const EnumDescriptor* enum_type, int16_t& start,
                             uint16_t& size) {
   ABSL_CHECK_GT(enum_type->value_count(), 0) << enum_type->DebugString();
@@ -521,16 +540,16 @@ TailCallTableInfo::NumToEntryTable MakeNumToEntryTable(
     if (start_new_block == false) {
       // If the next field number is within 15 of the last_skip_entry_start, we
       // continue writing just to that entry.  If it's between 16 and 31 more,
-      // then we just extend the current block by one. If it's more than 31
-      // more, we have to add empty skip entries in order to continue using the
-      // existing block.  Obviously it's just 32 more, it doesn't make sense to
-      // start a whole new block, since new blocks mean having to write out
-      // their starting field number, which is 32 bits, as well as the size of
-      // the additional block, which is 16... while an empty SkipEntry16 only
-      // costs 32 bits.  So if it was 48 more, it's a slight space win; we save
-      // 16 bits, but probably at the cost of slower run time.  We're choosing
-      // 96 for now.
-      if (fnum - last_skip_entry_start > 96) start_new_block = true;
+      // then we just extend the current block by one. If it's further away, we
+      // can either pad the current block with empty skip entries (4 bytes
+      // each) or start a new block, which costs 6 bytes of header and, more
+      // importantly, an extra dependent load and branch in FindFieldEntry
+      // every time a field in a later block misses the fast table.  We bias
+      // towards fewer blocks so that the slow-path lookup for high field
+      // numbers normally indexes into a single block: gaps of up to 256
+      // numbers (15 empty skip entries, 60 bytes) are absorbed into the
+      // current block.
+      if (fnum - last_skip_entry_start > 256) start_new_block = true;
     }
     if (start_new_block) {
       num_to_entry_table.blocks.push_back({fnum});
@@ -835,6 +854,10 @@ TailCallTableInfo::TailCallTableInfo(
   size_t subtable_aux_idx = aux_entries.size();
   aux_entries.resize(aux_entries.size() + num_non_cold_subtables);
 
+  // Map fields of the same shape share one run of aux entries; the first
+  // field of each shape registers its index here.
+  std::vector<std::pair<const FieldDescriptor*, uint16_t>> map_aux_by_shape;
+
   // Fill in mini table entries.
   for (const auto& options : ordered_fields) {
     auto* field = options.field;
@@ -847,17 +870,28 @@ TailCallTableInfo::TailCallTableInfo(
         field->type() == FieldDescriptor::TYPE_GROUP) {
       // Message-typed fields have a FieldAux with the default instance pointer.
       if (field->is_map()) {
-        entry.aux_idx = aux_entries.size();
-        aux_entries.push_back({kMapAuxInfo, {field}});
-        if (message_options.uses_codegen) {
-          // If we don't use codegen we can't add these.
-          auto* map_value = field->message_type()->map_value();
-          if (auto* sub = map_value->message_type()) {
-            aux_entries.push_back({kCreateInArena});
-            aux_entries.back().desc = sub;
-          } else if (map_value->type() == FieldDescriptor::TYPE_ENUM &&
-                     !cpp::HasPreservingUnknownEnumSemantics(map_value)) {
-            aux_entries.push_back({kEnumValidator, {map_value}});
+        const auto it = std::find_if(
+            map_aux_by_shape.begin(), map_aux_by_shape.end(),
+            [&](const auto& prior) {
+              return SameMapAuxShape(prior.first, field,
+                                     message_options.is_lite);
+            });
+        if (it != map_aux_by_shape.end()) {
+          entry.aux_idx = it->second;
+        } else {
+          entry.aux_idx = aux_entries.size();
+          map_aux_by_shape.emplace_back(field, entry.aux_idx);
+          aux_entries.push_back({kMapAuxInfo, {field}});
+          if (message_options.uses_codegen) {
+            // If we don't use codegen we can't add these.
+            auto* map_value = field->message_type()->map_value();
+            if (auto* sub = map_value->message_type()) {
+              aux_entries.push_back({kCreateInArena});
+              aux_entries.back().desc = sub;
+            } else if (map_value->type() == FieldDescriptor::TYPE_ENUM &&
+                       !cpp::HasPreservingUnknownEnumSemantics(map_value)) {
+              aux_entries.push_back({kEnumValidator, {map_value}});
+            }
           }
         }
       } else if (field->options().weak()) {
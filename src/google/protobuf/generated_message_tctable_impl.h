@@ -432,6 +432,18 @@ class PROTOBUF_EXPORT TcParser final {
                                ParseContext* ctx,
                                const TcParseTableBase* table);
 
+  // Table-driven implementations of the field-handling bodies of generated
+  // Clear() and MergeFrom().  Both walk the MiniParse field entries, so they
+  // require every field to be representable there and additionally exclude
+  // oneofs, maps, split, weak, lazy and non-default string representations;
+  // generated code only calls them for messages where all fields qualify.
+  // Unknown fields, extensions and cached sizes remain the generated
+  // methods' responsibility.
+  static void ClearMessageFields(MessageLite* msg,
+                                 const TcParseTableBase* table);
+  static void MergeMessageFields(const MessageLite& from, MessageLite* to,
+                                 const TcParseTableBase* table);
+
   // Functions referenced by generated fast tables (numeric types):
   //   F: fixed      V: varint     Z: zigzag
   //   8/32/64: storage type width (bits)
@@ -902,6 +914,10 @@ class PROTOBUF_EXPORT TcParser final {
   static absl::string_view MessageName(const TcParseTableBase* table);
   static absl::string_view FieldName(const TcParseTableBase* table,
                                      const TcParseTableBase::FieldEntry*);
+  // Inverse of FindFieldEntry: recovers the field number of an entry from the
+  // table's lookup structures.  The entry must belong to `table`.
+  static uint32_t FieldNumber(const TcParseTableBase* table,
+                              const TcParseTableBase::FieldEntry*);
   static bool ChangeOneof(const TcParseTableBase* table,
                           const TcParseTableBase::FieldEntry& entry,
                           uint32_t field_num, ParseContext* ctx,
@@ -910,7 +926,7 @@ class PROTOBUF_EXPORT TcParser final {
   // UTF-8 validation:
   static void ReportFastUtf8Error(uint32_t decoded_tag,
                                   const TcParseTableBase* table);
-  static bool MpVerifyUtf8(absl::string_view wire_bytes,
+  static bool MpVerifyUtf8(ParseContext* ctx, const std::string& wire_bytes,
                            const TcParseTableBase* table,
                            const TcParseTableBase::FieldEntry& entry,
                            uint16_t xform_val);
@@ -923,6 +939,8 @@ class PROTOBUF_EXPORT TcParser final {
   friend class FindFieldEntryTest;
   friend struct ParseFunctionGeneratorTestPeer;
   friend struct FuzzPeer;
+  // Validate-only wire format walk; see wire_format_validate.h.
+  friend class WireFormatVerifier;
   static constexpr const uint32_t kMtSmallScanSize = 4;
 
   // Mini parsing:
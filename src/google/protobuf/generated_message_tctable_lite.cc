@@ -15,6 +15,7 @@
 #include <utility>
 
 #include "absl/base/optimization.h"
+#include "absl/container/inlined_vector.h"
 #include "absl/log/absl_check.h"
 #include "absl/log/absl_log.h"
 #include "absl/numeric/bits.h"
@@ -216,6 +217,46 @@ absl::string_view TcParser::FieldName(const TcParseTableBase* table,
                   field_index + 1);
 }
 
+uint32_t TcParser::FieldNumber(const TcParseTableBase* table,
+                               const FieldEntry* field_entry) {
+  // The data structures in the table map a field number to its entry
+  // (FindFieldEntry, above); walk them in the same order to invert that
+  // mapping.
+  const auto target =
+      static_cast<uint32_t>(field_entry - table->field_entries_begin());
+  {
+    const uint32_t skipmap = table->skipmap32;
+    uint32_t entry_index = 0;
+    for (uint32_t adj_fnum = 0; adj_fnum < 32; ++adj_fnum) {
+      if (skipmap & (uint32_t{1} << adj_fnum)) continue;
+      if (entry_index++ == target) return adj_fnum + 1;
+    }
+  }
+  const uint16_t* lookup_table = table->field_lookup_begin();
+  for (;;) {
+    uint32_t fstart;
+#ifdef ABSL_IS_LITTLE_ENDIAN
+    memcpy(&fstart, lookup_table, sizeof(fstart));
+#else
+    fstart = lookup_table[0] | (lookup_table[1] << 16);
+#endif
+    // The entry is required to belong to the table, so we must find its
+    // number before hitting the terminator.
+    ABSL_DCHECK_NE(fstart, ~uint32_t{0});
+    lookup_table += sizeof(fstart) / sizeof(*lookup_table);
+    const uint32_t num_skip_entries = *lookup_table++;
+    for (uint32_t group = 0; group < num_skip_entries; ++group) {
+      const SkipEntry16 se = {lookup_table[0], lookup_table[1]};
+      lookup_table += sizeof(SkipEntry16) / sizeof(*lookup_table);
+      uint32_t entry_index = se.field_entry_offset;
+      for (uint32_t bit = 0; bit < 16; ++bit) {
+        if (se.skipmap & (uint16_t{1} << bit)) continue;
+        if (entry_index++ == target) return fstart + group * 16 + bit;
+      }
+    }
+  }
+}
+
 PROTOBUF_NOINLINE const char* TcParser::Error(PROTOBUF_TC_PARAM_NO_DATA_DECL) {
   (void)ctx;
   (void)ptr;
@@ -713,6 +754,21 @@ inline int64_t ZigZagDecodeHelper<int64_t, true>(int64_t value) {
   return WireFormatLite::ZigZagDecode64(value);
 }
 
+// Batch counterpart used by the packed paths; a no-op unless the field is
+// actually a sint field, so the dead branch compiles for every FieldType.
+template <typename FieldType, bool zigzag = false>
+inline void ZigZagDecodeArrayHelper(FieldType* values, int n) {}
+
+template <>
+inline void ZigZagDecodeArrayHelper<int32_t, true>(int32_t* values, int n) {
+  WireFormatLite::ZigZagDecodeArray(values, n);
+}
+
+template <>
+inline void ZigZagDecodeArrayHelper<int64_t, true>(int64_t* values, int n) {
+  WireFormatLite::ZigZagDecodeArray(values, n);
+}
+
 // Prefetch the enum data, if necessary.
 // We can issue the prefetch before we start parsing the ints.
 PROTOBUF_ALWAYS_INLINE void PrefetchEnumData(uint16_t xform_val,
@@ -962,19 +1018,20 @@ PROTOBUF_ALWAYS_INLINE const char* TcParser::PackedVarint(
   // pending hasbits now:
   SyncHasbits(msg, hasbits, table);
   auto* field = &RefAt<RepeatedField<FieldType>>(msg, data.offset());
-  return ctx->ReadPackedVarint(ptr, [field](uint64_t varint) {
-    FieldType val;
-    if (zigzag) {
-      if (sizeof(FieldType) == 8) {
-        val = WireFormatLite::ZigZagDecode64(varint);
-      } else {
-        val = WireFormatLite::ZigZagDecode32(varint);
-      }
-    } else {
-      val = varint;
-    }
-    field->Add(val);
+  // For sint fields, append the raw varint bit patterns and zigzag-decode
+  // them in a second pass over the new elements: the decode loop stays a
+  // pure varint loop, and the shift/xor transform runs as one vectorizable
+  // sweep instead of being interleaved per value.  On a parse failure the
+  // untransformed tail is left behind, but the failure discards the message.
+  const int old_size = field->size();
+  ptr = ctx->ReadPackedVarint(ptr, [field](uint64_t varint) {
+    field->Add(static_cast<FieldType>(varint));
   });
+  if (zigzag && ptr != nullptr) {
+    ZigZagDecodeArrayHelper<FieldType, zigzag>(field->mutable_data() + old_size,
+                                               field->size() - old_size);
+  }
+  return ptr;
 }
 
 PROTOBUF_NOINLINE const char* TcParser::FastV8P1(PROTOBUF_TC_PARAM_DECL) {
@@ -1161,13 +1218,27 @@ PROTOBUF_ALWAYS_INLINE const char* TcParser::PackedEnum(
   auto* field = &RefAt<RepeatedField<int32_t>>(msg, data.offset());
   const TcParseTableBase::FieldAux aux = *table->field_aux(data.aux_idx());
   PrefetchEnumData(xform_val, aux);
-  return ctx->ReadPackedVarint(ptr, [=](int32_t value) {
-    if (!EnumIsValidAux(value, xform_val, aux)) {
-      AddUnknownEnum(msg, table, FastDecodeTag(saved_tag), value);
-    } else {
-      field->Add(value);
-    }
-  });
+  return ctx->ReadPackedVarint(
+      ptr,
+      [=](int32_t value) {
+        if (!EnumIsValidAux(value, xform_val, aux)) {
+          AddUnknownEnum(msg, table, FastDecodeTag(saved_tag), value);
+        } else {
+          field->Add(value);
+        }
+      },
+      /*size_callback=*/
+      [=](int32_t size_bytes) {
+        // Optimistically assume one byte per value, as in
+        // PackedEnumSmallRange, so long arrays are validated and appended
+        // without growing the field mid-loop. The reserve is capped by the
+        // remaining input so corrupt sizes cannot cause giant allocations.
+        int64_t new_size =
+            int64_t{field->size()} +
+            std::min(size_bytes, std::max(1024, ctx->MaximumReadSize(ptr)));
+        field->Reserve(static_cast<int32_t>(
+            std::min(new_size, int64_t{std::numeric_limits<int32_t>::max()})));
+      });
 }
 
 PROTOBUF_NOINLINE const char* TcParser::FastErR1(PROTOBUF_TC_PARAM_DECL) {
@@ -1426,6 +1497,14 @@ PROTOBUF_ALWAYS_INLINE const char* TcParser::SingularString(
 #endif
       break;
     default:
+      // Deferred mode records the field storage and validates after the
+      // parse loop.  Pointers stay valid even if the field is parsed again
+      // (last-wins reuses the same std::string object).
+      if (utf8 == kUtf8 &&
+          PROTOBUF_PREDICT_FALSE(ctx->deferred_utf8() != nullptr)) {
+        ctx->deferred_utf8()->push_back(&field.Get());
+        break;
+      }
       if (PROTOBUF_PREDICT_TRUE(IsValidUTF8(field))) {
         break;
       }
@@ -1516,7 +1595,7 @@ PROTOBUF_ALWAYS_INLINE const char* TcParser::RepeatedString(
   const auto expected_tag = UnalignedLoad<TagType>(ptr);
   auto& field = RefAt<FieldType>(msg, data.offset());
 
-  const auto validate_last_string = [expected_tag, table, &field] {
+  const auto validate_last_string = [expected_tag, table, ctx, &field] {
     switch (utf8) {
       case kNoUtf8:
 #ifdef NDEBUG
@@ -1524,6 +1603,13 @@ PROTOBUF_ALWAYS_INLINE const char* TcParser::RepeatedString(
 #endif
         return true;
       default:
+        // Deferred mode records the element and validates after the parse
+        // loop; element addresses are stable across repeated field growth.
+        if (utf8 == kUtf8 &&
+            PROTOBUF_PREDICT_FALSE(ctx->deferred_utf8() != nullptr)) {
+          ctx->deferred_utf8()->push_back(&field[field.size() - 1]);
+          return true;
+        }
         if (PROTOBUF_PREDICT_TRUE(
                 utf8_range::IsStructurallyValid(field[field.size() - 1]))) {
           return true;
@@ -2027,13 +2113,25 @@ const char* TcParser::MpPackedVarintT(PROTOBUF_TC_PARAM_DECL) {
       }
     });
   } else {
-    return ctx->ReadPackedVarint(ptr, [=](uint64_t value) {
-      field->Add(is_zigzag ? (sizeof(FieldType) == 8
-                                  ? WireFormatLite::ZigZagDecode64(value)
-                                  : WireFormatLite::ZigZagDecode32(
-                                        static_cast<uint32_t>(value)))
-                           : value);
+    // Same second-pass scheme as TcParser::PackedVarint: append the raw
+    // varint bit patterns, then zigzag-decode the new elements in one
+    // vectorizable sweep.  is_zigzag is only ever set for 32- and 64-bit
+    // sint fields, so the casts below never see bool storage.
+    const int old_size = field->size();
+    ptr = ctx->ReadPackedVarint(ptr, [=](uint64_t value) {
+      field->Add(static_cast<FieldType>(value));
     });
+    if (is_zigzag && ptr != nullptr) {
+      const int n = field->size() - old_size;
+      if (sizeof(FieldType) == 8) {
+        WireFormatLite::ZigZagDecodeArray(
+            reinterpret_cast<int64_t*>(field->mutable_data() + old_size), n);
+      } else {
+        WireFormatLite::ZigZagDecodeArray(
+            reinterpret_cast<int32_t*>(field->mutable_data() + old_size), n);
+      }
+    }
+    return ptr;
   }
 }
 
@@ -2099,10 +2197,16 @@ PROTOBUF_NOINLINE const char* TcParser::MpPackedVarint(PROTOBUF_TC_PARAM_DECL) {
   }
 }
 
-bool TcParser::MpVerifyUtf8(absl::string_view wire_bytes,
+bool TcParser::MpVerifyUtf8(ParseContext* ctx, const std::string& wire_bytes,
                             const TcParseTableBase* table,
                             const FieldEntry& entry, uint16_t xform_val) {
   if (xform_val == field_layout::kTvUtf8) {
+    // Deferred mode records the field storage and validates after the parse
+    // loop.
+    if (PROTOBUF_PREDICT_FALSE(ctx->deferred_utf8() != nullptr)) {
+      ctx->deferred_utf8()->push_back(&wire_bytes);
+      return true;
+    }
     if (!utf8_range::IsStructurallyValid(wire_bytes)) {
       PrintUTF8ErrorLog(MessageName(table), FieldName(table, &entry), "parsing",
                         false);
@@ -2169,7 +2273,7 @@ PROTOBUF_NOINLINE const char* TcParser::MpString(PROTOBUF_TC_PARAM_DECL) {
         ptr = InlineGreedyStringParser(str, ptr, ctx);
       }
       if (!ptr) break;
-      is_valid = MpVerifyUtf8(field.Get(), table, entry, xform_val);
+      is_valid = MpVerifyUtf8(ctx, field.Get(), table, entry, xform_val);
       break;
     }
 
@@ -2246,9 +2350,10 @@ PROTOBUF_NOINLINE const char* TcParser::MpRepeatedString(
         do {
           ptr = ptr2;
           ptr = ParseRepeatedStringOnce(ptr, serial_arena, ctx, field);
-          if (PROTOBUF_PREDICT_FALSE(ptr == nullptr ||
-                                     !MpVerifyUtf8(field[field.size() - 1],
-                                                   table, entry, xform_val))) {
+          if (PROTOBUF_PREDICT_FALSE(
+                  ptr == nullptr ||
+                  !MpVerifyUtf8(ctx, field[field.size() - 1], table, entry,
+                                xform_val))) {
             PROTOBUF_MUSTTAIL return Error(PROTOBUF_TC_PARAM_NO_DATA_PASS);
           }
           if (PROTOBUF_PREDICT_FALSE(!ctx->DataAvailable(ptr))) goto parse_loop;
@@ -2261,7 +2366,7 @@ PROTOBUF_NOINLINE const char* TcParser::MpRepeatedString(
           ptr = InlineGreedyStringParser(str, ptr, ctx);
           if (PROTOBUF_PREDICT_FALSE(
                   ptr == nullptr ||
-                  !MpVerifyUtf8(*str, table, entry, xform_val))) {
+                  !MpVerifyUtf8(ctx, *str, table, entry, xform_val))) {
             PROTOBUF_MUSTTAIL return Error(PROTOBUF_TC_PARAM_NO_DATA_PASS);
           }
           if (PROTOBUF_PREDICT_FALSE(!ctx->DataAvailable(ptr))) goto parse_loop;
@@ -2711,8 +2816,43 @@ PROTOBUF_NOINLINE const char* TcParser::MpMap(PROTOBUF_TC_PARAM_DECL) {
 
   const uint32_t saved_tag = data.tag();
 
+  // Consecutive entries of the same map field are the common case, so batch
+  // the node allocations: carve slabs holding several nodes out of a single
+  // arena block instead of paying one arena allocation (plus its alignment
+  // round-up) per entry. Heap maps keep per-node allocation because their
+  // nodes are deallocated individually. Slabs are bounded by how many
+  // entries the remaining input could possibly hold (an entry takes at least
+  // one tag byte and one length byte on the wire), so a short run cannot
+  // strand much arena memory; slab size grows geometrically across a run.
+  constexpr int kMinEntryWireSize = 2;
+  constexpr int kMaxSlabNodes = 32;
+  const size_t node_size = SizeFromInfo(map_info.node_size_info);
+  Arena* const map_arena = map.arena();
+  char* slab = nullptr;
+  int slab_nodes = 0;
+  int next_slab_nodes = 4;
+
+  const auto alloc_node = [&]() -> NodeBase* {
+    if (map_arena == nullptr) {
+      return map.AllocNode(map_info.node_size_info);
+    }
+    if (PROTOBUF_PREDICT_FALSE(slab_nodes == 0)) {
+      const int upper_bound =
+          1 + std::max(0, ctx->BytesUntilLimit(ptr)) / kMinEntryWireSize;
+      const int count = std::min(next_slab_nodes, upper_bound);
+      if (count <= 1) return map.AllocNode(map_info.node_size_info);
+      slab = Arena::CreateArray<char>(map_arena, count * node_size);
+      slab_nodes = count;
+      next_slab_nodes = std::min(next_slab_nodes * 2, kMaxSlabNodes);
+    }
+    NodeBase* node = reinterpret_cast<NodeBase*>(slab);
+    slab += node_size;
+    --slab_nodes;
+    return node;
+  };
+
   while (true) {
-    NodeBase* node = map.AllocNode(map_info.node_size_info);
+    NodeBase* node = alloc_node();
 
     InitializeMapNodeEntry(node->GetVoidKey(), map_info.key_type_card, map, aux,
                            true);
@@ -2929,6 +3069,218 @@ const char* TcParser::DiscardEverythingFallback(PROTOBUF_TC_PARAM_DECL) {
   return UnknownFieldParse(tag, nullptr, ptr, ctx);
 }
 
+//////////////////////////////////////////////////////////////////////////////
+// Table-driven Clear and MergeFrom
+//////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Byte width of the in-memory representation of a numeric field.
+inline uint32_t NumericRepWidth(uint16_t type_card) {
+  switch (type_card & field_layout::kRepMask) {
+    case field_layout::kRep8Bits:
+      return 1;
+    case field_layout::kRep32Bits:
+      return 4;
+    default:
+      return 8;
+  }
+}
+
+inline bool IsHasBitSet(const MessageLite& msg, uint32_t has_idx) {
+  return (TcParser::RefAt<uint32_t>(&msg, has_idx / 32 * 4) >> (has_idx % 32)) &
+         1;
+}
+
+}  // namespace
+
+void TcParser::ClearMessageFields(MessageLite* msg,
+                                  const TcParseTableBase* table) {
+  namespace fl = field_layout;
+  // Byte ranges to be zeroed: numeric fields plus the has-bit words they
+  // reference.  They are coalesced below so that contiguous trivial regions
+  // of the message (the common layout) collapse into a few memset calls.
+  absl::InlinedVector<std::pair<uint32_t, uint32_t>, 32> zero_runs;
+  for (const FieldEntry& entry : table->field_entries()) {
+    const uint16_t type_card = entry.type_card;
+    ABSL_DCHECK_EQ(type_card & fl::kSplitMask, 0);
+    const uint16_t card = type_card & fl::kFcMask;
+    ABSL_DCHECK_NE(card, fl::kFcOneof);
+    const uint16_t kind = type_card & fl::kFkMask;
+    if (card == fl::kFcRepeated) {
+      switch (kind) {
+        case fl::kFkString:
+          RefAt<RepeatedPtrFieldBase>(msg, entry.offset)
+              .Clear<GenericTypeHandler<std::string>>();
+          break;
+        case fl::kFkMessage:
+          RefAt<RepeatedPtrFieldBase>(msg, entry.offset)
+              .Clear<GenericTypeHandler<MessageLite>>();
+          break;
+        default:
+          ABSL_DCHECK(kind == fl::kFkVarint || kind == fl::kFkFixed ||
+                      kind == fl::kFkPackedVarint || kind == fl::kFkPackedFixed);
+          // Clearing a RepeatedField only resets its size, so as in MiniParse
+          // the unsigned type of the right width stands in for all element
+          // types of that width.
+          switch (type_card & fl::kRepMask) {
+            case fl::kRep8Bits:
+              RefAt<RepeatedField<bool>>(msg, entry.offset).Clear();
+              break;
+            case fl::kRep32Bits:
+              RefAt<RepeatedField<uint32_t>>(msg, entry.offset).Clear();
+              break;
+            default:
+              RefAt<RepeatedField<uint64_t>>(msg, entry.offset).Clear();
+              break;
+          }
+          break;
+      }
+      continue;
+    }
+    if (card == fl::kFcOptional) {
+      // Queue the whole has-bit word; duplicates from fields sharing a word
+      // collapse in the coalescing step.
+      const uint32_t word = static_cast<uint32_t>(entry.has_idx) / 32 * 4;
+      zero_runs.push_back({word, word + 4});
+    }
+    switch (kind) {
+      case fl::kFkString:
+        ABSL_DCHECK_EQ(type_card & fl::kRepMask, fl::kRepAString);
+        RefAt<ArenaStringPtr>(msg, entry.offset).ClearToEmpty();
+        break;
+      case fl::kFkMessage: {
+        ABSL_DCHECK_NE(type_card & fl::kRepMask, fl::kRepLazy);
+        // A clear has-bit means the retained submessage is already default.
+        if (card == fl::kFcOptional &&
+            !IsHasBitSet(*msg, static_cast<uint32_t>(entry.has_idx))) {
+          break;
+        }
+        MessageLite* field = RefAt<MessageLite*>(msg, entry.offset);
+        if (field != nullptr) field->Clear();
+        break;
+      }
+      default:
+        ABSL_DCHECK(kind == fl::kFkVarint || kind == fl::kFkFixed);
+        zero_runs.push_back(
+            {entry.offset, entry.offset + NumericRepWidth(type_card)});
+        break;
+    }
+  }
+  if (zero_runs.empty()) return;
+  std::sort(zero_runs.begin(), zero_runs.end());
+  char* base = reinterpret_cast<char*>(msg);
+  uint32_t begin = zero_runs[0].first;
+  uint32_t end = zero_runs[0].second;
+  for (size_t i = 1; i < zero_runs.size(); ++i) {
+    if (zero_runs[i].first > end) {
+      memset(base + begin, 0, end - begin);
+      begin = zero_runs[i].first;
+      end = zero_runs[i].second;
+    } else {
+      end = std::max(end, zero_runs[i].second);
+    }
+  }
+  memset(base + begin, 0, end - begin);
+}
+
+void TcParser::MergeMessageFields(const MessageLite& from, MessageLite* to,
+                                  const TcParseTableBase* table) {
+  namespace fl = field_layout;
+  Arena* arena = to->GetArena();
+  for (const FieldEntry& entry : table->field_entries()) {
+    const uint16_t type_card = entry.type_card;
+    ABSL_DCHECK_EQ(type_card & fl::kSplitMask, 0);
+    const uint16_t card = type_card & fl::kFcMask;
+    ABSL_DCHECK_NE(card, fl::kFcOneof);
+    const uint16_t kind = type_card & fl::kFkMask;
+    if (card == fl::kFcRepeated) {
+      switch (kind) {
+        case fl::kFkString: {
+          const auto& src = RefAt<RepeatedPtrFieldBase>(&from, entry.offset);
+          if (!src.empty()) {
+            RefAt<RepeatedPtrFieldBase>(to, entry.offset)
+                .MergeFrom<std::string>(src);
+          }
+          break;
+        }
+        case fl::kFkMessage: {
+          const auto& src = RefAt<RepeatedPtrFieldBase>(&from, entry.offset);
+          if (!src.empty()) {
+            RefAt<RepeatedPtrFieldBase>(to, entry.offset)
+                .MergeFrom<MessageLite>(src);
+          }
+          break;
+        }
+        default:
+          switch (type_card & fl::kRepMask) {
+            case fl::kRep8Bits: {
+              const auto& src = RefAt<RepeatedField<bool>>(&from, entry.offset);
+              if (!src.empty()) {
+                RefAt<RepeatedField<bool>>(to, entry.offset).MergeFrom(src);
+              }
+              break;
+            }
+            case fl::kRep32Bits: {
+              const auto& src =
+                  RefAt<RepeatedField<uint32_t>>(&from, entry.offset);
+              if (!src.empty()) {
+                RefAt<RepeatedField<uint32_t>>(to, entry.offset).MergeFrom(src);
+              }
+              break;
+            }
+            default: {
+              const auto& src =
+                  RefAt<RepeatedField<uint64_t>>(&from, entry.offset);
+              if (!src.empty()) {
+                RefAt<RepeatedField<uint64_t>>(to, entry.offset).MergeFrom(src);
+              }
+              break;
+            }
+          }
+          break;
+      }
+      continue;
+    }
+    if (card == fl::kFcOptional &&
+        !IsHasBitSet(from, static_cast<uint32_t>(entry.has_idx))) {
+      continue;
+    }
+    switch (kind) {
+      case fl::kFkString: {
+        const auto& src = RefAt<ArenaStringPtr>(&from, entry.offset);
+        if (card == fl::kFcSingular && src.Get().empty()) break;
+        RefAt<ArenaStringPtr>(to, entry.offset).Set(src.Get(), arena);
+        if (card == fl::kFcOptional) SetHas(entry, to);
+        break;
+      }
+      case fl::kFkMessage: {
+        ABSL_DCHECK_NE(type_card & fl::kRepMask, fl::kRepLazy);
+        const MessageLite* src = RefAt<const MessageLite*>(&from, entry.offset);
+        if (src == nullptr) break;
+        MessageLite*& dst = RefAt<MessageLite*>(to, entry.offset);
+        if (dst == nullptr) dst = src->New(arena);
+        dst->CheckTypeAndMergeFrom(*src);
+        if (card == fl::kFcOptional) SetHas(entry, to);
+        break;
+      }
+      default: {
+        const uint32_t width = NumericRepWidth(type_card);
+        const char* src = reinterpret_cast<const char*>(&from) + entry.offset;
+        if (card == fl::kFcSingular) {
+          // Implicit-presence fields only transfer when set, i.e. nonzero.
+          uint64_t bits = 0;
+          memcpy(&bits, src, width);
+          if (bits == 0) break;
+        }
+        memcpy(reinterpret_cast<char*>(to) + entry.offset, src, width);
+        if (card == fl::kFcOptional) SetHas(entry, to);
+        break;
+      }
+    }
+  }
+}
+
 }  // namespace internal
 }  // namespace protobuf
 }  // namespace google
@@ -8,6 +8,8 @@
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <limits>
+#include <string>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -19,6 +21,7 @@
 #include "google/protobuf/generated_message_tctable_decl.h"
 #include "google/protobuf/generated_message_tctable_impl.h"
 #include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include "google/protobuf/parse_context.h"
 #include "google/protobuf/unittest.pb.h"
 #include "google/protobuf/wire_format_lite.h"
@@ -34,6 +37,13 @@ namespace internal {
 
 namespace {
 
+// Generated parse tables reference the tables of their child messages through
+// constexpr TcParser::GetTable<T>() pointers, so the links are resolved at
+// link time and the tables are constant-initialized with no runtime
+// registration.  Guard the constexpr-ness so that property does not regress.
+static_assert(TcParser::GetTable<protobuf_unittest::TestAllTypes>() != nullptr,
+              "generated parse tables must be statically addressable");
+
 using ::testing::ElementsAreArray;
 using ::testing::Eq;
 using ::testing::Not;
@@ -343,6 +353,16 @@ class FindFieldEntryTest : public ::testing::Test {
     return TcParser::MessageName(&table.header);
   }
 
+  // Calls the private `FieldNumber` function.
+  template <size_t kFastTableSizeLog2, size_t kNumEntries, size_t kNumFieldAux,
+            size_t kNameTableSize, size_t kFieldLookupTableSize>
+  static uint32_t FieldNumber(
+      const TcParseTable<kFastTableSizeLog2, kNumEntries, kNumFieldAux,
+                         kNameTableSize, kFieldLookupTableSize>& table,
+      const TcParseTableBase::FieldEntry* entry) {
+    return TcParser::FieldNumber(&table.header, entry);
+  }
+
   // Returns the number of fields scanned during a small scan.
   static constexpr int small_scan_size() { return TcParser::kMtSmallScanSize; }
 };
@@ -492,6 +512,47 @@ TEST_F(FindFieldEntryTest, BinarySearchRange) {
   }
 }
 
+TEST_F(FindFieldEntryTest, FieldNumberRoundTrip) {
+  // FieldNumber is the inverse of FindFieldEntry, for both the skipmap32
+  // range and the field lookup table.
+  // clang-format off
+  TcParseTable<0, 6, 0, 0, 8> table = {
+      // header:
+      {
+          0, 0,  // has_bits_offset, extensions
+          111,   // max_field_number
+          0,     // fast_idx_mask,
+          offsetof(decltype(table), field_lookup_table),
+          0xFFFFFFFF - (1<<0) - (1<<2) - (1<<3) - (1<<4) - (1<<6),  // 1,3-5,7
+          offsetof(decltype(table), field_entries),
+          6,           // num_field_entries
+          0, 0,        // num_aux_entries, aux_offset,
+          nullptr,     // default instance
+          nullptr,     // post_loop_handler
+          {},          // fallback function
+#ifdef PROTOBUF_PREFETCH_PARSE_TABLE
+          nullptr,     // to_prefetch
+#endif  // PROTOBUF_PREFETCH_PARSE_TABLE
+      },
+      {},  // fast_entries
+      // field_lookup_table for 1, 3, 4, 5, 7, 111:
+      {{
+        111, 0,                                              // field 111
+        1,                                                   // 1 skip entry
+        0xFFFE, 5,                                           // 1 field, entry 5
+        65535, 65535                                         // end of table
+      }},
+  };
+  // clang-format on
+  int table_field_numbers[] = {1, 3, 4, 5, 7, 111};
+
+  for (int i : table_field_numbers) {
+    const TcParseTableBase::FieldEntry* entry = FindFieldEntry(table, i);
+    ASSERT_THAT(entry, Not(Eq(nullptr)));
+    EXPECT_THAT(FieldNumber(table, entry), Eq(static_cast<uint32_t>(i)));
+  }
+}
+
 TEST_F(FindFieldEntryTest, OutOfRange) {
   // Look up tags that are larger than the maximum in the message.
   // clang-format off
@@ -946,6 +1007,163 @@ TEST(GeneratedMessageTctableLiteTest,
   EXPECT_LE(proto.vals().Capacity(), 2048);
 }
 
+TEST(GeneratedMessageTctableLiteTest, PackedSintRoundTrip) {
+  // The packed sint parse path appends raw varints and zigzag-decodes them in
+  // a second pass.  Small-magnitude values encode to one byte each and take
+  // the word-at-a-time decode path; the limit values encode to 5 and 10 bytes
+  // and force the generic varint fallback between the one-byte runs.
+  protobuf_unittest::TestPackedTypes proto;
+  for (int i = -40; i < 40; ++i) {
+    proto.add_packed_sint32(i);
+    proto.add_packed_sint64(i);
+    if (i % 10 == 0) {
+      proto.add_packed_sint32(std::numeric_limits<int32_t>::min());
+      proto.add_packed_sint32(std::numeric_limits<int32_t>::max());
+      proto.add_packed_sint64(std::numeric_limits<int64_t>::min());
+      proto.add_packed_sint64(std::numeric_limits<int64_t>::max());
+    }
+  }
+
+  std::string bytes;
+  ASSERT_TRUE(proto.SerializeToString(&bytes));
+
+  protobuf_unittest::TestPackedTypes parsed;
+  ASSERT_TRUE(parsed.ParseFromString(bytes));
+  EXPECT_THAT(parsed.packed_sint32(), ElementsAreArray(proto.packed_sint32()));
+  EXPECT_THAT(parsed.packed_sint64(), ElementsAreArray(proto.packed_sint64()));
+}
+
+TEST(ParseBudgetTest, ByteBudgetAbortsStreamParse) {
+  protobuf_unittest::TestAllTypes proto;
+  for (int i = 0; i < 2000; ++i) proto.add_repeated_int32(i);
+  std::string bytes;
+  ASSERT_TRUE(proto.SerializeToString(&bytes));
+
+  const auto* table = TcParser::GetTable<protobuf_unittest::TestAllTypes>();
+  // Small stream chunks force a buffer refill -- and thus a budget check --
+  // every 64 bytes.
+  {
+    io::ArrayInputStream input(bytes.data(), static_cast<int>(bytes.size()),
+                               /*block_size=*/64);
+    const char* ptr;
+    ParseContext ctx(io::CodedInputStream::GetDefaultRecursionLimit(),
+                     /*aliasing=*/false, &ptr, &input);
+    ctx.SetParseByteBudget(static_cast<int64_t>(bytes.size()));
+    protobuf_unittest::TestAllTypes parsed;
+    ptr = TcParser::ParseLoop(&parsed, ptr, &ctx, table);
+    ASSERT_TRUE(ptr != nullptr && ctx.EndedAtEndOfStream());
+    EXPECT_EQ(parsed.repeated_int32_size(), 2000);
+  }
+  {
+    io::ArrayInputStream input(bytes.data(), static_cast<int>(bytes.size()),
+                               /*block_size=*/64);
+    const char* ptr;
+    ParseContext ctx(io::CodedInputStream::GetDefaultRecursionLimit(),
+                     /*aliasing=*/false, &ptr, &input);
+    ctx.SetParseByteBudget(256);
+    protobuf_unittest::TestAllTypes parsed;
+    EXPECT_EQ(TcParser::ParseLoop(&parsed, ptr, &ctx, table), nullptr);
+  }
+}
+
+TEST(ParseBudgetTest, AbortCheckCancelsParse) {
+  protobuf_unittest::TestAllTypes proto;
+  for (int i = 0; i < 2000; ++i) proto.add_repeated_int32(i);
+  std::string bytes;
+  ASSERT_TRUE(proto.SerializeToString(&bytes));
+
+  io::ArrayInputStream input(bytes.data(), static_cast<int>(bytes.size()),
+                             /*block_size=*/64);
+  const char* ptr;
+  ParseContext ctx(io::CodedInputStream::GetDefaultRecursionLimit(),
+                   /*aliasing=*/false, &ptr, &input);
+  int checks = 0;
+  ctx.SetParseAbortCheck(
+      [](void* arg) { return ++*static_cast<int*>(arg) > 3; }, &checks);
+  protobuf_unittest::TestAllTypes parsed;
+  EXPECT_EQ(TcParser::ParseLoop(&parsed, ptr, &ctx,
+                                TcParser::GetTable<protobuf_unittest::TestAllTypes>()),
+            nullptr);
+  EXPECT_GT(checks, 3);
+}
+
+TEST(TableDrivenClearTest, ClearsContiguousNumericFieldsAndHasBits) {
+  protobuf_unittest::TestRequired msg;
+  msg.set_a(1);
+  msg.set_b(2);
+  msg.set_c(3);
+  msg.set_dummy12(4);
+
+  TcParser::ClearMessageFields(
+      &msg, TcParser::GetTable<protobuf_unittest::TestRequired>());
+  EXPECT_FALSE(msg.has_a());
+  EXPECT_FALSE(msg.has_b());
+  EXPECT_FALSE(msg.has_c());
+  EXPECT_FALSE(msg.has_dummy12());
+  EXPECT_EQ(msg.ByteSizeLong(), 0);
+}
+
+TEST(TableDrivenClearTest, ClearsStringsAndRepeatedFields) {
+  protobuf_unittest::OneString one;
+  one.set_data("payload");
+  TcParser::ClearMessageFields(
+      &one, TcParser::GetTable<protobuf_unittest::OneString>());
+  EXPECT_FALSE(one.has_data());
+  EXPECT_TRUE(one.data().empty());
+
+  protobuf_unittest::MoreString more;
+  more.add_data("a");
+  more.add_data("b");
+  TcParser::ClearMessageFields(
+      &more, TcParser::GetTable<protobuf_unittest::MoreString>());
+  EXPECT_EQ(more.data_size(), 0);
+}
+
+TEST(TableDrivenClearTest, ClearsButRetainsSubmessages) {
+  protobuf_unittest::TestNestedMessageHasBits msg;
+  auto* nested = msg.mutable_optional_nested_message();
+  nested->add_nestedmessage_repeated_int32(42);
+  nested->add_nestedmessage_repeated_foreignmessage()->set_c(7);
+
+  TcParser::ClearMessageFields(
+      &msg,
+      TcParser::GetTable<protobuf_unittest::TestNestedMessageHasBits>());
+  EXPECT_FALSE(msg.has_optional_nested_message());
+  EXPECT_EQ(msg.ByteSizeLong(), 0);
+  // The submessage object is retained for reuse, but fully cleared.
+  EXPECT_EQ(msg.mutable_optional_nested_message(), nested);
+  EXPECT_EQ(nested->nestedmessage_repeated_int32_size(), 0);
+  EXPECT_EQ(nested->nestedmessage_repeated_foreignmessage_size(), 0);
+}
+
+TEST(TableDrivenMergeTest, MatchesGeneratedMergeFrom) {
+  protobuf_unittest::TestNestedMessageHasBits from;
+  auto* nested = from.mutable_optional_nested_message();
+  nested->add_nestedmessage_repeated_int32(1);
+  nested->add_nestedmessage_repeated_int32(2);
+  nested->add_nestedmessage_repeated_foreignmessage()->set_c(7);
+
+  protobuf_unittest::TestNestedMessageHasBits to;
+  to.mutable_optional_nested_message()->add_nestedmessage_repeated_int32(99);
+  protobuf_unittest::TestNestedMessageHasBits expected = to;
+  expected.MergeFrom(from);
+
+  TcParser::MergeMessageFields(
+      from, &to,
+      TcParser::GetTable<protobuf_unittest::TestNestedMessageHasBits>());
+  EXPECT_EQ(to.SerializeAsString(), expected.SerializeAsString());
+}
+
+TEST(TableDrivenMergeTest, SetsHasBitsAndCopiesStrings) {
+  protobuf_unittest::OneString from;
+  from.set_data("payload");
+  protobuf_unittest::OneString to;
+
+  TcParser::MergeMessageFields(
+      from, &to, TcParser::GetTable<protobuf_unittest::OneString>());
+  EXPECT_TRUE(to.has_data());
+  EXPECT_EQ(to.data(), "payload");
+}
 
 }  // namespace internal
 }  // namespace protobuf
@@ -321,6 +321,28 @@ struct WeakDescriptorDefaultTail {
   size_t size;
 };
 
+// One element of the compile-time field list emitted into generated headers
+// (see internal_field_metadata() in generated .pb.h files). `member` points at
+// the field's storage inside the message's private Impl_ struct when that
+// storage is a direct member, and is nullptr for fields reached indirectly
+// (oneof members and split fields); templates can tell the two apart with
+// std::is_member_pointer<decltype(entry.member)>.
+template <typename MemberT>
+struct FieldMetadataEntry {
+  const char* name;  // unqualified field name
+  int number;        // field number
+  int type;          // FieldDescriptor::Type of the field, as an int
+  MemberT member;    // pointer to the storage member, or nullptr
+};
+
+template <typename MemberT>
+constexpr FieldMetadataEntry<MemberT> MakeFieldMetadataEntry(const char* name,
+                                                             int number,
+                                                             int type,
+                                                             MemberT member) {
+  return FieldMetadataEntry<MemberT>{name, number, type, member};
+}
+
 }  // namespace internal
 }  // namespace protobuf
 }  // namespace google
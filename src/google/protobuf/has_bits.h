@@ -27,6 +27,15 @@ namespace google {
 namespace protobuf {
 namespace internal {
 
+// Returns true if every element is non-negative.  Used by generated presence
+// APIs to validate packs of has-bit indexes at compile time.
+constexpr bool AllNonNegative(std::initializer_list<int> values) {
+  for (int v : values) {
+    if (v < 0) return false;
+  }
+  return true;
+}
+
 template <int doublewords>
 class HasBits {
  public:
@@ -56,6 +65,36 @@ class HasBits {
     return !(*this == rhs);
   }
 
+  // Returns true if every bit set in `mask` is also set here.
+  bool TestAll(const HasBits<doublewords>& mask) const {
+    for (int i = 0; i < doublewords; ++i) {
+      if ((has_bits_[i] & mask.has_bits_[i]) != mask.has_bits_[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Returns true if any bit set in `mask` is also set here.
+  bool TestAny(const HasBits<doublewords>& mask) const {
+    for (int i = 0; i < doublewords; ++i) {
+      if ((has_bits_[i] & mask.has_bits_[i]) != 0) return true;
+    }
+    return false;
+  }
+
+  // Builds the instance with the given bit indexes set.  Used by generated
+  // code to assemble compile-time masks for TestAll()/TestAny().
+  static constexpr HasBits FromIndexes(
+      std::initializer_list<uint32_t> indexes) {
+    HasBits result;
+    for (uint32_t index : indexes) {
+      assert(index < doublewords * 32u);
+      result.has_bits_[index / 32] |= uint32_t{1} << (index % 32);
+    }
+    return result;
+  }
+
   void Or(const HasBits<doublewords>& rhs) {
     for (int i = 0; (i + 1) < doublewords; i += 2) {
       Write64B(Read64B(i) | rhs.Read64B(i), i);
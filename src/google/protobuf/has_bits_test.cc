@@ -102,6 +102,35 @@ TEST(HasBits, Copy) {
   EXPECT_TRUE(bits1 == bits2);
 }
 
+TEST(HasBits, FromIndexes) {
+  constexpr HasBits<2> bits = HasBits<2>::FromIndexes({0, 5, 32, 63});
+  EXPECT_TRUE(bits == HasBits<2>({(1u << 0) | (1u << 5), (1u << 0) | (1u << 31)}));
+}
+
+TEST(HasBits, TestAll) {
+  HasBits<2> bits({0b1011, 0b0001});
+  EXPECT_TRUE(bits.TestAll(HasBits<2>::FromIndexes({0, 1, 3, 32})));
+  EXPECT_TRUE(bits.TestAll(HasBits<2>::FromIndexes({1})));
+  EXPECT_FALSE(bits.TestAll(HasBits<2>::FromIndexes({1, 2})));
+  EXPECT_FALSE(bits.TestAll(HasBits<2>::FromIndexes({0, 33})));
+  // An empty mask is trivially satisfied.
+  EXPECT_TRUE(bits.TestAll(HasBits<2>()));
+}
+
+TEST(HasBits, TestAny) {
+  HasBits<2> bits({0b1011, 0b0001});
+  EXPECT_TRUE(bits.TestAny(HasBits<2>::FromIndexes({2, 3})));
+  EXPECT_TRUE(bits.TestAny(HasBits<2>::FromIndexes({32})));
+  EXPECT_FALSE(bits.TestAny(HasBits<2>::FromIndexes({2, 33})));
+  EXPECT_FALSE(bits.TestAny(HasBits<2>()));
+}
+
+TEST(HasBits, AllNonNegative) {
+  static_assert(AllNonNegative({0, 1, 31}), "all indexes are valid");
+  static_assert(!AllNonNegative({0, -1, 31}), "a -1 index is rejected");
+  EXPECT_TRUE(AllNonNegative({}));
+}
+
 }  // namespace
 }  // namespace internal
 }  // namespace protobuf
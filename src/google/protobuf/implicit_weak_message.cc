@@ -22,7 +22,11 @@ namespace internal {
 
 const char* ImplicitWeakMessage::ParseImpl(ImplicitWeakMessage* msg,
                                            const char* ptr, ParseContext* ctx) {
-  return ctx->AppendString(ptr, msg->data_);
+  // Walk the fields, preserving their bytes verbatim, instead of copying in
+  // bulk up to the current limit.  Group-typed weak fields have no length
+  // prefix, so the parse must stop at the matching end-group tag; the field
+  // walk handles both framings (limits and end-group tags) uniformly.
+  return UnknownGroupLiteParse(msg->data_, ptr, ctx);
 }
 
 struct ImplicitWeakMessageDefaultType {
@@ -0,0 +1,60 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/implicit_weak_message.h"
+
+#include <string>
+
+#include <gtest/gtest.h>
+#include "absl/strings/string_view.h"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+namespace {
+
+std::string Bytes(absl::string_view data) { return std::string(data); }
+
+TEST(ImplicitWeakMessageTest, RoundTripsFieldBytes) {
+  // field 1 varint 150, field 2 string "abc", field 3 group { field 4
+  // varint 1 }.
+  const std::string payload = Bytes(
+      "\x08\x96\x01"
+      "\x12\x03"
+      "abc"
+      "\x1b\x20\x01\x1c");
+
+  ImplicitWeakMessage message;
+  ASSERT_TRUE(message.ParseFromString(payload));
+  EXPECT_EQ(payload.size(), message.ByteSizeLong());
+  EXPECT_EQ(payload, message.SerializeAsString());
+}
+
+TEST(ImplicitWeakMessageTest, MergeAppendsFieldBytes) {
+  ImplicitWeakMessage a;
+  ImplicitWeakMessage b;
+  ASSERT_TRUE(a.ParseFromString(Bytes("\x08\x01")));
+  ASSERT_TRUE(b.ParseFromString(Bytes("\x08\x02")));
+  a.CheckTypeAndMergeFrom(b);
+  EXPECT_EQ(Bytes("\x08\x01\x08\x02"), a.SerializeAsString());
+}
+
+TEST(ImplicitWeakMessageTest, RejectsMalformedData) {
+  ImplicitWeakMessage message;
+  // Truncated length-delimited field.
+  EXPECT_FALSE(message.ParseFromString(Bytes("\x0a\x05"
+                                             "ab")));
+  // End-group tag with no matching start-group tag.
+  EXPECT_FALSE(message.ParseFromString(Bytes("\x0c")));
+  // Unterminated group.
+  EXPECT_FALSE(message.ParseFromString(Bytes("\x1b\x20\x01")));
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
@@ -27,6 +27,7 @@
 
 #include "absl/log/absl_check.h"
 #include "absl/log/absl_log.h"
+#include "absl/numeric/bits.h"
 #include "absl/strings/cord.h"
 #include "absl/strings/internal/resize_uninitialized.h"
 #include "absl/strings/string_view.h"
@@ -276,7 +277,31 @@ bool CodedInputStream::ReadStringFallback(std::string* buffer, int size) {
   if (closest_limit != INT_MAX) {
     int bytes_to_limit = closest_limit - CurrentPosition();
     if (bytes_to_limit > 0 && size > 0 && size <= bytes_to_limit) {
-      buffer->reserve(size);
+      // The payload is known to fit within the limit, so size the string up
+      // front and copy into uninitialized storage, like ReadString() does when
+      // the data is already buffered, instead of growing through append().
+      absl::strings_internal::STLStringResizeUninitialized(buffer, size);
+      std::pair<char*, bool> z = as_string_data(buffer);
+      if (z.second) {
+        char* out = z.first;
+        int current_buffer_size;
+        while ((current_buffer_size = BufferSize()) < size) {
+          memcpy(out, buffer_, current_buffer_size);
+          out += current_buffer_size;
+          size -= current_buffer_size;
+          Advance(current_buffer_size);
+          if (!Refresh()) {
+            // The stream ended early; don't leave uninitialized bytes
+            // reachable through the string.
+            buffer->clear();
+            return false;
+          }
+        }
+        memcpy(out, buffer_, size);
+        Advance(size);
+        return true;
+      }
+      buffer->clear();
     }
   }
 
@@ -700,13 +725,100 @@ bool CodedInputStream::Refresh() {
 // CodedOutputStream =================================================
 
 void EpsCopyOutputStream::EnableAliasing(bool enabled) {
-  aliasing_enabled_ = enabled && stream_->AllowsAliasing();
+  // Aliased writes bypass the carry buffer and would be reordered against
+  // coalesced bytes, so aliasing stays off while a minimum flush unit is set.
+  aliasing_enabled_ =
+      enabled && min_flush_unit_ == 0 && stream_->AllowsAliasing();
+}
+
+void EpsCopyOutputStream::SetMinFlushUnit(int min_bytes) {
+  ABSL_DCHECK(stream_ != nullptr);
+  ABSL_DCHECK_GT(min_bytes, 0);
+  ABSL_DCHECK(coalesce_buffer_ == nullptr);
+  // The stream must not hold a partially written sink buffer; its tail would
+  // never be returned once grants start coming from the carry buffer.
+  ABSL_DCHECK(buffer_end_ == buffer_ && end_ == buffer_);
+  min_flush_unit_ = min_bytes;
+  coalesce_buffer_.reset(new uint8_t[min_bytes]);
+  coalesce_pos_ = 0;
+  aliasing_enabled_ = false;
+}
+
+bool EpsCopyOutputStream::FlushCoalesced() {
+  if (min_flush_unit_ == 0 || coalesce_pos_ == 0) return true;
+  if (!DrainCoalesced(coalesce_pos_)) {
+    had_error_ = true;
+    return false;
+  }
+  return true;
+}
+
+bool EpsCopyOutputStream::DrainCoalesced(int size) {
+  const uint8_t* p = coalesce_buffer_.get();
+  int remaining = size;
+  while (remaining > 0) {
+    void* data;
+    int chunk;
+    if (!stream_->Next(&data, &chunk)) return false;
+    int n = chunk < remaining ? chunk : remaining;
+    std::memcpy(data, p, n);
+    if (n < chunk) stream_->BackUp(chunk - n);
+    p += n;
+    remaining -= n;
+  }
+  RecordFlush(size);
+  coalesce_pos_ = 0;
+  return true;
+}
+
+bool EpsCopyOutputStream::StreamNext(void** data, int* size) {
+  if (PROTOBUF_PREDICT_FALSE(min_flush_unit_ > 0)) {
+    // Grant the remainder of the carry buffer, draining a completed unit
+    // first. The sink only ever sees whole units this way.
+    if (coalesce_pos_ == min_flush_unit_ && !DrainCoalesced(min_flush_unit_)) {
+      return false;
+    }
+    *data = coalesce_buffer_.get() + coalesce_pos_;
+    *size = min_flush_unit_ - coalesce_pos_;
+    coalesce_pos_ = min_flush_unit_;
+    return true;
+  }
+  // Moving on to a fresh buffer commits the previous one in full.
+  RecordFlush(stream_grant_);
+  stream_grant_ = 0;
+  if (!stream_->Next(data, size)) return false;
+  stream_grant_ = *size;
+  return true;
+}
+
+void EpsCopyOutputStream::StreamBackUp(int count) {
+  if (PROTOBUF_PREDICT_FALSE(min_flush_unit_ > 0)) {
+    // The grant came from the carry buffer; rewind it so the bytes written
+    // so far wait for a full unit instead of being pushed to the sink.
+    coalesce_pos_ -= count;
+    return;
+  }
+  stream_->BackUp(count);
+  RecordFlush(stream_grant_ - count);
+  stream_grant_ = 0;
+}
+
+void EpsCopyOutputStream::RecordFlush(int64_t size) {
+  if (flush_stats_ == nullptr || size <= 0) return;
+  ++flush_stats_->flushes;
+  flush_stats_->flushed_bytes += size;
+  if (min_flush_unit_ > 0 && size < min_flush_unit_) {
+    ++flush_stats_->small_flushes;
+  }
+  int bucket = absl::bit_width(static_cast<uint64_t>(size)) - 1;
+  ++flush_stats_->histogram[bucket < 31 ? bucket : 31];
 }
 
 int64_t EpsCopyOutputStream::ByteCount(uint8_t* ptr) const {
   // Calculate the current offset relative to the end of the stream buffer.
   int delta = (end_ - ptr) + (buffer_end_ ? 0 : kSlopBytes);
-  return stream_->ByteCount() - delta;
+  // Bytes held in the carry buffer have not reached the stream yet.
+  return stream_->ByteCount() + coalesce_pos_ - delta;
 }
 
 // Flushes what's written out to the underlying ZeroCopyOutputStream buffers.
@@ -737,7 +849,7 @@ int EpsCopyOutputStream::Flush(uint8_t* ptr) {
 uint8_t* EpsCopyOutputStream::Trim(uint8_t* ptr) {
   if (had_error_) return ptr;
   int s = Flush(ptr);
-  stream_->BackUp(s);
+  StreamBackUp(s);
   // Reset to initial state (expecting new buffer)
   buffer_end_ = end_ = buffer_;
   return buffer_;
@@ -765,7 +877,7 @@ bool EpsCopyOutputStream::Skip(int count, uint8_t** pp) {
   void* data = buffer_end_;
   while (count > size) {
     count -= size;
-    if (!stream_->Next(&data, &size)) {
+    if (!StreamNext(&data, &size)) {
       *pp = Error();
       return false;
     }
@@ -787,7 +899,7 @@ bool EpsCopyOutputStream::GetDirectBufferPointer(void** data, int* size,
   }
   *data = buffer_end_;
   while (*size == 0) {
-    if (!stream_->Next(data, size)) {
+    if (!StreamNext(data, size)) {
       *pp = Error();
       return false;
     }
@@ -827,7 +939,7 @@ uint8_t* EpsCopyOutputStream::Next() {
     int size;
     do {
       void* data;
-      if (PROTOBUF_PREDICT_FALSE(!stream_->Next(&data, &size))) {
+      if (PROTOBUF_PREDICT_FALSE(!StreamNext(&data, &size))) {
         // Stream has an error, we use the patch buffer to continue to be
         // able to write.
         return Error();
@@ -888,7 +1000,10 @@ uint8_t* EpsCopyOutputStream::WriteAliasedRaw(const void* data, int size,
     return WriteRaw(data, size, ptr);
   } else {
     ptr = Trim(ptr);
-    if (stream_->WriteAliasedRaw(data, size)) return ptr;
+    if (stream_->WriteAliasedRaw(data, size)) {
+      RecordFlush(size);
+      return ptr;
+    }
     return Error();
   }
 }
@@ -957,7 +1072,13 @@ uint8_t* EpsCopyOutputStream::WriteCord(const absl::Cord& cord, uint8_t* ptr) {
   } else {
     // Back up to the position where the Cord should start.
     ptr = Trim(ptr);
+    // The Cord bypasses the carry buffer, so push held back bytes first to
+    // keep them ordered before it.
+    if (PROTOBUF_PREDICT_FALSE(min_flush_unit_ > 0) && !FlushCoalesced()) {
+      return Error();
+    }
     if (!stream_->WriteCord(cord)) return Error();
+    RecordFlush(static_cast<int64_t>(cord.size()));
     return ptr;
   }
 }
@@ -996,7 +1117,10 @@ uint8_t* EpsCopyOutputStream::WriteCordOutline(const absl::Cord& c, uint8_t* ptr
 std::atomic<bool> CodedOutputStream::default_serialization_deterministic_{
     false};
 
-CodedOutputStream::~CodedOutputStream() { Trim(); }
+CodedOutputStream::~CodedOutputStream() {
+  Trim();
+  impl_.FlushCoalesced();
+}
 
 uint8_t* CodedOutputStream::WriteCordToArray(const absl::Cord& cord,
                                              uint8_t* target) {
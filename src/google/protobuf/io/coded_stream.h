@@ -94,6 +94,7 @@
 #include <cstdint>
 #include <cstring>
 #include <limits>
+#include <memory>
 #include <string>
 #include <type_traits>
 #include <utility>
@@ -383,6 +384,16 @@ class PROTOBUF_EXPORT CodedInputStream {
 
   static int GetDefaultRecursionLimit() { return default_recursion_limit_; }
 
+  // Sets the recursion limit used by CodedInputStreams constructed after this
+  // call and by all message parsing entry points (ParseFromString() etc.),
+  // which read the default at the start of each parse.  This gives a single
+  // process-wide knob for the parse depth policy instead of scattering
+  // SetRecursionLimit() calls across call sites.  Not synchronized: call it
+  // during program initialization, before any parsing starts.
+  static void SetDefaultRecursionLimit(int limit) {
+    default_recursion_limit_ = limit;
+  }
+
   // Increments the current recursion depth.  Returns true if the depth is
   // under the limit, false if it has gone over.
   bool IncrementRecursionDepth();
@@ -796,6 +807,41 @@ class PROTOBUF_EXPORT EpsCopyOutputStream {
   // remains live until all of the data has been consumed from the stream.
   void EnableAliasing(bool enabled);
 
+  // Statistics about the buffer commits ("flushes") this stream makes to the
+  // underlying ZeroCopyOutputStream. See SetFlushStats().
+  struct FlushStats {
+    int64_t flushes = 0;        // Number of buffers committed to the stream.
+    int64_t flushed_bytes = 0;  // Total number of bytes committed.
+    // Number of commits smaller than the minimum flush unit. Only counted
+    // when a minimum flush unit is set, see SetMinFlushUnit().
+    int64_t small_flushes = 0;
+    // histogram[n] counts commits whose size is in [2^n, 2^(n+1)).
+    int64_t histogram[32] = {};
+  };
+
+  // Records the size of every buffer committed to the underlying stream into
+  // `stats`, which must outlive this object. A buffer is committed when the
+  // stream moves on to a fresh buffer, when Trim() returns the unused tail of
+  // the current one, and when a large write (an aliased buffer or a Cord) is
+  // passed through to the underlying stream directly. Buffers this stream did
+  // not obtain itself (i.e. an eagerly initialized first buffer) are not
+  // counted. Pass nullptr (the default) to disable collection.
+  void SetFlushStats(FlushStats* stats) { flush_stats_ = stats; }
+
+  // Accumulates writes in an internal buffer so that the underlying stream
+  // only sees commits of exactly `min_bytes`, except for a final partial unit
+  // pushed by FlushCoalesced(). This helps sinks that pay a fixed cost per
+  // committed buffer (e.g. a socket write) without interposing a copying
+  // ZeroCopyOutputStream. Must be called before anything is written, and
+  // disables aliasing.
+  void SetMinFlushUnit(int min_bytes);
+
+  // Pushes bytes held back by SetMinFlushUnit() to the underlying stream even
+  // though they do not fill a whole unit. Call Trim() first so that the held
+  // back region ends at the current write position. Returns false on an
+  // underlying write error. No-op if no minimum flush unit is set.
+  bool FlushCoalesced();
+
   // See documentation on CodedOutputStream::SetSerializationDeterministic.
   void SetSerializationDeterministic(bool value) {
     is_serialization_deterministic_ = value;
@@ -820,10 +866,28 @@ class PROTOBUF_EXPORT EpsCopyOutputStream {
   bool aliasing_enabled_ = false;  // See EnableAliasing().
   bool is_serialization_deterministic_;
   bool skip_check_consistency = false;
+  // Size of the buffer most recently obtained from stream_ that is still
+  // being written to; used to size commits for flush_stats_.
+  int stream_grant_ = 0;
+  // Minimum commit size towards stream_; 0 disables coalescing. The carry
+  // buffer holds a partial unit across commits and coalesce_pos_ is the end
+  // of the region handed out of it so far. See SetMinFlushUnit().
+  int min_flush_unit_ = 0;
+  int coalesce_pos_ = 0;
+  std::unique_ptr<uint8_t[]> coalesce_buffer_;
+  FlushStats* flush_stats_ = nullptr;
 
   uint8_t* EnsureSpaceFallback(uint8_t* ptr);
   inline uint8_t* Next();
   int Flush(uint8_t* ptr);
+  // stream_->Next() / BackUp() must be routed through these so that commits
+  // are counted into flush_stats_ and, when a minimum flush unit is set, the
+  // carry buffer is interposed between this stream and the sink.
+  bool StreamNext(void** data, int* size);
+  void StreamBackUp(int count);
+  // Writes the first `size` bytes of the carry buffer to stream_.
+  bool DrainCoalesced(int size);
+  void RecordFlush(int64_t size);
   std::ptrdiff_t GetSize(uint8_t* ptr) const {
     ABSL_DCHECK(ptr <= end_ + kSlopBytes);  // NOLINT
     return end_ + kSlopBytes - ptr;
@@ -874,6 +938,31 @@ class PROTOBUF_EXPORT EpsCopyOutputStream {
     ptr = WriteLengthDelim(num, size, ptr);
     auto it = r.data();
     auto end = it + r.size();
+#ifdef ABSL_IS_LITTLE_ENDIAN
+    // Runs of values that encode in one byte each are the common case for
+    // packed fields. Emit eight of them at a time as a single word store
+    // with one bounds check; EnsureSpace guarantees 16 writable bytes. A
+    // batch containing a multi-byte value encodes one value through the
+    // generic path and retries, so mixed content still benefits.
+    while (end - it >= 8) {
+      uint64_t word = 0;
+      bool all_one_byte = true;
+      for (int i = 0; i < 8; ++i) {
+        const auto v = encode(it[i]);
+        all_one_byte &= v < 0x80;
+        word |= static_cast<uint64_t>(static_cast<uint8_t>(v)) << (8 * i);
+      }
+      ptr = EnsureSpace(ptr);
+      if (PROTOBUF_PREDICT_TRUE(all_one_byte)) {
+        std::memcpy(ptr, &word, sizeof(word));
+        ptr += 8;
+        it += 8;
+      } else {
+        ptr = UnsafeVarint(encode(*it++), ptr);
+      }
+    }
+    if (it == end) return ptr;
+#endif
     do {
       ptr = EnsureSpace(ptr);
       ptr = UnsafeVarint(encode(*it++), ptr);
@@ -1214,6 +1303,33 @@ class PROTOBUF_EXPORT CodedOutputStream {
   // remains live until all of the data has been consumed from the stream.
   void EnableAliasing(bool enabled) { impl_.EnableAliasing(enabled); }
 
+  // Collects statistics about the buffer commits this stream makes to the
+  // underlying ZeroCopyOutputStream into `stats`, which must outlive this
+  // object. See EpsCopyOutputStream::SetFlushStats(). For complete
+  // accounting, construct the stream with `eager_init` false; an eagerly
+  // obtained first buffer is not counted.
+  void SetFlushStats(EpsCopyOutputStream::FlushStats* stats) {
+    impl_.SetFlushStats(stats);
+  }
+
+  // Coalesces commits to the underlying stream into units of `min_bytes` by
+  // buffering writes internally; useful when the underlying stream pays a
+  // fixed cost per committed buffer, e.g. a write call per buffer on a
+  // socket stream. Must be called before anything is written and disables
+  // aliasing. The final partial unit is pushed by FlushCoalesced() or on
+  // destruction. See EpsCopyOutputStream::SetMinFlushUnit().
+  void SetMinFlushUnit(int min_bytes) {
+    Trim();
+    impl_.SetMinFlushUnit(min_bytes);
+  }
+
+  // Trims the stream and pushes any bytes held back by SetMinFlushUnit() to
+  // the underlying stream. Returns false on an underlying write error.
+  bool FlushCoalesced() {
+    Trim();
+    return impl_.FlushCoalesced();
+  }
+
   // Indicate to the serializer whether the user wants deterministic
   // serialization. The default when this is not called comes from the global
   // default, controlled by SetDefaultSerializationDeterministic.
@@ -909,6 +909,24 @@ TEST_F(CodedStreamTest,
   }
 }
 
+TEST_F(CodedStreamTest, ReadStringClearsResultOnStreamEndWithinLimit) {
+  memcpy(buffer_, kRawBytes, sizeof(kRawBytes));
+  // The stream holds fewer bytes than the requested size, but the pushed
+  // limit is far enough away that ReadStringFallback() sizes the string up
+  // front.  The premature end of the stream must not leave uninitialized
+  // bytes readable through the string.
+  ArrayInputStream input(buffer_, 32, 16);
+
+  {
+    CodedInputStream coded_input(&input);
+    coded_input.PushLimit(64);
+
+    std::string str;
+    EXPECT_FALSE(coded_input.ReadString(&str, 48));
+    EXPECT_TRUE(str.empty());
+  }
+}
+
 
 // -------------------------------------------------------------------
 // Cord reads and writes
@@ -1089,6 +1107,76 @@ TEST_F(CodedStreamTest, Trim) {
   EXPECT_EQ(1 + sizeof(kTestData), cord.size());
 }
 
+// -------------------------------------------------------------------
+// Flush statistics and coalescing
+
+TEST_F(CodedStreamTest, FlushStatsCountCommittedBuffers) {
+  ArrayOutputStream output(buffer_, sizeof(buffer_), 16);
+  EpsCopyOutputStream::FlushStats stats;
+
+  {
+    // With eager initialization the first buffer is not obtained by the
+    // coded stream itself and would go uncounted.
+    CodedOutputStream coded_output(&output, /*eager_init=*/false);
+    coded_output.SetFlushStats(&stats);
+
+    std::string data;
+    for (int i = 0; i < 40; i++) data.push_back('A' + i % 26);
+    coded_output.WriteRaw(data.data(), data.size());
+    coded_output.Trim();
+  }
+
+  // Every committed byte is attributed to exactly one flush.
+  EXPECT_EQ(40, stats.flushed_bytes);
+  // The sink hands out 16 byte buffers, so at least three were committed.
+  EXPECT_GE(stats.flushes, 3);
+  EXPECT_EQ(0, stats.small_flushes);
+  int64_t histogram_total = 0;
+  for (int64_t count : stats.histogram) histogram_total += count;
+  EXPECT_EQ(stats.flushes, histogram_total);
+}
+
+TEST_F(CodedStreamTest, MinFlushUnitCoalescesCommits) {
+  ArrayOutputStream output(buffer_, sizeof(buffer_), 16);
+  EpsCopyOutputStream::FlushStats stats;
+  std::string data;
+  for (int i = 0; i < 130; i++) data.push_back('A' + i % 26);
+
+  CodedOutputStream coded_output(&output, /*eager_init=*/false);
+  coded_output.SetMinFlushUnit(100);
+  coded_output.SetFlushStats(&stats);
+
+  coded_output.WriteRaw(data.data(), data.size());
+  EXPECT_FALSE(coded_output.HadError());
+  EXPECT_EQ(130, coded_output.ByteCount());
+
+  // Only the completed 100 byte unit has reached the sink; the remainder is
+  // held back for the next unit.
+  EXPECT_EQ(100, output.ByteCount());
+  EXPECT_EQ(1, stats.flushes);
+  EXPECT_EQ(100, stats.flushed_bytes);
+
+  EXPECT_TRUE(coded_output.FlushCoalesced());
+  EXPECT_EQ(130, output.ByteCount());
+  EXPECT_EQ(0, memcmp(buffer_, data.data(), data.size()));
+  EXPECT_EQ(2, stats.flushes);
+  EXPECT_EQ(130, stats.flushed_bytes);
+  EXPECT_EQ(1, stats.small_flushes);
+}
+
+TEST_F(CodedStreamTest, MinFlushUnitTailIsFlushedOnDestruction) {
+  ArrayOutputStream output(buffer_, sizeof(buffer_), 16);
+
+  {
+    CodedOutputStream coded_output(&output, /*eager_init=*/false);
+    coded_output.SetMinFlushUnit(64);
+    coded_output.WriteRaw("0123456789", 10);
+    EXPECT_EQ(0, output.ByteCount());
+  }
+
+  EXPECT_EQ(10, output.ByteCount());
+  EXPECT_EQ(0, memcmp(buffer_, "0123456789", 10));
+}
 
 // -------------------------------------------------------------------
 // Skip
@@ -1438,6 +1526,21 @@ TEST_F(CodedStreamTest, RecursionLimit) {
   EXPECT_FALSE(coded_input.IncrementRecursionDepth());  // 7
 }
 
+TEST_F(CodedStreamTest, DefaultRecursionLimit) {
+  const int old_default = CodedInputStream::GetDefaultRecursionLimit();
+  CodedInputStream::SetDefaultRecursionLimit(2);
+  EXPECT_EQ(2, CodedInputStream::GetDefaultRecursionLimit());
+
+  // Streams constructed after the call pick up the new default.
+  ArrayInputStream input(buffer_, sizeof(buffer_));
+  CodedInputStream coded_input(&input);
+  EXPECT_TRUE(coded_input.IncrementRecursionDepth());   // 1
+  EXPECT_TRUE(coded_input.IncrementRecursionDepth());   // 2
+  EXPECT_FALSE(coded_input.IncrementRecursionDepth());  // 3
+
+  CodedInputStream::SetDefaultRecursionLimit(old_default);
+}
+
 
 class ReallyBigInputStream : public ZeroCopyInputStream {
  public:
@@ -14,6 +14,14 @@
 #if HAVE_ZLIB
 #include "google/protobuf/io/gzip_stream.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+
 #include "google/protobuf/stubs/common.h"
 #include "absl/log/absl_check.h"
 #include "absl/log/absl_log.h"
@@ -175,6 +183,120 @@ int64_t GzipInputStream::ByteCount() const {
 
 // =========================================================================
 
+static int RecordWindowBits(ZlibRecordDecompressor::Format format) {
+  switch (format) {
+    case ZlibRecordDecompressor::GZIP:
+      return 15 | 16;
+    case ZlibRecordDecompressor::AUTO:
+      return 15 | 32;
+    case ZlibRecordDecompressor::ZLIB:
+      return 15;
+    case ZlibRecordDecompressor::RAW:
+      return -15;
+  }
+  return 15 | 32;
+}
+
+ZlibRecordDecompressor::Options::Options() : format(AUTO) {}
+
+ZlibRecordDecompressor::ZlibRecordDecompressor(const Options& options)
+    : options_(options), zerror_(Z_OK), initialized_(false) {
+  zcontext_.state = Z_NULL;
+  zcontext_.zalloc = Z_NULL;
+  zcontext_.zfree = Z_NULL;
+  zcontext_.opaque = Z_NULL;
+  zcontext_.next_in = nullptr;
+  zcontext_.avail_in = 0;
+  zcontext_.msg = nullptr;
+}
+
+ZlibRecordDecompressor::~ZlibRecordDecompressor() {
+  if (initialized_) {
+    inflateEnd(&zcontext_);
+  }
+}
+
+int ZlibRecordDecompressor::SetDictionary() {
+  return inflateSetDictionary(
+      &zcontext_, reinterpret_cast<const Bytef*>(options_.dictionary.data()),
+      options_.dictionary.size());
+}
+
+bool ZlibRecordDecompressor::Decompress(const void* data, size_t size,
+                                        std::string* output) {
+  if (!initialized_) {
+    zerror_ = inflateInit2(&zcontext_, RecordWindowBits(options_.format));
+    if (zerror_ != Z_OK) {
+      return false;
+    }
+    initialized_ = true;
+  } else {
+    // Rewinds the stream without freeing the allocated window; this is the
+    // per-record saving over constructing a GzipInputStream each time.
+    zerror_ = inflateReset2(&zcontext_, RecordWindowBits(options_.format));
+    if (zerror_ != Z_OK) {
+      return false;
+    }
+  }
+  if (options_.format == RAW && !options_.dictionary.empty()) {
+    // Raw deflate has no FDICT handshake; the dictionary is simply assumed.
+    zerror_ = SetDictionary();
+    if (zerror_ != Z_OK) {
+      return false;
+    }
+  }
+
+  // Start from the string's existing allocation; small records compressed
+  // from similar inputs converge on a stable capacity after a few calls.
+  output->resize(std::max<size_t>(output->capacity(), 4 * size + 64));
+  zcontext_.next_in = static_cast<Bytef*>(const_cast<void*>(data));
+  zcontext_.avail_in = size;
+  size_t total_out = 0;
+  while (true) {
+    zcontext_.next_out = reinterpret_cast<Bytef*>(&(*output)[total_out]);
+    zcontext_.avail_out = output->size() - total_out;
+    int error = inflate(&zcontext_, Z_NO_FLUSH);
+    total_out = output->size() - zcontext_.avail_out;
+    if (error == Z_STREAM_END) {
+      break;
+    }
+    if (error == Z_NEED_DICT) {
+      if (options_.dictionary.empty()) {
+        zerror_ = Z_NEED_DICT;
+        return false;
+      }
+      zerror_ = SetDictionary();
+      if (zerror_ != Z_OK) {
+        return false;
+      }
+      continue;
+    }
+    if (error != Z_OK && !(error == Z_BUF_ERROR && zcontext_.avail_out == 0)) {
+      zerror_ = error;
+      return false;
+    }
+    if (zcontext_.avail_out == 0) {
+      output->resize(2 * output->size());
+      continue;
+    }
+    if (zcontext_.avail_in == 0) {
+      // Input ran out before the end-of-stream marker: truncated record.
+      zerror_ = Z_BUF_ERROR;
+      return false;
+    }
+  }
+  if (zcontext_.avail_in != 0) {
+    // Bytes past the end of the stream; records are exactly one stream.
+    zerror_ = Z_DATA_ERROR;
+    return false;
+  }
+  output->resize(total_out);
+  zerror_ = Z_OK;
+  return true;
+}
+
+// =========================================================================
+
 GzipOutputStream::Options::Options()
     : format(GZIP),
       buffer_size(kDefaultBufferSize),
@@ -305,6 +427,211 @@ bool GzipOutputStream::Close() {
   return ok;
 }
 
+// =========================================================================
+
+static const int kDefaultParallelBlockSize = 128 * 1024;
+// A deflate window: the next block may reference up to this many trailing
+// bytes of the previous one through its dictionary.
+static const size_t kDictionarySize = 32 * 1024;
+// Room for the sync flush marker past deflateBound().
+static const size_t kSyncFlushSlop = 16;
+
+// One block compression job, run on its own thread.  Each job compresses an
+// independent raw deflate stream; non-final jobs end with a byte-aligned
+// Z_SYNC_FLUSH and the final one with Z_FINISH, so the concatenation of the
+// outputs is a single valid deflate stream.
+struct ParallelGzipOutputStream::Job {
+  std::string plain;
+  std::string dictionary;
+  int level;
+  bool last;
+
+  std::string compressed;
+  uLong crc;
+  int error;
+  std::thread thread;
+
+  void Run() {
+    z_stream ctx;
+    ctx.zalloc = Z_NULL;
+    ctx.zfree = Z_NULL;
+    ctx.opaque = Z_NULL;
+    ctx.msg = nullptr;
+    // Negative windowBits selects a raw deflate stream with no zlib header
+    // or checksum; the gzip framing is written by the main thread.
+    error = deflateInit2(&ctx, level, Z_DEFLATED, /* windowBits */ -15,
+                         /* memLevel (default) */ 8, Z_DEFAULT_STRATEGY);
+    if (error != Z_OK) return;
+    if (!dictionary.empty()) {
+      error = deflateSetDictionary(
+          &ctx, reinterpret_cast<const Bytef*>(dictionary.data()),
+          dictionary.size());
+      if (error != Z_OK) {
+        deflateEnd(&ctx);
+        return;
+      }
+    }
+    compressed.resize(deflateBound(&ctx, plain.size()) + kSyncFlushSlop);
+    ctx.next_in =
+        reinterpret_cast<Bytef*>(const_cast<char*>(plain.data()));
+    ctx.avail_in = plain.size();
+    ctx.next_out = reinterpret_cast<Bytef*>(&compressed[0]);
+    ctx.avail_out = compressed.size();
+    error = deflate(&ctx, last ? Z_FINISH : Z_SYNC_FLUSH);
+    if (error == (last ? Z_STREAM_END : Z_OK) && ctx.avail_in == 0) {
+      compressed.resize(compressed.size() - ctx.avail_out);
+      error = Z_OK;
+    } else if (error >= 0) {
+      // The output buffer was sized from deflateBound(), so running out of
+      // space (or leftover input) indicates a bug rather than a zlib error.
+      error = Z_BUF_ERROR;
+    }
+    deflateEnd(&ctx);
+    crc = crc32(crc32(0, Z_NULL, 0),
+                reinterpret_cast<const Bytef*>(plain.data()), plain.size());
+  }
+};
+
+ParallelGzipOutputStream::Options::Options()
+    : compression_level(Z_DEFAULT_COMPRESSION),
+      block_size(kDefaultParallelBlockSize),
+      num_threads(static_cast<int>(std::thread::hardware_concurrency())) {}
+
+ParallelGzipOutputStream::ParallelGzipOutputStream(
+    ZeroCopyOutputStream* sub_stream)
+    : ParallelGzipOutputStream(sub_stream, Options()) {}
+
+ParallelGzipOutputStream::ParallelGzipOutputStream(
+    ZeroCopyOutputStream* sub_stream, const Options& options)
+    : sub_stream_(sub_stream),
+      options_(options),
+      zerror_(Z_OK),
+      header_written_(false),
+      closed_(false),
+      block_pos_(0),
+      crc_(crc32(0, Z_NULL, 0)),
+      total_plain_(0),
+      byte_count_(0) {
+  if (options_.block_size <= 0) options_.block_size = kDefaultParallelBlockSize;
+  if (options_.num_threads <= 0) options_.num_threads = 1;
+  block_.resize(options_.block_size);
+}
+
+ParallelGzipOutputStream::~ParallelGzipOutputStream() {
+  Close();
+  // Close() bails out early on error; make sure no worker outlives us.
+  for (std::unique_ptr<Job>& job : jobs_) {
+    if (job->thread.joinable()) job->thread.join();
+  }
+}
+
+bool ParallelGzipOutputStream::WriteToSubStream(const void* data, size_t size) {
+  const char* in = static_cast<const char*>(data);
+  while (size > 0) {
+    void* out;
+    int out_size;
+    if (!sub_stream_->Next(&out, &out_size)) {
+      zerror_ = Z_BUF_ERROR;
+      return false;
+    }
+    ABSL_CHECK_GT(out_size, 0);
+    size_t n = std::min(size, static_cast<size_t>(out_size));
+    memcpy(out, in, n);
+    if (n < static_cast<size_t>(out_size)) {
+      sub_stream_->BackUp(out_size - n);
+    }
+    in += n;
+    size -= n;
+  }
+  return true;
+}
+
+bool ParallelGzipOutputStream::DrainOldestJob() {
+  std::unique_ptr<Job> job = std::move(jobs_.front());
+  jobs_.pop_front();
+  job->thread.join();
+  if (job->error != Z_OK) {
+    zerror_ = job->error;
+    return false;
+  }
+  if (!WriteToSubStream(job->compressed.data(), job->compressed.size())) {
+    return false;
+  }
+  crc_ = crc32_combine(crc_, job->crc, job->plain.size());
+  return true;
+}
+
+bool ParallelGzipOutputStream::SubmitBlock(bool last) {
+  if (!header_written_) {
+    // Minimal gzip header: magic, deflate method, no flags or mtime,
+    // unknown OS.
+    static const unsigned char kGzipHeader[10] = {0x1f, 0x8b, 8, 0, 0,
+                                                  0,    0,    0, 0, 255};
+    if (!WriteToSubStream(kGzipHeader, sizeof(kGzipHeader))) return false;
+    header_written_ = true;
+  }
+  std::unique_ptr<Job> job(new Job);
+  job->plain.assign(block_, 0, block_pos_);
+  job->dictionary = std::move(dictionary_);
+  job->level = options_.compression_level;
+  job->last = last;
+  job->crc = 0;
+  job->error = Z_OK;
+  const size_t dict_size = std::min(block_pos_, kDictionarySize);
+  dictionary_.assign(block_, block_pos_ - dict_size, dict_size);
+  total_plain_ += block_pos_;
+  block_pos_ = 0;
+  Job* raw_job = job.get();
+  jobs_.push_back(std::move(job));
+  raw_job->thread = std::thread([raw_job] { raw_job->Run(); });
+  while (jobs_.size() > static_cast<size_t>(options_.num_threads)) {
+    if (!DrainOldestJob()) return false;
+  }
+  return true;
+}
+
+// implements ZeroCopyOutputStream ---------------------------------
+bool ParallelGzipOutputStream::Next(void** data, int* size) {
+  if (zerror_ != Z_OK || closed_) return false;
+  if (block_pos_ == block_.size()) {
+    if (!SubmitBlock(/*last=*/false)) return false;
+  }
+  *data = &block_[block_pos_];
+  *size = block_.size() - block_pos_;
+  byte_count_ += *size;
+  block_pos_ = block_.size();
+  return true;
+}
+
+void ParallelGzipOutputStream::BackUp(int count) {
+  ABSL_CHECK_GE(block_pos_, static_cast<size_t>(count));
+  block_pos_ -= count;
+  byte_count_ -= count;
+}
+
+int64_t ParallelGzipOutputStream::ByteCount() const { return byte_count_; }
+
+bool ParallelGzipOutputStream::Close() {
+  if (closed_) return zerror_ == Z_OK;
+  if (zerror_ != Z_OK) return false;
+  // The final block carries the Z_FINISH marker even when it is empty.
+  if (!SubmitBlock(/*last=*/true)) return false;
+  while (!jobs_.empty()) {
+    if (!DrainOldestJob()) return false;
+  }
+  // gzip trailer: CRC32 and input size mod 2^32, both little-endian.
+  const uint32_t crc = static_cast<uint32_t>(crc_);
+  const uint32_t isize = static_cast<uint32_t>(total_plain_);
+  unsigned char trailer[8];
+  for (int i = 0; i < 4; ++i) {
+    trailer[i] = static_cast<unsigned char>(crc >> (8 * i));
+    trailer[i + 4] = static_cast<unsigned char>(isize >> (8 * i));
+  }
+  if (!WriteToSubStream(trailer, sizeof(trailer))) return false;
+  closed_ = true;
+  return true;
+}
+
 }  // namespace io
 }  // namespace protobuf
 }  // namespace google
@@ -20,6 +20,11 @@
 #ifndef GOOGLE_PROTOBUF_IO_GZIP_STREAM_H__
 #define GOOGLE_PROTOBUF_IO_GZIP_STREAM_H__
 
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+
 #include "google/protobuf/stubs/common.h"
 #include "google/protobuf/io/zero_copy_stream.h"
 #include "google/protobuf/port.h"
@@ -81,6 +86,75 @@ class PROTOBUF_EXPORT GzipInputStream final : public ZeroCopyInputStream {
   void DoNextOutput(const void** data, int* size);
 };
 
+// Decompresses many small independent records through a single zlib inflate
+// state.  GzipInputStream allocates and initializes a fresh z_stream (and its
+// 32kB window) per stream, which dominates the cost of decompressing records
+// of a few kB; this class keeps one inflate state alive and rewinds it with
+// inflateReset2() between records, and decompresses into a caller-owned
+// string whose capacity is likewise reused across calls.
+//
+// A preset dictionary may be supplied for payloads that share structure
+// (e.g. records of the same schema).  It applies to ZLIB records compressed
+// with deflateSetDictionary() (the stream's FDICT handshake selects it) and
+// to RAW deflate records, where it is installed unconditionally after each
+// reset.  GZIP framing has no dictionary support.
+class PROTOBUF_EXPORT ZlibRecordDecompressor {
+ public:
+  // Format key for constructor.  Unlike GzipInputStream this includes RAW,
+  // since raw deflate is the natural framing for dictionary-compressed
+  // records (there is no per-record header at all).
+  enum Format {
+    // zlib will autodetect gzip header or zlib stream.
+    AUTO = 0,
+
+    // GZIP records have some extra header data for file attributes.
+    GZIP = 1,
+
+    // Simpler zlib stream format.
+    ZLIB = 2,
+
+    // Raw deflate data with no header or checksum.
+    RAW = 3,
+  };
+
+  struct PROTOBUF_EXPORT Options {
+    // Defaults to AUTO.
+    Format format;
+
+    // Preset dictionary, or empty for none.  See the class comment for
+    // which formats support it.
+    std::string dictionary;
+
+    Options();  // Initializes with default values.
+  };
+
+  ZlibRecordDecompressor() : ZlibRecordDecompressor(Options()) {}
+  explicit ZlibRecordDecompressor(const Options& options);
+  ZlibRecordDecompressor(const ZlibRecordDecompressor&) = delete;
+  ZlibRecordDecompressor& operator=(const ZlibRecordDecompressor&) = delete;
+  ~ZlibRecordDecompressor();
+
+  // Decompresses one complete record into *output, replacing its contents
+  // but keeping its allocation for the next call.  The record must be a
+  // whole compressed stream in the configured format; trailing bytes after
+  // the end of the stream are an error, as is a truncated record.
+  // Returns true if no error.
+  bool Decompress(const void* data, size_t size, std::string* output);
+
+  // Return last error message or NULL if no error.
+  inline const char* ZlibErrorMessage() const { return zcontext_.msg; }
+  inline int ZlibErrorCode() const { return zerror_; }
+
+ private:
+  Options options_;
+
+  z_stream zcontext_;
+  int zerror_;
+  bool initialized_;
+
+  int SetDictionary();
+};
+
 class PROTOBUF_EXPORT GzipOutputStream final : public ZeroCopyOutputStream {
  public:
   // Format key for constructor
@@ -170,6 +244,99 @@ class PROTOBUF_EXPORT GzipOutputStream final : public ZeroCopyOutputStream {
   int Deflate(int flush);
 };
 
+// A ZeroCopyOutputStream that compresses fixed-size blocks of its input on
+// multiple threads and concatenates the results into one standard gzip
+// stream, in the style of pigz.  The output is a plain gzip file: it is
+// readable by GzipInputStream, gunzip or any other zlib consumer, so no
+// matching input class is needed.
+//
+// Each block is compressed as an independent raw-deflate job joined to its
+// neighbors with byte-aligned sync flushes; the last 32kB of the previous
+// block is supplied as a dictionary, so the compression ratio stays close to
+// a single-threaded stream.  With large inputs (e.g. serialized snapshots)
+// throughput scales with the number of threads until the underlying stream
+// becomes the bottleneck.
+//
+// Unlike GzipOutputStream there is no incremental Flush(): data reaches the
+// underlying stream in block granularity, and the stream only becomes a
+// complete gzip file once Close() has been called.
+class PROTOBUF_EXPORT ParallelGzipOutputStream final
+    : public ZeroCopyOutputStream {
+ public:
+  struct PROTOBUF_EXPORT Options {
+    // A number between 0 and 9, where 0 is no compression and 9 is best
+    // compression.  Defaults to Z_DEFAULT_COMPRESSION (see zlib.h).
+    int compression_level;
+
+    // Uncompressed bytes handed to each compression job.  Defaults to 128kB.
+    // Larger blocks compress slightly better; smaller blocks start to
+    // parallelize (and reach the underlying stream) sooner.
+    int block_size;
+
+    // Maximum number of blocks compressed concurrently.  Defaults to the
+    // hardware concurrency.
+    int num_threads;
+
+    Options();  // Initializes with default values.
+  };
+
+  // Create a ParallelGzipOutputStream with default options.
+  explicit ParallelGzipOutputStream(ZeroCopyOutputStream* sub_stream);
+
+  // Create a ParallelGzipOutputStream with the given options.
+  ParallelGzipOutputStream(ZeroCopyOutputStream* sub_stream,
+                           const Options& options);
+  ParallelGzipOutputStream(const ParallelGzipOutputStream&) = delete;
+  ParallelGzipOutputStream& operator=(const ParallelGzipOutputStream&) = delete;
+
+  ~ParallelGzipOutputStream() override;
+
+  // Returns the last zlib error code, or Z_OK if no error.
+  inline int ZlibErrorCode() const { return zerror_; }
+
+  // Compresses all pending data, waits for the outstanding jobs and writes
+  // the gzip trailer.  It is the caller's responsibility to close the
+  // underlying stream if necessary.
+  // Returns true if no error.
+  bool Close();
+
+  // implements ZeroCopyOutputStream ---------------------------------
+  bool Next(void** data, int* size) override;
+  void BackUp(int count) override;
+  int64_t ByteCount() const override;
+
+ private:
+  struct Job;
+
+  // Hands the current block (and the dictionary for the one after it) to a
+  // worker thread, draining finished jobs if the pool is full.
+  bool SubmitBlock(bool last);
+  // Joins the oldest job and writes its output to the underlying stream.
+  bool DrainOldestJob();
+  bool WriteToSubStream(const void* data, size_t size);
+
+  ZeroCopyOutputStream* sub_stream_;
+  Options options_;
+  int zerror_;
+  bool header_written_;
+  bool closed_;
+
+  // Staging buffer for the block currently being filled by the caller.
+  std::string block_;
+  size_t block_pos_;
+  // Tail of the previously submitted block, used as the next job's
+  // dictionary.
+  std::string dictionary_;
+
+  // Jobs in submission order; the front is always the next one to be
+  // written.
+  std::deque<std::unique_ptr<Job>> jobs_;
+
+  uLong crc_;            // combined CRC32 of all submitted blocks
+  int64_t total_plain_;  // bytes submitted to jobs
+  int64_t byte_count_;   // bytes written by the caller
+};
+
 }  // namespace io
 }  // namespace protobuf
 }  // namespace google
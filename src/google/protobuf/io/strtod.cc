@@ -17,10 +17,19 @@
 #include <string>
 #include <system_error>  // NOLINT(build/c++11)
 
+#if defined(__has_include)
+#if __has_include(<charconv>) &&                       \
+    (__cplusplus >= 201703L ||                         \
+     (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L))
+#include <charconv>
+#endif
+#endif
+
 #include "absl/log/absl_check.h"
 #include "absl/strings/charconv.h"
 #include "absl/strings/numbers.h"
 #include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
 
 namespace google {
 namespace protobuf {
@@ -76,6 +85,25 @@ double NoLocaleStrtod(const char *str, char **endptr) {
   return ret;
 }
 
+size_t ParseDoublePrefix(absl::string_view token, double *value) {
+  double ret = 0.0;
+  auto result = absl::from_chars(token.data(), token.data() + token.size(), ret);
+  if (result.ec == std::errc::result_out_of_range) {
+    // See NoLocaleStrtod() above: match SimpleAtod and return infinity
+    // rather than max() on overflow.
+    if (ret > 1.0) {
+      ret = std::numeric_limits<double>::infinity();
+    } else if (ret < -1.0) {
+      ret = -std::numeric_limits<double>::infinity();
+    }
+  } else if (result.ec != std::errc()) {
+    *value = 0.0;
+    return 0;
+  }
+  *value = ret;
+  return static_cast<size_t>(result.ptr - token.data());
+}
+
 // ----------------------------------------------------------------------
 // SimpleDtoa()
 // SimpleFtoa()
@@ -116,12 +144,18 @@ double NoLocaleStrtod(const char *str, char **endptr) {
 // ----------------------------------------------------------------------
 
 namespace {
-// In practice, doubles should never need more than 24 bytes and floats
-// should never need more than 14 (including null terminators), but we
-// overestimate to be safe.
-constexpr int kDoubleToBufferSize = 32;
-constexpr int kFloatToBufferSize = 24;
-
+// Where the standard library implements floating-point std::to_chars, use it
+// to produce the "%.*g" representations below.  It emits exactly the printf
+// output for the given precision but is substantially faster (no format
+// string parsing, no locale lookup) and always uses '.' as the radix, so no
+// DelocalizeRadix() fixup is needed.  The overall strategy -- try a never
+// over-precise precision, verify it round-trips, retry with full precision --
+// is unchanged, keeping the printed text byte-identical to the snprintf path.
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+#define PROTOBUF_HAS_FLOAT_TO_CHARS 1
+#endif
+
+#ifndef PROTOBUF_HAS_FLOAT_TO_CHARS
 inline bool IsValidFloatChar(char c) {
   return ('0' <= c && c <= '9') || c == 'e' || c == 'E' || c == '+' || c == '-';
 }
@@ -161,6 +195,8 @@ bool safe_strtof(const char *str, float *value) {
   *value = strtof(str, &endptr);
   return *str != 0 && *endptr == 0 && errno == 0;
 }
+#endif  // !PROTOBUF_HAS_FLOAT_TO_CHARS
+}  // namespace
 
 char *FloatToBuffer(float value, char *buffer) {
   // FLT_DIG is 6 for IEEE-754 floats, which are used on almost all
@@ -180,6 +216,23 @@ char *FloatToBuffer(float value, char *buffer) {
     return buffer;
   }
 
+#ifdef PROTOBUF_HAS_FLOAT_TO_CHARS
+  std::to_chars_result result = std::to_chars(
+      buffer, buffer + kFloatToBufferSize - 1, value,
+      std::chars_format::general, FLT_DIG);
+  ABSL_DCHECK(result.ec == std::errc());
+  *result.ptr = '\0';
+
+  float parsed_value;
+  if (absl::from_chars(buffer, result.ptr, parsed_value).ec != std::errc() ||
+      parsed_value != value) {
+    result = std::to_chars(buffer, buffer + kFloatToBufferSize - 1, value,
+                           std::chars_format::general, FLT_DIG + 3);
+    ABSL_DCHECK(result.ec == std::errc());
+    *result.ptr = '\0';
+  }
+  return buffer;
+#else
   int snprintf_result =
       absl::SNPrintF(buffer, kFloatToBufferSize, "%.*g", FLT_DIG, value);
 
@@ -198,6 +251,7 @@ char *FloatToBuffer(float value, char *buffer) {
 
   DelocalizeRadix(buffer);
   return buffer;
+#endif  // PROTOBUF_HAS_FLOAT_TO_CHARS
 }
 
 char *DoubleToBuffer(double value, char *buffer) {
@@ -218,6 +272,23 @@ char *DoubleToBuffer(double value, char *buffer) {
     return buffer;
   }
 
+#ifdef PROTOBUF_HAS_FLOAT_TO_CHARS
+  std::to_chars_result result = std::to_chars(
+      buffer, buffer + kDoubleToBufferSize - 1, value,
+      std::chars_format::general, DBL_DIG);
+  ABSL_DCHECK(result.ec == std::errc());
+  *result.ptr = '\0';
+
+  double parsed_value;
+  if (absl::from_chars(buffer, result.ptr, parsed_value).ec != std::errc() ||
+      parsed_value != value) {
+    result = std::to_chars(buffer, buffer + kDoubleToBufferSize - 1, value,
+                           std::chars_format::general, DBL_DIG + 2);
+    ABSL_DCHECK(result.ec == std::errc());
+    *result.ptr = '\0';
+  }
+  return buffer;
+#else
   int snprintf_result =
       absl::SNPrintF(buffer, kDoubleToBufferSize, "%.*g", DBL_DIG, value);
 
@@ -242,8 +313,8 @@ char *DoubleToBuffer(double value, char *buffer) {
 
   DelocalizeRadix(buffer);
   return buffer;
+#endif  // PROTOBUF_HAS_FLOAT_TO_CHARS
 }
-}  // namespace
 
 std::string SimpleDtoa(double value) {
   char buffer[kDoubleToBufferSize];
@@ -12,8 +12,12 @@
 #ifndef GOOGLE_PROTOBUF_IO_STRTOD_H__
 #define GOOGLE_PROTOBUF_IO_STRTOD_H__
 
+#include <cstddef>
 #include <string>
 
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+
 // Must be included last.
 #include "google/protobuf/port_def.inc"
 
@@ -35,15 +39,86 @@ namespace io {
 PROTOBUF_EXPORT std::string SimpleDtoa(double value);
 PROTOBUF_EXPORT std::string SimpleFtoa(float value);
 
+// Buffer sizes required by DoubleToBuffer() and FloatToBuffer() below.  In
+// practice, doubles should never need more than 24 bytes and floats should
+// never need more than 14 (including null terminators), but we overestimate
+// to be safe.
+constexpr int kDoubleToBufferSize = 32;
+constexpr int kFloatToBufferSize = 24;
+
+// In-place equivalents of SimpleDtoa()/SimpleFtoa() for callers that cannot
+// afford a std::string allocation per conversion.  `buffer` must have room
+// for at least kDoubleToBufferSize (resp. kFloatToBufferSize) bytes; the
+// NUL-terminated result is written into it and `buffer` is returned.
+PROTOBUF_EXPORT char* DoubleToBuffer(double value, char* buffer);
+PROTOBUF_EXPORT char* FloatToBuffer(float value, char* buffer);
+
 // A locale-independent version of the standard strtod(), which always
 // uses a dot as the decimal separator.
 PROTOBUF_EXPORT double NoLocaleStrtod(const char* str, char** endptr);
 
+// A bounded counterpart of NoLocaleStrtod() for tokens that are not
+// NUL-terminated.  Parses the longest valid double prefix of `token` and
+// returns its length in bytes (zero if the token does not start with a
+// number), storing the value in `*value`.  Values out of range are mapped
+// to +/-infinity, as NoLocaleStrtod() does.  Unlike NoLocaleStrtod() this
+// never scans past the token for a terminator, so it is the right entry
+// point for converting many tokens picked out of a larger buffer.
+PROTOBUF_EXPORT size_t ParseDoublePrefix(absl::string_view token,
+                                         double* value);
+
+// Batch conversion of numeric tokens, for parsers that have already split
+// a numeric array into individual tokens.  Each token must be exactly one
+// double literal; space for all values is reserved up front and the
+// conversions run in one tight loop, amortizing the per-call overhead of
+// the single-value entry points.  On the first malformed token the
+// function returns false; values converted before it remain appended.
+//
+// `output` needs the RepeatedField protocol -- size(), Reserve() and
+// Add() -- so RepeatedField<double> and RepeatedField<float> both work
+// without this low-level header depending on them.  ParseFloatArray()
+// narrows through SafeDoubleToFloat(), mapping values out of float range
+// to +/-infinity.
+template <typename Container>
+bool ParseDoubleArray(absl::Span<const absl::string_view> tokens,
+                      Container* output);
+template <typename Container>
+bool ParseFloatArray(absl::Span<const absl::string_view> tokens,
+                     Container* output);
+
 // Casts a double value to a float value. If the value is outside of the
 // representable range of float, it will be converted to positive or negative
 // infinity.
 PROTOBUF_EXPORT float SafeDoubleToFloat(double value);
 
+template <typename Container>
+bool ParseDoubleArray(absl::Span<const absl::string_view> tokens,
+                      Container* output) {
+  output->Reserve(output->size() + static_cast<int>(tokens.size()));
+  for (const absl::string_view token : tokens) {
+    double value;
+    if (token.empty() || ParseDoublePrefix(token, &value) != token.size()) {
+      return false;
+    }
+    output->Add(value);
+  }
+  return true;
+}
+
+template <typename Container>
+bool ParseFloatArray(absl::Span<const absl::string_view> tokens,
+                     Container* output) {
+  output->Reserve(output->size() + static_cast<int>(tokens.size()));
+  for (const absl::string_view token : tokens) {
+    double value;
+    if (token.empty() || ParseDoublePrefix(token, &value) != token.size()) {
+      return false;
+    }
+    output->Add(SafeDoubleToFloat(value));
+  }
+  return true;
+}
+
 }  // namespace io
 }  // namespace protobuf
 }  // namespace google
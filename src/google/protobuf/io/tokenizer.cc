@@ -67,6 +67,8 @@
 
 #include "google/protobuf/io/tokenizer.h"
 
+#include <cstring>
+
 #include "google/protobuf/stubs/common.h"
 #include "absl/log/absl_check.h"
 #include "absl/log/absl_log.h"
@@ -264,6 +266,25 @@ void Tokenizer::NextChar() {
   }
 }
 
+void Tokenizer::AdvancePastRun(const char* run_end) {
+  const char* start = buffer_ + buffer_pos_;
+  // The run contains no newlines, so only tabs complicate the column
+  // bookkeeping; runs without them advance the column in one add.
+  if (memchr(start, '\t', run_end - start) == nullptr) {
+    column_ += static_cast<ColumnNumber>(run_end - start);
+  } else {
+    for (const char* p = start; p != run_end; ++p) {
+      column_ += *p == '\t' ? kTabWidth - column_ % kTabWidth : 1;
+    }
+  }
+  buffer_pos_ = static_cast<int>(run_end - buffer_);
+  if (buffer_pos_ < buffer_size_) {
+    current_char_ = *run_end;
+  } else {
+    Refresh();
+  }
+}
+
 void Tokenizer::Refresh() {
   if (read_error_) {
     current_char_ = '\0';
@@ -355,8 +376,34 @@ inline bool Tokenizer::TryConsume(char c) {
 
 template <typename CharacterClass>
 inline void Tokenizer::ConsumeZeroOrMore() {
+  // Consume each in-buffer run with a single scan instead of per-character
+  // NextChar() bookkeeping.  Note that whenever current_char_ is in a class,
+  // buffer_pos_ < buffer_size_, since '\0' belongs to no class.
   while (CharacterClass::InClass(current_char_)) {
-    NextChar();
+    const char* limit = buffer_ + buffer_size_;
+    const char* p = buffer_ + buffer_pos_ + 1;
+    while (p < limit && CharacterClass::InClass(*p)) ++p;
+    if (CharacterClass::InClass('\n')) {
+      // Only the Whitespace class reaches here; line numbers must track.
+      for (const char* q = buffer_ + buffer_pos_; q != p; ++q) {
+        if (*q == '\n') {
+          ++line_;
+          column_ = 0;
+        } else if (*q == '\t') {
+          column_ += kTabWidth - column_ % kTabWidth;
+        } else {
+          ++column_;
+        }
+      }
+      buffer_pos_ = static_cast<int>(p - buffer_);
+      if (buffer_pos_ < buffer_size_) {
+        current_char_ = *p;
+      } else {
+        Refresh();
+      }
+    } else {
+      AdvancePastRun(p);
+    }
   }
 }
 
@@ -365,9 +412,8 @@ inline void Tokenizer::ConsumeOneOrMore(const char* error) {
   if (!CharacterClass::InClass(current_char_)) {
     AddError(error);
   } else {
-    do {
-      NextChar();
-    } while (CharacterClass::InClass(current_char_));
+    NextChar();
+    ConsumeZeroOrMore<CharacterClass>();
   }
 }
 
@@ -377,6 +423,22 @@ inline void Tokenizer::ConsumeOneOrMore(const char* error) {
 
 void Tokenizer::ConsumeString(char delimiter) {
   while (true) {
+    // Skip the longest run of ordinary characters in the current buffer in
+    // one scan; the switch below only has to look at the character that
+    // ended the run.  '\0' is included so that an embedded NUL is still
+    // reported as end of string.
+    if (buffer_pos_ < buffer_size_) {
+      const char* limit = buffer_ + buffer_size_;
+      const char* p = buffer_ + buffer_pos_;
+      while (p < limit && *p != delimiter && *p != '\\' && *p != '\n' &&
+             *p != '\0') {
+        ++p;
+      }
+      if (p != buffer_ + buffer_pos_) {
+        AdvancePastRun(p);
+        continue;
+      }
+    }
     switch (current_char_) {
       case '\0':
         AddError("Unexpected end of string.");
@@ -499,7 +561,12 @@ void Tokenizer::ConsumeLineComment(std::string* content) {
   if (content != NULL) RecordTo(content);
 
   while (current_char_ != '\0' && current_char_ != '\n') {
-    NextChar();
+    // Scan to the end of line (or an embedded NUL, which the loop condition
+    // treats as end of input) within the current buffer in one pass.
+    const char* limit = buffer_ + buffer_size_;
+    const char* p = buffer_ + buffer_pos_;
+    while (p < limit && *p != '\n' && *p != '\0') ++p;
+    AdvancePastRun(p);
   }
   TryConsume('\n');
 
@@ -1024,8 +1091,8 @@ double Tokenizer::ParseFloat(const std::string& text) {
 
 bool Tokenizer::TryParseFloat(const std::string& text, double* result) {
   const char* start = text.c_str();
-  char* end;
-  *result = NoLocaleStrtod(start, &end);
+  // The bounded parse never rescans the token for a NUL terminator.
+  const char* end = start + ParseDoublePrefix(text, result);
 
   // "1e" is not a valid float, but if the tokenizer reads it, it will
   // report an error but still return it as a valid token.  We need to
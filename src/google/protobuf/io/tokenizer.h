@@ -304,6 +304,12 @@ class PROTOBUF_EXPORT Tokenizer {
   // Consume this character and advance to the next one.
   void NextChar();
 
+  // Consume every character of the run [buffer_ + buffer_pos_, run_end),
+  // which must not contain '\n', in one step.  This is the bulk equivalent
+  // of calling NextChar() once per character; the buffer is refreshed if
+  // the run extends to its end.
+  void AdvancePastRun(const char* run_end);
+
   // Read a new buffer from the input.
   void Refresh();
 
@@ -367,6 +367,16 @@ MultiTokenCase kMultiTokenCases[] = {
          {Tokenizer::TYPE_END, "", 0, 17, 17},
      }},
 
+    // Test that tabs inside whitespace and string literals advance the
+    // column to the next multiple of the tab width.
+    {"\tfoo\t'ba\tr'\n42",
+     {
+         {Tokenizer::TYPE_IDENTIFIER, "foo", 0, 8, 11},
+         {Tokenizer::TYPE_STRING, "'ba\tr'", 0, 16, 26},
+         {Tokenizer::TYPE_INTEGER, "42", 1, 0, 2},
+         {Tokenizer::TYPE_END, "", 1, 2, 2},
+     }},
+
     // Test that consecutive symbols are parsed as separate tokens.
     {"!@+%",
      {
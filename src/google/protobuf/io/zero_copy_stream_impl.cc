@@ -26,6 +26,11 @@
 #include "google/protobuf/io/io_win32.h"
 #include "google/protobuf/io/zero_copy_stream_impl.h"
 
+#if defined(GOOGLE_PROTOBUF_IO_HAVE_MMAP_INPUT_STREAM) || \
+    defined(GOOGLE_PROTOBUF_IO_HAVE_VM_OUTPUT_STREAM)
+#include <sys/mman.h>
+#endif
+
 
 namespace google {
 namespace protobuf {
@@ -147,6 +152,299 @@ int FileInputStream::CopyingFileInputStream::Skip(int count) {
 
 // ===================================================================
 
+#ifdef GOOGLE_PROTOBUF_IO_HAVE_MMAP_INPUT_STREAM
+
+namespace {
+
+// Default Next() chunk size for MmapInputStream. Large chunks let
+// EpsCopyInputStream parse directly out of the mapping with few buffer
+// flips, while keeping the int size contract of Next() comfortable for
+// multi-GB files.
+constexpr int kDefaultMmapBlockSize = 8 << 20;  // 8 MiB
+
+}  // namespace
+
+MmapInputStream::MmapInputStream(int file_descriptor, int block_size)
+    : block_size_(block_size > 0 ? block_size : kDefaultMmapBlockSize) {
+  struct stat st;
+  if (fstat(file_descriptor, &st) < 0) {
+    errno_ = errno;
+    return;
+  }
+  size_ = static_cast<int64_t>(st.st_size);
+  if (size_ == 0) return;  // Empty file: open, immediately at EOF.
+  void* map = mmap(nullptr, static_cast<size_t>(size_), PROT_READ, MAP_PRIVATE,
+                   file_descriptor, 0);
+  if (map == MAP_FAILED) {
+    errno_ = errno;
+    size_ = 0;
+    return;
+  }
+  data_ = static_cast<const char*>(map);
+  // We always consume the file front to back; let the kernel read ahead
+  // aggressively and drop pages behind the cursor.
+  madvise(map, static_cast<size_t>(size_), MADV_SEQUENTIAL);
+}
+
+MmapInputStream::~MmapInputStream() {
+  if (data_ != nullptr) {
+    munmap(const_cast<char*>(data_), static_cast<size_t>(size_));
+  }
+}
+
+bool MmapInputStream::Next(const void** data, int* size) {
+  if (errno_ != 0 || position_ >= size_) return false;
+  const int64_t chunk = std::min<int64_t>(block_size_, size_ - position_);
+  *data = data_ + position_;
+  *size = static_cast<int>(chunk);
+  position_ += chunk;
+  // Ask for the chunk after the one just handed out, so the kernel faults it
+  // in while the caller is still parsing.
+  if (position_ < size_) {
+    const int64_t prefetch = std::min<int64_t>(block_size_, size_ - position_);
+    const size_t page_mask = static_cast<size_t>(sysconf(_SC_PAGESIZE)) - 1;
+    const char* start = data_ + (static_cast<size_t>(position_) & ~page_mask);
+    madvise(const_cast<char*>(start),
+            static_cast<size_t>(data_ + position_ + prefetch - start),
+            MADV_WILLNEED);
+  }
+  return true;
+}
+
+void MmapInputStream::BackUp(int count) {
+  ABSL_CHECK_GE(count, 0);
+  ABSL_CHECK_LE(static_cast<int64_t>(count), position_);
+  position_ -= count;
+}
+
+bool MmapInputStream::Skip(int count) {
+  ABSL_CHECK_GE(count, 0);
+  if (errno_ != 0) return false;
+  if (count > size_ - position_) {
+    position_ = size_;
+    return false;
+  }
+  position_ += count;
+  return true;
+}
+
+int64_t MmapInputStream::ByteCount() const { return position_; }
+
+#endif  // GOOGLE_PROTOBUF_IO_HAVE_MMAP_INPUT_STREAM
+
+// ===================================================================
+
+#ifdef GOOGLE_PROTOBUF_IO_HAVE_NONBLOCKING_INPUT_STREAM
+
+namespace {
+
+// Default Next() chunk size for NonBlockingFdInputStream; matches the
+// Copying{In,Out}putStreamAdaptor default.
+constexpr int kDefaultNonBlockingBlockSize = 8192;
+
+}  // namespace
+
+NonBlockingFdInputStream::NonBlockingFdInputStream(int file_descriptor,
+                                                   int block_size)
+    : file_(file_descriptor),
+      block_size_(block_size > 0 ? block_size : kDefaultNonBlockingBlockSize),
+      buffer_(new uint8_t[block_size_]) {}
+
+NonBlockingFdInputStream::~NonBlockingFdInputStream() {
+  if (close_on_delete_) {
+    if (!Close()) {
+      ABSL_LOG(ERROR) << "close() failed: " << strerror(errno_);
+    }
+  }
+}
+
+bool NonBlockingFdInputStream::Close() {
+  ABSL_CHECK(!is_closed_);
+
+  is_closed_ = true;
+  if (close_no_eintr(file_) != 0) {
+    errno_ = errno;
+    return false;
+  }
+
+  return true;
+}
+
+int NonBlockingFdInputStream::ReadOnce() {
+  ABSL_CHECK(!is_closed_);
+
+  int result;
+  do {
+    result = read(file_, buffer_.get(), block_size_);
+  } while (result < 0 && errno == EINTR);
+
+  if (result > 0) {
+    buffer_used_ = result;
+    position_ += result;
+    return result;
+  }
+  if (result == 0) {
+    eof_ = true;
+  } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+    would_block_ = true;
+    if (readiness_callback_) {
+      readiness_callback_(file_);
+    }
+  } else {
+    errno_ = errno;
+  }
+  return -1;
+}
+
+bool NonBlockingFdInputStream::Next(const void** data, int* size) {
+  would_block_ = false;
+  if (backup_bytes_ > 0) {
+    *data = buffer_.get() + buffer_used_ - backup_bytes_;
+    *size = backup_bytes_;
+    backup_bytes_ = 0;
+    return true;
+  }
+  if (errno_ != 0 || eof_) return false;
+  if (ReadOnce() < 0) return false;
+  *data = buffer_.get();
+  *size = buffer_used_;
+  return true;
+}
+
+void NonBlockingFdInputStream::BackUp(int count) {
+  ABSL_CHECK(backup_bytes_ == 0)
+      << " BackUp() can only be called after Next().";
+  ABSL_CHECK_LE(count, buffer_used_)
+      << " Can't back up over more bytes than were returned by the last call"
+         " to Next().";
+  ABSL_CHECK_GE(count, 0) << " Parameter to BackUp() can't be negative.";
+
+  backup_bytes_ = count;
+}
+
+bool NonBlockingFdInputStream::Skip(int count) {
+  ABSL_CHECK_GE(count, 0);
+
+  would_block_ = false;
+  const int from_backup = std::min(count, backup_bytes_);
+  backup_bytes_ -= from_backup;
+  count -= from_backup;
+  while (count > 0) {
+    if (errno_ != 0 || eof_) return false;
+    if (ReadOnce() < 0) return false;
+    if (buffer_used_ > count) {
+      // Read past the skip target; hand the remainder to the next Next().
+      backup_bytes_ = buffer_used_ - count;
+      return true;
+    }
+    count -= buffer_used_;
+  }
+  return true;
+}
+
+int64_t NonBlockingFdInputStream::ByteCount() const {
+  return position_ - backup_bytes_;
+}
+
+#endif  // GOOGLE_PROTOBUF_IO_HAVE_NONBLOCKING_INPUT_STREAM
+
+// ===================================================================
+
+#ifdef GOOGLE_PROTOBUF_IO_HAVE_VM_OUTPUT_STREAM
+
+// BSD-derived systems spell MAP_ANONYMOUS as MAP_ANON and have no
+// MAP_NORESERVE (their anonymous mappings are already reserve-free).
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE 0
+#endif
+
+namespace {
+
+// Default address-space reservation for VirtualMemoryOutputStream.  Reserved
+// pages cost no physical memory until written, so on 64-bit targets the
+// default leans large enough that typical snapshots never need to grow.
+constexpr int64_t kDefaultVmReservation =
+    sizeof(void*) >= 8 ? (int64_t{1} << 32)   // 4 GiB
+                       : (int64_t{1} << 28);  // 256 MiB
+
+// Default Next() chunk size; matches MmapInputStream.  Pages are committed
+// on first write regardless of the chunk size, so this only bounds how much
+// a writer can run past the end of the output before BackUp().
+constexpr int kDefaultVmBlockSize = 8 << 20;  // 8 MiB
+
+}  // namespace
+
+VirtualMemoryOutputStream::VirtualMemoryOutputStream(int64_t reserved_size,
+                                                     int block_size)
+    : block_size_(block_size > 0 ? block_size : kDefaultVmBlockSize) {
+  reserved_ = reserved_size > 0 ? reserved_size : kDefaultVmReservation;
+  // MAP_NORESERVE asks for address space only; the kernel commits pages as
+  // they are first written.
+  void* map = mmap(nullptr, static_cast<size_t>(reserved_),
+                   PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (map == MAP_FAILED) {
+    errno_ = errno;
+    reserved_ = 0;
+    return;
+  }
+  data_ = static_cast<char*>(map);
+}
+
+VirtualMemoryOutputStream::~VirtualMemoryOutputStream() {
+  if (data_ != nullptr) {
+    munmap(data_, static_cast<size_t>(reserved_));
+  }
+}
+
+bool VirtualMemoryOutputStream::Grow() {
+#ifdef __linux__
+  // mremap() doubles the reservation by remapping pages, never copying
+  // them.  The mapping may move, which is why data() is only stable once
+  // writing is finished.
+  const int64_t new_reserved = reserved_ * 2;
+  void* map = mremap(data_, static_cast<size_t>(reserved_),
+                     static_cast<size_t>(new_reserved), MREMAP_MAYMOVE);
+  if (map == MAP_FAILED) {
+    errno_ = errno;
+    return false;
+  }
+  data_ = static_cast<char*>(map);
+  reserved_ = new_reserved;
+  return true;
+#else
+  // Without mremap() the reservation is a hard cap; report the same error
+  // mmap() would for an exhausted address space.
+  errno_ = ENOMEM;
+  return false;
+#endif
+}
+
+bool VirtualMemoryOutputStream::Next(void** data, int* size) {
+  if (errno_ != 0) return false;
+  if (position_ == reserved_ && !Grow()) return false;
+  const int64_t chunk = std::min<int64_t>(block_size_, reserved_ - position_);
+  *data = data_ + position_;
+  *size = static_cast<int>(chunk);
+  position_ += chunk;
+  return true;
+}
+
+void VirtualMemoryOutputStream::BackUp(int count) {
+  ABSL_CHECK_GE(count, 0);
+  ABSL_CHECK_LE(static_cast<int64_t>(count), position_);
+  position_ -= count;
+}
+
+int64_t VirtualMemoryOutputStream::ByteCount() const { return position_; }
+
+#endif  // GOOGLE_PROTOBUF_IO_HAVE_VM_OUTPUT_STREAM
+
+// ===================================================================
+
 FileOutputStream::FileOutputStream(int file_descriptor, int block_size)
     : CopyingOutputStreamAdaptor(&copying_output_, block_size),
       copying_output_(file_descriptor) {}
@@ -225,6 +523,202 @@ bool FileOutputStream::CopyingFileOutputStream::Write(const void* buffer,
 
 // ===================================================================
 
+namespace {
+
+// Larger than CopyingOutputStreamAdaptor's default buffer: each handoff to
+// the writer thread has synchronization cost, and bigger writes keep the
+// disk busy while the next buffer is encoded.
+const int kDefaultAsyncBufferSize = 65536;
+
+}  // namespace
+
+AsyncFileOutputStream::AsyncFileOutputStream(int file_descriptor,
+                                             int buffer_size)
+    : copying_output_(file_descriptor),
+      buffer_size_(buffer_size > 0 ? buffer_size : kDefaultAsyncBufferSize) {
+  buffers_[0].reset(new uint8_t[buffer_size_]);
+  buffers_[1].reset(new uint8_t[buffer_size_]);
+  writer_ = std::thread(&AsyncFileOutputStream::WriterLoop, this);
+}
+
+AsyncFileOutputStream::~AsyncFileOutputStream() {
+  Flush();
+  {
+    absl::MutexLock lock(&mu_);
+    shutdown_ = true;
+  }
+  writer_.join();
+}
+
+void AsyncFileOutputStream::WriterLoop() {
+  mu_.Lock();
+  while (true) {
+    mu_.Await(absl::Condition(this, &AsyncFileOutputStream::WriterHasWork));
+    if (pending_data_ == nullptr) break;  // shutdown_ with nothing queued
+    const uint8_t* data = pending_data_;
+    const int size = pending_size_;
+    mu_.Unlock();
+    const bool ok = copying_output_.Write(data, size);
+    mu_.Lock();
+    if (!ok) failed_ = true;
+    pending_data_ = nullptr;
+  }
+  mu_.Unlock();
+}
+
+bool AsyncFileOutputStream::SubmitBuffer() {
+  absl::MutexLock lock(&mu_);
+  mu_.Await(absl::Condition(this, &AsyncFileOutputStream::WriterIdle));
+  if (failed_) return false;
+  if (buffer_used_ > 0) {
+    pending_data_ = buffers_[current_].get();
+    pending_size_ = buffer_used_;
+    current_ ^= 1;
+    buffer_used_ = 0;
+  }
+  return true;
+}
+
+bool AsyncFileOutputStream::Flush() {
+  if (!SubmitBuffer()) return false;
+  absl::MutexLock lock(&mu_);
+  mu_.Await(absl::Condition(this, &AsyncFileOutputStream::WriterIdle));
+  return !failed_;
+}
+
+bool AsyncFileOutputStream::Close() {
+  bool flush_succeeded = Flush();
+  return copying_output_.Close() && flush_succeeded;
+}
+
+bool AsyncFileOutputStream::Next(void** data, int* size) {
+  if (buffer_used_ == buffer_size_ && !SubmitBuffer()) return false;
+  *data = buffers_[current_].get() + buffer_used_;
+  *size = buffer_size_ - buffer_used_;
+  byte_count_ += *size;
+  buffer_used_ = buffer_size_;
+  return true;
+}
+
+void AsyncFileOutputStream::BackUp(int count) {
+  ABSL_CHECK_GE(count, 0);
+  ABSL_CHECK_LE(count, buffer_used_);
+  buffer_used_ -= count;
+  byte_count_ -= count;
+}
+
+int64_t AsyncFileOutputStream::ByteCount() const { return byte_count_; }
+
+// ===================================================================
+
+AsyncFileInputStream::AsyncFileInputStream(int file_descriptor,
+                                           int buffer_size)
+    : copying_input_(file_descriptor),
+      buffer_size_(buffer_size > 0 ? buffer_size : kDefaultAsyncBufferSize) {
+  buffers_[0].reset(new uint8_t[buffer_size_]);
+  buffers_[1].reset(new uint8_t[buffer_size_]);
+  reader_ = std::thread(&AsyncFileInputStream::ReaderLoop, this);
+  // Start filling immediately; the first Next() only has to wait for the
+  // read, not issue it.
+  RequestFetch(fetch_index_);
+}
+
+AsyncFileInputStream::~AsyncFileInputStream() {
+  {
+    absl::MutexLock lock(&mu_);
+    shutdown_ = true;
+  }
+  reader_.join();
+}
+
+void AsyncFileInputStream::ReaderLoop() {
+  mu_.Lock();
+  while (true) {
+    mu_.Await(absl::Condition(this, &AsyncFileInputStream::ReaderHasWork));
+    if (pending_buffer_ == nullptr) break;  // shutdown_ with nothing queued
+    uint8_t* buffer = pending_buffer_;
+    mu_.Unlock();
+    const int result = copying_input_.Read(buffer, buffer_size_);
+    mu_.Lock();
+    fetched_size_ = result;
+    pending_buffer_ = nullptr;
+  }
+  mu_.Unlock();
+}
+
+void AsyncFileInputStream::RequestFetch(int buffer_index) {
+  absl::MutexLock lock(&mu_);
+  pending_buffer_ = buffers_[buffer_index].get();
+}
+
+int AsyncFileInputStream::WaitForFetch() {
+  absl::MutexLock lock(&mu_);
+  mu_.Await(absl::Condition(this, &AsyncFileInputStream::ReaderIdle));
+  return fetched_size_;
+}
+
+bool AsyncFileInputStream::Close() {
+  // Let an in-flight read drain before closing the descriptor under it.
+  WaitForFetch();
+  eof_ = true;
+  return copying_input_.Close() && !failed_;
+}
+
+bool AsyncFileInputStream::Next(const void** data, int* size) {
+  if (failed_ || eof_) return false;
+  if (position_ == limit_) {
+    // Current buffer drained: take the prefetched one and send the drained
+    // buffer back out for the read after that.
+    const int fetched = WaitForFetch();
+    if (fetched < 0) {
+      failed_ = true;
+      return false;
+    }
+    if (fetched == 0) {
+      eof_ = true;
+      return false;
+    }
+    current_ = fetch_index_;
+    fetch_index_ ^= 1;
+    RequestFetch(fetch_index_);
+    position_ = 0;
+    limit_ = fetched;
+  }
+  *data = buffers_[current_].get() + position_;
+  *size = limit_ - position_;
+  byte_count_ += *size;
+  position_ = limit_;
+  return true;
+}
+
+void AsyncFileInputStream::BackUp(int count) {
+  ABSL_CHECK_GE(count, 0);
+  ABSL_CHECK_LE(count, position_);
+  position_ -= count;
+  byte_count_ -= count;
+}
+
+bool AsyncFileInputStream::Skip(int count) {
+  ABSL_CHECK_GE(count, 0);
+  // The buffer being skipped over is usually already read (that is the
+  // point of the stream), so skipping via Next() costs no extra I/O.
+  const void* data;
+  int size;
+  while (count > 0) {
+    if (!Next(&data, &size)) return false;
+    if (size > count) {
+      BackUp(size - count);
+      return true;
+    }
+    count -= size;
+  }
+  return true;
+}
+
+int64_t AsyncFileInputStream::ByteCount() const { return byte_count_; }
+
+// ===================================================================
+
 IstreamInputStream::IstreamInputStream(std::istream* input, int block_size)
     : copying_input_(input), impl_(&copying_input_, block_size) {}
 
@@ -17,9 +17,15 @@
 #ifndef GOOGLE_PROTOBUF_IO_ZERO_COPY_STREAM_IMPL_H__
 #define GOOGLE_PROTOBUF_IO_ZERO_COPY_STREAM_IMPL_H__
 
+#include <functional>
 #include <iosfwd>
+#include <memory>
 #include <string>
+#include <thread>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "google/protobuf/stubs/common.h"
 #include "google/protobuf/io/zero_copy_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl_lite.h"
@@ -106,8 +112,308 @@ class PROTOBUF_EXPORT FileInputStream final : public ZeroCopyInputStream {
 
   CopyingFileInputStream copying_input_;
   CopyingInputStreamAdaptor impl_;
+
+  friend class AsyncFileInputStream;  // Reuses CopyingFileInputStream.
+};
+
+// ===================================================================
+
+// A ZeroCopyInputStream which reads from a file descriptor on a background
+// thread, so parsing overlaps with disk I/O instead of stalling on blocking
+// read() calls.  This is the input-side counterpart of
+// AsyncFileOutputStream.
+//
+// The stream double-buffers: while the parser drains one buffer through
+// Next(), the reader thread fills the other, so by the time a buffer is
+// consumed the next one is usually already resident.  Unlike the
+// POSIX-only MmapInputStream, this works on every platform with threads --
+// in particular on Windows, where the synchronous read() shim otherwise
+// leaves the parser idle for the full duration of each disk read.  For
+// streams that are purely CPU-bound or purely disk-bound, plain
+// FileInputStream performs the same with one less thread.
+//
+// Read errors are detected asynchronously: a failed read causes a later
+// Next() to return false.  Call GetErrno() afterwards to distinguish an
+// error from end-of-stream.  The stream must be used from a single thread.
+class PROTOBUF_EXPORT AsyncFileInputStream final : public ZeroCopyInputStream {
+ public:
+  // Creates a stream that reads from the given Unix file descriptor.  If a
+  // buffer_size is given, it specifies the size of each of the two buffers;
+  // it bounds how far ahead of the parser the reader thread can get.
+  explicit AsyncFileInputStream(int file_descriptor, int buffer_size = -1);
+  AsyncFileInputStream(const AsyncFileInputStream&) = delete;
+  AsyncFileInputStream& operator=(const AsyncFileInputStream&) = delete;
+
+  // Joins the reader thread.  An in-flight read is allowed to finish; its
+  // data is discarded.
+  ~AsyncFileInputStream() override;
+
+  // Waits for any in-flight read and closes the underlying file.  Returns
+  // false if an error occurs during the process; use GetErrno() to examine
+  // the error.  Even if an error occurs, the file descriptor is closed when
+  // this returns.
+  bool Close();
+
+  // By default, the file descriptor is not closed when the stream is
+  // destroyed.  Call SetCloseOnDelete(true) to change that.  WARNING:
+  // This leaves no way for the caller to detect if close() fails.  If
+  // detecting close() errors is important to you, you should arrange
+  // to close the descriptor yourself.
+  void SetCloseOnDelete(bool value) { copying_input_.SetCloseOnDelete(value); }
+
+  // If an I/O error has occurred on this file descriptor, this is the
+  // errno from that error.  Otherwise, this is zero.  Once an error
+  // occurs, the stream is broken and all subsequent operations will
+  // fail.
+  int GetErrno() const { return copying_input_.GetErrno(); }
+
+  // implements ZeroCopyInputStream ----------------------------------
+  bool Next(const void** data, int* size) override;
+  void BackUp(int count) override;
+  bool Skip(int count) override;
+  int64_t ByteCount() const override;
+
+ private:
+  // Hands the given (drained) buffer to the reader thread to fill.  The
+  // reader must be idle.
+  void RequestFetch(int buffer_index);
+
+  // Waits for the in-flight read and returns its byte count: 0 at
+  // end-of-stream, -1 on error.
+  int WaitForFetch();
+
+  void ReaderLoop();
+
+  bool ReaderIdle() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return pending_buffer_ == nullptr;
+  }
+  bool ReaderHasWork() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return pending_buffer_ != nullptr || shutdown_;
+  }
+
+  FileInputStream::CopyingFileInputStream copying_input_;
+  const int buffer_size_;
+  std::unique_ptr<uint8_t[]> buffers_[2];
+  int current_ = 0;      // Index of the buffer being drained.
+  int fetch_index_ = 0;  // Index of the buffer the reader thread fills.
+  int position_ = 0;     // Bytes of the current buffer handed out by Next().
+  int limit_ = 0;        // Valid bytes in the current buffer.
+  bool eof_ = false;
+  bool failed_ = false;
+  int64_t byte_count_ = 0;
+
+  absl::Mutex mu_;
+  uint8_t* pending_buffer_ ABSL_GUARDED_BY(mu_) = nullptr;
+  int fetched_size_ ABSL_GUARDED_BY(mu_) = 0;
+  bool shutdown_ ABSL_GUARDED_BY(mu_) = false;
+
+  std::thread reader_;
+};
+
+// ===================================================================
+
+#if defined(__unix__) || (defined(__APPLE__) && defined(__MACH__))
+#define GOOGLE_PROTOBUF_IO_HAVE_MMAP_INPUT_STREAM 1
+
+// A ZeroCopyInputStream which reads a regular file through a private memory
+// mapping. Next() hands out the mapped pages directly, so parsing happens
+// straight out of the page cache with no intermediate copies, and madvise()
+// is used to tell the kernel to read ahead of the cursor.
+//
+// Unlike FileInputStream, buffers returned by Next() stay valid until the
+// stream is destroyed, which makes this stream safe to combine with aliasing
+// parse modes (e.g. CodedInputStream::EnableAliasing()) as long as the
+// consumer of the aliases does not outlive the stream.
+//
+// Only available on POSIX systems with mmap(); test
+// GOOGLE_PROTOBUF_IO_HAVE_MMAP_INPUT_STREAM before use.
+class PROTOBUF_EXPORT MmapInputStream final : public ZeroCopyInputStream {
+ public:
+  // Maps the whole regular file referred to by the given file descriptor.
+  // The descriptor is only used during construction and may be closed by the
+  // caller afterwards; the mapping keeps the file data reachable. If a
+  // block_size is given, it bounds the number of bytes returned by a single
+  // Next() call; otherwise a reasonable default is used.
+  explicit MmapInputStream(int file_descriptor, int block_size = -1);
+  MmapInputStream(const MmapInputStream&) = delete;
+  MmapInputStream& operator=(const MmapInputStream&) = delete;
+  ~MmapInputStream() override;
+
+  // Returns true if the file was mapped successfully. If false, Next()
+  // always returns false and GetErrno() reports the mmap()/fstat() error.
+  bool IsOpen() const { return errno_ == 0; }
+
+  // If mapping the file failed, this is the errno from that error.
+  // Otherwise, this is zero.
+  int GetErrno() const { return errno_; }
+
+  // implements ZeroCopyInputStream ----------------------------------
+  bool Next(const void** data, int* size) override;
+  void BackUp(int count) override;
+  bool Skip(int count) override;
+  int64_t ByteCount() const override;
+
+ private:
+  const char* data_ = nullptr;  // The mapping, nullptr on failure/empty file.
+  int64_t size_ = 0;            // File size in bytes.
+  int64_t position_ = 0;        // Bytes consumed so far.
+  int block_size_;
+  int errno_ = 0;
+};
+
+#define GOOGLE_PROTOBUF_IO_HAVE_NONBLOCKING_INPUT_STREAM 1
+
+// A ZeroCopyInputStream which reads from a non-blocking file descriptor,
+// typically a socket driven by epoll or kqueue. FileInputStream clears
+// O_NONBLOCK on its descriptor and blocks in read(); this stream leaves the
+// descriptor's flags alone and surfaces EAGAIN/EWOULDBLOCK as a
+// distinguishable WOULD_BLOCK state instead: Next() returns false,
+// WouldBlock() returns true and the stream remains usable. Once the event
+// loop reports the descriptor readable, calling Next() again resumes
+// reading where it stopped, so a suspended parse can be continued rather
+// than parking a thread per connection.
+//
+// A readiness hook may be installed with SetReadinessCallback(); it is
+// invoked with the descriptor each time a read would block, which is a
+// convenient place to (re-)arm a readiness watch before suspending the
+// consumer.
+//
+// Only available on POSIX systems; test
+// GOOGLE_PROTOBUF_IO_HAVE_NONBLOCKING_INPUT_STREAM before use.
+class PROTOBUF_EXPORT NonBlockingFdInputStream final
+    : public ZeroCopyInputStream {
+ public:
+  // Creates a stream that reads from the given file descriptor, which should
+  // already have O_NONBLOCK set. If a block_size is given, it specifies the
+  // number of bytes that should be read and returned with each call to
+  // Next().  Otherwise, a reasonable default is used.
+  explicit NonBlockingFdInputStream(int file_descriptor, int block_size = -1);
+  NonBlockingFdInputStream(const NonBlockingFdInputStream&) = delete;
+  NonBlockingFdInputStream& operator=(const NonBlockingFdInputStream&) =
+      delete;
+  ~NonBlockingFdInputStream() override;
+
+  // Closes the underlying file descriptor.  Returns false if close() fails;
+  // use GetErrno() to examine the error.  The descriptor is closed even if
+  // an error occurs.
+  bool Close();
+
+  // By default, the file descriptor is not closed when the stream is
+  // destroyed.  Call SetCloseOnDelete(true) to change that.
+  void SetCloseOnDelete(bool value) { close_on_delete_ = value; }
+
+  // True if the most recent Next() or Skip() returned false only because no
+  // data was available yet.  Cleared by the next call to either.  When true,
+  // the stream is not broken: wait for readiness and call again.
+  bool WouldBlock() const { return would_block_; }
+
+  // If an I/O error other than WOULD_BLOCK has occurred, this is the errno
+  // from that error.  Otherwise, this is zero.  Once an error occurs, the
+  // stream is broken and all subsequent operations will fail.
+  int GetErrno() const { return errno_; }
+
+  // Installs a hook invoked with the file descriptor every time a read would
+  // block.  Pass a default-constructed function to remove it.
+  void SetReadinessCallback(std::function<void(int)> callback) {
+    readiness_callback_ = std::move(callback);
+  }
+
+  // implements ZeroCopyInputStream ----------------------------------
+  bool Next(const void** data, int* size) override;
+  void BackUp(int count) override;
+  bool Skip(int count) override;
+  int64_t ByteCount() const override;
+
+ private:
+  // Reads once into buffer_, retrying on EINTR.  Updates buffer_used_,
+  // position_ and the eof / would-block / error state.  Returns the number
+  // of bytes read, or -1 if nothing was read.
+  int ReadOnce();
+
+  const int file_;
+  bool close_on_delete_ = false;
+  bool is_closed_ = false;
+
+  const int block_size_;
+  std::unique_ptr<uint8_t[]> buffer_;
+  // Bytes of buffer_ filled by the last read, and how many of its trailing
+  // bytes were returned by BackUp().
+  int buffer_used_ = 0;
+  int backup_bytes_ = 0;
+
+  int64_t position_ = 0;  // Bytes read from the descriptor so far.
+  bool eof_ = false;
+  bool would_block_ = false;
+  int errno_ = 0;
+
+  std::function<void(int)> readiness_callback_;
 };
 
+#define GOOGLE_PROTOBUF_IO_HAVE_VM_OUTPUT_STREAM 1
+
+// A ZeroCopyOutputStream backed by a large anonymous virtual memory
+// reservation instead of a growable std::string.  The reservation costs
+// address space only: physical pages are committed by the kernel on first
+// write, so serializing into this stream never copies bytes already written
+// the way copy-on-resize growth does.  On Linux, output larger than the
+// reservation grows it in place with mremap(), again without copying; on
+// other POSIX systems the reservation is a hard cap and Next() fails once
+// it is exhausted.
+//
+// The finished output is exposed zero-copy through data()/size() (or
+// view()); the buffer stays contiguous and valid until the stream is
+// destroyed or Grow() moves it, i.e. read it only after serialization is
+// done.
+//
+// Only available on POSIX systems with mmap(); test
+// GOOGLE_PROTOBUF_IO_HAVE_VM_OUTPUT_STREAM before use.
+class PROTOBUF_EXPORT VirtualMemoryOutputStream final
+    : public ZeroCopyOutputStream {
+ public:
+  // Reserves reserved_size bytes of address space (a reasonable default is
+  // used if none is given; it is cheap to over-reserve).  If a block_size
+  // is given, it bounds the number of bytes returned by a single Next()
+  // call; otherwise a reasonable default is used.
+  explicit VirtualMemoryOutputStream(int64_t reserved_size = -1,
+                                     int block_size = -1);
+  VirtualMemoryOutputStream(const VirtualMemoryOutputStream&) = delete;
+  VirtualMemoryOutputStream& operator=(const VirtualMemoryOutputStream&) =
+      delete;
+  ~VirtualMemoryOutputStream() override;
+
+  // Returns true if the reservation succeeded.  If false, Next() always
+  // returns false and GetErrno() reports the mmap() error.
+  bool IsOpen() const { return errno_ == 0; }
+
+  // If reserving or growing the mapping failed, this is the errno from that
+  // error.  Otherwise, this is zero.
+  int GetErrno() const { return errno_; }
+
+  // The bytes written so far.  Only meaningful once the writer is finished
+  // (i.e. has backed up any unused tail of the last Next() buffer).
+  const char* data() const { return data_; }
+  size_t size() const { return static_cast<size_t>(position_); }
+  absl::string_view view() const { return absl::string_view(data_, size()); }
+
+  // implements ZeroCopyOutputStream ---------------------------------
+  bool Next(void** data, int* size) override;
+  void BackUp(int count) override;
+  int64_t ByteCount() const override;
+
+ private:
+  // Doubles the reservation, in place when the kernel allows.  Returns
+  // false (and sets errno_) if the mapping cannot grow.
+  bool Grow();
+
+  char* data_ = nullptr;     // The reservation, nullptr on failure.
+  int64_t reserved_ = 0;     // Reserved bytes.
+  int64_t position_ = 0;     // Bytes handed out and not backed up.
+  int block_size_;
+  int errno_ = 0;
+};
+
+#endif  // __unix__ || __APPLE__
+
 // ===================================================================
 
 // A ZeroCopyOutputStream which writes to a file descriptor.
@@ -175,6 +481,97 @@ class PROTOBUF_EXPORT FileOutputStream final
   };
 
   CopyingFileOutputStream copying_output_;
+
+  friend class AsyncFileOutputStream;  // Reuses CopyingFileOutputStream.
+};
+
+// ===================================================================
+
+// A ZeroCopyOutputStream which writes to a file descriptor from a background
+// thread, so serialization overlaps with disk I/O instead of stalling on
+// blocking write() calls.
+//
+// The stream double-buffers: while the serializer fills one buffer through
+// Next(), the previous buffer is written out by a dedicated writer thread.
+// Workloads that alternate between CPU-bound encoding and waiting on the
+// disk (e.g. snapshot writers calling SerializeToZeroCopyStream()) can hide
+// most of the write latency this way; for workloads that are purely bound by
+// one or the other, plain FileOutputStream performs the same with one less
+// thread.
+//
+// Write errors are detected asynchronously: a failed write causes a later
+// Next() or the final Flush()/Close() to return false.  Call GetErrno()
+// after Flush() or Close() to get the errno of the failed write.  The stream
+// must be used from a single thread.
+class PROTOBUF_EXPORT AsyncFileOutputStream final
+    : public ZeroCopyOutputStream {
+ public:
+  // Creates a stream that writes to the given Unix file descriptor.  If a
+  // buffer_size is given, it specifies the size of each of the two buffers;
+  // it bounds how much encoded data can be in flight to the disk at once.
+  explicit AsyncFileOutputStream(int file_descriptor, int buffer_size = -1);
+  AsyncFileOutputStream(const AsyncFileOutputStream&) = delete;
+  AsyncFileOutputStream& operator=(const AsyncFileOutputStream&) = delete;
+
+  // Flushes remaining data and joins the writer thread.  Errors detected
+  // this late are lost; call Flush() or Close() first if you care.
+  ~AsyncFileOutputStream() override;
+
+  // Waits for all data handed out by Next() (minus BackUp()) to reach the
+  // file descriptor.  Returns false if any write failed.
+  bool Flush();
+
+  // Flushes all buffers and closes the underlying file.  Returns false if
+  // an error occurs during the process; use GetErrno() to examine the error.
+  // Even if an error occurs, the file descriptor is closed when this returns.
+  bool Close();
+
+  // By default, the file descriptor is not closed when the stream is
+  // destroyed.  Call SetCloseOnDelete(true) to change that.  WARNING:
+  // This leaves no way for the caller to detect if close() fails.  If
+  // detecting close() errors is important to you, you should arrange
+  // to close the descriptor yourself.
+  void SetCloseOnDelete(bool value) { copying_output_.SetCloseOnDelete(value); }
+
+  // If an I/O error has occurred on this file descriptor, this is the
+  // errno from that error.  Otherwise, this is zero.  Only stable once
+  // Flush() or Close() has returned.
+  int GetErrno() const { return copying_output_.GetErrno(); }
+
+  // implements ZeroCopyOutputStream ---------------------------------
+  bool Next(void** data, int* size) override;
+  void BackUp(int count) override;
+  int64_t ByteCount() const override;
+
+ private:
+  // Hands the filled part of the current buffer to the writer thread,
+  // waiting for the previous write to finish first, and makes the other
+  // buffer current.  Returns false if a write has failed.
+  bool SubmitBuffer();
+
+  void WriterLoop();
+
+  bool WriterIdle() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return pending_data_ == nullptr;
+  }
+  bool WriterHasWork() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return pending_data_ != nullptr || shutdown_;
+  }
+
+  FileOutputStream::CopyingFileOutputStream copying_output_;
+  const int buffer_size_;
+  std::unique_ptr<uint8_t[]> buffers_[2];
+  int current_ = 0;      // Index of the buffer being filled.
+  int buffer_used_ = 0;  // Bytes of the current buffer handed out by Next().
+  int64_t byte_count_ = 0;
+
+  absl::Mutex mu_;
+  const uint8_t* pending_data_ ABSL_GUARDED_BY(mu_) = nullptr;
+  int pending_size_ ABSL_GUARDED_BY(mu_) = 0;
+  bool shutdown_ ABSL_GUARDED_BY(mu_) = false;
+  bool failed_ ABSL_GUARDED_BY(mu_) = false;
+
+  std::thread writer_;
 };
 
 // ===================================================================
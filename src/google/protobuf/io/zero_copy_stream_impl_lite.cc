@@ -82,6 +82,69 @@ bool ArrayInputStream::Skip(int count) {
 int64_t ArrayInputStream::ByteCount() const { return position_; }
 
 
+// ===================================================================
+
+BufferChainInputStream::BufferChainInputStream(
+    absl::Span<const absl::string_view> fragments)
+    : fragments_(fragments),
+      index_(0),
+      position_(0),
+      byte_count_(0),
+      last_returned_size_(0) {}
+
+bool BufferChainInputStream::Next(const void** data, int* size) {
+  while (index_ < fragments_.size() &&
+         position_ == fragments_[index_].size()) {
+    ++index_;
+    position_ = 0;
+  }
+  if (index_ == fragments_.size()) {
+    // We're at the end of the chain.
+    last_returned_size_ = 0;  // Don't let caller back up.
+    return false;
+  }
+  const absl::string_view fragment = fragments_[index_];
+  // Fragments larger than INT_MAX are returned in multiple pieces.
+  last_returned_size_ = static_cast<int>(
+      std::min(fragment.size() - position_,
+               static_cast<size_t>(std::numeric_limits<int>::max())));
+  *data = fragment.data() + position_;
+  *size = last_returned_size_;
+  position_ += last_returned_size_;
+  byte_count_ += last_returned_size_;
+  return true;
+}
+
+void BufferChainInputStream::BackUp(int count) {
+  ABSL_CHECK_GT(last_returned_size_, 0)
+      << "BackUp() can only be called after a successful Next().";
+  ABSL_CHECK_LE(count, last_returned_size_);
+  ABSL_CHECK_GE(count, 0);
+  position_ -= count;
+  byte_count_ -= count;
+  last_returned_size_ = 0;  // Don't let caller back up further.
+}
+
+bool BufferChainInputStream::Skip(int count) {
+  ABSL_CHECK_GE(count, 0);
+  last_returned_size_ = 0;  // Don't let caller back up.
+  while (count > 0 && index_ < fragments_.size()) {
+    const size_t available = fragments_[index_].size() - position_;
+    const size_t skipped = std::min(available, static_cast<size_t>(count));
+    position_ += skipped;
+    byte_count_ += skipped;
+    count -= static_cast<int>(skipped);
+    if (position_ == fragments_[index_].size()) {
+      ++index_;
+      position_ = 0;
+    }
+  }
+  return count == 0;
+}
+
+int64_t BufferChainInputStream::ByteCount() const { return byte_count_; }
+
+
 // ===================================================================
 
 ArrayOutputStream::ArrayOutputStream(void* data, int size, int block_size)
@@ -620,7 +683,16 @@ bool CordOutputStream::Next(void** data, int* size) {
       ABSL_FALLTHROUGH_INTENDED;
     case State::kEmpty:
       assert(buffer_.length() == 0);
-      buffer_ = absl::CordBuffer::CreateWithDefaultLimit(desired_size);
+      if (desired_size > absl::CordBuffer::kDefaultLimit) {
+        // Large writes build a rope of bigger blocks rather than a long list
+        // of default-limit (4K) flats: each completed block is appended to
+        // the cord as its own chunk, so a large serialized message never
+        // needs one contiguous allocation of its full size.
+        buffer_ = absl::CordBuffer::CreateWithCustomLimit(
+            absl::CordBuffer::kCustomLimit, desired_size);
+      } else {
+        buffer_ = absl::CordBuffer::CreateWithDefaultLimit(desired_size);
+      }
       break;
   }
 
@@ -666,6 +738,22 @@ int64_t CordOutputStream::ByteCount() const {
   return static_cast<int64_t>(cord_.size() + buffer_.length());
 }
 
+void CordOutputStream::Truncate(size_t new_size) {
+  const size_t current_size = cord_.size() + buffer_.length();
+  assert(new_size <= current_size);
+  if (new_size >= current_size) return;
+  if (new_size >= cord_.size()) {
+    // The truncation point lies inside the pending buffer; shrinking it
+    // leaves the remaining capacity available for subsequent writes.
+    buffer_.SetLength(new_size - cord_.size());
+    state_ = State::kPartial;
+  } else {
+    buffer_ = {};
+    cord_.RemoveSuffix(cord_.size() - new_size);
+    state_ = cord_.empty() ? State::kEmpty : State::kSteal;
+  }
+}
+
 bool CordOutputStream::WriteCord(const absl::Cord& cord) {
   cord_.Append(std::move(buffer_));
   cord_.Append(cord);
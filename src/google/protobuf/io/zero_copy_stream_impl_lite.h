@@ -31,6 +31,8 @@
 #include "absl/base/attributes.h"
 #include "absl/strings/cord.h"
 #include "absl/strings/cord_buffer.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "google/protobuf/io/zero_copy_stream.h"
 #include "google/protobuf/port.h"
 
@@ -80,6 +82,47 @@ class PROTOBUF_EXPORT ArrayInputStream final : public ZeroCopyInputStream {
 
 // ===================================================================
 
+// A ZeroCopyInputStream backed by a sequence of non-contiguous memory
+// fragments, such as an iovec array or a chain of refcounted RPC buffers.
+// Each Next() call returns (a prefix of) the current fragment, so parsing
+// transitions between fragments without flattening them into one contiguous
+// buffer first; the parser's own boundary handling pays only a small
+// fixed-size copy per transition.
+class PROTOBUF_EXPORT BufferChainInputStream final
+    : public ZeroCopyInputStream {
+ public:
+  // Creates an InputStream that reads the given fragments in order.  Both
+  // the span and the memory each fragment points to remain the property of
+  // the caller and must remain valid until the stream is destroyed.  Empty
+  // fragments are permitted and skipped.
+  explicit BufferChainInputStream(
+      absl::Span<const absl::string_view> fragments
+          ABSL_ATTRIBUTE_LIFETIME_BOUND);
+  ~BufferChainInputStream() override = default;
+
+  // `BufferChainInputStream` is neither copiable nor assignable
+  BufferChainInputStream(const BufferChainInputStream&) = delete;
+  BufferChainInputStream& operator=(const BufferChainInputStream&) = delete;
+
+  // implements ZeroCopyInputStream ----------------------------------
+  bool Next(const void** data, int* size) override;
+  void BackUp(int count) override;
+  bool Skip(int count) override;
+  int64_t ByteCount() const override;
+
+
+ private:
+  const absl::Span<const absl::string_view> fragments_;
+
+  size_t index_;     // Current fragment.
+  size_t position_;  // Position within the current fragment.
+  int64_t byte_count_;
+  int last_returned_size_;  // How many bytes we returned last time Next()
+                            // was called (used for error checking only).
+};
+
+// ===================================================================
+
 // A ZeroCopyOutputStream backed by an in-memory array of bytes.
 class PROTOBUF_EXPORT ArrayOutputStream final : public ZeroCopyOutputStream {
  public:
@@ -476,6 +519,21 @@ class PROTOBUF_EXPORT CordOutputStream final : public ZeroCopyOutputStream {
   // and any new serialization calls will serialize into new cord data.
   absl::Cord Consume();
 
+  // Truncates the stream to `new_size` bytes, discarding all data written
+  // past that point. `new_size` must not exceed ByteCount(). Taking a
+  // checkpoint with ByteCount() before serializing allows a speculative
+  // write to be rolled back without a separate size pre-pass:
+  //
+  //   const size_t checkpoint = static_cast<size_t>(stream.ByteCount());
+  //   message.SerializePartialToZeroCopyStream(&stream);
+  //   if (stream.ByteCount() > quota) stream.Truncate(checkpoint);
+  //
+  // Truncation is cheap regardless of how many buffers were completed since
+  // the checkpoint: it trims the pending buffer and/or removes a suffix of
+  // the underlying cord without copying retained data. The stream remains
+  // usable after a call to `Truncate()`.
+  void Truncate(size_t new_size);
+
  private:
   // State of `buffer_` and 'cord_. As a default CordBuffer instance always has
   // inlined capacity, we track state explicitly to avoid returning 'existing
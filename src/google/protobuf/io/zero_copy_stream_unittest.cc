@@ -289,6 +289,58 @@ TEST_F(IoTest, ArrayIo) {
   }
 }
 
+TEST_F(IoTest, BufferChainIo) {
+  const int kBufferSize = 256;
+  uint8_t buffer[kBufferSize];
+
+  for (int i = 0; i < kBlockSizeCount; i++) {
+    for (int j = 0; j < kBlockSizeCount; j++) {
+      int size;
+      {
+        ArrayOutputStream output(buffer, kBufferSize, kBlockSizes[i]);
+        size = WriteStuff(&output);
+      }
+      {
+        // Split the buffer into fragments no larger than the block size,
+        // as an RPC transport delivering a chain of buffers would.
+        int fragment_size = kBlockSizes[j] > 0 ? kBlockSizes[j] : size;
+        std::vector<absl::string_view> fragments;
+        for (int pos = 0; pos < size; pos += fragment_size) {
+          fragments.push_back(
+              absl::string_view(reinterpret_cast<const char*>(buffer) + pos,
+                                std::min(fragment_size, size - pos)));
+        }
+        BufferChainInputStream input(fragments);
+        ReadStuff(&input);
+      }
+    }
+  }
+}
+
+TEST_F(IoTest, BufferChainIoWithEmptyFragments) {
+  const int kBufferSize = 256;
+  uint8_t buffer[kBufferSize];
+
+  int size;
+  {
+    ArrayOutputStream output(buffer, kBufferSize);
+    size = WriteStuff(&output);
+  }
+
+  // Interleave empty fragments with single-byte fragments; Next() must skip
+  // the empty ones rather than returning zero-sized blocks.
+  std::vector<absl::string_view> fragments;
+  for (int pos = 0; pos < size; ++pos) {
+    fragments.push_back(absl::string_view());
+    fragments.push_back(
+        absl::string_view(reinterpret_cast<const char*>(buffer) + pos, 1));
+  }
+  fragments.push_back(absl::string_view());
+
+  BufferChainInputStream input(fragments);
+  ReadStuff(&input);
+}
+
 TEST_F(IoTest, TwoSessionWrite) {
   // Test that two concatenated write sessions read correctly
 
@@ -372,6 +424,80 @@ TEST_F(IoTest, GzipIo) {
   delete[] buffer;
 }
 
+TEST_F(IoTest, ParallelGzipIo) {
+  // The output is a plain gzip stream, so it is read back with the ordinary
+  // GzipInputStream.  Use small blocks to exercise the multi-block path and
+  // the dictionary carry-over even with this small payload.
+  const int kBufferSize = 2 * 1024;
+  uint8* buffer = new uint8[kBufferSize];
+  const int kThreadCounts[] = {1, 4};
+  for (int num_threads : kThreadCounts) {
+    for (int i = 0; i < kBlockSizeCount; i++) {
+      int size;
+      {
+        ArrayOutputStream output(buffer, kBufferSize, kBlockSizes[i]);
+        ParallelGzipOutputStream::Options options;
+        options.block_size = 16;
+        options.num_threads = num_threads;
+        ParallelGzipOutputStream gzout(&output, options);
+        WriteStuff(&gzout);
+        EXPECT_TRUE(gzout.Close());
+        size = output.ByteCount();
+      }
+      {
+        ArrayInputStream input(buffer, size, kBlockSizes[i]);
+        GzipInputStream gzin(&input, GzipInputStream::GZIP);
+        ReadStuff(&gzin);
+      }
+    }
+  }
+  delete[] buffer;
+}
+
+TEST_F(IoTest, ParallelGzipLargeIo) {
+  // Large enough for several blocks per job queue refill; the repetitive
+  // payload verifies that back-references into the previous block's
+  // dictionary decompress correctly.
+  const int kBufferSize = 512 * 1024;
+  uint8* buffer = new uint8[kBufferSize];
+  int size;
+  {
+    ArrayOutputStream output(buffer, kBufferSize);
+    ParallelGzipOutputStream::Options options;
+    options.block_size = 8 * 1024;
+    options.num_threads = 3;
+    ParallelGzipOutputStream gzout(&output, options);
+    WriteStuffLarge(&gzout);
+    EXPECT_TRUE(gzout.Close());
+    size = output.ByteCount();
+  }
+  {
+    ArrayInputStream input(buffer, size);
+    GzipInputStream gzin(&input, GzipInputStream::GZIP);
+    ReadStuffLarge(&gzin);
+  }
+  delete[] buffer;
+}
+
+TEST_F(IoTest, ParallelGzipEmptyStream) {
+  const int kBufferSize = 256;
+  uint8 buffer[kBufferSize];
+  int size;
+  {
+    ArrayOutputStream output(buffer, kBufferSize);
+    ParallelGzipOutputStream gzout(&output);
+    EXPECT_TRUE(gzout.Close());
+    size = output.ByteCount();
+  }
+  {
+    ArrayInputStream input(buffer, size);
+    GzipInputStream gzin(&input, GzipInputStream::GZIP);
+    const void* data;
+    int data_size;
+    EXPECT_FALSE(gzin.Next(&data, &data_size));
+  }
+}
+
 TEST_F(IoTest, GzipIoWithFlush) {
   const int kBufferSize = 2 * 1024;
   uint8* buffer = new uint8[kBufferSize];
@@ -688,6 +814,126 @@ TEST_F(IoTest, GzipInputByteCountAfterClosedConcatenatedStreams) {
     EXPECT_EQ(total_size, gz_input.ByteCount());
   }
 }
+
+// Compresses one record with a preset dictionary; window_bits selects the
+// framing (15 for zlib, -15 for raw deflate).
+static std::string CompressWithDictionary(const std::string& data,
+                                          const std::string& dictionary,
+                                          int window_bits) {
+  z_stream ctx;
+  ctx.zalloc = Z_NULL;
+  ctx.zfree = Z_NULL;
+  ctx.opaque = Z_NULL;
+  ctx.msg = nullptr;
+  ABSL_CHECK_EQ(deflateInit2(&ctx, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                             window_bits, /* memLevel (default) */ 8,
+                             Z_DEFAULT_STRATEGY),
+                Z_OK);
+  ABSL_CHECK_EQ(
+      deflateSetDictionary(&ctx,
+                           reinterpret_cast<const Bytef*>(dictionary.data()),
+                           dictionary.size()),
+      Z_OK);
+  std::string result;
+  result.resize(deflateBound(&ctx, data.size()));
+  ctx.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  ctx.avail_in = data.size();
+  ctx.next_out = reinterpret_cast<Bytef*>(&result[0]);
+  ctx.avail_out = result.size();
+  ABSL_CHECK_EQ(deflate(&ctx, Z_FINISH), Z_STREAM_END);
+  result.resize(result.size() - ctx.avail_out);
+  deflateEnd(&ctx);
+  return result;
+}
+
+TEST_F(IoTest, ZlibRecordDecompressorReusesState) {
+  // One decompressor and one output string across many records; AUTO
+  // handles gzip and zlib records interchangeably.
+  std::vector<std::string> records;
+  for (int i = 0; i < 20; i++) {
+    records.push_back(absl::StrCat("record ", i, " ",
+                                   std::string(100 + 37 * i, 'a' + i % 26)));
+  }
+  ZlibRecordDecompressor decompressor;
+  std::string output;
+  for (size_t i = 0; i < records.size(); i++) {
+    GzipOutputStream::Options options;
+    options.format =
+        (i % 2 == 0) ? GzipOutputStream::GZIP : GzipOutputStream::ZLIB;
+    std::string compressed = Compress(records[i], options);
+    ASSERT_TRUE(
+        decompressor.Decompress(compressed.data(), compressed.size(), &output))
+        << decompressor.ZlibErrorCode();
+    EXPECT_EQ(records[i], output);
+  }
+}
+
+TEST_F(IoTest, ZlibRecordDecompressorRejectsBadRecords) {
+  std::string compressed =
+      Compress("a complete record", GzipOutputStream::Options());
+  ZlibRecordDecompressor decompressor;
+  std::string output;
+
+  // Truncated record.
+  EXPECT_FALSE(decompressor.Decompress(compressed.data(),
+                                       compressed.size() / 2, &output));
+
+  // Trailing bytes past the end of the stream.
+  std::string padded = absl::StrCat(compressed, "x");
+  EXPECT_FALSE(
+      decompressor.Decompress(padded.data(), padded.size(), &output));
+
+  // The reset between records recovers from either failure.
+  EXPECT_TRUE(
+      decompressor.Decompress(compressed.data(), compressed.size(), &output));
+  EXPECT_EQ("a complete record", output);
+}
+
+TEST_F(IoTest, ZlibRecordDecompressorPresetDictionary) {
+  const std::string dictionary = "the quick brown fox jumps over the lazy dog";
+  const std::string record =
+      "the quick brown fox jumps over the lazy dog again and again";
+
+  // Raw deflate: the dictionary is installed unconditionally after each
+  // reset.
+  {
+    std::string compressed =
+        CompressWithDictionary(record, dictionary, /*window_bits=*/-15);
+    ZlibRecordDecompressor::Options options;
+    options.format = ZlibRecordDecompressor::RAW;
+    options.dictionary = dictionary;
+    ZlibRecordDecompressor decompressor(options);
+    std::string output;
+    for (int i = 0; i < 3; i++) {
+      ASSERT_TRUE(decompressor.Decompress(compressed.data(),
+                                          compressed.size(), &output))
+          << decompressor.ZlibErrorCode();
+      EXPECT_EQ(record, output);
+    }
+  }
+
+  // Zlib framing: the stream's FDICT handshake requests the dictionary, so
+  // decompression fails without it and succeeds with it.
+  {
+    std::string compressed =
+        CompressWithDictionary(record, dictionary, /*window_bits=*/15);
+    std::string output;
+
+    ZlibRecordDecompressor no_dictionary;
+    EXPECT_FALSE(
+        no_dictionary.Decompress(compressed.data(), compressed.size(), &output));
+    EXPECT_EQ(Z_NEED_DICT, no_dictionary.ZlibErrorCode());
+
+    ZlibRecordDecompressor::Options options;
+    options.format = ZlibRecordDecompressor::ZLIB;
+    options.dictionary = dictionary;
+    ZlibRecordDecompressor decompressor(options);
+    ASSERT_TRUE(
+        decompressor.Decompress(compressed.data(), compressed.size(), &output))
+        << decompressor.ZlibErrorCode();
+    EXPECT_EQ(record, output);
+  }
+}
 #endif
 
 // There is no string input, only string output.  Also, it doesn't support
@@ -998,6 +1244,34 @@ TEST(CordOutputStreamTest, ConsumesCordClearingState) {
   EXPECT_TRUE(output.Consume().empty());
 }
 
+TEST(CordOutputStreamTest, LargeOutputBuildsRopeOfLargeChunks) {
+  constexpr size_t kSize = 1 << 20;  // 1 MiB
+  CordOutputStream output(kSize);
+  void* data;
+  int size;
+  size_t written = 0;
+  while (written < kSize) {
+    ASSERT_TRUE(output.Next(&data, &size));
+    memset(data, 'a', static_cast<size_t>(size));
+    written += static_cast<size_t>(size);
+  }
+  ASSERT_EQ(written, kSize);  // with a size hint, Next() never overshoots
+
+  absl::Cord cord = output.Consume();
+  EXPECT_EQ(cord.size(), kSize);
+  // The data is built as a rope rather than one contiguous block, and the
+  // blocks scale up to the custom limit instead of staying at the small
+  // default flat size.
+  EXPECT_FALSE(cord.TryFlat());
+  size_t max_chunk = 0;
+  for (absl::string_view chunk : cord.Chunks()) {
+    max_chunk = std::max(max_chunk, chunk.size());
+  }
+  EXPECT_GT(max_chunk, absl::CordBuffer::kDefaultLimit);
+  EXPECT_LE(max_chunk, absl::CordBuffer::kCustomLimit);
+  EXPECT_EQ(cord, std::string(kSize, 'a'));
+}
+
 TEST(CordOutputStreamTest, DonateEmptyCordBuffer) {
   absl::CordBuffer buffer = absl::CordBuffer::CreateWithDefaultLimit(500);
   absl::Span<char> available = buffer.available();
@@ -1165,6 +1439,57 @@ TEST(CordOutputStreamTest, DonateCordAndFullCordBufferAndBackup) {
                       std::string(100, 'c'));
 }
 
+TEST(CordOutputStreamTest, TruncateInsidePendingBuffer) {
+  CordOutputStream output;
+  void* data;
+  int size;
+  ASSERT_TRUE(output.Next(&data, &size));
+  ASSERT_GE(size, 10);
+  memset(data, 'a', 10);
+  output.BackUp(size - 10);
+  const size_t checkpoint = static_cast<size_t>(output.ByteCount());
+
+  // Speculatively write more data, then roll it back.
+  ASSERT_TRUE(output.Next(&data, &size));
+  memset(data, 'b', static_cast<size_t>(size));
+  output.Truncate(checkpoint);
+  EXPECT_EQ(output.ByteCount(), 10);
+
+  // The stream remains usable after the rollback.
+  ASSERT_TRUE(output.Next(&data, &size));
+  ASSERT_GE(size, 5);
+  memset(data, 'c', 5);
+  output.BackUp(size - 5);
+  EXPECT_EQ(output.Consume(), std::string(10, 'a') + std::string(5, 'c'));
+}
+
+TEST(CordOutputStreamTest, TruncateAcrossFlushedBuffers) {
+  CordOutputStream output(absl::Cord(std::string(400, 'a')));
+  const size_t checkpoint = static_cast<size_t>(output.ByteCount());
+
+  // Complete several buffers so the speculative data spans multiple chunks.
+  for (int i = 0; i < 10; ++i) {
+    void* data;
+    int size;
+    ASSERT_TRUE(output.Next(&data, &size));
+    memset(data, 'b', static_cast<size_t>(size));
+  }
+  ASSERT_GT(output.ByteCount(), static_cast<int64_t>(checkpoint));
+
+  output.Truncate(checkpoint);
+  EXPECT_EQ(output.ByteCount(), 400);
+  EXPECT_EQ(output.Consume(), absl::Cord(std::string(400, 'a')));
+}
+
+TEST(CordOutputStreamTest, TruncateToZeroAndCurrentSize) {
+  CordOutputStream output(absl::Cord("abcdef"));
+  output.Truncate(6);  // No-op: already the current size.
+  EXPECT_EQ(output.ByteCount(), 6);
+  output.Truncate(0);
+  EXPECT_EQ(output.ByteCount(), 0);
+  EXPECT_TRUE(output.Consume().empty());
+}
+
 TEST(CordOutputStreamTest, ProperHintCreatesSingleFlatCord) {
   CordOutputStream output(2000);
   void* data;
@@ -1431,6 +1756,164 @@ TEST_F(IoTest, FileIo) {
   }
 }
 
+TEST_F(IoTest, AsyncFileIo) {
+  std::string filename =
+      absl::StrCat(::testing::TempDir(), "/zero_copy_stream_test_async_file");
+
+  for (int i = 0; i < kBlockSizeCount; i++) {
+    for (int j = 0; j < kBlockSizeCount; j++) {
+      // Make a temporary file.
+      int file =
+          open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0777);
+      ASSERT_GE(file, 0);
+
+      {
+        // Small buffers force handoffs to the writer thread mid-stream.
+        AsyncFileOutputStream output(file, kBlockSizes[i]);
+        WriteStuff(&output);
+        EXPECT_TRUE(output.Flush());
+        EXPECT_EQ(0, output.GetErrno());
+      }
+
+      // Rewind.
+      ASSERT_NE(lseek(file, 0, SEEK_SET), (off_t)-1);
+
+      {
+        FileInputStream input(file, kBlockSizes[j]);
+        ReadStuff(&input);
+        EXPECT_EQ(0, input.GetErrno());
+      }
+
+      close(file);
+    }
+  }
+}
+
+TEST_F(IoTest, AsyncFileInputIo) {
+  std::string filename = absl::StrCat(::testing::TempDir(),
+                                      "/zero_copy_stream_test_async_input");
+
+  for (int i = 0; i < kBlockSizeCount; i++) {
+    for (int j = 0; j < kBlockSizeCount; j++) {
+      // Make a temporary file.
+      int file =
+          open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0777);
+      ASSERT_GE(file, 0);
+
+      {
+        FileOutputStream output(file, kBlockSizes[i]);
+        WriteStuff(&output);
+        EXPECT_EQ(0, output.GetErrno());
+      }
+
+      // Rewind.
+      ASSERT_NE(lseek(file, 0, SEEK_SET), (off_t)-1);
+
+      {
+        // Small buffers force buffer swaps with the reader thread
+        // mid-stream; ReadStuff also exercises Skip() across them.
+        AsyncFileInputStream input(file, kBlockSizes[j]);
+        ReadStuff(&input);
+        EXPECT_EQ(0, input.GetErrno());
+      }
+
+      close(file);
+    }
+  }
+}
+
+#ifdef GOOGLE_PROTOBUF_IO_HAVE_MMAP_INPUT_STREAM
+TEST_F(IoTest, MmapIo) {
+  std::string filename =
+      absl::StrCat(::testing::TempDir(), "/zero_copy_stream_test_mmap_file");
+
+  for (int i = 0; i < kBlockSizeCount; i++) {
+    for (int j = 0; j < kBlockSizeCount; j++) {
+      // Make a temporary file.
+      int file =
+          open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0777);
+      ASSERT_GE(file, 0);
+
+      {
+        FileOutputStream output(file, kBlockSizes[i]);
+        WriteStuff(&output);
+        EXPECT_EQ(0, output.GetErrno());
+      }
+
+      {
+        MmapInputStream input(file, kBlockSizes[j]);
+        ASSERT_TRUE(input.IsOpen());
+        ReadStuff(&input);
+        EXPECT_EQ(0, input.GetErrno());
+      }
+
+      close(file);
+    }
+  }
+}
+
+TEST_F(IoTest, MmapIoEmptyFile) {
+  std::string filename =
+      absl::StrCat(::testing::TempDir(), "/zero_copy_stream_test_mmap_empty");
+  int file = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0777);
+  ASSERT_GE(file, 0);
+
+  MmapInputStream input(file);
+  EXPECT_TRUE(input.IsOpen());
+  const void* data;
+  int size;
+  EXPECT_FALSE(input.Next(&data, &size));
+  close(file);
+}
+#endif  // GOOGLE_PROTOBUF_IO_HAVE_MMAP_INPUT_STREAM
+
+#ifdef GOOGLE_PROTOBUF_IO_HAVE_VM_OUTPUT_STREAM
+TEST_F(IoTest, VirtualMemoryIo) {
+  for (int i = 0; i < kBlockSizeCount; i++) {
+    for (int j = 0; j < kBlockSizeCount; j++) {
+      VirtualMemoryOutputStream output(-1, kBlockSizes[i]);
+      ASSERT_TRUE(output.IsOpen());
+      const int size = WriteStuff(&output);
+      EXPECT_EQ(0, output.GetErrno());
+      EXPECT_EQ(size, output.ByteCount());
+      EXPECT_EQ(size, static_cast<int>(output.size()));
+
+      ArrayInputStream input(output.data(), size, kBlockSizes[j]);
+      ReadStuff(&input);
+    }
+  }
+}
+
+TEST_F(IoTest, VirtualMemoryGrowth) {
+  // A one-page reservation forces Grow() almost immediately.
+  VirtualMemoryOutputStream output(4096, 1024);
+  ASSERT_TRUE(output.IsOpen());
+  const std::string pattern = "0123456789abcdef";
+  constexpr int kCopies = 4096;  // 64 KiB, 16x the initial reservation.
+#ifdef __linux__
+  for (int i = 0; i < kCopies; ++i) {
+    WriteString(&output, pattern);
+  }
+  EXPECT_EQ(0, output.GetErrno());
+  ASSERT_EQ(pattern.size() * kCopies, output.size());
+  // Spot-check that bytes written before the growths survived them.
+  EXPECT_EQ(pattern, std::string(output.data(), pattern.size()));
+  EXPECT_EQ(pattern,
+            std::string(output.data() + output.size() - pattern.size(),
+                        pattern.size()));
+#else
+  // Without mremap() the reservation is a hard cap: the stream reports
+  // ENOMEM once it is exhausted.
+  void* data;
+  int size;
+  int64_t total = 0;
+  while (output.Next(&data, &size)) total += size;
+  EXPECT_EQ(4096, total);
+  EXPECT_EQ(ENOMEM, output.GetErrno());
+#endif
+}
+#endif  // GOOGLE_PROTOBUF_IO_HAVE_VM_OUTPUT_STREAM
+
 #ifndef _WIN32
 // This tests the FileInputStream with a non blocking file. It opens a pipe in
 // non blocking mode, then starts reading it. The writing thread starts writing
@@ -1497,6 +1980,89 @@ TEST_F(IoTest, BlockingFileIoWithTimeout) {
 }
 #endif
 
+#ifdef GOOGLE_PROTOBUF_IO_HAVE_NONBLOCKING_INPUT_STREAM
+// Feeds a non-blocking pipe in pieces and checks that WOULD_BLOCK is reported
+// between pieces without breaking the stream.
+TEST_F(IoTest, NonBlockingFdInputStreamWouldBlockAndResume) {
+  int fd[2];
+  ASSERT_EQ(pipe(fd), 0);
+  ASSERT_EQ(fcntl(fd[0], F_SETFL, O_NONBLOCK), 0);
+
+  NonBlockingFdInputStream input(fd[0]);
+  int ready_fd = -1;
+  int ready_calls = 0;
+  input.SetReadinessCallback([&](int which) {
+    ready_fd = which;
+    ++ready_calls;
+  });
+
+  const void* data;
+  int size;
+
+  // Nothing written yet: distinguishable from both EOF and an error.
+  EXPECT_FALSE(input.Next(&data, &size));
+  EXPECT_TRUE(input.WouldBlock());
+  EXPECT_EQ(0, input.GetErrno());
+  EXPECT_EQ(fd[0], ready_fd);
+  EXPECT_EQ(1, ready_calls);
+
+  ASSERT_EQ(write(fd[1], "foo", 3), 3);
+  ASSERT_TRUE(input.Next(&data, &size));
+  EXPECT_FALSE(input.WouldBlock());
+  ASSERT_EQ(3, size);
+  EXPECT_EQ(0, memcmp(data, "foo", 3));
+
+  // Drained again.
+  EXPECT_FALSE(input.Next(&data, &size));
+  EXPECT_TRUE(input.WouldBlock());
+  EXPECT_EQ(2, ready_calls);
+
+  // Resume after more data, then observe a true EOF once the writer closes.
+  ASSERT_EQ(write(fd[1], "bar", 3), 3);
+  close(fd[1]);
+  ASSERT_TRUE(input.Next(&data, &size));
+  ASSERT_EQ(3, size);
+  EXPECT_EQ(0, memcmp(data, "bar", 3));
+  EXPECT_EQ(6, input.ByteCount());
+  EXPECT_FALSE(input.Next(&data, &size));
+  EXPECT_FALSE(input.WouldBlock());
+  EXPECT_EQ(0, input.GetErrno());
+
+  close(fd[0]);
+}
+
+TEST_F(IoTest, NonBlockingFdInputStreamBackUpAndSkip) {
+  int fd[2];
+  ASSERT_EQ(pipe(fd), 0);
+  ASSERT_EQ(fcntl(fd[0], F_SETFL, O_NONBLOCK), 0);
+
+  NonBlockingFdInputStream input(fd[0]);
+  const void* data;
+  int size;
+
+  ASSERT_EQ(write(fd[1], "abcdef", 6), 6);
+  ASSERT_TRUE(input.Next(&data, &size));
+  ASSERT_EQ(6, size);
+  input.BackUp(4);
+  EXPECT_EQ(2, input.ByteCount());
+  ASSERT_TRUE(input.Skip(1));
+  ASSERT_TRUE(input.Next(&data, &size));
+  ASSERT_EQ(3, size);
+  EXPECT_EQ(0, memcmp(data, "def", 3));
+
+  // A skip that runs dry reports WOULD_BLOCK and can be resumed as well.
+  EXPECT_FALSE(input.Skip(10));
+  EXPECT_TRUE(input.WouldBlock());
+  ASSERT_EQ(write(fd[1], std::string(10, 'x').data(), 10), 10);
+  EXPECT_TRUE(input.Skip(4));
+  ASSERT_TRUE(input.Next(&data, &size));
+  ASSERT_EQ(6, size);
+
+  close(fd[0]);
+  close(fd[1]);
+}
+#endif  // GOOGLE_PROTOBUF_IO_HAVE_NONBLOCKING_INPUT_STREAM
+
 #if HAVE_ZLIB
 TEST_F(IoTest, GzipFileIo) {
   std::string filename =
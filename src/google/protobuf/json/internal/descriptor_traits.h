@@ -176,11 +176,8 @@ struct Proto2Descriptor {
       return field;
     }
 
-    for (int i = 0; i < d.field_count(); ++i) {
-      const auto* field = d.field(i);
-      if (field->has_json_name() && field->json_name() == name) {
-        return field;
-      }
+    if (const auto* field = d.FindFieldByJsonName(name)) {
+      return field;
     }
 
     return absl::nullopt;
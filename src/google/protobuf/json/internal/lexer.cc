@@ -209,6 +209,12 @@ absl::Status JsonLexer::SkipToToken() {
 }
 
 absl::StatusOr<LocationWith<MaybeOwnedString>> JsonLexer::ParseRawNumber() {
+  double ignored;
+  return ParseRawNumber(&ignored);
+}
+
+absl::StatusOr<LocationWith<MaybeOwnedString>> JsonLexer::ParseRawNumber(
+    double* value) {
   RETURN_IF_ERROR(SkipToToken());
 
   enum { kInt, kFraction, kExponent } state = kInt;
@@ -261,8 +267,9 @@ absl::StatusOr<LocationWith<MaybeOwnedString>> JsonLexer::ParseRawNumber() {
     return number->loc.Invalid("number cannot have trailing period");
   }
 
-  double d;
-  if (!absl::SimpleAtod(number_text, &d) || !std::isfinite(d)) {
+  // SimpleAtod() takes the fast Eisel-Lemire path in absl::from_chars for
+  // almost all inputs, so this conversion doubles as cheap validation.
+  if (!absl::SimpleAtod(number_text, value) || !std::isfinite(*value)) {
     return number->loc.Invalid(
         absl::StrFormat("invalid number: '%s'", number_text));
   }
@@ -286,14 +293,11 @@ absl::StatusOr<LocationWith<MaybeOwnedString>> JsonLexer::ParseRawNumber() {
 }
 
 absl::StatusOr<LocationWith<double>> JsonLexer::ParseNumber() {
-  auto number = ParseRawNumber();
-  RETURN_IF_ERROR(number.status());
-
+  // ParseRawNumber() already converts the text to validate it; reuse that
+  // value instead of converting the same characters a second time.
   double d;
-  if (!absl::SimpleAtod(number->value.AsView(), &d) || !std::isfinite(d)) {
-    return number->loc.Invalid(
-        absl::StrFormat("invalid number: '%s'", number->value.AsView()));
-  }
+  auto number = ParseRawNumber(&d);
+  RETURN_IF_ERROR(number.status());
 
   return LocationWith<double>{d, number->loc};
 }
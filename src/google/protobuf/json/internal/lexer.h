@@ -245,6 +245,11 @@ class JsonLexer {
   // "unquoted keys" extension.
   absl::StatusOr<LocationWith<MaybeOwnedString>> ParseBareWord();
 
+  // Like ParseRawNumber(), but also hands out the converted double, which
+  // validation has to compute anyway; this lets ParseNumber() avoid
+  // converting the same text twice.
+  absl::StatusOr<LocationWith<MaybeOwnedString>> ParseRawNumber(double* value);
+
   absl::Status Advance(size_t bytes) {
     RETURN_IF_ERROR(stream_.Advance(bytes));
     json_loc_.offset += static_cast<int>(bytes);
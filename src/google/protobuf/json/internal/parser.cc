@@ -302,9 +302,13 @@ absl::StatusOr<double> ParseFp(JsonLexer& lex, Field<Traits> field) {
   return n;
 }
 
+// Returns the lexed string without materializing it: escape-free strings stay
+// as views into the lexer's buffer, so the only copy is the one SetString
+// makes into the message. Bytes fields are decoded in place and so must be
+// moved to the heap first.
 template <typename Traits>
-absl::StatusOr<std::string> ParseStrOrBytes(JsonLexer& lex,
-                                            Field<Traits> field) {
+absl::StatusOr<MaybeOwnedString> ParseStrOrBytes(JsonLexer& lex,
+                                                 Field<Traits> field) {
   absl::StatusOr<LocationWith<MaybeOwnedString>> str = lex.ParseUtf8();
   RETURN_IF_ERROR(str.status());
 
@@ -318,7 +322,7 @@ absl::StatusOr<std::string> ParseStrOrBytes(JsonLexer& lex,
     b64.resize(decoded->size());
   }
 
-  return std::move(str->value.ToString());
+  return std::move(str->value);
 }
 
 template <typename Traits>
@@ -498,7 +502,7 @@ absl::Status ParseSingular(JsonLexer& lex, Field<Traits> field,
     case FieldDescriptor::TYPE_BYTES: {
       auto x = ParseStrOrBytes<Traits>(lex, field);
       RETURN_IF_ERROR(x.status());
-      Traits::SetString(field, msg, *x);
+      Traits::SetString(field, msg, x->AsView());
       break;
     }
     case FieldDescriptor::TYPE_ENUM: {
@@ -583,9 +587,14 @@ absl::Status ParseArray(JsonLexer& lex, Field<Traits> field, Msg<Traits>& msg) {
     return lex.Expect("null");
   }
 
+  // The element type is the same for every element, so classify it once up
+  // front instead of re-deriving it from the type name on each element; for
+  // long arrays of scalars (e.g. packed doubles) the per-element string
+  // comparisons show up in profiles.
+  MessageType type = ClassifyMessage(Traits::FieldTypeName(field));
+
   return lex.VisitArray([&]() -> absl::Status {
     lex.path().NextRepeated();
-    MessageType type = ClassifyMessage(Traits::FieldTypeName(field));
 
     if (lex.Peek(JsonLexer::kNull)) {
       if (type == MessageType::kValue) {
@@ -707,8 +716,7 @@ absl::Status ParseMap(JsonLexer& lex, Field<Traits> field, Msg<Traits>& msg) {
                   break;
                 }
                 case FieldDescriptor::TYPE_STRING: {
-                  Traits::SetString(key_field, entry,
-                                    std::move(key.value.ToString()));
+                  Traits::SetString(key_field, entry, key.value.AsView());
                   break;
                 }
                 default:
@@ -1075,7 +1083,7 @@ absl::Status ParseValue(JsonLexer& lex, const Desc<Traits>& desc,
 
       auto str = lex.ParseUtf8();
       RETURN_IF_ERROR(str.status());
-      Traits::SetString(field, msg, std::move(str->value.ToString()));
+      Traits::SetString(field, msg, str->value.AsView());
       break;
     }
     case JsonLexer::kFalse:
@@ -1303,6 +1311,26 @@ absl::Status JsonStringToMessage(absl::string_view input, Message* message,
   return s;
 }
 
+absl::Status StreamParserImpl::Next(Message* message) {
+  if (lexer_.AtEof()) {
+    return absl::OutOfRangeError("no more documents in stream");
+  }
+  message->Clear();
+  // Re-root the error-reporting path at this document's type; the lexer keeps
+  // pointing at path_, and line/column numbers keep accumulating over the
+  // stream so errors name the offending line.
+  path_ = MessagePath(message->GetDescriptor()->full_name());
+
+  ParseProto2Descriptor::Msg msg(message);
+  absl::Status s = ParseMessage<ParseProto2Descriptor>(
+      lexer_, *message->GetDescriptor(), msg, /*any_reparse=*/false);
+  if (PROTOBUF_DEBUG) {
+    ABSL_DLOG(INFO) << "json2/status: " << s;
+    ABSL_DLOG(INFO) << "json2/output: " << message->DebugString();
+  }
+  return s;
+}
+
 absl::Status JsonToBinaryStream(google::protobuf::util::TypeResolver* resolver,
                                 const std::string& type_url,
                                 io::ZeroCopyInputStream* json_input,
@@ -29,6 +29,25 @@ absl::Status JsonToBinaryStream(google::protobuf::util::TypeResolver* resolver,
                                 io::ZeroCopyInputStream* json_input,
                                 io::ZeroCopyOutputStream* binary_output,
                                 json_internal::ParseOptions options);
+
+// Engine behind google::protobuf::json::JsonStreamParser; see json.h for details.
+// Holds a single lexer over the whole stream so that its internal buffers
+// and input position persist across documents.
+class StreamParserImpl {
+ public:
+  StreamParserImpl(io::ZeroCopyInputStream* json_input, ParseOptions options)
+      : path_(""), lexer_(json_input, options, &path_) {}
+
+  // Returns true once only ignorable whitespace remains in the input.
+  bool Done() { return lexer_.AtEof(); }
+
+  // Clears `message` in place and parses the next document into it.
+  absl::Status Next(Message* message);
+
+ private:
+  MessagePath path_;
+  JsonLexer lexer_;
+};
 }  // namespace json_internal
 }  // namespace protobuf
 }  // namespace google
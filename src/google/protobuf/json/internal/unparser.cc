@@ -824,21 +824,101 @@ absl::Status WriteMessage(JsonWriter& writer, const Msg<Traits>& msg,
     }
   }
 }
+
+size_t EstimateJsonSize(const Message& message);
+
+// Estimates the unparsed size of one value of `field`; `index` is the
+// element index for repeated fields and -1 for singular ones.
+size_t EstimateJsonValueSize(const Message& message,
+                             const FieldDescriptor* field,
+                             const Reflection* reflection, int index) {
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_BOOL:
+      return 5;  // "false"
+    case FieldDescriptor::CPPTYPE_INT32:
+    case FieldDescriptor::CPPTYPE_UINT32:
+      return 11;
+    case FieldDescriptor::CPPTYPE_ENUM:
+      return 16;  // Usually printed as a quoted name.
+    case FieldDescriptor::CPPTYPE_INT64:
+    case FieldDescriptor::CPPTYPE_UINT64:
+      return 22;  // Quoted.
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      return 16;
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      return 25;
+    case FieldDescriptor::CPPTYPE_STRING: {
+      std::string scratch;
+      size_t len =
+          (index < 0
+               ? reflection->GetStringReference(message, field, &scratch)
+               : reflection->GetRepeatedStringReference(message, field, index,
+                                                        &scratch))
+              .size();
+      if (field->type() == FieldDescriptor::TYPE_BYTES) {
+        return 2 + (len + 2) / 3 * 4;  // Base64.
+      }
+      return 2 + len + len / 8;  // Quotes plus room for some escapes.
+    }
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      return EstimateJsonSize(
+          index < 0 ? reflection->GetMessage(message, field)
+                    : reflection->GetRepeatedMessage(message, field, index));
+  }
+  return 0;
+}
+
+// Estimates the number of bytes WriteMessage() will produce for `message`,
+// so that string outputs can be presized instead of growing repeatedly as
+// the stream writes through them.  This is a cheap single pass that ignores
+// escaping, whitespace and well-known-type formatting, so it is only a
+// hint: undershooting merely costs the output one more round of growth.
+size_t EstimateJsonSize(const Message& message) {
+  const Reflection* reflection = message.GetReflection();
+  const Descriptor* descriptor = message.GetDescriptor();
+  size_t size = 2;  // "{}"
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    const FieldDescriptor* field = descriptor->field(i);
+    if (field->is_repeated()) {
+      int count = reflection->FieldSize(message, field);
+      if (count == 0) continue;
+      size += field->json_name().size() + 5;  // Quotes, colon, [], comma.
+      for (int j = 0; j < count; ++j) {
+        size += EstimateJsonValueSize(message, field, reflection, j) + 1;
+      }
+    } else {
+      if (!reflection->HasField(message, field)) continue;
+      size += field->json_name().size() + 4;  // Quotes, colon, comma.
+      size += EstimateJsonValueSize(message, field, reflection, -1);
+    }
+  }
+  return size;
+}
 }  // namespace
 
-absl::Status MessageToJsonString(const Message& message, std::string* output,
+absl::Status MessageToJsonStream(const Message& message,
+                                 io::ZeroCopyOutputStream* json_output,
                                  json_internal::WriterOptions options) {
   if (PROTOBUF_DEBUG) {
     ABSL_DLOG(INFO) << "json2/input: " << message.DebugString();
   }
-  io::StringOutputStream out(output);
-  JsonWriter writer(&out, options);
+  JsonWriter writer(json_output, options);
   absl::Status s = WriteMessage<UnparseProto2Descriptor>(
       writer, message, *message.GetDescriptor(), /*is_top_level=*/true);
   if (PROTOBUF_DEBUG) ABSL_DLOG(INFO) << "json2/status: " << s;
   RETURN_IF_ERROR(s);
 
   writer.NewLine();
+  return absl::OkStatus();
+}
+
+absl::Status MessageToJsonString(const Message& message, std::string* output,
+                                 json_internal::WriterOptions options) {
+  {
+    output->reserve(output->size() + EstimateJsonSize(message));
+    io::StringOutputStream out(output);
+    RETURN_IF_ERROR(MessageToJsonStream(message, &out, options));
+  }
   if (PROTOBUF_DEBUG) {
     ABSL_DLOG(INFO) << "json2/output: " << absl::CHexEscape(*output);
   }
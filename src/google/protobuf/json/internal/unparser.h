@@ -22,6 +22,11 @@ namespace json_internal {
 // details.
 absl::Status MessageToJsonString(const Message& message, std::string* output,
                                  json_internal::WriterOptions options);
+// Internal version of google::protobuf::json::MessageToJsonStream; see json.h for
+// details.
+absl::Status MessageToJsonStream(const Message& message,
+                                 io::ZeroCopyOutputStream* json_output,
+                                 json_internal::WriterOptions options);
 // Internal version of google::protobuf::util::BinaryToJsonStream; see json_util.h for
 // details.
 absl::Status BinaryToJsonStream(google::protobuf::util::TypeResolver* resolver,
@@ -109,13 +109,15 @@ class JsonWriter {
   // in an attempt to match the behavior of the ESF parser.
   void Write(double val) {
     if (!MaybeWriteSpecialFp(val)) {
-      Write(io::SimpleDtoa(val));
+      char buf[io::kDoubleToBufferSize];
+      Write(absl::string_view(io::DoubleToBuffer(val, buf)));
     }
   }
 
   void Write(float val) {
     if (!MaybeWriteSpecialFp(val)) {
-      Write(io::SimpleFtoa(val));
+      char buf[io::kFloatToBufferSize];
+      Write(absl::string_view(io::FloatToBuffer(val, buf)));
     }
   }
 
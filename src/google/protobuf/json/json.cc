@@ -7,6 +7,7 @@
 
 #include "google/protobuf/json/json.h"
 
+#include <memory>
 #include <string>
 
 #include "absl/status/status.h"
@@ -98,6 +99,24 @@ absl::Status MessageToJsonString(const Message& message, std::string* output,
   return google::protobuf::json_internal::MessageToJsonString(message, output, opts);
 }
 
+absl::Status MessageToJsonStream(const Message& message,
+                                 io::ZeroCopyOutputStream* json_output,
+                                 const PrintOptions& options) {
+  google::protobuf::json_internal::WriterOptions opts;
+  opts.add_whitespace = options.add_whitespace;
+  opts.preserve_proto_field_names = options.preserve_proto_field_names;
+  opts.always_print_enums_as_ints = options.always_print_enums_as_ints;
+  opts.always_print_fields_with_no_presence =
+      options.always_print_fields_with_no_presence;
+  opts.unquote_int64_if_possible = options.unquote_int64_if_possible;
+
+  // TODO: Drop this setting.
+  opts.allow_legacy_syntax = true;
+
+  return google::protobuf::json_internal::MessageToJsonStream(message, json_output,
+                                                    opts);
+}
+
 absl::Status JsonStringToMessage(absl::string_view input, Message* message,
                                  const ParseOptions& options) {
   google::protobuf::json_internal::ParseOptions opts;
@@ -109,6 +128,27 @@ absl::Status JsonStringToMessage(absl::string_view input, Message* message,
 
   return google::protobuf::json_internal::JsonStringToMessage(input, message, opts);
 }
+
+JsonStreamParser::JsonStreamParser(io::ZeroCopyInputStream* json_input,
+                                   const ParseOptions& options) {
+  google::protobuf::json_internal::ParseOptions opts;
+  opts.ignore_unknown_fields = options.ignore_unknown_fields;
+  opts.case_insensitive_enum_parsing = options.case_insensitive_enum_parsing;
+
+  // TODO: Drop this setting.
+  opts.allow_legacy_syntax = true;
+
+  impl_ = std::make_unique<google::protobuf::json_internal::StreamParserImpl>(json_input,
+                                                                    opts);
+}
+
+JsonStreamParser::~JsonStreamParser() = default;
+
+bool JsonStreamParser::Done() { return impl_->Done(); }
+
+absl::Status JsonStreamParser::Next(Message* message) {
+  return impl_->Next(message);
+}
 }  // namespace json
 }  // namespace protobuf
 }  // namespace google
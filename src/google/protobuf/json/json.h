@@ -10,6 +10,7 @@
 #ifndef GOOGLE_PROTOBUF_JSON_JSON_H__
 #define GOOGLE_PROTOBUF_JSON_JSON_H__
 
+#include <memory>
 #include <string>
 
 #include "absl/status/status.h"
@@ -22,6 +23,10 @@
 
 namespace google {
 namespace protobuf {
+namespace json_internal {
+class StreamParserImpl;
+}  // namespace json_internal
+
 namespace json {
 struct ParseOptions {
   // Whether to ignore unknown JSON fields during parsing
@@ -69,6 +74,24 @@ inline absl::Status MessageToJsonString(const Message& message,
   return MessageToJsonString(message, output, PrintOptions());
 }
 
+// Converts from protobuf message to JSON, writing to the given
+// ZeroCopyOutputStream. Unlike MessageToJsonString(), the document is never
+// materialized in memory: output is emitted incrementally as the message tree
+// is walked (repeated-field elements included), so peak memory stays bounded
+// by the stream's buffer size rather than the document size. It will use the
+// DescriptorPool of the passed-in message to resolve Any types.
+//
+// Please note that non-OK statuses are not a stable output of this API and
+// subject to change without notice.
+PROTOBUF_EXPORT absl::Status MessageToJsonStream(
+    const Message& message, io::ZeroCopyOutputStream* json_output,
+    const PrintOptions& options);
+
+inline absl::Status MessageToJsonStream(const Message& message,
+                                        io::ZeroCopyOutputStream* json_output) {
+  return MessageToJsonStream(message, json_output, PrintOptions());
+}
+
 // Converts from JSON to protobuf message. This works equivalently to
 // JsonToBinaryStream(). It will use the DescriptorPool of the passed-in
 // message to resolve Any types.
@@ -84,6 +107,48 @@ inline absl::Status JsonStringToMessage(absl::string_view input,
   return JsonStringToMessage(input, message, ParseOptions());
 }
 
+// Parses a stream of whitespace-separated JSON documents -- newline-delimited
+// JSON being the common case -- one message at a time.  Unlike calling
+// JsonStringToMessage() once per document, the parser object persists across
+// documents: the lexer's buffers and the input position are retained, and the
+// output message is cleared in place rather than re-created, so per-document
+// setup cost is paid once per stream.
+//
+//   JsonStreamParser parser(&input);
+//   MyMessage message;
+//   while (!parser.Done()) {
+//     RETURN_IF_ERROR(parser.Next(&message));
+//     Process(message);
+//   }
+//
+// Line and column numbers in error statuses are relative to the start of the
+// stream, so they name the offending line of an NDJSON input.  The input
+// stream must outlive the parser.
+//
+// Please note that non-OK statuses are not a stable output of this API and
+// subject to change without notice.
+class PROTOBUF_EXPORT JsonStreamParser {
+ public:
+  explicit JsonStreamParser(io::ZeroCopyInputStream* json_input,
+                            const ParseOptions& options = ParseOptions());
+  ~JsonStreamParser();
+
+  JsonStreamParser(const JsonStreamParser&) = delete;
+  JsonStreamParser& operator=(const JsonStreamParser&) = delete;
+
+  // Returns true once only ignorable whitespace remains in the input.
+  bool Done();
+
+  // Clears `message` in place and parses the next document into it.  Calling
+  // Next() when Done() is true returns an OutOfRange error.  After a parse
+  // error the stream position is unspecified, so the remaining documents
+  // cannot be recovered.
+  absl::Status Next(Message* message);
+
+ private:
+  std::unique_ptr<json_internal::StreamParserImpl> impl_;
+};
+
 // Converts protobuf binary data to JSON.
 // The conversion will fail if:
 //   1. TypeResolver fails to resolve a type.
@@ -147,6 +147,22 @@ class JsonTest : public testing::TestWithParam<Codec> {
 INSTANTIATE_TEST_SUITE_P(JsonTestSuite, JsonTest,
                          testing::Values(Codec::kReflective, Codec::kResolver));
 
+TEST_P(JsonTest, MessageToJsonStreamMatchesString) {
+  TestMessage m;
+  m.set_string_value("foo");
+  m.add_repeated_bool_value(true);
+  m.add_repeated_bool_value(false);
+
+  // Stream output with a tiny block size must match the string API byte for
+  // byte, including when spread across many Next() buffers.
+  std::string streamed;
+  {
+    io::StringOutputStream out(&streamed);
+    ASSERT_OK(MessageToJsonStream(m, &out));
+  }
+  EXPECT_THAT(ToJson(m), IsOkAndHolds(streamed));
+}
+
 TEST_P(JsonTest, TestWhitespaces) {
   TestMessage m;
   m.mutable_message_value();
@@ -1298,6 +1314,85 @@ TEST_P(JsonTest, ClearPreExistingRepeatedInJsonValues) {
   EXPECT_THAT(s.fields(), IsEmpty());
 }
 
+TEST(JsonStreamParserTest, ParsesNewlineDelimitedDocuments) {
+  absl::string_view ndjson =
+      "{\"stringValue\": \"foo\", \"int32Value\": 1}\n"
+      "{\"stringValue\": \"bar\"}\n"
+      "{\"int32Value\": 3}\n";
+  io::ArrayInputStream in(ndjson.data(), ndjson.size());
+  JsonStreamParser parser(&in);
+
+  TestMessage m;
+  ASSERT_FALSE(parser.Done());
+  ASSERT_OK(parser.Next(&m));
+  EXPECT_EQ(m.string_value(), "foo");
+  EXPECT_EQ(m.int32_value(), 1);
+
+  // The message is recycled in place: fields from the previous document must
+  // not leak into the next one.
+  ASSERT_FALSE(parser.Done());
+  ASSERT_OK(parser.Next(&m));
+  EXPECT_EQ(m.string_value(), "bar");
+  EXPECT_EQ(m.int32_value(), 0);
+
+  ASSERT_FALSE(parser.Done());
+  ASSERT_OK(parser.Next(&m));
+  EXPECT_EQ(m.string_value(), "");
+  EXPECT_EQ(m.int32_value(), 3);
+
+  EXPECT_TRUE(parser.Done());
+  EXPECT_THAT(parser.Next(&m), StatusIs(absl::StatusCode::kOutOfRange));
+}
+
+TEST(JsonStreamParserTest, DoneSkipsTrailingWhitespace) {
+  absl::string_view ndjson = "{}\n  \n\t";
+  io::ArrayInputStream in(ndjson.data(), ndjson.size());
+  JsonStreamParser parser(&in);
+
+  TestMessage m;
+  ASSERT_FALSE(parser.Done());
+  ASSERT_OK(parser.Next(&m));
+  EXPECT_TRUE(parser.Done());
+}
+
+TEST(JsonStreamParserTest, EmptyStreamIsImmediatelyDone) {
+  io::ArrayInputStream in("", 0);
+  JsonStreamParser parser(&in);
+  EXPECT_TRUE(parser.Done());
+
+  TestMessage m;
+  EXPECT_THAT(parser.Next(&m), StatusIs(absl::StatusCode::kOutOfRange));
+}
+
+TEST(JsonStreamParserTest, ErrorsNameTheOffendingLine) {
+  absl::string_view ndjson =
+      "{\"stringValue\": \"ok\"}\n"
+      "{\"int32Value\": \"garbage\"}\n";
+  io::ArrayInputStream in(ndjson.data(), ndjson.size());
+  JsonStreamParser parser(&in);
+
+  TestMessage m;
+  ASSERT_OK(parser.Next(&m));
+  absl::Status s = parser.Next(&m);
+  EXPECT_THAT(s, StatusIs(absl::StatusCode::kInvalidArgument));
+  // Locations are stream-relative, so the error points at the second line.
+  EXPECT_THAT(s.message(), ContainsRegex("near *2 *:"));
+}
+
+TEST(JsonStreamParserTest, DocumentsSplitAcrossStreamChunks) {
+  io::internal::TestZeroCopyInputStream in(
+      {"{\"stringValue\": \"fo", "o\"}\n{\"int32", "Value\": 2}"});
+  JsonStreamParser parser(&in);
+
+  TestMessage m;
+  ASSERT_OK(parser.Next(&m));
+  EXPECT_EQ(m.string_value(), "foo");
+
+  ASSERT_OK(parser.Next(&m));
+  EXPECT_EQ(m.int32_value(), 2);
+  EXPECT_TRUE(parser.Done());
+}
+
 TEST(JsonErrorTest, FieldNameAndSyntaxErrorInSeparateChunks) {
   std::unique_ptr<TypeResolver> resolver{
       google::protobuf::util::NewTypeResolverForDescriptorPool(
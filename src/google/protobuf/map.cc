@@ -118,6 +118,7 @@ TableEntryPtr UntypedMapBase::ConvertToTree(NodeBase* node, GetKey get_key) {
 
 void UntypedMapBase::ClearTable(const ClearInput input) {
   ABSL_DCHECK_NE(num_buckets_, kGlobalEmptyTableSize);
+  ++mod_count_;
 
   if (alloc_.arena() == nullptr) {
     const auto loop = [=](auto destroy_node) {
@@ -24,6 +24,7 @@
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #if !defined(GOOGLE_PROTOBUF_NO_RDTSC) && defined(__APPLE__)
 #include <time.h>
@@ -31,6 +32,7 @@
 
 #include "google/protobuf/stubs/common.h"
 #include "absl/base/attributes.h"
+#include "absl/base/prefetch.h"
 #include "absl/container/btree_map.h"
 #include "absl/hash/hash.h"
 #include "absl/log/absl_check.h"
@@ -57,6 +59,9 @@ namespace protobuf {
 template <typename Key, typename T>
 class Map;
 
+template <typename Key, typename T>
+class MapOrderedView;
+
 class MapIterator;
 
 template <typename Enum>
@@ -552,6 +557,8 @@ class PROTOBUF_EXPORT UntypedMapBase {
         num_buckets_(internal::kGlobalEmptyTableSize),
         seed_(0),
         index_of_first_non_null_(internal::kGlobalEmptyTableSize),
+        reserved_buckets_(0),
+        mod_count_(0),
         table_(const_cast<TableEntryPtr*>(internal::kGlobalEmptyTable)),
         alloc_(arena) {}
 
@@ -570,8 +577,13 @@ class PROTOBUF_EXPORT UntypedMapBase {
     std::swap(num_buckets_, other->num_buckets_);
     std::swap(seed_, other->seed_);
     std::swap(index_of_first_non_null_, other->index_of_first_non_null_);
+    std::swap(reserved_buckets_, other->reserved_buckets_);
     std::swap(table_, other->table_);
     std::swap(alloc_, other->alloc_);
+    // Both maps change contents; swapping the counters could leave either one
+    // with its old value, so move both strictly forward instead.
+    mod_count_ = other->mod_count_ =
+        (std::max)(mod_count_, other->mod_count_) + 1;
   }
 
   static size_type max_size() {
@@ -792,6 +804,15 @@ class PROTOBUF_EXPORT UntypedMapBase {
   map_index_t num_buckets_;
   map_index_t seed_;
   map_index_t index_of_first_non_null_;
+  // Floor set by reserve(): load-based shrinking never takes the table below
+  // this many buckets. Zero when no reservation was made.
+  map_index_t reserved_buckets_;
+  // Incremented on every insert, erase, clear, and swap so that caches built
+  // over the map contents (see MapOrderedView) can cheaply detect staleness.
+  // Rehashing bumps it too, which only costs such caches a spurious rebuild.
+  // On 64-bit builds this occupies the padding before table_, so it does not
+  // grow the map.
+  map_index_t mod_count_;
   TableEntryPtr* table_;  // an array with num_buckets_ entries
   Allocator alloc_;
 };
@@ -939,6 +960,7 @@ class KeyMapBase : public UntypedMapBase {
       EraseFromTree(b, tree_it);
     }
     --num_elements_;
+    ++mod_count_;
     if (PROTOBUF_PREDICT_FALSE(b == index_of_first_non_null_)) {
       while (index_of_first_non_null_ < num_buckets_ &&
              TableEntryIsEmpty(index_of_first_non_null_)) {
@@ -949,10 +971,27 @@ class KeyMapBase : public UntypedMapBase {
 
   NodeAndBucket FindHelper(typename TS::ViewType k,
                            TreeIterator* it = nullptr) const {
-    map_index_t b = BucketNumber(k);
+    return FindHelperWithHash(k, hash_function()(k), it);
+  }
+
+  // Like FindHelper, but for callers that already computed hash_function()(k)
+  // upstream; the per-table seed is still mixed in here, so a raw key hash is
+  // valid for every table.
+  NodeAndBucket FindHelperWithHash(typename TS::ViewType k, uint64_t key_hash,
+                                   TreeIterator* it = nullptr) const {
+    ABSL_DCHECK_EQ(key_hash, static_cast<uint64_t>(hash_function()(k)));
+    map_index_t b = BucketNumberFromHash(key_hash);
+    ABSL_DCHECK_EQ(b, VariantBucketNumber(RealKeyToVariantKey<Key>{}(k)));
     if (TableEntryIsNonEmptyList(b)) {
       auto* node = internal::TableEntryToNode(table_[b]);
       do {
+        // Chained nodes are individually allocated and rarely share cache
+        // lines; start fetching the next node while comparing the current
+        // key, which overlaps the miss with the (possibly out-of-line
+        // string) comparison.
+        if (node->next != nullptr) {
+          absl::PrefetchToLocalCache(node->next);
+        }
         if (TS::Equals(static_cast<KeyNode*>(node)->key(), k)) {
           return {node, b};
         } else {
@@ -996,6 +1035,7 @@ class KeyMapBase : public UntypedMapBase {
     // or whatever.  But it's probably cheap enough to recompute that here;
     // it's likely that we're inserting into an empty or short list.
     ABSL_DCHECK(FindHelper(node->key()).node == nullptr);
+    ++mod_count_;
     if (TableEntryIsEmpty(b)) {
       InsertUniqueInList(b, node);
       index_of_first_non_null_ = (std::min)(index_of_first_non_null_, b);
@@ -1054,6 +1094,13 @@ class KeyMapBase : public UntypedMapBase {
       }
       size_type new_num_buckets = std::max<size_type>(
           kMinTableSize, num_buckets_ >> lg2_of_size_reduction_factor);
+      // A reserve() pins the table: shrinking below the reserved size would
+      // undo the presizing on the first insert after the reservation. The
+      // clamp never grows the table here, even if a reservation outlived its
+      // bucket array.
+      new_num_buckets = std::max<size_type>(
+          new_num_buckets,
+          std::min<size_type>(reserved_buckets_, num_buckets_));
       if (new_num_buckets != num_buckets_) {
         Resize(new_num_buckets);
         return true;
@@ -1062,6 +1109,31 @@ class KeyMapBase : public UntypedMapBase {
     return false;
   }
 
+  // Grows the table until `target_size` elements fit under the load-factor
+  // cutoff, so that many inserts reach the target with a single rehash
+  // instead of log(n) incremental doublings. Never shrinks; a no-op when the
+  // table is already large enough.
+  void ReserveGrowthForSize(size_type target_size) {
+    if (target_size == 0) return;
+    map_index_t needed_buckets = kMinTableSize;
+    while (CalculateHiCutoff(needed_buckets) < target_size &&
+           needed_buckets <= max_size() / 2) {
+      needed_buckets *= 2;
+    }
+    reserved_buckets_ = (std::max)(reserved_buckets_, needed_buckets);
+    if (needed_buckets <= num_buckets_ &&
+        num_buckets_ != kGlobalEmptyTableSize) {
+      return;
+    }
+    if (num_buckets_ == kGlobalEmptyTableSize) {
+      // Resize() on the global empty array installs the minimum table
+      // regardless of the requested size, so it may take a second Resize()
+      // below to reach the target.
+      Resize(kMinTableSize);
+    }
+    if (needed_buckets > num_buckets_) Resize(needed_buckets);
+  }
+
   // Resize to the given number of buckets.
   void Resize(map_index_t new_num_buckets) {
     if (num_buckets_ == kGlobalEmptyTableSize) {
@@ -1395,14 +1467,16 @@ class Map : private internal::KeyMapBase<internal::KeyForBase<Key>> {
   template <typename K = key_type>
   const T& at(const key_arg<K>& key) const ABSL_ATTRIBUTE_LIFETIME_BOUND {
     const_iterator it = find(key);
-    ABSL_CHECK(it != end()) << "key not found: " << static_cast<Key>(key);
+    PROTOBUF_HARDENING_ASSERT(it != end())
+        << "key not found: " << static_cast<Key>(key);
     return it->second;
   }
 
   template <typename K = key_type>
   T& at(const key_arg<K>& key) ABSL_ATTRIBUTE_LIFETIME_BOUND {
     iterator it = find(key);
-    ABSL_CHECK(it != end()) << "key not found: " << static_cast<Key>(key);
+    PROTOBUF_HARDENING_ASSERT(it != end())
+        << "key not found: " << static_cast<Key>(key);
     return it->second;
   }
 
@@ -1464,9 +1538,22 @@ class Map : private internal::KeyMapBase<internal::KeyForBase<Key>> {
     //  (2) Constructed in-place with the arena and then assigned with a
     //      mapped_type temporary constructed with the given args, otherwise.
     return ArenaAwareTryEmplace(Arena::is_arena_constructable<mapped_type>(),
+                                this->hash_function()(TS::ToView(k)),
                                 std::forward<K>(k),
                                 std::forward<Args>(args)...);
   }
+  // Variant of try_emplace for callers that already computed
+  // hash_function()(k) upstream, e.g. to route the key to a shard; the key is
+  // not rehashed here. The per-table seed is mixed in afterwards, so the same
+  // precomputed hash is valid for every Map with this key type.
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> try_emplace_with_hash(size_t key_hash, K&& k,
+                                                  Args&&... args)
+      ABSL_ATTRIBUTE_LIFETIME_BOUND {
+    return ArenaAwareTryEmplace(Arena::is_arena_constructable<mapped_type>(),
+                                key_hash, std::forward<K>(k),
+                                std::forward<Args>(args)...);
+  }
   std::pair<iterator, bool> insert(init_type&& value)
       ABSL_ATTRIBUTE_LIFETIME_BOUND {
     return try_emplace(std::move(value.first), std::move(value.second));
@@ -1483,10 +1570,8 @@ class Map : private internal::KeyMapBase<internal::KeyForBase<Key>> {
   }
   template <class InputIt>
   void insert(InputIt first, InputIt last) {
-    for (; first != last; ++first) {
-      auto&& pair = *first;
-      try_emplace(pair.first, pair.second);
-    }
+    InsertRange(first, last,
+                typename std::iterator_traits<InputIt>::iterator_category());
   }
   void insert(std::initializer_list<init_type> values) {
     insert(values.begin(), values.end());
@@ -1557,6 +1642,10 @@ class Map : private internal::KeyMapBase<internal::KeyForBase<Key>> {
 
   hasher hash_function() const { return {}; }
 
+  // Grows the hash table so that `n` elements fit under the load-factor
+  // cutoff without further rehashing. Never shrinks the table.
+  void reserve(size_type n) { this->ReserveGrowthForSize(n); }
+
   size_t SpaceUsedExcludingSelfLong() const {
     if (empty()) return 0;
     return SpaceUsedInternal() + internal::SpaceUsedInValues(this);
@@ -1614,16 +1703,39 @@ class Map : private internal::KeyMapBase<internal::KeyForBase<Key>> {
     return insert(value_type(std::forward<Args>(args)...));
   }
 
+  template <class InputIt>
+  void InsertRange(InputIt first, InputIt last, std::input_iterator_tag) {
+    for (; first != last; ++first) {
+      auto&& pair = *first;
+      try_emplace(pair.first, pair.second);
+    }
+  }
+  template <class ForwardIt>
+  void InsertRange(ForwardIt first, ForwardIt last,
+                   std::forward_iterator_tag) {
+    // The range can be walked twice, so presize for the worst case (every key
+    // new) and insert the whole range with at most one rehash instead of
+    // log(n) incremental doublings.
+    this->ReserveGrowthForSize(this->num_elements_ +
+                               static_cast<size_type>(
+                                   std::distance(first, last)));
+    for (; first != last; ++first) {
+      auto&& pair = *first;
+      try_emplace(pair.first, pair.second);
+    }
+  }
+
   template <typename K, typename... Args>
-  std::pair<iterator, bool> TryEmplaceInternal(K&& k, Args&&... args) {
-    auto p = this->FindHelper(TS::ToView(k));
+  std::pair<iterator, bool> TryEmplaceInternal(size_t key_hash, K&& k,
+                                               Args&&... args) {
+    auto p = this->FindHelperWithHash(TS::ToView(k), key_hash);
     // Case 1: key was already present.
     if (p.node != nullptr)
       return std::make_pair(
           iterator(static_cast<Node*>(p.node), this, p.bucket), false);
     // Case 2: insert.
     if (this->ResizeIfLoadIsOutOfRange(this->num_elements_ + 1)) {
-      p = this->FindHelper(TS::ToView(k));
+      p = this->FindHelperWithHash(TS::ToView(k), key_hash);
     }
     const auto b = p.bucket;  // bucket number
     // If K is not key_type, make the conversion to key_type explicit.
@@ -1668,15 +1780,17 @@ class Map : private internal::KeyMapBase<internal::KeyForBase<Key>> {
   // created and then (if `Args` are not empty) assigned to a mapped value
   // that was created with the arena.
   template <typename K>
-  std::pair<iterator, bool> ArenaAwareTryEmplace(std::true_type, K&& k) {
+  std::pair<iterator, bool> ArenaAwareTryEmplace(std::true_type,
+                                                 size_t key_hash, K&& k) {
     // case 1.1: "default" constructed (e.g. from arena only).
-    return TryEmplaceInternal(std::forward<K>(k));
+    return TryEmplaceInternal(key_hash, std::forward<K>(k));
   }
   template <typename K, typename... Args>
-  std::pair<iterator, bool> ArenaAwareTryEmplace(std::true_type, K&& k,
+  std::pair<iterator, bool> ArenaAwareTryEmplace(std::true_type,
+                                                 size_t key_hash, K&& k,
                                                  Args&&... args) {
     // case 1.2: "default" constructed + copy/move assignment
-    auto p = TryEmplaceInternal(std::forward<K>(k));
+    auto p = TryEmplaceInternal(key_hash, std::forward<K>(k));
     if (p.second) {
       AssignMapped(std::is_same<void(typename std::decay<Args>::type...),
                                 void(mapped_type)>(),
@@ -1688,8 +1802,9 @@ class Map : private internal::KeyMapBase<internal::KeyForBase<Key>> {
   // construction.
   template <typename... Args>
   std::pair<iterator, bool> ArenaAwareTryEmplace(std::false_type,
+                                                 size_t key_hash,
                                                  Args&&... args) {
-    return TryEmplaceInternal(std::forward<Args>(args)...);
+    return TryEmplaceInternal(key_hash, std::forward<Args>(args)...);
   }
 
   using Base::arena;
@@ -1704,6 +1819,108 @@ class Map : private internal::KeyMapBase<internal::KeyForBase<Key>> {
   friend class internal::TcParser;
   friend struct internal::MapTestPeer;
   friend struct internal::MapBenchmarkPeer;
+  friend class MapOrderedView<Key, T>;
+};
+
+// A key-ordered view over a Map, for code that repeatedly scans the same map
+// in sorted order (e.g. exporters that emit deterministic output). The view
+// holds a compact array of pointers to the map's elements, sorted by key, so
+// an ordered scan is a linear sweep over the array instead of a sort per
+// scan. The array is built lazily on the first ordered iteration and is
+// reused until the map changes structurally (insert, erase, clear, swap);
+// staleness is detected with a modification counter, so an unchanged map
+// costs O(1) to revalidate and a changed one costs one O(n log n) rebuild.
+// Element pointers stay valid across rehashing, value updates through
+// operator[] on existing keys do not invalidate the view, and the view adds
+// no cost to maps that do not use it.
+//
+// The view must not outlive the map, and like Map itself it is not safe to
+// use concurrently with mutations.
+//
+// Example:
+//   MapOrderedView<std::string, int64_t> ordered(counters);
+//   for (const auto& entry : ordered) {  // ascending by key, sort-free
+//     Export(entry.first, entry.second);
+//   }
+template <typename Key, typename T>
+class MapOrderedView {
+ public:
+  using value_type = typename Map<Key, T>::value_type;
+
+  class const_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = typename Map<Key, T>::value_type;
+    using difference_type = ptrdiff_t;
+    using pointer = const value_type*;
+    using reference = const value_type&;
+
+    const_iterator() : it_(nullptr) {}
+
+    reference operator*() const { return **it_; }
+    pointer operator->() const { return *it_; }
+
+    const_iterator& operator++() {
+      ++it_;
+      return *this;
+    }
+    const_iterator operator++(int) {
+      auto copy = *this;
+      ++it_;
+      return copy;
+    }
+
+    friend bool operator==(const const_iterator& a, const const_iterator& b) {
+      return a.it_ == b.it_;
+    }
+    friend bool operator!=(const const_iterator& a, const const_iterator& b) {
+      return !(a == b);
+    }
+
+   private:
+    explicit const_iterator(const value_type* const* it) : it_(it) {}
+    friend class MapOrderedView;
+
+    const value_type* const* it_;
+  };
+
+  explicit MapOrderedView(const Map<Key, T>& map ABSL_ATTRIBUTE_LIFETIME_BOUND)
+      : map_(&map) {}
+  MapOrderedView(const MapOrderedView&) = delete;
+  MapOrderedView& operator=(const MapOrderedView&) = delete;
+
+  const_iterator begin() const ABSL_ATTRIBUTE_LIFETIME_BOUND {
+    Revalidate();
+    return const_iterator(entries_.data());
+  }
+  const_iterator end() const ABSL_ATTRIBUTE_LIFETIME_BOUND {
+    Revalidate();
+    return const_iterator(entries_.data() + entries_.size());
+  }
+
+  size_t size() const { return map_->size(); }
+  bool empty() const { return map_->empty(); }
+
+ private:
+  void Revalidate() const {
+    if (built_ && epoch_ == map_->mod_count_) return;
+    entries_.clear();
+    entries_.reserve(map_->size());
+    for (const value_type& entry : *map_) {
+      entries_.push_back(&entry);
+    }
+    std::sort(entries_.begin(), entries_.end(),
+              [](const value_type* a, const value_type* b) {
+                return a->first < b->first;
+              });
+    epoch_ = map_->mod_count_;
+    built_ = true;
+  }
+
+  const Map<Key, T>* map_;
+  mutable std::vector<const value_type*> entries_;
+  mutable internal::map_index_t epoch_ = 0;
+  mutable bool built_ = false;
 };
 
 namespace internal {
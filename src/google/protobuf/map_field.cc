@@ -7,6 +7,7 @@
 
 #include "google/protobuf/map_field.h"
 
+#include <algorithm>
 #include <utility>
 #include <vector>
 
@@ -99,6 +100,36 @@ RepeatedPtrFieldBase* MapFieldBase::MutableRepeatedField() {
   return reinterpret_cast<RepeatedPtrFieldBase*>(&payload().repeated_field);
 }
 
+const std::vector<MapKey>& MapFieldBase::GetSortedKeyList() const {
+  ConstAccess();
+  // Bring the map up to date before taking the mutex; SyncMapWithRepeatedField
+  // locks it itself.
+  SyncMapWithRepeatedField();
+  auto& p = payload();
+  if (!p.sorted_keys_valid.load(std::memory_order_acquire)) {
+    absl::MutexLock lock(&p.mutex);
+    // Double check under the lock, as in SyncRepeatedFieldWithMap().
+    if (!p.sorted_keys_valid.load(std::memory_order_relaxed)) {
+      const Descriptor* descriptor = GetPrototype()->GetDescriptor();
+      auto* self = const_cast<MapFieldBase*>(this);
+      MapIterator it(self, descriptor);
+      MapIterator end(self, descriptor);
+      it.iter_ = self->GetMapRaw().begin();
+      SetMapIteratorValue(&it);
+      end.iter_ = UntypedMapBase::EndIterator();
+      p.sorted_keys.clear();
+      p.sorted_keys.reserve(GetMapRaw().size());
+      for (; !EqualIterator(it, end); IncreaseIterator(&it)) {
+        p.sorted_keys.push_back(it.GetKey());
+      }
+      std::sort(p.sorted_keys.begin(), p.sorted_keys.end());
+      p.sorted_keys_valid.store(true, std::memory_order_release);
+    }
+    ConstAccess();
+  }
+  return p.sorted_keys;
+}
+
 template <typename T>
 static void SwapRelaxed(std::atomic<T>& a, std::atomic<T>& b) {
   auto value_b = b.load(std::memory_order_relaxed);
@@ -138,6 +169,8 @@ void MapFieldBase::SwapImpl(MapFieldBase& lhs, MapFieldBase& rhs) {
   if (p2 == nullptr) p2 = &rhs.payload();
   p1->repeated_field.Swap(&p2->repeated_field);
   SwapRelaxed(p1->state, p2->state);
+  p1->sorted_keys.swap(p2->sorted_keys);
+  SwapRelaxed(p1->sorted_keys_valid, p2->sorted_keys_valid);
 }
 
 void MapFieldBase::UnsafeShallowSwapImpl(MapFieldBase& lhs, MapFieldBase& rhs) {
@@ -178,14 +211,18 @@ void MapFieldBase::SetMapDirty() {
   MutableAccess();
   // These are called by (non-const) mutator functions. So by our API it's the
   // callers responsibility to have these calls properly ordered.
-  payload().state.store(STATE_MODIFIED_MAP, std::memory_order_relaxed);
+  auto& p = payload();
+  p.state.store(STATE_MODIFIED_MAP, std::memory_order_relaxed);
+  p.sorted_keys_valid.store(false, std::memory_order_relaxed);
 }
 
 void MapFieldBase::SetRepeatedDirty() {
   MutableAccess();
   // These are called by (non-const) mutator functions. So by our API it's the
   // callers responsibility to have these calls properly ordered.
-  payload().state.store(STATE_MODIFIED_REPEATED, std::memory_order_relaxed);
+  auto& p = payload();
+  p.state.store(STATE_MODIFIED_REPEATED, std::memory_order_relaxed);
+  p.sorted_keys_valid.store(false, std::memory_order_relaxed);
 }
 
 void MapFieldBase::SyncRepeatedFieldWithMap() const {
@@ -223,8 +260,16 @@ void MapFieldBase::SyncRepeatedFieldWithMapNoLock() {
   end.iter_ = UntypedMapBase::EndIterator();
 
   for (; !EqualIterator(it, end); IncreaseIterator(&it)) {
-    Message* new_entry = prototype->New(arena());
-    rep.AddAllocated(new_entry);
+    // Reuse entry messages cleared by a previous sync where possible.
+    // Otherwise AddAllocated() below would delete a cleared entry just to
+    // make room for the freshly allocated one, making every resync pay a
+    // full generation of entry deallocations and allocations.
+    Message* new_entry = reinterpret_cast<RepeatedPtrFieldBase&>(rep)
+                             .AddFromCleared<GenericTypeHandler<Message>>();
+    if (new_entry == nullptr) {
+      new_entry = prototype->New(arena());
+      rep.AddAllocated(new_entry);
+    }
     const MapKey& map_key = it.GetKey();
     switch (key_des->cpp_type()) {
       case FieldDescriptor::CPPTYPE_STRING:
@@ -15,9 +15,11 @@
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "absl/log/absl_check.h"
 #include "absl/log/absl_log.h"
+#include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
 #include "google/protobuf/arena.h"
 #include "google/protobuf/descriptor.h"
@@ -112,9 +114,13 @@ class PROTOBUF_EXPORT MapKey {
     SetType(FieldDescriptor::CPPTYPE_BOOL);
     val_.bool_value = value;
   }
-  void SetStringValue(std::string val) {
+  // Accepts any string-like key (std::string, string_view, literals) and
+  // copies it into the MapKey's own storage, reusing existing capacity. This
+  // lets reflection callers that already hold a view perform repeated map
+  // lookups without materializing a std::string per call.
+  void SetStringValue(absl::string_view val) {
     SetType(FieldDescriptor::CPPTYPE_STRING);
-    *val_.string_value.get_mutable() = std::move(val);
+    val_.string_value.get_mutable()->assign(val.data(), val.size());
   }
 
   int64_t GetInt64Value() const {
@@ -361,6 +367,14 @@ class PROTOBUF_EXPORT MapFieldBase : public MapFieldBaseForParse {
   // Like above. Returns mutable pointer to the internal repeated field.
   RepeatedPtrFieldBase* MutableRepeatedField();
 
+  // Returns the map's keys in ascending order, for deterministic
+  // serialization.  The sorted list is cached in the reflection payload and
+  // reused until the map is next mutated, so serializing an unmodified
+  // message repeatedly sorts once rather than per call.  As with the
+  // repeated-field view, mutations must go through the map field's own
+  // accessors to be observed.
+  const std::vector<MapKey>& GetSortedKeyList() const;
+
   const VTable* vtable() const { return static_cast<const VTable*>(vtable_); }
 
   bool ContainsMapKey(const MapKey& map_key) const {
@@ -477,6 +491,12 @@ class PROTOBUF_EXPORT MapFieldBase : public MapFieldBaseForParse {
     absl::Mutex mutex;  // The thread to synchronize map and repeated
                         // field needs to get lock first;
     std::atomic<State> state{STATE_MODIFIED_MAP};
+
+    // Keys in ascending order, built lazily by GetSortedKeyList() and kept
+    // until the next mutation.  Written under `mutex`; `sorted_keys_valid`
+    // is cleared by mutators the same way `state` is.
+    std::vector<MapKey> sorted_keys;
+    std::atomic<bool> sorted_keys_valid{false};
   };
 
   Arena* arena() const {
@@ -873,9 +893,9 @@ class PROTOBUF_EXPORT MapValueRef final : public MapValueConstRef {
     TYPE_CHECK(FieldDescriptor::CPPTYPE_ENUM, "MapValueRef::SetEnumValue");
     *reinterpret_cast<int*>(data_) = value;
   }
-  void SetStringValue(const std::string& value) {
+  void SetStringValue(absl::string_view value) {
     TYPE_CHECK(FieldDescriptor::CPPTYPE_STRING, "MapValueRef::SetStringValue");
-    *reinterpret_cast<std::string*>(data_) = value;
+    reinterpret_cast<std::string*>(data_)->assign(value.data(), value.size());
   }
   void SetFloatValue(float value) {
     TYPE_CHECK(FieldDescriptor::CPPTYPE_FLOAT, "MapValueRef::SetFloatValue");
@@ -109,6 +109,50 @@ TEST_P(MapFieldBasePrimitiveTest, GetRepeatedField) {
   }
 }
 
+TEST_P(MapFieldBasePrimitiveTest, ResyncReusesEntryMessages) {
+  const RepeatedPtrField<Message>& repeated =
+      reinterpret_cast<const RepeatedPtrField<Message>&>(
+          map_field_base_->GetRepeatedField());
+  ASSERT_EQ(2, repeated.size());
+  absl::flat_hash_map<const Message*, bool> old_entries;
+  for (const Message& message : repeated) old_entries[&message] = true;
+
+  // Dirty the map without changing its size and trigger a resync. The
+  // existing entry messages are cleared and reused rather than deallocated
+  // and replaced.
+  (*map_field_->MutableMap())[0] = 200;
+  const RepeatedPtrField<Message>& resynced =
+      reinterpret_cast<const RepeatedPtrField<Message>&>(
+          map_field_base_->GetRepeatedField());
+  ASSERT_EQ(&repeated, &resynced);
+  ASSERT_EQ(2, resynced.size());
+  for (const Message& message : resynced) {
+    EXPECT_TRUE(old_entries.contains(&message));
+    int key = message.GetReflection()->GetInt32(message, key_descriptor_);
+    int value = message.GetReflection()->GetInt32(message, value_descriptor_);
+    EXPECT_EQ(value, key == 0 ? 200 : initial_value_map_[key]);
+  }
+}
+
+TEST_P(MapFieldBasePrimitiveTest, GetSortedKeyList) {
+  const std::vector<MapKey>& sorted_keys = map_field_base_->GetSortedKeyList();
+  ASSERT_EQ(2, sorted_keys.size());
+  EXPECT_EQ(0, sorted_keys[0].GetInt32Value());
+  EXPECT_EQ(1, sorted_keys[1].GetInt32Value());
+
+  // Until the next mutation, repeated calls reuse the cached list.
+  EXPECT_EQ(&sorted_keys, &map_field_base_->GetSortedKeyList());
+
+  // A mutation invalidates the cache and the list is rebuilt in order.
+  (*map_field_->MutableMap())[-5] = 102;
+  const std::vector<MapKey>& resorted_keys =
+      map_field_base_->GetSortedKeyList();
+  ASSERT_EQ(3, resorted_keys.size());
+  EXPECT_EQ(-5, resorted_keys[0].GetInt32Value());
+  EXPECT_EQ(0, resorted_keys[1].GetInt32Value());
+  EXPECT_EQ(1, resorted_keys[2].GetInt32Value());
+}
+
 TEST_P(MapFieldBasePrimitiveTest, MutableRepeatedField) {
   RepeatedPtrField<Message>* repeated =
       reinterpret_cast<RepeatedPtrField<Message>*>(
@@ -235,6 +235,71 @@ TEST(MapTest, LoadFactorCalculationWorks) {
   }
 }
 
+TEST(MapTest, ReservePresizesAndPinsTable) {
+  Map<int, int> map;
+  map.reserve(1000);
+  const size_t reserved_buckets = MapTestPeer::NumBuckets(map);
+  EXPECT_GE(MapTestPeer::CalculateHiCutoff(reserved_buckets), 1000);
+
+  // Low load after a reservation must not shrink the table back down.
+  map[0] = 0;
+  EXPECT_EQ(MapTestPeer::NumBuckets(map), reserved_buckets);
+
+  // Filling up to the reserved size must not grow it either.
+  for (int i = 0; i < 1000; ++i) {
+    map[i] = i;
+  }
+  EXPECT_EQ(MapTestPeer::NumBuckets(map), reserved_buckets);
+
+  // clear() keeps the bucket array, so the reservation survives it.
+  map.clear();
+  map[0] = 0;
+  EXPECT_EQ(MapTestPeer::NumBuckets(map), reserved_buckets);
+}
+
+TEST(MapTest, RangeInsertPresizesForForwardIterators) {
+  std::vector<std::pair<int, int>> values;
+  for (int i = 0; i < 1000; ++i) {
+    values.push_back({i, i * 2});
+  }
+
+  Map<int, int> map;
+  map.insert(values.begin(), values.end());
+  ASSERT_EQ(map.size(), 1000);
+  EXPECT_EQ(map[123], 246);
+  // The range presized the table: it matches what an explicit reservation of
+  // the same size yields, instead of the result of incremental doublings.
+  Map<int, int> reserved;
+  reserved.reserve(1000);
+  EXPECT_EQ(MapTestPeer::NumBuckets(map), MapTestPeer::NumBuckets(reserved));
+}
+
+TEST(MapTest, TryEmplaceWithHashMatchesPlainInsert) {
+  Map<std::string, int> map;
+  const auto hash = map.hash_function();
+
+  auto p = map.try_emplace_with_hash(hash("hello"), "hello", 1);
+  EXPECT_TRUE(p.second);
+  EXPECT_EQ(p.first->second, 1);
+  // A duplicate key is found, not replaced, just like try_emplace.
+  p = map.try_emplace_with_hash(hash("hello"), "hello", 2);
+  EXPECT_FALSE(p.second);
+  EXPECT_EQ(p.first->second, 1);
+
+  // Pre-hashed and plain inserts interoperate on the same table.
+  map.try_emplace("world", 3);
+  for (int i = 0; i < 100; ++i) {
+    const std::string key = absl::StrCat("key", i);
+    EXPECT_TRUE(map.try_emplace_with_hash(hash(key), key, i).second);
+  }
+  EXPECT_EQ(map.size(), 102);
+  for (int i = 0; i < 100; ++i) {
+    const auto it = map.find(absl::StrCat("key", i));
+    ASSERT_NE(it, map.end());
+    EXPECT_EQ(it->second, i);
+  }
+}
+
 TEST(MapTest, NaturalGrowthOnArenasReuseBlocks) {
   Arena arena;
   std::vector<Map<int, int>*> values;
@@ -15,6 +15,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <functional>
 #include <new>  // IWYU pragma: keep for operator new().
 #include <queue>
 #include <string>
@@ -24,6 +25,7 @@
 #include "absl/base/optimization.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/functional/function_ref.h"
 #include "absl/hash/hash.h"
 #include "absl/log/absl_check.h"
 #include "absl/log/absl_log.h"
@@ -166,6 +168,10 @@ size_t Message::ByteSizeLong() const {
   return size;
 }
 
+size_t Message::ByteSizeUpperBound() const {
+  return WireFormat::ByteSizeUpperBound(*this);
+}
+
 size_t Message::ComputeUnknownFieldsSize(
     size_t total_size, internal::CachedSize* cached_size) const {
   total_size += WireFormat::ComputeUnknownFieldsSize(
@@ -194,6 +200,201 @@ size_t Message::SpaceUsedLong() const {
       .SpaceUsedLong();
 }
 
+namespace {
+
+// Deterministic hashing primitives for Message::StableHash(). FNV-1a rather
+// than absl::Hash because the result must not depend on the per-process hash
+// seed; scalars are hashed through their little-endian bytes so the result
+// does not depend on host endianness either.
+constexpr uint64_t kStableHashSeed = 0xcbf29ce484222325u;  // FNV offset basis
+constexpr uint64_t kStableHashPrime = 0x100000001b3u;      // FNV prime
+
+uint64_t StableHashBytes(uint64_t hash, absl::string_view bytes) {
+  for (const char c : bytes) {
+    hash = (hash ^ static_cast<uint8_t>(c)) * kStableHashPrime;
+  }
+  return hash;
+}
+
+uint64_t StableHashWord(uint64_t hash, uint64_t word) {
+  for (int i = 0; i < 8; ++i) {
+    hash = (hash ^ static_cast<uint8_t>(word >> (8 * i))) * kStableHashPrime;
+  }
+  return hash;
+}
+
+uint64_t StableHashUnknownFields(uint64_t hash,
+                                 const UnknownFieldSet& unknown_fields) {
+  for (int i = 0; i < unknown_fields.field_count(); ++i) {
+    const UnknownField& field = unknown_fields.field(i);
+    hash = StableHashWord(
+        hash, (static_cast<uint64_t>(field.number()) << 3) | field.type());
+    switch (field.type()) {
+      case UnknownField::TYPE_VARINT:
+        hash = StableHashWord(hash, field.varint());
+        break;
+      case UnknownField::TYPE_FIXED32:
+        hash = StableHashWord(hash, field.fixed32());
+        break;
+      case UnknownField::TYPE_FIXED64:
+        hash = StableHashWord(hash, field.fixed64());
+        break;
+      case UnknownField::TYPE_LENGTH_DELIMITED:
+        hash = StableHashBytes(hash, field.length_delimited());
+        break;
+      case UnknownField::TYPE_GROUP:
+        hash = StableHashUnknownFields(hash, field.group());
+        break;
+    }
+  }
+  return hash;
+}
+
+}  // namespace
+
+uint64_t Message::StableHash() const { return StableHashImpl(kStableHashSeed); }
+
+uint64_t Message::StableHashImpl(uint64_t hash) const {
+  const Reflection* reflection = GetReflection();
+
+  // Hashes one value of `field` into `h`; `index` is -1 for singular fields.
+  const auto hash_value = [&](uint64_t h, const FieldDescriptor* field,
+                              int index) -> uint64_t {
+    switch (field->cpp_type()) {
+      case FieldDescriptor::CPPTYPE_INT32:
+        return StableHashWord(
+            h, static_cast<uint64_t>(static_cast<int64_t>(
+                   index < 0
+                       ? reflection->GetInt32(*this, field)
+                       : reflection->GetRepeatedInt32(*this, field, index))));
+      case FieldDescriptor::CPPTYPE_INT64:
+        return StableHashWord(
+            h, static_cast<uint64_t>(
+                   index < 0
+                       ? reflection->GetInt64(*this, field)
+                       : reflection->GetRepeatedInt64(*this, field, index)));
+      case FieldDescriptor::CPPTYPE_UINT32:
+        return StableHashWord(
+            h, index < 0
+                   ? reflection->GetUInt32(*this, field)
+                   : reflection->GetRepeatedUInt32(*this, field, index));
+      case FieldDescriptor::CPPTYPE_UINT64:
+        return StableHashWord(
+            h, index < 0
+                   ? reflection->GetUInt64(*this, field)
+                   : reflection->GetRepeatedUInt64(*this, field, index));
+      case FieldDescriptor::CPPTYPE_DOUBLE: {
+        const double value =
+            index < 0 ? reflection->GetDouble(*this, field)
+                      : reflection->GetRepeatedDouble(*this, field, index);
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return StableHashWord(h, bits);
+      }
+      case FieldDescriptor::CPPTYPE_FLOAT: {
+        const float value =
+            index < 0 ? reflection->GetFloat(*this, field)
+                      : reflection->GetRepeatedFloat(*this, field, index);
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return StableHashWord(h, bits);
+      }
+      case FieldDescriptor::CPPTYPE_BOOL: {
+        const bool value =
+            index < 0 ? reflection->GetBool(*this, field)
+                      : reflection->GetRepeatedBool(*this, field, index);
+        return StableHashWord(h, value ? 1 : 0);
+      }
+      case FieldDescriptor::CPPTYPE_ENUM:
+        return StableHashWord(
+            h, static_cast<uint64_t>(static_cast<int64_t>(
+                   index < 0 ? reflection->GetEnumValue(*this, field)
+                             : reflection->GetRepeatedEnumValue(*this, field,
+                                                                index))));
+      case FieldDescriptor::CPPTYPE_STRING: {
+        std::string scratch;
+        return StableHashBytes(
+            h, index < 0 ? reflection->GetStringReference(*this, field,
+                                                          &scratch)
+                         : reflection->GetRepeatedStringReference(
+                               *this, field, index, &scratch));
+      }
+      case FieldDescriptor::CPPTYPE_MESSAGE:
+        return (index < 0
+                    ? reflection->GetMessage(*this, field)
+                    : reflection->GetRepeatedMessage(*this, field, index))
+            .StableHashImpl(h);
+    }
+    internal::Unreachable();
+  };
+
+  // Iterate the precomputed visit plan rather than the descriptor; see
+  // internal::ReflectionVisit.
+  int plan_size = 0;
+  const Reflection::FieldVisitEntry* plan = reflection->GetVisitPlan(&plan_size);
+  for (int i = 0; i < plan_size; ++i) {
+    const Reflection::FieldVisitEntry& entry = plan[i];
+    const FieldDescriptor* field = entry.field;
+    if (entry.kind == Reflection::FieldVisitEntry::kRepeated) {
+      const int count = reflection->FieldSize(*this, field);
+      if (count == 0) continue;
+      // Tag bit distinguishes a repeated field from a singular field with the
+      // same number so schema evolution cannot silently alias them.
+      hash = StableHashWord(hash, (static_cast<uint64_t>(entry.number) << 1) | 1);
+      if (field->is_map()) {
+        // Map iteration order is unspecified, so entry hashes are combined
+        // commutatively.
+        uint64_t combined = 0;
+        for (int j = 0; j < count; ++j) {
+          combined += reflection->GetRepeatedMessage(*this, field, j)
+                          .StableHashImpl(kStableHashSeed);
+        }
+        hash = StableHashWord(hash, combined);
+      } else {
+        hash = StableHashWord(hash, static_cast<uint64_t>(count));
+        for (int j = 0; j < count; ++j) {
+          hash = hash_value(hash, field, j);
+        }
+      }
+    } else {
+      if (!reflection->HasField(*this, field)) continue;
+      hash = StableHashWord(hash, static_cast<uint64_t>(entry.number) << 1);
+      hash = hash_value(hash, field, -1);
+    }
+  }
+
+  // Extensions are not part of the visit plan; this is the one path that
+  // allocates.
+  if (GetDescriptor()->extension_range_count() > 0) {
+    std::vector<const FieldDescriptor*> fields;
+    reflection->ListFields(*this, &fields);
+    for (const FieldDescriptor* field : fields) {
+      if (!field->is_extension()) continue;
+      if (field->is_repeated()) {
+        const int count = reflection->FieldSize(*this, field);
+        hash = StableHashWord(
+            hash, (static_cast<uint64_t>(field->number()) << 1) | 1);
+        hash = StableHashWord(hash, static_cast<uint64_t>(count));
+        for (int j = 0; j < count; ++j) {
+          hash = hash_value(hash, field, j);
+        }
+      } else {
+        hash = StableHashWord(hash, static_cast<uint64_t>(field->number()) << 1);
+        hash = hash_value(hash, field, -1);
+      }
+    }
+  }
+
+  const UnknownFieldSet& unknown_fields = reflection->GetUnknownFields(*this);
+  if (unknown_fields.field_count() > 0) {
+    // A tag no declared field can produce: field numbers fit in 29 bits.
+    hash = StableHashWord(hash, ~uint64_t{0});
+    hash = StableHashUnknownFields(hash, unknown_fields);
+  }
+
+  return hash;
+}
+
 static std::string GetTypeNameImpl(const MessageLite& msg) {
   return DownCast<const Message&>(msg).GetDescriptor()->full_name();
 }
@@ -242,6 +443,8 @@ class GeneratedMessageFactory final : public MessageFactory {
 
   const Message* TryGetPrototype(const Descriptor* type);
 
+  void WarmUpAll(absl::FunctionRef<void(std::function<void()>)> schedule);
+
   // implements MessageFactory ---------------------------------------
   const Message* GetPrototype(const Descriptor* type) override;
 
@@ -250,16 +453,50 @@ class GeneratedMessageFactory final : public MessageFactory {
     dropped_defaults_factory_.SetDelegateToGeneratedFactory(true);
   }
 
-  absl::optional<const Message*> FindInTypeMap(const Descriptor* type)
-      ABSL_SHARED_LOCKS_REQUIRED(mutex_)
+  class MessagePtr {
+   public:
+    MessagePtr() : value_() {}
+    explicit MessagePtr(const Message* msg) : value_(msg) {}
+    const Message* get() const { return value_; }
+    void set(const Message* msg) { value_ = msg; }
+
+   private:
+    const Message* value_;
+  };
+
+  // Prototypes are kept in a small fixed number of shards, each with its own
+  // mutex, so that lookups of unrelated types do not contend with each other
+  // or with an in-progress file registration.
+  static constexpr size_t kTypeMapShards = 32;
+  struct TypeMapShard {
+    absl::Mutex mutex;
+    absl::flat_hash_map<const Descriptor*, MessagePtr> map
+        ABSL_GUARDED_BY(mutex);
+  };
+
+  TypeMapShard& ShardFor(const Descriptor* type) {
+    return type_map_shards_[absl::HashOf(type) % kTypeMapShards];
+  }
+
+  absl::optional<const Message*> FindInTypeMap(TypeMapShard& shard,
+                                               const Descriptor* type)
+      ABSL_SHARED_LOCKS_REQUIRED(shard.mutex)
   {
-    auto it = type_map_.find(type);
-    if (it == type_map_.end()) return absl::nullopt;
+    auto it = shard.map.find(type);
+    if (it == shard.map.end()) return absl::nullopt;
     return it->second.get();
   }
 
+  void WarmUpMessage(const Descriptor* descriptor) {
+    GetPrototype(descriptor);
+    for (int i = 0; i < descriptor->nested_type_count(); ++i) {
+      WarmUpMessage(descriptor->nested_type(i));
+    }
+  }
+
   const google::protobuf::internal::DescriptorTable* FindInFileMap(
       absl::string_view name) {
+    absl::ReaderMutexLock lock(&files_mutex_);
     auto it = files_.find(name);
     if (it == files_.end()) return nullptr;
     return *it;
@@ -294,25 +531,20 @@ class GeneratedMessageFactory final : public MessageFactory {
     }
   };
 
-  // Only written at static init time, so does not require locking.
+  // Usually written at static init time, but dlopen'd generated code can
+  // register files while other threads are already running, so writes and
+  // reads are synchronized.
+  absl::Mutex files_mutex_;
   absl::flat_hash_set<const google::protobuf::internal::DescriptorTable*,
                       DescriptorByNameHash, DescriptorByNameEq>
-      files_;
+      files_ ABSL_GUARDED_BY(files_mutex_);
   DynamicMessageFactory dropped_defaults_factory_;
 
-  absl::Mutex mutex_;
-  class MessagePtr {
-   public:
-    MessagePtr() : value_() {}
-    explicit MessagePtr(const Message* msg) : value_(msg) {}
-    const Message* get() const { return value_; }
-    void set(const Message* msg) { value_ = msg; }
-
-   private:
-    const Message* value_;
-  };
-  absl::flat_hash_map<const Descriptor*, MessagePtr> type_map_
-      ABSL_GUARDED_BY(mutex_);
+  // Serializes the slow path that assembles reflection for a not yet
+  // registered file.  Never held while a shard mutex is held, and only taken
+  // once per file, so steady-state lookups stay on their shard mutex alone.
+  absl::Mutex registration_mutex_;
+  TypeMapShard type_map_shards_[kTypeMapShards];
 };
 
 GeneratedMessageFactory* GeneratedMessageFactory::singleton() {
@@ -323,6 +555,7 @@ GeneratedMessageFactory* GeneratedMessageFactory::singleton() {
 
 void GeneratedMessageFactory::RegisterFile(
     const google::protobuf::internal::DescriptorTable* table) {
+  absl::WriterMutexLock lock(&files_mutex_);
   if (!files_.insert(table).second) {
     ABSL_LOG(FATAL) << "File is already registered: " << table->filename;
   }
@@ -334,11 +567,9 @@ void GeneratedMessageFactory::RegisterType(const Descriptor* descriptor,
       << "Tried to register a non-generated type with the generated "
          "type registry.";
 
-  // This should only be called as a result of calling a file registration
-  // function during GetPrototype(), in which case we already have locked
-  // the mutex.
-  mutex_.AssertHeld();
-  if (!type_map_.try_emplace(descriptor, prototype).second) {
+  TypeMapShard& shard = ShardFor(descriptor);
+  absl::WriterMutexLock lock(&shard.mutex);
+  if (!shard.map.try_emplace(descriptor, prototype).second) {
     ABSL_DLOG(FATAL) << "Type is already registered: "
                      << descriptor->full_name();
   }
@@ -356,11 +587,12 @@ const Message* GeneratedMessageFactory::GetPrototype(const Descriptor* type) {
     result = dropped_defaults_factory_.GetPrototype(type);
 
     {
-      absl::WriterMutexLock lock(&mutex_);
+      TypeMapShard& shard = ShardFor(type);
+      absl::WriterMutexLock lock(&shard.mutex);
       // And update the main map to make the next lookup faster.
       // We don't need to recheck here. Even if someone raced us here the result
       // is the same, so we can just write it.
-      type_map_[type].set(result);
+      shard.map[type].set(result);
     }
   }
 
@@ -369,10 +601,11 @@ const Message* GeneratedMessageFactory::GetPrototype(const Descriptor* type) {
 
 const Message* GeneratedMessageFactory::TryGetPrototype(
     const Descriptor* type) {
+  TypeMapShard& shard = ShardFor(type);
   absl::optional<const Message*> result;
   {
-    absl::ReaderMutexLock lock(&mutex_);
-    result = FindInTypeMap(type);
+    absl::ReaderMutexLock lock(&shard.mutex);
+    result = FindInTypeMap(shard, type);
     if (result.has_value() && *result != nullptr) {
       return *result;
     }
@@ -393,15 +626,21 @@ const Message* GeneratedMessageFactory::TryGetPrototype(
   }
 
   {
-    absl::WriterMutexLock lock(&mutex_);
+    absl::MutexLock lock(&registration_mutex_);
 
     // Check if another thread preempted us.
-    result = FindInTypeMap(type);
+    {
+      absl::ReaderMutexLock shard_lock(&shard.mutex);
+      result = FindInTypeMap(shard, type);
+    }
     if (!result.has_value()) {
-      // Nope.  OK, register everything.
+      // Nope.  OK, register everything.  RegisterType() locks each type's
+      // shard individually, so lookups of already-registered types in other
+      // shards proceed while this file's reflection is assembled.
       internal::RegisterFileLevelMetadata(registration_data);
       // Should be here now.
-      result = FindInTypeMap(type);
+      absl::ReaderMutexLock shard_lock(&shard.mutex);
+      result = FindInTypeMap(shard, type);
       ABSL_DCHECK(result.has_value());
     }
   }
@@ -409,6 +648,30 @@ const Message* GeneratedMessageFactory::TryGetPrototype(
   return *result;
 }
 
+void GeneratedMessageFactory::WarmUpAll(
+    absl::FunctionRef<void(std::function<void()>)> schedule) {
+  // Snapshot the file set so that the tasks run without files_mutex_; a file
+  // registered after the snapshot just stays lazily-built as before.
+  std::vector<const internal::DescriptorTable*> tables;
+  {
+    absl::ReaderMutexLock lock(&files_mutex_);
+    tables.assign(files_.begin(), files_.end());
+  }
+  for (const internal::DescriptorTable* table : tables) {
+    schedule([this, table] {
+      // Forces the lazy descriptor build for the file, then the reflection
+      // assembly and prototype registration for every message in it.  Both
+      // steps are idempotent, so racing with regular use is fine.
+      const FileDescriptor* file =
+          DescriptorPool::generated_pool()->FindFileByName(table->filename);
+      if (file == nullptr) return;
+      for (int i = 0; i < file->message_type_count(); ++i) {
+        WarmUpMessage(file->message_type(i));
+      }
+    });
+  }
+}
+
 }  // namespace
 
 const Message* MessageFactory::TryGetGeneratedPrototype(
@@ -420,6 +683,11 @@ MessageFactory* MessageFactory::generated_factory() {
   return GeneratedMessageFactory::singleton();
 }
 
+void MessageFactory::WarmUpGeneratedTypes(
+    absl::FunctionRef<void(std::function<void()>)> schedule) {
+  GeneratedMessageFactory::singleton()->WarmUpAll(schedule);
+}
+
 void MessageFactory::InternalRegisterGeneratedFile(
     const google::protobuf::internal::DescriptorTable* table) {
   GeneratedMessageFactory::singleton()->RegisterFile(table);
@@ -89,6 +89,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 #include <type_traits>
@@ -96,12 +97,14 @@
 
 #include "absl/base/attributes.h"
 #include "absl/base/call_once.h"
+#include "absl/functional/function_ref.h"
 #include "google/protobuf/stubs/common.h"
 #include "absl/log/absl_check.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/cord.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "google/protobuf/arena.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/generated_message_reflection.h"
@@ -143,6 +146,7 @@ struct FuzzPeer;
 struct DescriptorTable;
 template <bool is_oneof>
 struct DynamicFieldInfoHelper;
+class FastDebugEmitter;
 class MapFieldBase;
 class MessageUtil;
 class ReflectionVisit;
@@ -181,6 +185,7 @@ PROTOBUF_EXPORT std::string ShortFormat(
 PROTOBUF_EXPORT std::string Utf8Format(
     const Message& message);  // text_format.cc
 namespace util {
+class ColumnTranscoder;
 class MessageDifferencer;
 }
 
@@ -188,7 +193,6 @@ class MessageDifferencer;
 namespace internal {
 class ReflectionAccessor;      // message.cc
 class ReflectionOps;           // reflection_ops.h
-class MapKeySorter;            // wire_format.cc
 class WireFormat;              // wire_format.h
 class MapFieldReflectionTest;  // map_test.cc
 }  // namespace internal
@@ -315,6 +319,31 @@ class PROTOBUF_EXPORT Message : public MessageLite {
     return internal::ToIntSize(SpaceUsedLong());
   }
 
+  // Hashing ---------------------------------------------------------
+
+  // Returns a 64-bit hash of the message contents, computed by walking the
+  // field values directly rather than serializing and hashing wire bytes.
+  // This makes it substantially cheaper than hashing SerializeAsString() and
+  // it performs no allocation for messages without extensions.
+  //
+  // Stability: for a given library version and message definition the result
+  // is deterministic across processes and platforms, so it is usable for
+  // sharding and routing decisions between binaries built from the same
+  // version. It is NOT stable across library versions or schema changes;
+  // never persist it.
+  //
+  // Semantics: fields are visited in declaration order, each tagged with its
+  // field number; map entries are combined commutatively because map
+  // iteration order is unspecified; floating point values hash their exact
+  // bit patterns (0.0 and -0.0 differ); unknown fields and extensions are
+  // included, mirroring what serialize-then-hash would observe.
+  uint64_t StableHash() const;
+
+  template <typename H>
+  friend H AbslHashValue(H state, const Message& message) {
+    return H::combine(std::move(state), message.StableHash());
+  }
+
   // Debugging & Testing----------------------------------------------
 
   // Generates a human-readable form of this message for debugging purposes.
@@ -350,6 +379,12 @@ class PROTOBUF_EXPORT Message : public MessageLite {
 
   void CheckTypeAndMergeFrom(const MessageLite& other) override;
   size_t ByteSizeLong() const override;
+
+  // Computes an upper bound on the serialized size more cheaply than
+  // ByteSizeLong() by charging numeric values and length prefixes their
+  // maximum encoded width instead of sizing them exactly.  Useful to presize
+  // output buffers; serialization still performs its own exact size pass.
+  size_t ByteSizeUpperBound() const;
   uint8_t* _InternalSerialize(uint8_t* target,
                               io::EpsCopyOutputStream* stream) const override;
 
@@ -385,6 +420,10 @@ class PROTOBUF_EXPORT Message : public MessageLite {
   static const internal::TcParseTableBase* GetTcParseTableImpl(
       const MessageLite& msg);
 
+  // Recursive worker for StableHash(); a member so it can iterate the
+  // Reflection visit plan, which is private to Reflection.
+  uint64_t StableHashImpl(uint64_t hash) const;
+
   static const DescriptorMethods kDescriptorMethods;
 
 };
@@ -841,6 +880,27 @@ class PROTOBUF_EXPORT Reflection final {
                                       Message* new_entry) const;
 
 
+  // Bulk repeated field mutators ------------------------------------
+  // Span-based counterparts of the per-element mutators and adders above
+  // for scalar repeated fields.  Descriptor validation and field offset
+  // resolution happen once per call instead of once per element, so writing
+  // N elements costs one lookup plus a bulk copy into the underlying
+  // RepeatedField.  T must match the field's cpp type (int32_t is also
+  // accepted for enum fields, with no unknown-value handling: values are
+  // written as-is, like GetMutableRepeatedFieldRef<int32_t>).  Defined for
+  // T = int32_t, int64_t, uint32_t, uint64_t, float, double and bool; other
+  // types fail at link time.
+
+  // Replaces the entire contents of the repeated field with `values`.
+  template <typename T>
+  void SetRepeatedSpan(Message* message, const FieldDescriptor* field,
+                       absl::Span<const T> values) const;
+
+  // Appends all elements of `values` to the repeated field.
+  template <typename T>
+  void AddRepeatedSpan(Message* message, const FieldDescriptor* field,
+                       absl::Span<const T> values) const;
+
   // Get a RepeatedFieldRef object that can be used to read the underlying
   // repeated field. The type parameter T must be set according to the
   // field's cpp type. The following table shows the mapping from cpp type
@@ -1053,6 +1113,12 @@ class PROTOBUF_EXPORT Reflection final {
   // contain weak fields, then this field equals descriptor_->field_count().
   int last_non_weak_field_index_;
 
+  // True if the i'th field's presence is exactly the i'th has-bit for every
+  // field: all fields are singular, outside oneofs, and have identity-mapped
+  // has-bit indices.  Lets ListFields() walk set bits word by word instead of
+  // testing every field.
+  bool has_dense_has_bits_;
+
   // The table-driven parser table.
   // This table is generated on demand for Message types that did not override
   // _InternalParse. It uses the reflection information to do so.
@@ -1067,6 +1133,28 @@ class PROTOBUF_EXPORT Reflection final {
   }
 
   const TcParseTableBase* CreateTcParseTable() const;
+
+  // A flat per-field visit plan precomputed from the descriptor, used by
+  // internal::ReflectionVisit to iterate fields without re-reading scattered
+  // FieldDescriptor metadata on every visit. Built on demand, like the
+  // tcparse table above.
+  struct FieldVisitEntry {
+    enum Kind : uint8_t { kSingular, kRepeated, kOneof };
+    static constexpr uint32_t kNoHasbit = static_cast<uint32_t>(-1);
+
+    const FieldDescriptor* field;
+    uint32_t number;         // field->number()
+    uint32_t has_bit_index;  // kNoHasbit if the field has no hasbit
+    uint16_t oneof_index;    // containing oneof index; only valid for kOneof
+    uint8_t type;            // FieldDescriptor::Type
+    uint8_t cpp_type;        // FieldDescriptor::CppType
+    Kind kind;
+  };
+  mutable absl::once_flag visit_plan_once_;
+  mutable const FieldVisitEntry* visit_plan_ = nullptr;
+  mutable int visit_plan_size_ = 0;
+
+  const FieldVisitEntry* GetVisitPlan(int* size) const;
   void PopulateTcParseFastEntries(
       const internal::TailCallTableInfo& table_info,
       TcParseTableBase::FastFieldEntry* fast_entries) const;
@@ -1086,11 +1174,12 @@ class PROTOBUF_EXPORT Reflection final {
   friend class GeneratedMessageReflectionTestHelper;
   friend class python::MapReflectionFriend;
   friend class python::MessageReflectionFriend;
+  friend class util::ColumnTranscoder;
   friend class util::MessageDifferencer;
 #define GOOGLE_PROTOBUF_HAS_CEL_MAP_REFLECTION_FRIEND
   friend class expr::CelMapReflectionFriend;
+  friend class internal::FastDebugEmitter;
   friend class internal::MapFieldReflectionTest;
-  friend class internal::MapKeySorter;
   friend class internal::MessageUtil;
   friend class internal::WireFormat;
   friend class internal::ReflectionOps;
@@ -1378,6 +1467,25 @@ class PROTOBUF_EXPORT MessageFactory {
   // This factory is a singleton.  The caller must not delete the object.
   static MessageFactory* generated_factory();
 
+  // Eagerly builds the descriptors, reflection objects and prototypes behind
+  // generated_factory().  Normally that work happens lazily, once per .proto
+  // file, the first time a type from the file is used reflectively -- which
+  // makes the latency of the first request touching a type depend on how
+  // novel the type is.  Calling this at process start moves the one-time cost
+  // out of serving traffic; afterwards every generated type is served from
+  // the already-published prototype tables.
+  //
+  // `schedule` is invoked once per registered file with an independent
+  // warm-up task.  Run the tasks however you like -- on a caller-owned thread
+  // pool, or inline -- and wait for all of them before relying on the
+  // warm-up; the runtime itself never spawns threads.  Tasks are idempotent
+  // and safe to run concurrently with each other and with regular use of the
+  // factory, though they partially serialize on internal registration locks.
+  // Files registered after this call (e.g. from dlopen'd generated code) are
+  // warmed lazily as before.
+  static void WarmUpGeneratedTypes(
+      absl::FunctionRef<void(std::function<void()>)> schedule);
+
   // For internal use only:  Registers a .proto file at static initialization
   // time, to be placed in generated_factory.  The first time GetPrototype()
   // is called with a descriptor from this file, |register_messages| will be
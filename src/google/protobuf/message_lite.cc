@@ -19,6 +19,7 @@
 #include <ostream>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/base/dynamic_annotations.h"
 #include "absl/base/optimization.h"
@@ -32,6 +33,7 @@
 #include "absl/synchronization/mutex.h"
 #include "absl/types/optional.h"
 #include "google/protobuf/arena.h"
+#include "google/protobuf/codecz_sampler.h"
 #include "google/protobuf/generated_message_tctable_impl.h"
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/zero_copy_stream.h"
@@ -158,13 +160,25 @@ template <bool aliasing>
 bool MergeFromImpl(absl::string_view input, MessageLite* msg,
                    const internal::TcParseTableBase* tc_table,
                    MessageLite::ParseFlags parse_flags) {
+  const bool sample = CodeczShouldSample();
+  const int64_t start_nanos = PROTOBUF_PREDICT_FALSE(sample) ? CodeczNanos() : 0;
   const char* ptr;
   internal::ParseContext ctx(io::CodedInputStream::GetDefaultRecursionLimit(),
                              aliasing, &ptr, input);
+  std::vector<const std::string*> deferred_utf8;
+  if (PROTOBUF_PREDICT_FALSE(
+          (parse_flags & MessageLite::kDeferUtf8Validation) != 0)) {
+    ctx.set_deferred_utf8(&deferred_utf8);
+  }
   ptr = internal::TcParser::ParseLoop(msg, ptr, &ctx, tc_table);
+  if (PROTOBUF_PREDICT_FALSE(sample)) {
+    CodeczRecordParse(*msg, tc_table, static_cast<int64_t>(input.size()),
+                      CodeczNanos() - start_nanos);
+  }
   // ctx has an explicit limit set (length of string_view).
   if (PROTOBUF_PREDICT_TRUE(ptr && ctx.EndedAtLimit())) {
-    return CheckFieldPresence(ctx, *msg, parse_flags);
+    return ctx.ValidateDeferredUtf8() &&
+           CheckFieldPresence(ctx, *msg, parse_flags);
   }
   return false;
 }
@@ -173,13 +187,27 @@ template <bool aliasing>
 bool MergeFromImpl(io::ZeroCopyInputStream* input, MessageLite* msg,
                    const internal::TcParseTableBase* tc_table,
                    MessageLite::ParseFlags parse_flags) {
+  const bool sample = CodeczShouldSample();
+  const int64_t start_nanos = PROTOBUF_PREDICT_FALSE(sample) ? CodeczNanos() : 0;
+  const int64_t start_bytes =
+      PROTOBUF_PREDICT_FALSE(sample) ? input->ByteCount() : 0;
   const char* ptr;
   internal::ParseContext ctx(io::CodedInputStream::GetDefaultRecursionLimit(),
                              aliasing, &ptr, input);
+  std::vector<const std::string*> deferred_utf8;
+  if (PROTOBUF_PREDICT_FALSE(
+          (parse_flags & MessageLite::kDeferUtf8Validation) != 0)) {
+    ctx.set_deferred_utf8(&deferred_utf8);
+  }
   ptr = internal::TcParser::ParseLoop(msg, ptr, &ctx, tc_table);
+  if (PROTOBUF_PREDICT_FALSE(sample)) {
+    CodeczRecordParse(*msg, tc_table, input->ByteCount() - start_bytes,
+                      CodeczNanos() - start_nanos);
+  }
   // ctx has no explicit limit (hence we end on end of stream)
   if (PROTOBUF_PREDICT_TRUE(ptr && ctx.EndedAtEndOfStream())) {
-    return CheckFieldPresence(ctx, *msg, parse_flags);
+    return ctx.ValidateDeferredUtf8() &&
+           CheckFieldPresence(ctx, *msg, parse_flags);
   }
   return false;
 }
@@ -188,14 +216,26 @@ template <bool aliasing>
 bool MergeFromImpl(BoundedZCIS input, MessageLite* msg,
                    const internal::TcParseTableBase* tc_table,
                    MessageLite::ParseFlags parse_flags) {
+  const bool sample = CodeczShouldSample();
+  const int64_t start_nanos = PROTOBUF_PREDICT_FALSE(sample) ? CodeczNanos() : 0;
   const char* ptr;
   internal::ParseContext ctx(io::CodedInputStream::GetDefaultRecursionLimit(),
                              aliasing, &ptr, input.zcis, input.limit);
+  std::vector<const std::string*> deferred_utf8;
+  if (PROTOBUF_PREDICT_FALSE(
+          (parse_flags & MessageLite::kDeferUtf8Validation) != 0)) {
+    ctx.set_deferred_utf8(&deferred_utf8);
+  }
   ptr = internal::TcParser::ParseLoop(msg, ptr, &ctx, tc_table);
+  if (PROTOBUF_PREDICT_FALSE(sample)) {
+    CodeczRecordParse(*msg, tc_table, input.limit,
+                      CodeczNanos() - start_nanos);
+  }
   if (PROTOBUF_PREDICT_FALSE(!ptr)) return false;
   ctx.BackUp(ptr);
   if (PROTOBUF_PREDICT_TRUE(ctx.EndedAtLimit())) {
-    return CheckFieldPresence(ctx, *msg, parse_flags);
+    return ctx.ValidateDeferredUtf8() &&
+           CheckFieldPresence(ctx, *msg, parse_flags);
   }
   return false;
 }
@@ -253,6 +293,11 @@ class ZeroCopyCodedInputStream : public io::ZeroCopyInputStream {
 
 bool MessageLite::MergeFromImpl(io::CodedInputStream* input,
                                 MessageLite::ParseFlags parse_flags) {
+  const bool sample = internal::CodeczShouldSample();
+  const int64_t start_nanos =
+      PROTOBUF_PREDICT_FALSE(sample) ? internal::CodeczNanos() : 0;
+  const int64_t start_bytes =
+      PROTOBUF_PREDICT_FALSE(sample) ? input->CurrentPosition() : 0;
   ZeroCopyCodedInputStream zcis(input);
   const char* ptr;
   internal::ParseContext ctx(input->RecursionBudget(), zcis.aliasing_enabled(),
@@ -263,7 +308,17 @@ bool MessageLite::MergeFromImpl(io::CodedInputStream* input,
   ctx.TrackCorrectEnding();
   ctx.data().pool = input->GetExtensionPool();
   ctx.data().factory = input->GetExtensionFactory();
+  std::vector<const std::string*> deferred_utf8;
+  if (PROTOBUF_PREDICT_FALSE(
+          (parse_flags & MessageLite::kDeferUtf8Validation) != 0)) {
+    ctx.set_deferred_utf8(&deferred_utf8);
+  }
   ptr = internal::TcParser::ParseLoop(this, ptr, &ctx, GetTcParseTable());
+  if (PROTOBUF_PREDICT_FALSE(sample)) {
+    internal::CodeczRecordParse(*this, GetTcParseTable(),
+                                input->CurrentPosition() - start_bytes,
+                                internal::CodeczNanos() - start_nanos);
+  }
   if (PROTOBUF_PREDICT_FALSE(!ptr)) return false;
   ctx.BackUp(ptr);
   if (!ctx.EndedAtEndOfStream()) {
@@ -273,7 +328,8 @@ bool MessageLite::MergeFromImpl(io::CodedInputStream* input,
   } else {
     input->SetConsumed();
   }
-  return CheckFieldPresence(ctx, *this, parse_flags);
+  return ctx.ValidateDeferredUtf8() &&
+         CheckFieldPresence(ctx, *this, parse_flags);
 }
 
 bool MessageLite::MergePartialFromCodedStream(io::CodedInputStream* input) {
@@ -567,6 +623,15 @@ bool MessageLite::SerializePartialToArray(void* data, int size) const {
   return true;
 }
 
+bool MessageLite::SerializePartialToArrayUsingCachedSizes(void* data,
+                                                          int size) const {
+  const int byte_size = GetCachedSize();
+  if (size < byte_size) return false;
+  uint8_t* start = reinterpret_cast<uint8_t*>(data);
+  SerializeToArrayImpl(*this, start, byte_size);
+  return true;
+}
+
 std::string MessageLite::SerializeAsString() const {
   // If the compiler implements the (Named) Return Value Optimization,
   // the local variable 'output' will not actually reside on the stack
@@ -393,6 +393,14 @@ class PROTOBUF_EXPORT MessageLite {
   bool SerializeToArray(void* data, int size) const;
   // Like SerializeToArray(), but allows missing required fields.
   bool SerializePartialToArray(void* data, int size) const;
+  // Like SerializePartialToArray(), but reuses the sizes computed by the most
+  // recent ByteSizeLong() (or SerializeTo*()) call instead of re-walking the
+  // message tree. The message, including submessages, must not have been
+  // modified since that call; cached sizes are not re-validated. Intended for
+  // fan-out scenarios where one unchanged message is serialized to many
+  // destinations. Returns false if `size` is smaller than the cached
+  // serialized size.
+  bool SerializePartialToArrayUsingCachedSizes(void* data, int size) const;
 
   // Make a string encoding the message. Is equivalent to calling
   // SerializeToString() on a string and using that.  Returns the empty
@@ -648,7 +656,12 @@ class PROTOBUF_EXPORT MessageLite {
     kMergeWithAliasing = 4,
     kParseWithAliasing = 5,
     kMergePartialWithAliasing = 6,
-    kParsePartialWithAliasing = 7
+    kParsePartialWithAliasing = 7,
+    // Defer UTF-8 validation of enforced string fields: the parse loop
+    // records the parsed values and validates them in one batch after the
+    // loop finishes, instead of inline per field.  The parse still fails on
+    // malformed UTF-8; only the point of validation moves.
+    kDeferUtf8Validation = 8
   };
 
   template <ParseFlags flags, typename T>
@@ -0,0 +1,126 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+//
+// This file defines the MessagePool class template.
+
+#ifndef GOOGLE_PROTOBUF_MESSAGE_POOL_H__
+#define GOOGLE_PROTOBUF_MESSAGE_POOL_H__
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "absl/log/absl_check.h"
+#include "google/protobuf/port.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+
+// A type-keyed recycling pool for heap-allocated messages.
+//
+// Servers that churn one request/response type at high rates pay malloc and
+// constructor cost per message when allocating on the heap, and arena block
+// setup per request when allocating per-request arenas.  MessagePool instead
+// recycles fully-constructed instances: Release() resets a message in place
+// with Clear() - which retains allocated submessage and repeated-field
+// capacity - and caches it; Acquire() hands cached instances back out.  In
+// steady state a request is served with no allocation at all once the
+// message's internal capacity has warmed up.
+//
+// Caches are thread-local, so Acquire() and Release() take no locks; a
+// message may be released on a different thread than it was acquired on.
+// Each thread caches at most `kDefaultMaxCachedPerThread` instances per type
+// (see SetMaxCachedPerThread); releases beyond the bound delete the message.
+//
+//   auto request = MessagePool<MyRequest>::AcquireUnique();
+//   request->ParseFromString(data);
+//   ...  // The handle releases the instance back to the pool.
+//
+// Only messages owned by the heap may be released; arena-allocated messages
+// are owned by their arena.  T may be any generated message type, including
+// lite messages.
+template <typename T>
+class MessagePool {
+ public:
+  static constexpr size_t kDefaultMaxCachedPerThread = 64;
+
+  MessagePool() = delete;
+
+  // Returns an empty instance, reusing a cached one when available.  The
+  // caller owns the result and should return it with Release().
+  static T* Acquire() {
+    Cache& cache = ThreadCache();
+    if (!cache.messages.empty()) {
+      T* message = cache.messages.back();
+      cache.messages.pop_back();
+      return message;
+    }
+    return new T();
+  }
+
+  // Resets `message` in place and caches it for reuse, or deletes it when
+  // the calling thread's cache is full.  `message` must be heap-allocated.
+  static void Release(T* message) {
+    if (message == nullptr) return;
+    ABSL_DCHECK(message->GetArena() == nullptr)
+        << "arena-allocated messages are owned by their arena and cannot be "
+           "pooled";
+    Cache& cache = ThreadCache();
+    if (cache.messages.size() >= cache.max_cached) {
+      delete message;
+      return;
+    }
+    message->Clear();
+    cache.messages.push_back(message);
+  }
+
+  struct Releaser {
+    void operator()(T* message) const { MessagePool<T>::Release(message); }
+  };
+  using UniquePtr = std::unique_ptr<T, Releaser>;
+
+  // Like Acquire(), returning a handle that releases back to the pool.
+  static UniquePtr AcquireUnique() { return UniquePtr(Acquire()); }
+
+  // Adjusts the calling thread's cache bound, deleting cached instances
+  // beyond the new bound.  Pass 0 to disable caching on this thread.
+  static void SetMaxCachedPerThread(size_t max_cached) {
+    Cache& cache = ThreadCache();
+    cache.max_cached = max_cached;
+    while (cache.messages.size() > max_cached) {
+      delete cache.messages.back();
+      cache.messages.pop_back();
+    }
+  }
+
+  static size_t CachedCountForTesting() { return ThreadCache().messages.size(); }
+
+ private:
+  struct Cache {
+    std::vector<T*> messages;
+    size_t max_cached = kDefaultMaxCachedPerThread;
+
+    ~Cache() {
+      for (T* message : messages) delete message;
+    }
+  };
+
+  static Cache& ThreadCache() {
+    static thread_local Cache cache;
+    return cache;
+  }
+};
+
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_MESSAGE_POOL_H__
@@ -0,0 +1,107 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/message_pool.h"
+
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "google/protobuf/test_util.h"
+#include "google/protobuf/unittest.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace {
+
+using protobuf_unittest::TestAllTypes;
+
+class MessagePoolTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    // Tests share the thread-local cache; start each one empty.
+    MessagePool<TestAllTypes>::SetMaxCachedPerThread(0);
+    MessagePool<TestAllTypes>::SetMaxCachedPerThread(
+        MessagePool<TestAllTypes>::kDefaultMaxCachedPerThread);
+  }
+};
+
+TEST_F(MessagePoolTest, AcquireReturnsEmptyInstance) {
+  TestAllTypes* message = MessagePool<TestAllTypes>::Acquire();
+  TestUtil::ExpectClear(*message);
+  MessagePool<TestAllTypes>::Release(message);
+}
+
+TEST_F(MessagePoolTest, ReleaseRecyclesInstance) {
+  TestAllTypes* message = MessagePool<TestAllTypes>::Acquire();
+  TestUtil::SetAllFields(message);
+  MessagePool<TestAllTypes>::Release(message);
+
+  TestAllTypes* recycled = MessagePool<TestAllTypes>::Acquire();
+  EXPECT_EQ(message, recycled);
+  TestUtil::ExpectClear(*recycled);
+  MessagePool<TestAllTypes>::Release(recycled);
+}
+
+TEST_F(MessagePoolTest, CacheIsBounded) {
+  MessagePool<TestAllTypes>::SetMaxCachedPerThread(2);
+  std::vector<TestAllTypes*> messages;
+  for (int i = 0; i < 4; ++i) {
+    messages.push_back(MessagePool<TestAllTypes>::Acquire());
+  }
+  for (TestAllTypes* message : messages) {
+    MessagePool<TestAllTypes>::Release(message);
+  }
+  EXPECT_EQ(2u, MessagePool<TestAllTypes>::CachedCountForTesting());
+}
+
+TEST_F(MessagePoolTest, UniqueHandleReleases) {
+  TestAllTypes* raw;
+  {
+    auto handle = MessagePool<TestAllTypes>::AcquireUnique();
+    handle->set_optional_int32(7);
+    raw = handle.get();
+  }
+  EXPECT_EQ(1u, MessagePool<TestAllTypes>::CachedCountForTesting());
+  TestAllTypes* recycled = MessagePool<TestAllTypes>::Acquire();
+  EXPECT_EQ(raw, recycled);
+  EXPECT_FALSE(recycled->has_optional_int32());
+  MessagePool<TestAllTypes>::Release(recycled);
+}
+
+TEST_F(MessagePoolTest, ShrinkingBoundDeletesExcess) {
+  MessagePool<TestAllTypes>::SetMaxCachedPerThread(4);
+  std::vector<TestAllTypes*> messages;
+  for (int i = 0; i < 4; ++i) {
+    messages.push_back(MessagePool<TestAllTypes>::Acquire());
+  }
+  for (TestAllTypes* message : messages) {
+    MessagePool<TestAllTypes>::Release(message);
+  }
+  MessagePool<TestAllTypes>::SetMaxCachedPerThread(1);
+  EXPECT_EQ(1u, MessagePool<TestAllTypes>::CachedCountForTesting());
+}
+
+TEST_F(MessagePoolTest, CachesAreThreadLocal) {
+  TestAllTypes* message = MessagePool<TestAllTypes>::Acquire();
+  MessagePool<TestAllTypes>::Release(message);
+  ASSERT_EQ(1u, MessagePool<TestAllTypes>::CachedCountForTesting());
+
+  std::thread other([] {
+    EXPECT_EQ(0u, MessagePool<TestAllTypes>::CachedCountForTesting());
+    TestAllTypes* local = MessagePool<TestAllTypes>::Acquire();
+    MessagePool<TestAllTypes>::Release(local);
+    EXPECT_EQ(1u, MessagePool<TestAllTypes>::CachedCountForTesting());
+  });
+  other.join();
+
+  EXPECT_EQ(1u, MessagePool<TestAllTypes>::CachedCountForTesting());
+}
+
+}  // namespace
+}  // namespace protobuf
+}  // namespace google
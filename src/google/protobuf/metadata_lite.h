@@ -27,6 +27,14 @@ class UnknownFieldSet;
 
 namespace internal {
 
+// Attaches the owning message's arena to a freshly created UnknownFieldSet so
+// that its payloads are arena-allocated.  Defined in unknown_field_set.cc; the
+// std::string overload keeps mutable_unknown_fields_slow() generic for lite
+// messages, whose unknown fields are a plain string.
+PROTOBUF_EXPORT void SetUnknownFieldSetArena(UnknownFieldSet* set,
+                                             Arena* arena);
+inline void SetUnknownFieldSetArena(std::string* /*set*/, Arena* /*arena*/) {}
+
 // This is the representation for messages that support arena allocation. It
 // uses a tagged pointer to either store the owning Arena pointer, if there are
 // no unknown fields, or a pointer to a block of memory with both the owning
@@ -174,6 +182,7 @@ class PROTOBUF_EXPORT InternalMetadata {
     ptr_ = reinterpret_cast<intptr_t>(container);
     ptr_ |= kUnknownFieldsTagMask;
     container->arena = my_arena;
+    SetUnknownFieldSetArena(&container->unknown_fields, my_arena);
     return &(container->unknown_fields);
   }
 
@@ -11,6 +11,7 @@
 #include <cstring>
 
 #include "absl/strings/cord.h"
+#include "absl/strings/internal/resize_uninitialized.h"
 #include "absl/strings/string_view.h"
 #include "google/protobuf/message_lite.h"
 #include "google/protobuf/repeated_field.h"
@@ -149,6 +150,8 @@ std::pair<const char*, bool> EpsCopyInputStream::DoneFallback(int overrun,
                                                               int depth) {
   // Did we exceeded the limit (parse error).
   if (PROTOBUF_PREDICT_FALSE(overrun > limit_)) return {nullptr, true};
+  // A tripped parse budget aborts exactly like malformed input.
+  if (PROTOBUF_PREDICT_FALSE(ShouldAbortParse())) return {nullptr, true};
   ABSL_DCHECK(overrun != limit_);  // Guaranteed by caller.
   ABSL_DCHECK(overrun < limit_);   // Follows from above
   // TODO Instead of this dcheck we could just assign, and remove
@@ -187,6 +190,24 @@ const char* EpsCopyInputStream::SkipFallback(const char* ptr, int size) {
 
 const char* EpsCopyInputStream::ReadStringFallback(const char* ptr, int size,
                                                    std::string* str) {
+  if (PROTOBUF_PREDICT_TRUE(size <= buffer_end_ - ptr + limit_ &&
+                            size <= kSafeStringSize)) {
+    // The payload lies within the current limit: size the string up front and
+    // copy straight into uninitialized storage, like the non-fallback path,
+    // instead of growing through append().
+    absl::strings_internal::STLStringResizeUninitialized(str, size);
+    char* out = &(*str)[0];
+    const char* res = AppendSize(ptr, size, [&out](const char* p, int s) {
+      memcpy(out, p, s);
+      out += s;
+    });
+    if (PROTOBUF_PREDICT_FALSE(res == nullptr)) {
+      // The stream ended early; don't leave uninitialized bytes reachable
+      // through the string.
+      str->clear();
+    }
+    return res;
+  }
   str->clear();
   if (PROTOBUF_PREDICT_TRUE(size <= buffer_end_ - ptr + limit_)) {
     // Reserve the string up to a static safe size. If strings are bigger than
@@ -200,6 +221,24 @@ const char* EpsCopyInputStream::ReadStringFallback(const char* ptr, int size,
 
 const char* EpsCopyInputStream::AppendStringFallback(const char* ptr, int size,
                                                      std::string* str) {
+  if (PROTOBUF_PREDICT_TRUE(size <= buffer_end_ - ptr + limit_ &&
+                            size <= kSafeStringSize)) {
+    // Same uninitialized-append fast path as ReadStringFallback(), but
+    // preserving the existing contents of the string.
+    const size_t old_size = str->size();
+    absl::strings_internal::STLStringResizeUninitialized(str, old_size + size);
+    char* out = &(*str)[old_size];
+    const char* res = AppendSize(ptr, size, [&out](const char* p, int s) {
+      memcpy(out, p, s);
+      out += s;
+    });
+    if (PROTOBUF_PREDICT_FALSE(res == nullptr)) {
+      // The stream ended early; don't leave uninitialized bytes reachable
+      // through the string.
+      str->resize(old_size);
+    }
+    return res;
+  }
   if (PROTOBUF_PREDICT_TRUE(size <= buffer_end_ - ptr + limit_)) {
     // Reserve the string up to a static safe size. If strings are bigger than
     // this we proceed by growing the string as needed. This protects against
@@ -210,6 +249,18 @@ const char* EpsCopyInputStream::AppendStringFallback(const char* ptr, int size,
                     [str](const char* p, int s) { str->append(p, s); });
 }
 
+const char* EpsCopyInputStream::ReadStringViewFallback(const char* ptr,
+                                                       int size,
+                                                       absl::string_view* out,
+                                                       std::string* backing) {
+  // The bytes straddle a buffer seam, so a contiguous alias into the input is
+  // not available; materialize a copy and view that instead.
+  ptr = ReadStringFallback(ptr, size, backing);
+  if (ptr == nullptr) return nullptr;
+  *out = *backing;
+  return ptr;
+}
+
 const char* EpsCopyInputStream::ReadCordFallback(const char* ptr, int size,
                                                  absl::Cord* cord) {
   if (zcis_ == nullptr) {
@@ -415,6 +466,17 @@ bool VerifyUTF8(absl::string_view str, const char* field_name) {
   return true;
 }
 
+bool ParseContext::ValidateDeferredUtf8() const {
+  if (deferred_utf8_ == nullptr) return true;
+  for (const std::string* str : *deferred_utf8_) {
+    if (!utf8_range::IsStructurallyValid(*str)) {
+      PrintUTF8ErrorLog("", "", "parsing", false);
+      return false;
+    }
+  }
+  return true;
+}
+
 const char* InlineGreedyStringParser(std::string* s, const char* ptr,
                                      ParseContext* ctx) {
   int size = ReadSize(&ptr);
@@ -13,6 +13,7 @@
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "absl/base/config.h"
 #include "absl/log/absl_check.h"
@@ -212,6 +213,35 @@ class PROTOBUF_EXPORT EpsCopyInputStream {
     return ReadCordFallback(ptr, size, cord);
   }
 
+  // Reads `size` bytes into `*out` without copying whenever the input allows
+  // it: if aliasing was enabled (EnableAliasing() on CodedInputStream, or the
+  // aliasing ParseContext constructor) and the bytes are contiguous in the
+  // original input, `*out` aliases the input buffer and the caller must
+  // guarantee the buffer outlives every use of the view. Otherwise the bytes
+  // are copied into `*backing` and `*out` points at the copy. Returns the
+  // advanced pointer, or nullptr on parse failure.
+  PROTOBUF_NODISCARD const char* ReadStringView(const char* ptr, int size,
+                                                absl::string_view* out,
+                                                std::string* backing) {
+    if (size <= buffer_end_ + kSlopBytes - ptr) {
+      if (aliasing_ == kNoDelta) {
+        // The current buffer is (part of) the original input; alias directly.
+        *out = absl::string_view(ptr, size);
+      } else if (aliasing_ > kNoDelta) {
+        // We are parsing from the patch buffer but the bytes are also live in
+        // the original flat input at a fixed offset.
+        *out = absl::string_view(ptr + aliasing_, size);
+      } else {
+        // Aliasing disabled, or the bytes only exist in the volatile patch
+        // buffer (kOnPatch): fall back to an owned copy.
+        backing->assign(ptr, size);
+        *out = *backing;
+      }
+      return ptr + size;
+    }
+    return ReadStringViewFallback(ptr, size, out, backing);
+  }
+
 
   template <typename Tag, typename T>
   PROTOBUF_NODISCARD const char* ReadRepeatedFixed(const char* ptr,
@@ -255,6 +285,25 @@ class PROTOBUF_EXPORT EpsCopyInputStream {
   // call Done for further checks.
   bool DataAvailable(const char* ptr) { return ptr < limit_end_; }
 
+  // Cooperative parse budgets, for callers that must bound how long a single
+  // parse can hold a thread.  Both checks run only when the parse loop
+  // crosses a buffer-refill boundary (DoneFallback), so the per-tag fast
+  // path is unchanged; a tripped budget fails the parse the same way
+  // malformed input does.
+  //
+  // Caps the number of bytes pulled from the underlying stream.  The cap is
+  // checked after the fact, so a parse can overshoot it by up to one stream
+  // chunk.  It has no effect on flat-array parses, whose size is known up
+  // front.
+  void SetParseByteBudget(int64_t bytes) { parse_budget_ = bytes; }
+  // Registers a predicate called with `arg` at refill boundaries; returning
+  // true aborts the parse.  Typical uses are deadline checks and
+  // cancellation flags.  `check` must stay valid for the whole parse.
+  void SetParseAbortCheck(bool (*check)(void* arg), void* arg) {
+    abort_check_ = check;
+    abort_check_arg_ = arg;
+  }
+
  protected:
   // Returns true is limit (either an explicit limit or end of stream) is
   // reached. It aligns *ptr across buffer seams.
@@ -341,6 +390,10 @@ class PROTOBUF_EXPORT EpsCopyInputStream {
   // DoneFallback.
   uint32_t last_tag_minus_1_ = 0;
   int overall_limit_ = INT_MAX;  // Overall limit independent of pushed limits.
+  // See SetParseByteBudget()/SetParseAbortCheck().  Checked in DoneFallback.
+  int64_t parse_budget_ = INT64_MAX;
+  bool (*abort_check_)(void*) = nullptr;
+  void* abort_check_arg_ = nullptr;
   // Pretty random large number that seems like a safe allocation on most
   // systems. TODO do we need to set this as build flag?
   enum { kSafeStringSize = 50000000 };
@@ -369,15 +422,27 @@ class PROTOBUF_EXPORT EpsCopyInputStream {
   const char* AppendStringFallback(const char* ptr, int size, std::string* str);
   const char* ReadStringFallback(const char* ptr, int size, std::string* str);
   const char* ReadCordFallback(const char* ptr, int size, absl::Cord* cord);
+  const char* ReadStringViewFallback(const char* ptr, int size,
+                                     absl::string_view* out,
+                                     std::string* backing);
   static bool ParseEndsInSlopRegion(const char* begin, int overrun, int depth);
   bool StreamNext(const void** data) {
     bool res = zcis_->Next(data, &size_);
-    if (res) overall_limit_ -= size_;
+    if (res) {
+      overall_limit_ -= size_;
+      parse_budget_ -= size_;
+    }
     return res;
   }
   void StreamBackUp(int count) {
     zcis_->BackUp(count);
     overall_limit_ += count;
+    parse_budget_ += count;
+  }
+
+  bool ShouldAbortParse() const {
+    return PROTOBUF_PREDICT_FALSE(parse_budget_ < 0) ||
+           (abort_check_ != nullptr && abort_check_(abort_check_arg_));
   }
 
   template <typename A>
@@ -405,8 +470,8 @@ class PROTOBUF_EXPORT EpsCopyInputStream {
   // AppendUntilEnd appends data until a limit (either a PushLimit or end of
   // stream. Normal payloads are from length delimited fields which have an
   // explicit size. Reading until limit only comes when the string takes
-  // the place of a protobuf, ie RawMessage, lazy fields and implicit weak
-  // messages. We keep these methods private and friend them.
+  // the place of a protobuf, ie RawMessage and lazy fields. We keep these
+  // methods private and friend them.
   template <typename A>
   const char* AppendUntilEnd(const char* ptr, const A& append) {
     if (ptr - buffer_end_ > limit_) return nullptr;
@@ -428,7 +493,6 @@ class PROTOBUF_EXPORT EpsCopyInputStream {
     return AppendUntilEnd(
         ptr, [str](const char* p, ptrdiff_t s) { str->append(p, s); });
   }
-  friend class ImplicitWeakMessage;
 
   // Needs access to kSlopBytes.
   friend PROTOBUF_EXPORT std::pair<const char*, int32_t> ReadSizeFallback(
@@ -491,6 +555,24 @@ class PROTOBUF_EXPORT ParseContext : public EpsCopyInputStream {
   Data& data() { return data_; }
   const Data& data() const { return data_; }
 
+  // Deferred UTF-8 validation (see MessageLite::kDeferUtf8Validation).  When
+  // a list is attached, table-driven parsing of enforced-UTF-8 string fields
+  // records a pointer to the parsed field value instead of validating
+  // inline; the parse entry point runs ValidateDeferredUtf8() once the parse
+  // loop finishes.  The pointers reference field storage in the parsed
+  // message, which is stable for the duration of the parse.
+  void set_deferred_utf8(std::vector<const std::string*>* deferred) {
+    deferred_utf8_ = deferred;
+  }
+  std::vector<const std::string*>* deferred_utf8() const {
+    return deferred_utf8_;
+  }
+
+  // Validates every recorded field value in one batch; logs and returns
+  // false on the first malformed one.  Returns true when no list is
+  // attached.
+  bool ValidateDeferredUtf8() const;
+
   const char* ParseMessage(MessageLite* msg, const char* ptr);
 
   // Read the length prefix, push the new limit, call the func(ptr), and then
@@ -568,6 +650,7 @@ class PROTOBUF_EXPORT ParseContext : public EpsCopyInputStream {
   // in the last kSlopBytes of a ZeroCopyInputStream chunk.
   int group_depth_ = INT_MIN;
   Data data_;
+  std::vector<const std::string*>* deferred_utf8_ = nullptr;
 };
 
 template <int>
@@ -1199,6 +1282,32 @@ const char* EpsCopyInputStream::ReadPackedFixed(const char* ptr, int size,
 
 template <typename Add>
 const char* ReadPackedVarintArray(const char* ptr, const char* end, Add add) {
+#ifdef ABSL_IS_LITTLE_ENDIAN
+  // Packed varint regions are frequently long runs of values that encode in
+  // a single byte each. Scan eight input bytes at a time and, when none of
+  // them has its continuation bit set, emit all eight values without going
+  // through the generic decode loop. A single multi-byte varint falls back
+  // to VarintParse for that element only, so mixed content still benefits.
+  while (end - ptr >= 8) {
+    uint64_t word = UnalignedLoad<uint64_t>(ptr);
+    if (PROTOBUF_PREDICT_TRUE((word & 0x8080808080808080u) == 0)) {
+      add(word & 0xFF);
+      add((word >> 8) & 0xFF);
+      add((word >> 16) & 0xFF);
+      add((word >> 24) & 0xFF);
+      add((word >> 32) & 0xFF);
+      add((word >> 40) & 0xFF);
+      add((word >> 48) & 0xFF);
+      add(word >> 56);
+      ptr += 8;
+    } else {
+      uint64_t varint;
+      ptr = VarintParse(ptr, &varint);
+      if (ptr == nullptr) return nullptr;
+      add(varint);
+    }
+  }
+#endif
   while (ptr < end) {
     uint64_t varint;
     ptr = VarintParse(ptr, &varint);
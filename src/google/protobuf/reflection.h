@@ -13,6 +13,7 @@
 #include <memory>
 #include <type_traits>
 
+#include "absl/types/span.h"
 #include "google/protobuf/generated_enum_util.h"
 #include "google/protobuf/descriptor.h"
 
@@ -55,6 +56,24 @@ class RepeatedFieldRef<
   int size() const { return accessor_->Size(data_); }
   T Get(int index) const { return accessor_->template Get<T>(data_, index); }
 
+  // Copies the first `values.size()` elements of the repeated field into
+  // `values`.  `values.size()` must not exceed size().  For fields backed by
+  // a contiguous RepeatedField this is a single memcpy; other
+  // representations fall back to element-wise Get().
+  void CopyTo(absl::Span<T> values) const {
+    typedef typename internal::RefTypeTraits<T>::AccessorValueType ActualType;
+    const int count = static_cast<int>(values.size());
+    assert(count <= size());
+    if (count == 0) return;
+    if (std::is_same<T, ActualType>::value &&
+        accessor_->CopyToBuffer(data_, values.data(), count)) {
+      return;
+    }
+    for (int i = 0; i < count; ++i) {
+      values[i] = Get(i);
+    }
+  }
+
   typedef IteratorType iterator;
   typedef IteratorType const_iterator;
   typedef T value_type;
@@ -95,6 +114,23 @@ class MutableRepeatedFieldRef<
     accessor_->template Set<T>(data_, index, value);
   }
   void Add(const T& value) const { accessor_->template Add<T>(data_, value); }
+
+  // Appends all elements of `values` to the repeated field.  For fields
+  // backed by a contiguous RepeatedField this is a single bulk append; other
+  // representations fall back to element-wise Add().
+  void Append(absl::Span<const T> values) const {
+    typedef typename internal::RefTypeTraits<T>::AccessorValueType ActualType;
+    const int count = static_cast<int>(values.size());
+    if (count == 0) return;
+    if (std::is_same<T, ActualType>::value &&
+        accessor_->AppendFromBuffer(data_, values.data(), count)) {
+      return;
+    }
+    for (int i = 0; i < count; ++i) {
+      Add(values[i]);
+    }
+  }
+
   void RemoveLast() const { accessor_->RemoveLast(data_); }
   void Reserve(int size) const { accessor_->Reserve(data_, size); }
   void SwapElements(int index1, int index2) const {
@@ -308,6 +344,20 @@ class PROTOBUF_EXPORT RepeatedFieldAccessor {
   virtual void Swap(Field* data, const RepeatedFieldAccessor* other_mutator,
                     Field* other_data) const = 0;
 
+  // Bulk accessors used by RepeatedFieldRef::CopyTo() and
+  // MutableRepeatedFieldRef::Append().  `buffer` points to an array of `size`
+  // AccessorValueType elements.  Implementations backed by a contiguous
+  // RepeatedField copy in bulk and return true; the default returns false
+  // and callers fall back to element-wise access.
+  virtual bool CopyToBuffer(const Field* /*data*/, Value* /*buffer*/,
+                            int /*size*/) const {
+    return false;
+  }
+  virtual bool AppendFromBuffer(Field* /*data*/, const Value* /*buffer*/,
+                                int /*size*/) const {
+    return false;
+  }
+
   // Create an iterator that points at the beginning of the repeated field.
   virtual Iterator* BeginIterator(const Field* data) const = 0;
   // Create an iterator that points at the end of the repeated field.
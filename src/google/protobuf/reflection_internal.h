@@ -8,6 +8,8 @@
 #ifndef GOOGLE_PROTOBUF_REFLECTION_INTERNAL_H__
 #define GOOGLE_PROTOBUF_REFLECTION_INTERNAL_H__
 
+#include <cstring>
+
 #include "absl/strings/cord.h"
 #include "google/protobuf/map_field.h"
 #include "google/protobuf/reflection.h"
@@ -255,6 +257,7 @@ template <typename T>
 class RepeatedFieldPrimitiveAccessor final : public RepeatedFieldWrapper<T> {
   typedef void Field;
   typedef void Value;
+  using RepeatedFieldWrapper<T>::GetRepeatedField;
   using RepeatedFieldWrapper<T>::MutableRepeatedField;
 
  public:
@@ -267,6 +270,18 @@ class RepeatedFieldPrimitiveAccessor final : public RepeatedFieldWrapper<T> {
     ABSL_CHECK(this == other_mutator);
     MutableRepeatedField(data)->Swap(MutableRepeatedField(other_data));
   }
+  bool CopyToBuffer(const Field* data, Value* buffer,
+                    int size) const override {
+    memcpy(buffer, GetRepeatedField(data)->data(),
+           static_cast<size_t>(size) * sizeof(T));
+    return true;
+  }
+  bool AppendFromBuffer(Field* data, const Value* buffer,
+                        int size) const override {
+    const T* values = static_cast<const T*>(buffer);
+    MutableRepeatedField(data)->Add(values, values + size);
+    return true;
+  }
 
  protected:
   T ConvertToT(const Value* value) const override {
@@ -6,6 +6,7 @@
 #include <utility>
 
 #include "absl/base/attributes.h"
+#include "absl/base/prefetch.h"
 #include "absl/log/absl_check.h"
 #include "absl/strings/cord.h"
 #include "google/protobuf/descriptor.h"
@@ -100,18 +101,31 @@ void ReflectionVisit::VisitFields(MessageT& message, CallbackFn&& func,
   // See Reflection::ListFields for the optimization.
   const uint32_t* const has_bits =
       schema.HasHasbits() ? reflection->GetHasBits(message) : nullptr;
-  const uint32_t* const has_bits_indices = schema.has_bit_indices_;
-  const Descriptor* descriptor = GetDescriptor(reflection);
-  const int field_count = descriptor->field_count();
 
-  for (int i = 0; i < field_count; i++) {
-    const FieldDescriptor* field = descriptor->field(i);
+  // Iterate the precomputed visit plan instead of the descriptor: each entry
+  // carries the per-field metadata the loop needs (kind, type, hasbit index)
+  // in one flat, cache-friendly array.
+  using FieldVisitEntry = Reflection::FieldVisitEntry;
+  int plan_size;
+  const FieldVisitEntry* const plan = reflection->GetVisitPlan(&plan_size);
+
+  for (int i = 0; i < plan_size; i++) {
+    const FieldVisitEntry& entry = plan[i];
+    if (i + 1 < plan_size) {
+      // The FieldDescriptor is only dereferenced for fields that turn out to
+      // be present; prefetch the next one while handling this field.
+      absl::PrefetchToLocalCache(plan[i + 1].field);
+    }
+    const FieldDescriptor* field = entry.field;
     ABSL_DCHECK(!field->options().weak()) << "weak fields are not supported";
 
-    if (!ShouldVisit(mask, field->cpp_type())) continue;
+    if (!ShouldVisit(mask, static_cast<FieldDescriptor::CppType>(
+                               entry.cpp_type))) {
+      continue;
+    }
 
-    if (field->is_repeated()) {
-      switch (field->type()) {
+    if (entry.kind == FieldVisitEntry::kRepeated) {
+      switch (static_cast<FieldDescriptor::Type>(entry.type)) {
 #define PROTOBUF_HANDLE_REPEATED_CASE(TYPE, CPPTYPE, NAME)                  \
   case FieldDescriptor::TYPE_##TYPE: {                                      \
     ABSL_DCHECK(!field->is_map());                                          \
@@ -188,17 +202,15 @@ void ReflectionVisit::VisitFields(MessageT& message, CallbackFn&& func,
 #undef PROTOBUF_HANDLE_REPEATED_CASE
 #undef PROTOBUF_HANDLE_REPEATED_PTR_CASE
 #undef PROTOBUF_IMPL_STRING_CASE
-    } else if (schema.InRealOneof(field)) {
-      const OneofDescriptor* containing_oneof = field->containing_oneof();
+    } else if (entry.kind == FieldVisitEntry::kOneof) {
       const uint32_t* const oneof_case_array =
           internal::GetConstPointerAtOffset<uint32_t>(
               &message, schema.oneof_case_offset_);
       // Equivalent to: !HasOneofField(message, field)
-      if (static_cast<int64_t>(oneof_case_array[containing_oneof->index()]) !=
-          field->number()) {
+      if (oneof_case_array[entry.oneof_index] != entry.number) {
         continue;
       }
-      switch (field->type()) {
+      switch (static_cast<FieldDescriptor::Type>(entry.type)) {
 #define PROTOBUF_HANDLE_CASE(TYPE, NAME)                                       \
   case FieldDescriptor::TYPE_##TYPE:                                           \
     func(internal::NAME##DynamicFieldInfo<MessageT, true>{reflection, message, \
@@ -243,15 +255,15 @@ void ReflectionVisit::VisitFields(MessageT& message, CallbackFn&& func,
 #undef PROTOBUF_HANDLE_CASE
       }
     } else {
-      auto index = has_bits_indices[i];
-      bool check_hasbits = has_bits && index != static_cast<uint32_t>(-1);
+      const uint32_t index = entry.has_bit_index;
+      bool check_hasbits = has_bits && index != FieldVisitEntry::kNoHasbit;
       if (PROTOBUF_PREDICT_TRUE(check_hasbits)) {
         if ((has_bits[index / 32] & (1u << (index % 32))) == 0) continue;
       } else {
         // Skip if it has default values.
         if (!reflection->HasBit(message, field)) continue;
       }
-      switch (field->type()) {
+      switch (static_cast<FieldDescriptor::Type>(entry.type)) {
 #define PROTOBUF_HANDLE_CASE(TYPE, NAME)                                     \
   case FieldDescriptor::TYPE_##TYPE:                                         \
     func(internal::NAME##DynamicFieldInfo<MessageT, false>{reflection,       \
@@ -23,6 +23,7 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <iterator>
 #include <limits>
 #include <memory>
@@ -217,6 +218,20 @@ class RepeatedField final
   // array is grown, it will always be at least doubled in size.
   void Reserve(int new_size);
 
+  // Like Reserve(), but additionally tries to place the element array on an
+  // `align`-byte boundary so that `data()` can be fed to aligned vector
+  // loads.  `align` must be a power of two no smaller than alignof(Element).
+  //
+  // Only arena-backed fields can honor alignments above 8: heap blocks place
+  // an 8-byte header directly in front of the element array, so the array's
+  // alignment is fixed by `operator new`.  Returns true if `data()` satisfies
+  // `align` on return; callers that get false must fall back to unaligned
+  // loads or an aligned scratch buffer.
+  //
+  // The guarantee holds until the field reallocates, i.e. until it grows
+  // beyond Capacity(); call ReserveAligned() again after exceeding it.
+  bool ReserveAligned(int new_size, size_t align);
+
   // Resizes the RepeatedField to a new, smaller size.  This is O(1).
   // Except for RepeatedField<Cord>, for which it is O(size-new_size).
   void Truncate(int new_size);
@@ -236,6 +251,10 @@ class RepeatedField final
 
   // Gets the underlying array.  This pointer is possibly invalidated by
   // any add or remove operation.
+  //
+  // Alignment contract: the array starts directly behind an 8-byte header,
+  // so it is 8-byte aligned but not, in general, any more than that.  Use
+  // ReserveAligned() to obtain stronger alignment on arena-backed fields.
   pointer mutable_data() ABSL_ATTRIBUTE_LIFETIME_BOUND;
   const_pointer data() const ABSL_ATTRIBUTE_LIFETIME_BOUND;
 
@@ -295,8 +314,9 @@ class RepeatedField final
   // Note: this can be inaccurate for split default fields so we make this
   // function non-const.
   inline Arena* GetArena() {
-    return (total_size_ == 0) ? static_cast<Arena*>(arena_or_elements_)
-                              : rep()->arena;
+    if (total_size_ == 0) return static_cast<Arena*>(arena_or_elements_);
+    // Inline storage is only used when there is no arena.
+    return is_soo() ? nullptr : rep()->arena;
   }
 
   // For internal use only.
@@ -329,6 +349,22 @@ class RepeatedField final
   static constexpr int kInitialSize = 0;
   static PROTOBUF_CONSTEXPR const size_t kRepHeaderSize = sizeof(Rep);
 
+  // Number of elements we can store inline in `arena_or_elements_` instead of
+  // allocating a Rep.  Inline storage is only used for trivial element types
+  // (so the bytes can be relocated with memswap/memcpy) and only on the heap;
+  // arena-backed fields keep the arena pointer in `arena_or_elements_` until
+  // the first Rep is allocated.  The capacity is deliberately kept strictly
+  // below RepeatedFieldLowerClampLimit(): every Rep is allocated with at least
+  // that many elements, so a total size in (0, clamp) uniquely identifies the
+  // inline representation without spending a discriminator bit.
+  static constexpr int kSooCapacityElements =
+      std::is_trivial<Element>::value
+          ? (static_cast<int>(kRepHeaderSize / sizeof(Element)) - 1 <
+                     static_cast<int>(sizeof(void*) / sizeof(Element))
+                 ? static_cast<int>(kRepHeaderSize / sizeof(Element)) - 1
+                 : static_cast<int>(sizeof(void*) / sizeof(Element)))
+          : 0;
+
   RepeatedField(Arena* arena, const RepeatedField& rhs);
   RepeatedField(Arena* arena, RepeatedField&& rhs);
 
@@ -379,11 +415,27 @@ class RepeatedField final
   void Grow(int current_size, int new_size);
   void GrowNoAnnotate(int current_size, int new_size);
 
+  // Returns true if the elements are stored inline in `arena_or_elements_`.
+  // Only ever true for trivial element types on heap-backed fields; see
+  // `kSooCapacityElements`.
+  bool is_soo() const {
+    return kSooCapacityElements > 0 && total_size_ == kSooCapacityElements;
+  }
+
+  // Returns a pointer to the inline element storage.
+  // pre-condition: is_soo() is true.
+  Element* soo_elements() const {
+    return reinterpret_cast<Element*>(const_cast<void**>(&arena_or_elements_));
+  }
+
   // Annotates a change in size of this instance. This function should be called
   // with (total_size, current_size) after new memory has been allocated and
   // filled from previous memory), and called with (current_size, total_size)
   // right before (previously annotated) memory is released.
   void AnnotateSize(int old_size, int new_size) const {
+    // Inline storage shares the `arena_or_elements_` word and may end in the
+    // middle of a shadow-memory granule, so it is not container-annotated.
+    if (is_soo()) return;
     if (old_size != new_size) {
       ABSL_ANNOTATE_CONTIGUOUS_CONTAINER(
           unsafe_elements(), unsafe_elements() + total_size_,
@@ -419,12 +471,15 @@ class RepeatedField final
   // an invalid pointer is returned. This only happens for empty repeated
   // fields, where you can't dereference this pointer anyway (it's empty).
   Element* unsafe_elements() const {
-    return static_cast<Element*>(arena_or_elements_);
+    return is_soo() ? soo_elements()
+                    : static_cast<Element*>(arena_or_elements_);
   }
 
   // Returns a pointer to the Rep struct.
-  // pre-condition: the Rep must have been allocated, ie elements() is safe.
+  // pre-condition: the Rep must have been allocated, ie elements() is safe and
+  // the elements are not stored inline.
   Rep* rep() const {
+    ABSL_DCHECK(!is_soo());
     return reinterpret_cast<Rep*>(reinterpret_cast<char*>(elements()) -
                                   kRepHeaderSize);
   }
@@ -457,6 +512,10 @@ class RepeatedField final
   // If total_size_ == 0 this points to an Arena otherwise it points to the
   // elements member of a Rep struct. Using this invariant allows the storage of
   // the arena pointer without an extra allocation in the constructor.
+  // As a third state, for trivial element types on the heap, a small number of
+  // elements (kSooCapacityElements) is stored directly in this word; this
+  // state is identified by total_size_ being in (0, lower clamp limit), a
+  // capacity no Rep is ever allocated with.
   void* arena_or_elements_;
 };
 
@@ -505,7 +564,7 @@ RepeatedField<Element>::~RepeatedField() {
 #endif
   if (total_size_ > 0) {
     Destroy(unsafe_elements(), unsafe_elements() + current_size_);
-    InternalDeallocate<true>();
+    if (!is_soo()) InternalDeallocate<true>();
   }
 }
 
@@ -619,16 +678,16 @@ inline const Element& RepeatedField<Element>::Get(int index) const
 template <typename Element>
 inline const Element& RepeatedField<Element>::at(int index) const
     ABSL_ATTRIBUTE_LIFETIME_BOUND {
-  ABSL_CHECK_GE(index, 0);
-  ABSL_CHECK_LT(index, current_size_);
+  PROTOBUF_HARDENING_ASSERT(index >= 0);
+  PROTOBUF_HARDENING_ASSERT(index < current_size_);
   return elements()[index];
 }
 
 template <typename Element>
 inline Element& RepeatedField<Element>::at(int index)
     ABSL_ATTRIBUTE_LIFETIME_BOUND {
-  ABSL_CHECK_GE(index, 0);
-  ABSL_CHECK_LT(index, current_size_);
+  PROTOBUF_HARDENING_ASSERT(index >= 0);
+  PROTOBUF_HARDENING_ASSERT(index < current_size_);
   return elements()[index];
 }
 
@@ -660,9 +719,11 @@ inline void RepeatedField<Element>::Add(Element value) {
   void* p = elem + ExchangeCurrentSize(new_size);
   ::new (p) Element(std::move(value));
 
-  // The below helps the compiler optimize dense loops.
+  // The below helps the compiler optimize dense loops.  The element pointer
+  // assumption only holds for Rep-backed fields; with inline storage
+  // `arena_or_elements_` holds the elements themselves.
   ABSL_ASSUME(new_size == current_size_);
-  ABSL_ASSUME(elem == arena_or_elements_);
+  ABSL_ASSUME(kSooCapacityElements > 0 || elem == arena_or_elements_);
   ABSL_ASSUME(total_size == total_size_);
 }
 
@@ -688,9 +749,10 @@ inline void RepeatedField<Element>::AddForwardIterator(Iter begin, Iter end) {
   }
   UninitializedCopy(begin, end, elem + ExchangeCurrentSize(new_size));
 
-  // The below helps the compiler optimize dense loops.
+  // The below helps the compiler optimize dense loops.  See `Add()` for why
+  // the element pointer assumption is conditional.
   ABSL_ASSUME(new_size == current_size_);
-  ABSL_ASSUME(elem == arena_or_elements_);
+  ABSL_ASSUME(kSooCapacityElements > 0 || elem == arena_or_elements_);
   ABSL_ASSUME(total_size == total_size_);
 }
 
@@ -892,7 +954,9 @@ RepeatedField<Element>::cend() const ABSL_ATTRIBUTE_LIFETIME_BOUND {
 
 template <typename Element>
 inline size_t RepeatedField<Element>::SpaceUsedExcludingSelfLong() const {
-  return total_size_ > 0 ? (total_size_ * sizeof(Element) + kRepHeaderSize) : 0;
+  return total_size_ > 0 && !is_soo()
+             ? (total_size_ * sizeof(Element) + kRepHeaderSize)
+             : 0;
 }
 
 namespace internal {
@@ -931,6 +995,80 @@ void RepeatedField<Element>::Reserve(int new_size) {
   }
 }
 
+template <typename Element>
+PROTOBUF_NOINLINE bool RepeatedField<Element>::ReserveAligned(int new_size,
+                                                              size_t align) {
+  ABSL_DCHECK_EQ(align & (align - 1), size_t{0})
+      << "align must be a power of two";
+  ABSL_DCHECK_GE(align, alignof(Element));
+  const auto is_aligned = [align](const void* p) {
+    return (reinterpret_cast<uintptr_t>(p) & (align - 1)) == 0;
+  };
+  Arena* arena = GetArena();
+  if (arena == nullptr || align <= internal::ArenaAlignDefault::align) {
+    // Either the requested alignment already follows from the 8-byte
+    // alignment of every Rep, or the field is heap-backed and the array's
+    // placement is fixed by `operator new`; a plain reservation is the best
+    // we can do.
+    Reserve(new_size);
+    return total_size_ == 0 || is_aligned(unsafe_elements());
+  }
+  if (new_size <= total_size_ && total_size_ > 0 && is_aligned(elements())) {
+    return true;
+  }
+
+  const int current_size = current_size_;
+  AnnotateSize(current_size, total_size_);
+  if (new_size > total_size_) {
+    new_size = internal::CalculateReserveSize<Element, kRepHeaderSize>(
+        total_size_, new_size);
+  } else {
+    // Pure realignment: keep the current capacity.
+    new_size = std::max(
+        total_size_,
+        internal::RepeatedFieldLowerClampLimit<Element, kRepHeaderSize>());
+  }
+  // Pad the front of the block so the element array, which lives
+  // kRepHeaderSize bytes into it, lands on an `align` boundary.  The padding
+  // stays owned by the arena: InternalDeallocate() returns only the Rep
+  // suffix, which ReturnArrayMemory() accepts.
+  const size_t padding = (align - kRepHeaderSize % align) % align;
+  ABSL_DCHECK_LE(static_cast<size_t>(new_size),
+                 (std::numeric_limits<size_t>::max() - kRepHeaderSize -
+                  padding) /
+                     sizeof(Element))
+      << "Requested size is too large to fit into size_t.";
+  const size_t bytes =
+      kRepHeaderSize + sizeof(Element) * static_cast<size_t>(new_size);
+  char* block =
+      static_cast<char*>(arena->AllocateAligned(bytes + padding, align));
+  Rep* new_rep = reinterpret_cast<Rep*>(block + padding);
+  new_rep->arena = arena;
+
+  if (total_size_ > 0) {
+    if (current_size > 0) {
+      Element* pnew = new_rep->elements();
+      Element* pold = elements();
+      if (std::is_trivial<Element>::value) {
+        memcpy(static_cast<void*>(pnew), pold, current_size * sizeof(Element));
+      } else {
+        for (Element* end = pnew + current_size; pnew != end; ++pnew, ++pold) {
+          ::new (static_cast<void*>(pnew)) Element(std::move(*pold));
+          pold->~Element();
+        }
+      }
+    }
+    // Arena-backed fields never use inline storage, so there is always a Rep
+    // to give back.
+    InternalDeallocate();
+  }
+
+  total_size_ = new_size;
+  arena_or_elements_ = new_rep->elements();
+  AnnotateSize(total_size_, current_size);
+  return true;
+}
+
 // Avoid inlining of Reserve(): new, copy, and delete[] lead to a significant
 // amount of code bloat.
 template <typename Element>
@@ -940,6 +1078,16 @@ PROTOBUF_NOINLINE void RepeatedField<Element>::GrowNoAnnotate(int current_size,
   Rep* new_rep;
   Arena* arena = GetArena();
 
+  if (kSooCapacityElements > 0 && arena == nullptr && total_size_ == 0 &&
+      new_size <= kSooCapacityElements) {
+    // Small first growth on the heap: store the elements inline in
+    // `arena_or_elements_` instead of allocating a Rep.  This is by far the
+    // most common case for repeated fields holding only a handful of values.
+    total_size_ = kSooCapacityElements;
+    return;
+  }
+  const bool was_soo = is_soo();
+
   new_size = internal::CalculateReserveSize<Element, kRepHeaderSize>(
       total_size_, new_size);
 
@@ -978,7 +1126,7 @@ PROTOBUF_NOINLINE void RepeatedField<Element>::GrowNoAnnotate(int current_size,
         }
       }
     }
-    InternalDeallocate();
+    if (!was_soo) InternalDeallocate();
   }
 
   total_size_ = new_size;
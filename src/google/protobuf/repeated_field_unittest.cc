@@ -32,6 +32,7 @@
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include "absl/container/flat_hash_map.h"
 #include "absl/log/absl_check.h"
 #include "absl/numeric/bits.h"
 #include "absl/random/random.h"
@@ -230,6 +231,70 @@ TEST(RepeatedField, Large) {
   EXPECT_GE(field.SpaceUsedExcludingSelf(), expected_usage);
 }
 
+// Heap-backed fields with only a handful of small elements store them inline
+// in the field itself and should not report (or perform) any allocation.
+TEST(RepeatedField, SmallHeapFieldsStoreElementsInline) {
+  RepeatedField<int> field;
+  field.Add(7);
+  EXPECT_EQ(field.SpaceUsedExcludingSelf(), 0);
+  EXPECT_EQ(field.size(), 1);
+  EXPECT_EQ(field.Get(0), 7);
+  EXPECT_EQ(field.GetArena(), nullptr);
+
+  // Growing past the inline capacity moves the elements to a heap Rep.
+  for (int i = 0; i < 16; i++) {
+    field.Add(i);
+  }
+  EXPECT_GT(field.SpaceUsedExcludingSelf(), 0);
+  EXPECT_EQ(field.Get(0), 7);
+  for (int i = 0; i < 16; i++) {
+    EXPECT_EQ(field.Get(i + 1), i);
+  }
+}
+
+TEST(RepeatedField, InlineStorageCapacityMatchesElementWidth) {
+  // bool packs several elements into the inline word.
+  RepeatedField<bool> bools;
+  for (int i = 0; i < 4; i++) {
+    bools.Add(i % 2 == 0);
+  }
+  EXPECT_EQ(bools.SpaceUsedExcludingSelf(), 0);
+  for (int i = 0; i < 4; i++) {
+    EXPECT_EQ(bools.Get(i), i % 2 == 0);
+  }
+
+  // Word-sized elements cannot share the word with anything and always
+  // allocate.
+  RepeatedField<int64_t> longs;
+  longs.Add(int64_t{1} << 40);
+  EXPECT_GT(longs.SpaceUsedExcludingSelf(), 0);
+  EXPECT_EQ(longs.Get(0), int64_t{1} << 40);
+}
+
+TEST(RepeatedField, InlineStorageSwapAndMove) {
+  RepeatedField<int> a;
+  RepeatedField<int> b;
+  a.Add(1);
+  b.Add(2);
+  a.Swap(&b);
+  EXPECT_THAT(a, ElementsAre(2));
+  EXPECT_THAT(b, ElementsAre(1));
+
+  RepeatedField<int> moved = std::move(a);
+  EXPECT_THAT(moved, ElementsAre(2));
+  EXPECT_EQ(moved.GetArena(), nullptr);
+}
+
+TEST(RepeatedField, ArenaFieldsDoNotUseInlineStorage) {
+  // On an arena the field must keep its elements in arena memory so that
+  // they outlive moves of the field itself.
+  Arena arena;
+  auto* field = Arena::Create<RepeatedField<int>>(&arena);
+  field->Add(1);
+  EXPECT_GT(field->SpaceUsedExcludingSelf(), 0);
+  EXPECT_EQ(field->GetArena(), &arena);
+}
+
 template <typename Rep>
 void CheckAllocationSizes(bool is_ptr) {
   using T = typename Rep::value_type;
@@ -575,6 +640,59 @@ TEST(RepeatedField, ReserveHuge) {
 #endif  // PROTOBUF_TEST_ALLOW_LARGE_ALLOC
 }
 
+TEST(RepeatedField, ReserveAlignedOnArena) {
+  Arena arena;
+  auto* field = Arena::Create<RepeatedField<float>>(&arena);
+  for (int i = 0; i < 5; ++i) field->Add(static_cast<float>(i));
+
+  EXPECT_TRUE(field->ReserveAligned(64, 64));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(field->data()) % 64, 0);
+  EXPECT_GE(field->Capacity(), 64);
+
+  // The realignment must preserve the existing elements.
+  ASSERT_EQ(field->size(), 5);
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(field->Get(i), static_cast<float>(i));
+  }
+
+  // Filling up to capacity must not reallocate, so the alignment holds.
+  const float* data = field->data();
+  while (field->size() < field->Capacity()) {
+    field->Add(0.0f);
+  }
+  EXPECT_EQ(field->data(), data);
+}
+
+TEST(RepeatedField, ReserveAlignedRealignsExistingCapacity) {
+  Arena arena;
+  auto* field = Arena::Create<RepeatedField<float>>(&arena);
+  field->Reserve(32);
+  for (int i = 0; i < 3; ++i) field->Add(static_cast<float>(i));
+
+  // A request within the current capacity still reallocates if the array is
+  // not yet aligned, but must not shrink it.
+  const int old_capacity = field->Capacity();
+  EXPECT_TRUE(field->ReserveAligned(0, 64));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(field->data()) % 64, 0);
+  EXPECT_GE(field->Capacity(), old_capacity);
+  ASSERT_EQ(field->size(), 3);
+  EXPECT_EQ(field->Get(2), 2.0f);
+
+  // Once aligned, a second request is a no-op.
+  const float* data = field->data();
+  EXPECT_TRUE(field->ReserveAligned(field->Capacity(), 64));
+  EXPECT_EQ(field->data(), data);
+}
+
+TEST(RepeatedField, ReserveAlignedOnHeapFallsBackToReserve) {
+  RepeatedField<float> field;
+  const bool aligned = field.ReserveAligned(64, 64);
+  // Heap blocks cannot be over-aligned; the call must still reserve space and
+  // report whether the allocator happened to satisfy the request.
+  EXPECT_GE(field.Capacity(), 64);
+  EXPECT_EQ(aligned, reinterpret_cast<uintptr_t>(field.data()) % 64 == 0);
+}
+
 TEST(RepeatedField, MergeFrom) {
   RepeatedField<int> source, destination;
   source.Add(4);
@@ -1376,6 +1494,57 @@ TEST(RepeatedPtrField, ClearThenReserveMore) {
   // strings.
 }
 
+TEST(RepeatedPtrField, ClearRecyclesElementsOnAdd) {
+  // Clear() retains element objects and Add() must recycle them, on both heap
+  // and arena, so that a Clear()/refill cycle reaches an allocation-free
+  // steady state.  Streaming decoders rely on this.
+  for (bool use_arena : {false, true}) {
+    Arena arena;
+    auto* field =
+        use_arena ? Arena::Create<RepeatedPtrField<TestAllTypes>>(&arena)
+                  : Arena::Create<RepeatedPtrField<TestAllTypes>>(nullptr);
+    std::vector<TestAllTypes*> original;
+    for (int i = 0; i < 16; i++) {
+      TestAllTypes* element = field->Add();
+      element->set_optional_int32(i);
+      original.push_back(element);
+    }
+    field->Clear();
+    ASSERT_EQ(0, field->size());
+    for (int i = 0; i < 16; i++) {
+      TestAllTypes* element = field->Add();
+      // Same object, already cleared.
+      EXPECT_EQ(original[i], element);
+      EXPECT_FALSE(element->has_optional_int32());
+    }
+    if (!use_arena) delete field;
+  }
+}
+
+TEST(RepeatedPtrField, ClearRecyclesElementsOnParse) {
+  // The parser's add paths recycle retained elements just like Add().
+  TestAllTypes source;
+  for (int i = 0; i < 16; i++) {
+    source.add_repeated_nested_message()->set_bb(i);
+  }
+  std::string wire = source.SerializeAsString();
+
+  Arena arena;
+  TestAllTypes* message = Arena::Create<TestAllTypes>(&arena);
+  ASSERT_TRUE(message->ParseFromString(wire));
+  std::vector<const TestAllTypes::NestedMessage*> original;
+  for (const auto& sub : message->repeated_nested_message()) {
+    original.push_back(&sub);
+  }
+  message->Clear();
+  ASSERT_TRUE(message->ParseFromString(wire));
+  ASSERT_EQ(16, message->repeated_nested_message_size());
+  for (int i = 0; i < 16; i++) {
+    EXPECT_EQ(original[i], &message->repeated_nested_message(i));
+    EXPECT_EQ(i, message->repeated_nested_message(i).bb());
+  }
+}
+
 // This helper overload set tests whether X::f can be called with a braced pair,
 // X::f({a, b}) of std::string iterators (specifically, pointers: That call is
 // ambiguous if and only if the call to ValidResolutionPointerRange is not.
@@ -1687,6 +1856,154 @@ TEST(RepeatedPtrField, ClearedElements) {
   PROTOBUF_IGNORE_DEPRECATION_STOP
 }
 
+// Once a repeated message field on an arena grows past a small threshold,
+// parsing constructs elements in batches, so the field ends the parse with
+// spare constructed elements filling all of its capacity.
+TEST(RepeatedPtrField, ParseBatchesMessageElementsOnArena) {
+  PROTOBUF_IGNORE_DEPRECATION_START
+  protobuf_unittest::NestedTestAllTypes source;
+  for (int i = 0; i < 100; ++i) {
+    source.add_repeated_child()->mutable_payload()->set_optional_int32(i);
+  }
+  const std::string serialized = source.SerializeAsString();
+
+  Arena arena;
+  auto* parsed = Arena::Create<protobuf_unittest::NestedTestAllTypes>(&arena);
+  ASSERT_TRUE(parsed->ParseFromString(serialized));
+  const auto& field = parsed->repeated_child();
+  ASSERT_EQ(100, field.size());
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(i, field.Get(i).payload().optional_int32());
+  }
+  // Every slot of the pointer array holds a constructed element; the ones
+  // beyond size() are spares waiting to be handed out as cleared elements.
+  EXPECT_EQ(field.Capacity() - field.size(), field.ClearedCount());
+
+  // Heap-backed messages keep the one-at-a-time behavior.
+  protobuf_unittest::NestedTestAllTypes heap_parsed;
+  ASSERT_TRUE(heap_parsed.ParseFromString(serialized));
+  EXPECT_EQ(0, heap_parsed.repeated_child().ClearedCount());
+  PROTOBUF_IGNORE_DEPRECATION_STOP
+}
+
+// Elements constructed in one batch are laid out back to back in arena
+// memory even when parsing each element's contents allocates in between.
+TEST(RepeatedPtrField, BatchedMessageElementsAreContiguous) {
+  protobuf_unittest::NestedTestAllTypes source;
+  for (int i = 0; i < 100; ++i) {
+    // Vary the string length so that per-element allocations would scatter
+    // the elements if they were constructed one at a time.
+    source.add_repeated_child()->mutable_payload()->set_optional_string(
+        std::string(i % 40, 'x'));
+  }
+  const std::string serialized = source.SerializeAsString();
+
+  // A single large block keeps all allocations in one contiguous region.
+  ArenaOptions options;
+  options.start_block_size = 1 << 20;
+  Arena arena(options);
+  auto* parsed = Arena::Create<protobuf_unittest::NestedTestAllTypes>(&arena);
+  ASSERT_TRUE(parsed->ParseFromString(serialized));
+  const auto& field = parsed->repeated_child();
+  ASSERT_EQ(100, field.size());
+
+  // Within a batch consecutive elements are exactly one object apart.  Count
+  // how many gaps match the most common stride; only the pre-threshold
+  // elements and the handful of batch boundaries may differ.
+  absl::flat_hash_map<ptrdiff_t, int> stride_counts;
+  for (int i = 1; i < field.size(); ++i) {
+    ++stride_counts[reinterpret_cast<const char*>(&field.Get(i)) -
+                    reinterpret_cast<const char*>(&field.Get(i - 1))];
+  }
+  int most_common = 0;
+  for (const auto& entry : stride_counts) {
+    most_common = std::max(most_common, entry.second);
+  }
+  EXPECT_GE(most_common, (field.size() - 1) / 2);
+}
+
+// Spare elements left over from a batched parse are reused by later Adds and
+// merges, like any other cleared elements.
+TEST(RepeatedPtrField, BatchedSpareElementsAreReused) {
+  protobuf_unittest::NestedTestAllTypes source;
+  for (int i = 0; i < 50; ++i) {
+    source.add_repeated_child()->mutable_payload()->set_optional_int32(i);
+  }
+  const std::string serialized = source.SerializeAsString();
+
+  Arena arena;
+  auto* parsed = Arena::Create<protobuf_unittest::NestedTestAllTypes>(&arena);
+  ASSERT_TRUE(parsed->ParseFromString(serialized));
+  parsed->clear_repeated_child();
+  ASSERT_TRUE(parsed->MergeFromString(serialized));
+  ASSERT_EQ(50, parsed->repeated_child_size());
+  for (int i = 0; i < 50; ++i) {
+    EXPECT_EQ(i, parsed->repeated_child(i).payload().optional_int32());
+  }
+}
+
+// ReserveWithElements() on an arena pre-constructs an element for every
+// reserved slot, so subsequent Adds hand them out without touching the
+// arena, and the elements sit back to back in memory.
+TEST(RepeatedPtrField, ReserveWithElementsPreconstructsOnArena) {
+  PROTOBUF_IGNORE_DEPRECATION_START
+  // A single large block keeps all allocations in one contiguous region.
+  ArenaOptions options;
+  options.start_block_size = 1 << 20;
+  Arena arena(options);
+  auto* field = Arena::Create<RepeatedPtrField<TestAllTypes>>(&arena);
+  field->ReserveWithElements(64);
+  EXPECT_GE(field->Capacity(), 64);
+  EXPECT_EQ(64, field->ClearedCount());
+
+  std::vector<const TestAllTypes*> elements;
+  for (int i = 0; i < 64; ++i) {
+    elements.push_back(field->Add());
+  }
+  // All Adds were satisfied from the pre-constructed elements.
+  EXPECT_EQ(0, field->ClearedCount());
+  // The elements were constructed in one tight loop, so consecutive ones
+  // are exactly one object apart.
+  for (size_t i = 1; i < elements.size(); ++i) {
+    EXPECT_EQ(reinterpret_cast<const char*>(elements[i]) -
+                  reinterpret_cast<const char*>(elements[i - 1]),
+              static_cast<ptrdiff_t>(sizeof(TestAllTypes)));
+  }
+  PROTOBUF_IGNORE_DEPRECATION_STOP
+}
+
+// On the heap ReserveWithElements() degrades to plain Reserve(): elements
+// are still constructed lazily, one per Add.
+TEST(RepeatedPtrField, ReserveWithElementsOnHeapOnlyReserves) {
+  PROTOBUF_IGNORE_DEPRECATION_START
+  RepeatedPtrField<TestAllTypes> field;
+  field.ReserveWithElements(32);
+  EXPECT_GE(field.Capacity(), 32);
+  EXPECT_EQ(0, field.ClearedCount());
+  PROTOBUF_IGNORE_DEPRECATION_STOP
+}
+
+// Pre-construction only fills the slots beyond what is already allocated,
+// and leaves existing contents alone.
+TEST(RepeatedPtrField, ReserveWithElementsKeepsExistingElements) {
+  PROTOBUF_IGNORE_DEPRECATION_START
+  Arena arena;
+  auto* field = Arena::Create<RepeatedPtrField<TestAllTypes>>(&arena);
+  for (int i = 0; i < 5; ++i) {
+    field->Add()->set_optional_int32(i);
+  }
+  field->ReserveWithElements(20);
+  EXPECT_EQ(15, field->ClearedCount());
+  ASSERT_EQ(5, field->size());
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(i, field->Get(i).optional_int32());
+  }
+  // A second call with a smaller size is a no-op.
+  field->ReserveWithElements(10);
+  EXPECT_EQ(15, field->ClearedCount());
+  PROTOBUF_IGNORE_DEPRECATION_STOP
+}
+
 // Test all code paths in AddAllocated().
 TEST(RepeatedPtrField, AddAllocated) {
   RepeatedPtrField<std::string> field;
@@ -1775,6 +2092,92 @@ TEST(RepeatedPtrField, MergeFrom) {
   EXPECT_EQ("5", destination.Get(4));
 }
 
+TEST(RepeatedPtrField, MergeFromOnArena) {
+  Arena arena;
+  RepeatedPtrField<std::string> source;
+  auto& destination = *Arena::Create<RepeatedPtrField<std::string>>(&arena);
+  source.Add()->assign("2");
+  // Long enough to defeat the small string optimization.
+  source.Add()->assign(std::string(256, 'x'));
+  destination.Add()->assign("1");
+
+  destination.MergeFrom(source);
+
+  ASSERT_EQ(3, destination.size());
+  EXPECT_EQ("1", destination.Get(0));
+  EXPECT_EQ("2", destination.Get(1));
+  EXPECT_EQ(std::string(256, 'x'), destination.Get(2));
+}
+
+TEST(RepeatedPtrField, MoveMergeFromSplicesElements) {
+  RepeatedPtrField<std::string> source, destination;
+  source.Add()->assign("4");
+  source.Add()->assign("5");
+  destination.Add()->assign("1");
+  destination.Add()->assign("2");
+  destination.Add()->assign("3");
+  const std::string* const spliced = &source.Get(0);
+
+  destination.MergeFrom(std::move(source));
+
+  ASSERT_EQ(5, destination.size());
+  EXPECT_EQ("1", destination.Get(0));
+  EXPECT_EQ("4", destination.Get(3));
+  EXPECT_EQ("5", destination.Get(4));
+  // The element objects themselves moved over; nothing was copied.
+  EXPECT_EQ(spliced, &destination.Get(3));
+  EXPECT_EQ(0, source.size());
+}
+
+TEST(RepeatedPtrField, MoveMergeFromIntoEmpty) {
+  RepeatedPtrField<std::string> source, destination;
+  source.Add()->assign("1");
+  source.Add()->assign("2");
+  const std::string* const spliced = &source.Get(0);
+
+  destination.MergeFrom(std::move(source));
+
+  ASSERT_EQ(2, destination.size());
+  EXPECT_EQ("1", destination.Get(0));
+  EXPECT_EQ(spliced, &destination.Get(0));
+  EXPECT_EQ(0, source.size());
+}
+
+TEST(RepeatedPtrField, MoveMergeFromOnSameArena) {
+  Arena arena;
+  auto& source = *Arena::Create<RepeatedPtrField<std::string>>(&arena);
+  auto& destination = *Arena::Create<RepeatedPtrField<std::string>>(&arena);
+  source.Add()->assign("2");
+  destination.Add()->assign("1");
+  const std::string* const spliced = &source.Get(0);
+
+  destination.MergeFrom(std::move(source));
+
+  ASSERT_EQ(2, destination.size());
+  EXPECT_EQ("1", destination.Get(0));
+  EXPECT_EQ("2", destination.Get(1));
+  EXPECT_EQ(spliced, &destination.Get(1));
+  EXPECT_EQ(0, source.size());
+}
+
+TEST(RepeatedPtrField, MoveMergeFromDifferentArenasCopies) {
+  Arena arena;
+  RepeatedPtrField<std::string> source;
+  auto& destination = *Arena::Create<RepeatedPtrField<std::string>>(&arena);
+  source.Add()->assign("2");
+  // Long enough to defeat the small string optimization.
+  source.Add()->assign(std::string(256, 'x'));
+  destination.Add()->assign("1");
+
+  destination.MergeFrom(std::move(source));
+
+  ASSERT_EQ(3, destination.size());
+  EXPECT_EQ("1", destination.Get(0));
+  EXPECT_EQ("2", destination.Get(1));
+  EXPECT_EQ(std::string(256, 'x'), destination.Get(2));
+  EXPECT_EQ(0, source.size());
+}
+
 
 TEST(RepeatedPtrField, CopyFrom) {
   RepeatedPtrField<std::string> source, destination;
@@ -16,6 +16,7 @@
 #include <cstdint>
 #include <cstring>
 #include <limits>
+#include <new>
 #include <string>
 
 #include "absl/base/prefetch.h"
@@ -24,6 +25,7 @@
 #include "google/protobuf/message_lite.h"
 #include "google/protobuf/port.h"
 #include "google/protobuf/repeated_field.h"
+#include "google/protobuf/serial_arena.h"
 
 // Must be included last.
 #include "google/protobuf/port_def.inc"
@@ -85,6 +87,23 @@ void RepeatedPtrFieldBase::Reserve(int capacity) {
   }
 }
 
+void RepeatedPtrFieldBase::ReserveWithElements(int capacity,
+                                               ElementFactory factory) {
+  Reserve(capacity);
+  Arena* const arena = GetArena();
+  if (arena == nullptr || capacity <= 0) return;
+  if (using_sso()) {
+    // capacity was 1 or less; at most the SSO slot to fill.
+    if (tagged_rep_or_elem_ == nullptr) tagged_rep_or_elem_ = factory(arena);
+    return;
+  }
+  Rep* r = rep();
+  for (int i = r->allocated_size; i < capacity; ++i) {
+    r->elements[i] = factory(arena);
+  }
+  r->allocated_size = std::max(r->allocated_size, capacity);
+}
+
 void RepeatedPtrFieldBase::DestroyProtos() {
   PROTOBUF_ALWAYS_INLINE_CALL Destroy<GenericTypeHandler<MessageLite>>();
 
@@ -152,7 +171,33 @@ void RepeatedPtrFieldBase::CloseGap(int start, int num) {
   ExchangeCurrentSize(current_size_ - num);
 }
 
+// Minimum capacity at which AddMessage() starts constructing elements in
+// batches.  Small fields keep the one-at-a-time behavior so that we never
+// construct speculative elements for fields that stay small.
+constexpr int kElementBatchThreshold = 16;
+
 MessageLite* RepeatedPtrFieldBase::AddMessage(const MessageLite* prototype) {
+  Arena* const arena = GetArena();
+  if (arena != nullptr && current_size_ == allocated_size() &&
+      Capacity() >= kElementBatchThreshold) {
+    // The field has grown enough that it is likely to keep growing.  Construct
+    // elements for every spare slot in one tight loop: default construction
+    // allocates nothing but the element itself, so consecutive elements
+    // bump-allocate back to back from the arena and end up contiguous in
+    // memory (modulo arena block boundaries).  Subsequent Adds consume the
+    // spares through the cleared-element path before constructing again, and
+    // iterating large repeated message fields after a parse walks sequential
+    // memory instead of elements scattered between their own subobjects.
+    if (SizeAtCapacity()) InternalExtend(1);
+    Rep* r = rep();
+    const int capacity = Capacity();
+    for (int i = r->allocated_size; i < capacity; ++i) {
+      r->elements[i] = prototype->New(arena);
+    }
+    r->allocated_size = capacity;
+    return static_cast<MessageLite*>(
+        r->elements[ExchangeCurrentSize(current_size_ + 1)]);
+  }
   return static_cast<MessageLite*>(
       AddInternal([prototype](Arena* a) { return prototype->New(a); }));
 }
@@ -178,8 +223,19 @@ void RepeatedPtrFieldBase::MergeFrom<std::string>(
     (*dst)->assign(**src);
   }
   if (Arena* const arena = arena_) {
-    for (; src < end; ++dst, ++src) {
-      *dst = Arena::Create<std::string>(arena, **src);
+    SerialArena* serial_arena;
+    if (PROTOBUF_PREDICT_TRUE(arena->impl_.GetSerialArenaFast(&serial_arena))) {
+      // Bump-allocate all new elements from the arena's string blocks,
+      // resolving the SerialArena once instead of once per element. Strings
+      // in string blocks are destroyed in bulk when the arena is destroyed,
+      // so no cleanup registration is needed.
+      for (; src < end; ++dst, ++src) {
+        *dst = new (serial_arena->AllocateFromStringBlock()) std::string(**src);
+      }
+    } else {
+      for (; src < end; ++dst, ++src) {
+        *dst = Arena::Create<std::string>(arena, **src);
+      }
     }
   } else {
     for (; src < end; ++dst, ++src) {
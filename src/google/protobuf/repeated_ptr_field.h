@@ -162,15 +162,15 @@ class PROTOBUF_EXPORT RepeatedPtrFieldBase {
 
   template <typename TypeHandler>
   const Value<TypeHandler>& at(int index) const {
-    ABSL_CHECK_GE(index, 0);
-    ABSL_CHECK_LT(index, current_size_);
+    PROTOBUF_HARDENING_ASSERT(index >= 0);
+    PROTOBUF_HARDENING_ASSERT(index < current_size_);
     return *cast<TypeHandler>(element_at(index));
   }
 
   template <typename TypeHandler>
   Value<TypeHandler>& at(int index) {
-    ABSL_CHECK_GE(index, 0);
-    ABSL_CHECK_LT(index, current_size_);
+    PROTOBUF_HARDENING_ASSERT(index >= 0);
+    PROTOBUF_HARDENING_ASSERT(index < current_size_);
     return *cast<TypeHandler>(element_at(index));
   }
 
@@ -249,6 +249,10 @@ class PROTOBUF_EXPORT RepeatedPtrFieldBase {
   // Creates and adds an element using the given prototype, without introducing
   // a link-time dependency on the concrete message type.
   //
+  // On arenas, once the field has grown past a small threshold this constructs
+  // elements for all spare capacity in one batch so that they sit contiguously
+  // in memory; the extras are handed out by later calls as cleared elements.
+  //
   // Pre-condition: prototype must not be nullptr.
   MessageLite* AddMessage(const MessageLite* prototype);
 
@@ -326,6 +330,11 @@ class PROTOBUF_EXPORT RepeatedPtrFieldBase {
 
   void Reserve(int capacity);
 
+  // Like Reserve(), but on arenas also constructs an element for every new
+  // slot up to `capacity` with `factory`.  See the public wrapper in
+  // RepeatedPtrField for the rationale.
+  void ReserveWithElements(int capacity, ElementFactory factory);
+
   template <typename TypeHandler>
   static inline Value<TypeHandler>* copy(const Value<TypeHandler>* value) {
     using H = CommonHandler<TypeHandler>;
@@ -1006,8 +1015,21 @@ class RepeatedPtrField final : private internal::RepeatedPtrFieldBase {
   // Calling this routine inside a loop can cause quadratic behavior.
   void DeleteSubrange(int start, int num);
 
+  // Clears all elements, leaving size() at zero.  The element objects
+  // themselves are retained (cleared in place) and recycled by subsequent
+  // Add() calls and by parsing, on both heap and arena: a message that is
+  // Clear()ed and reparsed each cycle reaches a steady state where repeated
+  // elements allocate nothing.  Use DeleteSubrange() or a fresh field to
+  // actually release element memory.
   ABSL_ATTRIBUTE_REINITIALIZES void Clear();
   void MergeFrom(const RepeatedPtrField& other);
+
+  // Appends the elements of `other`, leaving `other` empty.  When both fields
+  // are on the same arena (or both on the heap), the element pointers are
+  // spliced over without copying or moving any element contents; otherwise
+  // elements cannot change owners and this degrades to the copying
+  // MergeFrom() above.
+  void MergeFrom(RepeatedPtrField&& other);
   ABSL_ATTRIBUTE_REINITIALIZES void CopyFrom(const RepeatedPtrField& other);
 
   // Replaces the contents with RepeatedPtrField(begin, end).
@@ -1019,6 +1041,16 @@ class RepeatedPtrField final : private internal::RepeatedPtrFieldBase {
   // array is grown, it will always be at least doubled in size.
   void Reserve(int new_size);
 
+  // Like Reserve(), but on arena-backed fields also default-constructs an
+  // element for every slot up to the given size, in one tight loop.  The
+  // elements bump-allocate back to back from the arena, so they end up
+  // contiguous in memory, and subsequent Add() calls hand them out as
+  // cleared elements instead of allocating.  Use it when the final size is
+  // known up front, e.g. in batch builders.  On the heap this is plain
+  // Reserve(): per-element allocations would cost the same either way and
+  // speculative elements would have to be freed.
+  void ReserveWithElements(int new_size);
+
   int Capacity() const;
 
   // Gets the underlying array.  This pointer is possibly invalidated by
@@ -1441,6 +1473,29 @@ inline void RepeatedPtrField<Element>::MergeFrom(
   RepeatedPtrFieldBase::MergeFrom<Element>(other);
 }
 
+template <typename Element>
+inline void RepeatedPtrField<Element>::MergeFrom(RepeatedPtrField&& other) {
+  if (other.empty()) return;
+  ABSL_DCHECK_NE(&other, this);
+  if (GetArena() != other.GetArena()) {
+    MergeFrom(other);
+    other.Clear();
+    return;
+  }
+  if (empty()) {
+    InternalSwap(&other);
+    return;
+  }
+  const int num = other.size();
+  Reserve(size() + num);
+  void** src = other.raw_mutable_data();
+  for (int i = 0; i < num; ++i) {
+    RepeatedPtrFieldBase::UnsafeArenaAddAllocated<TypeHandler>(
+        static_cast<Element*>(src[i]));
+  }
+  other.CloseGap(0, num);
+}
+
 template <typename Element>
 inline void RepeatedPtrField<Element>::CopyFrom(const RepeatedPtrField& other) {
   RepeatedPtrFieldBase::CopyFrom<TypeHandler>(other);
@@ -1547,6 +1602,12 @@ inline void RepeatedPtrField<Element>::Reserve(int new_size) {
   return RepeatedPtrFieldBase::Reserve(new_size);
 }
 
+template <typename Element>
+inline void RepeatedPtrField<Element>::ReserveWithElements(int new_size) {
+  RepeatedPtrFieldBase::ReserveWithElements(new_size,
+                                            TypeHandler::GetNewFunc());
+}
+
 template <typename Element>
 inline int RepeatedPtrField<Element>::Capacity() const {
   return RepeatedPtrFieldBase::Capacity();
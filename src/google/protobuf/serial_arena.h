@@ -24,6 +24,7 @@
 #include "absl/numeric/bits.h"
 #include "google/protobuf/arena_align.h"
 #include "google/protobuf/arena_cleanup.h"
+#include "google/protobuf/arena_telemetry.h"
 #include "google/protobuf/port.h"
 #include "google/protobuf/string_block.h"
 
@@ -100,6 +101,10 @@ class PROTOBUF_EXPORT SerialArena {
   }
   uint64_t SpaceUsed() const;
 
+  // Returns the portion of SpaceUsed() occupied by string blocks, walking
+  // the string block chain.  Subject to the same races as SpaceUsed().
+  uint64_t StringBlockSpaceUsed() const;
+
   // See comments on `cached_blocks_` member for details.
   PROTOBUF_ALWAYS_INLINE void* TryAllocateFromCachedBlock(size_t size) {
     if (PROTOBUF_PREDICT_FALSE(size < 16)) return nullptr;
@@ -128,6 +133,7 @@ class PROTOBUF_EXPORT SerialArena {
   void* AllocateAligned(size_t n) {
     ABSL_DCHECK(internal::ArenaAlignDefault::IsAligned(n));
     ABSL_DCHECK_GE(limit_, ptr());
+    internal::RecordArenaAllocation(n);
 
     if (alloc_client == AllocationClient::kArray) {
       if (void* res = TryAllocateFromCachedBlock(n)) {
@@ -242,17 +248,25 @@ class PROTOBUF_EXPORT SerialArena {
   void* AllocateAlignedWithCleanup(size_t n, size_t align,
                                    void (*destructor)(void*)) {
     n = ArenaAlignDefault::Ceil(n);
+    internal::RecordArenaAllocation(n);
     char* ret = ArenaAlignAs(align).CeilDefaultAligned(ptr());
     // See the comment in MaybeAllocateAligned re uintptr_t.
     if (PROTOBUF_PREDICT_FALSE(reinterpret_cast<uintptr_t>(ret) + n +
                                    cleanup::Size() >
                                reinterpret_cast<uintptr_t>(limit_))) {
+      // Extending an existing run consumes no node space, so it may still fit
+      // in this block even though an object plus a fresh node does not.
+      if (MaybeExtendCleanupRun(ret, n, destructor)) return ret;
       return AllocateAlignedWithCleanupFallback(n, align, destructor);
     }
     PROTOBUF_UNPOISON_MEMORY_REGION(ret, n);
     char* next = ret + n;
     set_ptr(next);
-    AddCleanupFromExisting(ret, destructor);
+    if (!MaybeAppendToCleanupRun(ret, n, destructor)) {
+      AddCleanupFromExisting(ret, destructor);
+      cleanup_run_stride_ = n;
+    }
+    cleanup_run_end_ = next;
     ABSL_DCHECK_GE(limit_, ptr());
     MaybePrefetchForwards(next);
     return ret;
@@ -302,6 +316,55 @@ class PROTOBUF_EXPORT SerialArena {
     MaybePrefetchBackwards(limit_);
     ABSL_DCHECK_GE(limit_, ptr());
     cleanup::CreateNode(limit_, elem, destructor);
+    // The top node is no longer a run candidate tracked by the sized
+    // allocation path; callers that know the object size reestablish it.
+    cleanup_run_end_ = nullptr;
+  }
+
+  // Tries to fold the object at `elem` into the run covered by the top
+  // cleanup node: same destructor, same stride, and laid out directly after
+  // the run's last object. Converts the top plain node into a run head on the
+  // first fold, which consumes the extra node slot the caller has already
+  // checked for.
+  PROTOBUF_ALWAYS_INLINE
+  bool MaybeAppendToCleanupRun(char* elem, size_t n,
+                               void (*destructor)(void*)) {
+    if (elem != cleanup_run_end_ || n != cleanup_run_stride_ ||
+        destructor != cleanup::ToCleanup(limit_)->destructor) {
+      return false;
+    }
+    if (cleanup::IsRunNode(limit_)) {
+      cleanup::ExtendRun(limit_);
+      return true;
+    }
+    const size_t cleanup_size = cleanup::Size();
+    PROTOBUF_UNPOISON_MEMORY_REGION(limit_ - cleanup_size, cleanup_size);
+    limit_ -= cleanup_size;
+    MaybePrefetchBackwards(limit_);
+    ABSL_DCHECK_GE(limit_, ptr());
+    cleanup::ConvertToRun(limit_, n);
+    return true;
+  }
+
+  // Like MaybeAppendToCleanupRun, but for the tight-space path where only an
+  // extension (which consumes no node space) can still fit in this block.
+  // Claims the object memory on success.
+  PROTOBUF_ALWAYS_INLINE
+  bool MaybeExtendCleanupRun(char* elem, size_t n, void (*destructor)(void*)) {
+    if (elem != cleanup_run_end_ || n != cleanup_run_stride_ ||
+        reinterpret_cast<uintptr_t>(elem) + n >
+            reinterpret_cast<uintptr_t>(limit_) ||
+        !cleanup::IsRunNode(limit_) ||
+        destructor != cleanup::ToCleanup(limit_)->destructor) {
+      return false;
+    }
+    PROTOBUF_UNPOISON_MEMORY_REGION(elem, n);
+    char* next = elem + n;
+    set_ptr(next);
+    cleanup::ExtendRun(limit_);
+    cleanup_run_end_ = next;
+    MaybePrefetchForwards(next);
+    return true;
   }
 
   // Prefetch the next kPrefetchForwardsDegree bytes after `prefetch_ptr_` and
@@ -386,6 +449,9 @@ class PROTOBUF_EXPORT SerialArena {
     prefetch_ptr_ = ptr;
     limit_ = limit;
     prefetch_limit_ = limit;
+    // Cleanup runs never span blocks.
+    cleanup_run_end_ = nullptr;
+    cleanup_run_stride_ = 0;
   }
 
   void* AllocateAlignedFallback(size_t n);
@@ -410,6 +476,13 @@ class PROTOBUF_EXPORT SerialArena {
   const char* prefetch_ptr_ = nullptr;
   const char* prefetch_limit_ = nullptr;
 
+  // Candidate state for coalescing sized cleanup registrations into runs: the
+  // address right after the last object covered by the top cleanup node, and
+  // that object's (default-aligned) size. Null whenever the top node was not
+  // created by the sized allocation path or a new head block was installed.
+  char* cleanup_run_end_ = nullptr;
+  size_t cleanup_run_stride_ = 0;
+
   // The active string block.
   std::atomic<StringBlock*> string_block_{nullptr};
 
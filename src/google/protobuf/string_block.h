@@ -39,18 +39,27 @@ class alignas(std::string) StringBlock {
   StringBlock(const StringBlock&) = delete;
   StringBlock& operator=(const StringBlock&) = delete;
 
+  // Largest block size that can be configured through `first_size` or
+  // `max_size_cap` below; bounded by the uint16_t size bookkeeping.
+  static constexpr size_t kMaxConfiguredSize = size_t{32} << 10;
+
   // Returns the size of the next string block based on the size information
-  // stored in `block`. `block` may be null in which case the size of the
-  // initial string block is returned.
-  static size_t NextSize(StringBlock* block);
+  // stored in `block`. `block` may be null in which case `first_size`
+  // (clamped to the supported range) is returned.
+  static size_t NextSize(StringBlock* block, size_t first_size = min_size());
 
   // Allocates a new StringBlock pointing to `next`, which can be null.
-  // The size of the returned block depends on the allocated size of `next`.
-  static StringBlock* New(StringBlock* next);
+  // The size of the returned block depends on the allocated size of `next`;
+  // the first block is sized `first_size` and growth is capped at
+  // `max_size_cap`, both clamped to the supported range.
+  static StringBlock* New(StringBlock* next, size_t first_size = min_size(),
+                          size_t max_size_cap = max_size());
 
   // Allocates a new string block `in place`. `n` must be the value returned
-  // from a previous call to `StringBlock::NextSize(next)`
-  static StringBlock* Emplace(void* p, size_t n, StringBlock* next);
+  // from a previous call to `StringBlock::NextSize(next, first_size)`
+  static StringBlock* Emplace(void* p, size_t n, StringBlock* next,
+                              size_t first_size = min_size(),
+                              size_t max_size_cap = max_size());
 
   // Deletes `block` if `block` is heap allocated. `block` must not be null.
   // Returns the allocated size of `block`, or 0 if the block was emplaced.
@@ -99,6 +108,12 @@ class alignas(std::string) StringBlock {
   static constexpr size_type min_size() { return size_type{256}; }
   static constexpr size_type max_size() { return size_type{8192}; }
 
+  // Returns `size` clamped to [min_size(), kMaxConfiguredSize].
+  static size_type ClampedSize(size_t size) {
+    return static_cast<size_type>(std::min<size_t>(
+        std::max<size_t>(size, min_size()), kMaxConfiguredSize));
+  }
+
   // Returns `size` rounded down such that we can fit a perfect number
   // of std::string instances inside a StringBlock of that size.
   static constexpr size_type RoundedSize(size_type size);
@@ -116,27 +131,34 @@ constexpr StringBlock::size_type StringBlock::RoundedSize(size_type size) {
   return size - (size - sizeof(StringBlock)) % sizeof(std::string);
 }
 
-inline size_t StringBlock::NextSize(StringBlock* block) {
-  return block ? block->next_size() : min_size();
+inline size_t StringBlock::NextSize(StringBlock* block, size_t first_size) {
+  return block ? block->next_size() : ClampedSize(first_size);
 }
 
-inline StringBlock* StringBlock::Emplace(void* p, size_t n, StringBlock* next) {
+inline StringBlock* StringBlock::Emplace(void* p, size_t n, StringBlock* next,
+                                         size_t first_size,
+                                         size_t max_size_cap) {
   const auto count = static_cast<size_type>(n);
-  ABSL_DCHECK_EQ(count, NextSize(next));
-  size_type doubled = count * 2;
-  size_type next_size = next ? std::min(doubled, max_size()) : min_size();
+  ABSL_DCHECK_EQ(count, NextSize(next, first_size));
+  size_t doubled = size_t{count} * 2;
+  size_type next_size =
+      next ? static_cast<size_type>(
+                 std::min<size_t>(doubled, ClampedSize(max_size_cap)))
+           : ClampedSize(first_size);
   return new (p) StringBlock(next, false, RoundedSize(count), next_size);
 }
 
-inline StringBlock* StringBlock::New(StringBlock* next) {
+inline StringBlock* StringBlock::New(StringBlock* next, size_t first_size,
+                                     size_t max_size_cap) {
   // Compute required size, rounding down to a multiple of sizeof(std:string)
   // so that we can optimize the allocation path. I.e., we incur a (constant
   // size) MOD() operation cost here to avoid any MUL() later on.
-  size_type size = min_size();
-  size_type next_size = min_size();
+  size_type size = ClampedSize(first_size);
+  size_type next_size = size;
   if (next) {
     size = next->next_size_;
-    next_size = std::min<size_type>(size * 2, max_size());
+    next_size = static_cast<size_type>(
+        std::min<size_t>(size_t{size} * 2, ClampedSize(max_size_cap)));
   }
   size = RoundedSize(size);
   void* p = ::operator new(size);
@@ -146,6 +146,39 @@ TEST(StringBlockTest, EmplaceMultipleBlocks) {
   }
 }
 
+TEST(StringBlockTest, ConfiguredSizes) {
+  // The first block honors the configured first size, the second matches it,
+  // and growth doubles up to the configured cap.
+  StringBlock* block = StringBlock::New(nullptr, /*first_size=*/1024,
+                                        /*max_size_cap=*/16384);
+  ASSERT_THAT(block->allocated_size(), Eq(AllocatedSizeFor(1024)));
+
+  for (int size : {1024, 2048, 4096, 8192, 16384, 16384}) {
+    block = StringBlock::New(block, 1024, 16384);
+    ASSERT_THAT(block, Ne(nullptr));
+    ASSERT_TRUE(block->heap_allocated());
+    ASSERT_THAT(block->allocated_size(), Eq(AllocatedSizeFor(size)));
+  }
+
+  while (block) {
+    StringBlock* next = block->next();
+    StringBlock::Delete(block);
+    block = next;
+  }
+}
+
+TEST(StringBlockTest, ConfiguredSizesAreClamped) {
+  // Sizes below the minimum and above the supported maximum are clamped.
+  StringBlock* small = StringBlock::New(nullptr, /*first_size=*/1);
+  EXPECT_THAT(small->allocated_size(), Eq(AllocatedSizeFor(256)));
+  StringBlock::Delete(small);
+
+  StringBlock* large = StringBlock::New(nullptr, /*first_size=*/1 << 20);
+  EXPECT_THAT(large->allocated_size(),
+              Eq(AllocatedSizeFor(StringBlock::kMaxConfiguredSize)));
+  StringBlock::Delete(large);
+}
+
 }  // namespace
 }  // namespace internal
 }  // namespace protobuf
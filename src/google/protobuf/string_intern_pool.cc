@@ -0,0 +1,65 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/string_intern_pool.h"
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+
+#include "absl/hash/hash.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+
+StringInternPool* StringInternPool::Global() {
+  // Leaked: interned data must stay valid until process exit.
+  static auto* pool = new StringInternPool();
+  return pool;
+}
+
+StringInternPool::Shard& StringInternPool::ShardFor(absl::string_view value) {
+  return shards_[absl::HashOf(value) % kShards];
+}
+
+absl::string_view StringInternPool::Intern(absl::string_view value) {
+  Shard& shard = ShardFor(value);
+  {
+    absl::ReaderMutexLock lock(&shard.mu);
+    auto it = shard.values.find(value);
+    if (it != shard.values.end()) return *it;
+  }
+  absl::WriterMutexLock lock(&shard.mu);
+  // Another thread may have interned the value while the lock was dropped.
+  auto it = shard.values.find(value);
+  if (it != shard.values.end()) return *it;
+  char* copy = static_cast<char*>(::operator new(value.size()));
+  if (!value.empty()) memcpy(copy, value.data(), value.size());
+  shard.bytes += value.size();
+  return *shard.values.insert(absl::string_view(copy, value.size())).first;
+}
+
+size_t StringInternPool::SpaceUsed() const {
+  size_t total = 0;
+  for (const Shard& shard : shards_) {
+    absl::ReaderMutexLock lock(&shard.mu);
+    total += shard.bytes;
+  }
+  return total;
+}
+
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
@@ -0,0 +1,76 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef GOOGLE_PROTOBUF_STRING_INTERN_POOL_H__
+#define GOOGLE_PROTOBUF_STRING_INTERN_POOL_H__
+
+#include <cstddef>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+
+// A process-wide pool of immutable, deduplicated strings.
+//
+// Workloads that carry the same few thousand label values (host names,
+// metric names, ...) across billions of messages can intern them once and
+// share the bytes: Intern() returns a view whose data() is stable for the
+// lifetime of the process and identical for equal inputs, so each distinct
+// value is stored once and equality checks on interned views collapse to a
+// pointer comparison.
+//
+// Entries are never freed.  The pool is meant for a bounded vocabulary, and
+// leaking entries by design is what makes the returned views safe to cache
+// anywhere without reference counting.
+//
+// The table is sharded; lookups of already-interned values take a shared
+// per-shard lock, so read-mostly use scales across threads.
+class PROTOBUF_EXPORT StringInternPool {
+ public:
+  StringInternPool() = default;
+  StringInternPool(const StringInternPool&) = delete;
+  StringInternPool& operator=(const StringInternPool&) = delete;
+
+  // The process-wide pool.
+  static StringInternPool* Global();
+
+  // Returns a view equal to `value`, backed by the pool.  Views returned
+  // for equal inputs share the same data() pointer.
+  absl::string_view Intern(absl::string_view value);
+
+  // Total bytes of interned string data, for monitoring pool growth.
+  size_t SpaceUsed() const;
+
+ private:
+  struct Shard {
+    mutable absl::Mutex mu;
+    absl::flat_hash_set<absl::string_view> values ABSL_GUARDED_BY(mu);
+    size_t bytes ABSL_GUARDED_BY(mu) = 0;
+  };
+
+  static constexpr size_t kShards = 64;
+
+  Shard& ShardFor(absl::string_view value);
+
+  Shard shards_[kShards];
+};
+
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_STRING_INTERN_POOL_H__
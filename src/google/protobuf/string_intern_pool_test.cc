@@ -0,0 +1,90 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/string_intern_pool.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+namespace {
+
+TEST(StringInternPoolTest, EqualValuesShareStorage) {
+  StringInternPool pool;
+  absl::string_view a = pool.Intern("cell-aa.hostname-123");
+  std::string separate_backing = absl::StrCat("cell-aa.", "hostname-123");
+  absl::string_view b = pool.Intern(separate_backing);
+  EXPECT_EQ(a, "cell-aa.hostname-123");
+  EXPECT_EQ(a.data(), b.data());
+}
+
+TEST(StringInternPoolTest, DistinctValuesDoNotShareStorage) {
+  StringInternPool pool;
+  absl::string_view a = pool.Intern("metric/a");
+  absl::string_view b = pool.Intern("metric/b");
+  EXPECT_NE(a, b);
+  EXPECT_NE(a.data(), b.data());
+}
+
+TEST(StringInternPoolTest, EmptyString) {
+  StringInternPool pool;
+  absl::string_view a = pool.Intern("");
+  absl::string_view b = pool.Intern(std::string());
+  EXPECT_TRUE(a.empty());
+  EXPECT_EQ(a.data(), b.data());
+}
+
+TEST(StringInternPoolTest, SpaceUsedCountsDistinctValuesOnce) {
+  StringInternPool pool;
+  EXPECT_EQ(pool.SpaceUsed(), 0);
+  pool.Intern("12345");
+  pool.Intern("12345");
+  EXPECT_EQ(pool.SpaceUsed(), 5);
+  pool.Intern("123");
+  EXPECT_EQ(pool.SpaceUsed(), 8);
+}
+
+TEST(StringInternPoolTest, ConcurrentInternIsDeterministic) {
+  StringInternPool pool;
+  constexpr int kThreads = 8;
+  constexpr int kValues = 1000;
+  std::vector<std::vector<absl::string_view>> results(kThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&pool, &results, t] {
+      results[t].reserve(kValues);
+      for (int i = 0; i < kValues; ++i) {
+        results[t].push_back(pool.Intern(absl::StrCat("value-", i)));
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  for (int t = 1; t < kThreads; ++t) {
+    for (int i = 0; i < kValues; ++i) {
+      EXPECT_EQ(results[0][i].data(), results[t][i].data());
+    }
+  }
+}
+
+TEST(StringInternPoolTest, GlobalPoolIsSingleton) {
+  EXPECT_EQ(StringInternPool::Global(), StringInternPool::Global());
+  absl::string_view a = StringInternPool::Global()->Intern("global-label");
+  absl::string_view b = StringInternPool::Global()->Intern("global-label");
+  EXPECT_EQ(a.data(), b.data());
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
@@ -99,6 +99,49 @@ TEST(StringViewFieldTest, SingularSetByStringMove) {
   VerifySingularStringSet(message, std::move(value), STRING_PAYLOAD);
 }
 
+TEST(StringViewFieldTest, SingularViewWithDefault) {
+  TestStringView message;
+
+  EXPECT_FALSE(message.has_singular_with_default());
+
+  auto singular_with_default = message.singular_with_default();
+  static_assert(
+      std::is_same<decltype(singular_with_default), absl::string_view>::value,
+      "unexpected type");
+  EXPECT_THAT(singular_with_default, StrEq("default value"));
+
+  message.set_singular_with_default(STRING_PAYLOAD);
+  EXPECT_TRUE(message.has_singular_with_default());
+  EXPECT_THAT(message.singular_with_default(), StrEq(STRING_PAYLOAD));
+
+  message.clear_singular_with_default();
+  EXPECT_FALSE(message.has_singular_with_default());
+  EXPECT_THAT(message.singular_with_default(), StrEq("default value"));
+}
+
+TEST(StringViewFieldTest, OneofViewGetterAndSetter) {
+  TestStringView message;
+
+  EXPECT_EQ(message.string_oneof_case(), TestStringView::STRING_ONEOF_NOT_SET);
+  EXPECT_EQ(message.oneof_string().size(), 0);
+
+  message.set_oneof_string(STRING_PAYLOAD);
+  EXPECT_EQ(message.string_oneof_case(), TestStringView::kOneofString);
+
+  auto oneof_string = message.oneof_string();
+  static_assert(std::is_same<decltype(oneof_string), absl::string_view>::value,
+                "unexpected type");
+  EXPECT_THAT(oneof_string, StrEq(STRING_PAYLOAD));
+
+  message.set_oneof_bytes("012345");
+  EXPECT_EQ(message.string_oneof_case(), TestStringView::kOneofBytes);
+  EXPECT_THAT(message.oneof_bytes(), StrEq("012345"));
+  EXPECT_EQ(message.oneof_string().size(), 0);
+
+  message.clear_string_oneof();
+  EXPECT_EQ(message.string_oneof_case(), TestStringView::STRING_ONEOF_NOT_SET);
+}
+
 TEST(StringViewFieldTest, SingularSetAndGetByReflection) {
   TestStringView message;
 
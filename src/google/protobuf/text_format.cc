@@ -336,9 +336,9 @@ class TextFormat::Parser::ParserImpl {
              SingularOverwritePolicy singular_overwrite_policy,
              bool allow_case_insensitive_field, bool allow_unknown_field,
              bool allow_unknown_extension, bool allow_unknown_enum,
-             bool allow_field_number, bool allow_relaxed_whitespace,
-             bool allow_partial, int recursion_limit,
-             UnsetFieldsMetadata* no_op_fields)
+             bool allow_field_number, bool expect_canonical_input,
+             bool allow_relaxed_whitespace, bool allow_partial,
+             int recursion_limit, UnsetFieldsMetadata* no_op_fields)
       : error_collector_(error_collector),
         finder_(finder),
         parse_info_tree_(parse_info_tree),
@@ -351,6 +351,7 @@ class TextFormat::Parser::ParserImpl {
         allow_unknown_extension_(allow_unknown_extension),
         allow_unknown_enum_(allow_unknown_enum),
         allow_field_number_(allow_field_number),
+        expect_canonical_input_(expect_canonical_input),
         allow_partial_(allow_partial),
         initial_recursion_limit_(recursion_limit),
         recursion_limit_(recursion_limit),
@@ -382,6 +383,7 @@ class TextFormat::Parser::ParserImpl {
   // ABSL_LOG(ERROR)).
   bool Parse(Message* output) {
     // Consume fields until we cannot do so anymore.
+    int field_index_hint = 0;
     while (true) {
       if (LookingAtType(io::Tokenizer::TYPE_END)) {
         // Ensures recursion limit properly unwinded, but only for success
@@ -396,7 +398,7 @@ class TextFormat::Parser::ParserImpl {
         return !had_errors_;
       }
 
-      DO(ConsumeField(output));
+      DO(ConsumeField(output, &field_index_hint));
     }
   }
 
@@ -468,8 +470,9 @@ class TextFormat::Parser::ParserImpl {
   // This method checks to see that the end delimiter at the conclusion of
   // the consumption matches the starting delimiter passed in here.
   bool ConsumeMessage(Message* message, const std::string delimiter) {
+    int field_index_hint = 0;
     while (!LookingAt(">") && !LookingAt("}")) {
-      DO(ConsumeField(message));
+      DO(ConsumeField(message, &field_index_hint));
     }
 
     // Confirm that we have a valid ending delimiter.
@@ -491,7 +494,7 @@ class TextFormat::Parser::ParserImpl {
 
   // Consumes the current field (as returned by the tokenizer) on the
   // passed in message.
-  bool ConsumeField(Message* message) {
+  bool ConsumeField(Message* message, int* field_index_hint = nullptr) {
     const Reflection* reflection = message->GetReflection();
     const Descriptor* descriptor = message->GetDescriptor();
 
@@ -583,7 +586,26 @@ class TextFormat::Parser::ParserImpl {
           field = descriptor->FindFieldByNumber(field_number);
         }
       } else {
-        field = descriptor->FindFieldByName(field_name);
+        if (expect_canonical_input_ && field_index_hint != nullptr) {
+          // Canonical printers emit fields in declaration order, so the next
+          // field is either the previously matched one again (repeated
+          // values) or a later one.  Scan forward from the hint before
+          // consulting the name map; deviating input simply misses here and
+          // takes the general lookup below.
+          for (int i = *field_index_hint; i < descriptor->field_count(); ++i) {
+            if (descriptor->field(i)->name() == field_name) {
+              field = descriptor->field(i);
+              *field_index_hint = i;
+              break;
+            }
+          }
+        }
+        if (field == nullptr) {
+          field = descriptor->FindFieldByName(field_name);
+          if (field != nullptr && field_index_hint != nullptr) {
+            *field_index_hint = field->index();
+          }
+        }
         // Group-like delimited fields will accept both the capitalized type
         // names as well.
         if (field == nullptr) {
@@ -1428,6 +1450,7 @@ class TextFormat::Parser::ParserImpl {
   const bool allow_unknown_extension_;
   const bool allow_unknown_enum_;
   const bool allow_field_number_;
+  const bool expect_canonical_input_;
   const bool allow_partial_;
   const int initial_recursion_limit_;
   int recursion_limit_;
@@ -1452,7 +1475,9 @@ class TextFormat::Printer::TextGenerator
         failed_(false),
         insert_silent_marker_(false),
         indent_level_(initial_indent_level),
-        initial_indent_level_(initial_indent_level) {}
+        initial_indent_level_(initial_indent_level),
+        bytes_written_(0),
+        max_output_bytes_(0) {}
 
   explicit TextGenerator(io::ZeroCopyOutputStream* output,
                          bool insert_silent_marker, int initial_indent_level)
@@ -1463,7 +1488,9 @@ class TextFormat::Printer::TextGenerator
         failed_(false),
         insert_silent_marker_(insert_silent_marker),
         indent_level_(initial_indent_level),
-        initial_indent_level_(initial_indent_level) {}
+        initial_indent_level_(initial_indent_level),
+        bytes_written_(0),
+        max_output_bytes_(0) {}
 
   TextGenerator(const TextGenerator&) = delete;
   TextGenerator& operator=(const TextGenerator&) = delete;
@@ -1526,6 +1553,18 @@ class TextFormat::Printer::TextGenerator
   // error.)
   bool failed() const { return failed_; }
 
+  // If non-zero, LimitReached() starts returning true once this many bytes
+  // have been written.  The printer checks it at field boundaries, so output
+  // in flight (including closing brackets of enclosing messages) is still
+  // written and the result stays well-formed.
+  void SetMaxOutputBytes(int64_t max_output_bytes) {
+    max_output_bytes_ = max_output_bytes;
+  }
+
+  bool LimitReached() const override {
+    return max_output_bytes_ > 0 && bytes_written_ >= max_output_bytes_;
+  }
+
   void PrintMaybeWithMarker(MarkerToken, absl::string_view text) override {
     Print(text.data(), text.size());
     if (ConsumeInsertSilentMarker()) {
@@ -1546,6 +1585,7 @@ class TextFormat::Printer::TextGenerator
   void Write(const char* data, size_t size) {
     if (failed_) return;
     if (size == 0) return;
+    bytes_written_ += size;
 
     if (at_start_of_line_) {
       // Insert an indent.
@@ -1580,6 +1620,7 @@ class TextFormat::Printer::TextGenerator
     }
     ABSL_DCHECK(!failed_);
     int size = GetCurrentIndentationSize();
+    bytes_written_ += size;
 
     while (size > buffer_size_) {
       // Data exceeds space in the buffer. Write what we can and request a new
@@ -1622,6 +1663,11 @@ class TextFormat::Printer::TextGenerator
 
   int indent_level_;
   int initial_indent_level_;
+
+  // Total bytes delivered to the underlying stream, counted against
+  // max_output_bytes_ when the latter is non-zero.
+  int64_t bytes_written_;
+  int64_t max_output_bytes_;
 };
 
 // ===========================================================================
@@ -1781,6 +1827,7 @@ TextFormat::Parser::Parser()
       allow_unknown_extension_(false),
       allow_unknown_enum_(false),
       allow_field_number_(false),
+      expect_canonical_input_(false),
       allow_relaxed_whitespace_(false),
       allow_singular_overwrites_(false),
       recursion_limit_(std::numeric_limits<int>::max()) {}
@@ -1816,8 +1863,9 @@ bool TextFormat::Parser::Parse(io::ZeroCopyInputStream* input,
                     parse_info_tree_, overwrites_policy,
                     allow_case_insensitive_field_, allow_unknown_field_,
                     allow_unknown_extension_, allow_unknown_enum_,
-                    allow_field_number_, allow_relaxed_whitespace_,
-                    allow_partial_, recursion_limit_, no_op_fields_);
+                    allow_field_number_, expect_canonical_input_,
+                    allow_relaxed_whitespace_, allow_partial_,
+                    recursion_limit_, no_op_fields_);
   return MergeUsingImpl(input, output, &parser);
 }
 
@@ -1841,8 +1889,9 @@ bool TextFormat::Parser::Merge(io::ZeroCopyInputStream* input,
                     parse_info_tree_, ParserImpl::ALLOW_SINGULAR_OVERWRITES,
                     allow_case_insensitive_field_, allow_unknown_field_,
                     allow_unknown_extension_, allow_unknown_enum_,
-                    allow_field_number_, allow_relaxed_whitespace_,
-                    allow_partial_, recursion_limit_, no_op_fields_);
+                    allow_field_number_, expect_canonical_input_,
+                    allow_relaxed_whitespace_, allow_partial_,
+                    recursion_limit_, no_op_fields_);
   return MergeUsingImpl(input, output, &parser);
 }
 
@@ -1877,8 +1926,9 @@ bool TextFormat::Parser::ParseFieldValueFromString(absl::string_view input,
                     ParserImpl::ALLOW_SINGULAR_OVERWRITES,
                     allow_case_insensitive_field_, allow_unknown_field_,
                     allow_unknown_extension_, allow_unknown_enum_,
-                    allow_field_number_, allow_relaxed_whitespace_,
-                    allow_partial_, recursion_limit_, no_op_fields_);
+                    allow_field_number_, expect_canonical_input_,
+                    allow_relaxed_whitespace_, allow_partial_,
+                    recursion_limit_, no_op_fields_);
   return parser.ParseField(field, output);
 }
 
@@ -2189,6 +2239,8 @@ TextFormat::Printer::Printer()
       print_message_fields_in_index_order_(false),
       expand_any_(false),
       truncate_string_field_longer_than_(0LL),
+      max_output_bytes_(0LL),
+      skip_message_fields_larger_than_(0LL),
       finder_(nullptr) {
   SetUseUtf8StringEscaping(false);
 }
@@ -2282,7 +2334,7 @@ bool TextFormat::Printer::Print(const Message& message,
                                 io::ZeroCopyOutputStream* output,
                                 internal::FieldReporterLevel reporter) const {
   TextGenerator generator(output, insert_silent_marker_, initial_indent_level_);
-
+  generator.SetMaxOutputBytes(max_output_bytes_);
 
   Print(message, &generator);
 
@@ -2421,6 +2473,9 @@ void TextFormat::Printer::PrintMessage(const Message& message,
     std::sort(fields.begin(), fields.end(), FieldIndexSorter());
   }
   for (const FieldDescriptor* field : fields) {
+    if (generator->LimitReached()) {
+      return;
+    }
     PrintField(message, reflection, field, generator);
   }
   if (!hide_unknown_fields_) {
@@ -2646,8 +2701,24 @@ void TextFormat::Printer::PrintField(const Message& message,
   }
 
   for (int j = 0; j < count; ++j) {
+    if (generator->LimitReached()) {
+      break;
+    }
     const int field_index = field->is_repeated() ? j : -1;
 
+    if (skip_message_fields_larger_than_ > 0 &&
+        field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+      const Message& sub_message =
+          field->is_repeated()
+              ? (is_map ? *sorted_map_field[j]
+                        : reflection->GetRepeatedMessage(message, field, j))
+              : reflection->GetMessage(message, field);
+      if (sub_message.ByteSizeLong() >
+          static_cast<size_t>(skip_message_fields_larger_than_)) {
+        continue;
+      }
+    }
+
     PrintFieldName(message, field_index, count, reflection, field, generator);
 
     if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
@@ -2856,6 +2927,9 @@ void TextFormat::Printer::PrintUnknownFields(
     const UnknownFieldSet& unknown_fields, BaseTextGenerator* generator,
     int recursion_budget) const {
   for (int i = 0; i < unknown_fields.field_count(); i++) {
+    if (generator->LimitReached()) {
+      return;
+    }
     const UnknownField& field = unknown_fields.field(i);
 
     switch (field.type()) {
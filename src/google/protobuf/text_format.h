@@ -158,6 +158,11 @@ class PROTOBUF_EXPORT TextFormat {
     // Returns the current indentation size in characters.
     virtual size_t GetCurrentIndentationSize() const { return 0; }
 
+    // Returns true once a printer-imposed output limit has been reached.
+    // Printers consult this to stop walking the message early; generators
+    // without limits always return false.
+    virtual bool LimitReached() const { return false; }
+
     // Print text to the output stream.
     virtual void Print(const char* text, size_t size) = 0;
 
@@ -414,6 +419,32 @@ class PROTOBUF_EXPORT TextFormat {
       truncate_string_field_longer_than_ = truncate_string_field_longer_than;
     }
 
+    // If non-zero, stops printing once roughly this many bytes of output
+    // have been produced; the remaining fields and subtrees are not visited
+    // at all.  The limit is checked at field boundaries, so the output stays
+    // well-formed and may overshoot by one field value.  This bounds the
+    // cost of logging a preview of a very large message.
+    //
+    // NOTE:  Setting a non-zero value breaks round-trip safe
+    // property of TextFormat::Printer.  That is, from the printed message, we
+    // cannot recover the omitted fields any more.
+    void SetMaxOutputBytes(const int64_t max_output_bytes) {
+      max_output_bytes_ = max_output_bytes;
+    }
+
+    // If non-zero, message-typed field values (singular and repeated elements
+    // alike) whose serialized size exceeds this many bytes are skipped
+    // entirely: nothing is printed for them and their subtrees are never
+    // visited.
+    //
+    // NOTE:  Setting a non-zero value breaks round-trip safe
+    // property of TextFormat::Printer.  That is, from the printed message, we
+    // cannot recover the skipped fields any more.
+    void SetSkipMessageFieldsLargerThan(
+        const int64_t skip_message_fields_larger_than) {
+      skip_message_fields_larger_than_ = skip_message_fields_larger_than;
+    }
+
     // Sets whether sensitive fields found in the message will be reported or
     // not.
     void SetReportSensitiveFields(internal::FieldReporterLevel reporter) {
@@ -548,6 +579,8 @@ class PROTOBUF_EXPORT TextFormat {
     bool print_message_fields_in_index_order_;
     bool expand_any_;
     int64_t truncate_string_field_longer_than_;
+    int64_t max_output_bytes_;
+    int64_t skip_message_fields_larger_than_;
 
     std::unique_ptr<const FastFieldValuePrinter> default_field_value_printer_;
     absl::flat_hash_map<const FieldDescriptor*,
@@ -732,6 +765,16 @@ class PROTOBUF_EXPORT TextFormat {
 
     void AllowFieldNumber(bool allow) { allow_field_number_ = allow; }
 
+    // Declares that the input is expected to be canonical, i.e. produced by
+    // a printer that emits fields in declaration order (as TextFormat's own
+    // printers do).  Field names are then resolved by scanning forward from
+    // the previously matched field instead of through the name map, which is
+    // substantially faster for machine-generated input.  Input that deviates
+    // from declaration order still parses correctly through the general
+    // lookup, just without the speedup.
+    // This is 'false' by default.
+    void ExpectCanonicalInput(bool expect) { expect_canonical_input_ = expect; }
+
     // Sets maximum recursion depth which parser can use. This is effectively
     // the maximum allowed nesting of proto messages.
     void SetRecursionLimit(int limit) { recursion_limit_ = limit; }
@@ -791,6 +834,7 @@ class PROTOBUF_EXPORT TextFormat {
     bool allow_unknown_extension_;
     bool allow_unknown_enum_;
     bool allow_field_number_;
+    bool expect_canonical_input_;
     bool allow_relaxed_whitespace_;
     bool allow_singular_overwrites_;
     int recursion_limit_;
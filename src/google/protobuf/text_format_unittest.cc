@@ -603,6 +603,73 @@ TEST_F(TextFormatTest, PrintBufferTooSmall) {
   EXPECT_EQ(output_stream.ByteCount(), 1);
 }
 
+TEST_F(TextFormatTest, PrintWithMaxOutputBytes) {
+  // Fields past the output byte budget are omitted.
+
+  protobuf_unittest::TestAllTypes message;
+
+  message.add_repeated_string("abc");
+  message.add_repeated_string("def");
+  message.add_repeated_string("ghi");
+
+  std::string text;
+  TextFormat::Printer printer;
+  printer.SetMaxOutputBytes(30);
+  EXPECT_TRUE(printer.PrintToString(message, &text));
+  EXPECT_EQ(
+      "repeated_string: \"abc\"\n"
+      "repeated_string: \"def\"\n",
+      text);
+}
+
+TEST_F(TextFormatTest, PrintWithMaxOutputBytesStaysWellFormed) {
+  // When the budget runs out inside a nested message, the closing bracket is
+  // still emitted.
+
+  protobuf_unittest::NestedTestAllTypes message;
+  protobuf_unittest::TestAllTypes* payload = message.mutable_payload();
+  payload->add_repeated_string("abc");
+  payload->add_repeated_string("def");
+  payload->add_repeated_string("ghi");
+
+  std::string text;
+  TextFormat::Printer printer;
+  printer.SetMaxOutputBytes(40);
+  EXPECT_TRUE(printer.PrintToString(message, &text));
+  EXPECT_EQ(
+      "payload {\n"
+      "  repeated_string: \"abc\"\n"
+      "  repeated_string: \"def\"\n"
+      "}\n",
+      text);
+}
+
+TEST_F(TextFormatTest, PrintWithSkipMessageFieldsLargerThan) {
+  // Message-typed values over the threshold are skipped without being
+  // visited; scalar fields and small messages are unaffected.
+
+  protobuf_unittest::TestAllTypes message;
+  message.set_optional_int32(42);
+  message.mutable_optional_nested_message()->set_bb(123);
+  message.add_repeated_nested_message()->set_bb(1);
+  // Serializes to more than four bytes, so this element is skipped below.
+  message.add_repeated_nested_message()->set_bb(123456789);
+
+  std::string text;
+  TextFormat::Printer printer;
+  printer.SetSkipMessageFieldsLargerThan(4);
+  EXPECT_TRUE(printer.PrintToString(message, &text));
+  EXPECT_EQ(
+      "optional_int32: 42\n"
+      "optional_nested_message {\n"
+      "  bb: 123\n"
+      "}\n"
+      "repeated_nested_message {\n"
+      "  bb: 1\n"
+      "}\n",
+      text);
+}
+
 // A printer that appends 'u' to all unsigned int32.
 class CustomUInt32FieldValuePrinter : public TextFormat::FieldValuePrinter {
  public:
@@ -968,6 +1035,32 @@ TEST_F(TextFormatTest, ParseBasic) {
   TestUtil::ExpectAllFieldsSet(proto_);
 }
 
+TEST_F(TextFormatTest, ParseCanonicalInput) {
+  // The golden text is printer output, so it is in declaration order and
+  // eligible for the sequential field lookup.
+  TextFormat::Parser parser;
+  parser.ExpectCanonicalInput(true);
+  EXPECT_TRUE(parser.ParseFromString(proto_text_format_, &proto_));
+  TestUtil::ExpectAllFieldsSet(proto_);
+}
+
+TEST_F(TextFormatTest, ParseCanonicalInputToleratesDeviation) {
+  // Fields out of declaration order fall back to the general lookup and
+  // still parse correctly.
+  TextFormat::Parser parser;
+  parser.ExpectCanonicalInput(true);
+  EXPECT_TRUE(parser.ParseFromString(
+      "optional_string: \"b\" optional_int32 : 1 optional_string: \"a\" "
+      "repeated_int32: 2 optional_int64: 3 repeated_int32: 4",
+      &proto_));
+  EXPECT_EQ("a", proto_.optional_string());
+  EXPECT_EQ(1, proto_.optional_int32());
+  EXPECT_EQ(3, proto_.optional_int64());
+  ASSERT_EQ(2, proto_.repeated_int32_size());
+  EXPECT_EQ(2, proto_.repeated_int32(0));
+  EXPECT_EQ(4, proto_.repeated_int32(1));
+}
+
 TEST_F(TextFormatTest, ParseCordBasic) {
   absl::Cord cord(proto_text_format_);
   TextFormat::ParseFromCord(cord, &proto_);
@@ -14,6 +14,7 @@
 #include "absl/log/absl_check.h"
 #include "absl/strings/cord.h"
 #include "absl/strings/internal/resize_uninitialized.h"
+#include "google/protobuf/arena.h"
 #include "google/protobuf/extension_set.h"
 #include "google/protobuf/generated_message_tctable_decl.h"
 #include "google/protobuf/generated_message_tctable_impl.h"
@@ -39,10 +40,14 @@ const UnknownFieldSet& UnknownFieldSet::default_instance() {
 
 void UnknownFieldSet::ClearFallback() {
   ABSL_DCHECK(!fields_.empty());
-  int n = fields_.size();
-  do {
-    (fields_)[--n].Delete();
-  } while (n > 0);
+  if (arena_ == nullptr) {
+    int n = fields_.size();
+    do {
+      (fields_)[--n].Delete();
+    } while (n > 0);
+  }
+  // On an arena the payloads are owned by the arena, which will run their
+  // destructors when it is destroyed.
   fields_.clear();
 }
 
@@ -52,7 +57,7 @@ void UnknownFieldSet::InternalMergeFrom(const UnknownFieldSet& other) {
     fields_.reserve(fields_.size() + other_field_count);
     for (int i = 0; i < other_field_count; i++) {
       fields_.push_back((other.fields_)[i]);
-      fields_.back().DeepCopy((other.fields_)[i]);
+      fields_.back().DeepCopy((other.fields_)[i], arena_);
     }
   }
 }
@@ -63,7 +68,7 @@ void UnknownFieldSet::MergeFrom(const UnknownFieldSet& other) {
     fields_.reserve(fields_.size() + other_field_count);
     for (int i = 0; i < other_field_count; i++) {
       fields_.push_back((other.fields_)[i]);
-      fields_.back().DeepCopy((other.fields_)[i]);
+      fields_.back().DeepCopy((other.fields_)[i], arena_);
     }
   }
 }
@@ -71,6 +76,12 @@ void UnknownFieldSet::MergeFrom(const UnknownFieldSet& other) {
 // A specialized MergeFrom for performance when we are merging from an UFS that
 // is temporary and can be destroyed in the process.
 void UnknownFieldSet::MergeFromAndDestroy(UnknownFieldSet* other) {
+  if (arena_ != other->arena_) {
+    // Payloads cannot change owners across arenas; fall back to copying.
+    MergeFrom(*other);
+    other->Clear();
+    return;
+  }
   if (fields_.empty()) {
     fields_ = std::move(other->fields_);
   } else {
@@ -141,7 +152,8 @@ std::string* UnknownFieldSet::AddLengthDelimited(int number) {
   auto& field = fields_.back();
   field.number_ = number;
   field.SetType(UnknownField::TYPE_LENGTH_DELIMITED);
-  field.data_.length_delimited_.string_value = new std::string;
+  field.data_.length_delimited_.string_value =
+      Arena::Create<std::string>(arena_);
   return field.data_.length_delimited_.string_value;
 }
 
@@ -151,19 +163,21 @@ UnknownFieldSet* UnknownFieldSet::AddGroup(int number) {
   auto& field = fields_.back();
   field.number_ = number;
   field.SetType(UnknownField::TYPE_GROUP);
-  field.data_.group_ = new UnknownFieldSet;
+  field.data_.group_ = Arena::Create<UnknownFieldSet>(arena_, arena_);
   return field.data_.group_;
 }
 
 void UnknownFieldSet::AddField(const UnknownField& field) {
   fields_.push_back(field);
-  fields_.back().DeepCopy(field);
+  fields_.back().DeepCopy(field, arena_);
 }
 
 void UnknownFieldSet::DeleteSubrange(int start, int num) {
   // Delete the specified fields.
-  for (int i = 0; i < num; ++i) {
-    (fields_)[i + start].Delete();
+  if (arena_ == nullptr) {
+    for (int i = 0; i < num; ++i) {
+      (fields_)[i + start].Delete();
+    }
   }
   // Slide down the remaining fields.
   for (size_t i = start + num; i < fields_.size(); ++i) {
@@ -180,7 +194,7 @@ void UnknownFieldSet::DeleteByNumber(int number) {
   for (size_t i = 0; i < fields_.size(); ++i) {
     UnknownField* field = &(fields_)[i];
     if (field->number() == number) {
-      field->Delete();
+      if (arena_ == nullptr) field->Delete();
     } else {
       if (i != left) {
         (fields_)[left] = (fields_)[i];
@@ -191,8 +205,19 @@ void UnknownFieldSet::DeleteByNumber(int number) {
   fields_.resize(left);
 }
 
+void UnknownFieldSet::SwapSlow(UnknownFieldSet* x) {
+  // The sets live on different arenas, so the payloads cannot simply change
+  // owners; exchange deep copies instead.
+  UnknownFieldSet copy(arena_);
+  copy.InternalMergeFrom(*x);
+  x->Clear();
+  x->MergeFrom(*this);
+  Clear();
+  MergeFromAndDestroy(&copy);
+}
+
 bool UnknownFieldSet::MergeFromCodedStream(io::CodedInputStream* input) {
-  UnknownFieldSet other;
+  UnknownFieldSet other(arena_);
   if (internal::WireFormat::SkipMessage(input, &other) &&
       input->ConsumedEntireMessage()) {
     MergeFromAndDestroy(&other);
@@ -258,15 +283,15 @@ void UnknownField::Delete() {
   }
 }
 
-void UnknownField::DeepCopy(const UnknownField& other) {
+void UnknownField::DeepCopy(const UnknownField& other, Arena* arena) {
   (void)other;  // Parameter is used by Google-internal code.
   switch (type()) {
     case UnknownField::TYPE_LENGTH_DELIMITED:
-      data_.length_delimited_.string_value =
-          new std::string(*data_.length_delimited_.string_value);
+      data_.length_delimited_.string_value = Arena::Create<std::string>(
+          arena, *data_.length_delimited_.string_value);
       break;
     case UnknownField::TYPE_GROUP: {
-      UnknownFieldSet* group = new UnknownFieldSet();
+      UnknownFieldSet* group = Arena::Create<UnknownFieldSet>(arena, arena);
       group->InternalMergeFrom(*data_.group_);
       data_.group_ = group;
       break;
@@ -288,6 +313,11 @@ uint8_t* UnknownField::InternalSerializeLengthDelimitedNoTag(
 
 namespace internal {
 
+void SetUnknownFieldSetArena(UnknownFieldSet* set, Arena* arena) {
+  ABSL_DCHECK(set->fields_.empty());
+  set->arena_ = arena;
+}
+
 class UnknownFieldParserHelper {
  public:
   explicit UnknownFieldParserHelper(UnknownFieldSet* unknown)
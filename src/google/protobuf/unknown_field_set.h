@@ -37,15 +37,23 @@
 
 namespace google {
 namespace protobuf {
+class Arena;            // arena.h
+class Message;          // message.h
+class UnknownField;     // below
+class UnknownFieldSet;  // below
+
 namespace internal {
 class InternalMetadata;           // metadata_lite.h
 class WireFormat;                 // wire_format.h
 class MessageSetFieldSkipperUsingCord;
 // extension_set_heavy.cc
-}  // namespace internal
 
-class Message;       // message.h
-class UnknownField;  // below
+// Attaches an arena to a freshly constructed, still-empty UnknownFieldSet so
+// that its payloads are bump-allocated alongside the owning message. Called
+// by InternalMetadata when it creates the set.
+PROTOBUF_EXPORT void SetUnknownFieldSetArena(UnknownFieldSet* set,
+                                             Arena* arena);
+}  // namespace internal
 
 // An UnknownFieldSet contains fields that were encountered while parsing a
 // message but were not defined by its type.  Keeping track of these can be
@@ -54,6 +62,14 @@ class UnknownField;  // below
 // simply receives messages and forwards them to other servers does not need
 // to be updated every time a new field is added to the message definition.
 //
+// Unknown fields round-trip with their original wire bytes: a field that is
+// parsed into this set and serialized again without modification is emitted
+// verbatim (unknown fields are written after all known fields).  Proxies that
+// only inspect or rewrite a few fields of a large message can exploit this by
+// parsing with a trimmed message type that declares just those fields; the
+// rest of the payload is carried through this set as opaque bytes instead of
+// being decoded and re-encoded field by field.
+//
 // To get the UnknownFieldSet attached to any message, call
 // Reflection::GetUnknownFields().
 //
@@ -62,6 +78,10 @@ class UnknownField;  // below
 class PROTOBUF_EXPORT UnknownFieldSet {
  public:
   UnknownFieldSet();
+  // Constructs a set whose payloads (length-delimited values and nested
+  // groups) are allocated on `arena`.  The set itself is not registered with
+  // the arena; InternalMetadata takes care of that for message-owned sets.
+  explicit UnknownFieldSet(Arena* arena);
   UnknownFieldSet(const UnknownFieldSet&) = delete;
   UnknownFieldSet& operator=(const UnknownFieldSet&) = delete;
   ~UnknownFieldSet();
@@ -104,6 +124,13 @@ class PROTOBUF_EXPORT UnknownFieldSet {
 
   int SpaceUsed() const { return internal::ToIntSize(SpaceUsedLong()); }
 
+  // Accessors -------------------------------------------------------
+  // Fields are decoded into structured records eagerly during parsing, not
+  // lazily on first access: const accessors here are read by concurrent
+  // threads (printing, size computation, serialization) and therefore must
+  // not mutate the set, which rules out deferring the decode until a reader
+  // shows up without adding per-set synchronization.
+
   // Returns the number of fields present in the UnknownFieldSet.
   inline int field_count() const;
   // Get a field in the set, where 0 <= index < field_count().  The fields
@@ -161,10 +188,15 @@ class PROTOBUF_EXPORT UnknownFieldSet {
  private:
   // For InternalMergeFrom
   friend class UnknownField;
+  friend void internal::SetUnknownFieldSetArena(UnknownFieldSet* set,
+                                                Arena* arena);
   // Merges from other UnknownFieldSet. This method assumes, that this object
   // is newly created and has no fields.
   void InternalMergeFrom(const UnknownFieldSet& other);
   void ClearFallback();
+  // Out-of-line part of Swap() for sets on different arenas, which must
+  // exchange deep copies rather than pointers.
+  void SwapSlow(UnknownFieldSet* x);
 
   template <typename MessageType,
             typename std::enable_if<
@@ -188,6 +220,10 @@ class PROTOBUF_EXPORT UnknownFieldSet {
   }
 
   std::vector<UnknownField> fields_;
+  // The arena, if any, on which payloads are allocated.  When non-null the
+  // arena owns the payloads, so Clear() and the destructor must not free
+  // them individually.
+  Arena* arena_ = nullptr;
 };
 
 namespace internal {
@@ -247,11 +283,13 @@ class PROTOBUF_EXPORT UnknownField {
       uint8_t* target, io::EpsCopyOutputStream* stream) const;
 
 
-  // If this UnknownField contains a pointer, delete it.
+  // If this UnknownField contains a pointer, delete it.  Must not be called
+  // for fields whose payloads live on an arena.
   void Delete();
 
-  // Make a deep copy of any pointers in this UnknownField.
-  void DeepCopy(const UnknownField& other);
+  // Make a deep copy of any pointers in this UnknownField, allocating the
+  // copies on `arena` (or the heap if `arena` is null).
+  void DeepCopy(const UnknownField& other, Arena* arena);
 
   // Set the wire type of this UnknownField. Should only be used when this
   // UnknownField is being created.
@@ -277,6 +315,8 @@ class PROTOBUF_EXPORT UnknownField {
 
 inline UnknownFieldSet::UnknownFieldSet() {}
 
+inline UnknownFieldSet::UnknownFieldSet(Arena* arena) : arena_(arena) {}
+
 inline UnknownFieldSet::~UnknownFieldSet() { Clear(); }
 
 inline void UnknownFieldSet::ClearAndFreeMemory() { Clear(); }
@@ -290,7 +330,11 @@ inline void UnknownFieldSet::Clear() {
 inline bool UnknownFieldSet::empty() const { return fields_.empty(); }
 
 inline void UnknownFieldSet::Swap(UnknownFieldSet* x) {
-  fields_.swap(x->fields_);
+  if (arena_ == x->arena_) {
+    fields_.swap(x->fields_);
+  } else {
+    SwapSlow(x);
+  }
 }
 
 inline int UnknownFieldSet::field_count() const {
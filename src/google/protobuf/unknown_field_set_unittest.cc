@@ -28,6 +28,7 @@
 #include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
+#include "google/protobuf/arena.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl.h"
@@ -275,6 +276,52 @@ TEST_F(UnknownFieldSetTest, SwapWithSelf) {
   EXPECT_EQ(debug_string, empty_message_.DebugString());
 }
 
+TEST_F(UnknownFieldSetTest, ArenaParsing) {
+  // Unknown fields parsed into an arena-allocated message have their payloads
+  // (strings and groups) allocated on the arena; make sure they round-trip.
+  Arena arena;
+  auto* message = Arena::Create<unittest::TestEmptyMessage>(&arena);
+  ASSERT_TRUE(message->ParseFromString(all_fields_data_));
+  EXPECT_GT(message->unknown_fields().field_count(), 0);
+
+  std::string serialized;
+  ASSERT_TRUE(message->SerializeToString(&serialized));
+  unittest::TestAllTypes round_tripped;
+  ASSERT_TRUE(round_tripped.ParseFromString(serialized));
+  TestUtil::ExpectAllFieldsSet(round_tripped);
+}
+
+TEST_F(UnknownFieldSetTest, SwapAcrossArenas) {
+  // Swapping sets on different arenas must exchange deep copies, since the
+  // payloads cannot change owners.
+  Arena arena;
+  auto* arena_message = Arena::Create<unittest::TestEmptyMessage>(&arena);
+  ASSERT_TRUE(arena_message->ParseFromString(GetBizarroData()));
+
+  const std::string debug_string = empty_message_.DebugString();
+  const std::string other_debug_string = arena_message->DebugString();
+  EXPECT_NE(debug_string, other_debug_string);
+
+  empty_message_.mutable_unknown_fields()->Swap(
+      arena_message->mutable_unknown_fields());
+  EXPECT_EQ(debug_string, arena_message->DebugString());
+  EXPECT_EQ(other_debug_string, empty_message_.DebugString());
+}
+
+TEST_F(UnknownFieldSetTest, MergeFromAndDestroyAcrossArenas) {
+  Arena arena;
+  auto* arena_message = Arena::Create<unittest::TestEmptyMessage>(&arena);
+  ASSERT_TRUE(arena_message->ParseFromString(all_fields_data_));
+
+  UnknownFieldSet heap_set;
+  heap_set.MergeFromAndDestroy(arena_message->mutable_unknown_fields());
+  EXPECT_EQ(0, arena_message->unknown_fields().field_count());
+
+  std::string serialized;
+  ASSERT_TRUE(heap_set.SerializeToString(&serialized));
+  EXPECT_EQ(all_fields_data_, serialized);
+}
+
 TEST_F(UnknownFieldSetTest, MergeFrom) {
   unittest::TestEmptyMessage source, destination;
 
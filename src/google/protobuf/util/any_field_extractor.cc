@@ -0,0 +1,221 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/util/any_field_extractor.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/message.h"
+#include "google/protobuf/wire_format.h"
+#include "google/protobuf/wire_format_lite.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+using ::google::protobuf::internal::WireFormat;
+using ::google::protobuf::internal::WireFormatLite;
+
+// Whether `type_url` refers to the type named `full_name`, using the same
+// suffix check as AnyMetadata::InternalIs(): any prefix is accepted as long
+// as a '/' separates it from the full type name.
+bool TypeUrlMatches(absl::string_view type_url, absl::string_view full_name) {
+  return type_url.size() > full_name.size() &&
+         type_url[type_url.size() - full_name.size() - 1] == '/' &&
+         absl::EndsWith(type_url, full_name);
+}
+
+}  // namespace
+
+absl::StatusOr<AnyFieldExtractor> AnyFieldExtractor::Create(
+    absl::Span<const Selection> selections) {
+  AnyFieldExtractor extractor;
+  for (const Selection& selection : selections) {
+    if (selection.type == nullptr) {
+      return absl::InvalidArgumentError("Selection type must not be null.");
+    }
+    // Reuse the root node when the same type is selected twice, so the
+    // masks merge.
+    int root = -1;
+    for (const TypePlan& plan : extractor.types_) {
+      if (plan.type == selection.type) {
+        root = plan.root;
+        break;
+      }
+    }
+    if (root < 0) {
+      root = static_cast<int>(extractor.nodes_.size());
+      extractor.nodes_.emplace_back();
+      extractor.types_.push_back({selection.type, root});
+    }
+    for (const std::string& path : selection.mask.paths()) {
+      absl::Status status = extractor.AddPath(selection.type, path, root);
+      if (!status.ok()) return status;
+    }
+  }
+  return extractor;
+}
+
+absl::Status AnyFieldExtractor::AddPath(const Descriptor* type,
+                                        absl::string_view path, int root) {
+  const std::vector<absl::string_view> segments = absl::StrSplit(path, '.');
+  int node = root;
+  for (size_t i = 0; i < segments.size(); ++i) {
+    const FieldDescriptor* field = type->FindFieldByName(segments[i]);
+    if (field == nullptr) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Path \"", path, "\" does not resolve: \"",
+                       segments[i], "\" is not a field of ",
+                       type->full_name(), "."));
+    }
+    const bool last = i + 1 == segments.size();
+    FieldSelection& selection = nodes_[node].fields[field->number()];
+    if (last) {
+      // A whole-field selection subsumes any nested one added earlier.
+      selection = {field, kWholeField};
+      return absl::OkStatus();
+    }
+    if (field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE ||
+        field->is_repeated()) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Path \"", path, "\" traverses \"", segments[i],
+                       "\", which is not a singular message field."));
+    }
+    if (selection.field != nullptr && selection.subplan == kWholeField) {
+      // The whole field is already selected; the deeper path adds nothing.
+      return absl::OkStatus();
+    }
+    if (selection.field == nullptr) {
+      selection.field = field;
+      selection.subplan = static_cast<int>(nodes_.size());
+      nodes_.emplace_back();  // Invalidates `selection`; re-read below.
+    }
+    node = nodes_[node].fields[field->number()].subplan;
+    type = field->message_type();
+  }
+  return absl::OkStatus();
+}
+
+const Descriptor* AnyFieldExtractor::FindType(
+    absl::string_view type_url) const {
+  for (const TypePlan& plan : types_) {
+    if (TypeUrlMatches(type_url, plan.type->full_name())) return plan.type;
+  }
+  return nullptr;
+}
+
+absl::Status AnyFieldExtractor::Extract(const Any& any,
+                                        Message* output) const {
+  const Descriptor* type = output->GetDescriptor();
+  const TypePlan* plan = nullptr;
+  for (const TypePlan& candidate : types_) {
+    if (candidate.type == type) {
+      plan = &candidate;
+      break;
+    }
+  }
+  if (plan == nullptr) {
+    return absl::NotFoundError(absl::StrCat(
+        "No selection was compiled for ", type->full_name(), "."));
+  }
+  if (!TypeUrlMatches(any.type_url(), type->full_name())) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Type URL \"", any.type_url(), "\" does not carry ",
+                     type->full_name(), "."));
+  }
+  output->Clear();
+  io::CodedInputStream input(
+      reinterpret_cast<const uint8_t*>(any.value().data()),
+      static_cast<int>(any.value().size()));
+  if (!WalkMessage(nodes_[plan->root], 0, &input, output)) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Any value for ", type->full_name(), " is malformed."));
+  }
+  return absl::OkStatus();
+}
+
+bool AnyFieldExtractor::WalkMessage(const PlanNode& node,
+                                    uint32_t group_start_tag,
+                                    io::CodedInputStream* input,
+                                    Message* output) const {
+  while (true) {
+    const uint32_t tag = input->ReadTagNoLastTag();
+    if (tag == 0) {
+      // End of stream (or of the enclosing length limit): valid anywhere
+      // but inside a group.
+      return group_start_tag == 0;
+    }
+    if (WireFormatLite::GetTagWireType(tag) ==
+        WireFormatLite::WIRETYPE_END_GROUP) {
+      return group_start_tag != 0 &&
+             WireFormatLite::GetTagFieldNumber(tag) ==
+                 WireFormatLite::GetTagFieldNumber(group_start_tag);
+    }
+    const auto it = node.fields.find(WireFormatLite::GetTagFieldNumber(tag));
+    if (it == node.fields.end()) {
+      // Unselected: skip at the wire level, payload bytes untouched.
+      if (!WireFormatLite::SkipField(input, tag)) return false;
+      continue;
+    }
+    const FieldSelection& selection = it->second;
+    if (selection.subplan == kWholeField) {
+      if (!WireFormat::ParseAndMergeField(tag, selection.field, output,
+                                          input)) {
+        return false;
+      }
+      continue;
+    }
+    // A nested selection: project the submessage through its own node.
+    const WireFormatLite::WireType wire_type =
+        WireFormatLite::GetTagWireType(tag);
+    if (wire_type != WireFormatLite::WIRETYPE_LENGTH_DELIMITED &&
+        wire_type != WireFormatLite::WIRETYPE_START_GROUP) {
+      // Wrong wire type: treat it as an unknown field, as the parser does.
+      if (!WireFormatLite::SkipField(input, tag)) return false;
+      continue;
+    }
+    if (!input->IncrementRecursionDepth()) return false;
+    Message* child =
+        output->GetReflection()->MutableMessage(output, selection.field);
+    if (wire_type == WireFormatLite::WIRETYPE_START_GROUP) {
+      if (!WalkMessage(nodes_[selection.subplan], tag, input, child)) {
+        return false;
+      }
+    } else {
+      uint32_t length;
+      if (!input->ReadVarint32(&length)) return false;
+      const io::CodedInputStream::Limit limit = input->PushLimit(length);
+      if (!WalkMessage(nodes_[selection.subplan], 0, input, child)) {
+        return false;
+      }
+      if (!input->ConsumedEntireMessage()) return false;
+      input->PopLimit(limit);
+    }
+    input->DecrementRecursionDepth();
+  }
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
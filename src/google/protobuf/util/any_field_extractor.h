@@ -0,0 +1,134 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef GOOGLE_PROTOBUF_UTIL_ANY_FIELD_EXTRACTOR_H__
+#define GOOGLE_PROTOBUF_UTIL_ANY_FIELD_EXTRACTOR_H__
+
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "google/protobuf/any.pb.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/field_mask.pb.h"
+#include "google/protobuf/message.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+
+namespace io {
+class CodedInputStream;
+}  // namespace io
+
+namespace util {
+
+// Extracts a few selected fields from google.protobuf.Any payloads without
+// materializing the rest of the message.
+//
+// A consumer of an Any-carrying event stream usually needs a handful of
+// fields from a payload that is orders of magnitude larger.  UnpackTo()
+// makes it pay for all of it: every field is decoded, every string copied,
+// every submessage allocated.  AnyFieldExtractor instead compiles
+// (type, FieldMask) pairs into a per-field-number selection plan once; at
+// extraction time it walks the value bytes with a CodedInputStream, parses
+// only the selected field numbers into the output message, and skips
+// everything else at the wire level, so the cost scales with the bytes the
+// consumer asked for rather than with the payload.
+//
+//   auto extractor = AnyFieldExtractor::Create(
+//       {{Order::descriptor(), MakeMask("user_id", "total.amount")}});
+//   Order projection;
+//   if (extractor->Extract(any, &projection).ok()) {
+//     Use(projection.user_id(), projection.total().amount());
+//   }
+//
+// Mask paths follow FieldMask semantics: dotted field names, where every
+// segment but the last must name a singular message field.  A path ending
+// at a message field copies that subtree in full.  Overlapping paths are
+// merged, with the shorter (whole-field) path winning.
+//
+// An extractor is immutable after Create() and safe to share between
+// threads.  Extract() is tied to the descriptors the plan was compiled
+// from; output messages must use those exact descriptors.
+class PROTOBUF_EXPORT AnyFieldExtractor {
+ public:
+  struct Selection {
+    const Descriptor* type;
+    FieldMask mask;
+  };
+
+  // Compiles a plan over `selections`.  Returns InvalidArgument if a mask
+  // path does not resolve in its type or traverses a non-message or
+  // repeated field before its last segment.  Selections naming the same
+  // type are merged.
+  static absl::StatusOr<AnyFieldExtractor> Create(
+      absl::Span<const Selection> selections);
+
+  AnyFieldExtractor(AnyFieldExtractor&&) = default;
+  AnyFieldExtractor& operator=(AnyFieldExtractor&&) = default;
+
+  // Returns the compiled type `type_url` refers to, or null if the URL
+  // names no type in the plan.  Use this to pick the output message for a
+  // heterogeneous stream before calling Extract().
+  const Descriptor* FindType(absl::string_view type_url) const;
+
+  // Clears `*output` and fills in the fields selected for its type from
+  // the payload of `any`.  Returns NotFound if no selection was compiled
+  // for the output's type, and InvalidArgument if the Any's type URL names
+  // a different type or its value bytes are malformed.
+  absl::Status Extract(const Any& any, Message* output) const;
+
+ private:
+  // One selected occurrence slot: the field, and either the index of the
+  // plan node to project its submessage through or kWholeField to parse
+  // the occurrence in full.
+  static constexpr int kWholeField = -1;
+  struct FieldSelection {
+    const FieldDescriptor* field;
+    int subplan;
+  };
+  // Field-number lookup for one (sub)message type.  Nodes live in nodes_
+  // and reference each other by index so the plan is movable.
+  struct PlanNode {
+    absl::flat_hash_map<int, FieldSelection> fields;
+  };
+  struct TypePlan {
+    const Descriptor* type;
+    int root;
+  };
+
+  AnyFieldExtractor() = default;
+
+  // Adds `path` under nodes_[root], creating nodes as needed.
+  absl::Status AddPath(const Descriptor* type, absl::string_view path,
+                       int root);
+
+  // Walks one message level.  `group_start_tag` is zero at the top level
+  // and the start-group tag inside a group.  Returns false on malformed
+  // input.
+  bool WalkMessage(const PlanNode& node, uint32_t group_start_tag,
+                   io::CodedInputStream* input, Message* output) const;
+
+  std::vector<PlanNode> nodes_;
+  // The handful of compiled types; matched by linear scan.
+  std::vector<TypePlan> types_;
+};
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_ANY_FIELD_EXTRACTOR_H__
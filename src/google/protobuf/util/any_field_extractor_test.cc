@@ -0,0 +1,135 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/util/any_field_extractor.h"
+
+#include <string>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "google/protobuf/any.pb.h"
+#include "google/protobuf/field_mask.pb.h"
+#include "google/protobuf/unittest.pb.h"
+#include "google/protobuf/util/field_mask_util.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+using ::protobuf_unittest::ForeignMessage;
+using ::protobuf_unittest::TestAllTypes;
+using ::testing::ElementsAre;
+
+FieldMask MakeMask(absl::string_view paths) {
+  FieldMask mask;
+  FieldMaskUtil::FromString(paths, &mask);
+  return mask;
+}
+
+TEST(AnyFieldExtractorTest, ExtractsOnlySelectedFields) {
+  TestAllTypes message;
+  message.set_optional_int32(42);
+  message.set_optional_string("dropped");
+  message.add_repeated_string("kept");
+  message.add_repeated_string("also kept");
+  message.mutable_optional_nested_message()->set_bb(7);
+
+  Any any;
+  any.PackFrom(message);
+
+  auto extractor = AnyFieldExtractor::Create(
+      {{TestAllTypes::descriptor(), MakeMask("optional_int32,repeated_string")}});
+  ASSERT_TRUE(extractor.ok()) << extractor.status();
+
+  TestAllTypes projection;
+  ASSERT_TRUE(extractor->Extract(any, &projection).ok());
+  EXPECT_EQ(projection.optional_int32(), 42);
+  EXPECT_THAT(projection.repeated_string(), ElementsAre("kept", "also kept"));
+  EXPECT_FALSE(projection.has_optional_string());
+  EXPECT_FALSE(projection.has_optional_nested_message());
+}
+
+TEST(AnyFieldExtractorTest, NestedPathsProjectSubmessages) {
+  TestAllTypes message;
+  message.mutable_optional_foreign_message()->set_c(1);
+  message.mutable_optional_foreign_message()->set_d(2);
+  message.mutable_optional_nested_message()->set_bb(3);
+
+  Any any;
+  any.PackFrom(message);
+
+  // "c" is selected through the submessage; its sibling "d" is not.  The
+  // nested-message path selects the whole subtree.
+  auto extractor = AnyFieldExtractor::Create(
+      {{TestAllTypes::descriptor(),
+        MakeMask("optional_foreign_message.c,optional_nested_message")}});
+  ASSERT_TRUE(extractor.ok()) << extractor.status();
+
+  TestAllTypes projection;
+  ASSERT_TRUE(extractor->Extract(any, &projection).ok());
+  EXPECT_EQ(projection.optional_foreign_message().c(), 1);
+  EXPECT_FALSE(projection.optional_foreign_message().has_d());
+  EXPECT_EQ(projection.optional_nested_message().bb(), 3);
+}
+
+TEST(AnyFieldExtractorTest, FindTypeAndTypeMismatch) {
+  auto extractor = AnyFieldExtractor::Create(
+      {{TestAllTypes::descriptor(), MakeMask("optional_int32")}});
+  ASSERT_TRUE(extractor.ok()) << extractor.status();
+
+  Any any;
+  any.PackFrom(ForeignMessage());
+  EXPECT_EQ(extractor->FindType(any.type_url()), nullptr);
+
+  // The output names a compiled type, but the Any carries another.
+  TestAllTypes projection;
+  EXPECT_TRUE(absl::IsInvalidArgument(extractor->Extract(any, &projection)));
+
+  // No selection at all for the output's type.
+  ForeignMessage foreign;
+  EXPECT_TRUE(absl::IsNotFound(extractor->Extract(any, &foreign)));
+
+  any.PackFrom(TestAllTypes());
+  EXPECT_EQ(extractor->FindType(any.type_url()), TestAllTypes::descriptor());
+}
+
+TEST(AnyFieldExtractorTest, RejectsInvalidPaths) {
+  EXPECT_TRUE(absl::IsInvalidArgument(
+      AnyFieldExtractor::Create(
+          {{TestAllTypes::descriptor(), MakeMask("no_such_field")}})
+          .status()));
+  // A non-terminal segment must be a singular message field.
+  EXPECT_TRUE(absl::IsInvalidArgument(
+      AnyFieldExtractor::Create(
+          {{TestAllTypes::descriptor(), MakeMask("optional_int32.bb")}})
+          .status()));
+  EXPECT_TRUE(absl::IsInvalidArgument(
+      AnyFieldExtractor::Create(
+          {{TestAllTypes::descriptor(),
+            MakeMask("repeated_nested_message.bb")}})
+          .status()));
+}
+
+TEST(AnyFieldExtractorTest, RejectsMalformedValue) {
+  auto extractor = AnyFieldExtractor::Create(
+      {{TestAllTypes::descriptor(), MakeMask("optional_int32")}});
+  ASSERT_TRUE(extractor.ok()) << extractor.status();
+
+  Any any;
+  any.PackFrom(TestAllTypes());
+  // A lone tag with its varint payload missing.
+  any.set_value(std::string("\x08", 1));
+
+  TestAllTypes projection;
+  EXPECT_TRUE(absl::IsInvalidArgument(extractor->Extract(any, &projection)));
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,120 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef GOOGLE_PROTOBUF_UTIL_CACHED_ANY_UNPACKER_H__
+#define GOOGLE_PROTOBUF_UTIL_CACHED_ANY_UNPACKER_H__
+
+#include <cstddef>
+#include <string>
+
+#include "absl/strings/match.h"
+#include "google/protobuf/any.pb.h"
+#include "google/protobuf/util/merge_reparse.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+// Unpacks google.protobuf.Any payloads that repeatedly carry the same few
+// types, caching the work Any::UnpackTo() redoes on every call:
+//
+//  - Type check: UnpackTo() suffix-compares the full type URL string each
+//    time.  The unpacker remembers the exact URL it last accepted, so the
+//    steady-state check is a pointer-and-length comparison (the same Any
+//    object unpacked again) or one memcmp, with the suffix walk reserved
+//    for genuinely new URLs.
+//  - Payload parse: UnpackTo() re-parses value on every call.  The
+//    unpacker keeps the bytes its cached message was parsed from and
+//    returns the cached object untouched when they recur; when the bytes
+//    differ it re-parses through MergeReparser, so unchanged submessage
+//    objects keep their addresses (see merge_reparse.h).
+//
+// One unpacker caches one unpacked type; an event bus dispatching a
+// handful of types holds one unpacker per type.  Not thread-safe; use one
+// instance per consumer.
+template <typename T>
+class CachedAnyUnpacker {
+ public:
+  CachedAnyUnpacker() = default;
+  CachedAnyUnpacker(const CachedAnyUnpacker&) = delete;
+  CachedAnyUnpacker& operator=(const CachedAnyUnpacker&) = delete;
+
+  // Returns the unpacked message, or null if `any` does not carry a T or
+  // its payload does not parse.  The returned object is owned by the
+  // unpacker, keeps its address across calls, and is updated in place by
+  // the next Unpack() whose payload differs.
+  const T* Unpack(const Any& any) {
+    if (!MatchesType(any.type_url())) return nullptr;
+    const std::string& value = any.value();
+    if (has_value_ && value == cached_value_) {
+      changed_ = false;
+      return &message_;
+    }
+    if (!reparser_.Reparse(value, &message_)) {
+      has_value_ = false;
+      return nullptr;
+    }
+    changed_ = reparser_.changed();
+    cached_value_.assign(value);
+    has_value_ = true;
+    return &message_;
+  }
+
+  // Whether the last successful Unpack() modified the cached message.
+  // False on a byte-identical payload, and also when different bytes
+  // decode to the same field values.
+  bool changed() const { return changed_; }
+
+ private:
+  bool MatchesType(const std::string& type_url) {
+    // Same Any object with an unchanged URL: no byte comparison at all.
+    if (type_url.data() == accepted_data_ && type_url.size() == accepted_size_) {
+      return true;
+    }
+    if (!accepted_url_.empty() && type_url == accepted_url_) {
+      accepted_data_ = type_url.data();
+      accepted_size_ = type_url.size();
+      return true;
+    }
+    // New URL: the full check, as AnyMetadata::InternalIs() does.
+    const std::string name = T::default_instance().GetTypeName();
+    if (type_url.size() < name.size() + 1 ||
+        type_url[type_url.size() - name.size() - 1] != '/' ||
+        !absl::EndsWith(type_url, name)) {
+      return false;
+    }
+    accepted_url_.assign(type_url);
+    accepted_data_ = type_url.data();
+    accepted_size_ = type_url.size();
+    return true;
+  }
+
+  // Last accepted type URL, plus the address/length of the std::string it
+  // was read from for the pointer fast path.
+  std::string accepted_url_;
+  const char* accepted_data_ = nullptr;
+  size_t accepted_size_ = 0;
+
+  // The bytes message_ currently reflects.
+  std::string cached_value_;
+  bool has_value_ = false;
+  bool changed_ = false;
+
+  T message_;
+  MergeReparser reparser_;
+};
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_CACHED_ANY_UNPACKER_H__
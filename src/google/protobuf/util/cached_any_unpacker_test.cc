@@ -0,0 +1,113 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/util/cached_any_unpacker.h"
+
+#include <string>
+
+#include <gtest/gtest.h>
+#include "google/protobuf/any.pb.h"
+#include "google/protobuf/unittest.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+TEST(CachedAnyUnpackerTest, UnpacksAndReturnsStableObject) {
+  protobuf_unittest::ForeignMessage original;
+  original.set_c(42);
+  Any any;
+  ASSERT_TRUE(any.PackFrom(original));
+
+  CachedAnyUnpacker<protobuf_unittest::ForeignMessage> unpacker;
+  const protobuf_unittest::ForeignMessage* first = unpacker.Unpack(any);
+  ASSERT_TRUE(first != nullptr);
+  EXPECT_EQ(first->c(), 42);
+
+  // Identical payload: the cached object comes back untouched.
+  const protobuf_unittest::ForeignMessage* second = unpacker.Unpack(any);
+  EXPECT_EQ(second, first);
+  EXPECT_FALSE(unpacker.changed());
+
+  // Changed payload: same address, updated in place.
+  original.set_c(43);
+  ASSERT_TRUE(any.PackFrom(original));
+  const protobuf_unittest::ForeignMessage* third = unpacker.Unpack(any);
+  EXPECT_EQ(third, first);
+  EXPECT_EQ(third->c(), 43);
+  EXPECT_TRUE(unpacker.changed());
+}
+
+TEST(CachedAnyUnpackerTest, RejectsWrongType) {
+  protobuf_unittest::TestAllTypes message;
+  message.set_optional_int32(1);
+  Any any;
+  ASSERT_TRUE(any.PackFrom(message));
+
+  CachedAnyUnpacker<protobuf_unittest::ForeignMessage> unpacker;
+  EXPECT_TRUE(unpacker.Unpack(any) == nullptr);
+}
+
+TEST(CachedAnyUnpackerTest, AcceptsCustomTypeUrlPrefix) {
+  protobuf_unittest::ForeignMessage original;
+  original.set_c(7);
+  Any any;
+  ASSERT_TRUE(any.PackFrom(original, "type.example.com"));
+
+  CachedAnyUnpacker<protobuf_unittest::ForeignMessage> unpacker;
+  const protobuf_unittest::ForeignMessage* unpacked = unpacker.Unpack(any);
+  ASSERT_TRUE(unpacked != nullptr);
+  EXPECT_EQ(unpacked->c(), 7);
+}
+
+TEST(CachedAnyUnpackerTest, SubmessageSurvivesUnrelatedUpdate) {
+  protobuf_unittest::TestAllTypes original;
+  original.mutable_optional_nested_message()->set_bb(5);
+  original.set_optional_int32(1);
+  Any any;
+  ASSERT_TRUE(any.PackFrom(original));
+
+  CachedAnyUnpacker<protobuf_unittest::TestAllTypes> unpacker;
+  const protobuf_unittest::TestAllTypes* unpacked = unpacker.Unpack(any);
+  ASSERT_TRUE(unpacked != nullptr);
+  const auto* nested = &unpacked->optional_nested_message();
+
+  // An update elsewhere in the message re-parses in place; the unchanged
+  // submessage keeps its address (the MergeReparser guarantee).
+  original.set_optional_int32(2);
+  ASSERT_TRUE(any.PackFrom(original));
+  unpacked = unpacker.Unpack(any);
+  ASSERT_TRUE(unpacked != nullptr);
+  EXPECT_EQ(unpacked->optional_int32(), 2);
+  EXPECT_EQ(&unpacked->optional_nested_message(), nested);
+  EXPECT_EQ(unpacked->optional_nested_message().bb(), 5);
+}
+
+TEST(CachedAnyUnpackerTest, MalformedPayloadRecovers) {
+  protobuf_unittest::ForeignMessage original;
+  original.set_c(9);
+  Any any;
+  ASSERT_TRUE(any.PackFrom(original));
+
+  CachedAnyUnpacker<protobuf_unittest::ForeignMessage> unpacker;
+  ASSERT_TRUE(unpacker.Unpack(any) != nullptr);
+
+  Any bad = any;
+  bad.set_value("\x05");  // truncated field
+  EXPECT_TRUE(unpacker.Unpack(bad) == nullptr);
+
+  // A good payload after a bad one unpacks normally.
+  const protobuf_unittest::ForeignMessage* unpacked = unpacker.Unpack(any);
+  ASSERT_TRUE(unpacked != nullptr);
+  EXPECT_EQ(unpacked->c(), 9);
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,145 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/util/column_transcoder.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/generated_message_reflection.h"
+#include "google/protobuf/message.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+namespace {
+
+bool IsSupportedColumnType(FieldDescriptor::CppType cpp_type) {
+  switch (cpp_type) {
+    case FieldDescriptor::CPPTYPE_INT32:
+    case FieldDescriptor::CPPTYPE_INT64:
+    case FieldDescriptor::CPPTYPE_UINT32:
+    case FieldDescriptor::CPPTYPE_UINT64:
+    case FieldDescriptor::CPPTYPE_FLOAT:
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+    case FieldDescriptor::CPPTYPE_BOOL:
+    case FieldDescriptor::CPPTYPE_ENUM:
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+const internal::ReflectionSchema& ColumnTranscoder::GetSchema(
+    const Reflection* reflection) {
+  return reflection->schema_;
+}
+
+absl::StatusOr<ColumnTranscoder> ColumnTranscoder::Create(
+    const Message& prototype, absl::Span<const FieldDescriptor* const> fields) {
+  const Descriptor* descriptor = prototype.GetDescriptor();
+  const Reflection* reflection = prototype.GetReflection();
+  const internal::ReflectionSchema& schema = GetSchema(reflection);
+
+  std::vector<Column> columns;
+  columns.reserve(fields.size());
+  for (const FieldDescriptor* field : fields) {
+    if (field == nullptr) {
+      return absl::InvalidArgumentError("null field");
+    }
+    if (field->containing_type() != descriptor) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("field ", field->full_name(),
+                       " does not belong to message ", descriptor->full_name()));
+    }
+    if (field->is_extension()) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "field ", field->full_name(), " is an extension"));
+    }
+    if (field->is_repeated()) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "field ", field->full_name(), " is repeated"));
+    }
+    if (schema.InRealOneof(field)) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "field ", field->full_name(), " is a member of a oneof"));
+    }
+    if (schema.IsSplit(field)) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "field ", field->full_name(), " is in the split section"));
+    }
+    if (!IsSupportedColumnType(field->cpp_type())) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "field ", field->full_name(), " has type ", field->cpp_type_name(),
+          "; only numeric, bool and enum fields are supported"));
+    }
+    Column column;
+    column.field = field;
+    column.offset = schema.GetFieldOffsetNonOneof(field);
+    column.has_bit_index =
+        schema.HasHasbits() ? schema.HasBitIndex(field) : kNoHasBit;
+    column.cpp_type = field->cpp_type();
+    columns.push_back(column);
+  }
+
+  const uint32_t has_bits_offset =
+      schema.HasHasbits() ? schema.HasBitsOffset() : 0;
+  return ColumnTranscoder(reflection, has_bits_offset, std::move(columns));
+}
+
+absl::StatusOr<const ColumnTranscoder::Column*> ColumnTranscoder::CheckCall(
+    int column, FieldDescriptor::CppType buffer_type, size_t buffer_size,
+    size_t batch_size) const {
+  if (column < 0 || column >= columns()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("column ", column, " out of range; plan has ", columns(),
+                     " columns"));
+  }
+  const Column& col = columns_[static_cast<size_t>(column)];
+  // Enum columns travel through int32_t buffers.
+  const bool type_matches =
+      col.cpp_type == buffer_type ||
+      (col.cpp_type == FieldDescriptor::CPPTYPE_ENUM &&
+       buffer_type == FieldDescriptor::CPPTYPE_INT32);
+  if (!type_matches) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "buffer type does not match field ", col.field->full_name(),
+        " of type ", col.field->cpp_type_name()));
+  }
+  if (buffer_size != batch_size) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("buffer holds ", buffer_size, " elements but batch has ",
+                     batch_size, " messages"));
+  }
+  return &col;
+}
+
+absl::Status ColumnTranscoder::ForeignMessageError(
+    const Message& message) const {
+  return absl::InvalidArgumentError(
+      absl::StrCat("message of type ", message.GetDescriptor()->full_name(),
+                   " does not match the plan's type"));
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
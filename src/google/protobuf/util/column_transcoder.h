@@ -0,0 +1,206 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef GOOGLE_PROTOBUF_UTIL_COLUMN_TRANSCODER_H__
+#define GOOGLE_PROTOBUF_UTIL_COLUMN_TRANSCODER_H__
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+// Maps a column buffer element type to the field cpp type it carries.
+// Implementation detail of ColumnTranscoder; not for direct use.
+template <typename T>
+struct ColumnTypeTraits;
+template <>
+struct ColumnTypeTraits<int32_t> {
+  static constexpr FieldDescriptor::CppType kCppType =
+      FieldDescriptor::CPPTYPE_INT32;
+};
+template <>
+struct ColumnTypeTraits<int64_t> {
+  static constexpr FieldDescriptor::CppType kCppType =
+      FieldDescriptor::CPPTYPE_INT64;
+};
+template <>
+struct ColumnTypeTraits<uint32_t> {
+  static constexpr FieldDescriptor::CppType kCppType =
+      FieldDescriptor::CPPTYPE_UINT32;
+};
+template <>
+struct ColumnTypeTraits<uint64_t> {
+  static constexpr FieldDescriptor::CppType kCppType =
+      FieldDescriptor::CPPTYPE_UINT64;
+};
+template <>
+struct ColumnTypeTraits<float> {
+  static constexpr FieldDescriptor::CppType kCppType =
+      FieldDescriptor::CPPTYPE_FLOAT;
+};
+template <>
+struct ColumnTypeTraits<double> {
+  static constexpr FieldDescriptor::CppType kCppType =
+      FieldDescriptor::CPPTYPE_DOUBLE;
+};
+template <>
+struct ColumnTypeTraits<bool> {
+  static constexpr FieldDescriptor::CppType kCppType =
+      FieldDescriptor::CPPTYPE_BOOL;
+};
+
+// A compiled plan for moving scalar fields between batches of messages and
+// column arrays.
+//
+// Per-field reflection calls pay for field validation and type dispatch on
+// every message; when a pipeline extracts the same handful of fields from
+// millions of messages, that overhead dominates.  ColumnTranscoder hoists
+// all of it to plan-compilation time: Create() resolves each requested field
+// to its byte offset and hasbit in the message layout once, and Gather() /
+// Scatter() then run a tight per-column loop that is one load and one store
+// per message.
+//
+//   auto transcoder = ColumnTranscoder::Create(
+//       *prototype, {descriptor->FindFieldByName("user_id"),
+//                    descriptor->FindFieldByName("score")});
+//   std::vector<int64_t> ids(batch.size());
+//   transcoder->Gather<int64_t>(0, batch, absl::MakeSpan(ids));
+//
+// Columns are limited to singular numeric, bool and enum fields that are not
+// extensions, not members of a oneof and not in the split (rarely-present)
+// section of the message; string, message and repeated fields do not have
+// fixed-size slots and keep their per-field reflection cost.  Gathering an
+// unset field yields the field's default value, since a singular scalar slot
+// always holds the default while the field is unset.
+//
+// A transcoder is immutable after Create() and safe to share between threads.
+class PROTOBUF_EXPORT ColumnTranscoder {
+ public:
+  // Compiles a plan over `fields`, which must all belong to the type of
+  // `prototype`.  Returns InvalidArgument if a field is unsupported (see
+  // class comment).  The plan is tied to the prototype's Reflection and may
+  // only be applied to messages from the same pool and factory.
+  static absl::StatusOr<ColumnTranscoder> Create(
+      const Message& prototype,
+      absl::Span<const FieldDescriptor* const> fields);
+
+  ColumnTranscoder(ColumnTranscoder&&) = default;
+  ColumnTranscoder& operator=(ColumnTranscoder&&) = default;
+
+  int columns() const { return static_cast<int>(columns_.size()); }
+  const FieldDescriptor* field(int column) const {
+    return columns_[static_cast<size_t>(column)].field;
+  }
+
+  // Reads column `column` from each message into `out`, which must have
+  // exactly messages.size() elements.  T must match the column's cpp type;
+  // enum columns are read as int32_t.  Unset fields yield their default.
+  template <typename T>
+  absl::Status Gather(int column, absl::Span<const Message* const> messages,
+                      absl::Span<T> out) const;
+
+  // Writes `values` into column `column` of each message and marks the field
+  // present.  Sizes and types are checked as in Gather().  Like
+  // Reflection::SetEnumValue, enum values written through an int32_t column
+  // are not range-checked against closed enums in opt builds.
+  template <typename T>
+  absl::Status Scatter(int column, absl::Span<const T> values,
+                       absl::Span<Message* const> messages) const;
+
+ private:
+  static constexpr uint32_t kNoHasBit = ~uint32_t{0};
+
+  struct Column {
+    const FieldDescriptor* field;
+    uint32_t offset;
+    uint32_t has_bit_index;  // kNoHasBit if the field has no hasbit.
+    FieldDescriptor::CppType cpp_type;
+  };
+
+  ColumnTranscoder(const Reflection* reflection, uint32_t has_bits_offset,
+                   std::vector<Column> columns)
+      : reflection_(reflection),
+        has_bits_offset_(has_bits_offset),
+        columns_(std::move(columns)) {}
+
+  static const internal::ReflectionSchema& GetSchema(
+      const Reflection* reflection);
+
+  // Shared validation for Gather/Scatter; returns the column on success.
+  absl::StatusOr<const Column*> CheckCall(int column,
+                                          FieldDescriptor::CppType buffer_type,
+                                          size_t buffer_size,
+                                          size_t batch_size) const;
+  absl::Status ForeignMessageError(const Message& message) const;
+
+  const Reflection* reflection_;
+  uint32_t has_bits_offset_;  // Unused when no column has a hasbit.
+  std::vector<Column> columns_;
+};
+
+template <typename T>
+absl::Status ColumnTranscoder::Gather(int column,
+                                      absl::Span<const Message* const> messages,
+                                      absl::Span<T> out) const {
+  auto col = CheckCall(column, ColumnTypeTraits<T>::kCppType, out.size(),
+                       messages.size());
+  if (!col.ok()) return col.status();
+  const uint32_t offset = (*col)->offset;
+  for (size_t i = 0; i < messages.size(); ++i) {
+    const Message& message = *messages[i];
+    if (PROTOBUF_PREDICT_FALSE(message.GetReflection() != reflection_)) {
+      return ForeignMessageError(message);
+    }
+    out[i] = *internal::GetConstPointerAtOffset<T>(&message, offset);
+  }
+  return absl::OkStatus();
+}
+
+template <typename T>
+absl::Status ColumnTranscoder::Scatter(
+    int column, absl::Span<const T> values,
+    absl::Span<Message* const> messages) const {
+  auto col = CheckCall(column, ColumnTypeTraits<T>::kCppType, values.size(),
+                       messages.size());
+  if (!col.ok()) return col.status();
+  const uint32_t offset = (*col)->offset;
+  const uint32_t has_bit_index = (*col)->has_bit_index;
+  for (size_t i = 0; i < messages.size(); ++i) {
+    Message* message = messages[i];
+    if (PROTOBUF_PREDICT_FALSE(message->GetReflection() != reflection_)) {
+      return ForeignMessageError(*message);
+    }
+    *internal::GetPointerAtOffset<T>(message, offset) = values[i];
+    if (has_bit_index != kNoHasBit) {
+      internal::GetPointerAtOffset<uint32_t>(
+          message, has_bits_offset_)[has_bit_index / 32] |=
+          uint32_t{1} << (has_bit_index % 32);
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_COLUMN_TRANSCODER_H__
@@ -0,0 +1,189 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/util/column_transcoder.h"
+
+#include <cstdint>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "absl/log/absl_check.h"
+#include "absl/types/span.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/unittest.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+using protobuf_unittest::TestAllTypes;
+
+const FieldDescriptor* GetField(const char* name) {
+  const FieldDescriptor* field =
+      TestAllTypes::descriptor()->FindFieldByName(name);
+  ABSL_CHECK(field != nullptr) << name;
+  return field;
+}
+
+TEST(ColumnTranscoderTest, GathersScalarColumns) {
+  auto transcoder = ColumnTranscoder::Create(
+      TestAllTypes::default_instance(),
+      {GetField("optional_int32"), GetField("optional_uint64"),
+       GetField("optional_double"), GetField("optional_bool")});
+  ASSERT_TRUE(transcoder.ok()) << transcoder.status();
+  ASSERT_EQ(4, transcoder->columns());
+
+  TestAllTypes a, b, c;
+  a.set_optional_int32(100);
+  a.set_optional_uint64(101);
+  a.set_optional_double(101.5);
+  a.set_optional_bool(true);
+  b.set_optional_int32(-200);
+  c.set_optional_uint64(300);
+  const Message* batch[] = {&a, &b, &c};
+
+  std::vector<int32_t> int32s(3);
+  std::vector<uint64_t> uint64s(3);
+  std::vector<double> doubles(3);
+  ASSERT_TRUE(transcoder->Gather<int32_t>(0, batch, absl::MakeSpan(int32s)).ok());
+  ASSERT_TRUE(
+      transcoder->Gather<uint64_t>(1, batch, absl::MakeSpan(uint64s)).ok());
+  ASSERT_TRUE(
+      transcoder->Gather<double>(2, batch, absl::MakeSpan(doubles)).ok());
+
+  EXPECT_EQ(100, int32s[0]);
+  EXPECT_EQ(-200, int32s[1]);
+  EXPECT_EQ(0, int32s[2]);  // Unset fields yield their default.
+  EXPECT_EQ(101u, uint64s[0]);
+  EXPECT_EQ(300u, uint64s[2]);
+  EXPECT_EQ(101.5, doubles[0]);
+  EXPECT_EQ(0.0, doubles[1]);
+}
+
+TEST(ColumnTranscoderTest, GathersDefaultsOfUnsetFields) {
+  auto transcoder = ColumnTranscoder::Create(TestAllTypes::default_instance(),
+                                             {GetField("default_int32")});
+  ASSERT_TRUE(transcoder.ok()) << transcoder.status();
+
+  TestAllTypes message;
+  const Message* batch[] = {&message};
+  int32_t value = 0;
+  ASSERT_TRUE(
+      transcoder->Gather<int32_t>(0, batch, absl::MakeSpan(&value, 1)).ok());
+  EXPECT_EQ(41, value);
+}
+
+TEST(ColumnTranscoderTest, ScatterSetsValuesAndPresence) {
+  auto transcoder = ColumnTranscoder::Create(
+      TestAllTypes::default_instance(),
+      {GetField("optional_int64"), GetField("optional_float")});
+  ASSERT_TRUE(transcoder.ok()) << transcoder.status();
+
+  TestAllTypes a, b;
+  Message* batch[] = {&a, &b};
+  const int64_t int64s[] = {int64_t{1} << 40, -7};
+  const float floats[] = {1.5f, -2.5f};
+  ASSERT_TRUE(transcoder->Scatter<int64_t>(0, int64s, batch).ok());
+  ASSERT_TRUE(transcoder->Scatter<float>(1, floats, batch).ok());
+
+  EXPECT_TRUE(a.has_optional_int64());
+  EXPECT_EQ(int64_t{1} << 40, a.optional_int64());
+  EXPECT_EQ(-7, b.optional_int64());
+  EXPECT_TRUE(b.has_optional_float());
+  EXPECT_EQ(1.5f, a.optional_float());
+  EXPECT_EQ(-2.5f, b.optional_float());
+}
+
+TEST(ColumnTranscoderTest, EnumColumnsTravelAsInt32) {
+  auto transcoder = ColumnTranscoder::Create(
+      TestAllTypes::default_instance(), {GetField("optional_nested_enum")});
+  ASSERT_TRUE(transcoder.ok()) << transcoder.status();
+
+  TestAllTypes message;
+  Message* mutable_batch[] = {&message};
+  const int32_t in[] = {TestAllTypes::BAZ};
+  ASSERT_TRUE(transcoder->Scatter<int32_t>(0, in, mutable_batch).ok());
+  EXPECT_TRUE(message.has_optional_nested_enum());
+  EXPECT_EQ(TestAllTypes::BAZ, message.optional_nested_enum());
+
+  const Message* batch[] = {&message};
+  int32_t out = 0;
+  ASSERT_TRUE(
+      transcoder->Gather<int32_t>(0, batch, absl::MakeSpan(&out, 1)).ok());
+  EXPECT_EQ(TestAllTypes::BAZ, out);
+}
+
+TEST(ColumnTranscoderTest, RoundTrip) {
+  auto transcoder = ColumnTranscoder::Create(TestAllTypes::default_instance(),
+                                             {GetField("optional_uint32")});
+  ASSERT_TRUE(transcoder.ok()) << transcoder.status();
+
+  const uint32_t in[] = {0, 1, 0xffffffffu};
+  TestAllTypes messages[3];
+  Message* mutable_batch[] = {&messages[0], &messages[1], &messages[2]};
+  ASSERT_TRUE(transcoder->Scatter<uint32_t>(0, in, mutable_batch).ok());
+
+  const Message* batch[] = {&messages[0], &messages[1], &messages[2]};
+  std::vector<uint32_t> out(3);
+  ASSERT_TRUE(transcoder->Gather<uint32_t>(0, batch, absl::MakeSpan(out)).ok());
+  EXPECT_EQ(std::vector<uint32_t>(in, in + 3), out);
+}
+
+TEST(ColumnTranscoderTest, RejectsUnsupportedFields) {
+  const Message& prototype = TestAllTypes::default_instance();
+  EXPECT_FALSE(
+      ColumnTranscoder::Create(prototype, {GetField("repeated_int32")}).ok());
+  EXPECT_FALSE(
+      ColumnTranscoder::Create(prototype, {GetField("optional_string")}).ok());
+  EXPECT_FALSE(
+      ColumnTranscoder::Create(prototype, {GetField("optional_nested_message")})
+          .ok());
+  EXPECT_FALSE(
+      ColumnTranscoder::Create(prototype, {GetField("oneof_uint32")}).ok());
+  EXPECT_FALSE(
+      ColumnTranscoder::Create(
+          protobuf_unittest::ForeignMessage::default_instance(),
+          {GetField("optional_int32")})
+          .ok());
+}
+
+TEST(ColumnTranscoderTest, ChecksTypesAndSizes) {
+  auto transcoder = ColumnTranscoder::Create(TestAllTypes::default_instance(),
+                                             {GetField("optional_int32")});
+  ASSERT_TRUE(transcoder.ok()) << transcoder.status();
+
+  TestAllTypes message;
+  const Message* batch[] = {&message};
+  int64_t wrong_type = 0;
+  EXPECT_FALSE(
+      transcoder->Gather<int64_t>(0, batch, absl::MakeSpan(&wrong_type, 1))
+          .ok());
+  std::vector<int32_t> wrong_size(2);
+  EXPECT_FALSE(
+      transcoder->Gather<int32_t>(0, batch, absl::MakeSpan(wrong_size)).ok());
+  int32_t value = 0;
+  EXPECT_FALSE(
+      transcoder->Gather<int32_t>(1, batch, absl::MakeSpan(&value, 1)).ok());
+}
+
+TEST(ColumnTranscoderTest, RejectsForeignMessagesInBatch) {
+  auto transcoder = ColumnTranscoder::Create(TestAllTypes::default_instance(),
+                                             {GetField("optional_int32")});
+  ASSERT_TRUE(transcoder.ok()) << transcoder.status();
+
+  protobuf_unittest::ForeignMessage foreign;
+  const Message* batch[] = {&foreign};
+  int32_t value = 0;
+  EXPECT_FALSE(
+      transcoder->Gather<int32_t>(0, batch, absl::MakeSpan(&value, 1)).ok());
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,241 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/util/compression_dictionary.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/wire_format_lite.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+using ::google::protobuf::internal::WireFormatLite;
+
+std::string FieldPath(const std::string& prefix,
+                      const FieldDescriptor* field) {
+  std::string segment = field->is_extension()
+                            ? absl::StrCat("(", field->full_name(), ")")
+                            : std::string(field->name());
+  return prefix.empty() ? segment : absl::StrCat(prefix, ".", segment);
+}
+
+}  // namespace
+
+void CompressionDictionaryTrainer::AddMessage(const Message& message) {
+  ++message_count_;
+  SampleFields(message, "");
+}
+
+void CompressionDictionaryTrainer::SampleFields(const Message& message,
+                                                const std::string& prefix) {
+  const Reflection* reflection = message.GetReflection();
+  std::vector<const FieldDescriptor*> fields;
+  reflection->ListFields(message, &fields);
+  for (const FieldDescriptor* field : fields) {
+    const std::string path = FieldPath(prefix, field);
+    switch (field->cpp_type()) {
+      case FieldDescriptor::CPPTYPE_STRING: {
+        std::string scratch;
+        if (field->is_repeated()) {
+          const int count = reflection->FieldSize(message, field);
+          for (int i = 0; i < count; ++i) {
+            const std::string& value = reflection->GetRepeatedStringReference(
+                message, field, i, &scratch);
+            streams_[path].push_back(value);
+            ++value_stats_[value].count;
+          }
+        } else {
+          const std::string& value =
+              reflection->GetStringReference(message, field, &scratch);
+          streams_[path].push_back(value);
+          ++value_stats_[value].count;
+        }
+        break;
+      }
+      case FieldDescriptor::CPPTYPE_MESSAGE:
+        // Map entries walk like repeated messages, so map values sample
+        // under "mapfield.value".
+        if (field->is_repeated()) {
+          const int count = reflection->FieldSize(message, field);
+          for (int i = 0; i < count; ++i) {
+            SampleFields(reflection->GetRepeatedMessage(message, field, i),
+                         path);
+          }
+        } else {
+          SampleFields(reflection->GetMessage(message, field), path);
+        }
+        break;
+      default:
+        // Scalars are a few bytes each and rarely repeat as byte
+        // sequences long enough for a back-reference to win.
+        break;
+    }
+  }
+}
+
+std::vector<CompressionDictionaryTrainer::FieldSampleStream>
+CompressionDictionaryTrainer::ExtractSampleStreams() const {
+  std::vector<FieldSampleStream> result;
+  result.reserve(streams_.size());
+  for (const auto& entry : streams_) {
+    result.push_back({entry.first, entry.second});
+  }
+  std::sort(result.begin(), result.end(),
+            [](const FieldSampleStream& a, const FieldSampleStream& b) {
+              return a.path < b.path;
+            });
+  return result;
+}
+
+std::string CompressionDictionaryTrainer::TrainDictionary(
+    size_t max_bytes) const {
+  // A back-reference into the dictionary saves (occurrences - 1) * size
+  // bytes at best; values seen once save nothing and are excluded.
+  struct Candidate {
+    absl::string_view value;
+    int64_t savings;
+  };
+  std::vector<Candidate> candidates;
+  for (const auto& entry : value_stats_) {
+    if (entry.second.count < 2 || entry.first.empty()) continue;
+    candidates.push_back(
+        {entry.first,
+         (entry.second.count - 1) * static_cast<int64_t>(entry.first.size())});
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](const Candidate& a, const Candidate& b) {
+              if (a.savings != b.savings) return a.savings > b.savings;
+              return a.value < b.value;  // Deterministic output.
+            });
+
+  // Greedily take the most valuable values that fit.
+  std::vector<absl::string_view> taken;
+  size_t total = 0;
+  for (const Candidate& candidate : candidates) {
+    if (total + candidate.value.size() > max_bytes) continue;
+    taken.push_back(candidate.value);
+    total += candidate.value.size();
+  }
+
+  // Most valuable last: zlib's deflateSetDictionary() and zstd's
+  // raw-content dictionaries favor matches near the end of the window.
+  std::string dictionary;
+  dictionary.reserve(total);
+  for (auto it = taken.rbegin(); it != taken.rend(); ++it) {
+    dictionary.append(it->data(), it->size());
+  }
+  return dictionary;
+}
+
+namespace {
+
+// Nested messages deeper than this are copied without reordering rather
+// than recursed into, mirroring the parser's recursion limit.
+constexpr int kMaxReorderDepth = 100;
+
+bool ReorderMessage(const Descriptor* type, absl::string_view data,
+                    int depth, std::string* output) {
+  struct Span {
+    int number;
+    int start;
+    int value_start;  // Start of the payload of a recursable field, or -1.
+    int end;
+    const FieldDescriptor* field;
+  };
+  std::vector<Span> spans;
+
+  io::CodedInputStream input(reinterpret_cast<const uint8_t*>(data.data()),
+                             static_cast<int>(data.size()));
+  while (true) {
+    const int start = input.CurrentPosition();
+    const uint32_t tag = input.ReadTagNoLastTag();
+    if (tag == 0) {
+      // Valid only as end-of-input; a stray zero byte is malformed.
+      if (static_cast<size_t>(start) != data.size()) return false;
+      break;
+    }
+    if (WireFormatLite::GetTagWireType(tag) ==
+        WireFormatLite::WIRETYPE_END_GROUP) {
+      return false;
+    }
+    const int number = WireFormatLite::GetTagFieldNumber(tag);
+    const FieldDescriptor* field =
+        type != nullptr ? type->FindFieldByNumber(number) : nullptr;
+    int value_start = -1;
+    if (field != nullptr &&
+        field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE &&
+        field->type() == FieldDescriptor::TYPE_MESSAGE &&
+        WireFormatLite::GetTagWireType(tag) ==
+            WireFormatLite::WIRETYPE_LENGTH_DELIMITED &&
+        depth < kMaxReorderDepth) {
+      uint32_t length;
+      if (!input.ReadVarint32(&length)) return false;
+      value_start = input.CurrentPosition();
+      if (!input.Skip(static_cast<int>(length))) return false;
+    } else {
+      field = nullptr;
+      if (!WireFormatLite::SkipField(&input, tag)) return false;
+    }
+    spans.push_back({number, start, value_start, input.CurrentPosition(),
+                     field});
+  }
+
+  // Stable by field number: occurrences of one field become adjacent while
+  // their relative order -- repeated element order, last-wins for singular
+  // fields -- is preserved.
+  std::stable_sort(spans.begin(), spans.end(),
+                   [](const Span& a, const Span& b) {
+                     return a.number < b.number;
+                   });
+
+  for (const Span& span : spans) {
+    if (span.field == nullptr) {
+      output->append(data.data() + span.start, span.end - span.start);
+      continue;
+    }
+    // Tag and length prefix verbatim, then the recursively reordered
+    // payload; the permutation never changes lengths.
+    output->append(data.data() + span.start, span.value_start - span.start);
+    if (!ReorderMessage(span.field->message_type(),
+                        data.substr(span.value_start,
+                                    span.end - span.value_start),
+                        depth + 1, output)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+bool ReorderForCompressionAffinity(const Descriptor* type,
+                                   absl::string_view serialized,
+                                   std::string* output) {
+  output->clear();
+  output->reserve(serialized.size());
+  return type != nullptr && ReorderMessage(type, serialized, 0, output);
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
@@ -0,0 +1,114 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef GOOGLE_PROTOBUF_UTIL_COMPRESSION_DICTIONARY_H__
+#define GOOGLE_PROTOBUF_UTIL_COMPRESSION_DICTIONARY_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+// Trains schema-aware compression dictionaries from a message corpus.
+//
+// Generic dictionary trainers see serialized records as opaque bytes, so
+// the values that actually repeat across a corpus -- the same user agent
+// string in every record, the same enum of a handful of submessage shapes
+// -- compete with wire-format noise (tags, lengths, varints) for
+// dictionary space.  The trainer walks each corpus message with
+// reflection instead, so it samples field values with their framing
+// stripped and knows which field path each value came from.
+//
+// Two outputs are supported:
+//
+//  - ExtractSampleStreams() returns the per-field-path value streams, for
+//    feeding an external trainer (e.g. zstd's zdict) one column at a
+//    time.
+//  - TrainDictionary() builds a raw preset dictionary directly: distinct
+//    string/bytes values ranked by the bytes they would save, with the
+//    most valuable values last, the layout zlib's deflateSetDictionary()
+//    and zstd's raw-content dictionaries reward.
+//
+// Not thread-safe; train on one thread, share the resulting dictionary.
+class PROTOBUF_EXPORT CompressionDictionaryTrainer {
+ public:
+  CompressionDictionaryTrainer() = default;
+  CompressionDictionaryTrainer(const CompressionDictionaryTrainer&) = delete;
+  CompressionDictionaryTrainer& operator=(const CompressionDictionaryTrainer&) =
+      delete;
+
+  // Adds one corpus message.  All string and bytes fields are sampled,
+  // recursively through submessages, map entries and extensions; other
+  // field types contribute little to a dictionary and are skipped.
+  void AddMessage(const Message& message);
+
+  // One sampled value stream per dotted field path, e.g.
+  // "child.payload.name".  `values` holds each sampled value separately so
+  // a per-column trainer keeps the sample boundaries.
+  struct FieldSampleStream {
+    std::string path;
+    std::vector<std::string> values;
+  };
+
+  // Returns the value streams collected so far, sorted by path.
+  std::vector<FieldSampleStream> ExtractSampleStreams() const;
+
+  // Builds a raw preset dictionary of at most `max_bytes`.  Values are
+  // ranked by (occurrences - 1) * size -- the bytes a back-reference into
+  // the dictionary can save -- and emitted in ascending rank so the most
+  // valuable values sit at the end, closest to the window.  Values seen
+  // only once are never included.
+  std::string TrainDictionary(size_t max_bytes) const;
+
+  // Number of messages added so far.
+  int64_t message_count() const { return message_count_; }
+
+ private:
+  void SampleFields(const Message& message, const std::string& prefix);
+
+  struct ValueStats {
+    int64_t count = 0;
+  };
+
+  // Sampled values per dotted path, in sample order.
+  absl::flat_hash_map<std::string, std::vector<std::string>> streams_;
+  // Occurrence counts of distinct string/bytes values across all paths.
+  absl::flat_hash_map<std::string, ValueStats> value_stats_;
+  int64_t message_count_ = 0;
+};
+
+// Rewrites `serialized`, a wire-format message of `type`, so that all
+// occurrences of the same field are adjacent (stable-sorted by field
+// number), recursively through message-typed fields.  The result is the
+// same length and parses to the same message -- relative order within one
+// field number is preserved, so repeated element order and last-wins
+// semantics are unchanged -- but same-shaped bytes sit next to each
+// other, which compressors reward.  Returns false if `serialized` is
+// malformed, in which case `*output` is left in an unspecified state.
+PROTOBUF_EXPORT bool ReorderForCompressionAffinity(const Descriptor* type,
+                                                   absl::string_view serialized,
+                                                   std::string* output);
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_COMPRESSION_DICTIONARY_H__
@@ -0,0 +1,131 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/util/compression_dictionary.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "google/protobuf/unittest.pb.h"
+#include "google/protobuf/util/message_differencer.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+using protobuf_unittest::NestedTestAllTypes;
+using protobuf_unittest::TestAllTypes;
+
+TEST(CompressionDictionaryTrainerTest, ExtractsStreamsPerFieldPath) {
+  NestedTestAllTypes message;
+  message.mutable_payload()->set_optional_string("alpha");
+  message.mutable_payload()->add_repeated_string("beta");
+  message.mutable_payload()->add_repeated_string("gamma");
+  message.mutable_child()->mutable_payload()->set_optional_bytes("delta");
+
+  CompressionDictionaryTrainer trainer;
+  trainer.AddMessage(message);
+  EXPECT_EQ(1, trainer.message_count());
+
+  std::vector<CompressionDictionaryTrainer::FieldSampleStream> streams =
+      trainer.ExtractSampleStreams();
+  ASSERT_EQ(3, streams.size());
+  EXPECT_EQ("child.payload.optional_bytes", streams[0].path);
+  EXPECT_EQ(std::vector<std::string>{"delta"}, streams[0].values);
+  EXPECT_EQ("payload.optional_string", streams[1].path);
+  EXPECT_EQ(std::vector<std::string>{"alpha"}, streams[1].values);
+  EXPECT_EQ("payload.repeated_string", streams[2].path);
+  EXPECT_EQ((std::vector<std::string>{"beta", "gamma"}), streams[2].values);
+}
+
+TEST(CompressionDictionaryTrainerTest, RanksRepeatedValuesMostValuableLast) {
+  CompressionDictionaryTrainer trainer;
+  for (int i = 0; i < 3; ++i) {
+    TestAllTypes message;
+    message.set_optional_string("common");
+    if (i == 0) message.set_optional_bytes("seen-only-once-so-excluded");
+    if (i < 2) message.add_repeated_string("dup");
+    trainer.AddMessage(message);
+  }
+
+  // "common" saves (3 - 1) * 6 = 12 bytes, "dup" saves (2 - 1) * 3 = 3, so
+  // "common" is most valuable and must sit at the end of the dictionary.
+  // The singleton never appears.
+  EXPECT_EQ("dupcommon", trainer.TrainDictionary(64));
+
+  // A tight budget keeps only the most valuable value.
+  EXPECT_EQ("common", trainer.TrainDictionary(6));
+}
+
+TEST(CompressionDictionaryTest, ReorderGroupsFieldsAndPreservesSemantics) {
+  // Concatenating two serializations interleaves field numbers: the result
+  // is optional_string (14), then optional_int32 (1) -- out of order.
+  TestAllTypes first, second;
+  first.set_optional_string("payload");
+  second.set_optional_int32(7);
+  const std::string wire =
+      first.SerializeAsString() + second.SerializeAsString();
+
+  std::string reordered;
+  ASSERT_TRUE(ReorderForCompressionAffinity(TestAllTypes::descriptor(), wire,
+                                            &reordered));
+  EXPECT_EQ(wire.size(), reordered.size());
+  EXPECT_NE(wire, reordered);
+  // Field 1 (tag byte 0x08) now leads.
+  EXPECT_EQ('\x08', reordered[0]);
+
+  TestAllTypes from_wire, from_reordered;
+  ASSERT_TRUE(from_wire.ParseFromString(wire));
+  ASSERT_TRUE(from_reordered.ParseFromString(reordered));
+  EXPECT_TRUE(MessageDifferencer::Equals(from_wire, from_reordered));
+}
+
+TEST(CompressionDictionaryTest, ReorderRecursesIntoSubmessages) {
+  // The nested payload serializes its own fields out of order once two
+  // payloads are merged at the wire level.
+  TestAllTypes first, second;
+  first.set_optional_string("inner");
+  second.set_optional_int32(5);
+  NestedTestAllTypes outer;
+  outer.mutable_child();  // Field 1, serialized before payload (field 2).
+  const std::string inner_wire =
+      first.SerializeAsString() + second.SerializeAsString();
+  std::string wire = outer.SerializeAsString();
+  // Append payload (field 2, length-delimited) holding the merged bytes.
+  wire.push_back('\x12');
+  wire.push_back(static_cast<char>(inner_wire.size()));
+  wire += inner_wire;
+
+  std::string reordered;
+  ASSERT_TRUE(ReorderForCompressionAffinity(NestedTestAllTypes::descriptor(),
+                                            wire, &reordered));
+  EXPECT_EQ(wire.size(), reordered.size());
+
+  NestedTestAllTypes from_wire, from_reordered;
+  ASSERT_TRUE(from_wire.ParseFromString(wire));
+  ASSERT_TRUE(from_reordered.ParseFromString(reordered));
+  EXPECT_TRUE(MessageDifferencer::Equals(from_wire, from_reordered));
+  // The payload's own fields were regrouped, not copied verbatim.
+  EXPECT_NE(wire, reordered);
+}
+
+TEST(CompressionDictionaryTest, ReorderRejectsMalformedInput) {
+  std::string output;
+  // Truncated varint value.
+  EXPECT_FALSE(ReorderForCompressionAffinity(TestAllTypes::descriptor(),
+                                             "\x08", &output));
+  // Unmatched end-group tag.
+  EXPECT_FALSE(ReorderForCompressionAffinity(TestAllTypes::descriptor(),
+                                             "\x0c", &output));
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
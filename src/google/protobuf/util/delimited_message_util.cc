@@ -101,6 +101,28 @@ bool SerializeDelimitedToCodedStream(const MessageLite& message,
   return true;
 }
 
+bool SplitDelimitedMessages(absl::string_view data,
+                            std::vector<absl::string_view>* messages) {
+  const char* ptr = data.data();
+  const char* end = ptr + data.size();
+  while (ptr < end) {
+    // Decode the varint size prefix directly; CodedInputStream would copy
+    // and buffer, and this scan is the sequential bottleneck of a parallel
+    // batch decode.
+    uint64_t size = 0;
+    int shift = 0;
+    do {
+      if (ptr == end || shift >= 35) return false;
+      size |= static_cast<uint64_t>(*ptr & 0x7F) << shift;
+      shift += 7;
+    } while (*ptr++ & 0x80);
+    if (size > static_cast<uint64_t>(end - ptr)) return false;
+    messages->push_back(absl::string_view(ptr, static_cast<size_t>(size)));
+    ptr += size;
+  }
+  return true;
+}
+
 }  // namespace util
 }  // namespace protobuf
 }  // namespace google
@@ -12,7 +12,9 @@
 #define GOOGLE_PROTOBUF_UTIL_DELIMITED_MESSAGE_UTIL_H__
 
 #include <ostream>
+#include <vector>
 
+#include "absl/strings/string_view.h"
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl.h"
 #include "google/protobuf/message_lite.h"
@@ -76,6 +78,22 @@ bool PROTOBUF_EXPORT SerializeDelimitedToZeroCopyStream(
 bool PROTOBUF_EXPORT SerializeDelimitedToCodedStream(
     const MessageLite& message, io::CodedOutputStream* output);
 
+// Splits a flat buffer holding consecutive size-delimited messages into one
+// string_view per message payload (sizes stripped), without touching message
+// contents. The views alias |data|, so |data| must outlive them.
+//
+// This is the building block for parallel batch decoding: splitting is a
+// cheap sequential scan, after which each record can be handed to
+// MessageLite::ParseFromString (or a shared arena per shard) on whatever
+// thread pool the caller already owns. The protobuf runtime itself never
+// spawns threads.
+//
+// Returns false if the buffer ends mid-record or a size prefix is malformed;
+// |messages| then contains the records that were fully framed before the
+// error.
+bool PROTOBUF_EXPORT SplitDelimitedMessages(
+    absl::string_view data, std::vector<absl::string_view>* messages);
+
 }  // namespace util
 }  // namespace protobuf
 }  // namespace google
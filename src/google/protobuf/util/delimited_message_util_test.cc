@@ -88,6 +88,35 @@ TEST(DelimitedMessageUtilTest, FailsAtEndOfStream) {
   }
 }
 
+TEST(DelimitedMessageUtilTest, SplitDelimitedMessages) {
+  std::stringstream stream;
+  protobuf_unittest::ForeignMessage message1;
+  message1.set_c(42);
+  EXPECT_TRUE(SerializeDelimitedToOstream(message1, &stream));
+  protobuf_unittest::ForeignMessage message2;
+  message2.set_d(24);
+  EXPECT_TRUE(SerializeDelimitedToOstream(message2, &stream));
+
+  std::string data = stream.str();
+  std::vector<absl::string_view> records;
+  ASSERT_TRUE(SplitDelimitedMessages(data, &records));
+  ASSERT_EQ(records.size(), size_t{2});
+
+  // Each record parses independently, as a parallel batch decode would.
+  protobuf_unittest::ForeignMessage parsed;
+  EXPECT_TRUE(parsed.ParseFromString(records[0]));
+  EXPECT_EQ(parsed.c(), 42);
+  EXPECT_TRUE(parsed.ParseFromString(records[1]));
+  EXPECT_EQ(parsed.d(), 24);
+
+  // A truncated final record fails but keeps the complete ones.
+  records.clear();
+  EXPECT_FALSE(
+      SplitDelimitedMessages(absl::string_view(data.data(), data.size() - 1),
+                             &records));
+  EXPECT_EQ(records.size(), size_t{1});
+}
+
 }  // namespace util
 }  // namespace protobuf
 }  // namespace google
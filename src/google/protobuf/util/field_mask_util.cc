@@ -10,6 +10,7 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/container/btree_map.h"
@@ -21,7 +22,10 @@
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/strip.h"
+#include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/message.h"
+#include "google/protobuf/wire_format.h"
+#include "google/protobuf/wire_format_lite.h"
 
 // Must be included last.
 #include "google/protobuf/port_def.inc"
@@ -232,6 +236,15 @@ class FieldMaskTree {
     return TrimMessage(&root_, message);
   }
 
+  // Parses from the input only the fields specified by this tree, skipping
+  // everything else at the wire level. An empty tree parses the full message.
+  bool ParseMessage(io::CodedInputStream* input, Message* message) {
+    if (root_.children.empty()) {
+      return message->MergePartialFromCodedStream(input);
+    }
+    return ParseMessage(&root_, input, message);
+  }
+
  private:
   struct Node {
     Node() = default;
@@ -271,6 +284,10 @@ class FieldMaskTree {
   // Returns true if the message is actually modified
   bool TrimMessage(const Node* node, Message* message);
 
+  // Parses from the input only the fields specified by a sub-tree.
+  bool ParseMessage(const Node* node, io::CodedInputStream* input,
+                    Message* message);
+
   Node root_;
 };
 
@@ -594,6 +611,64 @@ bool FieldMaskTree::TrimMessage(const Node* node, Message* message) {
   return modified;
 }
 
+bool FieldMaskTree::ParseMessage(const Node* node, io::CodedInputStream* input,
+                                 Message* message) {
+  ABSL_DCHECK(!node->children.empty());
+  const Reflection* reflection = message->GetReflection();
+  const Descriptor* descriptor = message->GetDescriptor();
+  uint32_t tag;
+  while ((tag = input->ReadTagNoLastTag()) != 0) {
+    const FieldDescriptor* field = descriptor->FindFieldByNumber(
+        internal::WireFormatLite::GetTagFieldNumber(tag));
+    const Node* child = nullptr;
+    if (field != nullptr) {
+      auto it = node->children.find(field->name());
+      if (it != node->children.end()) {
+        child = it->second.get();
+      }
+    }
+    if (child == nullptr) {
+      // The field is not covered by the mask (or not known at all): discard
+      // its value without materializing it or recording it as unknown.
+      if (!internal::WireFormatLite::SkipField(input, tag)) {
+        return false;
+      }
+      continue;
+    }
+    if (!child->children.empty() && !field->is_repeated() &&
+        field->type() == FieldDescriptor::TYPE_MESSAGE &&
+        internal::WireFormatLite::GetTagWireType(tag) ==
+            internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+      // Only some sub-fields are selected: descend into the sub-message so
+      // its unselected fields are skipped at the wire level too.
+      uint32_t length;
+      if (!input->ReadVarint32(&length)) {
+        return false;
+      }
+      std::pair<io::CodedInputStream::Limit, int> p =
+          input->IncrementRecursionDepthAndPushLimit(length);
+      if (p.second < 0 ||
+          !ParseMessage(child, input,
+                        reflection->MutableMessage(message, field))) {
+        return false;
+      }
+      // Make sure that parsing stopped when the limit was hit, not at an
+      // endgroup tag.
+      if (!input->DecrementRecursionDepthAndPopLimit(p.first)) {
+        return false;
+      }
+      continue;
+    }
+    // A leaf node selects the whole field; parse it normally. This branch
+    // also handles shapes sub-paths cannot descend into (groups, repeated
+    // message fields).
+    if (!internal::WireFormat::ParseAndMergeField(tag, field, message, input)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 }  // namespace
 
 void FieldMaskUtil::ToCanonicalForm(const FieldMask& mask, FieldMask* out) {
@@ -676,6 +751,17 @@ bool FieldMaskUtil::TrimMessage(const FieldMask& mask, Message* message) {
   return tree.TrimMessage(ABSL_DIE_IF_NULL(message));
 }
 
+bool FieldMaskUtil::ParseWithMask(io::ZeroCopyInputStream* input,
+                                  const FieldMask& mask, Message* message) {
+  ABSL_DIE_IF_NULL(message)->Clear();
+  // Build a FieldMaskTree and walk through the wire format, parsing only the
+  // fields it specifies.
+  FieldMaskTree tree;
+  tree.MergeFromFieldMask(mask);
+  io::CodedInputStream coded_input(input);
+  return tree.ParseMessage(&coded_input, message);
+}
+
 bool FieldMaskUtil::TrimMessage(const FieldMask& mask, Message* message,
                                 const TrimOptions& options) {
   // Build a FieldMaskTree and walk through the tree to merge all specified
@@ -18,6 +18,7 @@
 #include "absl/log/absl_check.h"
 #include "absl/strings/string_view.h"
 #include "google/protobuf/descriptor.h"
+#include "google/protobuf/io/zero_copy_stream.h"
 
 // Must be included last.
 #include "google/protobuf/port_def.inc"
@@ -158,6 +159,18 @@ class PROTOBUF_EXPORT FieldMaskUtil {
   static bool TrimMessage(const FieldMask& mask, Message* message,
                           const TrimOptions& options);
 
+  // Clears 'message' and parses it from 'input', materializing only the
+  // fields represented in the given FieldMask. Fields outside the mask are
+  // skipped at the wire level without being parsed or recorded as unknown
+  // fields, which is much cheaper than parsing the full message and calling
+  // TrimMessage() when only a small slice of a wide message is needed.
+  // If the FieldMask is empty, the whole message is parsed.
+  // Uses partial-parse semantics: missing required fields do not cause a
+  // failure (the mask may well exclude them). Returns false if the input is
+  // malformed.
+  static bool ParseWithMask(io::ZeroCopyInputStream* input,
+                            const FieldMask& mask, Message* message);
+
  private:
   friend class SnakeCaseCamelCaseTest;
   // Converts a field name from snake_case to camelCase:
@@ -9,10 +9,12 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <string>
 #include <vector>
 
 #include "google/protobuf/field_mask.pb.h"
 #include <gtest/gtest.h>
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include "google/protobuf/test_util.h"
 #include "google/protobuf/unittest.pb.h"
 
@@ -804,6 +806,67 @@ TEST(FieldMaskUtilTest, TrimMessageReturnValue) {
   // supported.
 }
 
+TEST(FieldMaskUtilTest, ParseWithMask) {
+  TestAllTypes src;
+  TestUtil::SetAllFields(&src);
+  std::string data;
+  ASSERT_TRUE(src.SerializeToString(&data));
+
+  // Parsing with a mask gives the same result as a full parse followed by
+  // TrimMessage(), without ever materializing the unselected fields.
+  FieldMask mask;
+  FieldMaskUtil::FromString(
+      "optional_int32,optional_string,optional_nested_message,repeated_int32",
+      &mask);
+  TestAllTypes expected(src);
+  FieldMaskUtil::TrimMessage(mask, &expected);
+
+  TestAllTypes parsed;
+  io::ArrayInputStream input(data.data(), data.size());
+  ASSERT_TRUE(FieldMaskUtil::ParseWithMask(&input, mask, &parsed));
+  EXPECT_EQ(expected.DebugString(), parsed.DebugString());
+
+  // An empty mask parses the whole message.
+  FieldMask empty_mask;
+  io::ArrayInputStream full_input(data.data(), data.size());
+  ASSERT_TRUE(FieldMaskUtil::ParseWithMask(&full_input, empty_mask, &parsed));
+  EXPECT_EQ(src.DebugString(), parsed.DebugString());
+}
+
+TEST(FieldMaskUtilTest, ParseWithMaskNestedPaths) {
+  NestedTestAllTypes msg;
+  msg.mutable_child()->mutable_payload()->set_optional_int32(1234);
+  msg.mutable_child()->mutable_payload()->set_optional_string("abc");
+  msg.mutable_payload()->set_optional_int32(5678);
+  std::string data;
+  ASSERT_TRUE(msg.SerializeToString(&data));
+
+  // Sub-paths descend into the sub-message, so its unselected fields are
+  // skipped at the wire level as well.
+  FieldMask mask;
+  FieldMaskUtil::FromString("child.payload.optional_int32", &mask);
+  NestedTestAllTypes parsed;
+  io::ArrayInputStream input(data.data(), data.size());
+  ASSERT_TRUE(FieldMaskUtil::ParseWithMask(&input, mask, &parsed));
+  EXPECT_EQ(parsed.child().payload().optional_int32(), 1234);
+  EXPECT_FALSE(parsed.child().payload().has_optional_string());
+  EXPECT_FALSE(parsed.has_payload());
+}
+
+TEST(FieldMaskUtilTest, ParseWithMaskMalformedInput) {
+  TestAllTypes src;
+  src.set_optional_string("hello world");
+  std::string data;
+  ASSERT_TRUE(src.SerializeToString(&data));
+  // Truncate the input inside the selected field's value.
+  data.resize(data.size() - 1);
+
+  FieldMask mask;
+  FieldMaskUtil::FromString("optional_string", &mask);
+  TestAllTypes parsed;
+  io::ArrayInputStream input(data.data(), data.size());
+  EXPECT_FALSE(FieldMaskUtil::ParseWithMask(&input, mask, &parsed));
+}
 
 }  // namespace
 }  // namespace util
@@ -0,0 +1,566 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/util/flat_message.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "absl/base/casts.h"
+#include "absl/log/absl_check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+// Buffer layout (all integers native-endian; the format is intra-host only):
+//
+//   uint32 magic
+//   uint32 entry_count
+//   entry_count x 16-byte entries, sorted by field number:
+//     uint32 number, uint8 kind, uint8 cpp_type, uint16 reserved,
+//     uint64 payload
+//   8-byte aligned out-of-line blocks
+//
+// Scalars store their value bit pattern directly in `payload` (integers
+// sign-extended to 64 bits, floats bit-cast). All other kinds store an
+// offset, relative to the start of the flat message, to a block:
+//
+//   string:           uint64 size, then the bytes, padded to 8
+//   message:          a complete nested flat message
+//   repeated scalar:  uint64 count, then count 8-byte value slots
+//   repeated string:  uint64 count, then count uint64 offsets to string
+//                     blocks
+//   repeated message: uint64 count, then count uint64 offsets to nested flat
+//                     messages
+constexpr uint32_t kMagic = 0x74616c66;  // "flat"
+constexpr size_t kHeaderSize = 8;
+constexpr size_t kEntrySize = 16;
+
+enum class FieldKind : uint8_t {
+  kScalar = 0,
+  kString = 1,
+  kMessage = 2,
+  kRepeatedScalar = 3,
+  kRepeatedString = 4,
+  kRepeatedMessage = 5,
+};
+
+struct Entry {
+  uint32_t number;
+  FieldKind kind;
+  uint8_t cpp_type;
+  uint64_t payload;
+};
+
+template <typename T>
+T LoadAs(absl::string_view data, size_t offset) {
+  T value;
+  ABSL_DCHECK_LE(offset + sizeof(T), data.size());
+  memcpy(&value, data.data() + offset, sizeof(T));
+  return value;
+}
+
+Entry LoadEntry(absl::string_view data, int index) {
+  const size_t pos = kHeaderSize + static_cast<size_t>(index) * kEntrySize;
+  Entry entry;
+  entry.number = LoadAs<uint32_t>(data, pos);
+  entry.kind = static_cast<FieldKind>(LoadAs<uint8_t>(data, pos + 4));
+  entry.cpp_type = LoadAs<uint8_t>(data, pos + 5);
+  entry.payload = LoadAs<uint64_t>(data, pos + 8);
+  return entry;
+}
+
+int EntryCount(absl::string_view data) {
+  return static_cast<int>(LoadAs<uint32_t>(data, 4));
+}
+
+// Binary search over the number-sorted field table. Returns -1 if absent.
+int FindEntryIndex(absl::string_view data, int number) {
+  int lo = 0;
+  int hi = EntryCount(data) - 1;
+  while (lo <= hi) {
+    const int mid = lo + (hi - lo) / 2;
+    const uint32_t mid_number = LoadAs<uint32_t>(
+        data, kHeaderSize + static_cast<size_t>(mid) * kEntrySize);
+    if (mid_number == static_cast<uint32_t>(number)) return mid;
+    if (mid_number < static_cast<uint32_t>(number)) {
+      lo = mid + 1;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  return -1;
+}
+
+FieldKind KindFor(const FieldDescriptor* field) {
+  if (field->is_repeated()) {
+    switch (field->cpp_type()) {
+      case FieldDescriptor::CPPTYPE_STRING:
+        return FieldKind::kRepeatedString;
+      case FieldDescriptor::CPPTYPE_MESSAGE:
+        return FieldKind::kRepeatedMessage;
+      default:
+        return FieldKind::kRepeatedScalar;
+    }
+  }
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_STRING:
+      return FieldKind::kString;
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      return FieldKind::kMessage;
+    default:
+      return FieldKind::kScalar;
+  }
+}
+
+void AppendU64(std::string* out, uint64_t value) {
+  out->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void StoreU64(std::string* out, size_t pos, uint64_t value) {
+  memcpy(&(*out)[pos], &value, sizeof(value));
+}
+
+// Pads `out` so the next append lands on an 8-byte boundary relative to
+// `base`, the start of the flat message being built.
+void PadTo8(std::string* out, size_t base) {
+  while ((out->size() - base) % 8 != 0) out->push_back('\0');
+}
+
+// Returns the 64-bit slot encoding of a scalar value; `index` is -1 for
+// singular fields.
+uint64_t ScalarSlot(const Message& message, const Reflection* reflection,
+                    const FieldDescriptor* field, int index) {
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      return static_cast<uint64_t>(static_cast<int64_t>(
+          index < 0 ? reflection->GetInt32(message, field)
+                    : reflection->GetRepeatedInt32(message, field, index)));
+    case FieldDescriptor::CPPTYPE_INT64:
+      return static_cast<uint64_t>(
+          index < 0 ? reflection->GetInt64(message, field)
+                    : reflection->GetRepeatedInt64(message, field, index));
+    case FieldDescriptor::CPPTYPE_UINT32:
+      return index < 0
+                 ? reflection->GetUInt32(message, field)
+                 : reflection->GetRepeatedUInt32(message, field, index);
+    case FieldDescriptor::CPPTYPE_UINT64:
+      return index < 0
+                 ? reflection->GetUInt64(message, field)
+                 : reflection->GetRepeatedUInt64(message, field, index);
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      return absl::bit_cast<uint32_t>(
+          index < 0 ? reflection->GetFloat(message, field)
+                    : reflection->GetRepeatedFloat(message, field, index));
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      return absl::bit_cast<uint64_t>(
+          index < 0 ? reflection->GetDouble(message, field)
+                    : reflection->GetRepeatedDouble(message, field, index));
+    case FieldDescriptor::CPPTYPE_BOOL:
+      return (index < 0 ? reflection->GetBool(message, field)
+                        : reflection->GetRepeatedBool(message, field, index))
+                 ? 1
+                 : 0;
+    case FieldDescriptor::CPPTYPE_ENUM:
+      return static_cast<uint64_t>(static_cast<int64_t>(
+          index < 0
+              ? reflection->GetEnumValue(message, field)
+              : reflection->GetRepeatedEnumValue(message, field, index)));
+    default:
+      ABSL_DCHECK(false) << "not a scalar: " << field->full_name();
+      return 0;
+  }
+}
+
+// Appends a string block and returns its offset relative to `base`.
+uint64_t AppendStringBlock(std::string* out, size_t base,
+                           absl::string_view value) {
+  PadTo8(out, base);
+  const uint64_t offset = out->size() - base;
+  AppendU64(out, value.size());
+  out->append(value.data(), value.size());
+  PadTo8(out, base);
+  return offset;
+}
+
+}  // namespace
+
+absl::Status FlattenMessage(const Message& message, std::string* output) {
+  const size_t base = output->size();
+  const Reflection* reflection = message.GetReflection();
+  const Descriptor* descriptor = message.GetDescriptor();
+
+  std::vector<const FieldDescriptor*> fields;
+  fields.reserve(descriptor->field_count());
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    const FieldDescriptor* field = descriptor->field(i);
+    const bool present = field->is_repeated()
+                             ? reflection->FieldSize(message, field) > 0
+                             : reflection->HasField(message, field);
+    if (present) fields.push_back(field);
+  }
+  std::sort(fields.begin(), fields.end(),
+            [](const FieldDescriptor* a, const FieldDescriptor* b) {
+              return a->number() < b->number();
+            });
+
+  const uint32_t count = static_cast<uint32_t>(fields.size());
+  output->append(reinterpret_cast<const char*>(&kMagic), sizeof(kMagic));
+  output->append(reinterpret_cast<const char*>(&count), sizeof(count));
+  const size_t table = output->size();
+  output->resize(table + fields.size() * kEntrySize);
+
+  for (size_t i = 0; i < fields.size(); ++i) {
+    const FieldDescriptor* field = fields[i];
+    const size_t pos = table + i * kEntrySize;
+    const uint32_t number = static_cast<uint32_t>(field->number());
+    memcpy(&(*output)[pos], &number, sizeof(number));
+    (*output)[pos + 4] = static_cast<char>(KindFor(field));
+    (*output)[pos + 5] = static_cast<char>(field->cpp_type());
+  }
+
+  for (size_t i = 0; i < fields.size(); ++i) {
+    const FieldDescriptor* field = fields[i];
+    const size_t payload_pos = table + i * kEntrySize + 8;
+    switch (KindFor(field)) {
+      case FieldKind::kScalar:
+        StoreU64(output, payload_pos,
+                 ScalarSlot(message, reflection, field, -1));
+        break;
+      case FieldKind::kString: {
+        std::string scratch;
+        const uint64_t offset = AppendStringBlock(
+            output, base,
+            reflection->GetStringReference(message, field, &scratch));
+        StoreU64(output, payload_pos, offset);
+        break;
+      }
+      case FieldKind::kMessage: {
+        PadTo8(output, base);
+        const uint64_t offset = output->size() - base;
+        absl::Status status =
+            FlattenMessage(reflection->GetMessage(message, field), output);
+        if (!status.ok()) return status;
+        StoreU64(output, payload_pos, offset);
+        break;
+      }
+      case FieldKind::kRepeatedScalar: {
+        PadTo8(output, base);
+        const uint64_t offset = output->size() - base;
+        const int size = reflection->FieldSize(message, field);
+        AppendU64(output, static_cast<uint64_t>(size));
+        for (int j = 0; j < size; ++j) {
+          AppendU64(output, ScalarSlot(message, reflection, field, j));
+        }
+        StoreU64(output, payload_pos, offset);
+        break;
+      }
+      case FieldKind::kRepeatedString: {
+        PadTo8(output, base);
+        const uint64_t offset = output->size() - base;
+        const int size = reflection->FieldSize(message, field);
+        AppendU64(output, static_cast<uint64_t>(size));
+        const size_t slots = output->size();
+        output->resize(slots + static_cast<size_t>(size) * 8);
+        for (int j = 0; j < size; ++j) {
+          std::string scratch;
+          const uint64_t element_offset = AppendStringBlock(
+              output, base,
+              reflection->GetRepeatedStringReference(message, field, j,
+                                                     &scratch));
+          StoreU64(output, slots + static_cast<size_t>(j) * 8,
+                   element_offset);
+        }
+        StoreU64(output, payload_pos, offset);
+        break;
+      }
+      case FieldKind::kRepeatedMessage: {
+        PadTo8(output, base);
+        const uint64_t offset = output->size() - base;
+        const int size = reflection->FieldSize(message, field);
+        AppendU64(output, static_cast<uint64_t>(size));
+        const size_t slots = output->size();
+        output->resize(slots + static_cast<size_t>(size) * 8);
+        for (int j = 0; j < size; ++j) {
+          PadTo8(output, base);
+          const uint64_t element_offset = output->size() - base;
+          absl::Status status = FlattenMessage(
+              reflection->GetRepeatedMessage(message, field, j), output);
+          if (!status.ok()) return status;
+          StoreU64(output, slots + static_cast<size_t>(j) * 8,
+                   element_offset);
+        }
+        StoreU64(output, payload_pos, offset);
+        break;
+      }
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<FlatMessageView> FlatMessageView::Create(
+    absl::string_view data) {
+  if (data.size() < kHeaderSize) {
+    return absl::InvalidArgumentError("flat message buffer too short");
+  }
+  uint32_t magic;
+  memcpy(&magic, data.data(), sizeof(magic));
+  if (magic != kMagic) {
+    return absl::InvalidArgumentError("bad flat message magic");
+  }
+  uint32_t count;
+  memcpy(&count, data.data() + 4, sizeof(count));
+  if (kHeaderSize + static_cast<size_t>(count) * kEntrySize > data.size()) {
+    return absl::InvalidArgumentError("flat message field table out of range");
+  }
+  return FlatMessageView(data);
+}
+
+bool FlatMessageView::Has(int field_number) const {
+  return FindEntryIndex(data_, field_number) >= 0;
+}
+
+int FlatMessageView::RepeatedSize(int field_number) const {
+  const int index = FindEntryIndex(data_, field_number);
+  if (index < 0) return 0;
+  const Entry entry = LoadEntry(data_, index);
+  return static_cast<int>(LoadAs<uint64_t>(data_, entry.payload));
+}
+
+uint64_t FlatMessageView::EntryPayload(int field_number) const {
+  const int index = FindEntryIndex(data_, field_number);
+  ABSL_DCHECK_GE(index, 0) << "absent field " << field_number;
+  return LoadEntry(data_, index).payload;
+}
+
+uint64_t FlatMessageView::RepeatedSlot(int field_number, int index) const {
+  const uint64_t offset = EntryPayload(field_number);
+  ABSL_DCHECK_LT(static_cast<uint64_t>(index),
+                 LoadAs<uint64_t>(data_, offset));
+  return LoadAs<uint64_t>(data_,
+                          offset + 8 + static_cast<uint64_t>(index) * 8);
+}
+
+int32_t FlatMessageView::GetInt32(int field_number) const {
+  return static_cast<int32_t>(EntryPayload(field_number));
+}
+int64_t FlatMessageView::GetInt64(int field_number) const {
+  return static_cast<int64_t>(EntryPayload(field_number));
+}
+uint32_t FlatMessageView::GetUInt32(int field_number) const {
+  return static_cast<uint32_t>(EntryPayload(field_number));
+}
+uint64_t FlatMessageView::GetUInt64(int field_number) const {
+  return EntryPayload(field_number);
+}
+float FlatMessageView::GetFloat(int field_number) const {
+  return absl::bit_cast<float>(
+      static_cast<uint32_t>(EntryPayload(field_number)));
+}
+double FlatMessageView::GetDouble(int field_number) const {
+  return absl::bit_cast<double>(EntryPayload(field_number));
+}
+bool FlatMessageView::GetBool(int field_number) const {
+  return EntryPayload(field_number) != 0;
+}
+int FlatMessageView::GetEnumValue(int field_number) const {
+  return static_cast<int>(static_cast<int64_t>(EntryPayload(field_number)));
+}
+
+absl::string_view FlatMessageView::GetString(int field_number) const {
+  const uint64_t offset = EntryPayload(field_number);
+  const uint64_t size = LoadAs<uint64_t>(data_, offset);
+  return data_.substr(offset + 8, size);
+}
+
+FlatMessageView FlatMessageView::GetMessage(int field_number) const {
+  return FlatMessageView(data_.substr(EntryPayload(field_number)));
+}
+
+int32_t FlatMessageView::GetRepeatedInt32(int field_number, int index) const {
+  return static_cast<int32_t>(RepeatedSlot(field_number, index));
+}
+int64_t FlatMessageView::GetRepeatedInt64(int field_number, int index) const {
+  return static_cast<int64_t>(RepeatedSlot(field_number, index));
+}
+uint32_t FlatMessageView::GetRepeatedUInt32(int field_number,
+                                            int index) const {
+  return static_cast<uint32_t>(RepeatedSlot(field_number, index));
+}
+uint64_t FlatMessageView::GetRepeatedUInt64(int field_number,
+                                            int index) const {
+  return RepeatedSlot(field_number, index);
+}
+float FlatMessageView::GetRepeatedFloat(int field_number, int index) const {
+  return absl::bit_cast<float>(
+      static_cast<uint32_t>(RepeatedSlot(field_number, index)));
+}
+double FlatMessageView::GetRepeatedDouble(int field_number, int index) const {
+  return absl::bit_cast<double>(RepeatedSlot(field_number, index));
+}
+bool FlatMessageView::GetRepeatedBool(int field_number, int index) const {
+  return RepeatedSlot(field_number, index) != 0;
+}
+int FlatMessageView::GetRepeatedEnumValue(int field_number, int index) const {
+  return static_cast<int>(
+      static_cast<int64_t>(RepeatedSlot(field_number, index)));
+}
+
+absl::string_view FlatMessageView::GetRepeatedString(int field_number,
+                                                     int index) const {
+  const uint64_t offset = RepeatedSlot(field_number, index);
+  const uint64_t size = LoadAs<uint64_t>(data_, offset);
+  return data_.substr(offset + 8, size);
+}
+
+FlatMessageView FlatMessageView::GetRepeatedMessage(int field_number,
+                                                    int index) const {
+  return FlatMessageView(data_.substr(RepeatedSlot(field_number, index)));
+}
+
+absl::Status FlatMessageView::UnflattenTo(Message* message) const {
+  message->Clear();
+  const Reflection* reflection = message->GetReflection();
+  const Descriptor* descriptor = message->GetDescriptor();
+  const int count = EntryCount(data_);
+  for (int i = 0; i < count; ++i) {
+    const Entry entry = LoadEntry(data_, i);
+    const FieldDescriptor* field =
+        descriptor->FindFieldByNumber(static_cast<int>(entry.number));
+    // Skip numbers the target schema does not know, so a reader built from a
+    // slightly older schema still accepts the buffer.
+    if (field == nullptr) continue;
+    if (KindFor(field) != entry.kind ||
+        static_cast<uint8_t>(field->cpp_type()) != entry.cpp_type) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("flat message type mismatch for field ",
+                       field->full_name()));
+    }
+    const int number = static_cast<int>(entry.number);
+    switch (entry.kind) {
+      case FieldKind::kScalar:
+        switch (field->cpp_type()) {
+          case FieldDescriptor::CPPTYPE_INT32:
+            reflection->SetInt32(message, field, GetInt32(number));
+            break;
+          case FieldDescriptor::CPPTYPE_INT64:
+            reflection->SetInt64(message, field, GetInt64(number));
+            break;
+          case FieldDescriptor::CPPTYPE_UINT32:
+            reflection->SetUInt32(message, field, GetUInt32(number));
+            break;
+          case FieldDescriptor::CPPTYPE_UINT64:
+            reflection->SetUInt64(message, field, GetUInt64(number));
+            break;
+          case FieldDescriptor::CPPTYPE_FLOAT:
+            reflection->SetFloat(message, field, GetFloat(number));
+            break;
+          case FieldDescriptor::CPPTYPE_DOUBLE:
+            reflection->SetDouble(message, field, GetDouble(number));
+            break;
+          case FieldDescriptor::CPPTYPE_BOOL:
+            reflection->SetBool(message, field, GetBool(number));
+            break;
+          case FieldDescriptor::CPPTYPE_ENUM:
+            reflection->SetEnumValue(message, field, GetEnumValue(number));
+            break;
+          default:
+            break;
+        }
+        break;
+      case FieldKind::kString:
+        reflection->SetString(message, field, std::string(GetString(number)));
+        break;
+      case FieldKind::kMessage: {
+        absl::Status status = GetMessage(number).UnflattenTo(
+            reflection->MutableMessage(message, field));
+        if (!status.ok()) return status;
+        break;
+      }
+      case FieldKind::kRepeatedScalar: {
+        const int size = RepeatedSize(number);
+        for (int j = 0; j < size; ++j) {
+          switch (field->cpp_type()) {
+            case FieldDescriptor::CPPTYPE_INT32:
+              reflection->AddInt32(message, field,
+                                   GetRepeatedInt32(number, j));
+              break;
+            case FieldDescriptor::CPPTYPE_INT64:
+              reflection->AddInt64(message, field,
+                                   GetRepeatedInt64(number, j));
+              break;
+            case FieldDescriptor::CPPTYPE_UINT32:
+              reflection->AddUInt32(message, field,
+                                    GetRepeatedUInt32(number, j));
+              break;
+            case FieldDescriptor::CPPTYPE_UINT64:
+              reflection->AddUInt64(message, field,
+                                    GetRepeatedUInt64(number, j));
+              break;
+            case FieldDescriptor::CPPTYPE_FLOAT:
+              reflection->AddFloat(message, field,
+                                   GetRepeatedFloat(number, j));
+              break;
+            case FieldDescriptor::CPPTYPE_DOUBLE:
+              reflection->AddDouble(message, field,
+                                    GetRepeatedDouble(number, j));
+              break;
+            case FieldDescriptor::CPPTYPE_BOOL:
+              reflection->AddBool(message, field, GetRepeatedBool(number, j));
+              break;
+            case FieldDescriptor::CPPTYPE_ENUM:
+              reflection->AddEnumValue(message, field,
+                                       GetRepeatedEnumValue(number, j));
+              break;
+            default:
+              break;
+          }
+        }
+        break;
+      }
+      case FieldKind::kRepeatedString: {
+        const int size = RepeatedSize(number);
+        for (int j = 0; j < size; ++j) {
+          reflection->AddString(message, field,
+                                std::string(GetRepeatedString(number, j)));
+        }
+        break;
+      }
+      case FieldKind::kRepeatedMessage: {
+        const int size = RepeatedSize(number);
+        for (int j = 0; j < size; ++j) {
+          absl::Status status = GetRepeatedMessage(number, j).UnflattenTo(
+              reflection->AddMessage(message, field));
+          if (!status.ok()) return status;
+        }
+        break;
+      }
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
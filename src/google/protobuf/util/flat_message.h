@@ -0,0 +1,112 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+//
+// A flat serialization format for protobuf messages that can be read in
+// place, without a parse step. Intended for trusted intra-host transports
+// (shared memory, UDS) where both sides share the schema and the decode cost
+// of standard wire format dominates.
+//
+// The layout is a header plus a field table sorted by field number. Scalar
+// values are stored inline in their table entry; strings, sub-messages and
+// repeated fields are stored out of line behind 8-byte aligned offsets, so a
+// reader backed by an 8-byte aligned buffer performs naturally aligned
+// accesses and string values can be exposed as string_views directly over the
+// buffer.
+//
+// Restrictions: extensions and unknown fields are not represented and are
+// silently dropped when flattening. The format is not a wire-compatibility
+// surface; both endpoints must be built from the same source tree.
+
+#ifndef GOOGLE_PROTOBUF_UTIL_FLAT_MESSAGE_H__
+#define GOOGLE_PROTOBUF_UTIL_FLAT_MESSAGE_H__
+
+#include <cstdint>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/message.h"
+#include "google/protobuf/port.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+// Serializes `message` into the flat format, appending to `*output`.
+// Extensions and unknown fields are dropped.
+PROTOBUF_EXPORT absl::Status FlattenMessage(const Message& message,
+                                            std::string* output);
+
+// A read-only view over a flat-format buffer. The view does not own the
+// buffer; it must outlive the view. Accessors take field numbers and assume
+// the caller asks for the type the schema declares (enforced with debug
+// checks only, as the transport is trusted).
+class PROTOBUF_EXPORT FlatMessageView {
+ public:
+  // Validates the header and field table and returns a view over `data`.
+  static absl::StatusOr<FlatMessageView> Create(absl::string_view data);
+
+  // Returns true if the singular field `field_number` is present.
+  bool Has(int field_number) const;
+
+  // Returns the element count of the repeated field `field_number`, or 0 if
+  // it is absent.
+  int RepeatedSize(int field_number) const;
+
+  // Singular accessors. The field must be present (see Has()).
+  int32_t GetInt32(int field_number) const;
+  int64_t GetInt64(int field_number) const;
+  uint32_t GetUInt32(int field_number) const;
+  uint64_t GetUInt64(int field_number) const;
+  float GetFloat(int field_number) const;
+  double GetDouble(int field_number) const;
+  bool GetBool(int field_number) const;
+  int GetEnumValue(int field_number) const;
+  // The returned view aliases the underlying buffer.
+  absl::string_view GetString(int field_number) const;
+  FlatMessageView GetMessage(int field_number) const;
+
+  // Repeated accessors. `index` must be in [0, RepeatedSize(field_number)).
+  int32_t GetRepeatedInt32(int field_number, int index) const;
+  int64_t GetRepeatedInt64(int field_number, int index) const;
+  uint32_t GetRepeatedUInt32(int field_number, int index) const;
+  uint64_t GetRepeatedUInt64(int field_number, int index) const;
+  float GetRepeatedFloat(int field_number, int index) const;
+  double GetRepeatedDouble(int field_number, int index) const;
+  bool GetRepeatedBool(int field_number, int index) const;
+  int GetRepeatedEnumValue(int field_number, int index) const;
+  absl::string_view GetRepeatedString(int field_number, int index) const;
+  FlatMessageView GetRepeatedMessage(int field_number, int index) const;
+
+  // Reconstructs a standard message from the view using reflection. Entries
+  // whose field number is unknown to the target descriptor are skipped, so a
+  // reader built from a slightly newer schema still works. Returns an error
+  // if a field number is known but its type does not match.
+  absl::Status UnflattenTo(Message* message) const;
+
+ private:
+  explicit FlatMessageView(absl::string_view data) : data_(data) {}
+
+  // Returns the raw 64-bit payload of the entry for `field_number`, which
+  // must exist. Scalars store their value here; everything else an offset.
+  uint64_t EntryPayload(int field_number) const;
+  uint64_t RepeatedSlot(int field_number, int index) const;
+
+  absl::string_view data_;
+};
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_FLAT_MESSAGE_H__
@@ -0,0 +1,126 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/util/flat_message.h"
+
+#include <string>
+
+#include <gtest/gtest.h>
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/test_util.h"
+#include "google/protobuf/unittest.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+TEST(FlatMessageTest, RoundTripsAllFields) {
+  protobuf_unittest::TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+
+  std::string buffer;
+  ASSERT_TRUE(FlattenMessage(message, &buffer).ok());
+
+  absl::StatusOr<FlatMessageView> view = FlatMessageView::Create(buffer);
+  ASSERT_TRUE(view.ok()) << view.status();
+
+  protobuf_unittest::TestAllTypes restored;
+  ASSERT_TRUE(view->UnflattenTo(&restored).ok());
+  TestUtil::ExpectAllFieldsSet(restored);
+}
+
+TEST(FlatMessageTest, ReadsFieldsInPlace) {
+  protobuf_unittest::TestAllTypes message;
+  message.set_optional_int32(101);
+  message.set_optional_string("hello flat world");
+  message.mutable_optional_nested_message()->set_bb(42);
+  message.add_repeated_int32(7);
+  message.add_repeated_int32(8);
+  message.add_repeated_string("one");
+  message.add_repeated_string("two");
+
+  std::string buffer;
+  ASSERT_TRUE(FlattenMessage(message, &buffer).ok());
+
+  absl::StatusOr<FlatMessageView> view = FlatMessageView::Create(buffer);
+  ASSERT_TRUE(view.ok()) << view.status();
+
+  EXPECT_TRUE(view->Has(protobuf_unittest::TestAllTypes::kOptionalInt32FieldNumber));
+  EXPECT_FALSE(view->Has(protobuf_unittest::TestAllTypes::kOptionalInt64FieldNumber));
+  EXPECT_EQ(view->GetInt32(
+                protobuf_unittest::TestAllTypes::kOptionalInt32FieldNumber),
+            101);
+
+  const absl::string_view str = view->GetString(
+      protobuf_unittest::TestAllTypes::kOptionalStringFieldNumber);
+  EXPECT_EQ(str, "hello flat world");
+  // The string aliases the flat buffer: no copy happened.
+  EXPECT_GE(str.data(), buffer.data());
+  EXPECT_LT(str.data(), buffer.data() + buffer.size());
+
+  const FlatMessageView nested = view->GetMessage(
+      protobuf_unittest::TestAllTypes::kOptionalNestedMessageFieldNumber);
+  EXPECT_EQ(nested.GetInt32(
+                protobuf_unittest::TestAllTypes::NestedMessage::kBbFieldNumber),
+            42);
+
+  ASSERT_EQ(view->RepeatedSize(
+                protobuf_unittest::TestAllTypes::kRepeatedInt32FieldNumber),
+            2);
+  EXPECT_EQ(view->GetRepeatedInt32(
+                protobuf_unittest::TestAllTypes::kRepeatedInt32FieldNumber, 0),
+            7);
+  EXPECT_EQ(view->GetRepeatedInt32(
+                protobuf_unittest::TestAllTypes::kRepeatedInt32FieldNumber, 1),
+            8);
+  ASSERT_EQ(view->RepeatedSize(
+                protobuf_unittest::TestAllTypes::kRepeatedStringFieldNumber),
+            2);
+  EXPECT_EQ(view->GetRepeatedString(
+                protobuf_unittest::TestAllTypes::kRepeatedStringFieldNumber, 1),
+            "two");
+}
+
+TEST(FlatMessageTest, AbsentFields) {
+  protobuf_unittest::TestAllTypes message;
+  std::string buffer;
+  ASSERT_TRUE(FlattenMessage(message, &buffer).ok());
+
+  absl::StatusOr<FlatMessageView> view = FlatMessageView::Create(buffer);
+  ASSERT_TRUE(view.ok()) << view.status();
+  EXPECT_FALSE(view->Has(protobuf_unittest::TestAllTypes::kOptionalInt32FieldNumber));
+  EXPECT_EQ(view->RepeatedSize(
+                protobuf_unittest::TestAllTypes::kRepeatedInt32FieldNumber),
+            0);
+}
+
+TEST(FlatMessageTest, RejectsCorruptBuffers) {
+  EXPECT_FALSE(FlatMessageView::Create("").ok());
+  EXPECT_FALSE(FlatMessageView::Create("abc").ok());
+  EXPECT_FALSE(FlatMessageView::Create("not a flat message").ok());
+}
+
+TEST(FlatMessageTest, SkipsUnknownFieldNumbersWhenUnflattening) {
+  protobuf_unittest::TestAllTypes message;
+  message.set_optional_int32(101);
+
+  std::string buffer;
+  ASSERT_TRUE(FlattenMessage(message, &buffer).ok());
+
+  absl::StatusOr<FlatMessageView> view = FlatMessageView::Create(buffer);
+  ASSERT_TRUE(view.ok()) << view.status();
+
+  protobuf_unittest::TestEmptyMessage empty;
+  EXPECT_TRUE(view->UnflattenTo(&empty).ok());
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,49 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/util/frozen_message.h"
+
+#include <cstddef>
+
+#include "google/protobuf/arena.h"
+#include "google/protobuf/message.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+ArenaOptions FrozenMessage::CompactionOptions(const Message& message) {
+  // Size the first arena block to hold the whole tree, so that the copy ends
+  // up contiguous.  SpaceUsedLong() measures the source's retained memory,
+  // which is an upper bound on what the compact copy needs; the slack covers
+  // per-block arena overhead.  If the estimate is ever short the arena simply
+  // chains a second block.
+  constexpr size_t kSlack = 256;
+  ArenaOptions options;
+  options.start_block_size = message.SpaceUsedLong() + kSlack;
+  options.max_block_size = options.start_block_size;
+  return options;
+}
+
+FrozenMessage::FrozenMessage(const Message& message)
+    : arena_(CompactionOptions(message)) {
+  // CopyFrom walks fields in field order and allocates submessages and string
+  // payloads as it reaches them, which lays the tree out depth-first in the
+  // block: each submessage lands adjacent to the parent field that owns it.
+  Message* copy = message.New(&arena_);
+  copy->CopyFrom(message);
+  message_ = copy;
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
@@ -0,0 +1,67 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef GOOGLE_PROTOBUF_UTIL_FROZEN_MESSAGE_H__
+#define GOOGLE_PROTOBUF_UTIL_FROZEN_MESSAGE_H__
+
+#include <cstddef>
+
+#include "google/protobuf/arena.h"
+#include "google/protobuf/message.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+// A read-optimized, immutable copy of a parsed message.
+//
+// A message assembled by the parser is scattered across whatever allocations
+// were live at parse time; services that keep millions of parsed messages
+// resident for hours and only ever read them pay for that scatter on every
+// scan.  FrozenMessage compacts the tree: it copies the message into an arena
+// whose first block is sized up front from SpaceUsedLong(), so the whole tree
+// lands in one contiguous region, submessages are laid out adjacent to their
+// parents in field order, and string payloads are packed into the same block.
+//
+// The copy is reachable only as const; the mutable half of the message API is
+// never exposed, so the instance is immutable for its whole lifetime.
+//
+//   FrozenMessage frozen(*parsed);
+//   const MyProto& compact = static_cast<const MyProto&>(frozen.message());
+//
+// Reads through a FrozenMessage are safe from multiple threads concurrently.
+class PROTOBUF_EXPORT FrozenMessage {
+ public:
+  // Deep-copies `message` into the compact form.  The source is left
+  // untouched and no longer needed afterwards.
+  explicit FrozenMessage(const Message& message);
+
+  FrozenMessage(const FrozenMessage&) = delete;
+  FrozenMessage& operator=(const FrozenMessage&) = delete;
+
+  const Message& message() const { return *message_; }
+
+  // Total memory retained by the compact copy, including arena slack.
+  size_t SpaceUsedLong() const { return arena_.SpaceAllocated(); }
+
+ private:
+  static ArenaOptions CompactionOptions(const Message& message);
+
+  Arena arena_;
+  const Message* message_;
+};
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_FROZEN_MESSAGE_H__
@@ -0,0 +1,66 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/util/frozen_message.h"
+
+#include <gtest/gtest.h>
+#include "google/protobuf/test_util.h"
+#include "google/protobuf/unittest.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+TEST(FrozenMessageTest, PreservesAllFields) {
+  protobuf_unittest::TestAllTypes source;
+  TestUtil::SetAllFields(&source);
+
+  FrozenMessage frozen(source);
+  TestUtil::ExpectAllFieldsSet(
+      static_cast<const protobuf_unittest::TestAllTypes&>(frozen.message()));
+}
+
+TEST(FrozenMessageTest, IndependentOfSource) {
+  protobuf_unittest::TestAllTypes source;
+  TestUtil::SetAllFields(&source);
+
+  FrozenMessage frozen(source);
+  source.Clear();
+  TestUtil::ExpectAllFieldsSet(
+      static_cast<const protobuf_unittest::TestAllTypes&>(frozen.message()));
+}
+
+TEST(FrozenMessageTest, SerializesIdentically) {
+  protobuf_unittest::TestAllTypes source;
+  TestUtil::SetAllFields(&source);
+
+  FrozenMessage frozen(source);
+  EXPECT_EQ(source.SerializeAsString(), frozen.message().SerializeAsString());
+}
+
+TEST(FrozenMessageTest, CopyIsContiguous) {
+  protobuf_unittest::TestAllTypes source;
+  TestUtil::SetAllFields(&source);
+
+  // The up-front block estimate should be good enough that the copy does not
+  // retain more than the source plus a small constant of arena overhead.
+  FrozenMessage frozen(source);
+  EXPECT_GT(frozen.SpaceUsedLong(), 0);
+  EXPECT_LE(frozen.SpaceUsedLong(), source.SpaceUsedLong() + 512);
+}
+
+TEST(FrozenMessageTest, EmptyMessage) {
+  protobuf_unittest::TestAllTypes source;
+  FrozenMessage frozen(source);
+  EXPECT_EQ(frozen.message().ByteSizeLong(), 0);
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
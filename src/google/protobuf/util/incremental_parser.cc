@@ -0,0 +1,158 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/util/incremental_parser.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/message_lite.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+// Nested groups deeper than this are treated as malformed, matching the
+// parser's own default recursion limit.
+constexpr int kScanRecursionLimit = 100;
+
+// Scans one varint.  Returns the number of bytes it occupies, 0 if the
+// buffer ends mid-varint, or -1 if the varint is malformed.
+ptrdiff_t ScanVarint(const char* p, const char* end, uint64_t* value) {
+  uint64_t result = 0;
+  for (int i = 0; i < 10; ++i) {
+    if (p + i == end) return 0;
+    const uint8_t byte = static_cast<uint8_t>(p[i]);
+    result |= static_cast<uint64_t>(byte & 0x7F) << (7 * i);
+    if ((byte & 0x80) == 0) {
+      *value = result;
+      return i + 1;
+    }
+  }
+  return -1;
+}
+
+// Scans one complete field (tag and payload).  Returns the number of bytes
+// it occupies, 0 if the buffer ends before the field does, or -1 if the
+// field is malformed.
+ptrdiff_t ScanField(const char* p, const char* end, int depth) {
+  if (depth > kScanRecursionLimit) return -1;
+  uint64_t tag;
+  const ptrdiff_t tag_size = ScanVarint(p, end, &tag);
+  if (tag_size <= 0) return tag_size;
+  if (tag < 8 || tag > std::numeric_limits<uint32_t>::max()) return -1;
+  const char* q = p + tag_size;
+  switch (tag & 7) {
+    case 0: {  // varint
+      uint64_t value;
+      const ptrdiff_t n = ScanVarint(q, end, &value);
+      return n <= 0 ? n : tag_size + n;
+    }
+    case 1:  // fixed64
+      return end - q < 8 ? 0 : tag_size + 8;
+    case 2: {  // length-delimited
+      uint64_t length;
+      const ptrdiff_t n = ScanVarint(q, end, &length);
+      if (n <= 0) return n;
+      if (length >
+          static_cast<uint64_t>(std::numeric_limits<int32_t>::max())) {
+        return -1;
+      }
+      q += n;
+      if (static_cast<uint64_t>(end - q) < length) return 0;
+      return tag_size + n + static_cast<ptrdiff_t>(length);
+    }
+    case 3: {  // start group
+      const uint64_t end_tag = (tag & ~uint64_t{7}) | 4;
+      while (true) {
+        uint64_t inner_tag;
+        const ptrdiff_t n = ScanVarint(q, end, &inner_tag);
+        if (n <= 0) return n;
+        if (inner_tag == end_tag) return (q + n) - p;
+        const ptrdiff_t field_size = ScanField(q, end, depth + 1);
+        if (field_size <= 0) return field_size;
+        q += field_size;
+      }
+    }
+    case 5:  // fixed32
+      return end - q < 4 ? 0 : tag_size + 4;
+    default:  // end group without a matching start, or wire type 6/7
+      return -1;
+  }
+}
+
+// Merges |data| into |message| through the regular stream fast path,
+// without the top-level initialization check (the message is allowed to be
+// incomplete while more input is in flight).
+bool MergeFields(MessageLite* message, absl::string_view data) {
+  io::ArrayInputStream input(data.data(), static_cast<int>(data.size()));
+  return message->MergePartialFromBoundedZeroCopyStream(
+      &input, static_cast<int>(data.size()));
+}
+
+}  // namespace
+
+IncrementalParser::IncrementalParser(MessageLite* message)
+    : message_(message) {}
+
+ptrdiff_t IncrementalParser::ConsumeCompleteFields(absl::string_view data) {
+  const char* const begin = data.data();
+  const char* const end = begin + data.size();
+  const char* p = begin;
+  while (p < end) {
+    const ptrdiff_t field_size = ScanField(p, end, 0);
+    if (field_size < 0) return -1;
+    if (field_size == 0) break;  // Incomplete; wait for more input.
+    p += field_size;
+  }
+  if (p > begin &&
+      !MergeFields(message_, absl::string_view(begin, p - begin))) {
+    return -1;
+  }
+  return p - begin;
+}
+
+bool IncrementalParser::Feed(absl::string_view data) {
+  if (failed_) return false;
+  ptrdiff_t consumed;
+  if (pending_.empty()) {
+    consumed = ConsumeCompleteFields(data);
+    if (consumed >= 0) {
+      pending_.assign(data.data() + consumed, data.size() - consumed);
+    }
+  } else {
+    pending_.append(data.data(), data.size());
+    consumed = ConsumeCompleteFields(pending_);
+    if (consumed >= 0) {
+      pending_.erase(0, static_cast<size_t>(consumed));
+    }
+  }
+  if (consumed < 0) {
+    failed_ = true;
+    return false;
+  }
+  return true;
+}
+
+bool IncrementalParser::Finish() {
+  if (failed_ || !pending_.empty()) return false;
+  return message_->IsInitialized();
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
@@ -0,0 +1,87 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef GOOGLE_PROTOBUF_UTIL_INCREMENTAL_PARSER_H__
+#define GOOGLE_PROTOBUF_UTIL_INCREMENTAL_PARSER_H__
+
+#include <cstddef>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "google/protobuf/message_lite.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+// Parses a message from buffers that arrive piecemeal, e.g. from a
+// non-blocking socket or an io_uring completion loop, without dedicating a
+// thread that blocks inside ZeroCopyInputStream::Next() and without
+// accumulating the whole message before parsing.
+//
+// Feed() consumes every complete top-level field in the bytes seen so far
+// immediately (protobuf merge semantics make parsing a message in
+// field-aligned pieces equivalent to parsing it whole) and buffers only the
+// trailing bytes of an incomplete field until the rest arrives. For typical
+// messages this keeps the retained state a few bytes; the worst case is one
+// field's payload.
+//
+// Usage from an event loop:
+//
+//   IncrementalParser parser(&message);
+//   while (event_loop.Read(&chunk)) {
+//     if (!parser.Feed(chunk)) { /* malformed; fail the connection */ }
+//   }
+//   if (!parser.Finish()) { /* truncated or uninitialized */ }
+//
+// The parser suspends at top-level field boundaries rather than at
+// arbitrary byte positions: capturing a TcParser continuation mid-field
+// would mean materializing its call stack, which the tail-call design
+// deliberately keeps implicit.
+class PROTOBUF_EXPORT IncrementalParser {
+ public:
+  // The parser merges into |message|, which must outlive it.  |message| is
+  // not cleared; pre-existing contents are merged with the parsed data.
+  explicit IncrementalParser(MessageLite* message);
+
+  IncrementalParser(const IncrementalParser&) = delete;
+  IncrementalParser& operator=(const IncrementalParser&) = delete;
+
+  // Feeds the next chunk of the serialized message.  Complete top-level
+  // fields are merged into the message before returning; incomplete
+  // trailing bytes are copied aside.  Returns false if the input is
+  // malformed, after which the parser is permanently in the error state.
+  bool Feed(absl::string_view data);
+
+  // Signals end of input.  Returns false if bytes of an incomplete field
+  // are still pending, if the input was malformed, or if the message is
+  // missing required fields.
+  bool Finish();
+
+  // Bytes currently buffered while waiting for the rest of a field.
+  size_t pending_bytes() const { return pending_.size(); }
+
+ private:
+  // Merges the longest field-aligned prefix of |data| into the message and
+  // returns the number of bytes consumed, or -1 on malformed input.
+  ptrdiff_t ConsumeCompleteFields(absl::string_view data);
+
+  MessageLite* message_;
+  std::string pending_;
+  bool failed_ = false;
+};
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_INCREMENTAL_PARSER_H__
@@ -0,0 +1,99 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/util/incremental_parser.h"
+
+#include <string>
+
+#include <gtest/gtest.h>
+#include "absl/strings/string_view.h"
+#include "google/protobuf/test_util.h"
+#include "google/protobuf/unittest.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+TEST(IncrementalParserTest, SingleByteChunksMatchWholeParse) {
+  unittest::TestAllTypes original;
+  TestUtil::SetAllFields(&original);
+  std::string wire = original.SerializeAsString();
+
+  unittest::TestAllTypes parsed;
+  IncrementalParser parser(&parsed);
+  for (char c : wire) {
+    ASSERT_TRUE(parser.Feed(absl::string_view(&c, 1)));
+  }
+  ASSERT_TRUE(parser.Finish());
+  EXPECT_EQ(parsed.DebugString(), original.DebugString());
+}
+
+TEST(IncrementalParserTest, BuffersOnlyTheIncompleteField) {
+  unittest::TestAllTypes original;
+  original.set_optional_int32(42);
+  original.set_optional_string(std::string(100, 'x'));
+  std::string wire = original.SerializeAsString();
+
+  unittest::TestAllTypes parsed;
+  IncrementalParser parser(&parsed);
+
+  // Feed everything but the last byte: the int32 field is complete and
+  // must already be merged; only the truncated string field is pending.
+  ASSERT_TRUE(parser.Feed(absl::string_view(wire.data(), wire.size() - 1)));
+  EXPECT_EQ(parsed.optional_int32(), 42);
+  EXPECT_FALSE(parsed.has_optional_string());
+  EXPECT_GT(parser.pending_bytes(), 0);
+  EXPECT_FALSE(parser.Finish());
+
+  ASSERT_TRUE(parser.Feed(absl::string_view(wire.data() + wire.size() - 1, 1)));
+  EXPECT_EQ(parser.pending_bytes(), 0);
+  ASSERT_TRUE(parser.Finish());
+  EXPECT_EQ(parsed.optional_string(), std::string(100, 'x'));
+}
+
+TEST(IncrementalParserTest, GroupsSpanningChunks) {
+  unittest::TestAllTypes original;
+  original.mutable_optionalgroup()->set_a(117);
+  original.add_repeatedgroup()->set_a(118);
+  std::string wire = original.SerializeAsString();
+
+  unittest::TestAllTypes parsed;
+  IncrementalParser parser(&parsed);
+  size_t half = wire.size() / 2;
+  ASSERT_TRUE(parser.Feed(absl::string_view(wire.data(), half)));
+  ASSERT_TRUE(parser.Feed(absl::string_view(wire.data() + half,
+                                            wire.size() - half)));
+  ASSERT_TRUE(parser.Finish());
+  EXPECT_EQ(parsed.optionalgroup().a(), 117);
+  EXPECT_EQ(parsed.repeatedgroup(0).a(), 118);
+}
+
+TEST(IncrementalParserTest, MalformedInputFailsPermanently) {
+  unittest::TestAllTypes parsed;
+  IncrementalParser parser(&parsed);
+  // Field number zero is never valid.
+  EXPECT_FALSE(parser.Feed(absl::string_view("\x00", 1)));
+  EXPECT_FALSE(parser.Feed(absl::string_view("\x08\x01", 2)));
+  EXPECT_FALSE(parser.Finish());
+}
+
+TEST(IncrementalParserTest, FinishFailsOnTruncatedInput) {
+  unittest::TestAllTypes original;
+  original.set_optional_string("hello world");
+  std::string wire = original.SerializeAsString();
+
+  unittest::TestAllTypes parsed;
+  IncrementalParser parser(&parsed);
+  ASSERT_TRUE(parser.Feed(absl::string_view(wire.data(), wire.size() - 3)));
+  EXPECT_FALSE(parser.Finish());
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,339 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/util/journal_stream.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "absl/log/absl_log.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/io/coded_stream.h"
+
+#if HAVE_ZLIB
+#include <zlib.h>
+
+#include "google/protobuf/io/gzip_stream.h"
+#endif  // HAVE_ZLIB
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+// Starts every block.  The bytes outside the ASCII range keep the marker
+// from occurring in text payloads by accident.
+const uint8_t kSyncMarker[8] = {0xc1, 'P', 'B', 'J', 'R', 'N', 'L', 0x81};
+
+// Marker + first_record + record_count + raw_size + stored_size +
+// compression byte.
+constexpr size_t kBlockHeaderSize = sizeof(kSyncMarker) + 8 + 4 + 4 + 4 + 1;
+
+constexpr uint8_t kCompressionNone = 0;
+constexpr uint8_t kCompressionZlib = 1;
+
+uint32_t LoadLittleEndian32(const char* p) {
+  const uint8_t* b = reinterpret_cast<const uint8_t*>(p);
+  return static_cast<uint32_t>(b[0]) | (static_cast<uint32_t>(b[1]) << 8) |
+         (static_cast<uint32_t>(b[2]) << 16) |
+         (static_cast<uint32_t>(b[3]) << 24);
+}
+
+uint64_t LoadLittleEndian64(const char* p) {
+  return static_cast<uint64_t>(LoadLittleEndian32(p)) |
+         (static_cast<uint64_t>(LoadLittleEndian32(p + 4)) << 32);
+}
+
+// Appends one group-varint group: a tag byte carrying four 2-bit byte
+// widths (width - 1, value 0 in the low bits), then each value's bytes,
+// little-endian, narrowest width first to last.
+void AppendGroupVarint(const uint32_t* values, std::string* out) {
+  char buf[17];
+  char* p = buf + 1;
+  uint8_t tag = 0;
+  for (int i = 0; i < 4; ++i) {
+    uint32_t value = values[i];
+    int width = value < 0x100 ? 1 : value < 0x10000 ? 2
+                                : value < 0x1000000 ? 3
+                                                    : 4;
+    tag |= static_cast<uint8_t>(width - 1) << (2 * i);
+    for (int b = 0; b < width; ++b) {
+      *p++ = static_cast<char>(value & 0xff);
+      value >>= 8;
+    }
+  }
+  buf[0] = static_cast<char>(tag);
+  out->append(buf, static_cast<size_t>(p - buf));
+}
+
+// Decodes one group of four values; returns the position after the group,
+// or null if it would run past |end|.
+const char* DecodeGroupVarint(const char* p, const char* end,
+                              uint32_t* values) {
+  if (p >= end) return nullptr;
+  const uint8_t tag = static_cast<uint8_t>(*p++);
+  for (int i = 0; i < 4; ++i) {
+    const int width = ((tag >> (2 * i)) & 3) + 1;
+    if (end - p < width) return nullptr;
+    uint32_t value = 0;
+    for (int b = 0; b < width; ++b) {
+      value |= static_cast<uint32_t>(static_cast<uint8_t>(p[b])) << (8 * b);
+    }
+    p += width;
+    values[i] = value;
+  }
+  return p;
+}
+
+}  // namespace
+
+JournalWriter::Options::Options() : block_size(128 * 1024), compression(NONE) {}
+
+JournalWriter::JournalWriter(io::ZeroCopyOutputStream* output,
+                             const Options& options)
+    : output_(output), options_(options) {}
+
+bool JournalWriter::WriteRecord(const MessageLite& message) {
+  if (failed_) return false;
+  const size_t before = payload_.size();
+  if (!message.AppendToString(&payload_)) {
+    payload_.resize(before);
+    failed_ = true;
+    return false;
+  }
+  lengths_.push_back(static_cast<uint32_t>(payload_.size() - before));
+  return payload_.size() < options_.block_size || EmitBlock();
+}
+
+bool JournalWriter::WriteRecord(absl::string_view record) {
+  if (failed_) return false;
+  payload_.append(record.data(), record.size());
+  lengths_.push_back(static_cast<uint32_t>(record.size()));
+  return payload_.size() < options_.block_size || EmitBlock();
+}
+
+bool JournalWriter::Flush() {
+  if (failed_) return false;
+  return lengths_.empty() || EmitBlock();
+}
+
+bool JournalWriter::Close() { return Flush(); }
+
+bool JournalWriter::EmitBlock() {
+  // Lengths region first, then the record bytes.
+  std::string raw;
+  raw.reserve((lengths_.size() / 4 + 1) * 17 + payload_.size());
+  uint32_t quad[4];
+  for (size_t i = 0; i < lengths_.size(); i += 4) {
+    for (size_t j = 0; j < 4; ++j) {
+      quad[j] = i + j < lengths_.size() ? lengths_[i + j] : 0;
+    }
+    AppendGroupVarint(quad, &raw);
+  }
+  raw.append(payload_);
+
+  absl::string_view stored = raw;
+  uint8_t compression = kCompressionNone;
+  std::string compressed;
+  if (options_.compression == ZLIB) {
+#if HAVE_ZLIB
+    uLongf compressed_size = compressBound(raw.size());
+    compressed.resize(compressed_size);
+    if (compress2(reinterpret_cast<Bytef*>(&compressed[0]), &compressed_size,
+                  reinterpret_cast<const Bytef*>(raw.data()), raw.size(),
+                  Z_DEFAULT_COMPRESSION) != Z_OK) {
+      failed_ = true;
+      return false;
+    }
+    compressed.resize(compressed_size);
+    stored = compressed;
+    compression = kCompressionZlib;
+#else
+    ABSL_LOG(ERROR) << "JournalWriter: zlib compression requested but zlib "
+                       "support was not compiled in.";
+    failed_ = true;
+    return false;
+#endif  // HAVE_ZLIB
+  }
+
+  io::CodedOutputStream out(output_);
+  out.WriteRaw(kSyncMarker, sizeof(kSyncMarker));
+  out.WriteLittleEndian64(next_record_);
+  out.WriteLittleEndian32(static_cast<uint32_t>(lengths_.size()));
+  out.WriteLittleEndian32(static_cast<uint32_t>(raw.size()));
+  out.WriteLittleEndian32(static_cast<uint32_t>(stored.size()));
+  out.WriteRaw(&compression, 1);
+  out.WriteRaw(stored.data(), stored.size());
+  if (out.HadError()) {
+    failed_ = true;
+    return false;
+  }
+
+  next_record_ += lengths_.size();
+  lengths_.clear();
+  payload_.clear();
+  return true;
+}
+
+struct JournalBlockDecoder::ZlibState {
+#if HAVE_ZLIB
+  ZlibState() : inflater(MakeOptions()) {}
+
+  static io::ZlibRecordDecompressor::Options MakeOptions() {
+    io::ZlibRecordDecompressor::Options options;
+    options.format = io::ZlibRecordDecompressor::ZLIB;
+    return options;
+  }
+
+  io::ZlibRecordDecompressor inflater;
+#endif  // HAVE_ZLIB
+};
+
+JournalBlockDecoder::JournalBlockDecoder() = default;
+JournalBlockDecoder::~JournalBlockDecoder() = default;
+
+bool JournalBlockDecoder::Decode(absl::string_view journal,
+                                 const JournalBlockRef& block,
+                                 std::vector<absl::string_view>* records) {
+  records->clear();
+  if (journal.size() - block.offset < kBlockHeaderSize) return false;
+  const char* header = journal.data() + block.offset + sizeof(kSyncMarker);
+  const uint32_t record_count = LoadLittleEndian32(header + 8);
+  const uint32_t raw_size = LoadLittleEndian32(header + 12);
+  const uint32_t stored_size = LoadLittleEndian32(header + 16);
+  const uint8_t compression = static_cast<uint8_t>(header[20]);
+  if (record_count != block.record_count ||
+      journal.size() - block.offset - kBlockHeaderSize < stored_size) {
+    return false;
+  }
+
+  absl::string_view raw;
+  absl::string_view stored =
+      journal.substr(block.offset + kBlockHeaderSize, stored_size);
+  switch (compression) {
+    case kCompressionNone:
+      if (stored_size != raw_size) return false;
+      raw = stored;
+      break;
+    case kCompressionZlib:
+#if HAVE_ZLIB
+      if (zlib_ == nullptr) zlib_.reset(new ZlibState());
+      if (!zlib_->inflater.Decompress(stored.data(), stored.size(),
+                                      &scratch_) ||
+          scratch_.size() != raw_size) {
+        return false;
+      }
+      raw = scratch_;
+      break;
+#else
+      return false;
+#endif  // HAVE_ZLIB
+    default:
+      return false;
+  }
+
+  // Decode the group-varint lengths region, then slice the record bytes.
+  std::vector<uint32_t> lengths(((record_count + 3) / 4) * 4);
+  const char* p = raw.data();
+  const char* end = raw.data() + raw.size();
+  for (size_t i = 0; i < lengths.size(); i += 4) {
+    p = DecodeGroupVarint(p, end, &lengths[i]);
+    if (p == nullptr) return false;
+  }
+  records->reserve(record_count);
+  for (uint32_t i = 0; i < record_count; ++i) {
+    if (static_cast<size_t>(end - p) < lengths[i]) {
+      records->clear();
+      return false;
+    }
+    records->push_back(absl::string_view(p, lengths[i]));
+    p += lengths[i];
+  }
+  if (p != end) {
+    records->clear();
+    return false;
+  }
+  return true;
+}
+
+JournalReader::JournalReader(absl::string_view journal) : journal_(journal) {
+  // Index the journal by walking block headers; payloads are skipped, not
+  // read.  The scan stops at the first torn or corrupt block, leaving the
+  // intact prefix indexed.
+  size_t pos = 0;
+  while (journal_.size() - pos >= kBlockHeaderSize) {
+    if (memcmp(journal_.data() + pos, kSyncMarker, sizeof(kSyncMarker)) != 0) {
+      break;
+    }
+    const char* header = journal_.data() + pos + sizeof(kSyncMarker);
+    const uint64_t first_record = LoadLittleEndian64(header);
+    const uint32_t record_count = LoadLittleEndian32(header + 8);
+    const uint32_t stored_size = LoadLittleEndian32(header + 16);
+    if (first_record != num_records_ || record_count == 0 ||
+        journal_.size() - pos - kBlockHeaderSize < stored_size) {
+      break;
+    }
+    blocks_.push_back(JournalBlockRef{first_record, record_count, pos});
+    num_records_ += record_count;
+    pos += kBlockHeaderSize + stored_size;
+  }
+  valid_size_ = pos;
+  clean_end_ = pos == journal_.size();
+}
+
+bool JournalReader::ReadRecord(absl::string_view* record) {
+  while (current_block_ < 0 ||
+         next_in_block_ >= current_records_.size()) {
+    const int next = current_block_ < 0 ? 0 : current_block_ + 1;
+    if (next >= num_blocks() || !LoadBlock(next)) return false;
+  }
+  *record = current_records_[next_in_block_++];
+  return true;
+}
+
+bool JournalReader::SeekToRecord(uint64_t ordinal) {
+  if (ordinal >= num_records_) return false;
+  // Last block whose first record is <= ordinal.
+  const int index =
+      static_cast<int>(std::upper_bound(blocks_.begin(), blocks_.end(),
+                                        ordinal,
+                                        [](uint64_t o,
+                                           const JournalBlockRef& b) {
+                                          return o < b.first_record;
+                                        }) -
+                       blocks_.begin()) -
+      1;
+  if (current_block_ != index && !LoadBlock(index)) return false;
+  next_in_block_ =
+      static_cast<size_t>(ordinal - blocks_[index].first_record);
+  return true;
+}
+
+bool JournalReader::LoadBlock(int index) {
+  if (!decoder_.Decode(journal_, blocks_[index], &current_records_)) {
+    current_block_ = -1;
+    current_records_.clear();
+    next_in_block_ = 0;
+    return false;
+  }
+  current_block_ = index;
+  next_in_block_ = 0;
+  return true;
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
@@ -0,0 +1,204 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef GOOGLE_PROTOBUF_UTIL_JOURNAL_STREAM_H__
+#define GOOGLE_PROTOBUF_UTIL_JOURNAL_STREAM_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "google/protobuf/io/zero_copy_stream.h"
+#include "google/protobuf/message_lite.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+// An append-only journal of serialized messages, built for fast recovery
+// replay.  Where a WriteDelimitedTo() stream interleaves one varint prefix
+// per record and can only be replayed sequentially, a journal groups
+// records into blocks:
+//
+//   block := sync marker (8 bytes)
+//            first_record (uint64, little-endian record ordinal)
+//            record_count (uint32)
+//            raw_size     (uint32, payload size before compression)
+//            stored_size  (uint32, payload size as stored)
+//            compression  (uint8: 0 = none, 1 = zlib)
+//            payload      (stored_size bytes)
+//
+// The (uncompressed) payload is ceil(record_count / 4) group-varint
+// groups encoding the record lengths -- one tag byte holding four 2-bit
+// byte widths, then the length bytes; the last group is padded with zero
+// lengths -- followed by the record bytes back to back.  Keeping all
+// lengths at the front lets a replayer locate every record in the block
+// with one linear pass over a few bytes per record.
+//
+// Because each block header carries the ordinal of its first record and
+// its stored size, a reader can index the journal by touching only the
+// headers, then binary-search the index to seek, and blocks decode
+// independently, so replay parallelizes per block.  A torn final block
+// (the common crash artifact) is detected and the intact prefix remains
+// readable.
+class PROTOBUF_EXPORT JournalWriter {
+ public:
+  enum Compression {
+    NONE = 0,
+    // Per-block zlib compression.  Requires a zlib-enabled build; without
+    // one the first block emission fails.
+    ZLIB = 1,
+  };
+
+  struct Options {
+    Options();
+
+    // Target uncompressed payload size per block.  A block is emitted
+    // once its payload reaches this size, so blocks exceed it by at most
+    // one record.
+    size_t block_size;
+
+    Compression compression;
+  };
+
+  // Does not take ownership of |output|, which must stay live until the
+  // writer is destroyed.
+  explicit JournalWriter(io::ZeroCopyOutputStream* output,
+                         const Options& options = Options());
+  JournalWriter(const JournalWriter&) = delete;
+  JournalWriter& operator=(const JournalWriter&) = delete;
+
+  // Appends one record.  Records are buffered and written out a block at
+  // a time; call Flush() (or Close()) to make buffered records durable.
+  bool WriteRecord(const MessageLite& message);
+  bool WriteRecord(absl::string_view record);
+
+  // Emits the current partial block, putting a sync point after the last
+  // record written.  A no-op if no records are buffered.
+  bool Flush();
+
+  // Flushes; the writer must not be used afterwards.  Returns false if
+  // any write failed.
+  bool Close();
+
+  // Number of records accepted by WriteRecord() so far.
+  uint64_t record_count() const { return next_record_ + lengths_.size(); }
+
+ private:
+  bool EmitBlock();
+
+  io::ZeroCopyOutputStream* output_;
+  Options options_;
+  // Buffered record bytes and their lengths for the block in progress.
+  std::string payload_;
+  std::vector<uint32_t> lengths_;
+  // Ordinal of the first record in the block in progress.
+  uint64_t next_record_ = 0;
+  bool failed_ = false;
+};
+
+// Location of one block within a journal, as produced by JournalReader's
+// index scan.
+struct JournalBlockRef {
+  // Ordinal of the block's first record.
+  uint64_t first_record;
+  uint32_t record_count;
+  // Byte offset of the block's sync marker within the journal.
+  size_t offset;
+};
+
+// Decodes one block into its records.  Holds the scratch buffer (and, for
+// compressed journals, the reused zlib inflate state) between calls, so
+// decoding many blocks through one decoder does not reallocate per block.
+// For parallel replay, give each worker thread its own decoder and hand
+// out disjoint blocks; the journal bytes are only read.
+class PROTOBUF_EXPORT JournalBlockDecoder {
+ public:
+  JournalBlockDecoder();
+  JournalBlockDecoder(const JournalBlockDecoder&) = delete;
+  JournalBlockDecoder& operator=(const JournalBlockDecoder&) = delete;
+  ~JournalBlockDecoder();
+
+  // Decodes the block at |block| in |journal| (the same bytes the index
+  // was built from).  The returned views point into |journal| or into the
+  // decoder's scratch buffer and are valid until the next Decode() call.
+  // Returns false on a corrupt block, or a compressed block in a build
+  // without zlib.
+  bool Decode(absl::string_view journal, const JournalBlockRef& block,
+              std::vector<absl::string_view>* records);
+
+ private:
+  struct ZlibState;
+
+  std::string scratch_;
+  // Created on first compressed block, then reused.
+  std::unique_ptr<ZlibState> zlib_;
+};
+
+// Reads a journal from memory (typically an mmap'd file -- seeking and
+// parallel decoding need random access, which ZeroCopyInputStream does
+// not provide).  Construction scans only the block headers, so indexing
+// cost is proportional to the number of blocks, not to journal size.
+class PROTOBUF_EXPORT JournalReader {
+ public:
+  // Does not copy |journal|, which must outlive the reader and any record
+  // views handed out.
+  explicit JournalReader(absl::string_view journal);
+  JournalReader(const JournalReader&) = delete;
+  JournalReader& operator=(const JournalReader&) = delete;
+
+  // Records and blocks in the valid prefix of the journal.
+  uint64_t num_records() const { return num_records_; }
+  int num_blocks() const { return static_cast<int>(blocks_.size()); }
+  const JournalBlockRef& block(int index) const { return blocks_[index]; }
+
+  // True if the journal ends exactly on a block boundary; false if the
+  // tail is truncated or corrupt.  The valid prefix is readable either
+  // way; valid_size() is its length in bytes.
+  bool clean_end() const { return clean_end_; }
+  size_t valid_size() const { return valid_size_; }
+
+  // Returns the next record in ordinal order, or false at the end of the
+  // valid prefix (or on a block that fails to decode).  The view is valid
+  // until the next ReadRecord() or SeekToRecord() call.
+  bool ReadRecord(absl::string_view* record);
+
+  // Positions the reader so that the next ReadRecord() returns record
+  // |ordinal|.  Binary-searches the block index, then decodes one block.
+  // Returns false if |ordinal| is past the last record.
+  bool SeekToRecord(uint64_t ordinal);
+
+ private:
+  bool LoadBlock(int index);
+
+  absl::string_view journal_;
+  std::vector<JournalBlockRef> blocks_;
+  uint64_t num_records_ = 0;
+  bool clean_end_ = true;
+  size_t valid_size_ = 0;
+
+  JournalBlockDecoder decoder_;
+  // Decoded records of blocks_[current_block_]; next_in_block_ indexes
+  // the next record to deliver.
+  int current_block_ = -1;
+  std::vector<absl::string_view> current_records_;
+  size_t next_in_block_ = 0;
+};
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_JOURNAL_STREAM_H__
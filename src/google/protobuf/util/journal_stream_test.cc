@@ -0,0 +1,199 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/util/journal_stream.h"
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "absl/strings/string_view.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/unittest.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+// Writes |num_records| ForeignMessages (c == ordinal) with small blocks so
+// tests exercise multi-block journals.
+std::string MakeJournal(int num_records,
+                        JournalWriter::Compression compression =
+                            JournalWriter::NONE) {
+  std::string data;
+  io::StringOutputStream output(&data);
+  JournalWriter::Options options;
+  options.block_size = 64;
+  options.compression = compression;
+  JournalWriter writer(&output, options);
+  for (int i = 0; i < num_records; ++i) {
+    protobuf_unittest::ForeignMessage message;
+    message.set_c(i);
+    EXPECT_TRUE(writer.WriteRecord(message));
+  }
+  EXPECT_TRUE(writer.Close());
+  EXPECT_EQ(writer.record_count(), static_cast<uint64_t>(num_records));
+  return data;
+}
+
+TEST(JournalStreamTest, WriteReadRoundTrip) {
+  const int kNumRecords = 500;
+  std::string data = MakeJournal(kNumRecords);
+
+  JournalReader reader(data);
+  EXPECT_TRUE(reader.clean_end());
+  EXPECT_EQ(reader.num_records(), static_cast<uint64_t>(kNumRecords));
+  EXPECT_GT(reader.num_blocks(), 1);
+
+  absl::string_view record;
+  for (int i = 0; i < kNumRecords; ++i) {
+    ASSERT_TRUE(reader.ReadRecord(&record)) << "record " << i;
+    protobuf_unittest::ForeignMessage message;
+    ASSERT_TRUE(message.ParseFromString(record));
+    EXPECT_EQ(message.c(), i);
+  }
+  EXPECT_FALSE(reader.ReadRecord(&record));
+}
+
+TEST(JournalStreamTest, EmptyJournal) {
+  JournalReader reader(absl::string_view());
+  EXPECT_TRUE(reader.clean_end());
+  EXPECT_EQ(reader.num_records(), 0u);
+  absl::string_view record;
+  EXPECT_FALSE(reader.ReadRecord(&record));
+}
+
+TEST(JournalStreamTest, SeekToRecord) {
+  const int kNumRecords = 300;
+  std::string data = MakeJournal(kNumRecords);
+  JournalReader reader(data);
+
+  absl::string_view record;
+  for (int ordinal : {0, 299, 7, 150, 151, 42}) {
+    ASSERT_TRUE(reader.SeekToRecord(ordinal)) << "ordinal " << ordinal;
+    ASSERT_TRUE(reader.ReadRecord(&record));
+    protobuf_unittest::ForeignMessage message;
+    ASSERT_TRUE(message.ParseFromString(record));
+    EXPECT_EQ(message.c(), ordinal);
+  }
+  EXPECT_FALSE(reader.SeekToRecord(kNumRecords));
+
+  // Reading continues in order from the seek target.
+  ASSERT_TRUE(reader.SeekToRecord(100));
+  for (int i = 100; i < 110; ++i) {
+    ASSERT_TRUE(reader.ReadRecord(&record));
+    protobuf_unittest::ForeignMessage message;
+    ASSERT_TRUE(message.ParseFromString(record));
+    EXPECT_EQ(message.c(), i);
+  }
+}
+
+TEST(JournalStreamTest, ParallelBlockReplay) {
+  const int kNumRecords = 400;
+  const int kNumThreads = 4;
+  std::string data = MakeJournal(kNumRecords);
+  JournalReader reader(data);
+  ASSERT_GE(reader.num_blocks(), kNumThreads);
+
+  // Each worker decodes a disjoint stripe of blocks with its own decoder.
+  std::vector<int> seen(kNumRecords, 0);
+  std::vector<std::thread> workers;
+  for (int t = 0; t < kNumThreads; ++t) {
+    workers.emplace_back([&, t] {
+      JournalBlockDecoder decoder;
+      std::vector<absl::string_view> records;
+      for (int b = t; b < reader.num_blocks(); b += kNumThreads) {
+        const JournalBlockRef& block = reader.block(b);
+        ASSERT_TRUE(decoder.Decode(data, block, &records));
+        ASSERT_EQ(records.size(), block.record_count);
+        for (size_t i = 0; i < records.size(); ++i) {
+          protobuf_unittest::ForeignMessage message;
+          ASSERT_TRUE(message.ParseFromString(records[i]));
+          EXPECT_EQ(message.c(),
+                    static_cast<int>(block.first_record + i));
+          seen[message.c()] = 1;
+        }
+      }
+    });
+  }
+  for (auto& worker : workers) worker.join();
+  for (int i = 0; i < kNumRecords; ++i) {
+    EXPECT_EQ(seen[i], 1) << "record " << i;
+  }
+}
+
+TEST(JournalStreamTest, TruncatedTailLeavesPrefixReadable) {
+  const int kNumRecords = 200;
+  std::string data = MakeJournal(kNumRecords);
+  data.resize(data.size() - 3);
+
+  JournalReader reader(data);
+  EXPECT_FALSE(reader.clean_end());
+  EXPECT_LT(reader.num_records(), static_cast<uint64_t>(kNumRecords));
+  EXPECT_GT(reader.num_records(), 0u);
+  EXPECT_LT(reader.valid_size(), data.size());
+
+  absl::string_view record;
+  for (uint64_t i = 0; i < reader.num_records(); ++i) {
+    ASSERT_TRUE(reader.ReadRecord(&record)) << "record " << i;
+    protobuf_unittest::ForeignMessage message;
+    ASSERT_TRUE(message.ParseFromString(record));
+    EXPECT_EQ(message.c(), static_cast<int>(i));
+  }
+  EXPECT_FALSE(reader.ReadRecord(&record));
+}
+
+TEST(JournalStreamTest, CorruptBlockFailsDecode) {
+  std::string data = MakeJournal(100);
+  JournalReader reader(data);
+  ASSERT_GT(reader.num_blocks(), 1);
+
+  // Corrupt the second block's raw_size header field (it sits 20 bytes
+  // past the sync marker); the size check in Decode() catches it.
+  std::string corrupt = data;
+  corrupt[reader.block(1).offset + 20] ^= 0x55;
+  JournalBlockDecoder decoder;
+  std::vector<absl::string_view> records;
+  EXPECT_TRUE(decoder.Decode(data, reader.block(1), &records));
+  EXPECT_FALSE(decoder.Decode(corrupt, reader.block(1), &records));
+}
+
+#if HAVE_ZLIB
+TEST(JournalStreamTest, ZlibCompressedRoundTrip) {
+  const int kNumRecords = 500;
+  std::string data = MakeJournal(kNumRecords, JournalWriter::ZLIB);
+  std::string uncompressed = MakeJournal(kNumRecords);
+  EXPECT_NE(data, uncompressed);
+
+  JournalReader reader(data);
+  EXPECT_TRUE(reader.clean_end());
+  ASSERT_EQ(reader.num_records(), static_cast<uint64_t>(kNumRecords));
+
+  absl::string_view record;
+  for (int i = 0; i < kNumRecords; ++i) {
+    ASSERT_TRUE(reader.ReadRecord(&record)) << "record " << i;
+    protobuf_unittest::ForeignMessage message;
+    ASSERT_TRUE(message.ParseFromString(record));
+    EXPECT_EQ(message.c(), i);
+  }
+
+  // Seeking decompresses just the target block.
+  ASSERT_TRUE(reader.SeekToRecord(321));
+  ASSERT_TRUE(reader.ReadRecord(&record));
+  protobuf_unittest::ForeignMessage message;
+  ASSERT_TRUE(message.ParseFromString(record));
+  EXPECT_EQ(message.c(), 321);
+}
+#endif  // HAVE_ZLIB
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,383 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/util/merge_reparse.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "absl/log/absl_log.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+#include "google/protobuf/unknown_field_set.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+bool ApplyDiff(const Message& from, Message* to);
+
+// Whether a singular non-message field holds the same value in both messages.
+// Floats are compared with operator==, so a NaN always registers as changed;
+// rewriting a NaN with a NaN is harmless.
+bool SingularValueEquals(const Message& from, const Message& to,
+                         const FieldDescriptor* field) {
+  const Reflection* rf = from.GetReflection();
+  const Reflection* rt = to.GetReflection();
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      return rf->GetInt32(from, field) == rt->GetInt32(to, field);
+    case FieldDescriptor::CPPTYPE_INT64:
+      return rf->GetInt64(from, field) == rt->GetInt64(to, field);
+    case FieldDescriptor::CPPTYPE_UINT32:
+      return rf->GetUInt32(from, field) == rt->GetUInt32(to, field);
+    case FieldDescriptor::CPPTYPE_UINT64:
+      return rf->GetUInt64(from, field) == rt->GetUInt64(to, field);
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      return rf->GetFloat(from, field) == rt->GetFloat(to, field);
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      return rf->GetDouble(from, field) == rt->GetDouble(to, field);
+    case FieldDescriptor::CPPTYPE_BOOL:
+      return rf->GetBool(from, field) == rt->GetBool(to, field);
+    case FieldDescriptor::CPPTYPE_ENUM:
+      return rf->GetEnumValue(from, field) == rt->GetEnumValue(to, field);
+    case FieldDescriptor::CPPTYPE_STRING: {
+      std::string scratch_from, scratch_to;
+      return rf->GetStringReference(from, field, &scratch_from) ==
+             rt->GetStringReference(to, field, &scratch_to);
+    }
+    default:
+      ABSL_LOG(FATAL) << "Unexpected cpp_type: " << field->cpp_type();
+      return false;
+  }
+}
+
+void CopySingularValue(const Message& from, Message* to,
+                       const FieldDescriptor* field) {
+  const Reflection* rf = from.GetReflection();
+  const Reflection* rt = to->GetReflection();
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      rt->SetInt32(to, field, rf->GetInt32(from, field));
+      break;
+    case FieldDescriptor::CPPTYPE_INT64:
+      rt->SetInt64(to, field, rf->GetInt64(from, field));
+      break;
+    case FieldDescriptor::CPPTYPE_UINT32:
+      rt->SetUInt32(to, field, rf->GetUInt32(from, field));
+      break;
+    case FieldDescriptor::CPPTYPE_UINT64:
+      rt->SetUInt64(to, field, rf->GetUInt64(from, field));
+      break;
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      rt->SetFloat(to, field, rf->GetFloat(from, field));
+      break;
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      rt->SetDouble(to, field, rf->GetDouble(from, field));
+      break;
+    case FieldDescriptor::CPPTYPE_BOOL:
+      rt->SetBool(to, field, rf->GetBool(from, field));
+      break;
+    case FieldDescriptor::CPPTYPE_ENUM:
+      rt->SetEnumValue(to, field, rf->GetEnumValue(from, field));
+      break;
+    case FieldDescriptor::CPPTYPE_STRING:
+      rt->SetString(to, field, rf->GetString(from, field));
+      break;
+    default:
+      ABSL_LOG(FATAL) << "Unexpected cpp_type: " << field->cpp_type();
+      break;
+  }
+}
+
+bool RepeatedValueEquals(const Message& from, const Message& to,
+                         const FieldDescriptor* field, int index) {
+  const Reflection* rf = from.GetReflection();
+  const Reflection* rt = to.GetReflection();
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      return rf->GetRepeatedInt32(from, field, index) ==
+             rt->GetRepeatedInt32(to, field, index);
+    case FieldDescriptor::CPPTYPE_INT64:
+      return rf->GetRepeatedInt64(from, field, index) ==
+             rt->GetRepeatedInt64(to, field, index);
+    case FieldDescriptor::CPPTYPE_UINT32:
+      return rf->GetRepeatedUInt32(from, field, index) ==
+             rt->GetRepeatedUInt32(to, field, index);
+    case FieldDescriptor::CPPTYPE_UINT64:
+      return rf->GetRepeatedUInt64(from, field, index) ==
+             rt->GetRepeatedUInt64(to, field, index);
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      return rf->GetRepeatedFloat(from, field, index) ==
+             rt->GetRepeatedFloat(to, field, index);
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      return rf->GetRepeatedDouble(from, field, index) ==
+             rt->GetRepeatedDouble(to, field, index);
+    case FieldDescriptor::CPPTYPE_BOOL:
+      return rf->GetRepeatedBool(from, field, index) ==
+             rt->GetRepeatedBool(to, field, index);
+    case FieldDescriptor::CPPTYPE_ENUM:
+      return rf->GetRepeatedEnumValue(from, field, index) ==
+             rt->GetRepeatedEnumValue(to, field, index);
+    case FieldDescriptor::CPPTYPE_STRING: {
+      std::string scratch_from, scratch_to;
+      return rf->GetRepeatedStringReference(from, field, index,
+                                            &scratch_from) ==
+             rt->GetRepeatedStringReference(to, field, index, &scratch_to);
+    }
+    default:
+      ABSL_LOG(FATAL) << "Unexpected cpp_type: " << field->cpp_type();
+      return false;
+  }
+}
+
+void CopyRepeatedValue(const Message& from, Message* to,
+                       const FieldDescriptor* field, int index) {
+  const Reflection* rf = from.GetReflection();
+  const Reflection* rt = to->GetReflection();
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      rt->SetRepeatedInt32(to, field, index,
+                           rf->GetRepeatedInt32(from, field, index));
+      break;
+    case FieldDescriptor::CPPTYPE_INT64:
+      rt->SetRepeatedInt64(to, field, index,
+                           rf->GetRepeatedInt64(from, field, index));
+      break;
+    case FieldDescriptor::CPPTYPE_UINT32:
+      rt->SetRepeatedUInt32(to, field, index,
+                            rf->GetRepeatedUInt32(from, field, index));
+      break;
+    case FieldDescriptor::CPPTYPE_UINT64:
+      rt->SetRepeatedUInt64(to, field, index,
+                            rf->GetRepeatedUInt64(from, field, index));
+      break;
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      rt->SetRepeatedFloat(to, field, index,
+                           rf->GetRepeatedFloat(from, field, index));
+      break;
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      rt->SetRepeatedDouble(to, field, index,
+                            rf->GetRepeatedDouble(from, field, index));
+      break;
+    case FieldDescriptor::CPPTYPE_BOOL:
+      rt->SetRepeatedBool(to, field, index,
+                          rf->GetRepeatedBool(from, field, index));
+      break;
+    case FieldDescriptor::CPPTYPE_ENUM:
+      rt->SetRepeatedEnumValue(to, field, index,
+                               rf->GetRepeatedEnumValue(from, field, index));
+      break;
+    case FieldDescriptor::CPPTYPE_STRING:
+      rt->SetRepeatedString(to, field, index,
+                            rf->GetRepeatedString(from, field, index));
+      break;
+    default:
+      ABSL_LOG(FATAL) << "Unexpected cpp_type: " << field->cpp_type();
+      break;
+  }
+}
+
+void AppendRepeatedValue(const Message& from, Message* to,
+                         const FieldDescriptor* field, int index) {
+  const Reflection* rf = from.GetReflection();
+  const Reflection* rt = to->GetReflection();
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      rt->AddInt32(to, field, rf->GetRepeatedInt32(from, field, index));
+      break;
+    case FieldDescriptor::CPPTYPE_INT64:
+      rt->AddInt64(to, field, rf->GetRepeatedInt64(from, field, index));
+      break;
+    case FieldDescriptor::CPPTYPE_UINT32:
+      rt->AddUInt32(to, field, rf->GetRepeatedUInt32(from, field, index));
+      break;
+    case FieldDescriptor::CPPTYPE_UINT64:
+      rt->AddUInt64(to, field, rf->GetRepeatedUInt64(from, field, index));
+      break;
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      rt->AddFloat(to, field, rf->GetRepeatedFloat(from, field, index));
+      break;
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      rt->AddDouble(to, field, rf->GetRepeatedDouble(from, field, index));
+      break;
+    case FieldDescriptor::CPPTYPE_BOOL:
+      rt->AddBool(to, field, rf->GetRepeatedBool(from, field, index));
+      break;
+    case FieldDescriptor::CPPTYPE_ENUM:
+      rt->AddEnumValue(to, field,
+                       rf->GetRepeatedEnumValue(from, field, index));
+      break;
+    case FieldDescriptor::CPPTYPE_STRING:
+      rt->AddString(to, field, rf->GetRepeatedString(from, field, index));
+      break;
+    default:
+      ABSL_LOG(FATAL) << "Unexpected cpp_type: " << field->cpp_type();
+      break;
+  }
+}
+
+// Patches a repeated field element by element: the common prefix is updated
+// in place (preserving element addresses), extra snapshot elements are
+// appended, and stale trailing elements are removed.  Map fields are plain
+// repeated message fields under reflection and take the same path.
+bool ApplyRepeatedDiff(const Message& from, Message* to,
+                       const FieldDescriptor* field) {
+  const Reflection* rf = from.GetReflection();
+  const Reflection* rt = to->GetReflection();
+  const int from_size = rf->FieldSize(from, field);
+  int to_size = rt->FieldSize(*to, field);
+  const int common = std::min(from_size, to_size);
+  bool changed = false;
+  if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+    for (int i = 0; i < common; ++i) {
+      changed |= ApplyDiff(rf->GetRepeatedMessage(from, field, i),
+                           rt->MutableRepeatedMessage(to, field, i));
+    }
+    for (int i = common; i < from_size; ++i) {
+      rt->AddMessage(to, field)->CopyFrom(
+          rf->GetRepeatedMessage(from, field, i));
+      changed = true;
+    }
+  } else {
+    for (int i = 0; i < common; ++i) {
+      if (!RepeatedValueEquals(from, *to, field, i)) {
+        CopyRepeatedValue(from, to, field, i);
+        changed = true;
+      }
+    }
+    for (int i = common; i < from_size; ++i) {
+      AppendRepeatedValue(from, to, field, i);
+      changed = true;
+    }
+  }
+  while (to_size > from_size) {
+    rt->RemoveLast(to, field);
+    --to_size;
+    changed = true;
+  }
+  return changed;
+}
+
+// Copies a field that is present in the snapshot but not in `to`.
+bool CopyNewField(const Message& from, Message* to,
+                  const FieldDescriptor* field) {
+  if (field->is_repeated()) {
+    return ApplyRepeatedDiff(from, to, field);
+  }
+  if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+    // MutableMessage() revives a previously cleared submessage object if one
+    // is still allocated, so even newly present subtrees keep stable
+    // addresses across clear/set cycles.  Presence itself changed, so this
+    // counts as a modification regardless of the contents.
+    ApplyDiff(from.GetReflection()->GetMessage(from, field),
+              to->GetReflection()->MutableMessage(to, field));
+    return true;
+  }
+  CopySingularValue(from, to, field);
+  return true;
+}
+
+// Updates a field that is present on both sides.
+bool UpdateField(const Message& from, Message* to,
+                 const FieldDescriptor* field) {
+  if (field->is_repeated()) {
+    return ApplyRepeatedDiff(from, to, field);
+  }
+  if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+    return ApplyDiff(from.GetReflection()->GetMessage(from, field),
+                     to->GetReflection()->MutableMessage(to, field));
+  }
+  if (SingularValueEquals(from, *to, field)) {
+    return false;
+  }
+  CopySingularValue(from, to, field);
+  return true;
+}
+
+// Makes `to` equal to `from`, writing only where they differ.  Returns
+// whether `to` was modified.
+bool ApplyDiff(const Message& from, Message* to) {
+  const Reflection* rf = from.GetReflection();
+  const Reflection* rt = to->GetReflection();
+  std::vector<const FieldDescriptor*> from_fields;
+  std::vector<const FieldDescriptor*> to_fields;
+  rf->ListFields(from, &from_fields);
+  rt->ListFields(*to, &to_fields);
+
+  // Both lists are ordered by field number, so walk them like a merge.
+  bool changed = false;
+  size_t i = 0;
+  size_t j = 0;
+  while (i < from_fields.size() || j < to_fields.size()) {
+    const FieldDescriptor* ff =
+        i < from_fields.size() ? from_fields[i] : nullptr;
+    const FieldDescriptor* tf = j < to_fields.size() ? to_fields[j] : nullptr;
+    if (tf == nullptr || (ff != nullptr && ff->number() < tf->number())) {
+      changed |= CopyNewField(from, to, ff);
+      ++i;
+    } else if (ff == nullptr || tf->number() < ff->number()) {
+      // Absent from the snapshot: clear it, unless copying a oneof sibling
+      // above already did.
+      const bool still_present = tf->is_repeated()
+                                     ? rt->FieldSize(*to, tf) > 0
+                                     : rt->HasField(*to, tf);
+      if (still_present) {
+        rt->ClearField(to, tf);
+        changed = true;
+      }
+      ++j;
+    } else {
+      changed |= UpdateField(from, to, ff);
+      ++i;
+      ++j;
+    }
+  }
+
+  // Unknown fields are rare in this use case; replace them wholesale rather
+  // than diffing.
+  const UnknownFieldSet& from_unknown = rf->GetUnknownFields(from);
+  if (!from_unknown.empty() || !rt->GetUnknownFields(*to).empty()) {
+    UnknownFieldSet* to_unknown = rt->MutableUnknownFields(to);
+    to_unknown->Clear();
+    to_unknown->MergeFrom(from_unknown);
+    changed = true;
+  }
+  return changed;
+}
+
+}  // namespace
+
+bool MergeReparser::Reparse(absl::string_view wire, Message* existing) {
+  changed_ = false;
+  if (scratch_ == nullptr ||
+      scratch_->GetDescriptor() != existing->GetDescriptor()) {
+    scratch_.reset(existing->New());
+  }
+  if (!scratch_->ParseFromArray(wire.data(), static_cast<int>(wire.size()))) {
+    return false;
+  }
+  changed_ = ApplyDiff(*scratch_, existing);
+  return true;
+}
+
+bool MergeReparse(absl::string_view wire, Message* existing) {
+  MergeReparser reparser;
+  return reparser.Reparse(wire, existing);
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
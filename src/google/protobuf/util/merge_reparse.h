@@ -0,0 +1,76 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+// Incremental re-parse: applies a freshly received wire snapshot to an
+// existing message in place, touching only the fields that actually changed.
+// Subscribers that re-receive full snapshots where few fields differ can use
+// this instead of parsing into a fresh message and deep-comparing: unchanged
+// fields are never written, unchanged submessage and repeated-element objects
+// keep their addresses (so pointers held by downstream caches stay valid),
+// and steady-state updates allocate almost nothing.
+//
+// This is the consumer-side complement to util/message_delta.h: MessageDelta
+// avoids re-transmitting unchanged fields when the producer cooperates,
+// while MergeReparse copes with a wire that still carries full snapshots.
+
+#ifndef GOOGLE_PROTOBUF_UTIL_MERGE_REPARSE_H__
+#define GOOGLE_PROTOBUF_UTIL_MERGE_REPARSE_H__
+
+#include <memory>
+
+#include "absl/strings/string_view.h"
+#include "google/protobuf/message.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+// Applies wire snapshots to an existing message in place.  Holds a scratch
+// message of the target type that is reused across calls; since Clear()
+// retains submessage objects and repeated-field capacity, parsing successive
+// snapshots into the scratch allocates almost nothing once it has warmed up.
+// Not thread-safe; use one instance per consumer.
+class PROTOBUF_EXPORT MergeReparser {
+ public:
+  MergeReparser() = default;
+  MergeReparser(const MergeReparser&) = delete;
+  MergeReparser& operator=(const MergeReparser&) = delete;
+
+  // Parses `wire` as a full serialized snapshot of `existing`'s type and
+  // updates `existing` in place to equal the parse result: changed fields
+  // are overwritten, fields absent from the snapshot are cleared, and
+  // unchanged fields are left untouched.  Submessages are updated
+  // recursively through the existing objects, and repeated fields are
+  // patched element by element, so object addresses survive an update.
+  // Returns false and leaves `existing` unmodified if `wire` does not parse.
+  bool Reparse(absl::string_view wire, Message* existing);
+
+  // Whether the last successful Reparse() modified `existing`.  Unknown
+  // fields are replaced wholesale rather than compared, so a payload that
+  // carries unknown fields always reports a change.
+  bool changed() const { return changed_; }
+
+ private:
+  std::unique_ptr<Message> scratch_;
+  bool changed_ = false;
+};
+
+// Convenience wrapper around MergeReparser for one-off use.  Allocates a
+// scratch message per call; callers updating messages at a steady rate
+// should hold a MergeReparser to amortize the scratch across snapshots.
+PROTOBUF_EXPORT bool MergeReparse(absl::string_view wire, Message* existing);
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_MERGE_REPARSE_H__
@@ -0,0 +1,136 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/util/merge_reparse.h"
+
+#include <string>
+
+#include <gtest/gtest.h>
+#include "google/protobuf/test_util.h"
+#include "google/protobuf/unittest.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+using ::protobuf_unittest::TestAllTypes;
+
+TEST(MergeReparseTest, ParsesIntoEmptyMessage) {
+  TestAllTypes original;
+  TestUtil::SetAllFields(&original);
+
+  TestAllTypes target;
+  ASSERT_TRUE(MergeReparse(original.SerializeAsString(), &target));
+  TestUtil::ExpectAllFieldsSet(target);
+}
+
+TEST(MergeReparseTest, ReportsWhetherAnythingChanged) {
+  TestAllTypes original;
+  TestUtil::SetAllFields(&original);
+  TestAllTypes target;
+  target.CopyFrom(original);
+
+  MergeReparser reparser;
+  ASSERT_TRUE(reparser.Reparse(original.SerializeAsString(), &target));
+  EXPECT_FALSE(reparser.changed());
+
+  original.set_optional_int32(original.optional_int32() + 1);
+  ASSERT_TRUE(reparser.Reparse(original.SerializeAsString(), &target));
+  EXPECT_TRUE(reparser.changed());
+  EXPECT_EQ(target.optional_int32(), original.optional_int32());
+}
+
+TEST(MergeReparseTest, PreservesUnchangedSubmessageAddresses) {
+  TestAllTypes original;
+  TestUtil::SetAllFields(&original);
+  TestAllTypes target;
+  target.CopyFrom(original);
+  const TestAllTypes::NestedMessage* nested = &target.optional_nested_message();
+  const protobuf_unittest::ForeignMessage* foreign =
+      &target.optional_foreign_message();
+
+  // An update that leaves both submessages untouched.
+  original.set_optional_string("updated");
+  MergeReparser reparser;
+  ASSERT_TRUE(reparser.Reparse(original.SerializeAsString(), &target));
+  EXPECT_TRUE(reparser.changed());
+  EXPECT_EQ(&target.optional_nested_message(), nested);
+  EXPECT_EQ(&target.optional_foreign_message(), foreign);
+  EXPECT_EQ(target.optional_string(), "updated");
+
+  // Even a change inside a submessage is applied through the same object.
+  original.mutable_optional_nested_message()->set_bb(4242);
+  ASSERT_TRUE(reparser.Reparse(original.SerializeAsString(), &target));
+  EXPECT_EQ(&target.optional_nested_message(), nested);
+  EXPECT_EQ(target.optional_nested_message().bb(), 4242);
+}
+
+TEST(MergeReparseTest, ClearsFieldsAbsentFromSnapshot) {
+  TestAllTypes original;
+  TestUtil::SetAllFields(&original);
+  TestAllTypes target;
+  target.CopyFrom(original);
+
+  original.clear_optional_int32();
+  original.clear_optional_nested_message();
+  original.clear_repeated_string();
+  ASSERT_TRUE(MergeReparse(original.SerializeAsString(), &target));
+  EXPECT_FALSE(target.has_optional_int32());
+  EXPECT_FALSE(target.has_optional_nested_message());
+  EXPECT_EQ(target.repeated_string_size(), 0);
+}
+
+TEST(MergeReparseTest, PatchesRepeatedFieldsElementWise) {
+  TestAllTypes original;
+  original.add_repeated_int32(1);
+  original.add_repeated_int32(2);
+  original.add_repeated_int32(3);
+  original.add_repeated_nested_message()->set_bb(1);
+  original.add_repeated_nested_message()->set_bb(2);
+  TestAllTypes target;
+  target.CopyFrom(original);
+  const TestAllTypes::NestedMessage* first = &target.repeated_nested_message(0);
+
+  original.set_repeated_int32(1, 20);
+  original.add_repeated_nested_message()->set_bb(3);
+  MergeReparser reparser;
+  ASSERT_TRUE(reparser.Reparse(original.SerializeAsString(), &target));
+  EXPECT_TRUE(reparser.changed());
+  EXPECT_EQ(target.repeated_int32(1), 20);
+  ASSERT_EQ(target.repeated_nested_message_size(), 3);
+  EXPECT_EQ(&target.repeated_nested_message(0), first);
+  EXPECT_EQ(target.repeated_nested_message(2).bb(), 3);
+
+  original.mutable_repeated_int32()->RemoveLast();
+  ASSERT_TRUE(reparser.Reparse(original.SerializeAsString(), &target));
+  EXPECT_EQ(target.repeated_int32_size(), 2);
+}
+
+TEST(MergeReparseTest, SwitchesOneofMembers) {
+  TestAllTypes original;
+  original.set_oneof_uint32(11);
+  TestAllTypes target;
+  target.set_oneof_string("old");
+
+  ASSERT_TRUE(MergeReparse(original.SerializeAsString(), &target));
+  EXPECT_EQ(target.oneof_field_case(), TestAllTypes::kOneofUint32);
+  EXPECT_EQ(target.oneof_uint32(), 11u);
+}
+
+TEST(MergeReparseTest, LeavesTargetUntouchedOnParseFailure) {
+  TestAllTypes target;
+  target.set_optional_int32(7);
+  const std::string malformed("\x08", 1);  // field 1 tag with no payload
+  EXPECT_FALSE(MergeReparse(malformed, &target));
+  EXPECT_EQ(target.optional_int32(), 7);
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,199 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/util/message_delta.h"
+
+#include <string>
+
+#include "absl/log/absl_check.h"
+#include "absl/log/absl_log.h"
+#include "absl/strings/str_cat.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/field_mask.pb.h"
+#include "google/protobuf/message.h"
+#include "google/protobuf/util/field_mask_util.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+bool MessagesDiffer(const Message& base, const Message& current);
+
+// Compares the values of a singular field that is present in both messages.
+bool SingularValuesDiffer(const Message& base, const Message& current,
+                          const FieldDescriptor* field) {
+  const Reflection* base_reflection = base.GetReflection();
+  const Reflection* current_reflection = current.GetReflection();
+  switch (field->cpp_type()) {
+#define COMPARE_VALUE(TYPE, Name)                    \
+  case FieldDescriptor::CPPTYPE_##TYPE:              \
+    return base_reflection->Get##Name(base, field) != \
+           current_reflection->Get##Name(current, field);
+    COMPARE_VALUE(BOOL, Bool)
+    COMPARE_VALUE(INT32, Int32)
+    COMPARE_VALUE(INT64, Int64)
+    COMPARE_VALUE(UINT32, UInt32)
+    COMPARE_VALUE(UINT64, UInt64)
+    COMPARE_VALUE(FLOAT, Float)
+    COMPARE_VALUE(DOUBLE, Double)
+    COMPARE_VALUE(ENUM, EnumValue)
+#undef COMPARE_VALUE
+    case FieldDescriptor::CPPTYPE_STRING: {
+      std::string base_scratch, current_scratch;
+      return base_reflection->GetStringReference(base, field, &base_scratch) !=
+             current_reflection->GetStringReference(current, field,
+                                                    &current_scratch);
+    }
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      return MessagesDiffer(base_reflection->GetMessage(base, field),
+                            current_reflection->GetMessage(current, field));
+  }
+  ABSL_LOG(FATAL) << "Cannot get here";
+  return false;
+}
+
+bool SingularFieldsDiffer(const Message& base, const Message& current,
+                          const FieldDescriptor* field) {
+  const bool base_has = base.GetReflection()->HasField(base, field);
+  const bool current_has = current.GetReflection()->HasField(current, field);
+  if (base_has != current_has) return true;
+  return base_has && SingularValuesDiffer(base, current, field);
+}
+
+bool RepeatedFieldsDiffer(const Message& base, const Message& current,
+                          const FieldDescriptor* field) {
+  const Reflection* base_reflection = base.GetReflection();
+  const Reflection* current_reflection = current.GetReflection();
+  const int size = base_reflection->FieldSize(base, field);
+  if (size != current_reflection->FieldSize(current, field)) return true;
+  for (int i = 0; i < size; ++i) {
+    switch (field->cpp_type()) {
+#define COMPARE_VALUE(TYPE, Name)                                   \
+  case FieldDescriptor::CPPTYPE_##TYPE:                             \
+    if (base_reflection->GetRepeated##Name(base, field, i) !=       \
+        current_reflection->GetRepeated##Name(current, field, i)) { \
+      return true;                                                  \
+    }                                                               \
+    break;
+      COMPARE_VALUE(BOOL, Bool)
+      COMPARE_VALUE(INT32, Int32)
+      COMPARE_VALUE(INT64, Int64)
+      COMPARE_VALUE(UINT32, UInt32)
+      COMPARE_VALUE(UINT64, UInt64)
+      COMPARE_VALUE(FLOAT, Float)
+      COMPARE_VALUE(DOUBLE, Double)
+      COMPARE_VALUE(ENUM, EnumValue)
+#undef COMPARE_VALUE
+      case FieldDescriptor::CPPTYPE_STRING: {
+        std::string base_scratch, current_scratch;
+        if (base_reflection->GetRepeatedStringReference(base, field, i,
+                                                        &base_scratch) !=
+            current_reflection->GetRepeatedStringReference(current, field, i,
+                                                           &current_scratch)) {
+          return true;
+        }
+        break;
+      }
+      case FieldDescriptor::CPPTYPE_MESSAGE:
+        if (MessagesDiffer(
+                base_reflection->GetRepeatedMessage(base, field, i),
+                current_reflection->GetRepeatedMessage(current, field, i))) {
+          return true;
+        }
+        break;
+    }
+  }
+  return false;
+}
+
+bool MessagesDiffer(const Message& base, const Message& current) {
+  const Descriptor* descriptor = base.GetDescriptor();
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    const FieldDescriptor* field = descriptor->field(i);
+    if (field->is_repeated()) {
+      if (RepeatedFieldsDiffer(base, current, field)) return true;
+    } else {
+      if (SingularFieldsDiffer(base, current, field)) return true;
+    }
+  }
+  return false;
+}
+
+// Appends to `mask` one path per field whose value differs between `base`
+// and `current`.  Singular message fields present in both messages are
+// descended into so that a change deep inside a large submessage yields a
+// leaf path rather than replacing the whole subtree.
+void DiffMessage(const Message& base, const Message& current,
+                 const std::string& prefix, FieldMask* mask) {
+  const Reflection* base_reflection = base.GetReflection();
+  const Reflection* current_reflection = current.GetReflection();
+  const Descriptor* descriptor = base.GetDescriptor();
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    const FieldDescriptor* field = descriptor->field(i);
+    if (field->is_repeated()) {
+      if (RepeatedFieldsDiffer(base, current, field)) {
+        mask->add_paths(absl::StrCat(prefix, field->name()));
+      }
+      continue;
+    }
+    const bool base_has = base_reflection->HasField(base, field);
+    const bool current_has = current_reflection->HasField(current, field);
+    if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE && base_has &&
+        current_has) {
+      DiffMessage(base_reflection->GetMessage(base, field),
+                  current_reflection->GetMessage(current, field),
+                  absl::StrCat(prefix, field->name(), "."), mask);
+      continue;
+    }
+    if (base_has != current_has ||
+        (base_has && SingularValuesDiffer(base, current, field))) {
+      mask->add_paths(absl::StrCat(prefix, field->name()));
+    }
+  }
+}
+
+FieldMaskUtil::MergeOptions DeltaMergeOptions() {
+  FieldMaskUtil::MergeOptions options;
+  // A delta path carries the full new value of the field it names: repeated
+  // fields and submessages named by a leaf path must replace their
+  // counterparts rather than append or merge into them, and a path whose
+  // field is unset in the delta clears that field.
+  options.set_replace_message_fields(true);
+  options.set_replace_repeated_fields(true);
+  return options;
+}
+
+}  // namespace
+
+void MessageDelta::Compute(const Message& base, const Message& current,
+                           FieldMask* mask, Message* delta) {
+  ABSL_DCHECK_EQ(base.GetDescriptor(), current.GetDescriptor())
+      << "Cannot compute a delta between messages of different types.";
+  ABSL_DCHECK_EQ(current.GetDescriptor(), delta->GetDescriptor())
+      << "The delta message must have the same type as its inputs.";
+  mask->Clear();
+  delta->Clear();
+  DiffMessage(base, current, "", mask);
+  FieldMaskUtil::MergeMessageTo(current, *mask, DeltaMergeOptions(), delta);
+}
+
+void MessageDelta::Apply(const FieldMask& mask, const Message& delta,
+                         Message* target) {
+  ABSL_DCHECK_EQ(delta.GetDescriptor(), target->GetDescriptor())
+      << "Cannot apply a delta to a message of a different type.";
+  FieldMaskUtil::MergeMessageTo(delta, mask, DeltaMergeOptions(), target);
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
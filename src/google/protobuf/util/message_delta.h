@@ -0,0 +1,73 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef GOOGLE_PROTOBUF_UTIL_MESSAGE_DELTA_H__
+#define GOOGLE_PROTOBUF_UTIL_MESSAGE_DELTA_H__
+
+#include "google/protobuf/field_mask.pb.h"
+#include "google/protobuf/message.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+// Computes and applies compact differences between two messages of the same
+// type, for replicating streams of mostly-unchanged snapshots without
+// re-transmitting the whole message each time.
+//
+// The producer side diffs the previous snapshot against the current one:
+//
+//   FieldMask mask;
+//   std::unique_ptr<Message> delta(current.New());
+//   MessageDelta::Compute(previous, current, &mask, delta.get());
+//   // Ship `mask` and `delta` (typically far smaller than `current`).
+//
+// The consumer side applies the delta to its copy of the previous snapshot:
+//
+//   MessageDelta::Apply(mask, delta, &replica);  // replica == current
+//
+// The delta names changed fields by FieldMask paths: singular message fields
+// are descended into, so an unchanged large submessage with one modified leaf
+// costs only that leaf.  Repeated and map fields are replaced wholesale when
+// any element changed, and a path with an unset field in the delta clears
+// that field on apply.
+class PROTOBUF_EXPORT MessageDelta {
+  typedef google::protobuf::FieldMask FieldMask;
+
+ public:
+  MessageDelta() = delete;
+
+  // Computes the difference between `base` and `current`.  All three message
+  // arguments must be of the same type; `mask` and `delta` are overwritten.
+  // On return, `mask` holds one path per changed field and `delta` holds the
+  // values those paths have in `current`.
+  //
+  // Fields are compared by presence and value.  Unknown fields and extensions
+  // are not diffed and never appear in the delta.  Map fields are compared
+  // entry-wise in iteration order, so an equal map that merely iterates in a
+  // different order may be reported as changed; the delta still applies
+  // correctly, it is just not minimal.
+  static void Compute(const Message& base, const Message& current,
+                      FieldMask* mask, Message* delta);
+
+  // Applies a delta produced by Compute() to `target`.  If `target` equals
+  // the `base` the delta was computed from, it equals `current` afterwards
+  // (modulo unknown fields and extensions, which are left untouched).
+  static void Apply(const FieldMask& mask, const Message& delta,
+                    Message* target);
+};
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_MESSAGE_DELTA_H__
@@ -0,0 +1,136 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/util/message_delta.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "google/protobuf/field_mask.pb.h"
+#include "google/protobuf/unittest.pb.h"
+#include "google/protobuf/util/message_differencer.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+using ::protobuf_unittest::NestedTestAllTypes;
+using ::protobuf_unittest::TestAllTypes;
+using ::testing::UnorderedElementsAre;
+
+TEST(MessageDeltaTest, EqualMessagesYieldEmptyDelta) {
+  TestAllTypes base;
+  base.set_optional_int32(1);
+  base.add_repeated_string("x");
+  TestAllTypes current = base;
+
+  FieldMask mask;
+  TestAllTypes delta;
+  MessageDelta::Compute(base, current, &mask, &delta);
+
+  EXPECT_EQ(mask.paths_size(), 0);
+  EXPECT_EQ(delta.ByteSizeLong(), 0);
+}
+
+TEST(MessageDeltaTest, ComputeAndApplyRoundTrips) {
+  TestAllTypes base;
+  base.set_optional_int32(1);
+  base.set_optional_string("unchanged");
+  base.set_optional_uint64(99);  // Cleared in current.
+  base.add_repeated_int32(1);
+  base.mutable_optional_nested_message()->set_bb(5);
+
+  TestAllTypes current = base;
+  current.set_optional_int32(2);
+  current.clear_optional_uint64();
+  current.add_repeated_int32(7);
+  current.mutable_optional_nested_message()->set_bb(6);
+
+  FieldMask mask;
+  TestAllTypes delta;
+  MessageDelta::Compute(base, current, &mask, &delta);
+
+  EXPECT_THAT(mask.paths(),
+              UnorderedElementsAre("optional_int32", "optional_uint64",
+                                   "repeated_int32",
+                                   "optional_nested_message.bb"));
+  // The unchanged fields do not ride along in the delta.
+  EXPECT_FALSE(delta.has_optional_string());
+
+  TestAllTypes replica = base;
+  MessageDelta::Apply(mask, delta, &replica);
+  EXPECT_TRUE(MessageDifferencer::Equals(replica, current));
+}
+
+TEST(MessageDeltaTest, DeepChangeYieldsLeafPath) {
+  NestedTestAllTypes base;
+  base.mutable_child()->mutable_payload()->set_optional_int32(1);
+  base.mutable_child()->mutable_payload()->set_optional_string("big");
+
+  NestedTestAllTypes current = base;
+  current.mutable_child()->mutable_payload()->set_optional_int32(2);
+
+  FieldMask mask;
+  NestedTestAllTypes delta;
+  MessageDelta::Compute(base, current, &mask, &delta);
+
+  // Only the changed leaf is named and shipped, not the whole subtree.
+  EXPECT_THAT(mask.paths(),
+              UnorderedElementsAre("child.payload.optional_int32"));
+  EXPECT_FALSE(delta.child().payload().has_optional_string());
+
+  NestedTestAllTypes replica = base;
+  MessageDelta::Apply(mask, delta, &replica);
+  EXPECT_TRUE(MessageDifferencer::Equals(replica, current));
+}
+
+TEST(MessageDeltaTest, PresenceChangesReplaceWholeSubmessage) {
+  NestedTestAllTypes base;
+  base.mutable_child()->mutable_payload()->set_optional_int32(1);
+  base.mutable_payload()->set_optional_int32(3);
+
+  NestedTestAllTypes current = base;
+  current.mutable_child()->clear_payload();  // Cleared submessage.
+  current.clear_payload();
+  current.mutable_payload()->set_optional_string("new");  // Replaced content.
+
+  FieldMask mask;
+  NestedTestAllTypes delta;
+  MessageDelta::Compute(base, current, &mask, &delta);
+
+  EXPECT_THAT(mask.paths(),
+              UnorderedElementsAre("child.payload", "payload.optional_int32",
+                                   "payload.optional_string"));
+
+  NestedTestAllTypes replica = base;
+  MessageDelta::Apply(mask, delta, &replica);
+  EXPECT_TRUE(MessageDifferencer::Equals(replica, current));
+}
+
+TEST(MessageDeltaTest, OneofSwitchClearsPreviousMember) {
+  TestAllTypes base;
+  base.set_oneof_uint32(11);
+
+  TestAllTypes current;
+  current.set_oneof_string("eleven");
+
+  FieldMask mask;
+  TestAllTypes delta;
+  MessageDelta::Compute(base, current, &mask, &delta);
+
+  EXPECT_THAT(mask.paths(),
+              UnorderedElementsAre("oneof_uint32", "oneof_string"));
+
+  TestAllTypes replica = base;
+  MessageDelta::Apply(mask, delta, &replica);
+  EXPECT_TRUE(MessageDifferencer::Equals(replica, current));
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
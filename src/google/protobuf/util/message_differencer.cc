@@ -14,6 +14,7 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <functional>
 #include <limits>
 #include <memory>
@@ -65,6 +66,23 @@ std::string PrintShortTextFormat(const google::protobuf::Message& message) {
   return debug_string;
 }
 
+// Returns true if the repeated field holds scalars whose default comparison
+// is bitwise equality. Floating point types are excluded because bitwise and
+// semantic equality disagree on NaN and signed zero.
+bool IsBitwiseComparableScalar(const FieldDescriptor* field) {
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+    case FieldDescriptor::CPPTYPE_INT64:
+    case FieldDescriptor::CPPTYPE_UINT32:
+    case FieldDescriptor::CPPTYPE_UINT64:
+    case FieldDescriptor::CPPTYPE_BOOL:
+    case FieldDescriptor::CPPTYPE_ENUM:
+      return true;
+    default:
+      return false;
+  }
+}
+
 }  // namespace
 
 // A reporter to report the total number of diffs.
@@ -265,8 +283,134 @@ bool MessageDifferencer::MapEntryKeyComparator::IsMatch(
       message1, message2, unpacked_any, key, -1, -1, &current_parent_fields);
 }
 
+namespace {
+
+// Result of the allocation-free equality walk used by Equals().
+enum class FastEqualsResult { kEqual, kDifferent, kUndecided };
+
+FastEqualsResult FastEquals(const Message& message1, const Message& message2);
+
+// Compares one value of a non-map field.  `index` is -1 for singular fields.
+FastEqualsResult FastEqualsValue(const Message& message1,
+                                 const Message& message2,
+                                 const Reflection* reflection1,
+                                 const Reflection* reflection2,
+                                 const FieldDescriptor* field, int index) {
+  switch (field->cpp_type()) {
+#define PROTOBUF_IMPL_FAST_EQUALS_CASE(CPPTYPE, METHOD)                     \
+  case FieldDescriptor::CPPTYPE_##CPPTYPE: {                                \
+    const auto value1 =                                                     \
+        index < 0 ? reflection1->Get##METHOD(message1, field)               \
+                  : reflection1->GetRepeated##METHOD(message1, field,       \
+                                                     index);                \
+    const auto value2 =                                                     \
+        index < 0 ? reflection2->Get##METHOD(message2, field)               \
+                  : reflection2->GetRepeated##METHOD(message2, field,       \
+                                                     index);                \
+    return value1 == value2 ? FastEqualsResult::kEqual                      \
+                            : FastEqualsResult::kDifferent;                 \
+  }
+    PROTOBUF_IMPL_FAST_EQUALS_CASE(INT32, Int32)
+    PROTOBUF_IMPL_FAST_EQUALS_CASE(INT64, Int64)
+    PROTOBUF_IMPL_FAST_EQUALS_CASE(UINT32, UInt32)
+    PROTOBUF_IMPL_FAST_EQUALS_CASE(UINT64, UInt64)
+    PROTOBUF_IMPL_FAST_EQUALS_CASE(BOOL, Bool)
+    // NaN != NaN under ==, which matches the EXACT float comparison of a
+    // default-configured differencer.
+    PROTOBUF_IMPL_FAST_EQUALS_CASE(FLOAT, Float)
+    PROTOBUF_IMPL_FAST_EQUALS_CASE(DOUBLE, Double)
+    PROTOBUF_IMPL_FAST_EQUALS_CASE(ENUM, EnumValue)
+#undef PROTOBUF_IMPL_FAST_EQUALS_CASE
+    case FieldDescriptor::CPPTYPE_STRING: {
+      std::string scratch1, scratch2;
+      const std::string& value1 =
+          index < 0
+              ? reflection1->GetStringReference(message1, field, &scratch1)
+              : reflection1->GetRepeatedStringReference(message1, field, index,
+                                                        &scratch1);
+      const std::string& value2 =
+          index < 0
+              ? reflection2->GetStringReference(message2, field, &scratch2)
+              : reflection2->GetRepeatedStringReference(message2, field, index,
+                                                        &scratch2);
+      return value1 == value2 ? FastEqualsResult::kEqual
+                              : FastEqualsResult::kDifferent;
+    }
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      return FastEquals(
+          index < 0 ? reflection1->GetMessage(message1, field)
+                    : reflection1->GetRepeatedMessage(message1, field, index),
+          index < 0 ? reflection2->GetMessage(message2, field)
+                    : reflection2->GetRepeatedMessage(message2, field, index));
+  }
+  return FastEqualsResult::kUndecided;
+}
+
+// Early-exit equality walk for a default-configured differencer: ordered
+// repeated fields, EQUAL message field comparison, EXACT float comparison,
+// FULL scope.  Bails out (kUndecided) on the cases Compare() models
+// specially -- Any unpacking, map fields, extensions and unknown fields --
+// so the caller can fall back to the full engine.  Unlike Compare() it
+// builds no field lists and stops at the first difference.
+FastEqualsResult FastEquals(const Message& message1, const Message& message2) {
+  const Descriptor* descriptor = message1.GetDescriptor();
+  if (descriptor != message2.GetDescriptor() ||
+      descriptor->extension_range_count() > 0 ||
+      descriptor->full_name() == internal::kAnyFullTypeName) {
+    return FastEqualsResult::kUndecided;
+  }
+  const Reflection* reflection1 = message1.GetReflection();
+  const Reflection* reflection2 = message2.GetReflection();
+  if (!reflection1->GetUnknownFields(message1).empty() ||
+      !reflection2->GetUnknownFields(message2).empty()) {
+    return FastEqualsResult::kUndecided;
+  }
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    const FieldDescriptor* field = descriptor->field(i);
+    if (field->is_map()) {
+      // Map fields compare unordered; leave them to the full differencer.
+      return FastEqualsResult::kUndecided;
+    }
+    if (field->is_repeated()) {
+      const int size = reflection1->FieldSize(message1, field);
+      if (size != reflection2->FieldSize(message2, field)) {
+        return FastEqualsResult::kDifferent;
+      }
+      for (int index = 0; index < size; ++index) {
+        const FastEqualsResult result = FastEqualsValue(
+            message1, message2, reflection1, reflection2, field, index);
+        if (result != FastEqualsResult::kEqual) return result;
+      }
+      continue;
+    }
+    if (field->has_presence()) {
+      const bool has1 = reflection1->HasField(message1, field);
+      if (has1 != reflection2->HasField(message2, field)) {
+        return FastEqualsResult::kDifferent;
+      }
+      if (!has1) continue;
+    }
+    const FastEqualsResult result = FastEqualsValue(
+        message1, message2, reflection1, reflection2, field, -1);
+    if (result != FastEqualsResult::kEqual) return result;
+  }
+  return FastEqualsResult::kEqual;
+}
+
+}  // namespace
+
 bool MessageDifferencer::Equals(const Message& message1,
                                 const Message& message2) {
+  // Most equality checks need only a boolean answer; walk the messages with
+  // early exit before paying for the reporting-capable engine.
+  switch (FastEquals(message1, message2)) {
+    case FastEqualsResult::kEqual:
+      return true;
+    case FastEqualsResult::kDifferent:
+      return false;
+    case FastEqualsResult::kUndecided:
+      break;
+  }
   MessageDifferencer differencer;
 
   return differencer.Compare(message1, message2);
@@ -1223,6 +1367,39 @@ bool MessageDifferencer::CompareRepeatedField(
                             parent_fields);
 }
 
+bool MessageDifferencer::RepeatedFieldsBitwiseEqual(
+    const Message& message1, const Message& message2,
+    const FieldDescriptor* field, int count) {
+  if (count == 0) return true;
+  const Reflection* reflection1 = message1.GetReflection();
+  const Reflection* reflection2 = message2.GetReflection();
+  switch (field->cpp_type()) {
+#define HANDLE_TYPE(CPPTYPE, TYPE)                                          \
+  case FieldDescriptor::CPPTYPE_##CPPTYPE:                                  \
+    return memcmp(                                                          \
+               reflection1->GetRepeatedFieldInternal<TYPE>(message1, field) \
+                   .data(),                                                 \
+               reflection2->GetRepeatedFieldInternal<TYPE>(message2, field) \
+                   .data(),                                                 \
+               static_cast<size_t>(count) * sizeof(TYPE)) == 0
+
+    HANDLE_TYPE(INT32, int32_t);
+    HANDLE_TYPE(INT64, int64_t);
+    HANDLE_TYPE(UINT32, uint32_t);
+    HANDLE_TYPE(UINT64, uint64_t);
+    HANDLE_TYPE(BOOL, bool);
+    // Raw int32_t access is allowed for enum fields and bitwise-equal values
+    // always map to the same enum value descriptor.
+    HANDLE_TYPE(ENUM, int32_t);
+#undef HANDLE_TYPE
+
+    default:
+      ABSL_DCHECK(false) << "Not a bitwise comparable scalar type: "
+                         << field->cpp_type_name();
+      return false;
+  }
+}
+
 bool MessageDifferencer::CompareRepeatedRep(
     const Message& message1, const Message& message2, int unpacked_any,
     const FieldDescriptor* repeated_field,
@@ -1258,6 +1435,18 @@ bool MessageDifferencer::CompareRepeatedRep(
                      !IsTreatedAsSet(repeated_field) &&
                      !IsTreatedAsSmartSet(repeated_field) && !smart_list;
 
+  // Fast path: compare trivially comparable scalar arrays through their
+  // underlying storage instead of with per-element reflection calls. This
+  // only applies under default, bitwise comparison semantics and without a
+  // reporter, where the first difference ends the comparison, so there is
+  // no need to localize mismatched elements.
+  if (simple_list && reporter_ == nullptr && !treated_as_subset &&
+      count1 == count2 && field_comparator_kind_ == kFCDefault &&
+      IsBitwiseComparableScalar(repeated_field)) {
+    return RepeatedFieldsBitwiseEqual(message1, message2, repeated_field,
+                                      count1);
+  }
+
   // For simple lists, we avoid matching repeated field indices, saving the
   // memory allocations that would otherwise be needed for match_list1 and
   // match_list2.
@@ -826,6 +826,16 @@ class PROTOBUF_EXPORT MessageDifferencer {
                           int unpacked_any, const FieldDescriptor* field,
                           std::vector<SpecificField>* parent_fields);
 
+  // Helper for CompareRepeatedRep: compares two repeated scalar fields of
+  // equal size by comparing their underlying storage directly, avoiding
+  // per-element reflection calls. Returns true iff the fields are equal.
+  // REQUIRES: the field's type has bitwise default comparison semantics
+  // (integral types; floating point disagrees on NaN and signed zero).
+  static bool RepeatedFieldsBitwiseEqual(const Message& message1,
+                                         const Message& message2,
+                                         const FieldDescriptor* field,
+                                         int count);
+
   // Helper for CompareMapField: compare the map fields using map reflection
   // instead of sync to repeated.
   bool CompareMapFieldByMapReflection(const Message& message1,
@@ -14,6 +14,7 @@
 #include "google/protobuf/util/message_differencer.h"
 
 #include <algorithm>
+#include <limits>
 #include <random>
 #include <string>
 #include <vector>
@@ -136,6 +137,73 @@ TEST(MessageDifferencerTest, RepeatedFieldInequalityTest) {
   EXPECT_FALSE(util::MessageDifferencer::Equals(msg1, msg2));
 }
 
+TEST(MessageDifferencerTest, RepeatedScalarBulkCompareTest) {
+  // Identical scalar arrays take the bitwise bulk-compare fast path; the
+  // result must match element-wise comparison.
+  unittest::TestAllTypes msg1;
+  unittest::TestAllTypes msg2;
+  for (int i = 0; i < 1024; ++i) {
+    msg1.add_repeated_int32(i);
+    msg2.add_repeated_int32(i);
+    msg1.add_repeated_int64(int64_t{1} << (i % 63));
+    msg2.add_repeated_int64(int64_t{1} << (i % 63));
+  }
+
+  util::MessageDifferencer differencer;
+  EXPECT_TRUE(differencer.Compare(msg1, msg2));
+
+  // A single mismatched element anywhere in the array is still detected.
+  msg2.set_repeated_int32(1023, -1);
+  EXPECT_FALSE(differencer.Compare(msg1, msg2));
+
+  // With a reporter attached, the element-wise path localizes the mismatch.
+  std::string diff;
+  differencer.ReportDifferencesToString(&diff);
+  EXPECT_FALSE(differencer.Compare(msg1, msg2));
+  EXPECT_THAT(diff, testing::HasSubstr("repeated_int32[1023]"));
+}
+
+TEST(MessageDifferencerTest, EqualsTreatsNanAsUnequal) {
+  // The early-exit walk inside Equals() must preserve EXACT float
+  // comparison semantics, under which NaN != NaN.
+  unittest::TestAllTypes msg1;
+  unittest::TestAllTypes msg2;
+
+  msg1.set_optional_float(std::numeric_limits<float>::quiet_NaN());
+  msg2.set_optional_float(std::numeric_limits<float>::quiet_NaN());
+
+  EXPECT_FALSE(util::MessageDifferencer::Equals(msg1, msg2));
+}
+
+TEST(MessageDifferencerTest, EqualsDistinguishesDefaultFromUnset) {
+  // EQUAL (as opposed to EQUIVALENT) comparison treats a field explicitly
+  // set to its default value as different from an unset field.
+  unittest::TestAllTypes msg1;
+  unittest::TestAllTypes msg2;
+
+  msg1.set_optional_int32(0);
+
+  EXPECT_FALSE(util::MessageDifferencer::Equals(msg1, msg2));
+  EXPECT_TRUE(util::MessageDifferencer::Equivalent(msg1, msg2));
+}
+
+TEST(MessageDifferencerTest, EqualsComparesMapsUnordered) {
+  // Map fields must keep their unordered comparison semantics regardless of
+  // which engine Equals() uses.
+  unittest::TestMap msg1;
+  unittest::TestMap msg2;
+
+  (*msg1.mutable_map_int32_int32())[1] = 10;
+  (*msg1.mutable_map_int32_int32())[2] = 20;
+  (*msg2.mutable_map_int32_int32())[2] = 20;
+  (*msg2.mutable_map_int32_int32())[1] = 10;
+
+  EXPECT_TRUE(util::MessageDifferencer::Equals(msg1, msg2));
+
+  (*msg2.mutable_map_int32_int32())[1] = 11;
+  EXPECT_FALSE(util::MessageDifferencer::Equals(msg1, msg2));
+}
+
 TEST(MessageDifferencerTest, RepeatedFieldSetOptimizationTest) {
   util::MessageDifferencer differencer;
   protobuf_unittest::TestDiffMessage msg1;
@@ -0,0 +1,729 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/util/mini_descriptor.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/descriptor.pb.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+// Wire constants of the mini descriptor format.  These mirror
+// upb/mini_descriptor/internal/wire_constants.h; the two runtimes must stay
+// byte-for-byte compatible.
+enum EncodedType {
+  kEncodedTypeDouble = 0,
+  kEncodedTypeFloat = 1,
+  kEncodedTypeFixed32 = 2,
+  kEncodedTypeFixed64 = 3,
+  kEncodedTypeSFixed32 = 4,
+  kEncodedTypeSFixed64 = 5,
+  kEncodedTypeInt32 = 6,
+  kEncodedTypeUInt32 = 7,
+  kEncodedTypeSInt32 = 8,
+  kEncodedTypeInt64 = 9,
+  kEncodedTypeUInt64 = 10,
+  kEncodedTypeSInt64 = 11,
+  kEncodedTypeOpenEnum = 12,
+  kEncodedTypeBool = 13,
+  kEncodedTypeBytes = 14,
+  kEncodedTypeString = 15,
+  kEncodedTypeGroup = 16,
+  kEncodedTypeMessage = 17,
+  kEncodedTypeClosedEnum = 18,
+
+  kEncodedTypeRepeatedBase = 20,
+};
+
+enum EncodedFieldModifier {
+  kFieldModifierFlipPacked = 1 << 0,
+  kFieldModifierIsRequired = 1 << 1,
+  kFieldModifierIsProto3Singular = 1 << 2,
+  kFieldModifierFlipValidateUtf8 = 1 << 3,
+};
+
+enum EncodedMessageModifier {
+  kMessageModifierValidateUtf8 = 1 << 0,
+  kMessageModifierDefaultIsPacked = 1 << 1,
+  kMessageModifierIsExtendable = 1 << 2,
+};
+
+constexpr char kVersionEnum = '!';
+constexpr char kVersionMap = '%';
+constexpr char kVersionMessage = '$';
+constexpr char kVersionMessageSet = '&';
+
+constexpr char kMinField = ' ';
+constexpr char kMaxField = 'I';
+constexpr char kMinModifier = 'L';
+constexpr char kMaxModifier = '[';
+constexpr char kEnd = '^';
+constexpr char kMinSkip = '_';
+constexpr char kMaxSkip = '~';
+constexpr char kOneofSeparator = '~';
+constexpr char kFieldSeparator = '|';
+constexpr char kMinOneofField = ' ';
+constexpr char kMaxOneofField = 'b';
+constexpr char kMaxEnumMask = 'A';
+
+// Base92 alphabet: all printable ASCII except ' (apostrophe), " and \,
+// making the strings safe to embed in source literals of most languages.
+constexpr char kToBase92[] = {
+    ' ', '!', '#', '$', '%', '&', '(', ')', '*', '+', ',', '-', '.', '/',
+    '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', ':', ';', '<', '=',
+    '>', '?', '@', 'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K',
+    'L', 'M', 'N', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y',
+    'Z', '[', ']', '^', '_', '`', 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h',
+    'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v',
+    'w', 'x', 'y', 'z', '{', '|', '}', '~',
+};
+
+int8_t FromBase92(char ch) {
+  static constexpr int8_t kFromBase92[] = {
+      0,  1,  -1, 2,  3,  4,  5,  -1, 6,  7,  8,  9,  10, 11, 12, 13,
+      14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29,
+      30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45,
+      46, 47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57, -1, 58, 59, 60,
+      61, 62, 63, 64, 65, 66, 67, 68, 69, 70, 71, 72, 73, 74, 75, 76,
+      77, 78, 79, 80, 81, 82, 83, 84, 85, 86, 87, 88, 89, 90, 91,
+  };
+  const uint8_t u = static_cast<uint8_t>(ch);
+  if (u < ' ' || u > '~') return -1;
+  return kFromBase92[u - ' '];
+}
+
+int Log2Ceiling(uint32_t value) {
+  int bits = 0;
+  while ((uint32_t{1} << bits) < value) ++bits;
+  return bits;
+}
+
+// Little-endian base92 varint in the character range [min, max]; a char
+// outside the range terminates the value.
+void PutBase92Varint(uint32_t value, char min, char max, std::string* out) {
+  const int shift = Log2Ceiling(FromBase92(max) - FromBase92(min) + 1);
+  const uint32_t mask = (uint32_t{1} << shift) - 1;
+  do {
+    out->push_back(kToBase92[(value & mask) + FromBase92(min)]);
+    value >>= shift;
+  } while (value != 0);
+}
+
+void PutModifier(uint32_t modifier, std::string* out) {
+  if (modifier != 0) {
+    PutBase92Varint(modifier, kMinModifier, kMaxModifier, out);
+  }
+}
+
+// `first_ch` has already been consumed from `data`; continuation chars are
+// consumed while they stay inside [min, max].
+bool DecodeBase92Varint(absl::string_view data, size_t* pos, char first_ch,
+                        char min, char max, uint32_t* out) {
+  const int shift = Log2Ceiling(FromBase92(max) - FromBase92(min) + 1);
+  uint32_t value = 0;
+  int bits = 0;
+  char ch = first_ch;
+  while (true) {
+    value |= static_cast<uint32_t>(FromBase92(ch) - FromBase92(min)) << bits;
+    if (*pos >= data.size() || data[*pos] < min || max < data[*pos]) {
+      *out = value;
+      return true;
+    }
+    ch = data[(*pos)++];
+    bits += shift;
+    if (bits >= 32) return false;
+  }
+}
+
+int EncodedFieldType(const FieldDescriptor* field) {
+  switch (field->type()) {
+    case FieldDescriptor::TYPE_DOUBLE:
+      return kEncodedTypeDouble;
+    case FieldDescriptor::TYPE_FLOAT:
+      return kEncodedTypeFloat;
+    case FieldDescriptor::TYPE_FIXED32:
+      return kEncodedTypeFixed32;
+    case FieldDescriptor::TYPE_FIXED64:
+      return kEncodedTypeFixed64;
+    case FieldDescriptor::TYPE_SFIXED32:
+      return kEncodedTypeSFixed32;
+    case FieldDescriptor::TYPE_SFIXED64:
+      return kEncodedTypeSFixed64;
+    case FieldDescriptor::TYPE_INT32:
+      return kEncodedTypeInt32;
+    case FieldDescriptor::TYPE_UINT32:
+      return kEncodedTypeUInt32;
+    case FieldDescriptor::TYPE_SINT32:
+      return kEncodedTypeSInt32;
+    case FieldDescriptor::TYPE_INT64:
+      return kEncodedTypeInt64;
+    case FieldDescriptor::TYPE_UINT64:
+      return kEncodedTypeUInt64;
+    case FieldDescriptor::TYPE_SINT64:
+      return kEncodedTypeSInt64;
+    case FieldDescriptor::TYPE_ENUM:
+      return field->enum_type()->is_closed() ? kEncodedTypeClosedEnum
+                                             : kEncodedTypeOpenEnum;
+    case FieldDescriptor::TYPE_BOOL:
+      return kEncodedTypeBool;
+    case FieldDescriptor::TYPE_BYTES:
+      return kEncodedTypeBytes;
+    case FieldDescriptor::TYPE_STRING:
+      return kEncodedTypeString;
+    case FieldDescriptor::TYPE_GROUP:
+      return kEncodedTypeGroup;
+    case FieldDescriptor::TYPE_MESSAGE:
+      return kEncodedTypeMessage;
+  }
+  return kEncodedTypeMessage;  // Unreachable; silences -Wreturn-type.
+}
+
+// The message-level ValidateUtf8 modifier is only set when every string
+// field validates, so that runtimes which ignore the per-field flip err on
+// the lax side rather than the strict one.
+bool MessageValidatesUtf8(const Descriptor* message) {
+  bool has_string = false;
+  for (int i = 0; i < message->field_count(); ++i) {
+    const FieldDescriptor* field = message->field(i);
+    if (field->type() != FieldDescriptor::TYPE_STRING) continue;
+    if (!field->requires_utf8_validation()) return false;
+    has_string = true;
+  }
+  return has_string;
+}
+
+void PutField(const FieldDescriptor* field, uint32_t msg_modifiers,
+              uint32_t* last_field_number, std::string* out) {
+  const uint32_t number = static_cast<uint32_t>(field->number());
+  if (number != *last_field_number + 1) {
+    PutBase92Varint(number - *last_field_number, kMinSkip, kMaxSkip, out);
+  }
+  *last_field_number = number;
+
+  int encoded_type = EncodedFieldType(field);
+  if (field->is_repeated()) encoded_type += kEncodedTypeRepeatedBase;
+  out->push_back(kToBase92[encoded_type]);
+
+  uint32_t modifiers = 0;
+  if (field->is_packable()) {
+    const bool default_is_packed =
+        (msg_modifiers & kMessageModifierDefaultIsPacked) != 0;
+    if (field->is_packed() != default_is_packed) {
+      modifiers |= kFieldModifierFlipPacked;
+    }
+  }
+  if (field->type() == FieldDescriptor::TYPE_STRING) {
+    const bool message_validates =
+        (msg_modifiers & kMessageModifierValidateUtf8) != 0;
+    if (field->requires_utf8_validation() != message_validates) {
+      modifiers |= kFieldModifierFlipValidateUtf8;
+    }
+  }
+  if (!field->is_repeated() && !field->has_presence()) {
+    modifiers |= kFieldModifierIsProto3Singular;
+  }
+  if (field->is_required()) {
+    modifiers |= kFieldModifierIsRequired;
+  }
+  PutModifier(modifiers, out);
+}
+
+bool IsPackableType(FieldDescriptorProto::Type type) {
+  switch (type) {
+    case FieldDescriptorProto::TYPE_STRING:
+    case FieldDescriptorProto::TYPE_BYTES:
+    case FieldDescriptorProto::TYPE_GROUP:
+    case FieldDescriptorProto::TYPE_MESSAGE:
+      return false;
+    default:
+      return true;
+  }
+}
+
+bool DecodedFieldType(int encoded_type, FieldDescriptorProto::Type* out) {
+  switch (encoded_type) {
+    case kEncodedTypeDouble:
+      *out = FieldDescriptorProto::TYPE_DOUBLE;
+      return true;
+    case kEncodedTypeFloat:
+      *out = FieldDescriptorProto::TYPE_FLOAT;
+      return true;
+    case kEncodedTypeFixed32:
+      *out = FieldDescriptorProto::TYPE_FIXED32;
+      return true;
+    case kEncodedTypeFixed64:
+      *out = FieldDescriptorProto::TYPE_FIXED64;
+      return true;
+    case kEncodedTypeSFixed32:
+      *out = FieldDescriptorProto::TYPE_SFIXED32;
+      return true;
+    case kEncodedTypeSFixed64:
+      *out = FieldDescriptorProto::TYPE_SFIXED64;
+      return true;
+    case kEncodedTypeInt32:
+      *out = FieldDescriptorProto::TYPE_INT32;
+      return true;
+    case kEncodedTypeUInt32:
+      *out = FieldDescriptorProto::TYPE_UINT32;
+      return true;
+    case kEncodedTypeSInt32:
+      *out = FieldDescriptorProto::TYPE_SINT32;
+      return true;
+    case kEncodedTypeInt64:
+      *out = FieldDescriptorProto::TYPE_INT64;
+      return true;
+    case kEncodedTypeUInt64:
+      *out = FieldDescriptorProto::TYPE_UINT64;
+      return true;
+    case kEncodedTypeSInt64:
+      *out = FieldDescriptorProto::TYPE_SINT64;
+      return true;
+    case kEncodedTypeOpenEnum:
+    case kEncodedTypeClosedEnum:
+      *out = FieldDescriptorProto::TYPE_ENUM;
+      return true;
+    case kEncodedTypeBool:
+      *out = FieldDescriptorProto::TYPE_BOOL;
+      return true;
+    case kEncodedTypeBytes:
+      *out = FieldDescriptorProto::TYPE_BYTES;
+      return true;
+    case kEncodedTypeString:
+      *out = FieldDescriptorProto::TYPE_STRING;
+      return true;
+    case kEncodedTypeGroup:
+      *out = FieldDescriptorProto::TYPE_GROUP;
+      return true;
+    case kEncodedTypeMessage:
+      *out = FieldDescriptorProto::TYPE_MESSAGE;
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Per-field decoder state that DescriptorProto cannot hold.
+struct DecodedFieldInfo {
+  bool packable = false;
+  // Singular with explicit presence: eligible for oneof membership, and the
+  // marker that forces proto2 syntax if it survives outside a oneof on a
+  // non-message field.
+  bool hasbit = false;
+  bool in_oneof = false;
+};
+
+bool DecodeOneofs(absl::string_view data, size_t* pos, DescriptorProto* out,
+                  std::vector<DecodedFieldInfo>* infos) {
+  int oneof_index = out->oneof_decl_size();
+  out->add_oneof_decl()->set_name(absl::StrCat("o", oneof_index));
+  bool has_field = false;
+
+  while (*pos < data.size()) {
+    const char ch = data[(*pos)++];
+    if (ch == kFieldSeparator) {
+      // Separator between two fields of the same oneof.
+    } else if (ch == kOneofSeparator) {
+      if (!has_field) return false;
+      oneof_index = out->oneof_decl_size();
+      out->add_oneof_decl()->set_name(absl::StrCat("o", oneof_index));
+      has_field = false;
+    } else {
+      if (ch < kMinOneofField || kMaxOneofField < ch) return false;
+      uint32_t number;
+      if (!DecodeBase92Varint(data, pos, ch, kMinOneofField, kMaxOneofField,
+                              &number)) {
+        return false;
+      }
+      int index = -1;
+      for (int i = 0; i < out->field_size(); ++i) {
+        if (static_cast<uint32_t>(out->field(i).number()) == number) {
+          index = i;
+          break;
+        }
+      }
+      if (index < 0) return false;
+      DecodedFieldInfo& info = (*infos)[index];
+      if (!info.hasbit || info.in_oneof) return false;
+      info.in_oneof = true;
+      out->mutable_field(index)->set_oneof_index(oneof_index);
+      has_field = true;
+    }
+  }
+  return has_field;
+}
+
+}  // namespace
+
+std::string EncodeMessageMiniDescriptor(const Descriptor* message) {
+  std::string out;
+
+  if (message->options().map_entry()) {
+    out.push_back(kVersionMap);
+    uint32_t last_field_number = 0;
+    PutField(message->field(0), 0, &last_field_number, &out);
+    PutField(message->field(1), 0, &last_field_number, &out);
+    return out;
+  }
+  if (message->options().message_set_wire_format()) {
+    out.push_back(kVersionMessageSet);
+    return out;
+  }
+
+  uint32_t msg_modifiers = 0;
+  if (message->file()->edition() != Edition::EDITION_PROTO2) {
+    msg_modifiers |= kMessageModifierDefaultIsPacked;
+  }
+  if (MessageValidatesUtf8(message)) {
+    msg_modifiers |= kMessageModifierValidateUtf8;
+  }
+  if (message->extension_range_count() > 0) {
+    msg_modifiers |= kMessageModifierIsExtendable;
+  }
+
+  out.push_back(kVersionMessage);
+  PutModifier(msg_modifiers, &out);
+
+  std::vector<const FieldDescriptor*> fields;
+  fields.reserve(message->field_count());
+  for (int i = 0; i < message->field_count(); ++i) {
+    fields.push_back(message->field(i));
+  }
+  std::sort(fields.begin(), fields.end(),
+            [](const FieldDescriptor* a, const FieldDescriptor* b) {
+              return a->number() < b->number();
+            });
+
+  uint32_t last_field_number = 0;
+  for (const FieldDescriptor* field : fields) {
+    PutField(field, msg_modifiers, &last_field_number, &out);
+  }
+
+  for (int i = 0; i < message->real_oneof_decl_count(); ++i) {
+    out.push_back(i == 0 ? kEnd : kOneofSeparator);
+    const OneofDescriptor* oneof = message->oneof_decl(i);
+    for (int j = 0; j < oneof->field_count(); ++j) {
+      if (j > 0) out.push_back(kFieldSeparator);
+      PutBase92Varint(static_cast<uint32_t>(oneof->field(j)->number()),
+                      kMinOneofField, kMaxOneofField, &out);
+    }
+  }
+  return out;
+}
+
+std::string EncodeEnumMiniDescriptor(const EnumDescriptor* enum_type) {
+  std::string out;
+  out.push_back(kVersionEnum);
+
+  // Values sort as uint32, so negative numbers come last; duplicates
+  // (aliases) are encoded once.
+  std::vector<uint32_t> values;
+  values.reserve(enum_type->value_count());
+  for (int i = 0; i < enum_type->value_count(); ++i) {
+    values.push_back(static_cast<uint32_t>(enum_type->value(i)->number()));
+  }
+  std::sort(values.begin(), values.end());
+  values.erase(std::unique(values.begin(), values.end()), values.end());
+
+  // Runs of nearby values are emitted as 5-bit presence masks; larger gaps
+  // as skip varints.
+  uint32_t mask = 0;
+  uint32_t base = 0;
+  for (uint32_t value : values) {
+    uint32_t delta = value - base;
+    if (delta >= 5 && mask != 0) {
+      out.push_back(kToBase92[mask]);
+      mask = 0;
+      base += 5;
+      delta -= 5;
+    }
+    if (delta >= 5) {
+      PutBase92Varint(delta, kMinSkip, kMaxSkip, &out);
+      base += delta;
+      delta = 0;
+    }
+    mask |= uint32_t{1} << delta;
+  }
+  if (mask != 0) out.push_back(kToBase92[mask]);
+  return out;
+}
+
+bool DecodeMessageMiniDescriptor(absl::string_view data, DescriptorProto* out,
+                                 std::string* syntax) {
+  out->Clear();
+  if (data.empty()) return false;
+
+  const char version = data[0];
+  size_t pos = 1;
+
+  if (version == kVersionMessageSet) {
+    if (data.size() != 1) return false;
+    out->mutable_options()->set_message_set_wire_format(true);
+    if (syntax != nullptr) *syntax = "proto2";
+    return true;
+  }
+  if (version != kVersionMessage && version != kVersionMap) return false;
+  if (version == kVersionMap) out->mutable_options()->set_map_entry(true);
+
+  uint32_t msg_modifiers = 0;
+  uint32_t last_field_number = 0;
+  FieldDescriptorProto* last_field = nullptr;
+  std::vector<DecodedFieldInfo> infos;
+  bool needs_proto2 = false;
+
+  while (pos < data.size()) {
+    const char ch = data[pos++];
+    if (kMinField <= ch && ch <= kMaxField) {
+      int encoded_type = FromBase92(ch);
+      const bool repeated = encoded_type >= kEncodedTypeRepeatedBase;
+      if (repeated) encoded_type -= kEncodedTypeRepeatedBase;
+      FieldDescriptorProto::Type type;
+      if (!DecodedFieldType(encoded_type, &type)) return false;
+      if (encoded_type == kEncodedTypeClosedEnum ||
+          encoded_type == kEncodedTypeGroup) {
+        needs_proto2 = true;
+      }
+
+      ++last_field_number;
+      if (last_field_number > static_cast<uint32_t>(FieldDescriptor::kMaxNumber))
+        return false;
+      FieldDescriptorProto* field = out->add_field();
+      field->set_name(absl::StrCat("f", last_field_number));
+      field->set_number(static_cast<int>(last_field_number));
+      field->set_label(repeated ? FieldDescriptorProto::LABEL_REPEATED
+                                : FieldDescriptorProto::LABEL_OPTIONAL);
+      field->set_type(type);
+
+      DecodedFieldInfo info;
+      info.packable = repeated && IsPackableType(type);
+      info.hasbit = !repeated;
+      if (info.packable) {
+        field->mutable_options()->set_packed(
+            (msg_modifiers & kMessageModifierDefaultIsPacked) != 0);
+      }
+      infos.push_back(info);
+      last_field = field;
+    } else if (kMinModifier <= ch && ch <= kMaxModifier) {
+      uint32_t modifiers;
+      if (!DecodeBase92Varint(data, &pos, ch, kMinModifier, kMaxModifier,
+                              &modifiers)) {
+        return false;
+      }
+      if (last_field == nullptr) {
+        msg_modifiers = modifiers;
+        if (msg_modifiers & kMessageModifierIsExtendable) {
+          // Extension ranges cannot be reconstructed from the flag; the best
+          // we can preserve is proto2 syntax.
+          needs_proto2 = true;
+        }
+      } else {
+        DecodedFieldInfo& info = infos.back();
+        if (modifiers & kFieldModifierFlipPacked) {
+          if (!info.packable) return false;
+          last_field->mutable_options()->set_packed(
+              !last_field->options().packed());
+        }
+        if (modifiers & kFieldModifierFlipValidateUtf8) {
+          // Accepted for wire compatibility with upb, but per-field UTF-8
+          // overrides have no proto2/proto3 descriptor representation.
+          if (last_field->type() != FieldDescriptorProto::TYPE_STRING &&
+              last_field->type() != FieldDescriptorProto::TYPE_BYTES) {
+            return false;
+          }
+        }
+        const bool singular = (modifiers & kFieldModifierIsProto3Singular) != 0;
+        const bool required = (modifiers & kFieldModifierIsRequired) != 0;
+        if ((singular || required) && !info.hasbit) return false;
+        if (singular && required) return false;
+        if (singular &&
+            (last_field->type() == FieldDescriptorProto::TYPE_MESSAGE ||
+             last_field->type() == FieldDescriptorProto::TYPE_GROUP)) {
+          return false;
+        }
+        if (singular) info.hasbit = false;
+        if (required) {
+          last_field->set_label(FieldDescriptorProto::LABEL_REQUIRED);
+          info.hasbit = false;
+          needs_proto2 = true;
+        }
+      }
+    } else if (ch == kEnd) {
+      if (!DecodeOneofs(data, &pos, out, &infos)) return false;
+    } else if (kMinSkip <= ch && ch <= kMaxSkip) {
+      uint32_t skip;
+      if (!DecodeBase92Varint(data, &pos, ch, kMinSkip, kMaxSkip, &skip)) {
+        return false;
+      }
+      if (skip == 0) return false;
+      last_field_number += skip - 1;  // The next field char increments.
+    } else {
+      return false;
+    }
+  }
+
+  if (version == kVersionMap &&
+      (out->field_size() != 2 || out->field(0).number() != 1 ||
+       out->field(1).number() != 2 || out->oneof_decl_size() != 0)) {
+    return false;
+  }
+
+  if (syntax != nullptr) {
+    // A singular non-message field that kept its hasbit outside a oneof is
+    // an explicit-presence scalar, which proto3 cannot express.
+    for (int i = 0; i < out->field_size(); ++i) {
+      const FieldDescriptorProto& field = out->field(i);
+      if (infos[i].hasbit && !infos[i].in_oneof &&
+          field.type() != FieldDescriptorProto::TYPE_MESSAGE &&
+          field.type() != FieldDescriptorProto::TYPE_GROUP) {
+        needs_proto2 = true;
+      }
+    }
+    *syntax = needs_proto2 ? "proto2" : "proto3";
+  }
+  return true;
+}
+
+bool DecodeEnumMiniDescriptor(absl::string_view data,
+                              EnumDescriptorProto* out) {
+  out->Clear();
+  if (data.empty() || data[0] != kVersionEnum) return false;
+
+  uint32_t base = 0;
+  size_t pos = 1;
+  while (pos < data.size()) {
+    const char ch = data[pos++];
+    if (kMinField <= ch && ch <= kMaxEnumMask) {
+      const int mask = FromBase92(ch);
+      for (int bit = 0; bit < 5; ++bit) {
+        if ((mask & (1 << bit)) == 0) continue;
+        const int32_t number = static_cast<int32_t>(base + bit);
+        EnumValueDescriptorProto* value = out->add_value();
+        value->set_name(number < 0
+                            ? absl::StrCat("VM", -static_cast<int64_t>(number))
+                            : absl::StrCat("V", number));
+        value->set_number(number);
+      }
+      base += 5;
+    } else if (kMinSkip <= ch && ch <= kMaxSkip) {
+      uint32_t skip;
+      if (!DecodeBase92Varint(data, &pos, ch, kMinSkip, kMaxSkip, &skip)) {
+        return false;
+      }
+      base += skip;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+const Descriptor* MiniDescriptorPool::AddMessage(
+    absl::string_view full_name, absl::string_view data,
+    const absl::flat_hash_map<int, std::string>& linked_types) {
+  DescriptorProto message;
+  std::string syntax;
+  if (!DecodeMessageMiniDescriptor(data, &message, &syntax)) return nullptr;
+  if (message.options().map_entry() ||
+      message.options().message_set_wire_format()) {
+    return nullptr;
+  }
+
+  const size_t dot = full_name.rfind('.');
+  FileDescriptorProto file;
+  file.set_name(absl::StrCat(full_name, ".mini.proto"));
+  file.set_syntax(syntax);
+  if (dot != absl::string_view::npos) {
+    file.set_package(std::string(full_name.substr(0, dot)));
+    message.set_name(std::string(full_name.substr(dot + 1)));
+  } else {
+    message.set_name(std::string(full_name));
+  }
+
+  std::vector<std::string> dependencies;
+  for (FieldDescriptorProto& field : *message.mutable_field()) {
+    if (field.type() != FieldDescriptorProto::TYPE_MESSAGE &&
+        field.type() != FieldDescriptorProto::TYPE_GROUP &&
+        field.type() != FieldDescriptorProto::TYPE_ENUM) {
+      continue;
+    }
+    const auto it = linked_types.find(field.number());
+    if (it == linked_types.end()) return nullptr;
+    const FileDescriptor* dep_file;
+    if (field.type() == FieldDescriptorProto::TYPE_ENUM) {
+      const EnumDescriptor* linked = pool_.FindEnumTypeByName(it->second);
+      if (linked == nullptr) return nullptr;
+      dep_file = linked->file();
+    } else {
+      const Descriptor* linked = pool_.FindMessageTypeByName(it->second);
+      if (linked == nullptr || linked->options().map_entry()) return nullptr;
+      dep_file = linked->file();
+    }
+    field.set_type_name(absl::StrCat(".", it->second));
+    dependencies.push_back(dep_file->name());
+  }
+  std::sort(dependencies.begin(), dependencies.end());
+  dependencies.erase(std::unique(dependencies.begin(), dependencies.end()),
+                     dependencies.end());
+  for (const std::string& dependency : dependencies) {
+    file.add_dependency(dependency);
+  }
+
+  *file.add_message_type() = std::move(message);
+  const FileDescriptor* built = pool_.BuildFile(file);
+  return built == nullptr ? nullptr : built->message_type(0);
+}
+
+const EnumDescriptor* MiniDescriptorPool::AddEnum(absl::string_view full_name,
+                                                  absl::string_view data,
+                                                  bool closed) {
+  EnumDescriptorProto enum_proto;
+  if (!DecodeEnumMiniDescriptor(data, &enum_proto)) return nullptr;
+  if (enum_proto.value_size() == 0) return nullptr;
+  // Open enums map to proto3, which requires the zero value first; decoded
+  // values ascend as uint32 so zero is first exactly when it is present.
+  if (!closed && enum_proto.value(0).number() != 0) return nullptr;
+
+  const size_t dot = full_name.rfind('.');
+  FileDescriptorProto file;
+  file.set_name(absl::StrCat(full_name, ".mini.proto"));
+  file.set_syntax(closed ? "proto2" : "proto3");
+  absl::string_view simple_name = full_name;
+  if (dot != absl::string_view::npos) {
+    file.set_package(std::string(full_name.substr(0, dot)));
+    simple_name = full_name.substr(dot + 1);
+  }
+  enum_proto.set_name(std::string(simple_name));
+  // Enum value names live in the enclosing scope, so prefix them with the
+  // enum name to keep multiple enums per package from colliding.
+  for (EnumValueDescriptorProto& value : *enum_proto.mutable_value()) {
+    value.set_name(absl::StrCat(simple_name, "_", value.name()));
+  }
+
+  *file.add_enum_type() = std::move(enum_proto);
+  const FileDescriptor* built = pool_.BuildFile(file);
+  return built == nullptr ? nullptr : built->enum_type(0);
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
@@ -0,0 +1,132 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef GOOGLE_PROTOBUF_UTIL_MINI_DESCRIPTOR_H__
+#define GOOGLE_PROTOBUF_UTIL_MINI_DESCRIPTOR_H__
+
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/descriptor.pb.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+// Mini descriptors are tiny printable schema strings, defined by the upb
+// runtime (upb/mini_descriptor), that capture exactly what a parser needs
+// about one message: field numbers, wire types, presence and oneof
+// membership.  Names, options and source info are all omitted, which
+// typically makes a mini descriptor more than an order of magnitude
+// smaller than the serialized FileDescriptorProto for the same message.
+//
+// This module speaks the same base92 wire format as upb, so strings
+// produced here load with upb_MiniTable_Build() and vice versa:
+//
+//  - EncodeMessageMiniDescriptor() / EncodeEnumMiniDescriptor() turn a
+//    Descriptor into a mini descriptor string, e.g. at build time.
+//  - DecodeMessageMiniDescriptor() / DecodeEnumMiniDescriptor() expand a
+//    string back into descriptor.proto form, with synthesized names.
+//  - MiniDescriptorPool builds real Descriptors out of mini descriptor
+//    strings; combined with DynamicMessageFactory (whose parse tables are
+//    built at runtime anyway) this gives full parse/serialize capability
+//    with mini descriptors as the only schema artifact shipped.
+//
+// Because names and options are not encoded, the reconstruction is
+// necessarily approximate: field names are synthesized from numbers,
+// presence is mapped onto proto2 or proto3 syntax by content, per-field
+// UTF-8 validation overrides are accepted but not represented, and
+// extension ranges are reduced to a flag that cannot be restored.  Wire
+// compatibility -- what parses and how it is laid out -- is preserved.
+
+// Encodes the schema of `message` as a mini descriptor string.  Fields are
+// emitted in field number order; map entry messages and MessageSet messages
+// use their dedicated encodings.
+PROTOBUF_EXPORT std::string EncodeMessageMiniDescriptor(
+    const Descriptor* message);
+
+// Encodes the value set of `enum_type` as a mini descriptor string.  Only
+// the set of valid numbers is encoded; aliases collapse into one entry.
+PROTOBUF_EXPORT std::string EncodeEnumMiniDescriptor(
+    const EnumDescriptor* enum_type);
+
+// Decodes a message mini descriptor into `out`.  Field names are
+// synthesized as "f<number>" and oneofs as "o<index>", since the encoding
+// carries no names; message-, group- and enum-typed fields are left without
+// a type_name (mini descriptors link subtypes separately).  If `syntax` is
+// non-null it receives "proto2" or "proto3", chosen from the encoded
+// presence information.  Returns false if `data` is malformed, in which
+// case `*out` is left in an unspecified state.
+PROTOBUF_EXPORT bool DecodeMessageMiniDescriptor(absl::string_view data,
+                                                 DescriptorProto* out,
+                                                 std::string* syntax = nullptr);
+
+// Decodes an enum mini descriptor into `out`.  Value names are synthesized
+// from the numbers.  Returns false if `data` is malformed.
+PROTOBUF_EXPORT bool DecodeEnumMiniDescriptor(absl::string_view data,
+                                              EnumDescriptorProto* out);
+
+// Builds full Descriptors from mini descriptor strings.  Each added type
+// becomes a little synthesized file in an owned DescriptorPool, so the
+// results work with every consumer of Descriptors -- most usefully
+// DynamicMessageFactory:
+//
+//   MiniDescriptorPool pool;
+//   pool.AddEnum("pkg.Color", color_mini);
+//   pool.AddMessage("pkg.Inner", inner_mini);
+//   const Descriptor* outer =
+//       pool.AddMessage("pkg.Outer", outer_mini,
+//                       {{4, "pkg.Inner"}, {7, "pkg.Color"}});
+//   DynamicMessageFactory factory;
+//   Message* msg = factory.GetPrototype(outer)->New();
+//
+// Subtypes must be added before the messages that reference them.  Map
+// entry and MessageSet minis decode but cannot be added to a pool: the
+// former may only exist nested under a map field and the latter requires
+// extension ranges, neither of which a mini descriptor can reconstruct.
+//
+// Not thread-safe during Add*(); the built descriptors are immutable and
+// safe to share afterwards.
+class PROTOBUF_EXPORT MiniDescriptorPool {
+ public:
+  MiniDescriptorPool() = default;
+  MiniDescriptorPool(const MiniDescriptorPool&) = delete;
+  MiniDescriptorPool& operator=(const MiniDescriptorPool&) = delete;
+
+  // Decodes `data` and builds a message type called `full_name`.
+  // `linked_types` maps the field number of every message-, group- and
+  // enum-typed field to the full name of its type, which must already be in
+  // this pool.  Returns null if `data` is malformed, a link is missing or
+  // the resulting file does not build (e.g. `full_name` was added twice).
+  const Descriptor* AddMessage(
+      absl::string_view full_name, absl::string_view data,
+      const absl::flat_hash_map<int, std::string>& linked_types = {});
+
+  // Decodes `data` and builds an enum type called `full_name`.  Closedness
+  // is a property of the referencing field in the mini descriptor format,
+  // so it is passed explicitly here; open enums must contain the value 0.
+  const EnumDescriptor* AddEnum(absl::string_view full_name,
+                                absl::string_view data, bool closed = false);
+
+  const DescriptorPool* pool() const { return &pool_; }
+
+ private:
+  DescriptorPool pool_;
+};
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_MINI_DESCRIPTOR_H__
@@ -0,0 +1,307 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/util/mini_descriptor.h"
+
+#include <memory>
+#include <string>
+
+#include <gtest/gtest.h>
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/descriptor.pb.h"
+#include "google/protobuf/dynamic_message.h"
+#include "google/protobuf/message.h"
+#include "google/protobuf/text_format.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+const FileDescriptor* BuildFile(DescriptorPool& pool, absl::string_view text) {
+  FileDescriptorProto proto;
+  if (!TextFormat::ParseFromString(std::string(text), &proto)) return nullptr;
+  return pool.BuildFile(proto);
+}
+
+TEST(MiniDescriptorTest, EncodeProto2Scalar) {
+  DescriptorPool pool;
+  const FileDescriptor* file = BuildFile(pool, R"pb(
+    name: "a.proto"
+    syntax: "proto2"
+    package: "t"
+    message_type {
+      name: "M"
+      field { name: "a" number: 1 label: LABEL_OPTIONAL type: TYPE_INT32 }
+    }
+  )pb");
+  ASSERT_NE(file, nullptr);
+  EXPECT_EQ("$(", EncodeMessageMiniDescriptor(file->message_type(0)));
+}
+
+TEST(MiniDescriptorTest, EncodeProto3ImplicitPresence) {
+  DescriptorPool pool;
+  const FileDescriptor* file = BuildFile(pool, R"pb(
+    name: "a.proto"
+    syntax: "proto3"
+    package: "t"
+    message_type {
+      name: "M"
+      field { name: "a" number: 1 label: LABEL_OPTIONAL type: TYPE_INT32 }
+    }
+  )pb");
+  ASSERT_NE(file, nullptr);
+  // 'N' is the message modifier (packed by default), 'P' marks the field as
+  // proto3 singular (no presence).
+  EXPECT_EQ("$N(P", EncodeMessageMiniDescriptor(file->message_type(0)));
+}
+
+TEST(MiniDescriptorTest, EncodeSkipsFieldNumberGaps) {
+  DescriptorPool pool;
+  const FileDescriptor* file = BuildFile(pool, R"pb(
+    name: "a.proto"
+    syntax: "proto2"
+    package: "t"
+    message_type {
+      name: "M"
+      field { name: "d" number: 5 label: LABEL_OPTIONAL type: TYPE_DOUBLE }
+    }
+  )pb");
+  ASSERT_NE(file, nullptr);
+  EXPECT_EQ("$d ", EncodeMessageMiniDescriptor(file->message_type(0)));
+}
+
+TEST(MiniDescriptorTest, EncodeOneofs) {
+  DescriptorPool pool;
+  const FileDescriptor* file = BuildFile(pool, R"pb(
+    name: "a.proto"
+    syntax: "proto2"
+    package: "t"
+    message_type {
+      name: "M"
+      field { name: "a" number: 1 label: LABEL_OPTIONAL type: TYPE_INT32 }
+      field {
+        name: "b"
+        number: 2
+        label: LABEL_OPTIONAL
+        type: TYPE_INT32
+        oneof_index: 0
+      }
+      field {
+        name: "c"
+        number: 3
+        label: LABEL_OPTIONAL
+        type: TYPE_STRING
+        oneof_index: 0
+      }
+      oneof_decl { name: "o" }
+    }
+  )pb");
+  ASSERT_NE(file, nullptr);
+  EXPECT_EQ("$((1^#|$", EncodeMessageMiniDescriptor(file->message_type(0)));
+}
+
+TEST(MiniDescriptorTest, EncodeEnum) {
+  DescriptorPool pool;
+  const FileDescriptor* file = BuildFile(pool, R"pb(
+    name: "a.proto"
+    syntax: "proto2"
+    package: "t"
+    enum_type {
+      name: "E"
+      value { name: "A" number: 0 }
+      value { name: "B" number: 1 }
+      value { name: "C" number: 7 }
+    }
+  )pb");
+  ASSERT_NE(file, nullptr);
+  EXPECT_EQ("!$%", EncodeEnumMiniDescriptor(file->enum_type(0)));
+}
+
+TEST(MiniDescriptorTest, DecodeSuggestsSyntax) {
+  DescriptorProto message;
+  std::string syntax;
+
+  ASSERT_TRUE(DecodeMessageMiniDescriptor("$(", &message, &syntax));
+  EXPECT_EQ("proto2", syntax);
+  ASSERT_EQ(1, message.field_size());
+  EXPECT_EQ("f1", message.field(0).name());
+  EXPECT_EQ(1, message.field(0).number());
+  EXPECT_EQ(FieldDescriptorProto::TYPE_INT32, message.field(0).type());
+  EXPECT_EQ(FieldDescriptorProto::LABEL_OPTIONAL, message.field(0).label());
+
+  ASSERT_TRUE(DecodeMessageMiniDescriptor("$N(P", &message, &syntax));
+  EXPECT_EQ("proto3", syntax);
+  ASSERT_EQ(1, message.field_size());
+  EXPECT_EQ(FieldDescriptorProto::TYPE_INT32, message.field(0).type());
+}
+
+TEST(MiniDescriptorTest, DecodeRejectsMalformed) {
+  DescriptorProto message;
+  EXPECT_FALSE(DecodeMessageMiniDescriptor("", &message));
+  // 'J' is not a valid encoded field type.
+  EXPECT_FALSE(DecodeMessageMiniDescriptor("$J", &message));
+  // The oneof references field number 2, which does not exist.
+  EXPECT_FALSE(DecodeMessageMiniDescriptor("$(^#", &message));
+}
+
+TEST(MiniDescriptorTest, EnumRoundTrip) {
+  EnumDescriptorProto enum_proto;
+  ASSERT_TRUE(DecodeEnumMiniDescriptor("!$%", &enum_proto));
+  ASSERT_EQ(3, enum_proto.value_size());
+  EXPECT_EQ(0, enum_proto.value(0).number());
+  EXPECT_EQ(1, enum_proto.value(1).number());
+  EXPECT_EQ(7, enum_proto.value(2).number());
+  EXPECT_EQ("V0", enum_proto.value(0).name());
+}
+
+TEST(MiniDescriptorTest, MiniPoolRejectsMissingLink) {
+  DescriptorPool source_pool;
+  const FileDescriptor* file = BuildFile(source_pool, R"pb(
+    name: "a.proto"
+    syntax: "proto2"
+    package: "t"
+    message_type {
+      name: "Inner"
+      field { name: "x" number: 1 label: LABEL_OPTIONAL type: TYPE_INT32 }
+    }
+    message_type {
+      name: "Outer"
+      field {
+        name: "inner"
+        number: 1
+        label: LABEL_OPTIONAL
+        type: TYPE_MESSAGE
+        type_name: ".t.Inner"
+      }
+    }
+  )pb");
+  ASSERT_NE(file, nullptr);
+
+  MiniDescriptorPool mini_pool;
+  const std::string outer_mini =
+      EncodeMessageMiniDescriptor(file->message_type(1));
+  // The message-typed field 1 has no entry in linked_types.
+  EXPECT_EQ(nullptr, mini_pool.AddMessage("t.Outer", outer_mini));
+}
+
+TEST(MiniDescriptorTest, DynamicMessageRoundTrip) {
+  DescriptorPool source_pool;
+  const FileDescriptor* file = BuildFile(source_pool, R"pb(
+    name: "a.proto"
+    syntax: "proto3"
+    package: "t"
+    enum_type {
+      name: "Color"
+      value { name: "RED" number: 0 }
+      value { name: "GREEN" number: 5 }
+    }
+    message_type {
+      name: "Inner"
+      field { name: "name" number: 1 label: LABEL_OPTIONAL type: TYPE_STRING }
+    }
+    message_type {
+      name: "Outer"
+      field { name: "id" number: 1 label: LABEL_OPTIONAL type: TYPE_INT32 }
+      field { name: "nums" number: 2 label: LABEL_REPEATED type: TYPE_INT64 }
+      field {
+        name: "inner"
+        number: 4
+        label: LABEL_OPTIONAL
+        type: TYPE_MESSAGE
+        type_name: ".t.Inner"
+      }
+      field { name: "label" number: 5 label: LABEL_OPTIONAL type: TYPE_STRING }
+      field {
+        name: "items"
+        number: 6
+        label: LABEL_REPEATED
+        type: TYPE_MESSAGE
+        type_name: ".t.Inner"
+      }
+      field {
+        name: "color"
+        number: 7
+        label: LABEL_OPTIONAL
+        type: TYPE_ENUM
+        type_name: ".t.Color"
+      }
+      field {
+        name: "y"
+        number: 11
+        label: LABEL_OPTIONAL
+        type: TYPE_STRING
+        oneof_index: 0
+      }
+      oneof_decl { name: "choice" }
+    }
+  )pb");
+  ASSERT_NE(file, nullptr);
+  const Descriptor* outer = file->message_type(2);
+
+  // Rebuild the schema from mini descriptor strings alone.
+  MiniDescriptorPool mini_pool;
+  ASSERT_NE(nullptr, mini_pool.AddEnum(
+                         "t.Color", EncodeEnumMiniDescriptor(file->enum_type(0))));
+  ASSERT_NE(nullptr,
+            mini_pool.AddMessage(
+                "t.Inner", EncodeMessageMiniDescriptor(file->message_type(1))));
+  const Descriptor* mini_outer = mini_pool.AddMessage(
+      "t.Outer", EncodeMessageMiniDescriptor(outer),
+      {{4, "t.Inner"}, {6, "t.Inner"}, {7, "t.Color"}});
+  ASSERT_NE(mini_outer, nullptr);
+
+  // Populate a dynamic message of the original type.
+  DynamicMessageFactory source_factory;
+  std::unique_ptr<Message> original(
+      source_factory.GetPrototype(outer)->New());
+  const Reflection* reflection = original->GetReflection();
+  reflection->SetInt32(original.get(), outer->FindFieldByNumber(1), 42);
+  reflection->AddInt64(original.get(), outer->FindFieldByNumber(2), 10);
+  reflection->AddInt64(original.get(), outer->FindFieldByNumber(2), 20);
+  reflection->SetString(
+      reflection->MutableMessage(original.get(), outer->FindFieldByNumber(4)),
+      file->message_type(1)->FindFieldByNumber(1), "hello");
+  reflection->SetString(original.get(), outer->FindFieldByNumber(5), "label");
+  reflection->SetString(
+      reflection->AddMessage(original.get(), outer->FindFieldByNumber(6)),
+      file->message_type(1)->FindFieldByNumber(1), "item");
+  reflection->SetEnumValue(original.get(), outer->FindFieldByNumber(7), 5);
+  reflection->SetString(original.get(), outer->FindFieldByNumber(11), "why");
+
+  std::string wire;
+  ASSERT_TRUE(original->SerializeToString(&wire));
+
+  // Parse the same bytes with the mini-descriptor-built type.
+  DynamicMessageFactory mini_factory;
+  std::unique_ptr<Message> parsed(
+      mini_factory.GetPrototype(mini_outer)->New());
+  ASSERT_TRUE(parsed->ParseFromString(wire));
+
+  const Reflection* mini_reflection = parsed->GetReflection();
+  EXPECT_EQ(42, mini_reflection->GetInt32(*parsed,
+                                          mini_outer->FindFieldByNumber(1)));
+  EXPECT_EQ(2, mini_reflection->FieldSize(*parsed,
+                                          mini_outer->FindFieldByNumber(2)));
+  EXPECT_EQ("label", mini_reflection->GetString(
+                         *parsed, mini_outer->FindFieldByNumber(5)));
+  EXPECT_EQ(5, mini_reflection->GetEnumValue(
+                   *parsed, mini_outer->FindFieldByNumber(7)));
+  EXPECT_EQ("why", mini_reflection->GetString(
+                       *parsed, mini_outer->FindFieldByNumber(11)));
+
+  // The reconstructed schema preserves wire layout exactly.
+  std::string rewire;
+  ASSERT_TRUE(parsed->SerializeToString(&rewire));
+  EXPECT_EQ(wire, rewire);
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,167 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/util/parallel_delimited_reader.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "absl/synchronization/mutex.h"
+#include "google/protobuf/io/coded_stream.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+// One length-prefixed frame. The scanner fills |frame|, a worker replaces
+// it with |message|; |parsed| is only written with the reader's mutex held
+// so Read() can Await on it.
+struct ParallelDelimitedReader::Record {
+  std::string frame;
+  std::unique_ptr<MessageLite> message;
+  bool parsed = false;
+  bool ok = false;
+};
+
+ParallelDelimitedReader::Options::Options()
+    : num_threads(static_cast<int>(std::thread::hardware_concurrency())),
+      max_buffered_records(256) {}
+
+ParallelDelimitedReader::ParallelDelimitedReader(
+    io::ZeroCopyInputStream* input, const MessageLite& prototype,
+    const Options& options)
+    : input_(input), prototype_(&prototype), options_(options) {
+  if (options_.num_threads <= 0) options_.num_threads = 1;
+  if (options_.max_buffered_records < 1) options_.max_buffered_records = 1;
+  scanner_ = std::thread([this] { ScanFrames(); });
+  workers_.reserve(options_.num_threads);
+  for (int i = 0; i < options_.num_threads; ++i) {
+    workers_.emplace_back([this] { ParseFrames(); });
+  }
+}
+
+ParallelDelimitedReader::~ParallelDelimitedReader() {
+  {
+    absl::MutexLock lock(&mu_);
+    cancelled_ = true;
+  }
+  scanner_.join();
+  for (std::thread& worker : workers_) worker.join();
+}
+
+void ParallelDelimitedReader::ScanFrames() {
+  bool clean = true;
+  while (true) {
+    auto record = std::make_unique<Record>();
+    {
+      // A fresh CodedInputStream per record, as in
+      // ParseDelimitedFromZeroCopyStream(); its destructor pushes unread
+      // buffer back so the next record starts at the right offset, and the
+      // per-stream byte limit never accumulates across records.
+      io::CodedInputStream coded(input_);
+      int start = coded.CurrentPosition();
+      uint32_t size;
+      if (!coded.ReadVarint32(&size)) {
+        clean = coded.CurrentPosition() == start;
+        break;
+      }
+      if (!coded.ReadString(&record->frame, static_cast<int>(size))) {
+        clean = false;
+        break;
+      }
+    }
+
+    absl::MutexLock lock(&mu_);
+    auto has_room = [this]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      return cancelled_ ||
+             records_.size() < options_.max_buffered_records;
+    };
+    mu_.Await(absl::Condition(&has_room));
+    if (cancelled_) return;
+    records_.push_back(std::move(record));
+  }
+
+  absl::MutexLock lock(&mu_);
+  clean_eof_ = clean;
+  scan_done_ = true;
+}
+
+void ParallelDelimitedReader::ParseFrames() {
+  while (true) {
+    Record* record = nullptr;
+    {
+      absl::MutexLock lock(&mu_);
+      auto claimable = [this]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        return cancelled_ || scan_done_ || next_to_parse_ < records_.size();
+      };
+      mu_.Await(absl::Condition(&claimable));
+      if (cancelled_) return;
+      if (next_to_parse_ == records_.size()) {
+        if (scan_done_) return;
+        continue;
+      }
+      record = records_[next_to_parse_].get();
+      ++next_to_parse_;
+    }
+
+    // Parse outside the lock; the Record's address is stable and nothing
+    // else touches it until |parsed| is set. Partial parses are accepted,
+    // matching ParseDelimitedFromCodedStream(), which does not require
+    // required fields to be present.
+    std::unique_ptr<MessageLite> message(prototype_->New());
+    bool ok = message->ParsePartialFromString(record->frame);
+    std::string().swap(record->frame);
+
+    absl::MutexLock lock(&mu_);
+    record->message = std::move(message);
+    record->ok = ok;
+    record->parsed = true;
+  }
+}
+
+std::unique_ptr<MessageLite> ParallelDelimitedReader::Read() {
+  absl::MutexLock lock(&mu_);
+  if (failed_) return nullptr;
+  auto front_ready = [this]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return records_.empty() ? scan_done_ : records_.front()->parsed;
+  };
+  mu_.Await(absl::Condition(&front_ready));
+  if (records_.empty()) return nullptr;
+
+  std::unique_ptr<Record> record = std::move(records_.front());
+  records_.pop_front();
+  // The front was claimed before it was parsed, so the claim cursor always
+  // moves along with the pop.
+  --next_to_parse_;
+
+  if (!record->ok) {
+    clean_eof_ = false;
+    failed_ = true;
+    // Stop the scanner and idle workers; nothing past a bad record is
+    // ever delivered.
+    cancelled_ = true;
+    return nullptr;
+  }
+  return std::move(record->message);
+}
+
+bool ParallelDelimitedReader::clean_eof() const {
+  absl::MutexLock lock(&mu_);
+  return clean_eof_;
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
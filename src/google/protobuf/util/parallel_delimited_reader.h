@@ -0,0 +1,113 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef GOOGLE_PROTOBUF_UTIL_PARALLEL_DELIMITED_READER_H__
+#define GOOGLE_PROTOBUF_UTIL_PARALLEL_DELIMITED_READER_H__
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "google/protobuf/io/zero_copy_stream.h"
+#include "google/protobuf/message_lite.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+// Reads a stream of size-delimited messages (the framing produced by
+// SerializeDelimitedToZeroCopyStream()) with a pool of parsing threads.
+//
+// One internal thread scans the stream sequentially, copying out each
+// length-prefixed frame; the frames are parsed concurrently by worker
+// threads and handed back to the caller strictly in input order. The
+// scan is a cheap memcpy-rate pass, so with enough workers throughput is
+// bounded by the underlying stream rather than by message decoding. The
+// number of frames buffered between the scanner and the caller is capped,
+// so a fast stream feeding a slow consumer uses bounded memory.
+//
+// All Read() calls must come from a single consumer thread. The reader
+// does not take ownership of the input stream, which must stay live (and
+// untouched by other readers) until the reader is destroyed.
+class PROTOBUF_EXPORT ParallelDelimitedReader {
+ public:
+  struct Options {
+    Options();
+
+    // Number of parsing threads. Values < 1 are treated as 1.
+    int num_threads;
+
+    // Maximum number of frames in flight between the prefix scanner and
+    // the consumer, counting both parsed and not-yet-parsed frames. Also
+    // bounds how far the scanner may run ahead of Read().
+    size_t max_buffered_records;
+  };
+
+  // |prototype| supplies New() for the record type; it is not modified
+  // and must outlive the reader.
+  ParallelDelimitedReader(io::ZeroCopyInputStream* input,
+                          const MessageLite& prototype,
+                          const Options& options = Options());
+  ParallelDelimitedReader(const ParallelDelimitedReader&) = delete;
+  ParallelDelimitedReader& operator=(const ParallelDelimitedReader&) = delete;
+
+  // Joins all worker threads. The input stream may be positioned past the
+  // last record returned by Read() if the scanner had run ahead.
+  ~ParallelDelimitedReader();
+
+  // Returns the next record in input order, blocking until it has been
+  // parsed. Returns null once the stream is exhausted or an error is hit;
+  // clean_eof() distinguishes the two.
+  std::unique_ptr<MessageLite> Read();
+
+  // After Read() has returned null: true if the stream ended cleanly on a
+  // record boundary, false if it ended mid-record, a size prefix was
+  // malformed, or a record failed to parse.
+  bool clean_eof() const;
+
+ private:
+  struct Record;
+
+  void ScanFrames();
+  void ParseFrames();
+
+  io::ZeroCopyInputStream* input_;
+  const MessageLite* prototype_;
+  Options options_;
+
+  mutable absl::Mutex mu_;
+  // Frames in input order; the front is the next record to deliver.
+  // unique_ptr gives each Record a stable address while workers parse it
+  // outside the lock.
+  std::deque<std::unique_ptr<Record>> records_;
+  // Index into records_ of the next frame no worker has claimed yet.
+  size_t next_to_parse_ = 0;
+  bool scan_done_ = false;
+  bool clean_eof_ = false;
+  // Set when a record fails to parse; later records are never delivered.
+  bool failed_ = false;
+  // Set by the destructor (and on failure) to unblock the scanner and any
+  // idle workers.
+  bool cancelled_ = false;
+
+  std::thread scanner_;
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_PARALLEL_DELIMITED_READER_H__
@@ -0,0 +1,97 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/util/parallel_delimited_reader.h"
+
+#include <memory>
+#include <string>
+
+#include <gtest/gtest.h>
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/unittest.pb.h"
+#include "google/protobuf/util/delimited_message_util.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+std::string MakeDelimitedStream(int num_records) {
+  std::string data;
+  io::StringOutputStream output(&data);
+  for (int i = 0; i < num_records; ++i) {
+    protobuf_unittest::ForeignMessage message;
+    message.set_c(i);
+    EXPECT_TRUE(SerializeDelimitedToZeroCopyStream(message, &output));
+  }
+  return data;
+}
+
+TEST(ParallelDelimitedReaderTest, ReadsRecordsInOrder) {
+  const int kNumRecords = 1000;
+  std::string data = MakeDelimitedStream(kNumRecords);
+
+  for (int num_threads : {1, 4}) {
+    io::ArrayInputStream input(data.data(), data.size());
+    ParallelDelimitedReader::Options options;
+    options.num_threads = num_threads;
+    options.max_buffered_records = 16;
+    ParallelDelimitedReader reader(
+        &input, protobuf_unittest::ForeignMessage::default_instance(), options);
+
+    for (int i = 0; i < kNumRecords; ++i) {
+      std::unique_ptr<MessageLite> message = reader.Read();
+      ASSERT_TRUE(message != nullptr) << "record " << i;
+      EXPECT_EQ(
+          static_cast<protobuf_unittest::ForeignMessage&>(*message).c(), i);
+    }
+    EXPECT_TRUE(reader.Read() == nullptr);
+    EXPECT_TRUE(reader.clean_eof());
+  }
+}
+
+TEST(ParallelDelimitedReaderTest, EmptyStream) {
+  io::ArrayInputStream input(nullptr, 0);
+  ParallelDelimitedReader reader(
+      &input, protobuf_unittest::ForeignMessage::default_instance());
+  EXPECT_TRUE(reader.Read() == nullptr);
+  EXPECT_TRUE(reader.clean_eof());
+}
+
+TEST(ParallelDelimitedReaderTest, TruncatedFinalRecord) {
+  std::string data = MakeDelimitedStream(10);
+  data.resize(data.size() - 1);
+
+  io::ArrayInputStream input(data.data(), data.size());
+  ParallelDelimitedReader reader(
+      &input, protobuf_unittest::ForeignMessage::default_instance());
+
+  // The nine complete records are still delivered.
+  for (int i = 0; i < 9; ++i) {
+    std::unique_ptr<MessageLite> message = reader.Read();
+    ASSERT_TRUE(message != nullptr) << "record " << i;
+  }
+  EXPECT_TRUE(reader.Read() == nullptr);
+  EXPECT_FALSE(reader.clean_eof());
+}
+
+TEST(ParallelDelimitedReaderTest, DestructorJoinsWithUnreadRecords) {
+  std::string data = MakeDelimitedStream(100);
+  io::ArrayInputStream input(data.data(), data.size());
+  ParallelDelimitedReader reader(
+      &input, protobuf_unittest::ForeignMessage::default_instance());
+  // Read a few records and abandon the rest; the destructor must unblock
+  // the scanner, which is parked on the buffered-record cap.
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(reader.Read() != nullptr);
+  }
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
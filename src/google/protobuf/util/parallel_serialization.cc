@@ -0,0 +1,181 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/util/parallel_serialization.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "absl/log/absl_check.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/wire_format.h"
+#include "google/protobuf/wire_format_lite.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+namespace {
+
+using internal::WireFormat;
+using internal::WireFormatLite;
+
+constexpr size_t kMaxTaskBytes =
+    static_cast<size_t>(std::numeric_limits<int>::max());
+
+// Serializes elements [first, last) of a repeated message field at `ptr`,
+// relying on the cached sizes computed during planning.
+void SerializeElementRange(const Message& message, const FieldDescriptor* field,
+                           int first, int last, uint8_t* ptr, size_t len,
+                           bool deterministic) {
+  const Reflection* reflection = message.GetReflection();
+  io::EpsCopyOutputStream stream(ptr, static_cast<int>(len), deterministic);
+  uint8_t* target = ptr;
+  for (int i = first; i < last; ++i) {
+    const Message& elem = reflection->GetRepeatedMessage(message, field, i);
+    target = stream.EnsureSpace(target);
+    target = WireFormatLite::WriteTagToArray(
+        field->number(), WireFormatLite::WIRETYPE_LENGTH_DELIMITED, target);
+    target = io::CodedOutputStream::WriteVarint32ToArray(
+        static_cast<uint32_t>(elem.GetCachedSize()), target);
+    target = elem._InternalSerialize(target, &stream);
+  }
+  ABSL_DCHECK_EQ(target, ptr + len);
+}
+
+void SerializeFieldRegion(const Message& message, const FieldDescriptor* field,
+                          uint8_t* ptr, size_t len, bool deterministic) {
+  io::EpsCopyOutputStream stream(ptr, static_cast<int>(len), deterministic);
+  uint8_t* target =
+      WireFormat::InternalSerializeField(field, message, ptr, &stream);
+  ABSL_DCHECK_EQ(target, ptr + len);
+}
+
+void SerializeUnknownFieldRegion(const Message& message, uint8_t* ptr,
+                                 size_t len, bool deterministic) {
+  io::EpsCopyOutputStream stream(ptr, static_cast<int>(len), deterministic);
+  uint8_t* target = WireFormat::InternalSerializeUnknownFieldsToArray(
+      message.GetReflection()->GetUnknownFields(message), ptr, &stream);
+  ABSL_DCHECK_EQ(target, ptr + len);
+}
+
+}  // namespace
+
+absl::Status PlanParallelSerialization(const Message& message, void* data,
+                                       size_t size,
+                                       std::vector<SerializationTask>* tasks,
+                                       size_t min_bytes_per_task) {
+  // This walk also populates the cached sizes the tasks serialize with.
+  const size_t total = message.ByteSizeLong();
+  if (total > size) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("buffer too small: need ", total, " bytes, got ", size));
+  }
+  const Descriptor* descriptor = message.GetDescriptor();
+  const Reflection* reflection = message.GetReflection();
+  uint8_t* out = static_cast<uint8_t*>(data);
+  const bool deterministic =
+      io::CodedOutputStream::IsDefaultSerializationDeterministic();
+
+  if (descriptor->options().message_set_wire_format()) {
+    // MessageSet items interleave with unknown fields; don't partition.
+    if (total > kMaxTaskBytes) {
+      return absl::InvalidArgumentError("message set region exceeds 2GB");
+    }
+    tasks->push_back([&message, out, total, deterministic] {
+      io::EpsCopyOutputStream stream(out, static_cast<int>(total),
+                                     deterministic);
+      uint8_t* target = message._InternalSerialize(out, &stream);
+      ABSL_DCHECK_EQ(target, out + total);
+    });
+    return absl::OkStatus();
+  }
+
+  std::vector<const FieldDescriptor*> fields;
+  reflection->ListFields(message, &fields);
+
+  size_t offset = 0;
+  for (const FieldDescriptor* field : fields) {
+    const size_t field_size = WireFormat::FieldByteSize(field, message);
+    const bool partition = field->type() == FieldDescriptor::TYPE_MESSAGE &&
+                           field->is_repeated() && !field->is_map() &&
+                           field_size >= 2 * min_bytes_per_task;
+    if (partition) {
+      const int n = reflection->FieldSize(message, field);
+      const size_t tag_size =
+          WireFormat::TagSize(field->number(), field->type());
+      int chunk_first = 0;
+      size_t chunk_bytes = 0;
+      size_t chunk_offset = offset;
+      for (int i = 0; i < n; ++i) {
+        const Message& elem = reflection->GetRepeatedMessage(message, field, i);
+        const size_t payload = elem.ByteSizeLong();
+        chunk_bytes += tag_size +
+                       io::CodedOutputStream::VarintSize32(
+                           static_cast<uint32_t>(payload)) +
+                       payload;
+        if (chunk_bytes >= min_bytes_per_task || i == n - 1) {
+          if (chunk_bytes > kMaxTaskBytes) {
+            return absl::InvalidArgumentError(
+                absl::StrCat("field ", field->full_name(),
+                             " has an element chunk exceeding 2GB"));
+          }
+          tasks->push_back([&message, field, chunk_first, last = i + 1,
+                            ptr = out + chunk_offset, len = chunk_bytes,
+                            deterministic] {
+            SerializeElementRange(message, field, chunk_first, last, ptr, len,
+                                  deterministic);
+          });
+          chunk_offset += chunk_bytes;
+          chunk_bytes = 0;
+          chunk_first = i + 1;
+        }
+      }
+      ABSL_DCHECK_EQ(chunk_offset, offset + field_size);
+    } else {
+      if (field_size > kMaxTaskBytes) {
+        return absl::InvalidArgumentError(absl::StrCat(
+            "field ", field->full_name(), " region exceeds 2GB"));
+      }
+      tasks->push_back([&message, field, ptr = out + offset, len = field_size,
+                        deterministic] {
+        SerializeFieldRegion(message, field, ptr, len, deterministic);
+      });
+    }
+    offset += field_size;
+  }
+
+  const size_t unknown_size = WireFormat::ComputeUnknownFieldsSize(
+      reflection->GetUnknownFields(message));
+  if (unknown_size > 0) {
+    if (unknown_size > kMaxTaskBytes) {
+      return absl::InvalidArgumentError("unknown field region exceeds 2GB");
+    }
+    tasks->push_back([&message, ptr = out + offset, len = unknown_size,
+                      deterministic] {
+      SerializeUnknownFieldRegion(message, ptr, len, deterministic);
+    });
+    offset += unknown_size;
+  }
+
+  ABSL_DCHECK_EQ(offset, total);
+  return absl::OkStatus();
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
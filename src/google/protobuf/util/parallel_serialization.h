@@ -0,0 +1,57 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef GOOGLE_PROTOBUF_UTIL_PARALLEL_SERIALIZATION_H__
+#define GOOGLE_PROTOBUF_UTIL_PARALLEL_SERIALIZATION_H__
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "google/protobuf/message.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+// A unit of serialization work produced by PlanParallelSerialization().
+// Tasks are independent: each writes a disjoint byte range of the output
+// buffer and they may run concurrently on any executor.
+using SerializationTask = std::function<void()>;
+
+// Partitions the serialization of |message| into independent tasks writing
+// at precomputed offsets of |data|, so that a large message (typically one
+// dominated by big repeated submessage fields) can be serialized on a
+// caller-owned thread pool. Repeated message fields are split into chunks of
+// roughly |min_bytes_per_task| serialized bytes; all other fields and the
+// unknown-field set become one task per field. Running every task exactly
+// once, in any order or concurrently, produces the same bytes as
+// SerializeToArray(). The protobuf runtime itself never spawns threads.
+//
+// Requirements:
+//  - |size| must be at least message.ByteSizeLong().
+//  - |message| must not be modified until all tasks have completed.
+//  - Deterministic-serialization state is captured at planning time.
+//
+// Returns an error if the buffer is too small or the message layout cannot
+// be partitioned (e.g. a single field region exceeding 2GB).
+absl::Status PROTOBUF_EXPORT PlanParallelSerialization(
+    const Message& message, void* data, size_t size,
+    std::vector<SerializationTask>* tasks,
+    size_t min_bytes_per_task = size_t{1} << 20);
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_PARALLEL_SERIALIZATION_H__
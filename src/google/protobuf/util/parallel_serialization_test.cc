@@ -0,0 +1,75 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/util/parallel_serialization.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "google/protobuf/test_util.h"
+#include "google/protobuf/unittest.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+TEST(ParallelSerializationTest, TasksReproduceSerializeToString) {
+  unittest::TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+
+  std::string expected;
+  ASSERT_TRUE(message.SerializeToString(&expected));
+
+  std::string actual(expected.size(), '\0');
+  std::vector<SerializationTask> tasks;
+  ASSERT_TRUE(
+      PlanParallelSerialization(message, &actual[0], actual.size(), &tasks)
+          .ok());
+  EXPECT_GT(tasks.size(), 1);
+  for (const SerializationTask& task : tasks) task();
+
+  EXPECT_EQ(expected, actual);
+}
+
+TEST(ParallelSerializationTest, LargeRepeatedFieldIsSplitIntoChunks) {
+  unittest::TestAllTypes message;
+  for (int i = 0; i < 64; ++i) {
+    message.add_repeated_nested_message()->set_bb(i);
+  }
+
+  std::string expected;
+  ASSERT_TRUE(message.SerializeToString(&expected));
+
+  std::string actual(expected.size(), '\0');
+  std::vector<SerializationTask> tasks;
+  // A tiny chunk target forces the repeated field into multiple tasks.
+  ASSERT_TRUE(PlanParallelSerialization(message, &actual[0], actual.size(),
+                                        &tasks, /*min_bytes_per_task=*/16)
+                  .ok());
+  EXPECT_GT(tasks.size(), 2);
+  for (const SerializationTask& task : tasks) task();
+
+  EXPECT_EQ(expected, actual);
+}
+
+TEST(ParallelSerializationTest, RejectsUndersizedBuffer) {
+  unittest::TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+
+  char buffer[8];
+  std::vector<SerializationTask> tasks;
+  EXPECT_FALSE(
+      PlanParallelSerialization(message, buffer, sizeof(buffer), &tasks).ok());
+  EXPECT_TRUE(tasks.empty());
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,132 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/util/repeated_bool_util.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "absl/log/absl_check.h"
+#include "absl/numeric/bits.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/repeated_field.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+// A bool object holds exactly 0 or 1, so a word of eight bool bytes has one
+// bit set per true element, and standard bit tricks apply:
+//
+// Multiplying a word of 0/1 bytes by kGatherMagic moves the low bit of byte
+// i to bit i of the top byte (no partial product carries into the top byte,
+// since every intermediate byte sum stays below 0x100).
+constexpr uint64_t kGatherMagic = 0x8040201008040201u;
+// Broadcasting a byte with kSpread and masking with kGatherMagic leaves
+// byte i holding bit i of the original byte, shifted to position i; adding
+// 0x7f to each byte then pulls every nonzero byte's sign bit up, which is
+// how UnpackBoolsFromBitmap() normalizes the bytes back to 0/1.
+constexpr uint64_t kSpread = 0x0101010101010101u;
+
+uint64_t LoadWord(const bool* p) {
+  uint64_t word;
+  memcpy(&word, p, sizeof(word));
+  return word;
+}
+
+void StoreWord(bool* p, uint64_t word) { memcpy(p, &word, sizeof(word)); }
+
+}  // namespace
+
+size_t CountTrue(const RepeatedField<bool>& field) {
+  const bool* data = field.data();
+  const int n = field.size();
+  size_t count = 0;
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    // Each byte is 0 or 1, so the word's population count is the number of
+    // true elements in it.
+    count += static_cast<size_t>(absl::popcount(LoadWord(data + i)));
+  }
+  for (; i < n; ++i) {
+    count += data[i] ? 1 : 0;
+  }
+  return count;
+}
+
+void AndInto(RepeatedField<bool>* field, const RepeatedField<bool>& other) {
+  ABSL_DCHECK_EQ(field->size(), other.size());
+  bool* dst = field->mutable_data();
+  const bool* src = other.data();
+  const int n = field->size() < other.size() ? field->size() : other.size();
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    StoreWord(dst + i, LoadWord(dst + i) & LoadWord(src + i));
+  }
+  for (; i < n; ++i) {
+    dst[i] = dst[i] && src[i];
+  }
+}
+
+void OrInto(RepeatedField<bool>* field, const RepeatedField<bool>& other) {
+  ABSL_DCHECK_EQ(field->size(), other.size());
+  bool* dst = field->mutable_data();
+  const bool* src = other.data();
+  const int n = field->size() < other.size() ? field->size() : other.size();
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    StoreWord(dst + i, LoadWord(dst + i) | LoadWord(src + i));
+  }
+  for (; i < n; ++i) {
+    dst[i] = dst[i] || src[i];
+  }
+}
+
+void PackBoolsToBitmap(const RepeatedField<bool>& field, std::string* bitmap) {
+  const bool* data = field.data();
+  const int n = field.size();
+  bitmap->assign(static_cast<size_t>(n + 7) / 8, '\0');
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    (*bitmap)[i / 8] =
+        static_cast<char>((LoadWord(data + i) * kGatherMagic) >> 56);
+  }
+  for (; i < n; ++i) {
+    (*bitmap)[i / 8] |= static_cast<char>((data[i] ? 1 : 0) << (i % 8));
+  }
+}
+
+void UnpackBoolsFromBitmap(absl::string_view bitmap, int size,
+                           RepeatedField<bool>* field) {
+  ABSL_DCHECK_GE(size, 0);
+  ABSL_DCHECK_LE(static_cast<size_t>(size + 7) / 8, bitmap.size());
+  field->Clear();
+  field->Resize(size, false);
+  bool* data = field->mutable_data();
+  int i = 0;
+  for (; i + 8 <= size; i += 8) {
+    const uint64_t byte = static_cast<uint8_t>(bitmap[i / 8]);
+    const uint64_t spread = (byte * kSpread) & kGatherMagic;
+    StoreWord(data + i,
+              ((spread + 0x7f7f7f7f7f7f7f7fu) >> 7) & kSpread);
+  }
+  for (; i < size; ++i) {
+    data[i] = (static_cast<uint8_t>(bitmap[i / 8]) >> (i % 8)) & 1;
+  }
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
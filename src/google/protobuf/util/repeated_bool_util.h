@@ -0,0 +1,64 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef GOOGLE_PROTOBUF_UTIL_REPEATED_BOOL_UTIL_H__
+#define GOOGLE_PROTOBUF_UTIL_REPEATED_BOOL_UTIL_H__
+
+#include <cstddef>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "google/protobuf/repeated_field.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+// Bitmap-style bulk operations on `repeated bool` fields.
+//
+// RepeatedField<bool> stores one byte per element, so large flag vectors can
+// be processed a machine word (eight elements) at a time instead of
+// element-by-element.  These helpers do exactly that: counting and combining
+// work on whole words, and the pack/unpack pair converts to and from a
+// bitmap one eighth the size for compact storage or transmission in a
+// `bytes` field.
+
+// Returns the number of true elements in `field`.
+PROTOBUF_EXPORT size_t CountTrue(const RepeatedField<bool>& field);
+
+// Element-wise logical AND of `other` into `field`.  The fields must have
+// the same size.
+PROTOBUF_EXPORT void AndInto(RepeatedField<bool>* field,
+                             const RepeatedField<bool>& other);
+
+// Element-wise logical OR of `other` into `field`.  The fields must have
+// the same size.
+PROTOBUF_EXPORT void OrInto(RepeatedField<bool>* field,
+                            const RepeatedField<bool>& other);
+
+// Packs `field` into a bitmap of ceil(size / 8) bytes, one bit per element,
+// least-significant bit first within each byte.  Unused trailing bits of the
+// last byte are zero.  `bitmap` is overwritten.
+PROTOBUF_EXPORT void PackBoolsToBitmap(const RepeatedField<bool>& field,
+                                       std::string* bitmap);
+
+// Inverse of PackBoolsToBitmap(): expands the first `size` bits of `bitmap`
+// into `field`, which is overwritten.  `bitmap` must hold at least
+// ceil(size / 8) bytes.
+PROTOBUF_EXPORT void UnpackBoolsFromBitmap(absl::string_view bitmap, int size,
+                                           RepeatedField<bool>* field);
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_REPEATED_BOOL_UTIL_H__
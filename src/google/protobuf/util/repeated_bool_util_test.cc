@@ -0,0 +1,106 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/util/repeated_bool_util.h"
+
+#include <string>
+
+#include <gtest/gtest.h>
+#include "google/protobuf/repeated_field.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+// Sizes straddle the word-at-a-time boundary so both the bulk loop and the
+// scalar tail are exercised.
+constexpr int kSizes[] = {0, 1, 7, 8, 9, 64, 100};
+
+RepeatedField<bool> MakePattern(int size) {
+  RepeatedField<bool> field;
+  for (int i = 0; i < size; ++i) {
+    field.Add(i % 3 == 0);
+  }
+  return field;
+}
+
+TEST(RepeatedBoolUtilTest, CountTrue) {
+  for (int size : kSizes) {
+    RepeatedField<bool> field = MakePattern(size);
+    size_t expected = 0;
+    for (bool b : field) expected += b ? 1 : 0;
+    EXPECT_EQ(CountTrue(field), expected) << "size " << size;
+  }
+}
+
+TEST(RepeatedBoolUtilTest, AndInto) {
+  for (int size : kSizes) {
+    RepeatedField<bool> lhs = MakePattern(size);
+    RepeatedField<bool> rhs;
+    for (int i = 0; i < size; ++i) rhs.Add(i % 2 == 0);
+
+    RepeatedField<bool> result = lhs;
+    AndInto(&result, rhs);
+    for (int i = 0; i < size; ++i) {
+      EXPECT_EQ(result.Get(i), lhs.Get(i) && rhs.Get(i))
+          << "size " << size << " index " << i;
+    }
+  }
+}
+
+TEST(RepeatedBoolUtilTest, OrInto) {
+  for (int size : kSizes) {
+    RepeatedField<bool> lhs = MakePattern(size);
+    RepeatedField<bool> rhs;
+    for (int i = 0; i < size; ++i) rhs.Add(i % 2 == 0);
+
+    RepeatedField<bool> result = lhs;
+    OrInto(&result, rhs);
+    for (int i = 0; i < size; ++i) {
+      EXPECT_EQ(result.Get(i), lhs.Get(i) || rhs.Get(i))
+          << "size " << size << " index " << i;
+    }
+  }
+}
+
+TEST(RepeatedBoolUtilTest, PackUnpackRoundTrips) {
+  for (int size : kSizes) {
+    RepeatedField<bool> field = MakePattern(size);
+
+    std::string bitmap;
+    PackBoolsToBitmap(field, &bitmap);
+    EXPECT_EQ(bitmap.size(), (size + 7) / 8) << "size " << size;
+
+    RepeatedField<bool> unpacked;
+    unpacked.Add(true);  // Overwritten.
+    UnpackBoolsFromBitmap(bitmap, size, &unpacked);
+    ASSERT_EQ(unpacked.size(), size);
+    for (int i = 0; i < size; ++i) {
+      EXPECT_EQ(unpacked.Get(i), field.Get(i))
+          << "size " << size << " index " << i;
+    }
+  }
+}
+
+TEST(RepeatedBoolUtilTest, PackedBitLayoutIsLsbFirst) {
+  RepeatedField<bool> field;
+  for (bool b : {true, false, false, true, false, false, false, false, true}) {
+    field.Add(b);
+  }
+
+  std::string bitmap;
+  PackBoolsToBitmap(field, &bitmap);
+  ASSERT_EQ(bitmap.size(), 2);
+  EXPECT_EQ(static_cast<unsigned char>(bitmap[0]), 0b00001001);
+  EXPECT_EQ(static_cast<unsigned char>(bitmap[1]), 0b00000001);
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,72 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/util/shared_message.h"
+
+#include <memory>
+#include <utility>
+
+#include "absl/log/absl_check.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+SharedMessage::SharedMessage(std::unique_ptr<const Message> message)
+    : message_(std::move(message)) {
+  ABSL_DCHECK(message_ != nullptr);
+  ABSL_DCHECK(message_->GetArena() == nullptr)
+      << "Shared payloads must be heap-allocated; an arena would tie the "
+         "refcounted payload's lifetime to the arena's";
+}
+
+ScopedSharedMessageAttachment::ScopedSharedMessageAttachment(
+    const SharedMessage& shared, Message* parent, const FieldDescriptor* field)
+    : shared_(shared.message_), parent_(parent), field_(field) {
+  ABSL_DCHECK_EQ(field->cpp_type(), FieldDescriptor::CPPTYPE_MESSAGE);
+  ABSL_DCHECK(!field->is_repeated());
+  ABSL_DCHECK_EQ(shared_->GetDescriptor(), field->message_type());
+  // The const_cast is sound because the attachment never exposes mutable
+  // access to the field: the pointer is handed back unmodified in the
+  // destructor, and MutableDetached() swaps in a copy before any write.
+  parent_->GetReflection()->UnsafeArenaSetAllocatedMessage(
+      parent_, const_cast<Message*>(shared_.get()), field_);
+}
+
+ScopedSharedMessageAttachment::~ScopedSharedMessageAttachment() {
+  if (detached_) return;
+  Message* released =
+      parent_->GetReflection()->UnsafeArenaReleaseMessage(parent_, field_);
+  ABSL_DCHECK_EQ(released, shared_.get())
+      << "field " << field_->full_name() << " was reassigned while attached";
+  (void)released;
+}
+
+Message* ScopedSharedMessageAttachment::MutableDetached() {
+  ABSL_DCHECK(!detached_);
+  const Reflection* reflection = parent_->GetReflection();
+  Message* released = reflection->UnsafeArenaReleaseMessage(parent_, field_);
+  ABSL_DCHECK_EQ(released, shared_.get())
+      << "field " << field_->full_name() << " was reassigned while attached";
+  (void)released;
+  Message* copy = shared_->New(parent_->GetArena());
+  copy->CopyFrom(*shared_);
+  reflection->SetAllocatedMessage(parent_, copy, field_);
+  detached_ = true;
+  return copy;
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
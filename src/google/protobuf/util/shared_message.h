@@ -0,0 +1,106 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef GOOGLE_PROTOBUF_UTIL_SHARED_MESSAGE_H__
+#define GOOGLE_PROTOBUF_UTIL_SHARED_MESSAGE_H__
+
+#include <memory>
+
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+class ScopedSharedMessageAttachment;
+
+// A refcounted handle to an immutable message payload that can be lent to
+// many parent messages at once, making fan-out of a large common submessage
+// O(1) per recipient instead of O(size).
+//
+// SharedMessage handles are cheap to copy; the payload is destroyed when the
+// last handle and attachment referencing it goes away.  The payload itself
+// must never be mutated: every attached parent reads the same object.
+// Serializing attached parents concurrently is safe, as it only performs
+// const operations on the payload.
+class PROTOBUF_EXPORT SharedMessage {
+ public:
+  // Takes ownership of a fully built payload.  The payload must be
+  // heap-allocated (not arena-allocated), since its lifetime is governed by
+  // refcounting rather than by any one arena.
+  explicit SharedMessage(std::unique_ptr<const Message> message);
+
+  const Message& message() const { return *message_; }
+
+ private:
+  friend class ScopedSharedMessageAttachment;
+
+  std::shared_ptr<const Message> message_;
+};
+
+// Lends a shared payload to a singular message field of `parent` for the
+// lifetime of this object, without copying it.  The parent serializes the
+// shared payload exactly as if it owned the field; on destruction the field
+// is restored to the unset state, leaving ownership with the SharedMessage.
+//
+// While attached, the field must not be mutated or reassigned through the
+// parent: `mutable_*`, `set_allocated_*`, `Clear()` and `MergeFrom()` on the
+// parent would either write to the shared payload or destroy it.  Code that
+// needs to modify the submessage for this parent only should call
+// MutableDetached(), which replaces the attachment with a deep copy owned by
+// the parent.
+//
+// Typical fan-out loop:
+//
+//   SharedMessage payload(BuildLargeCommonSubmessage());
+//   for (auto& recipient : recipients) {
+//     Envelope envelope = MakeEnvelope(recipient);
+//     ScopedSharedMessageAttachment attachment(payload, &envelope, body_field);
+//     envelope.SerializeToString(&wire);  // reads the shared payload
+//     Send(recipient, wire);
+//   }
+class PROTOBUF_EXPORT ScopedSharedMessageAttachment {
+ public:
+  // `field` must be a singular message field of `parent` whose message type
+  // matches the payload's type.  A previously set value of the field is
+  // destroyed.  `parent` must outlive this object.
+  ScopedSharedMessageAttachment(const SharedMessage& shared, Message* parent,
+                                const FieldDescriptor* field);
+
+  ScopedSharedMessageAttachment(const ScopedSharedMessageAttachment&) = delete;
+  ScopedSharedMessageAttachment& operator=(
+      const ScopedSharedMessageAttachment&) = delete;
+
+  ~ScopedSharedMessageAttachment();
+
+  // Copy-on-write escape hatch: replaces the attachment with a deep copy of
+  // the payload owned by the parent and returns the copy for mutation.  The
+  // copy stays with the parent after this object is destroyed; the shared
+  // payload is unaffected.
+  Message* MutableDetached();
+
+  // True once MutableDetached() has been called.
+  bool detached() const { return detached_; }
+
+ private:
+  std::shared_ptr<const Message> shared_;
+  Message* parent_;
+  const FieldDescriptor* field_;
+  bool detached_ = false;
+};
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_SHARED_MESSAGE_H__
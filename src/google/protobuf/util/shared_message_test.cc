@@ -0,0 +1,112 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/util/shared_message.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <gtest/gtest.h>
+#include "google/protobuf/arena.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/unittest.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+const FieldDescriptor* ForeignMessageField() {
+  return protobuf_unittest::TestAllTypes::descriptor()->FindFieldByName(
+      "optional_foreign_message");
+}
+
+SharedMessage MakePayload(int c) {
+  auto payload = std::make_unique<protobuf_unittest::ForeignMessage>();
+  payload->set_c(c);
+  return SharedMessage(std::move(payload));
+}
+
+TEST(SharedMessageTest, AttachLendsPayloadWithoutCopy) {
+  SharedMessage shared = MakePayload(42);
+  protobuf_unittest::TestAllTypes parent;
+  std::string wire;
+  {
+    ScopedSharedMessageAttachment attachment(shared, &parent,
+                                             ForeignMessageField());
+    // The parent reads the shared object itself, not a copy.
+    EXPECT_EQ(&parent.optional_foreign_message(), &shared.message());
+    ASSERT_TRUE(parent.SerializeToString(&wire));
+  }
+  // Destruction restores the unset state without destroying the payload.
+  EXPECT_FALSE(parent.has_optional_foreign_message());
+
+  protobuf_unittest::TestAllTypes parsed;
+  ASSERT_TRUE(parsed.ParseFromString(wire));
+  EXPECT_EQ(parsed.optional_foreign_message().c(), 42);
+}
+
+TEST(SharedMessageTest, FanOutAttachesOnePayloadToManyParents) {
+  SharedMessage shared = MakePayload(7);
+  protobuf_unittest::TestAllTypes parents[3];
+  {
+    ScopedSharedMessageAttachment a(shared, &parents[0],
+                                    ForeignMessageField());
+    ScopedSharedMessageAttachment b(shared, &parents[1],
+                                    ForeignMessageField());
+    ScopedSharedMessageAttachment c(shared, &parents[2],
+                                    ForeignMessageField());
+    for (auto& parent : parents) {
+      EXPECT_EQ(&parent.optional_foreign_message(), &shared.message());
+      std::string wire;
+      ASSERT_TRUE(parent.SerializeToString(&wire));
+      protobuf_unittest::TestAllTypes parsed;
+      ASSERT_TRUE(parsed.ParseFromString(wire));
+      EXPECT_EQ(parsed.optional_foreign_message().c(), 7);
+    }
+  }
+}
+
+TEST(SharedMessageTest, MutableDetachedCopiesOnFirstWrite) {
+  SharedMessage shared = MakePayload(1);
+  protobuf_unittest::TestAllTypes parent;
+  {
+    ScopedSharedMessageAttachment attachment(shared, &parent,
+                                             ForeignMessageField());
+    Message* copy = attachment.MutableDetached();
+    EXPECT_TRUE(attachment.detached());
+    EXPECT_NE(copy, &shared.message());
+    static_cast<protobuf_unittest::ForeignMessage*>(copy)->set_c(2);
+  }
+  // The detached copy stays with the parent; the payload is untouched.
+  EXPECT_EQ(parent.optional_foreign_message().c(), 2);
+  EXPECT_EQ(
+      static_cast<const protobuf_unittest::ForeignMessage&>(shared.message())
+          .c(),
+      1);
+}
+
+TEST(SharedMessageTest, WorksWithArenaParents) {
+  SharedMessage shared = MakePayload(9);
+  Arena arena;
+  auto* parent = Arena::Create<protobuf_unittest::TestAllTypes>(&arena);
+  {
+    ScopedSharedMessageAttachment attachment(shared, parent,
+                                             ForeignMessageField());
+    EXPECT_EQ(&parent->optional_foreign_message(), &shared.message());
+    Message* copy = attachment.MutableDetached();
+    EXPECT_EQ(copy->GetArena(), &arena);
+    static_cast<protobuf_unittest::ForeignMessage*>(copy)->set_c(10);
+  }
+  EXPECT_EQ(parent->optional_foreign_message().c(), 10);
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
@@ -7,7 +7,9 @@
 
 #include "google/protobuf/util/type_resolver_util.h"
 
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "google/protobuf/source_context.pb.h"
@@ -379,6 +381,82 @@ Enum ConvertDescriptorToType(const EnumDescriptor& descriptor) {
   return enum_type;
 }
 
+CachingTypeResolver::CachingTypeResolver(std::unique_ptr<TypeResolver> delegate)
+    : delegate_(std::move(delegate)) {}
+
+CachingTypeResolver::~CachingTypeResolver() = default;
+
+absl::Status CachingTypeResolver::ResolveMessageType(const std::string& type_url,
+                                                     Type* message_type) {
+  {
+    absl::MutexLock lock(&mu_);
+    auto it = message_types_.find(type_url);
+    if (it != message_types_.end()) {
+      *message_type = it->second;
+      return absl::Status();
+    }
+  }
+  // Resolve without the lock held; a slow delegate must not serialize
+  // cache hits for other types.  Concurrent misses on the same URL resolve
+  // redundantly and the last one wins, which is harmless.
+  Type resolved;
+  absl::Status status = delegate_->ResolveMessageType(type_url, &resolved);
+  if (!status.ok()) {
+    return status;
+  }
+  *message_type = resolved;
+  absl::MutexLock lock(&mu_);
+  message_types_[type_url] = std::move(resolved);
+  return absl::Status();
+}
+
+absl::Status CachingTypeResolver::ResolveEnumType(const std::string& type_url,
+                                                  Enum* enum_type) {
+  {
+    absl::MutexLock lock(&mu_);
+    auto it = enum_types_.find(type_url);
+    if (it != enum_types_.end()) {
+      *enum_type = it->second;
+      return absl::Status();
+    }
+  }
+  Enum resolved;
+  absl::Status status = delegate_->ResolveEnumType(type_url, &resolved);
+  if (!status.ok()) {
+    return status;
+  }
+  *enum_type = resolved;
+  absl::MutexLock lock(&mu_);
+  enum_types_[type_url] = std::move(resolved);
+  return absl::Status();
+}
+
+absl::Status CachingTypeResolver::PrewarmTypes(
+    absl::Span<const std::string> type_urls) {
+  absl::Status first_error;
+  for (const std::string& type_url : type_urls) {
+    Type message_type;
+    absl::Status status = ResolveMessageType(type_url, &message_type);
+    if (status.ok()) continue;
+    Enum enum_type;
+    if (ResolveEnumType(type_url, &enum_type).ok()) continue;
+    if (first_error.ok()) first_error = status;
+  }
+  return first_error;
+}
+
+void CachingTypeResolver::InvalidateType(absl::string_view type_url) {
+  absl::MutexLock lock(&mu_);
+  message_types_.erase(type_url);
+  enum_types_.erase(type_url);
+}
+
+void CachingTypeResolver::InvalidateAll() {
+  absl::MutexLock lock(&mu_);
+  message_types_.clear();
+  enum_types_.clear();
+}
+
 }  // namespace util
 }  // namespace protobuf
 }  // namespace google
@@ -10,9 +10,17 @@
 #ifndef GOOGLE_PROTOBUF_UTIL_TYPE_RESOLVER_UTIL_H__
 #define GOOGLE_PROTOBUF_UTIL_TYPE_RESOLVER_UTIL_H__
 
+#include <memory>
+#include <string>
+
 #include "google/protobuf/type.pb.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
 #include "google/protobuf/descriptor.h"
+#include "google/protobuf/util/type_resolver.h"
 
 // Must be included last.
 #include "google/protobuf/port_def.inc"
@@ -21,13 +29,58 @@ namespace google {
 namespace protobuf {
 class DescriptorPool;
 namespace util {
-class TypeResolver;
 
 // Creates a TypeResolver that serves type information in the given descriptor
 // pool. Caller takes ownership of the returned TypeResolver.
 PROTOBUF_EXPORT TypeResolver* NewTypeResolverForDescriptorPool(
     absl::string_view url_prefix, const DescriptorPool* pool);
 
+// A thread-safe TypeResolver decorator that memoizes resolved types.
+//
+// DescriptorPoolTypeResolver rebuilds the full google.protobuf.Type proto on
+// every call, so a service that resolves the same handful of types per
+// request -- a JSON transcoding proxy, say -- re-pays the conversion on every
+// request.  Wrapping the resolver turns steady-state resolution into a hash
+// lookup and a message copy, and PrewarmTypes() moves even the first
+// resolution out of the request path.  Failed resolutions are not cached.
+//
+//   CachingTypeResolver resolver(absl::WrapUnique(
+//       NewTypeResolverForDescriptorPool(url_prefix, pool)));
+//   resolver.PrewarmTypes(urls_served);
+class PROTOBUF_EXPORT CachingTypeResolver : public TypeResolver {
+ public:
+  // Takes ownership of `delegate`, which must be thread-safe.
+  explicit CachingTypeResolver(std::unique_ptr<TypeResolver> delegate);
+  ~CachingTypeResolver() override;
+
+  absl::Status ResolveMessageType(const std::string& type_url,
+                                  google::protobuf::Type* message_type) override;
+  absl::Status ResolveEnumType(const std::string& type_url,
+                               google::protobuf::Enum* enum_type) override;
+
+  // Resolves every URL in `type_urls` -- as a message type, falling back to
+  // an enum type -- and caches the results.  Returns the first error
+  // encountered; the remaining URLs are still warmed.
+  absl::Status PrewarmTypes(absl::Span<const std::string> type_urls);
+
+  // Drops the cached entry for `type_url`, message and enum alike, so the
+  // next resolution consults the delegate again.  Call when the backing
+  // type information changes, e.g. after replacing a descriptor pool built
+  // at runtime.
+  void InvalidateType(absl::string_view type_url);
+
+  // Drops every cached entry.
+  void InvalidateAll();
+
+ private:
+  std::unique_ptr<TypeResolver> delegate_;
+  absl::Mutex mu_;
+  absl::flat_hash_map<std::string, google::protobuf::Type> message_types_
+      ABSL_GUARDED_BY(mu_);
+  absl::flat_hash_map<std::string, google::protobuf::Enum> enum_types_
+      ABSL_GUARDED_BY(mu_);
+};
+
 // Performs a direct conversion from a descriptor to a type proto.
 PROTOBUF_EXPORT google::protobuf::Type ConvertDescriptorToType(
     absl::string_view url_prefix, const Descriptor& descriptor);
@@ -669,6 +669,115 @@ TEST(ConvertDescriptorToTypeTest, TestCustomEnumOptions) {
       HasInt32Option(value->options(), "protobuf_unittest.enum_value_opt1", 123));
 }
 
+// A delegate that counts how often the caching layer falls through to it.
+class CountingTypeResolver : public TypeResolver {
+ public:
+  CountingTypeResolver()
+      : delegate_(NewTypeResolverForDescriptorPool(
+            kUrlPrefix, DescriptorPool::generated_pool())) {}
+
+  absl::Status ResolveMessageType(const std::string& type_url,
+                                  Type* message_type) override {
+    ++message_calls_;
+    return delegate_->ResolveMessageType(type_url, message_type);
+  }
+
+  absl::Status ResolveEnumType(const std::string& type_url,
+                               Enum* enum_type) override {
+    ++enum_calls_;
+    return delegate_->ResolveEnumType(type_url, enum_type);
+  }
+
+  int message_calls() const { return message_calls_; }
+  int enum_calls() const { return enum_calls_; }
+
+ private:
+  std::unique_ptr<TypeResolver> delegate_;
+  int message_calls_ = 0;
+  int enum_calls_ = 0;
+};
+
+class CachingTypeResolverTest : public testing::Test {
+ protected:
+  CachingTypeResolverTest() {
+    auto counter = std::make_unique<CountingTypeResolver>();
+    counter_ = counter.get();
+    resolver_ = std::make_unique<CachingTypeResolver>(std::move(counter));
+  }
+
+  static std::string GetTypeUrl(absl::string_view full_name) {
+    return kUrlPrefix + std::string("/") + std::string(full_name);
+  }
+
+  CountingTypeResolver* counter_;
+  std::unique_ptr<CachingTypeResolver> resolver_;
+};
+
+TEST_F(CachingTypeResolverTest, ResolvesOnceAndServesCopies) {
+  const std::string url = GetTypeUrl("protobuf_unittest.TestAllTypes");
+  Type first;
+  ASSERT_TRUE(resolver_->ResolveMessageType(url, &first).ok());
+  Type second;
+  ASSERT_TRUE(resolver_->ResolveMessageType(url, &second).ok());
+  EXPECT_EQ(1, counter_->message_calls());
+  // The cached copy matches the direct conversion.
+  EXPECT_EQ(second.DebugString(),
+            ConvertDescriptorToType(kUrlPrefix,
+                                    *protobuf_unittest::TestAllTypes::descriptor())
+                .DebugString());
+
+  const std::string enum_url = GetTypeUrl("protobuf_unittest.ForeignEnum");
+  Enum enum_type;
+  ASSERT_TRUE(resolver_->ResolveEnumType(enum_url, &enum_type).ok());
+  ASSERT_TRUE(resolver_->ResolveEnumType(enum_url, &enum_type).ok());
+  EXPECT_EQ(1, counter_->enum_calls());
+}
+
+TEST_F(CachingTypeResolverTest, InvalidationForcesReresolution) {
+  const std::string url = GetTypeUrl("protobuf_unittest.TestAllTypes");
+  Type type;
+  ASSERT_TRUE(resolver_->ResolveMessageType(url, &type).ok());
+  resolver_->InvalidateType(url);
+  ASSERT_TRUE(resolver_->ResolveMessageType(url, &type).ok());
+  EXPECT_EQ(2, counter_->message_calls());
+
+  resolver_->InvalidateAll();
+  ASSERT_TRUE(resolver_->ResolveMessageType(url, &type).ok());
+  EXPECT_EQ(3, counter_->message_calls());
+}
+
+TEST_F(CachingTypeResolverTest, PrewarmTypesPopulatesCache) {
+  const std::vector<std::string> urls = {
+      GetTypeUrl("protobuf_unittest.TestAllTypes"),
+      GetTypeUrl("protobuf_unittest.ForeignEnum"),
+  };
+  ASSERT_TRUE(resolver_->PrewarmTypes(urls).ok());
+
+  Type type;
+  ASSERT_TRUE(resolver_->ResolveMessageType(urls[0], &type).ok());
+  Enum enum_type;
+  ASSERT_TRUE(resolver_->ResolveEnumType(urls[1], &enum_type).ok());
+  // One message miss for the message type; the enum URL misses the message
+  // cache once during prewarming before falling back to the enum path.
+  EXPECT_EQ(2, counter_->message_calls());
+  EXPECT_EQ(1, counter_->enum_calls());
+}
+
+TEST_F(CachingTypeResolverTest, ErrorsAreNotCached) {
+  const std::string url = GetTypeUrl("protobuf_unittest.NoSuchType");
+  Type type;
+  EXPECT_TRUE(absl::IsNotFound(resolver_->ResolveMessageType(url, &type)));
+  EXPECT_TRUE(absl::IsNotFound(resolver_->ResolveMessageType(url, &type)));
+  EXPECT_EQ(2, counter_->message_calls());
+
+  // Prewarming reports the failure but still warms the valid URLs.
+  const std::vector<std::string> urls = {
+      url, GetTypeUrl("protobuf_unittest.TestAllTypes")};
+  EXPECT_TRUE(absl::IsNotFound(resolver_->PrewarmTypes(urls)));
+  ASSERT_TRUE(resolver_->ResolveMessageType(urls[1], &type).ok());
+  EXPECT_EQ(4, counter_->message_calls());
+}
+
 }  // namespace
 }  // namespace util
 }  // namespace protobuf
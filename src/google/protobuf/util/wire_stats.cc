@@ -0,0 +1,278 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/util/wire_stats.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/wire_format_lite.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+using ::google::protobuf::internal::WireFormatLite;
+
+class StatsWalker {
+ public:
+  explicit StatsWalker(WireStats* stats) : stats_(stats) {}
+
+  // Walks fields of `type` until the end of the stream (when
+  // `group_start_tag` is zero) or until the matching end-group tag.  Returns
+  // false on malformed input.
+  bool WalkMessage(const Descriptor* type, const std::string& prefix,
+                   uint32_t group_start_tag, io::CodedInputStream* input) {
+    while (true) {
+      const int tag_position = input->CurrentPosition();
+      const uint32_t tag = input->ReadTagNoLastTag();
+      if (tag == 0) {
+        // End of stream (or of the enclosing length limit): valid anywhere
+        // but inside a group.
+        return group_start_tag == 0;
+      }
+      if (WireFormatLite::GetTagWireType(tag) ==
+          WireFormatLite::WIRETYPE_END_GROUP) {
+        return group_start_tag != 0 &&
+               WireFormatLite::GetTagFieldNumber(tag) ==
+                   WireFormatLite::GetTagFieldNumber(group_start_tag);
+      }
+      if (!WalkField(type, prefix, tag, tag_position, input)) return false;
+    }
+  }
+
+ private:
+  static std::string FieldPath(const std::string& prefix,
+                               const FieldDescriptor* field, int number) {
+    std::string segment = field == nullptr ? absl::StrCat("#", number)
+                          : field->is_extension()
+                              ? absl::StrCat("(", field->full_name(), ")")
+                              : std::string(field->name());
+    return prefix.empty() ? segment : absl::StrCat(prefix, ".", segment);
+  }
+
+  // Returns whether a length-delimited occurrence of `field` is a packed run
+  // of primitive values rather than a single string/bytes/message payload.
+  static bool IsPackedRun(const FieldDescriptor* field) {
+    if (field == nullptr || !field->is_repeated()) return false;
+    switch (field->cpp_type()) {
+      case FieldDescriptor::CPPTYPE_STRING:
+      case FieldDescriptor::CPPTYPE_MESSAGE:
+        return false;
+      default:
+        return true;
+    }
+  }
+
+  // Bucket 0 for empty payloads, bucket i >= 1 for lengths in
+  // [2^(i-1), 2^i), with the last bucket absorbing longer ones.
+  static int LengthBucket(uint32_t length) {
+    int bucket = 0;
+    while (length > 0 && bucket < kWireStatsLengthBuckets - 1) {
+      length >>= 1;
+      ++bucket;
+    }
+    return bucket;
+  }
+
+  bool WalkField(const Descriptor* type, const std::string& prefix,
+                 uint32_t tag, int tag_position, io::CodedInputStream* input) {
+    const int number = WireFormatLite::GetTagFieldNumber(tag);
+    const FieldDescriptor* field = type->FindFieldByNumber(number);
+    if (field == nullptr) {
+      field = type->file()->pool()->FindExtensionByNumber(type, number);
+    }
+    const std::string path = FieldPath(prefix, field, number);
+    WireFieldStats& entry = stats_->fields[path];
+
+    switch (WireFormatLite::GetTagWireType(tag)) {
+      case WireFormatLite::WIRETYPE_VARINT: {
+        uint64_t value;
+        if (!input->ReadVarint64(&value)) return false;
+        ++entry.count;
+        break;
+      }
+      case WireFormatLite::WIRETYPE_FIXED32:
+        if (!input->Skip(4)) return false;
+        ++entry.count;
+        break;
+      case WireFormatLite::WIRETYPE_FIXED64:
+        if (!input->Skip(8)) return false;
+        ++entry.count;
+        break;
+      case WireFormatLite::WIRETYPE_LENGTH_DELIMITED: {
+        uint32_t length;
+        if (!input->ReadVarint32(&length)) return false;
+        if (field != nullptr &&
+            field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE &&
+            field->type() == FieldDescriptor::TYPE_MESSAGE) {
+          io::CodedInputStream::Limit limit = input->PushLimit(length);
+          const bool ok = WalkMessage(field->message_type(), path,
+                                      /*group_start_tag=*/0, input);
+          input->PopLimit(limit);
+          if (!ok) return false;
+          ++entry.count;
+        } else if (IsPackedRun(field)) {
+          if (!WalkPackedRun(field, length, &entry, input)) return false;
+        } else {
+          if (!input->Skip(static_cast<int>(length))) return false;
+          ++entry.count;
+          if (field != nullptr &&
+              field->cpp_type() == FieldDescriptor::CPPTYPE_STRING) {
+            entry.is_string = true;
+            entry.max_length =
+                std::max(entry.max_length, static_cast<int64_t>(length));
+            ++entry.length_histogram[LengthBucket(length)];
+          }
+        }
+        break;
+      }
+      case WireFormatLite::WIRETYPE_START_GROUP:
+        if (field != nullptr && field->type() == FieldDescriptor::TYPE_GROUP) {
+          if (!WalkMessage(field->message_type(), path, tag, input)) {
+            return false;
+          }
+        } else {
+          if (!WireFormatLite::SkipField(input, tag)) return false;
+        }
+        ++entry.count;
+        break;
+      default:
+        // WIRETYPE_END_GROUP is handled by the caller; anything else is
+        // malformed.
+        return false;
+    }
+
+    entry.total_bytes += input->CurrentPosition() - tag_position;
+    return true;
+  }
+
+  // Tallies the elements of a packed run so `count` reflects values, not
+  // length-delimited records.
+  bool WalkPackedRun(const FieldDescriptor* field, uint32_t length,
+                     WireFieldStats* entry, io::CodedInputStream* input) {
+    switch (WireFormatLite::WireTypeForFieldType(
+        static_cast<WireFormatLite::FieldType>(field->type()))) {
+      case WireFormatLite::WIRETYPE_FIXED32:
+        entry->count += length / 4;
+        return input->Skip(static_cast<int>(length));
+      case WireFormatLite::WIRETYPE_FIXED64:
+        entry->count += length / 8;
+        return input->Skip(static_cast<int>(length));
+      default: {
+        io::CodedInputStream::Limit limit = input->PushLimit(length);
+        bool ok = true;
+        while (input->BytesUntilLimit() > 0) {
+          uint64_t value;
+          if (!input->ReadVarint64(&value)) {
+            ok = false;
+            break;
+          }
+          ++entry->count;
+        }
+        input->PopLimit(limit);
+        return ok;
+      }
+    }
+  }
+
+  WireStats* stats_;
+};
+
+}  // namespace
+
+bool AnalyzeWireStats(const Descriptor* type, absl::string_view data,
+                      WireStats* stats) {
+  *stats = WireStats();
+  stats->total_bytes = static_cast<int64_t>(data.size());
+  if (type == nullptr) return false;
+  io::CodedInputStream input(reinterpret_cast<const uint8_t*>(data.data()),
+                             static_cast<int>(data.size()));
+  StatsWalker walker(stats);
+  return walker.WalkMessage(type, /*prefix=*/"", /*group_start_tag=*/0,
+                            &input);
+}
+
+std::string WireStatsToString(const WireStats& stats) {
+  std::vector<std::pair<absl::string_view, const WireFieldStats*>> rows;
+  rows.reserve(stats.fields.size());
+  for (const auto& entry : stats.fields) {
+    rows.push_back({entry.first, &entry.second});
+  }
+  // The map is ordered by path; a stable sort on bytes keeps ties in path
+  // order so the output is deterministic.
+  std::stable_sort(rows.begin(), rows.end(),
+                   [](const auto& a, const auto& b) {
+                     return a.second->total_bytes > b.second->total_bytes;
+                   });
+
+  std::string out = absl::StrFormat("Total: %d bytes\n", stats.total_bytes);
+  absl::StrAppendFormat(&out, "%12s %7s %10s  %s\n", "bytes", "%", "count",
+                        "field");
+  for (const auto& row : rows) {
+    const double percent =
+        stats.total_bytes == 0
+            ? 0.0
+            : 100.0 * static_cast<double>(row.second->total_bytes) /
+                  static_cast<double>(stats.total_bytes);
+    absl::StrAppendFormat(&out, "%12d %6.1f%% %10d  %s\n",
+                          row.second->total_bytes, percent, row.second->count,
+                          row.first);
+  }
+  return out;
+}
+
+std::string WireStringLengthsToString(const WireStats& stats) {
+  std::vector<std::pair<absl::string_view, const WireFieldStats*>> rows;
+  for (const auto& entry : stats.fields) {
+    if (entry.second.is_string) rows.push_back({entry.first, &entry.second});
+  }
+  if (rows.empty()) return "";
+  std::stable_sort(rows.begin(), rows.end(),
+                   [](const auto& a, const auto& b) {
+                     return a.second->count > b.second->count;
+                   });
+
+  // Share of occurrences whose length fits in 2^bucket - 1 bytes, i.e. the
+  // sum of buckets 0..bucket.
+  const auto share = [](const WireFieldStats& entry, int bucket) {
+    int64_t fitting = 0;
+    for (int i = 0; i <= bucket; ++i) fitting += entry.length_histogram[i];
+    return 100.0 * static_cast<double>(fitting) /
+           static_cast<double>(entry.count);
+  };
+
+  std::string out = "String field lengths:\n";
+  absl::StrAppendFormat(&out, "%10s %10s %7s %7s %7s %7s  %s\n", "count",
+                        "max", "<=7", "<=15", "<=31", "<=63", "field");
+  for (const auto& row : rows) {
+    absl::StrAppendFormat(&out, "%10d %10d %6.1f%% %6.1f%% %6.1f%% %6.1f%%  %s\n",
+                          row.second->count, row.second->max_length,
+                          share(*row.second, 3), share(*row.second, 4),
+                          share(*row.second, 5), share(*row.second, 6),
+                          row.first);
+  }
+  return out;
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
@@ -0,0 +1,97 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef GOOGLE_PROTOBUF_UTIL_WIRE_STATS_H__
+#define GOOGLE_PROTOBUF_UTIL_WIRE_STATS_H__
+
+#include <cstdint>
+#include <string>
+
+#include "absl/container/btree_map.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+// Attributes the bytes of a serialized message to the fields that produced
+// them, for answering "which fields make this message big" without
+// hand-rolled scripts.  The payload is walked with the descriptor as a guide
+// -- like WireFormat::ParseAndMergePartial, but tallying instead of
+// materializing a message -- so analyzing a payload costs no allocations
+// proportional to its content.
+//
+//   WireStats stats;
+//   if (AnalyzeWireStats(MyMessage::descriptor(), payload, &stats)) {
+//     std::cout << WireStatsToString(stats);
+//   }
+//
+// The same analysis is available from the command line as
+// `protoc --analyze=MESSAGE_TYPE` on a payload read from standard input.
+
+// Buckets of WireFieldStats::length_histogram.  Bucket 0 counts empty
+// payloads and bucket i >= 1 counts lengths in [2^(i-1), 2^i); the last
+// bucket absorbs everything longer.
+constexpr int kWireStatsLengthBuckets = 21;
+
+struct WireFieldStats {
+  // Number of times the field occurred on the wire.  Packed repeated fields
+  // count one occurrence per element, not per length-delimited run.
+  int64_t count = 0;
+  // Wire bytes attributed to the field, including its tag and any length
+  // prefix.  Message and group fields are inclusive of their contents: a
+  // parent's total covers everything beneath it, and the entries for nested
+  // paths break that total down further.
+  int64_t total_bytes = 0;
+  // For string and bytes fields only: payload-length distribution, for
+  // judging which fields would fit an inline (SSO-style) representation.
+  bool is_string = false;
+  int64_t max_length = 0;
+  int64_t length_histogram[kWireStatsLengthBuckets] = {};
+};
+
+struct WireStats {
+  // Keyed by dotted field path from the root type, e.g. "child.payload".
+  // Extensions appear as parenthesized full names, e.g. "(ext.weight)", and
+  // fields the descriptor does not know appear by number, e.g. "child.#1234".
+  absl::btree_map<std::string, WireFieldStats> fields;
+  // Size of the analyzed payload in bytes.
+  int64_t total_bytes = 0;
+};
+
+// Walks `data`, a serialized message of `type`, and tallies per-field-path
+// byte and occurrence counts into `*stats` (which is overwritten).  Returns
+// false if the payload is malformed; stats collected up to the malformed
+// point are retained so a truncated payload can still be inspected.
+PROTOBUF_EXPORT bool AnalyzeWireStats(const Descriptor* type,
+                                      absl::string_view data, WireStats* stats);
+
+// Renders `stats` as a table of byte counts, payload percentages and
+// occurrence counts, sorted by descending byte count.  This is the format
+// `protoc --analyze` prints.
+PROTOBUF_EXPORT std::string WireStatsToString(const WireStats& stats);
+
+// Renders the string/bytes fields of `stats` as a table of occurrence
+// counts, maximum lengths, and the share of occurrences fitting within
+// candidate inline capacities (7, 15, 31 and 63 bytes), sorted by
+// descending count.  Feed this production samples to decide which fields
+// are worth an inlined string representation.  Returns the empty string
+// if the payload carried no string fields.  `protoc --analyze` appends
+// this table to its output.
+PROTOBUF_EXPORT std::string WireStringLengthsToString(const WireStats& stats);
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_WIRE_STATS_H__
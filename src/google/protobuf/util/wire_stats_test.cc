@@ -0,0 +1,193 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/util/wire_stats.h"
+
+#include <string>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/strings/str_cat.h"
+#include "google/protobuf/unittest.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+using ::protobuf_unittest::TestAllExtensions;
+using ::protobuf_unittest::TestAllTypes;
+using ::protobuf_unittest::TestEmptyMessage;
+using ::protobuf_unittest::TestPackedTypes;
+using ::testing::HasSubstr;
+
+TEST(WireStatsTest, AttributesScalarAndStringFields) {
+  TestAllTypes message;
+  message.set_optional_int32(150);  // 1 tag byte + 2 varint bytes.
+  message.set_optional_string("hello");
+
+  const std::string data = message.SerializeAsString();
+  WireStats stats;
+  ASSERT_TRUE(AnalyzeWireStats(TestAllTypes::descriptor(), data, &stats));
+
+  EXPECT_EQ(stats.total_bytes, static_cast<int64_t>(data.size()));
+  ASSERT_TRUE(stats.fields.count("optional_int32"));
+  EXPECT_EQ(stats.fields["optional_int32"].count, 1);
+  EXPECT_EQ(stats.fields["optional_int32"].total_bytes, 3);
+  ASSERT_TRUE(stats.fields.count("optional_string"));
+  EXPECT_EQ(stats.fields["optional_string"].count, 1);
+  // Tag + length byte + 5 payload bytes.
+  EXPECT_EQ(stats.fields["optional_string"].total_bytes, 7);
+  // Every byte of the payload is attributed to some top-level path.
+  int64_t attributed = 0;
+  for (const auto& entry : stats.fields) {
+    attributed += entry.second.total_bytes;
+  }
+  EXPECT_EQ(attributed, stats.total_bytes);
+}
+
+TEST(WireStatsTest, MessageFieldsAreInclusiveAndBrokenDownByPath) {
+  TestAllTypes message;
+  message.mutable_optional_nested_message()->set_bb(1);
+
+  WireStats stats;
+  ASSERT_TRUE(AnalyzeWireStats(TestAllTypes::descriptor(),
+                               message.SerializeAsString(), &stats));
+
+  ASSERT_TRUE(stats.fields.count("optional_nested_message"));
+  ASSERT_TRUE(stats.fields.count("optional_nested_message.bb"));
+  // The parent covers its tag, length prefix and contents; the leaf accounts
+  // for the contents alone.
+  EXPECT_EQ(stats.fields["optional_nested_message"].total_bytes,
+            stats.total_bytes);
+  EXPECT_EQ(stats.fields["optional_nested_message.bb"].total_bytes, 2);
+  EXPECT_EQ(stats.fields["optional_nested_message.bb"].count, 1);
+}
+
+TEST(WireStatsTest, PackedRunsCountElements) {
+  TestPackedTypes message;
+  for (int i = 0; i < 10; ++i) {
+    message.add_packed_int32(i);
+    message.add_packed_fixed64(i);
+  }
+
+  WireStats stats;
+  ASSERT_TRUE(AnalyzeWireStats(TestPackedTypes::descriptor(),
+                               message.SerializeAsString(), &stats));
+
+  EXPECT_EQ(stats.fields["packed_int32"].count, 10);
+  EXPECT_EQ(stats.fields["packed_fixed64"].count, 10);
+  // 2 tag bytes + 1 length byte + 10 one-byte varints.
+  EXPECT_EQ(stats.fields["packed_int32"].total_bytes, 13);
+  EXPECT_EQ(stats.fields["packed_fixed64"].total_bytes, 2 + 1 + 10 * 8);
+}
+
+TEST(WireStatsTest, ExtensionsAndUnknownFieldsAreNamed) {
+  TestAllExtensions extended;
+  extended.SetExtension(protobuf_unittest::optional_int32_extension, 7);
+
+  WireStats stats;
+  ASSERT_TRUE(AnalyzeWireStats(TestAllExtensions::descriptor(),
+                               extended.SerializeAsString(), &stats));
+  EXPECT_EQ(stats.fields["(protobuf_unittest.optional_int32_extension)"].count,
+            1);
+
+  // Against a descriptor that knows none of the fields, paths fall back to
+  // field numbers.
+  TestAllTypes message;
+  message.set_optional_int32(1);
+  ASSERT_TRUE(AnalyzeWireStats(TestEmptyMessage::descriptor(),
+                               message.SerializeAsString(), &stats));
+  EXPECT_EQ(stats.fields["#1"].count, 1);
+}
+
+TEST(WireStatsTest, MalformedPayloadFailsButKeepsPartialStats) {
+  TestAllTypes message;
+  message.set_optional_int32(1);
+  std::string data = message.SerializeAsString();
+  // A length-delimited field whose length runs past the end of the payload.
+  data += {'\022', '\x7f'};
+
+  WireStats stats;
+  EXPECT_FALSE(AnalyzeWireStats(TestAllTypes::descriptor(), data, &stats));
+  EXPECT_EQ(stats.fields["optional_int32"].count, 1);
+}
+
+TEST(WireStatsTest, ToStringSortsByBytes) {
+  TestAllTypes message;
+  message.set_optional_int32(1);
+  message.set_optional_string("a long string that dominates the payload");
+
+  WireStats stats;
+  ASSERT_TRUE(AnalyzeWireStats(TestAllTypes::descriptor(),
+                               message.SerializeAsString(), &stats));
+  const std::string table = WireStatsToString(stats);
+
+  EXPECT_THAT(table,
+              HasSubstr(absl::StrCat("Total: ", stats.total_bytes, " bytes")));
+  EXPECT_LT(table.find("optional_string"), table.find("optional_int32"));
+}
+
+TEST(WireStatsTest, StringLengthHistogram) {
+  TestAllTypes message;
+  message.set_optional_string("");            // bucket 0
+  message.add_repeated_string("abcdefg");     // 7 bytes: bucket 3
+  message.add_repeated_string("0123456789abcde");  // 15 bytes: bucket 4
+  message.add_repeated_string(std::string(100, 'x'));  // bucket 7
+
+  WireStats stats;
+  ASSERT_TRUE(AnalyzeWireStats(TestAllTypes::descriptor(),
+                               message.SerializeAsString(), &stats));
+
+  const WireFieldStats& optional = stats.fields["optional_string"];
+  EXPECT_TRUE(optional.is_string);
+  EXPECT_EQ(optional.max_length, 0);
+  EXPECT_EQ(optional.length_histogram[0], 1);
+
+  const WireFieldStats& repeated = stats.fields["repeated_string"];
+  EXPECT_TRUE(repeated.is_string);
+  EXPECT_EQ(repeated.count, 3);
+  EXPECT_EQ(repeated.max_length, 100);
+  EXPECT_EQ(repeated.length_histogram[3], 1);
+  EXPECT_EQ(repeated.length_histogram[4], 1);
+  EXPECT_EQ(repeated.length_histogram[7], 1);
+
+  // Scalar fields carry no histogram.
+  message.set_optional_int32(1);
+  ASSERT_TRUE(AnalyzeWireStats(TestAllTypes::descriptor(),
+                               message.SerializeAsString(), &stats));
+  EXPECT_FALSE(stats.fields["optional_int32"].is_string);
+}
+
+TEST(WireStatsTest, StringLengthsToStringReportsInlineShares) {
+  TestAllTypes message;
+  message.add_repeated_string("short");             // fits <= 7
+  message.add_repeated_string(std::string(20, 'y'));  // fits none of <= 15
+
+  WireStats stats;
+  ASSERT_TRUE(AnalyzeWireStats(TestAllTypes::descriptor(),
+                               message.SerializeAsString(), &stats));
+  const std::string table = WireStringLengthsToString(stats);
+
+  EXPECT_THAT(table, HasSubstr("String field lengths:"));
+  EXPECT_THAT(table, HasSubstr("repeated_string"));
+  // One of two occurrences fits 7 bytes; both fit 31.
+  EXPECT_THAT(table, HasSubstr("50.0%"));
+  EXPECT_THAT(table, HasSubstr("100.0%"));
+
+  // No string fields, no table.
+  TestAllTypes scalars;
+  scalars.set_optional_int32(1);
+  ASSERT_TRUE(AnalyzeWireStats(TestAllTypes::descriptor(),
+                               scalars.SerializeAsString(), &stats));
+  EXPECT_EQ(WireStringLengthsToString(stats), "");
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
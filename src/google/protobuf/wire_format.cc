@@ -11,12 +11,15 @@
 
 #include "google/protobuf/wire_format.h"
 
+#include <algorithm>
+#include <climits>
 #include <stack>
 #include <string>
 #include <vector>
 
 #include "absl/log/absl_check.h"
 #include "absl/log/absl_log.h"
+#include "absl/strings/internal/resize_uninitialized.h"
 #include "absl/strings/cord.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/descriptor.pb.h"
@@ -357,6 +360,153 @@ bool WireFormat::ParseAndMergePartial(io::CodedInputStream* input,
   }
 }
 
+bool WireFormat::ParseAndMergePartialIterative(io::CodedInputStream* input,
+                                               Message* message,
+                                               int depth_limit) {
+  // One frame per open submessage or group.  `message` is null for groups
+  // that belong to no known field; their contents go to `unknown` instead.
+  struct Frame {
+    Message* message;
+    const Descriptor* descriptor;
+    const Reflection* reflection;
+    UnknownFieldSet* unknown;
+    io::CodedInputStream::Limit limit;  // Valid when end_tag == 0.
+    uint32_t end_tag;  // Nonzero for groups: the tag that closes the frame.
+  };
+
+  std::vector<Frame> stack;
+  Frame frame = {message,           message->GetDescriptor(),
+                 message->GetReflection(), nullptr,
+                 0,                 0};
+
+  while (true) {
+    uint32_t tag = input->ReadTag();
+
+    if (tag == 0) {
+      // End of input.  Valid at the top level and at the end of a
+      // length-delimited submessage's limit; a group may not end here.
+      if (stack.empty()) return true;
+      if (frame.end_tag != 0) return false;
+      if (!input->ConsumedEntireMessage()) return false;
+      input->PopLimit(frame.limit);
+      frame = stack.back();
+      stack.pop_back();
+      continue;
+    }
+
+    const WireFormatLite::WireType wire_type =
+        WireFormatLite::GetTagWireType(tag);
+
+    if (wire_type == WireFormatLite::WIRETYPE_END_GROUP) {
+      // At the top level this is a valid place to end, as in
+      // ParseAndMergePartial(); the caller checks LastTagWas().
+      if (stack.empty()) return true;
+      if (tag != frame.end_tag) return false;
+      frame = stack.back();
+      stack.pop_back();
+      continue;
+    }
+
+    int field_number = WireFormatLite::GetTagFieldNumber(tag);
+
+    if (frame.message == nullptr) {
+      // Inside an unknown group: record fields, opening nested unknown
+      // groups as frames rather than recursing through SkipMessage().
+      if (wire_type == WireFormatLite::WIRETYPE_START_GROUP) {
+        if (static_cast<int>(stack.size()) >= depth_limit) return false;
+        UnknownFieldSet* group = frame.unknown->AddGroup(field_number);
+        stack.push_back(frame);
+        frame = {nullptr, nullptr, nullptr, group, 0,
+                 WireFormatLite::MakeTag(
+                     field_number, WireFormatLite::WIRETYPE_END_GROUP)};
+        continue;
+      }
+      if (!SkipField(input, tag, frame.unknown)) return false;
+      continue;
+    }
+
+    // Field lookup as in ParseAndMergePartial().
+    const FieldDescriptor* field = nullptr;
+    if (frame.descriptor != nullptr) {
+      field = frame.descriptor->FindFieldByNumber(field_number);
+
+      if (field == nullptr && frame.descriptor->IsExtensionNumber(field_number)) {
+        if (input->GetExtensionPool() == nullptr) {
+          field = frame.reflection->FindKnownExtensionByNumber(field_number);
+        } else {
+          field = input->GetExtensionPool()->FindExtensionByNumber(
+              frame.descriptor, field_number);
+        }
+      }
+
+      if (field == nullptr &&
+          frame.descriptor->options().message_set_wire_format() &&
+          tag == WireFormatLite::kMessageSetItemStartTag) {
+        if (!ParseAndMergeMessageSetItem(input, frame.message)) {
+          return false;
+        }
+        continue;
+      }
+    }
+
+    if (field != nullptr && field->type() == FieldDescriptor::TYPE_MESSAGE &&
+        wire_type == WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+      if (static_cast<int>(stack.size()) >= depth_limit) return false;
+      uint32_t length;
+      if (!input->ReadVarint32(&length)) return false;
+      Message* sub_message =
+          field->is_repeated()
+              ? frame.reflection->AddMessage(frame.message, field,
+                                             input->GetExtensionFactory())
+              : frame.reflection->MutableMessage(frame.message, field,
+                                                 input->GetExtensionFactory());
+      stack.push_back(frame);
+      frame = {sub_message,
+               sub_message->GetDescriptor(),
+               sub_message->GetReflection(),
+               nullptr,
+               input->PushLimit(length),
+               0};
+      continue;
+    }
+
+    if (field != nullptr && field->type() == FieldDescriptor::TYPE_GROUP &&
+        wire_type == WireFormatLite::WIRETYPE_START_GROUP) {
+      if (static_cast<int>(stack.size()) >= depth_limit) return false;
+      Message* sub_message =
+          field->is_repeated()
+              ? frame.reflection->AddMessage(frame.message, field,
+                                             input->GetExtensionFactory())
+              : frame.reflection->MutableMessage(frame.message, field,
+                                                 input->GetExtensionFactory());
+      stack.push_back(frame);
+      frame = {sub_message, sub_message->GetDescriptor(),
+               sub_message->GetReflection(), nullptr, 0,
+               WireFormatLite::MakeTag(field_number,
+                                       WireFormatLite::WIRETYPE_END_GROUP)};
+      continue;
+    }
+
+    // Any start-group tag not consumed above (no such field, or the field is
+    // not a group) opens an unknown group.
+    if (wire_type == WireFormatLite::WIRETYPE_START_GROUP) {
+      if (static_cast<int>(stack.size()) >= depth_limit) return false;
+      UnknownFieldSet* group =
+          frame.reflection->MutableUnknownFields(frame.message)
+              ->AddGroup(field_number);
+      stack.push_back(frame);
+      frame = {nullptr, nullptr, nullptr, group, 0,
+               WireFormatLite::MakeTag(field_number,
+                                       WireFormatLite::WIRETYPE_END_GROUP)};
+      continue;
+    }
+
+    if (!ParseAndMergeField(tag, field, frame.message, input)) {
+      return false;
+    }
+  }
+}
+
 bool WireFormat::SkipMessageSetField(io::CodedInputStream* input,
                                      uint32_t field_number,
                                      UnknownFieldSet* unknown_fields) {
@@ -1152,49 +1302,6 @@ static uint8_t* SerializeMapValueRefWithCachedSizes(
   return target;
 }
 
-class MapKeySorter {
- public:
-  static std::vector<MapKey> SortKey(const Message& message,
-                                     const Reflection* reflection,
-                                     const FieldDescriptor* field) {
-    std::vector<MapKey> sorted_key_list;
-    for (MapIterator it =
-             reflection->MapBegin(const_cast<Message*>(&message), field);
-         it != reflection->MapEnd(const_cast<Message*>(&message), field);
-         ++it) {
-      sorted_key_list.push_back(it.GetKey());
-    }
-    MapKeyComparator comparator;
-    std::sort(sorted_key_list.begin(), sorted_key_list.end(), comparator);
-    return sorted_key_list;
-  }
-
- private:
-  class MapKeyComparator {
-   public:
-    bool operator()(const MapKey& a, const MapKey& b) const {
-      ABSL_DCHECK(a.type() == b.type());
-      switch (a.type()) {
-#define CASE_TYPE(CppType, CamelCppType)                                \
-  case FieldDescriptor::CPPTYPE_##CppType: {                            \
-    return a.Get##CamelCppType##Value() < b.Get##CamelCppType##Value(); \
-  }
-        CASE_TYPE(STRING, String)
-        CASE_TYPE(INT64, Int64)
-        CASE_TYPE(INT32, Int32)
-        CASE_TYPE(UINT64, UInt64)
-        CASE_TYPE(UINT32, UInt32)
-        CASE_TYPE(BOOL, Bool)
-#undef CASE_TYPE
-
-        default:
-          ABSL_DLOG(FATAL) << "Invalid key for map field.";
-          return true;
-      }
-    }
-  };
-};
-
 static uint8_t* InternalSerializeMapEntry(const FieldDescriptor* field,
                                           const MapKey& key,
                                           const MapValueConstRef& value,
@@ -1248,9 +1355,11 @@ uint8_t* WireFormat::InternalSerializeField(const FieldDescriptor* field,
         message_reflection->GetMapData(message, field);
     if (map_field->IsMapValid()) {
       if (stream->IsSerializationDeterministic()) {
-        std::vector<MapKey> sorted_key_list =
-            MapKeySorter::SortKey(message, message_reflection, field);
-        for (std::vector<MapKey>::iterator it = sorted_key_list.begin();
+        // The sorted key list is cached inside the map field and reused
+        // until the map is next mutated.
+        const std::vector<MapKey>& sorted_key_list =
+            map_field->GetSortedKeyList();
+        for (std::vector<MapKey>::const_iterator it = sorted_key_list.begin();
              it != sorted_key_list.end(); ++it) {
           MapValueConstRef map_value;
           message_reflection->LookupMapValue(message, field, *it, &map_value);
@@ -1468,6 +1577,289 @@ uint8_t* WireFormat::InternalSerializeMessageSetItem(
   return target;
 }
 
+// ===================================================================
+// Canonical serialization.  See the contract in wire_format.h.  The
+// canonical transformations (ordering map entries and unknown fields) never
+// change the total byte size, so sizes cached by a ByteSize() pass stay
+// valid throughout.
+
+namespace {
+
+// Stable order: ascending field number, equal numbers keep their relative
+// order.
+std::vector<const UnknownField*> SortedUnknownFields(
+    const UnknownFieldSet& unknown_fields) {
+  std::vector<const UnknownField*> sorted;
+  sorted.reserve(unknown_fields.field_count());
+  for (int i = 0; i < unknown_fields.field_count(); i++) {
+    sorted.push_back(&unknown_fields.field(i));
+  }
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   [](const UnknownField* a, const UnknownField* b) {
+                     return a->number() < b->number();
+                   });
+  return sorted;
+}
+
+// Like InternalSerializeMapEntry() but message-typed values recurse through
+// the canonical path instead of the generated serializer.
+uint8_t* SerializeCanonicalMapEntry(const FieldDescriptor* field,
+                                    const MapKey& key,
+                                    const MapValueConstRef& value,
+                                    uint8_t* target,
+                                    io::EpsCopyOutputStream* stream) {
+  const FieldDescriptor* key_field = field->message_type()->field(0);
+  const FieldDescriptor* value_field = field->message_type()->field(1);
+
+  size_t size = kMapEntryTagByteSize;
+  size += MapKeyDataOnlyByteSize(key_field, key);
+  size += MapValueRefDataOnlyByteSize(value_field, value);
+  target = stream->EnsureSpace(target);
+  target = WireFormatLite::WriteTagToArray(
+      field->number(), WireFormatLite::WIRETYPE_LENGTH_DELIMITED, target);
+  target = io::CodedOutputStream::WriteVarint32ToArray(size, target);
+  target = SerializeMapKeyWithCachedSizes(key_field, key, target, stream);
+  if (value_field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+    const Message& sub = value.GetMessageValue();
+    target = stream->EnsureSpace(target);
+    if (value_field->type() == FieldDescriptor::TYPE_GROUP) {
+      target = WireFormatLite::WriteTagToArray(
+          2, WireFormatLite::WIRETYPE_START_GROUP, target);
+      target = WireFormat::InternalSerializeCanonical(sub, target, stream);
+      target = stream->EnsureSpace(target);
+      target = WireFormatLite::WriteTagToArray(
+          2, WireFormatLite::WIRETYPE_END_GROUP, target);
+    } else {
+      target = WireFormatLite::WriteTagToArray(
+          2, WireFormatLite::WIRETYPE_LENGTH_DELIMITED, target);
+      target = io::CodedOutputStream::WriteVarint32ToArray(
+          static_cast<uint32_t>(sub.GetCachedSize()), target);
+      target = WireFormat::InternalSerializeCanonical(sub, target, stream);
+    }
+  } else {
+    target = SerializeMapValueRefWithCachedSizes(value_field, value, target,
+                                                 stream);
+  }
+  return target;
+}
+
+}  // namespace
+
+uint8_t* WireFormat::InternalSerializeCanonicalUnknownFields(
+    const UnknownFieldSet& unknown_fields, uint8_t* target,
+    io::EpsCopyOutputStream* stream) {
+  for (const UnknownField* field : SortedUnknownFields(unknown_fields)) {
+    target = stream->EnsureSpace(target);
+    switch (field->type()) {
+      case UnknownField::TYPE_VARINT:
+        target = WireFormatLite::WriteUInt64ToArray(field->number(),
+                                                    field->varint(), target);
+        break;
+      case UnknownField::TYPE_FIXED32:
+        target = WireFormatLite::WriteFixed32ToArray(field->number(),
+                                                     field->fixed32(), target);
+        break;
+      case UnknownField::TYPE_FIXED64:
+        target = WireFormatLite::WriteFixed64ToArray(field->number(),
+                                                     field->fixed64(), target);
+        break;
+      case UnknownField::TYPE_LENGTH_DELIMITED:
+        // Preserved verbatim; see the contract in wire_format.h.
+        target = stream->WriteString(field->number(),
+                                     field->length_delimited(), target);
+        break;
+      case UnknownField::TYPE_GROUP:
+        target = WireFormatLite::WriteTagToArray(
+            field->number(), WireFormatLite::WIRETYPE_START_GROUP, target);
+        target = InternalSerializeCanonicalUnknownFields(field->group(),
+                                                         target, stream);
+        target = stream->EnsureSpace(target);
+        target = WireFormatLite::WriteTagToArray(
+            field->number(), WireFormatLite::WIRETYPE_END_GROUP, target);
+        break;
+    }
+  }
+  return target;
+}
+
+uint8_t* WireFormat::InternalSerializeCanonicalUnknownMessageSetItems(
+    const UnknownFieldSet& unknown_fields, uint8_t* target,
+    io::EpsCopyOutputStream* stream) {
+  for (const UnknownField* field : SortedUnknownFields(unknown_fields)) {
+    // The only unknown fields that are allowed to exist in a MessageSet are
+    // messages, which are length-delimited.
+    if (field->type() != UnknownField::TYPE_LENGTH_DELIMITED) continue;
+    target = stream->EnsureSpace(target);
+    // Start group.
+    target = io::CodedOutputStream::WriteTagToArray(
+        WireFormatLite::kMessageSetItemStartTag, target);
+    // Write type ID.
+    target = io::CodedOutputStream::WriteTagToArray(
+        WireFormatLite::kMessageSetTypeIdTag, target);
+    target =
+        io::CodedOutputStream::WriteVarint32ToArray(field->number(), target);
+    // Write message.
+    target = io::CodedOutputStream::WriteTagToArray(
+        WireFormatLite::kMessageSetMessageTag, target);
+    target = field->InternalSerializeLengthDelimitedNoTag(target, stream);
+    target = stream->EnsureSpace(target);
+    // End group.
+    target = io::CodedOutputStream::WriteTagToArray(
+        WireFormatLite::kMessageSetItemEndTag, target);
+  }
+  return target;
+}
+
+uint8_t* WireFormat::InternalSerializeCanonicalField(
+    const FieldDescriptor* field, const Message& message, uint8_t* target,
+    io::EpsCopyOutputStream* stream) {
+  const Reflection* message_reflection = message.GetReflection();
+
+  if (field->is_extension() &&
+      field->containing_type()->options().message_set_wire_format() &&
+      field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE &&
+      !field->is_repeated()) {
+    // A MessageSet item, with the payload serialized canonically.
+    target = stream->EnsureSpace(target);
+    target = io::CodedOutputStream::WriteTagToArray(
+        WireFormatLite::kMessageSetItemStartTag, target);
+    target = WireFormatLite::WriteUInt32ToArray(
+        WireFormatLite::kMessageSetTypeIdNumber, field->number(), target);
+    const Message& sub = message_reflection->GetMessage(message, field);
+    target = stream->EnsureSpace(target);
+    target = WireFormatLite::WriteTagToArray(
+        WireFormatLite::kMessageSetMessageNumber,
+        WireFormatLite::WIRETYPE_LENGTH_DELIMITED, target);
+    target = io::CodedOutputStream::WriteVarint32ToArray(
+        static_cast<uint32_t>(sub.GetCachedSize()), target);
+    target = InternalSerializeCanonical(sub, target, stream);
+    target = stream->EnsureSpace(target);
+    target = io::CodedOutputStream::WriteTagToArray(
+        WireFormatLite::kMessageSetItemEndTag, target);
+    return target;
+  }
+
+  if (field->is_map()) {
+    const MapFieldBase* map_field =
+        message_reflection->GetMapData(message, field);
+    if (map_field->IsMapValid()) {
+      const std::vector<MapKey>& sorted_key_list =
+          map_field->GetSortedKeyList();
+      for (const MapKey& key : sorted_key_list) {
+        MapValueConstRef map_value;
+        message_reflection->LookupMapValue(message, field, key, &map_value);
+        target =
+            SerializeCanonicalMapEntry(field, key, map_value, target, stream);
+      }
+      return target;
+    }
+    // The repeated-entry representation is authoritative; fall through and
+    // serialize the entries as ordinary messages, sorted by key.
+  }
+
+  if (field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) {
+    // Scalars and strings have exactly one encoding each, so the shared
+    // field serializer is already canonical for them.
+    return InternalSerializeField(field, message, target, stream);
+  }
+
+  int count = 0;
+  if (field->is_repeated()) {
+    count = message_reflection->FieldSize(message, field);
+  } else if (field->containing_type()->options().map_entry()) {
+    // Map entry fields always need to be serialized.
+    count = 1;
+  } else if (message_reflection->HasField(message, field)) {
+    count = 1;
+  }
+
+  std::vector<const Message*> map_entries;
+  if (count > 1 && field->is_map()) {
+    map_entries =
+        DynamicMapSorter::Sort(message, count, message_reflection, field);
+  }
+
+  for (int j = 0; j < count; j++) {
+    const Message& sub =
+        !field->is_repeated()
+            ? message_reflection->GetMessage(message, field)
+        : !map_entries.empty()
+            ? *map_entries[j]
+            : message_reflection->GetRepeatedMessage(message, field, j);
+    target = stream->EnsureSpace(target);
+    if (field->type() == FieldDescriptor::TYPE_GROUP) {
+      target = WireFormatLite::WriteTagToArray(
+          field->number(), WireFormatLite::WIRETYPE_START_GROUP, target);
+      target = InternalSerializeCanonical(sub, target, stream);
+      target = stream->EnsureSpace(target);
+      target = WireFormatLite::WriteTagToArray(
+          field->number(), WireFormatLite::WIRETYPE_END_GROUP, target);
+    } else {
+      target = WireFormatLite::WriteTagToArray(
+          field->number(), WireFormatLite::WIRETYPE_LENGTH_DELIMITED, target);
+      target = io::CodedOutputStream::WriteVarint32ToArray(
+          static_cast<uint32_t>(sub.GetCachedSize()), target);
+      target = InternalSerializeCanonical(sub, target, stream);
+    }
+  }
+  return target;
+}
+
+uint8_t* WireFormat::InternalSerializeCanonical(
+    const Message& message, uint8_t* target,
+    io::EpsCopyOutputStream* stream) {
+  const Descriptor* descriptor = message.GetDescriptor();
+  const Reflection* message_reflection = message.GetReflection();
+
+  std::vector<const FieldDescriptor*> fields;
+
+  // Fields of map entry should always be serialized.
+  if (descriptor->options().map_entry()) {
+    for (int i = 0; i < descriptor->field_count(); i++) {
+      fields.push_back(descriptor->field(i));
+    }
+  } else {
+    // ListFields() returns fields and extensions in field number order.
+    message_reflection->ListFields(message, &fields);
+  }
+
+  for (auto field : fields) {
+    target = InternalSerializeCanonicalField(field, message, target, stream);
+  }
+
+  if (descriptor->options().message_set_wire_format()) {
+    return InternalSerializeCanonicalUnknownMessageSetItems(
+        message_reflection->GetUnknownFields(message), target, stream);
+  }
+  return InternalSerializeCanonicalUnknownFields(
+      message_reflection->GetUnknownFields(message), target, stream);
+}
+
+bool WireFormat::SerializeCanonical(const Message& message,
+                                    std::string* output) {
+  // Also caches byte sizes on all embedded messages, which the canonical
+  // serializer relies on: its reorderings never change any sizes.
+  const size_t size = ByteSize(message);
+  if (size > INT_MAX) {
+    ABSL_LOG(ERROR) << message.GetTypeName()
+                    << " exceeded maximum protobuf size of 2GB: " << size;
+    return false;
+  }
+  output->clear();
+  if (size == 0) return true;
+  absl::strings_internal::STLStringResizeUninitialized(output, size);
+  uint8_t* target = reinterpret_cast<uint8_t*>(&(*output)[0]);
+  io::EpsCopyOutputStream stream(
+      target, static_cast<int>(size),
+      /*deterministic=*/true);
+  uint8_t* res = InternalSerializeCanonical(message, target, &stream);
+  ABSL_DCHECK_EQ(res, target + size)
+      << ": Protocol message serialized to a size different from what was "
+         "originally expected.  Perhaps it was modified by another thread "
+         "during serialization?";
+  return res == target + size;
+}
+
 // ===================================================================
 
 size_t WireFormat::ByteSize(const Message& message) {
@@ -1549,6 +1941,146 @@ size_t WireFormat::FieldByteSize(const FieldDescriptor* field,
   return our_size;
 }
 
+namespace {
+
+// The maximum encoded size of a single value of the given type, or 0 for
+// length-delimited types whose size depends on the payload.
+size_t MaxScalarByteSize(FieldDescriptor::Type type) {
+  switch (type) {
+    case FieldDescriptor::TYPE_BOOL:
+      return 1;
+    case FieldDescriptor::TYPE_FLOAT:
+    case FieldDescriptor::TYPE_FIXED32:
+    case FieldDescriptor::TYPE_SFIXED32:
+      return WireFormatLite::kFixed32Size;
+    case FieldDescriptor::TYPE_DOUBLE:
+    case FieldDescriptor::TYPE_FIXED64:
+    case FieldDescriptor::TYPE_SFIXED64:
+      return WireFormatLite::kFixed64Size;
+    case FieldDescriptor::TYPE_UINT32:
+    case FieldDescriptor::TYPE_SINT32:
+      return 5;  // Zig-zag or unsigned 32-bit varint.
+    case FieldDescriptor::TYPE_INT32:  // Negative values take 10 bytes.
+    case FieldDescriptor::TYPE_INT64:
+    case FieldDescriptor::TYPE_UINT64:
+    case FieldDescriptor::TYPE_SINT64:
+    case FieldDescriptor::TYPE_ENUM:
+      return 10;
+    default:
+      return 0;
+  }
+}
+
+// The widest possible length prefix of a length-delimited field.
+constexpr size_t kMaxLengthPrefixSize = 5;
+
+}  // namespace
+
+size_t WireFormat::ByteSizeUpperBound(const Message& message) {
+  const Descriptor* descriptor = message.GetDescriptor();
+  const Reflection* message_reflection = message.GetReflection();
+
+  size_t our_size = 0;
+
+  std::vector<const FieldDescriptor*> fields;
+
+  // Fields of map entry should always be serialized.
+  if (descriptor->options().map_entry()) {
+    for (int i = 0; i < descriptor->field_count(); i++) {
+      fields.push_back(descriptor->field(i));
+    }
+  } else {
+    message_reflection->ListFields(message, &fields);
+  }
+
+  for (const FieldDescriptor* field : fields) {
+    our_size += FieldByteSizeUpperBound(field, message);
+  }
+
+  if (descriptor->options().message_set_wire_format()) {
+    our_size += ComputeUnknownMessageSetItemsSize(
+        message_reflection->GetUnknownFields(message));
+  } else {
+    our_size +=
+        ComputeUnknownFieldsSize(message_reflection->GetUnknownFields(message));
+  }
+
+  return our_size;
+}
+
+size_t WireFormat::FieldByteSizeUpperBound(const FieldDescriptor* field,
+                                           const Message& message) {
+  const Reflection* message_reflection = message.GetReflection();
+
+  if (field->is_map() ||
+      (field->is_extension() &&
+       field->containing_type()->options().message_set_wire_format() &&
+       field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE &&
+       !field->is_repeated())) {
+    return FieldByteSize(field, message);
+  }
+
+  size_t count = 0;
+  if (field->is_repeated()) {
+    count = FromIntSize(message_reflection->FieldSize(message, field));
+  } else if (field->containing_type()->options().map_entry()) {
+    // Map entry fields always need to be serialized.
+    count = 1;
+  } else if (message_reflection->HasField(message, field)) {
+    count = 1;
+  }
+  if (count == 0) return 0;
+
+  size_t data_size = 0;
+  switch (field->type()) {
+    case FieldDescriptor::TYPE_GROUP:
+      for (size_t i = 0; i < count; ++i) {
+        const Message& sub =
+            field->is_repeated()
+                ? message_reflection->GetRepeatedMessage(
+                      message, field, static_cast<int>(i))
+                : message_reflection->GetMessage(message, field);
+        data_size += ByteSizeUpperBound(sub);
+      }
+      // TagSize() returns the size of both the start and end group tags.
+      return data_size + count * TagSize(field->number(), field->type());
+    case FieldDescriptor::TYPE_MESSAGE:
+      for (size_t i = 0; i < count; ++i) {
+        const Message& sub =
+            field->is_repeated()
+                ? message_reflection->GetRepeatedMessage(
+                      message, field, static_cast<int>(i))
+                : message_reflection->GetMessage(message, field);
+        data_size += ByteSizeUpperBound(sub) + kMaxLengthPrefixSize;
+      }
+      return data_size + count * TagSize(field->number(), field->type());
+    case FieldDescriptor::TYPE_STRING:
+    case FieldDescriptor::TYPE_BYTES: {
+      std::string scratch;
+      for (size_t i = 0; i < count; ++i) {
+        const std::string& value =
+            field->is_repeated()
+                ? message_reflection->GetRepeatedStringReference(
+                      message, field, static_cast<int>(i), &scratch)
+                : message_reflection->GetStringReference(message, field,
+                                                         &scratch);
+        data_size += value.size() + kMaxLengthPrefixSize;
+      }
+      return data_size + count * TagSize(field->number(), field->type());
+    }
+    default:
+      data_size = count * MaxScalarByteSize(field->type());
+      break;
+  }
+
+  if (field->is_packed()) {
+    // Packed fields get serialized like a string.
+    return data_size + TagSize(field->number(), FieldDescriptor::TYPE_STRING) +
+           kMaxLengthPrefixSize;
+  }
+  return data_size + count * TagSize(field->number(), field->type());
+}
+
 size_t MapKeyDataOnlyByteSize(const FieldDescriptor* field,
                               const MapKey& value) {
   ABSL_DCHECK_EQ(FieldDescriptor::TypeToCppType(field->type()), value.type());
@@ -1666,6 +2198,30 @@ size_t WireFormat::FieldDataOnlyByteSize(const FieldDescriptor* field,
     count = 1;
   }
 
+  if (field->is_repeated() && count > 0) {
+    // Repeated varint scalars are stored contiguously in a RepeatedField, so
+    // size them through the whole-field overloads, whose size-classification
+    // loop vectorizes, instead of one reflection call per element.
+    switch (field->type()) {
+#define HANDLE_VARINT_TYPE(TYPE, CPPTYPE, TYPE_METHOD)                     \
+  case FieldDescriptor::TYPE_##TYPE:                                       \
+    return WireFormatLite::TYPE_METHOD##Size(                              \
+        message_reflection->GetRepeatedFieldInternal<CPPTYPE>(message,     \
+                                                              field));
+
+      HANDLE_VARINT_TYPE(INT32, int32_t, Int32)
+      HANDLE_VARINT_TYPE(INT64, int64_t, Int64)
+      HANDLE_VARINT_TYPE(SINT32, int32_t, SInt32)
+      HANDLE_VARINT_TYPE(SINT64, int64_t, SInt64)
+      HANDLE_VARINT_TYPE(UINT32, uint32_t, UInt32)
+      HANDLE_VARINT_TYPE(UINT64, uint64_t, UInt64)
+      HANDLE_VARINT_TYPE(ENUM, int, Enum)
+#undef HANDLE_VARINT_TYPE
+      default:
+        break;
+    }
+  }
+
   switch (field->type()) {
 #define HANDLE_TYPE(TYPE, TYPE_METHOD, CPPTYPE_METHOD)                      \
   case FieldDescriptor::TYPE_##TYPE:                                        \
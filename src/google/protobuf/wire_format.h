@@ -89,6 +89,19 @@ class PROTOBUF_EXPORT WireFormat {
   static bool ParseAndMergePartial(io::CodedInputStream* input,
                                    Message* message);
 
+  // Like ParseAndMergePartial(), but drives nested messages and groups from
+  // an explicit heap-allocated frame stack instead of recursing, so call
+  // stack usage stays flat no matter how deeply the input nests.  This makes
+  // depth limits in the thousands safe on small thread stacks; `depth_limit`
+  // bounds the number of open submessages and groups and replaces the
+  // CodedInputStream recursion limit, which this method does not consult.
+  //
+  // MessageSet items are the one exception: their payloads are parsed
+  // through the regular recursive path.
+  static bool ParseAndMergePartialIterative(io::CodedInputStream* input,
+                                            Message* message,
+                                            int depth_limit = 10000);
+
   // This is meant for internal protobuf use (WireFormat is an internal class).
   // This is the reflective implementation of the _InternalParse functionality.
   static const char* _InternalParse(Message* msg, const char* ptr,
@@ -121,6 +134,54 @@ class PROTOBUF_EXPORT WireFormat {
   // WireFormat::SerializeWithCachedSizes() on the same object.
   static size_t ByteSize(const Message& message);
 
+  // Computes an upper bound on the serialized size of message, skipping the
+  // exact per-value varint sizing that ByteSize() performs: numeric values
+  // and length prefixes are charged their maximum encoded width, while
+  // string lengths are read exactly.  The result is always >=
+  // ByteSize(message).  Unlike ByteSize(), this does *not* cache sizes on
+  // embedded messages, so it cannot be followed by
+  // SerializeWithCachedSizes(); use it to presize output buffers.
+  static size_t ByteSizeUpperBound(const Message& message);
+
+  // -----------------------------------------------------------------
+  // Canonical serialization
+
+  // Serializes `message` into a canonical byte string suitable for
+  // content-addressing (hashing, deduplication, signatures).  Two messages
+  // that compare equal — same known field values, same unknown field
+  // multiset — produce identical bytes regardless of how they were built or
+  // the order their fields were set or parsed.  The output obeys this
+  // contract, which we commit to keeping stable across library versions:
+  //
+  //   1. Known fields (including extensions) appear in ascending field
+  //      number order.  Repeated fields keep their element order; packable
+  //      repeated fields use the packed or unpacked encoding declared by
+  //      the field, as usual.
+  //   2. Map fields are ordered by key: integral keys ascending, bool keys
+  //      false before true, string keys in lexicographic byte order.
+  //   3. Unknown fields follow the known fields, stable-sorted by field
+  //      number (fields with equal numbers keep their relative order), with
+  //      unknown groups normalized recursively.  The bytes of unknown
+  //      length-delimited fields are preserved verbatim — they cannot be
+  //      normalized without knowing their type — so messages that took
+  //      different routes through unknown-field-bearing intermediaries may
+  //      still differ; drop unknown fields before hashing if that matters.
+  //   4. All of the above applies recursively to nested messages, groups,
+  //      map values and MessageSet items.  Varints use minimal encodings,
+  //      as all serializers in this library always have.
+  //
+  // Unlike io::CodedOutputStream::SetSerializationDeterministic(), which
+  // only promises identical bytes for the same binary, this is a format
+  // specification.  Returns false if the message exceeds the 2GB wire
+  // format limit; otherwise replaces *output.
+  static bool SerializeCanonical(const Message& message, std::string* output);
+
+  // The recursive worker for SerializeCanonical(); requires that byte sizes
+  // were cached by a preceding ByteSize(message) call.
+  static uint8_t* InternalSerializeCanonical(const Message& message,
+                                             uint8_t* target,
+                                             io::EpsCopyOutputStream* stream);
+
   // -----------------------------------------------------------------
   // Helpers for dealing with unknown fields
 
@@ -224,6 +285,14 @@ class PROTOBUF_EXPORT WireFormat {
   static size_t FieldByteSize(const FieldDescriptor* field,  // Can't be nullptr
                               const Message& message);
 
+  // Computes an upper bound on the size of a single field, as
+  // ByteSizeUpperBound() does for whole messages.  Map and MessageSet fields
+  // are sized exactly; their size is dominated by payloads that must be
+  // visited either way.
+  static size_t FieldByteSizeUpperBound(
+      const FieldDescriptor* field,  // Can't be nullptr
+      const Message& message);
+
   // Parse/serialize a MessageSet::Item group.  Used with messages that use
   // option message_set_wire_format = true.
   static bool ParseAndMergeMessageSetItem(io::CodedInputStream* input,
@@ -265,6 +334,23 @@ class PROTOBUF_EXPORT WireFormat {
  private:
   struct MessageSetParser;
   friend class TcParser;
+
+  // Per-field worker for InternalSerializeCanonical(): message, group, map
+  // and MessageSet extension fields recurse through the canonical path;
+  // everything else defers to InternalSerializeField().
+  static uint8_t* InternalSerializeCanonicalField(
+      const FieldDescriptor* field, const Message& message, uint8_t* target,
+      io::EpsCopyOutputStream* stream);
+
+  // Like InternalSerializeUnknownFieldsToArray() (respectively the
+  // MessageSet items variant) but stable-sorted by field number, with
+  // unknown groups normalized recursively.
+  static uint8_t* InternalSerializeCanonicalUnknownFields(
+      const UnknownFieldSet& unknown_fields, uint8_t* target,
+      io::EpsCopyOutputStream* stream);
+  static uint8_t* InternalSerializeCanonicalUnknownMessageSetItems(
+      const UnknownFieldSet& unknown_fields, uint8_t* target,
+      io::EpsCopyOutputStream* stream);
   // Skip a MessageSet field.
   static bool SkipMessageSetField(io::CodedInputStream* input,
                                   uint32_t field_number,
@@ -15,6 +15,7 @@
 #include <cstdint>
 #include <string>
 
+#include "google/protobuf/map_unittest.pb.h"
 #include "google/protobuf/unittest.pb.h"
 #include "google/protobuf/unittest_mset.pb.h"
 #include "google/protobuf/unittest_mset_wire_format.pb.h"
@@ -42,6 +43,37 @@ namespace protobuf {
 namespace internal {
 namespace {
 
+TEST(WireFormatTest, CanonicalSerializationSortsMapEntries) {
+  // Maps with the same contents built in different insertion orders produce
+  // identical canonical bytes, sorted by key.
+  protobuf_unittest::TestMap a;
+  (*a.mutable_map_string_string())["zebra"] = "z";
+  (*a.mutable_map_string_string())["apple"] = "a";
+  (*a.mutable_map_string_string())["mango"] = "m";
+  (*a.mutable_map_int32_int32())[3] = 30;
+  (*a.mutable_map_int32_int32())[1] = 10;
+  (*a.mutable_map_int32_int32())[2] = 20;
+
+  protobuf_unittest::TestMap b;
+  (*b.mutable_map_int32_int32())[2] = 20;
+  (*b.mutable_map_int32_int32())[1] = 10;
+  (*b.mutable_map_int32_int32())[3] = 30;
+  (*b.mutable_map_string_string())["mango"] = "m";
+  (*b.mutable_map_string_string())["apple"] = "a";
+  (*b.mutable_map_string_string())["zebra"] = "z";
+
+  std::string canonical_a, canonical_b;
+  ASSERT_TRUE(WireFormat::SerializeCanonical(a, &canonical_a));
+  ASSERT_TRUE(WireFormat::SerializeCanonical(b, &canonical_b));
+  EXPECT_EQ(canonical_a, canonical_b);
+
+  protobuf_unittest::TestMap round_trip;
+  ASSERT_TRUE(round_trip.ParseFromString(canonical_a));
+  EXPECT_EQ(3, round_trip.map_string_string().size());
+  EXPECT_EQ("m", round_trip.map_string_string().at("mango"));
+  EXPECT_EQ(3, round_trip.map_int32_int32().size());
+  EXPECT_EQ(20, round_trip.map_int32_int32().at(2));
+}
 
 }  // namespace
 }  // namespace internal
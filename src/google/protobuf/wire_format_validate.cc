@@ -0,0 +1,338 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2024 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/wire_format_validate.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/strings/string_view.h"
+#include "google/protobuf/generated_message_tctable_decl.h"
+#include "google/protobuf/generated_message_tctable_impl.h"
+#include "google/protobuf/wire_format_lite.h"
+#include "utf8_validity.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+namespace {
+
+// Matches the limit enforced by ReadSize() in the parser proper.
+constexpr uint64_t kMaxFieldLength = 0x7FFFFFFFu;
+
+}  // namespace
+
+// Friend of TcParser; gives the validator access to the mini-parse field
+// lookup without duplicating the skipmap/lookup-table walk.
+class WireFormatVerifier {
+ public:
+  static bool Validate(const TcParseTableBase* table, absl::string_view data,
+                       int recursion_limit);
+
+ private:
+  // Each helper consumes bytes from [ptr, end) and returns the new position,
+  // or nullptr if the input is not valid wire format.
+  static const char* ReadTag(const char* ptr, const char* end, uint32_t* tag);
+  static const char* ReadVarint(const char* ptr, const char* end);
+  static const char* ReadLength(const char* ptr, const char* end,
+                                uint32_t* length);
+  static const char* ValidateField(const TcParseTableBase* table,
+                                   const TcParseTableBase::FieldEntry& entry,
+                                   uint32_t tag, const char* ptr,
+                                   const char* end, int depth);
+  static const char* ValidateMapEntry(MapAuxInfo map_info, const char* ptr,
+                                      const char* end, int depth);
+  static const char* SkipField(uint32_t tag, const char* ptr, const char* end,
+                               int depth);
+  // Validates a run of fields.  `group_end_tag` is nonzero when inside a
+  // group, in which case the matching end-group tag is consumed and the walk
+  // returns; otherwise the walk must consume exactly up to `end`.
+  static const char* ValidateFields(const TcParseTableBase* table,
+                                    const char* ptr, const char* end,
+                                    uint32_t group_end_tag, int depth);
+};
+
+const char* WireFormatVerifier::ReadTag(const char* ptr, const char* end,
+                                        uint32_t* tag) {
+  // Tags are at most 5 bytes; like ReadTag() in the parser, bits beyond 32
+  // are dropped.
+  uint32_t result = 0;
+  for (int i = 0; i < 5; ++i) {
+    if (ptr == end) return nullptr;
+    const uint32_t byte = static_cast<uint8_t>(*ptr++);
+    result |= (byte & 0x7F) << (7 * i);
+    if (byte < 0x80) {
+      *tag = result;
+      return ptr;
+    }
+  }
+  return nullptr;
+}
+
+const char* WireFormatVerifier::ReadVarint(const char* ptr, const char* end) {
+  for (int i = 0; i < 10; ++i) {
+    if (ptr == end) return nullptr;
+    if (static_cast<uint8_t>(*ptr++) < 0x80) return ptr;
+  }
+  return nullptr;
+}
+
+const char* WireFormatVerifier::ReadLength(const char* ptr, const char* end,
+                                           uint32_t* length) {
+  uint64_t result = 0;
+  for (int i = 0; i < 5; ++i) {
+    if (ptr == end) return nullptr;
+    const uint64_t byte = static_cast<uint8_t>(*ptr++);
+    result |= (byte & 0x7F) << (7 * i);
+    if (byte < 0x80) {
+      if (result > kMaxFieldLength) return nullptr;
+      *length = static_cast<uint32_t>(result);
+      return ptr;
+    }
+  }
+  return nullptr;
+}
+
+const char* WireFormatVerifier::SkipField(uint32_t tag, const char* ptr,
+                                          const char* end, int depth) {
+  switch (tag & 7) {
+    case WireFormatLite::WIRETYPE_VARINT:
+      return ReadVarint(ptr, end);
+    case WireFormatLite::WIRETYPE_FIXED64:
+      return end - ptr < 8 ? nullptr : ptr + 8;
+    case WireFormatLite::WIRETYPE_LENGTH_DELIMITED: {
+      uint32_t length;
+      ptr = ReadLength(ptr, end, &length);
+      if (ptr == nullptr || static_cast<size_t>(end - ptr) < length) {
+        return nullptr;
+      }
+      return ptr + length;
+    }
+    case WireFormatLite::WIRETYPE_START_GROUP:
+      if (depth <= 0) return nullptr;
+      return ValidateFields(nullptr, ptr, end,
+                            (tag & ~uint32_t{7}) |
+                                WireFormatLite::WIRETYPE_END_GROUP,
+                            depth - 1);
+    case WireFormatLite::WIRETYPE_FIXED32:
+      return end - ptr < 4 ? nullptr : ptr + 4;
+    default:
+      // WIRETYPE_END_GROUP is handled by the caller; 6 and 7 are invalid.
+      return nullptr;
+  }
+}
+
+const char* WireFormatVerifier::ValidateMapEntry(MapAuxInfo map_info,
+                                                 const char* ptr,
+                                                 const char* end, int depth) {
+  while (ptr < end) {
+    uint32_t tag;
+    ptr = ReadTag(ptr, end, &tag);
+    if (ptr == nullptr || (tag >> 3) == 0) return nullptr;
+    const MapTypeCard* type_card = (tag >> 3) == 1   ? &map_info.key_type_card
+                                   : (tag >> 3) == 2 ? &map_info.value_type_card
+                                                     : nullptr;
+    if (type_card == nullptr || (tag & 7) != type_card->wiretype()) {
+      // Unexpected contents are skipped as unknown fields, as the parser does.
+      ptr = SkipField(tag, ptr, end, depth);
+      if (ptr == nullptr) return nullptr;
+      continue;
+    }
+    switch (type_card->wiretype()) {
+      case WireFormatLite::WIRETYPE_VARINT:
+        ptr = ReadVarint(ptr, end);
+        break;
+      case WireFormatLite::WIRETYPE_FIXED64:
+        ptr = end - ptr < 8 ? nullptr : ptr + 8;
+        break;
+      case WireFormatLite::WIRETYPE_FIXED32:
+        ptr = end - ptr < 4 ? nullptr : ptr + 4;
+        break;
+      case WireFormatLite::WIRETYPE_LENGTH_DELIMITED: {
+        uint32_t length;
+        ptr = ReadLength(ptr, end, &length);
+        if (ptr == nullptr || static_cast<size_t>(end - ptr) < length) {
+          return nullptr;
+        }
+        if (type_card->cpp_type() == MapTypeCard::kMessage) {
+          if (depth <= 0) return nullptr;
+          const char* limit = ptr + length;
+          if (ValidateFields(nullptr, ptr, limit, 0, depth - 1) != limit) {
+            return nullptr;
+          }
+        } else if (map_info.fail_on_utf8_failure && type_card->is_utf8() &&
+                   !utf8_range::IsStructurallyValid(
+                       absl::string_view(ptr, length))) {
+          return nullptr;
+        }
+        ptr += length;
+        break;
+      }
+      default:
+        return nullptr;
+    }
+    if (ptr == nullptr) return nullptr;
+  }
+  return ptr;
+}
+
+const char* WireFormatVerifier::ValidateField(
+    const TcParseTableBase* table, const TcParseTableBase::FieldEntry& entry,
+    uint32_t tag, const char* ptr, const char* end, int depth) {
+  namespace fl = field_layout;
+  const uint16_t type_card = entry.type_card;
+  const uint32_t wiretype = tag & 7;
+  switch (type_card & fl::kFkMask) {
+    case fl::kFkVarint:
+    case fl::kFkPackedVarint:
+      if (wiretype == WireFormatLite::WIRETYPE_VARINT) {
+        return ReadVarint(ptr, end);
+      }
+      if (wiretype == WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+        // Packed encoding: the region must decompose into whole varints.
+        uint32_t length;
+        ptr = ReadLength(ptr, end, &length);
+        if (ptr == nullptr || static_cast<size_t>(end - ptr) < length) {
+          return nullptr;
+        }
+        const char* limit = ptr + length;
+        while (ptr < limit) {
+          ptr = ReadVarint(ptr, limit);
+          if (ptr == nullptr) return nullptr;
+        }
+        return ptr;
+      }
+      break;
+    case fl::kFkFixed:
+    case fl::kFkPackedFixed: {
+      const size_t size =
+          (type_card & fl::kRepMask) == fl::kRep64Bits ? 8 : 4;
+      if ((wiretype == WireFormatLite::WIRETYPE_FIXED64 && size == 8) ||
+          (wiretype == WireFormatLite::WIRETYPE_FIXED32 && size == 4)) {
+        return static_cast<size_t>(end - ptr) < size ? nullptr : ptr + size;
+      }
+      if (wiretype == WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+        // Packed encoding: a partial trailing element is a parse failure.
+        uint32_t length;
+        ptr = ReadLength(ptr, end, &length);
+        if (ptr == nullptr || static_cast<size_t>(end - ptr) < length ||
+            length % size != 0) {
+          return nullptr;
+        }
+        return ptr + length;
+      }
+      break;
+    }
+    case fl::kFkString: {
+      if (wiretype != WireFormatLite::WIRETYPE_LENGTH_DELIMITED) break;
+      uint32_t length;
+      ptr = ReadLength(ptr, end, &length);
+      if (ptr == nullptr || static_cast<size_t>(end - ptr) < length) {
+        return nullptr;
+      }
+      // kTvUtf8Debug only logs; the parser accepts the payload.
+      if ((type_card & fl::kTvMask) == fl::kTvUtf8 &&
+          !utf8_range::IsStructurallyValid(absl::string_view(ptr, length))) {
+        return nullptr;
+      }
+      return ptr + length;
+    }
+    case fl::kFkMessage: {
+      // Sub-messages with linked tables are validated against their own
+      // schema; others (lazy, weak, default-instance aux) structurally.
+      const TcParseTableBase* sub =
+          (type_card & fl::kTvMask) == fl::kTvTable
+              ? table->field_aux(&entry)->table
+              : nullptr;
+      if ((type_card & fl::kRepMask) == fl::kRepGroup) {
+        if (wiretype != WireFormatLite::WIRETYPE_START_GROUP) break;
+        if (depth <= 0) return nullptr;
+        return ValidateFields(sub, ptr, end,
+                              (tag & ~uint32_t{7}) |
+                                  WireFormatLite::WIRETYPE_END_GROUP,
+                              depth - 1);
+      }
+      if (wiretype != WireFormatLite::WIRETYPE_LENGTH_DELIMITED) break;
+      uint32_t length;
+      ptr = ReadLength(ptr, end, &length);
+      if (ptr == nullptr || static_cast<size_t>(end - ptr) < length) {
+        return nullptr;
+      }
+      if (depth <= 0) return nullptr;
+      const char* limit = ptr + length;
+      if (ValidateFields(sub, ptr, limit, 0, depth - 1) != limit) {
+        return nullptr;
+      }
+      return limit;
+    }
+    case fl::kFkMap: {
+      if (wiretype != WireFormatLite::WIRETYPE_LENGTH_DELIMITED) break;
+      uint32_t length;
+      ptr = ReadLength(ptr, end, &length);
+      if (ptr == nullptr || static_cast<size_t>(end - ptr) < length) {
+        return nullptr;
+      }
+      if (depth <= 0) return nullptr;
+      const char* limit = ptr + length;
+      if (ValidateMapEntry(table->field_aux(&entry)->map_info, ptr, limit,
+                           depth - 1) != limit) {
+        return nullptr;
+      }
+      return limit;
+    }
+    default:
+      break;
+  }
+  // Wire type does not match the schema: the parser routes the field to the
+  // unknown field set, so validate it structurally.
+  return SkipField(tag, ptr, end, depth);
+}
+
+const char* WireFormatVerifier::ValidateFields(const TcParseTableBase* table,
+                                               const char* ptr,
+                                               const char* end,
+                                               uint32_t group_end_tag,
+                                               int depth) {
+  while (ptr < end) {
+    uint32_t tag;
+    ptr = ReadTag(ptr, end, &tag);
+    if (ptr == nullptr || (tag >> 3) == 0) return nullptr;
+    if (tag == group_end_tag) return ptr;
+    if ((tag & 7) == WireFormatLite::WIRETYPE_END_GROUP) {
+      // End-group for a group we are not in.
+      return nullptr;
+    }
+    const TcParseTableBase::FieldEntry* entry =
+        table != nullptr ? TcParser::FindFieldEntry(table, tag >> 3) : nullptr;
+    ptr = entry != nullptr ? ValidateField(table, *entry, tag, ptr, end, depth)
+                           : SkipField(tag, ptr, end, depth);
+    if (ptr == nullptr) return nullptr;
+  }
+  // Inside a group, running off the end means the group was not terminated.
+  return group_end_tag == 0 ? ptr : nullptr;
+}
+
+bool WireFormatVerifier::Validate(const TcParseTableBase* table,
+                                  absl::string_view data,
+                                  int recursion_limit) {
+  return ValidateFields(table, data.data(), data.data() + data.size(), 0,
+                        recursion_limit) == data.data() + data.size();
+}
+
+bool ValidateWireFormat(const TcParseTableBase* table, absl::string_view data,
+                        int recursion_limit) {
+  return WireFormatVerifier::Validate(table, data, recursion_limit);
+}
+
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
@@ -0,0 +1,57 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2024 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+//
+// Validate-only walk of the wire format, driven by the same TcParseTable
+// data that the tailcall parser uses.  Nothing is materialized: no message
+// is constructed, no fields are stored and no allocations are performed.
+
+#ifndef GOOGLE_PROTOBUF_WIRE_FORMAT_VALIDATE_H__
+#define GOOGLE_PROTOBUF_WIRE_FORMAT_VALIDATE_H__
+
+#include "absl/strings/string_view.h"
+#include "google/protobuf/generated_message_tctable_decl.h"
+#include "google/protobuf/generated_message_tctable_impl.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+
+// Returns true if `data` is wire format that the tailcall parser would
+// accept for a message described by `table`: tags and lengths are well
+// formed, groups are properly nested and terminated, the recursion limit
+// is respected, and strings that the schema marks as enforced UTF-8 are
+// structurally valid.  Fields whose wire type does not match the schema
+// are skipped as unknown fields, exactly as the parser would.
+//
+// Enum domain checks are deliberately excluded: an out-of-range enum value
+// is routed to the unknown field set by the parser, not rejected, so it is
+// not a parse failure.  Required field presence is likewise not checked;
+// the result corresponds to ParsePartialFromString(), not IsInitialized().
+PROTOBUF_EXPORT bool ValidateWireFormat(const TcParseTableBase* table,
+                                        absl::string_view data,
+                                        int recursion_limit = 100);
+
+}  // namespace internal
+
+// Returns true if `data` would parse cleanly as a `T`, without constructing
+// a `T`.  This is the cheap, allocation-free form of
+//   T msg; return msg.ParsePartialFromString(data);
+// for callers that gate ingest on validity and discard the message.
+template <typename T>
+bool ValidateWireFormat(absl::string_view data) {
+  return internal::ValidateWireFormat(internal::TcParser::GetTable<T>(), data);
+}
+
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_WIRE_FORMAT_VALIDATE_H__
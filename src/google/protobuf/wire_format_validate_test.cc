@@ -0,0 +1,136 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2024 Google Inc.  All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "google/protobuf/wire_format_validate.h"
+
+#include <string>
+
+#include <gtest/gtest.h>
+#include "google/protobuf/map_unittest.pb.h"
+#include "google/protobuf/test_util.h"
+#include "google/protobuf/unittest.pb.h"
+#include "google/protobuf/unittest_proto3.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace {
+
+TEST(WireFormatValidateTest, AcceptsValidPayload) {
+  unittest::TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  EXPECT_TRUE(
+      ValidateWireFormat<unittest::TestAllTypes>(message.SerializeAsString()));
+}
+
+TEST(WireFormatValidateTest, AcceptsEmptyPayload) {
+  EXPECT_TRUE(ValidateWireFormat<unittest::TestAllTypes>(""));
+}
+
+TEST(WireFormatValidateTest, RejectsTruncatedPayload) {
+  unittest::TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  std::string data = message.SerializeAsString();
+  data.resize(data.size() - 1);
+  EXPECT_FALSE(message.ParsePartialFromString(data));
+  EXPECT_FALSE(ValidateWireFormat<unittest::TestAllTypes>(data));
+}
+
+TEST(WireFormatValidateTest, SkipsUnknownFields) {
+  // Every field of TestAllTypes is unknown to TestEmptyMessage, exercising
+  // the structural skip path for all wire types, including groups.
+  unittest::TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  EXPECT_TRUE(ValidateWireFormat<unittest::TestEmptyMessage>(
+      message.SerializeAsString()));
+}
+
+TEST(WireFormatValidateTest, MismatchedWireTypeIsUnknownNotInvalid) {
+  // optional_int32 (field 1) encoded length-delimited; the parser routes it
+  // to the unknown field set rather than failing.
+  const std::string data("\x0a\x03the", 5);
+  unittest::TestAllTypes message;
+  EXPECT_TRUE(message.ParsePartialFromString(data));
+  EXPECT_TRUE(ValidateWireFormat<unittest::TestAllTypes>(data));
+}
+
+TEST(WireFormatValidateTest, RejectsUnmatchedEndGroup) {
+  EXPECT_FALSE(ValidateWireFormat<unittest::TestAllTypes>("\x0c"));
+}
+
+TEST(WireFormatValidateTest, RejectsUnterminatedGroup) {
+  // Start of optionalgroup (field 16) with no matching end tag.
+  const std::string data("\x83\x01", 2);
+  unittest::TestAllTypes message;
+  EXPECT_FALSE(message.ParsePartialFromString(data));
+  EXPECT_FALSE(ValidateWireFormat<unittest::TestAllTypes>(data));
+}
+
+TEST(WireFormatValidateTest, RejectsOverlongLength) {
+  // Field 1, length-delimited, claiming far more bytes than are present.
+  const std::string data("\x0a\xff\xff\xff\xff\x07", 6);
+  EXPECT_FALSE(ValidateWireFormat<unittest::TestAllTypes>(data));
+}
+
+TEST(WireFormatValidateTest, EnforcesRecursionLimit) {
+  // Unknown groups nest structurally; past the parser's recursion limit the
+  // payload must be rejected even though every tag is well formed.
+  std::string shallow, deep;
+  for (int i = 0; i < 10; ++i) shallow.push_back('\x0b');
+  for (int i = 0; i < 10; ++i) shallow.push_back('\x0c');
+  for (int i = 0; i < 200; ++i) deep.push_back('\x0b');
+  for (int i = 0; i < 200; ++i) deep.push_back('\x0c');
+  EXPECT_TRUE(ValidateWireFormat<unittest::TestEmptyMessage>(shallow));
+  EXPECT_FALSE(ValidateWireFormat<unittest::TestEmptyMessage>(deep));
+  unittest::TestEmptyMessage message;
+  EXPECT_FALSE(message.ParsePartialFromString(deep));
+}
+
+TEST(WireFormatValidateTest, RejectsMalformedPackedVarint) {
+  // packed_int32 (field 90) with a truncated varint inside the region.
+  const std::string data("\xd2\x05\x01\x80", 4);
+  unittest::TestPackedTypes message;
+  EXPECT_FALSE(message.ParsePartialFromString(data));
+  EXPECT_FALSE(ValidateWireFormat<unittest::TestPackedTypes>(data));
+}
+
+TEST(WireFormatValidateTest, RejectsPartialPackedFixed) {
+  // packed_fixed32 (field 97) with a region that is not a whole number of
+  // elements.
+  const std::string data("\x8a\x06\x02ab", 5);
+  unittest::TestPackedTypes message;
+  EXPECT_FALSE(message.ParsePartialFromString(data));
+  EXPECT_FALSE(ValidateWireFormat<unittest::TestPackedTypes>(data));
+}
+
+TEST(WireFormatValidateTest, Proto3RejectsInvalidUtf8) {
+  // optional_string (field 14) with an invalid UTF-8 payload: enforced in
+  // proto3, log-only in proto2.
+  const std::string data("\x72\x02\xff\xfe", 4);
+  proto3_unittest::TestAllTypes proto3_message;
+  EXPECT_FALSE(proto3_message.ParsePartialFromString(data));
+  EXPECT_FALSE(ValidateWireFormat<proto3_unittest::TestAllTypes>(data));
+  unittest::TestAllTypes proto2_message;
+  EXPECT_TRUE(proto2_message.ParsePartialFromString(data));
+  EXPECT_TRUE(ValidateWireFormat<unittest::TestAllTypes>(data));
+}
+
+TEST(WireFormatValidateTest, ValidatesMapEntries) {
+  protobuf_unittest::TestMap message;
+  (*message.mutable_map_string_string())["key"] = "value";
+  (*message.mutable_map_int32_int32())[17] = 42;
+  EXPECT_TRUE(
+      ValidateWireFormat<protobuf_unittest::TestMap>(
+          message.SerializeAsString()));
+  // map_string_string (field 14) entry whose key is invalid UTF-8.
+  const std::string bad_key("\x72\x04\x0a\x02\xff\xfe", 6);
+  EXPECT_FALSE(message.ParsePartialFromString(bad_key));
+  EXPECT_FALSE(ValidateWireFormat<protobuf_unittest::TestMap>(bad_key));
+}
+
+}  // namespace
+}  // namespace protobuf
+}  // namespace google
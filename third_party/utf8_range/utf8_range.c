@@ -27,6 +27,11 @@
 #include <tmmintrin.h>
 #endif
 
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define UTF8_RANGE_NEON 1
+#endif
+
 #if defined(__GNUC__)
 #define FORCE_INLINE_ATTR __attribute__((always_inline))
 #elif defined(_MSC_VER)
@@ -143,7 +148,7 @@ static size_t utf8_range_ValidateUTF8Naive(const char* data, const char* end,
   return err_pos + (1 - return_position);
 }
 
-#ifdef __SSE4_1__
+#if defined(__SSE4_1__) || defined(UTF8_RANGE_NEON)
 /* Returns the number of bytes needed to skip backwards to get to the first
    byte of codepoint.
  */
@@ -158,7 +163,7 @@ static inline int utf8_range_CodepointSkipBackwards(int32_t codepoint_word) {
   }
   return 0;
 }
-#endif  // __SSE4_1__
+#endif  // __SSE4_1__ || UTF8_RANGE_NEON
 
 /* Skipping over ASCII as much as possible, per 8 bytes. It is intentional
    as most strings to check for validity consist only of 1 byte codepoints.
@@ -187,10 +192,10 @@ static FORCE_INLINE_ATTR inline size_t utf8_range_Validate(
     return (return_position ? (data - (end - len)) : 0) +
            utf8_range_ValidateUTF8Naive(data, end, return_position);
   }
-#ifndef __SSE4_1__
+#if !defined(__SSE4_1__) && !defined(UTF8_RANGE_NEON)
   return (return_position ? (data - (end - len)) : 0) +
          utf8_range_ValidateUTF8Naive(data, end, return_position);
-#else
+#elif defined(__SSE4_1__)
   /* This code checks that utf-8 ranges are structurally valid 16 bytes at once
    * using superscalar instructions.
    * The mapping between ranges of codepoint and their corresponding utf-8
@@ -455,6 +460,117 @@ static FORCE_INLINE_ATTR inline size_t utf8_range_Validate(
   }
   /* Check the tail */
   return utf8_range_ValidateUTF8Naive(data, end, return_position);
+#else  /* UTF8_RANGE_NEON */
+  /* NEON port of the SSE algorithm above; see the comments there for how the
+   * range indices are computed.  Two differences:
+   *   - The comparisons here are unsigned, so the entries for invalid range
+   *     indices (9..15) use the unsigned sentinels min 0xFF / max 0x00, which
+   *     fail for every input byte.
+   *   - pshufb treats an index with the high bit set as "return zero" and
+   *     otherwise uses only the low 4 bits; vqtbl1q_u8 instead returns zero
+   *     for any index above 15.  Masking the saturated index with 0x8F
+   *     reproduces the pshufb behavior for the ef_fe lookup, whose in-range
+   *     indices (112..127) rely on the low-nibble wraparound.
+   */
+  static const uint8_t utf8_range_first_len_table[16] = {
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 2, 3};
+  static const uint8_t utf8_range_first_range_table[16] = {
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 8, 8, 8, 8};
+  static const uint8_t utf8_range_min_table[16] = {
+      0x00, 0x80, 0x80, 0x80, 0xA0, 0x80, 0x90, 0x80,
+      0xC2, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+  static const uint8_t utf8_range_max_table[16] = {
+      0x7F, 0xBF, 0xBF, 0xBF, 0xBF, 0x9F, 0xBF, 0x8F,
+      0xF4, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+  static const uint8_t utf8_range_df_ee_table[16] = {0, 2, 0, 0, 0, 0, 0, 0,
+                                                     0, 0, 0, 0, 0, 0, 3, 0};
+  static const uint8_t utf8_range_ef_fe_table[16] = {0, 3, 0, 0, 0, 4, 0, 0,
+                                                     0, 0, 0, 0, 0, 0, 0, 0};
+
+  const uint8x16_t first_len_table = vld1q_u8(utf8_range_first_len_table);
+  const uint8x16_t first_range_table = vld1q_u8(utf8_range_first_range_table);
+  const uint8x16_t range_min_table = vld1q_u8(utf8_range_min_table);
+  const uint8x16_t range_max_table = vld1q_u8(utf8_range_max_table);
+  const uint8x16_t df_ee_table = vld1q_u8(utf8_range_df_ee_table);
+  const uint8x16_t ef_fe_table = vld1q_u8(utf8_range_ef_fe_table);
+
+  uint8x16_t prev_input = vdupq_n_u8(0);
+  uint8x16_t prev_first_len = vdupq_n_u8(0);
+  uint8x16_t error = vdupq_n_u8(0);
+  while (end - data >= 16) {
+    const uint8x16_t input = vld1q_u8((const uint8_t*)data);
+
+    /* high_nibbles = input >> 4 */
+    const uint8x16_t high_nibbles = vshrq_n_u8(input, 4);
+
+    /* first_len = legal character length minus 1 */
+    const uint8x16_t first_len = vqtbl1q_u8(first_len_table, high_nibbles);
+
+    /* First Byte: set range index to 8 for bytes within 0xC0 ~ 0xFF */
+    uint8x16_t range = vqtbl1q_u8(first_range_table, high_nibbles);
+
+    /* Second Byte: set range index to first_len */
+    range = vorrq_u8(range, vextq_u8(prev_first_len, first_len, 15));
+
+    /* Third Byte: set range index to saturate_sub(first_len, 1) */
+    uint8x16_t tmp1 = vqsubq_u8(vextq_u8(prev_first_len, first_len, 14),
+                                vdupq_n_u8(1));
+    range = vorrq_u8(range, tmp1);
+
+    /* Fourth Byte: set range index to saturate_sub(first_len, 2) */
+    uint8x16_t tmp2 = vqsubq_u8(vextq_u8(prev_first_len, first_len, 13),
+                                vdupq_n_u8(2));
+    range = vorrq_u8(range, tmp2);
+
+    /* Adjust Second Byte range for special First Bytes(E0,ED,F0,F4) */
+    const uint8x16_t shift1 = vextq_u8(prev_input, input, 15);
+    const uint8x16_t pos = vsubq_u8(shift1, vdupq_n_u8(0xEF));
+    tmp1 = vqsubq_u8(pos, vdupq_n_u8(240));
+    uint8x16_t range2 = vqtbl1q_u8(df_ee_table, tmp1);
+    tmp2 = vqaddq_u8(pos, vdupq_n_u8(112));
+    range2 = vaddq_u8(
+        range2, vqtbl1q_u8(ef_fe_table, vandq_u8(tmp2, vdupq_n_u8(0x8F))));
+
+    range = vaddq_u8(range, range2);
+
+    /* Load min and max values per calculated range index */
+    const uint8x16_t min_range = vqtbl1q_u8(range_min_table, range);
+    const uint8x16_t max_range = vqtbl1q_u8(range_max_table, range);
+
+    /* Check value range */
+    if (return_position) {
+      error = vcltq_u8(input, min_range);
+      error = vorrq_u8(error, vcgtq_u8(input, max_range));
+      if (vmaxvq_u8(error) != 0) {
+        break;
+      }
+    } else {
+      error = vorrq_u8(error, vcltq_u8(input, min_range));
+      error = vorrq_u8(error, vcgtq_u8(input, max_range));
+    }
+
+    prev_input = input;
+    prev_first_len = first_len;
+
+    data += 16;
+  }
+  /* If we got to the end, we don't need to skip any bytes backwards */
+  if (return_position && (data - (end - len)) == 0) {
+    return utf8_range_ValidateUTF8Naive(data, end, return_position);
+  }
+  /* Find previous codepoint (not 80~BF) */
+  data -= utf8_range_CodepointSkipBackwards(
+      (int32_t)vgetq_lane_u32(vreinterpretq_u32_u8(prev_input), 3));
+  if (return_position) {
+    return (data - (end - len)) +
+           utf8_range_ValidateUTF8Naive(data, end, return_position);
+  }
+  /* Test if there was any error */
+  if (vmaxvq_u8(error) != 0) {
+    return 0;
+  }
+  /* Check the tail */
+  return utf8_range_ValidateUTF8Naive(data, end, return_position);
 #endif
 }
 
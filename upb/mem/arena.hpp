@@ -23,6 +23,10 @@ class Arena {
   Arena(char* initial_block, size_t size)
       : ptr_(upb_Arena_Init(initial_block, size, &upb_alloc_global),
              upb_Arena_Free) {}
+  // An arena that gets all of its blocks from `alloc`, which must outlive
+  // the arena.
+  explicit Arena(upb_alloc* alloc)
+      : ptr_(upb_Arena_Init(nullptr, 0, alloc), upb_Arena_Free) {}
 
   upb_Arena* ptr() const { return ptr_.get(); }
 